@@ -31,6 +31,7 @@
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <malloc.h>
+#include <time.h>
 
 #include "liblfds710.h"
 #include "bstrlib.h"
@@ -38,6 +39,7 @@
 #include "assertions.h"
 #include "intertask_interface.h"
 #include "intertask_interface_dump.h"
+#include "intertask_interface_capture.h"
 
 #include "memory_pools.h"
 
@@ -85,6 +87,7 @@ typedef struct message_list_s {
 
   message_number_t                        message_number;       ///< Unique message number
   uint32_t                                message_priority;     ///< Message priority
+  uint64_t                                enqueue_time_ns;      ///< CLOCK_MONOTONIC, for the dwell time in the queue
 } message_list_t;
 
 typedef struct thread_desc_s {
@@ -144,6 +147,24 @@ typedef struct task_desc_s {
   struct lfds710_queue_bmm_state         message_queue
           __attribute__ ((aligned (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
   struct lfds710_queue_bmm_element      *qbmme;
+
+  /*
+   * Queue accounting: the depth is reserved by the senders before the enqueue,
+   * * * the dwell histogram is only written by the receiving thread.
+   */
+  uint32_t                                queue_depth
+          __attribute__ ((aligned (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
+  uint32_t                                high_water_mark;
+  uint32_t                                high_watermark;
+  uint32_t                                low_watermark;
+  bool                                    overloaded;
+  uint64_t                                nb_enqueued;
+  uint64_t                                nb_dropped;
+  uint64_t                                nb_blocked;
+  uint64_t                                nb_dequeued;
+  uint64_t                                dwell_histogram[ITTI_DWELL_HISTOGRAM_BUCKETS];
+  uint64_t                                dwell_sum_us;
+  uint32_t                                dwell_max_us;
 } task_desc_t;
 
 typedef struct itti_desc_s {
@@ -175,6 +196,13 @@ typedef struct itti_desc_s {
 
   memory_pools_handle_t                   memory_pools_handle;
 
+  itti_overload_policy_t                  overload_policy;
+  uint32_t                                overload_block_timeout_ms;
+  message_priorities_t                    overload_drop_priority;
+  task_id_t                               overload_signal_task;
+
+  void                                  (*free_msg_content) (MessageDef * const message_p);
+
   uint64_t                                vcd_poll_msg;
   uint64_t                                vcd_receive_msg;
   uint64_t                                vcd_send_msg;
@@ -284,6 +312,287 @@ itti_get_message_name (
   return (itti_desc.messages_info[message_id].name);
 }
 
+task_id_t
+itti_get_task_id (
+  const char *const task_name)
+{
+  for (task_id_t task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
+    if (!strcmp (itti_desc.tasks_info[task_id].name, task_name)) {
+      return task_id;
+    }
+  }
+  return TASK_UNKNOWN;
+}
+
+bool
+itti_is_task_ready (
+  task_id_t task_id)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  return (itti_desc.threads[TASK_GET_THREAD_ID (task_id)].task_state == TASK_STATE_READY);
+}
+
+uint32_t
+itti_get_task_queue_count (
+  task_id_t task_id)
+{
+  lfds710_pal_uint_t                      count = 0;
+
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  lfds710_queue_bmm_query (&itti_desc.tasks[task_id].message_queue, LFDS710_QUEUE_BMM_QUERY_GET_POTENTIALLY_INACCURATE_COUNT, NULL, &count);
+  return (uint32_t)count;
+}
+
+uint32_t
+itti_get_task_queue_size (
+  task_id_t task_id)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  return itti_desc.tasks_info[task_id].queue_size;
+}
+
+static inline                           uint64_t
+itti_get_time_ns (
+  void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Bucket of a dwell time: 0 for 0 us, i for [2^(i-1), 2^i[ us, the last one is open
+ */
+static inline                           int
+itti_get_dwell_bucket (
+  const uint64_t dwell_us)
+{
+  const int                               bucket = (dwell_us) ? 64 - __builtin_clzll (dwell_us) : 0;
+
+  return (bucket < ITTI_DWELL_HISTOGRAM_BUCKETS) ? bucket : ITTI_DWELL_HISTOGRAM_BUCKETS - 1;
+}
+
+static                                  uint32_t
+itti_get_dwell_percentile (
+  const uint64_t * const histogram,
+  const uint64_t nb_values,
+  const uint32_t max_us,
+  const uint32_t percentile)
+{
+  const uint64_t                          rank = (nb_values * percentile + 99) / 100;
+  uint64_t                                cumulated = 0;
+
+  if (!nb_values) {
+    return 0;
+  }
+  for (int bucket = 0; bucket < ITTI_DWELL_HISTOGRAM_BUCKETS; bucket++) {
+    cumulated += histogram[bucket];
+    if (cumulated >= rank) {
+      const uint64_t upper_us = (1ULL << bucket) - 1;
+      return (upper_us < max_us) ? (uint32_t)upper_us : max_us;
+    }
+  }
+  return max_us;
+}
+
+/*
+ * Called on the transitions only: a message to the signal task can not recurse for ever.
+ */
+static void
+itti_signal_overload (
+  const task_id_t task_id,
+  const bool overloaded,
+  const uint32_t queue_depth)
+{
+  const task_id_t                         signal_task = itti_desc.overload_signal_task;
+
+  if (overloaded) {
+    OAILOG_WARNING (LOG_ITTI, "Queue of task %s overloaded (%u/%u messages)\n", itti_get_task_name (task_id), queue_depth, itti_desc.tasks_info[task_id].queue_size);
+  } else {
+    OAILOG_NOTICE (LOG_ITTI, "Queue of task %s not overloaded anymore (%u/%u messages)\n", itti_get_task_name (task_id), queue_depth, itti_desc.tasks_info[task_id].queue_size);
+  }
+  if ((ITTI_OVERLOAD_POLICY_SIGNAL == itti_desc.overload_policy) && (TASK_UNKNOWN != signal_task) && (itti_is_task_ready (signal_task))) {
+    MessageDef                             *message_p = itti_alloc_new_message (task_id, ITTI_OVERLOAD_IND);
+
+    ITTI_OVERLOAD_IND (message_p).task_id = task_id;
+    ITTI_OVERLOAD_IND (message_p).queue_depth = queue_depth;
+    ITTI_OVERLOAD_IND (message_p).queue_size = itti_desc.tasks_info[task_id].queue_size;
+    ITTI_OVERLOAD_IND (message_p).overloaded = overloaded;
+    itti_send_msg_to_task (signal_task, INSTANCE_DEFAULT, message_p);
+  }
+}
+
+/*
+ * Reserve a slot in the queue of the destination task, according to the overload policy.
+ * Returns the new depth of the queue, 0 if the message has to be dropped.
+ */
+static                                  uint32_t
+itti_reserve_queue_slot (
+  const task_id_t destination_task_id,
+  const thread_id_t destination_thread_id,
+  const uint32_t priority)
+{
+  task_desc_t                     * const task = &itti_desc.tasks[destination_task_id];
+  const uint32_t                          queue_size = itti_desc.tasks_info[destination_task_id].queue_size;
+  struct timespec                         backoff = {.tv_sec = 0, .tv_nsec = 10000};
+  uint64_t                                deadline_ns = 0;
+  uint32_t                                depth = 0;
+  uint32_t                                high_water_mark = 0;
+
+  if ((ITTI_OVERLOAD_POLICY_DROP == itti_desc.overload_policy) && (priority < itti_desc.overload_drop_priority) &&
+      (__atomic_load_n (&task->overloaded, __ATOMIC_RELAXED))) {
+    return 0;
+  }
+
+  while ((depth = __atomic_add_fetch (&task->queue_depth, 1, __ATOMIC_RELAXED)) > queue_size) {
+    __atomic_sub_fetch (&task->queue_depth, 1, __ATOMIC_RELAXED);
+    /*
+     * A task sending to itself would wait for its own dequeue
+     */
+    if ((ITTI_OVERLOAD_POLICY_BLOCK != itti_desc.overload_policy) || (!itti_desc.overload_block_timeout_ms) ||
+        (pthread_equal (pthread_self (), itti_desc.threads[destination_thread_id].task_thread))) {
+      return 0;
+    }
+    const uint64_t now_ns = itti_get_time_ns ();
+    if (!deadline_ns) {
+      deadline_ns = now_ns + (uint64_t)itti_desc.overload_block_timeout_ms * 1000000ULL;
+      __atomic_add_fetch (&task->nb_blocked, 1, __ATOMIC_RELAXED);
+    } else if (now_ns >= deadline_ns) {
+      return 0;
+    }
+    nanosleep (&backoff, NULL);
+    if (backoff.tv_nsec < 1000000) {
+      backoff.tv_nsec *= 2;
+    }
+  }
+
+  high_water_mark = __atomic_load_n (&task->high_water_mark, __ATOMIC_RELAXED);
+  while ((depth > high_water_mark) &&
+         (!__atomic_compare_exchange_n (&task->high_water_mark, &high_water_mark, depth, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
+
+  if ((depth >= task->high_watermark) && (!__atomic_load_n (&task->overloaded, __ATOMIC_RELAXED))) {
+    bool                                    overloaded = false;
+
+    if (__atomic_compare_exchange_n (&task->overloaded, &overloaded, true, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      itti_signal_overload (destination_task_id, true, depth);
+    }
+  }
+  return depth;
+}
+
+/*
+ * Called by the receiving thread once a message is dequeued
+ */
+static inline void
+itti_release_queue_slot (
+  const task_id_t task_id,
+  const message_list_t * const message)
+{
+  task_desc_t                     * const task = &itti_desc.tasks[task_id];
+  const uint64_t                          now_ns = itti_get_time_ns ();
+  const uint64_t                          dwell_us = (now_ns > message->enqueue_time_ns) ? (now_ns - message->enqueue_time_ns) / 1000 : 0;
+  const uint32_t                          depth = __atomic_sub_fetch (&task->queue_depth, 1, __ATOMIC_RELAXED);
+
+  task->dwell_histogram[itti_get_dwell_bucket (dwell_us)]++;
+  task->dwell_sum_us += dwell_us;
+  if (dwell_us > task->dwell_max_us) {
+    task->dwell_max_us = (dwell_us < UINT32_MAX) ? (uint32_t)dwell_us : UINT32_MAX;
+  }
+  task->nb_dequeued++;
+
+  if ((depth <= task->low_watermark) && (__atomic_load_n (&task->overloaded, __ATOMIC_RELAXED))) {
+    bool                                    overloaded = true;
+
+    if (__atomic_compare_exchange_n (&task->overloaded, &overloaded, false, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      itti_signal_overload (task_id, false, depth);
+    }
+  }
+}
+
+bool
+itti_is_task_overloaded (
+  task_id_t task_id)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  return __atomic_load_n (&itti_desc.tasks[task_id].overloaded, __ATOMIC_RELAXED);
+}
+
+void
+itti_get_task_queue_stats (
+  task_id_t task_id,
+  itti_task_queue_stats_t * const stats)
+{
+  const task_desc_t                      *task = NULL;
+  uint64_t                                histogram[ITTI_DWELL_HISTOGRAM_BUCKETS];
+  uint64_t                                nb_values = 0;
+
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  task = &itti_desc.tasks[task_id];
+  memset (stats, 0, sizeof (*stats));
+  stats->queue_size = itti_desc.tasks_info[task_id].queue_size;
+  stats->queue_depth = __atomic_load_n (&task->queue_depth, __ATOMIC_RELAXED);
+  if (stats->queue_depth > stats->queue_size) {
+    // a sender is backing off
+    stats->queue_depth = stats->queue_size;
+  }
+  stats->high_water_mark = __atomic_load_n (&task->high_water_mark, __ATOMIC_RELAXED);
+  stats->overloaded = __atomic_load_n (&task->overloaded, __ATOMIC_RELAXED);
+  stats->nb_enqueued = __atomic_load_n (&task->nb_enqueued, __ATOMIC_RELAXED);
+  stats->nb_dropped = __atomic_load_n (&task->nb_dropped, __ATOMIC_RELAXED);
+  stats->nb_blocked = __atomic_load_n (&task->nb_blocked, __ATOMIC_RELAXED);
+  stats->nb_dequeued = __atomic_load_n (&task->nb_dequeued, __ATOMIC_RELAXED);
+  stats->dwell_sum_us = __atomic_load_n (&task->dwell_sum_us, __ATOMIC_RELAXED);
+  stats->dwell_max_us = __atomic_load_n (&task->dwell_max_us, __ATOMIC_RELAXED);
+  for (int bucket = 0; bucket < ITTI_DWELL_HISTOGRAM_BUCKETS; bucket++) {
+    histogram[bucket] = __atomic_load_n (&task->dwell_histogram[bucket], __ATOMIC_RELAXED);
+    nb_values += histogram[bucket];
+  }
+  stats->dwell_p50_us = itti_get_dwell_percentile (histogram, nb_values, stats->dwell_max_us, 50);
+  stats->dwell_p90_us = itti_get_dwell_percentile (histogram, nb_values, stats->dwell_max_us, 90);
+  stats->dwell_p99_us = itti_get_dwell_percentile (histogram, nb_values, stats->dwell_max_us, 99);
+}
+
+void
+itti_set_overload_policy (
+  const itti_overload_policy_t policy,
+  const uint32_t block_timeout_ms,
+  const message_priorities_t drop_priority,
+  const task_id_t signal_task)
+{
+  static const char * const               policies[ITTI_OVERLOAD_POLICY_MAX] = ITTI_OVERLOAD_POLICY_STRINGS;
+
+  AssertFatal (policy < ITTI_OVERLOAD_POLICY_MAX, "Overload policy (%d) is out of range!\n", policy);
+  AssertFatal ((signal_task == TASK_UNKNOWN) || (signal_task < itti_desc.task_max), "Task id (%d) is out of range (%d)!\n", signal_task, itti_desc.task_max);
+  itti_desc.overload_block_timeout_ms = block_timeout_ms;
+  itti_desc.overload_drop_priority = drop_priority;
+  itti_desc.overload_signal_task = signal_task;
+  itti_desc.overload_policy = policy;
+  OAILOG_INFO (LOG_ITTI, "Overload policy %s (block timeout %u ms, drop priority %d, signal task %s)\n", policies[policy],
+      block_timeout_ms, drop_priority, (signal_task != TASK_UNKNOWN) ? itti_get_task_name (signal_task) : "none");
+}
+
+void
+itti_set_free_msg_content (
+  void (*free_msg_content) (MessageDef * const message_p))
+{
+  itti_desc.free_msg_content = free_msg_content;
+}
+
+/*
+ * Release a message the destination task will never receive, with the buffers it owns.
+ */
+static void
+itti_drop_message (
+  task_id_t origin_task_id,
+  MessageDef * message)
+{
+  if (itti_desc.free_msg_content) {
+    itti_desc.free_msg_content (message);
+  }
+  itti_free (origin_task_id, message);
+}
+
 const char                             *
 itti_get_task_name (
   task_id_t task_id)
@@ -297,7 +606,7 @@ itti_get_task_name (
   return (itti_desc.tasks_info[task_id].name);
 }
 
-static                                  task_id_t
+task_id_t
 itti_get_current_task_id (
   void)
 {
@@ -441,6 +750,10 @@ itti_send_msg_to_task (
    */
   message_number = itti_increment_message_number ();
 
+  if (itti_capture_enabled) {
+    itti_capture_message (message, message_number);
+  }
+
   if (destination_task_id != TASK_UNKNOWN) {
     VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_IN);
     memory_pools_set_info (itti_desc.memory_pools_handle, message, 1, destination_task_id);
@@ -448,7 +761,7 @@ itti_send_msg_to_task (
     if (itti_desc.threads[destination_thread_id].task_state == TASK_STATE_ENDED) {
       ITTI_DEBUG (ITTI_DEBUG_ISSUES, " Message %s, number %lu with priority %d can not be sent from %s to queue (%u:%s), ended destination task!\n",
                   itti_desc.messages_info[message_id].name, message_number, priority, itti_get_task_name (origin_task_id), destination_task_id, itti_get_task_name (destination_task_id));
-      itti_free (origin_task_id, message); // In case of issues free the memory allocated for message
+      itti_drop_message (origin_task_id, message); // In case of issues free the memory allocated for message
     } else {
       /*
        * We cannot send a message if the task is not running
@@ -456,6 +769,14 @@ itti_send_msg_to_task (
       AssertFatal (itti_desc.threads[destination_thread_id].task_state == TASK_STATE_READY,
                    "Task %s Cannot send message %s (%d) to thread %d, it is not in ready state (%d)!\n",
                    itti_get_task_name (origin_task_id), itti_desc.messages_info[message_id].name, message_id, destination_thread_id, itti_desc.threads[destination_thread_id].task_state);
+      if (!itti_reserve_queue_slot (destination_task_id, destination_thread_id, priority)) {
+        __atomic_add_fetch (&itti_desc.tasks[destination_task_id].nb_dropped, 1, __ATOMIC_RELAXED);
+        ITTI_DEBUG (ITTI_DEBUG_ISSUES, " Message %s, number %lu with priority %d dropped from %s to queue (%u:%s), overloaded destination task!\n",
+                    itti_desc.messages_info[message_id].name, message_number, priority, itti_get_task_name (origin_task_id), destination_task_id, itti_get_task_name (destination_task_id));
+        itti_drop_message (origin_task_id, message);
+        VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_SEND_MSG, __sync_and_and_fetch (&itti_desc.vcd_send_msg, ~(1L << destination_task_id)));
+        return -1;
+      }
       /*
        * Allocate new list element
        */
@@ -466,10 +787,21 @@ itti_send_msg_to_task (
       new->msg = message;
       new->message_number = message_number;
       new->message_priority = priority;
+      new->enqueue_time_ns = itti_get_time_ns ();
       /*
-       * Enqueue message in destination task queue
+       * Enqueue message in destination task queue, the slot is reserved but the queue count may be inaccurate
        */
-      lfds710_queue_bmm_enqueue (&itti_desc.tasks[destination_task_id].message_queue, NULL, new);
+      if (!lfds710_queue_bmm_enqueue (&itti_desc.tasks[destination_task_id].message_queue, NULL, new)) {
+        __atomic_sub_fetch (&itti_desc.tasks[destination_task_id].queue_depth, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch (&itti_desc.tasks[destination_task_id].nb_dropped, 1, __ATOMIC_RELAXED);
+        ITTI_DEBUG (ITTI_DEBUG_ISSUES, " Message %s, number %lu with priority %d dropped from %s to queue (%u:%s), full queue!\n",
+                    itti_desc.messages_info[message_id].name, message_number, priority, itti_get_task_name (origin_task_id), destination_task_id, itti_get_task_name (destination_task_id));
+        itti_free (origin_task_id, new);
+        itti_drop_message (origin_task_id, message);
+        VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_SEND_MSG, __sync_and_and_fetch (&itti_desc.vcd_send_msg, ~(1L << destination_task_id)));
+        return -1;
+      }
+      __atomic_add_fetch (&itti_desc.tasks[destination_task_id].nb_enqueued, 1, __ATOMIC_RELAXED);
       VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_OUT);
       {
         /*
@@ -643,6 +975,7 @@ itti_receive_msg_internal_event_fd (
       }
 
       AssertFatal (message != NULL, "Message from message queue is NULL!\n");
+      itti_release_queue_slot (task_id, message);
       *received_msg = message->msg;
       result = itti_free (ITTI_MSG_ORIGIN_ID (message->msg), message);
       AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
@@ -673,17 +1006,11 @@ itti_poll_msg (
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
   *received_msg = NULL;
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_or_and_fetch (&itti_desc.vcd_poll_msg, 1L << task_id));
-  {
-    struct message_list_s                  *message;
-
-    if (lfds710_queue_bmm_dequeue (&itti_desc.tasks[task_id].message_queue, NULL, (void **)&message) == 1) {
-      int                                     result;
-
-      *received_msg = message->msg;
-      result = itti_free (ITTI_MSG_ORIGIN_ID (*received_msg), message);
-      AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
-    }
-  }
+  /*
+   * Go through the event fd: dequeuing directly would leave the semaphore
+   * counter ahead of the queue and make the next itti_receive_msg() assert.
+   */
+  itti_receive_msg_internal_event_fd (task_id, 1, received_msg);
 
   if (*received_msg == NULL) {
     ITTI_DEBUG (ITTI_DEBUG_POLL, " No message in queue[(%u:%s)]\n", task_id, itti_get_task_name (task_id));
@@ -765,6 +1092,7 @@ itti_mark_task_ready (
    * Mark the thread as using LFDS queue
    */
   LFDS710_MISC_MAKE_VALID_ON_CURRENT_LOGICAL_CORE_INITS_COMPLETED_BEFORE_NOW_ON_ANY_OTHER_LOGICAL_CORE;
+  OAILOG_START_USE ();
   itti_desc.threads[thread_id].task_state = TASK_STATE_READY;
   itti_desc.ready_tasks++;
 
@@ -850,6 +1178,8 @@ itti_init (
 
     itti_desc.tasks[task_id].qbmme = calloc(itti_desc.tasks_info[task_id].queue_size, sizeof(struct lfds710_queue_bmm_element));
     lfds710_queue_bmm_init_valid_on_current_logical_core( &itti_desc.tasks[task_id].message_queue, itti_desc.tasks[task_id].qbmme, itti_desc.tasks_info[task_id].queue_size, NULL );
+    itti_desc.tasks[task_id].high_watermark = (itti_desc.tasks_info[task_id].queue_size * ITTI_QUEUE_HIGH_WATERMARK_PERCENT) / 100;
+    itti_desc.tasks[task_id].low_watermark = (itti_desc.tasks_info[task_id].queue_size * ITTI_QUEUE_LOW_WATERMARK_PERCENT) / 100;
   }
 
   /*
@@ -913,6 +1243,10 @@ itti_init (
   itti_desc.vcd_poll_msg = 0;
   itti_desc.vcd_receive_msg = 0;
   itti_desc.vcd_send_msg = 0;
+  itti_desc.overload_policy = ITTI_OVERLOAD_POLICY_BLOCK;
+  itti_desc.overload_block_timeout_ms = ITTI_OVERLOAD_BLOCK_TIMEOUT_DEFAULT;
+  itti_desc.overload_drop_priority = MESSAGE_PRIORITY_MED_PLUS;
+  itti_desc.overload_signal_task = TASK_UNKNOWN;
 
   CHECK_INIT_RETURN (timer_init ());
   // Could not be launched before ITTI initialization
@@ -982,6 +1316,7 @@ itti_wait_tasks_end (
 
   OAILOG_INFO (LOG_ITTI,  "ready_tasks %d", ready_tasks);
   itti_desc.running = 0;
+  itti_capture_exit ();
   {
     char                                   *statistics = memory_pools_statistics (itti_desc.memory_pools_handle);
 
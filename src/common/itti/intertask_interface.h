@@ -88,6 +88,39 @@ typedef struct task_info_s {
   const char * const name;
 } task_info_t;
 
+/* Behaviour of itti_send_msg_to_task() when the queue of the destination task fills up.
+ * Above the high watermark a queue is overloaded, it is not anymore once back below the low watermark.
+ */
+typedef enum itti_overload_policy_e {
+  ITTI_OVERLOAD_POLICY_BLOCK = 0,   ///< The sender waits for a free slot, at most block_timeout_ms, then the message is dropped
+  ITTI_OVERLOAD_POLICY_DROP,        ///< Messages of a priority lower than drop_priority are dropped while the queue is overloaded
+  ITTI_OVERLOAD_POLICY_SIGNAL,      ///< ITTI_OVERLOAD_IND is sent to signal_task when a queue enters or leaves overload
+  ITTI_OVERLOAD_POLICY_MAX,
+} itti_overload_policy_t;
+
+#define ITTI_OVERLOAD_POLICY_STRINGS           {"BLOCK", "DROP", "SIGNAL"}
+#define ITTI_QUEUE_HIGH_WATERMARK_PERCENT      80
+#define ITTI_QUEUE_LOW_WATERMARK_PERCENT       50
+#define ITTI_OVERLOAD_BLOCK_TIMEOUT_DEFAULT    100   /* ms */
+#define ITTI_DWELL_HISTOGRAM_BUCKETS           32    /* bucket i counts the dwell times in [2^(i-1), 2^i[ us */
+
+/* Snapshot of the queue of a task, see itti_get_task_queue_stats() */
+typedef struct itti_task_queue_stats_s {
+  uint32_t queue_size;
+  uint32_t queue_depth;
+  uint32_t high_water_mark;          ///< Max depth since the start
+  bool     overloaded;
+  uint64_t nb_enqueued;
+  uint64_t nb_dropped;               ///< Queue full, priority too low while overloaded, or blocking timeout
+  uint64_t nb_blocked;               ///< Senders that had to wait for a free slot
+  uint64_t nb_dequeued;
+  uint64_t dwell_sum_us;             ///< Time spent in the queue by the dequeued messages
+  uint32_t dwell_max_us;
+  uint32_t dwell_p50_us;             ///< Upper bound of the histogram bucket
+  uint32_t dwell_p90_us;
+  uint32_t dwell_p99_us;
+} itti_task_queue_stats_t;
+
 /** \brief Update the itti LTE time reference for messages
  \param current seconds
  \param current micro seconds
@@ -104,8 +137,8 @@ int itti_send_broadcast_message(MessageDef *message_p);
 /** \brief Send a message to a task (could be itself)
  \param task_id Task ID
  \param instance Instance of the task used for virtualization
- \param message Pointer to the message to send
- @returns -1 on failure, 0 otherwise
+ \param message Pointer to the message to send, freed if it is dropped
+ @returns -1 if the message was dropped (see itti_overload_policy_t), 0 otherwise
  **/
 int itti_send_msg_to_task(task_id_t task_id, instance_t instance, MessageDef *message);
 
@@ -188,6 +221,57 @@ const char *itti_get_message_name(MessagesIds message_id);
  **/
 const char *itti_get_task_name(task_id_t task_id);
 
+/** \brief Return the id of a task from its printable name ("TASK_S1AP")
+ * \param task_name Name of the task
+ * @returns TASK_UNKNOWN if there is no such task
+ **/
+task_id_t itti_get_task_id(const char *const task_name);
+
+/** \brief Return the id of the task running on the calling thread
+ * @returns TASK_UNKNOWN if the calling thread is not the thread of a task
+ **/
+task_id_t itti_get_current_task_id(void);
+
+/** \brief Tell if a task is ready to receive messages
+ * \param task_id Id of the task
+ **/
+bool itti_is_task_ready(task_id_t task_id);
+
+/** \brief Return the number of messages waiting in the queue of a task (may be inaccurate)
+ * \param task_id Id of the task
+ **/
+uint32_t itti_get_task_queue_count(task_id_t task_id);
+
+/** \brief Return the size of the queue of a task
+ * \param task_id Id of the task
+ **/
+uint32_t itti_get_task_queue_size(task_id_t task_id);
+
+/** \brief Tell if the queue of a task is above its high watermark (and did not go back below the low one)
+ * \param task_id Id of the task
+ **/
+bool itti_is_task_overloaded(task_id_t task_id);
+
+/** \brief Return the depth, high-water mark, counters and dwell time percentiles of the queue of a task
+ * \param task_id Id of the task
+ * \param stats Filled with the snapshot
+ **/
+void itti_get_task_queue_stats(task_id_t task_id, itti_task_queue_stats_t *const stats);
+
+/** \brief Set the behaviour of the senders when the queue of the destination task fills up (BLOCK by default)
+ * \param policy Overload policy
+ * \param block_timeout_ms Max time a sender waits for a free slot with ITTI_OVERLOAD_POLICY_BLOCK
+ * \param drop_priority Messages of a lower priority are dropped while overloaded with ITTI_OVERLOAD_POLICY_DROP
+ * \param signal_task Task receiving ITTI_OVERLOAD_IND with ITTI_OVERLOAD_POLICY_SIGNAL
+ **/
+void itti_set_overload_policy(const itti_overload_policy_t policy, const uint32_t block_timeout_ms,
+                              const message_priorities_t drop_priority, const task_id_t signal_task);
+
+/** \brief Set the function releasing the buffers owned by a message (bstrings, lists...) when ITTI drops it
+ * \param free_msg_content Called before the message itself is freed, NULL if the messages own no buffer
+ **/
+void itti_set_free_msg_content(void (*free_msg_content)(MessageDef * const message_p));
+
 /** \brief Alloc and memset(0) a new itti message.
  * \param origin_task_id Task ID of the sending task
  * \param message_id Message ID
@@ -0,0 +1,660 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_capture.c
+  \brief Capture of the ITTI messages in rotating mmap'd files, replay of a capture into a task.
+*/
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <glob.h>
+#include <libgen.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "bstrlib.h"
+
+#include "assertions.h"
+#include "common_defs.h"
+#include "intertask_interface.h"
+#include "intertask_interface_capture.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+
+#define ITTI_CAPTURE_ALIGN(lEn)                 (((lEn) + 7) & ~((size_t)7))
+
+/* The replay waits while the queue of the task is more than 3/4 full */
+#define ITTI_CAPTURE_REPLAY_QUEUE_HIGH_PERCENT  75
+#define ITTI_CAPTURE_REPLAY_POLL_US             100
+
+/* Messages the replay can rebuild: their only pointers are the listed bstrings */
+typedef struct itti_capture_message_desc_s {
+  MessagesIds                             message_id;
+  uint8_t                                 nb_bstrings;
+  uint32_t                                bstring_offsets[ITTI_CAPTURE_BSTRINGS_MAX];
+} itti_capture_message_desc_t;
+
+static const itti_capture_message_desc_t  itti_capture_replayable_messages[] = {
+  {SCTP_DATA_IND,                    1, {offsetof (msg_t, sctp_data_ind.payload)}},
+  {SCTP_DATA_CNF,                    0, {0}},
+  {SCTP_NEW_ASSOCIATION,             0, {0}},
+  {SCTP_CLOSE_ASSOCIATION,           0, {0}},
+  {S1AP_INITIAL_UE_MESSAGE,          1, {offsetof (msg_t, s1ap_initial_ue_message.nas)}},
+  {S1AP_UE_CONTEXT_RELEASE_REQ,      0, {0}},
+  {S1AP_UE_CONTEXT_RELEASE_COMPLETE, 0, {0}},
+  {NAS_UPLINK_DATA_IND,              1, {offsetof (msg_t, nas_ul_data_ind.nas_msg)}},
+  {S6A_AUTH_INFO_ANS,                0, {0}},
+  {S6A_CANCEL_LOCATION_REQ,          0, {0}},
+  {S6A_NOTIFY_ANS,                   0, {0}},
+};
+
+/* A capture file, written through its mapping. The senders reserve their record with an atomic
+ * add on offset, the one whose reservation crosses the end of the file records where the file ends. */
+typedef struct itti_capture_file_s {
+  uint64_t                                offset __attribute__ ((aligned (64)));  /*!< \brief next free byte */
+  uint32_t                                nb_writers;               /*!< \brief senders between their reservation and the end of their copy */
+  uint32_t                                file_index;
+  size_t                                  end;                      /*!< \brief end of the records once full, 0 before */
+  int                                     fd;
+  uint8_t                                *base;
+} itti_capture_file_t;
+
+/* The sender that fills a file switches to the next one, already mapped by the helper thread,
+ * and hands the full file over to the helper which closes it and maps the following one.
+ * The mutex only serializes the switches with the helper, it is not taken per message. */
+typedef struct itti_capture_s {
+  pthread_mutex_t                         mutex;
+  pthread_cond_t                          cond;
+  pthread_t                               helper;
+  bool                                    is_helper_running;
+  bool                                    is_stopping;
+  bstring                                 file_prefix;
+  uint32_t                                file_size;
+  uint32_t                                max_files;
+  itti_capture_file_t                     files[2];
+  itti_capture_file_t                    *current;                  /*!< \brief atomic, file written by the senders */
+  itti_capture_file_t                    *next;                     /*!< \brief mapped by the helper, NULL while it is being prepared */
+  itti_capture_file_t                    *retired;                  /*!< \brief full file to be closed by the helper */
+  uint32_t                                next_file_index;
+  uint64_t                                nb_records;
+  uint64_t                                nb_dropped;
+} itti_capture_t;
+
+typedef struct itti_capture_replay_s {
+  bstring                                 file_prefix;
+  task_id_t                               task_id;
+  bool                                    max_speed;
+} itti_capture_replay_t;
+
+typedef struct itti_capture_replay_file_s {
+  unsigned long                           index;
+  const char                             *path;
+} itti_capture_replay_file_t;
+
+bool                                      itti_capture_enabled = false;
+
+static itti_capture_t                     itti_capture = {.mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER,
+                                                          .files = {{.fd = -1}, {.fd = -1}}};
+static const itti_capture_message_desc_t *itti_capture_descs[MESSAGES_ID_MAX] = {NULL};
+
+//------------------------------------------------------------------------------
+static void itti_capture_init_descs (void)
+{
+  for (int i = 0; i < sizeof (itti_capture_replayable_messages) / sizeof (itti_capture_replayable_messages[0]); i++) {
+    itti_capture_descs[itti_capture_replayable_messages[i].message_id] = &itti_capture_replayable_messages[i];
+  }
+}
+
+//------------------------------------------------------------------------------
+static const itti_capture_message_desc_t * itti_capture_get_desc (const uint32_t message_id, const uint32_t message_size)
+{
+  const itti_capture_message_desc_t      *desc = NULL;
+
+  if (message_id >= MESSAGES_ID_MAX) return NULL;
+  desc = itti_capture_descs[message_id];
+  if (desc) {
+    for (int i = 0; i < desc->nb_bstrings; i++) {
+      if (desc->bstring_offsets[i] + sizeof (bstring) > message_size) return NULL;
+    }
+  }
+  return desc;
+}
+
+//------------------------------------------------------------------------------
+// Wait for the senders still copying in the file, then truncate it to its records
+static void itti_capture_close_file (itti_capture_file_t * const file)
+{
+  size_t                                  end = 0;
+
+  while (__atomic_load_n (&file->nb_writers, __ATOMIC_SEQ_CST)) {
+    sched_yield ();
+  }
+  end = (file->end) ? file->end : __atomic_load_n (&file->offset, __ATOMIC_SEQ_CST);
+  if (end > itti_capture.file_size) {
+    end = itti_capture.file_size;
+  }
+  if (file->base) {
+    munmap (file->base, itti_capture.file_size);
+    file->base = NULL;
+  }
+  if (0 <= file->fd) {
+    // a file not closed (crash) ends with a zeroed record header
+    if (ftruncate (file->fd, end)) {
+      OAILOG_WARNING (LOG_ITTI, "Could not truncate ITTI capture file %s.%u: %s\n", bdata (itti_capture.file_prefix), file->file_index, strerror (errno));
+    }
+    close (file->fd);
+    file->fd = -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Map a new capture file, the senders may use it once it is published as itti_capture.current
+static int itti_capture_open_file (itti_capture_file_t * const file, const uint32_t file_index)
+{
+  itti_capture_file_header_t              header = {{0}};
+  bstring                                 path = bformat ("%s.%u", bdata (itti_capture.file_prefix), file_index);
+  uint8_t                                *base = NULL;
+
+  file->fd = open (bdata (path), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (0 > file->fd) {
+    OAILOG_ERROR (LOG_ITTI, "Could not open ITTI capture file %s: %s\n", bdata (path), strerror (errno));
+    bdestroy_wrapper (&path);
+    return RETURNerror;
+  }
+  // pre-fault the whole file here rather than on the senders
+  if ((ftruncate (file->fd, itti_capture.file_size)) ||
+      (MAP_FAILED == (base = mmap (NULL, itti_capture.file_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, file->fd, 0)))) {
+    OAILOG_ERROR (LOG_ITTI, "Could not map ITTI capture file %s: %s\n", bdata (path), strerror (errno));
+    close (file->fd);
+    file->fd = -1;
+    bdestroy_wrapper (&path);
+    return RETURNerror;
+  }
+  bdestroy_wrapper (&path);
+
+  if (file_index >= itti_capture.max_files) {
+    path = bformat ("%s.%u", bdata (itti_capture.file_prefix), file_index - itti_capture.max_files);
+    unlink (bdata (path));
+    bdestroy_wrapper (&path);
+  }
+
+  memcpy (header.magic, ITTI_CAPTURE_MAGIC, sizeof (header.magic));
+  header.version = ITTI_CAPTURE_VERSION;
+  header.file_index = file_index;
+  header.message_header_size = sizeof (MessageHeader);
+  header.messages_id_max = MESSAGES_ID_MAX;
+  header.start_time_sec = time (NULL);
+  memcpy (base, &header, sizeof (header));
+  file->base = base;
+  file->file_index = file_index;
+  file->end = 0;
+  // a sender still holding this file from its previous use may reserve from now on
+  __atomic_store_n (&file->offset, sizeof (header), __ATOMIC_SEQ_CST);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+// Closes the full files and maps the next one ahead of the senders
+static void * itti_capture_helper_thread (__attribute__ ((unused)) void *args)
+{
+  pthread_mutex_lock (&itti_capture.mutex);
+  while (!itti_capture.is_stopping) {
+    if (itti_capture.retired) {
+      itti_capture_file_t * const         file = itti_capture.retired;
+
+      pthread_mutex_unlock (&itti_capture.mutex);
+      itti_capture_close_file (file);
+      pthread_mutex_lock (&itti_capture.mutex);
+      itti_capture.retired = NULL;
+    } else if ((!itti_capture.next) && (itti_capture_enabled)) {
+      itti_capture_file_t * const         file = (itti_capture.current == &itti_capture.files[0]) ? &itti_capture.files[1] : &itti_capture.files[0];
+      const uint32_t                      file_index = itti_capture.next_file_index++;
+      int                                 rc = RETURNok;
+
+      pthread_mutex_unlock (&itti_capture.mutex);
+      rc = itti_capture_open_file (file, file_index);
+      pthread_mutex_lock (&itti_capture.mutex);
+      if (RETURNok == rc) {
+        itti_capture.next = file;
+      } else {
+        __atomic_store_n (&itti_capture_enabled, false, __ATOMIC_SEQ_CST);
+      }
+      pthread_cond_broadcast (&itti_capture.cond);
+    } else {
+      pthread_cond_wait (&itti_capture.cond, &itti_capture.mutex);
+    }
+  }
+  pthread_mutex_unlock (&itti_capture.mutex);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+// Called by a sender that could not reserve its record in the full file
+static void itti_capture_switch_file (itti_capture_file_t * const full_file)
+{
+  pthread_mutex_lock (&itti_capture.mutex);
+  // only the first sender switches, the helper is normally ahead, senders wait only if it is not
+  while ((full_file == itti_capture.current) && (!itti_capture.next) && (itti_capture_enabled)) {
+    pthread_cond_wait (&itti_capture.cond, &itti_capture.mutex);
+  }
+  if ((full_file == itti_capture.current) && (itti_capture.next) && (!itti_capture.retired)) {
+    __atomic_store_n (&itti_capture.current, itti_capture.next, __ATOMIC_SEQ_CST);
+    itti_capture.next = NULL;
+    itti_capture.retired = full_file;
+    pthread_cond_broadcast (&itti_capture.cond);
+  }
+  pthread_mutex_unlock (&itti_capture.mutex);
+}
+
+//------------------------------------------------------------------------------
+static void itti_capture_remove_files (const char * const file_prefix)
+{
+  glob_t                                  files = {0};
+  bstring                                 pattern = bformat ("%s.[0-9]*", file_prefix);
+
+  if (!glob (bdata (pattern), 0, NULL, &files)) {
+    for (size_t i = 0; i < files.gl_pathc; i++) {
+      unlink (files.gl_pathv[i]);
+    }
+  }
+  globfree (&files);
+  bdestroy_wrapper (&pattern);
+}
+
+//------------------------------------------------------------------------------
+bool itti_capture_is_same_prefix (const char * const prefix1, const char * const prefix2)
+{
+  const char                             *prefixes[2] = {prefix1, prefix2};
+  char                                    dirs[2][PATH_MAX] = {{0}};
+  bstring                                 names[2] = {NULL, NULL};
+  bool                                    is_same = false;
+
+  for (int i = 0; i < 2; i++) {
+    char                                 *dir_copy = strdup (prefixes[i]);
+    char                                 *name_copy = strdup (prefixes[i]);
+
+    // the directory may be given through different paths
+    if (!realpath (dirname (dir_copy), dirs[i])) {
+      strncpy (dirs[i], prefixes[i], PATH_MAX - 1);
+    }
+    names[i] = bfromcstr (basename (name_copy));
+    free_wrapper ((void**)&dir_copy);
+    free_wrapper ((void**)&name_copy);
+  }
+  is_same = (!strcmp (dirs[0], dirs[1])) && (1 == biseq (names[0], names[1]));
+  bdestroy_wrapper (&names[0]);
+  bdestroy_wrapper (&names[1]);
+  return is_same;
+}
+
+//------------------------------------------------------------------------------
+int itti_capture_init (const char * const capture_file, const uint32_t file_size, const uint32_t max_files)
+{
+  int                                     rc = RETURNok;
+
+  AssertFatal (capture_file, "No capture file\n");
+  itti_capture_init_descs ();
+  itti_capture_remove_files (capture_file);
+
+  pthread_mutex_lock (&itti_capture.mutex);
+  itti_capture.file_prefix = bfromcstr (capture_file);
+  itti_capture.file_size = (file_size) ? file_size : ITTI_CAPTURE_FILE_SIZE_DEFAULT;
+  itti_capture.max_files = (max_files) ? max_files : ITTI_CAPTURE_MAX_FILES_DEFAULT;
+  itti_capture.nb_records = 0;
+  itti_capture.nb_dropped = 0;
+  itti_capture.is_stopping = false;
+  itti_capture.next = NULL;
+  itti_capture.retired = NULL;
+  itti_capture.next_file_index = 1;
+  rc = itti_capture_open_file (&itti_capture.files[0], 0);
+  if (RETURNok == rc) {
+    itti_capture.current = &itti_capture.files[0];
+    itti_capture_enabled = true;
+    if (pthread_create (&itti_capture.helper, NULL, itti_capture_helper_thread, NULL)) {
+      OAILOG_ERROR (LOG_ITTI, "Could not start the ITTI capture helper thread\n");
+      itti_capture_enabled = false;
+      itti_capture_close_file (&itti_capture.files[0]);
+      rc = RETURNerror;
+    } else {
+      itti_capture.is_helper_running = true;
+    }
+  }
+  pthread_mutex_unlock (&itti_capture.mutex);
+  if (RETURNok == rc) {
+    OAILOG_INFO (LOG_ITTI, "Capturing ITTI messages in %s.<index>, %u files of %u bytes\n", capture_file, itti_capture.max_files, itti_capture.file_size);
+  }
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+void itti_capture_message (const MessageDef * const message_p, const message_number_t message_number)
+{
+  const uint32_t                          message_id = message_p->ittiMsgHeader.messageId;
+  const uint32_t                          message_size = message_p->ittiMsgHeader.ittiMsgSize;
+  const itti_capture_message_desc_t      *desc = itti_capture_get_desc (message_id, message_size);
+  bstring                                 bstrings[ITTI_CAPTURE_BSTRINGS_MAX] = {NULL};
+  itti_capture_record_header_t            header = {0};
+  struct timespec                         now = {0};
+  size_t                                  length = sizeof (header) + ITTI_CAPTURE_ALIGN (message_size);
+
+  if (desc) {
+    for (int i = 0; i < desc->nb_bstrings; i++) {
+      memcpy (&bstrings[i], (const uint8_t *)&message_p->ittiMsg + desc->bstring_offsets[i], sizeof (bstring));
+      length += sizeof (itti_capture_bstring_t) + ((bstrings[i]) ? ITTI_CAPTURE_ALIGN (blength (bstrings[i])) : 0);
+    }
+    header.nb_bstrings = desc->nb_bstrings;
+    header.flags = ITTI_CAPTURE_RECORD_REPLAYABLE;
+  }
+  clock_gettime (CLOCK_REALTIME, &now);
+  header.length = length;
+  header.message_id = message_id;
+  header.origin_task_id = message_p->ittiMsgHeader.originTaskId;
+  header.destination_task_id = message_p->ittiMsgHeader.destinationTaskId;
+  header.instance = message_p->ittiMsgHeader.instance;
+  header.message_size = message_size;
+  header.message_number = message_number;
+  header.timestamp_ns = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+
+  if (length > itti_capture.file_size - sizeof (itti_capture_file_header_t)) {
+    __atomic_add_fetch (&itti_capture.nb_dropped, 1, __ATOMIC_RELAXED);
+    return;
+  }
+  for (;;) {
+    itti_capture_file_t * const           file = __atomic_load_n (&itti_capture.current, __ATOMIC_SEQ_CST);
+    uint64_t                              offset = 0;
+
+    // counted before the reservation: the file is not closed under a sender
+    __atomic_add_fetch (&file->nb_writers, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n (&itti_capture_enabled, __ATOMIC_SEQ_CST)) {
+      __atomic_sub_fetch (&file->nb_writers, 1, __ATOMIC_SEQ_CST);
+      return;
+    }
+    offset = __atomic_fetch_add (&file->offset, length, __ATOMIC_SEQ_CST);
+    if (offset + length <= itti_capture.file_size) {
+      uint8_t *record = &file->base[offset];
+
+      memcpy (record, &header, sizeof (header));
+      record += sizeof (header);
+      memcpy (record, &message_p->ittiMsg, message_size);
+      record += ITTI_CAPTURE_ALIGN (message_size);
+      for (int i = 0; i < header.nb_bstrings; i++) {
+        itti_capture_bstring_t field = {.offset = desc->bstring_offsets[i], .length = (bstrings[i]) ? blength (bstrings[i]) : -1};
+        memcpy (record, &field, sizeof (field));
+        record += sizeof (field);
+        if (0 < field.length) {
+          memcpy (record, bdata (bstrings[i]), field.length);
+          record += ITTI_CAPTURE_ALIGN (field.length);
+        }
+      }
+      __atomic_sub_fetch (&file->nb_writers, 1, __ATOMIC_SEQ_CST);
+      __atomic_add_fetch (&itti_capture.nb_records, 1, __ATOMIC_RELAXED);
+      return;
+    }
+    if (offset <= itti_capture.file_size) {
+      // the only reservation crossing the end of the file
+      file->end = offset;
+    }
+    __atomic_sub_fetch (&file->nb_writers, 1, __ATOMIC_SEQ_CST);
+    itti_capture_switch_file (file);
+  }
+}
+
+//------------------------------------------------------------------------------
+void itti_capture_exit (void)
+{
+  pthread_mutex_lock (&itti_capture.mutex);
+  const bool                              is_enabled = itti_capture_enabled;
+
+  __atomic_store_n (&itti_capture_enabled, false, __ATOMIC_SEQ_CST);
+  itti_capture.is_stopping = true;
+  pthread_cond_broadcast (&itti_capture.cond);
+  pthread_mutex_unlock (&itti_capture.mutex);
+  if (itti_capture.is_helper_running) {
+    pthread_join (itti_capture.helper, NULL);
+    itti_capture.is_helper_running = false;
+  }
+  if (itti_capture.retired) {
+    itti_capture_close_file (itti_capture.retired);
+    itti_capture.retired = NULL;
+  }
+  if (itti_capture.next) {
+    // mapped ahead, never written
+    bstring path = bformat ("%s.%u", bdata (itti_capture.file_prefix), itti_capture.next->file_index);
+    itti_capture_close_file (itti_capture.next);
+    unlink (bdata (path));
+    bdestroy_wrapper (&path);
+    itti_capture.next = NULL;
+  }
+  if (itti_capture.current) {
+    itti_capture_close_file (itti_capture.current);
+    if (is_enabled) {
+      OAILOG_INFO (LOG_ITTI, "ITTI capture %s: %" PRIu64 " messages in %u files, %" PRIu64 " dropped (larger than a file)\n",
+          bdata (itti_capture.file_prefix), itti_capture.nb_records, itti_capture.current->file_index + 1, itti_capture.nb_dropped);
+    }
+  }
+  bdestroy_wrapper (&itti_capture.file_prefix);
+}
+
+//------------------------------------------------------------------------------
+static int itti_capture_compare_files (const void *a, const void *b)
+{
+  const itti_capture_replay_file_t * const file_a = a;
+  const itti_capture_replay_file_t * const file_b = b;
+
+  return (file_a->index > file_b->index) - (file_a->index < file_b->index);
+}
+
+//------------------------------------------------------------------------------
+static MessageDef * itti_capture_rebuild_message (const itti_capture_record_header_t * const header, const uint8_t * const record)
+{
+  const uint8_t                          *field_p = &record[sizeof (*header) + ITTI_CAPTURE_ALIGN (header->message_size)];
+  const uint8_t                          *end = &record[header->length];
+  MessageDef                             *message_p = itti_alloc_new_message_sized (header->origin_task_id, header->message_id, header->message_size);
+
+  memcpy (&message_p->ittiMsg, &record[sizeof (*header)], header->message_size);
+  for (int i = 0; i < header->nb_bstrings; i++) {
+    itti_capture_bstring_t                field = {0};
+    bstring                               b = NULL;
+
+    if (field_p + sizeof (field) > end) break;
+    memcpy (&field, field_p, sizeof (field));
+    field_p += sizeof (field);
+    if (field.offset + sizeof (bstring) > header->message_size) break;
+    if (0 <= field.length) {
+      if (field_p + field.length > end) break;
+      b = blk2bstr (field_p, field.length);
+      field_p += ITTI_CAPTURE_ALIGN (field.length);
+    }
+    memcpy ((uint8_t *)&message_p->ittiMsg + field.offset, &b, sizeof (b));
+  }
+  return message_p;
+}
+
+//------------------------------------------------------------------------------
+static void * itti_capture_replay_thread (void *args)
+{
+  itti_capture_replay_t                  *replay = (itti_capture_replay_t *)args;
+  const uint32_t                          queue_high = itti_get_task_queue_size (replay->task_id) * ITTI_CAPTURE_REPLAY_QUEUE_HIGH_PERCENT / 100;
+  glob_t                                  files = {0};
+  itti_capture_replay_file_t             *ordered_files = NULL;
+  bstring                                 pattern = bformat ("%s.[0-9]*", bdata (replay->file_prefix));
+  struct timespec                         start = {0};
+  struct timespec                         end = {0};
+  uint64_t                                first_timestamp_ns = 0;
+  uint64_t                                nb_replayed = 0;
+  uint64_t                                nb_skipped = 0;
+  uint64_t                                nb_dropped = 0;
+
+  while (!itti_is_task_ready (replay->task_id)) {
+    usleep (10000);
+  }
+  if ((glob (bdata (pattern), 0, NULL, &files)) || (!files.gl_pathc)) {
+    OAILOG_ERROR (LOG_ITTI, "No ITTI capture file %s\n", bdata (pattern));
+    goto done;
+  }
+  ordered_files = calloc (files.gl_pathc, sizeof (itti_capture_replay_file_t));
+  for (size_t i = 0; i < files.gl_pathc; i++) {
+    ordered_files[i].index = strtoul (strrchr (files.gl_pathv[i], '.') + 1, NULL, 10);
+    ordered_files[i].path = files.gl_pathv[i];
+  }
+  qsort (ordered_files, files.gl_pathc, sizeof (itti_capture_replay_file_t), itti_capture_compare_files);
+  OAILOG_INFO (LOG_ITTI, "Replaying %zu ITTI capture files %s to %s at %s speed\n", files.gl_pathc, bdata (pattern),
+      itti_get_task_name (replay->task_id), (replay->max_speed) ? "maximum" : "original");
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (size_t f = 0; f < files.gl_pathc; f++) {
+    struct stat                           st = {0};
+    uint8_t                              *base = NULL;
+    itti_capture_file_header_t            file_header = {{0}};
+    size_t                                offset = sizeof (file_header);
+    int                                   fd = open (ordered_files[f].path, O_RDONLY);
+
+    if ((0 > fd) || (fstat (fd, &st)) || (st.st_size < sizeof (file_header)) ||
+        (MAP_FAILED == (base = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)))) {
+      OAILOG_ERROR (LOG_ITTI, "Could not map ITTI capture file %s\n", ordered_files[f].path);
+      if (0 <= fd) close (fd);
+      continue;
+    }
+    madvise (base, st.st_size, MADV_SEQUENTIAL);
+    memcpy (&file_header, base, sizeof (file_header));
+    if ((memcmp (file_header.magic, ITTI_CAPTURE_MAGIC, sizeof (file_header.magic))) || (ITTI_CAPTURE_VERSION != file_header.version) ||
+        (sizeof (MessageHeader) != file_header.message_header_size) || (MESSAGES_ID_MAX != file_header.messages_id_max)) {
+      OAILOG_ERROR (LOG_ITTI, "%s is not an ITTI capture of this build\n", ordered_files[f].path);
+      offset = st.st_size;
+    }
+
+    while (offset + sizeof (itti_capture_record_header_t) <= st.st_size) {
+      itti_capture_record_header_t        header = {0};
+      const uint8_t                      *record = &base[offset];
+
+      memcpy (&header, record, sizeof (header));
+      if ((!header.length) || (offset + header.length > st.st_size) ||
+          (header.length < sizeof (header) + header.message_size)) {
+        break;
+      }
+      offset += header.length;
+      if (header.destination_task_id != replay->task_id) {
+        continue;
+      }
+      if ((!(header.flags & ITTI_CAPTURE_RECORD_REPLAYABLE)) || (!itti_capture_get_desc (header.message_id, header.message_size))) {
+        nb_skipped++;
+        continue;
+      }
+
+      if (!first_timestamp_ns) {
+        first_timestamp_ns = header.timestamp_ns;
+      }
+      if (replay->max_speed) {
+        while (itti_get_task_queue_count (replay->task_id) >= queue_high) {
+          usleep (ITTI_CAPTURE_REPLAY_POLL_US);
+        }
+      } else {
+        const uint64_t                    delay_ns = header.timestamp_ns - first_timestamp_ns;
+        struct timespec                   deadline = start;
+
+        deadline.tv_sec += delay_ns / 1000000000ULL;
+        deadline.tv_nsec += delay_ns % 1000000000ULL;
+        if (deadline.tv_nsec >= 1000000000L) {
+          deadline.tv_sec++;
+          deadline.tv_nsec -= 1000000000L;
+        }
+        while (EINTR == clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL));
+      }
+      if (itti_send_msg_to_task (replay->task_id, header.instance, itti_capture_rebuild_message (&header, record)) < 0) {
+        nb_dropped++;
+      } else {
+        nb_replayed++;
+      }
+    }
+    munmap (base, st.st_size);
+    close (fd);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  {
+    const double                          elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    OAILOG_INFO (LOG_ITTI, "ITTI replay to %s done: %" PRIu64 " messages in %.3f s (%.0f messages/s), %" PRIu64 " not replayable skipped, %" PRIu64 " dropped\n",
+        itti_get_task_name (replay->task_id), nb_replayed, elapsed, (elapsed > 0) ? nb_replayed / elapsed : 0.0, nb_skipped, nb_dropped);
+  }
+
+done:
+  free_wrapper ((void**)&ordered_files);
+  globfree (&files);
+  bdestroy_wrapper (&pattern);
+  bdestroy_wrapper (&replay->file_prefix);
+  free_wrapper ((void**)&replay);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int itti_capture_replay_start (const char * const capture_file, const char * const task_name, const bool max_speed)
+{
+  itti_capture_replay_t                  *replay = NULL;
+  pthread_t                               thread;
+  pthread_attr_t                          attr;
+  task_id_t                               task_id = itti_get_task_id (task_name);
+
+  if (TASK_UNKNOWN == task_id) {
+    bstring full_name = bformat ("TASK_%s", task_name);
+    task_id = itti_get_task_id (bdata (full_name));
+    bdestroy_wrapper (&full_name);
+  }
+  if (TASK_UNKNOWN == task_id) {
+    OAILOG_ERROR (LOG_ITTI, "Unknown ITTI replay task %s\n", task_name);
+    return RETURNerror;
+  }
+  // the capture removed the files of its prefix and rewrites them
+  if ((itti_capture_enabled) && (itti_capture.file_prefix) && (itti_capture_is_same_prefix (capture_file, bdata (itti_capture.file_prefix)))) {
+    OAILOG_ERROR (LOG_ITTI, "Can not replay %s, it is the ITTI capture in progress\n", capture_file);
+    return RETURNerror;
+  }
+  itti_capture_init_descs ();
+  replay = calloc (1, sizeof (itti_capture_replay_t));
+  replay->file_prefix = bfromcstr (capture_file);
+  replay->task_id = task_id;
+  replay->max_speed = max_speed;
+
+  pthread_attr_init (&attr);
+  pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+  if (pthread_create (&thread, &attr, itti_capture_replay_thread, replay)) {
+    OAILOG_ERROR (LOG_ITTI, "Could not start the ITTI replay thread\n");
+    pthread_attr_destroy (&attr);
+    bdestroy_wrapper (&replay->file_prefix);
+    free_wrapper ((void**)&replay);
+    return RETURNerror;
+  }
+  pthread_attr_destroy (&attr);
+  return RETURNok;
+}
@@ -0,0 +1,121 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_capture.h
+  \brief Capture of the ITTI messages in rotating mmap'd files (<capture_file>.<index>) and
+  replay of a capture into a task of the running process.
+  A sender reserves its record with an atomic add on the offset of the current file and appends
+  it with a memcpy, the files are pre-faulted by a helper thread and written back by the kernel,
+  there is no lock and no system call per message.
+*/
+
+#ifndef INTERTASK_INTERFACE_CAPTURE_H_
+#define INTERTASK_INTERFACE_CAPTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ITTI_CAPTURE_MAGIC                  "OAIITTI1"
+#define ITTI_CAPTURE_VERSION                1
+
+#define ITTI_CAPTURE_FILE_SIZE_DEFAULT      (64*1024*1024)
+#define ITTI_CAPTURE_MAX_FILES_DEFAULT      8
+#define ITTI_CAPTURE_BSTRINGS_MAX           4     /*!< \brief max number of bstring fields in a replayable message */
+
+/*! \struct  itti_capture_file_header_t
+* \brief Header of a capture file. A capture is only replayed by the build that recorded it.
+*/
+typedef struct itti_capture_file_header_s {
+  char         magic[8];
+  uint32_t     version;
+  uint32_t     file_index;
+  uint32_t     message_header_size;   /*!< \brief sizeof (MessageHeader) */
+  uint32_t     messages_id_max;
+  int64_t      start_time_sec;
+} itti_capture_file_header_t;
+
+#define ITTI_CAPTURE_RECORD_REPLAYABLE      (1 << 0)   /*!< \brief All pointers of the message are in the record */
+
+/*! \struct  itti_capture_record_header_t
+* \brief Header of a record, 8 bytes aligned. A record with a length of 0 ends the file.
+* It is followed by the message payload (message_size bytes, padded), then for a replayable
+* message by nb_bstrings itti_capture_bstring_t, each followed by its data (padded).
+*/
+typedef struct itti_capture_record_header_s {
+  uint32_t     length;                /*!< \brief Length of the record, header included */
+  uint32_t     message_id;
+  uint16_t     origin_task_id;
+  uint16_t     destination_task_id;
+  uint16_t     instance;
+  uint8_t      nb_bstrings;
+  uint8_t      flags;
+  uint32_t     message_size;          /*!< \brief ittiMsgSize */
+  uint32_t     reserved;
+  uint64_t     message_number;
+  uint64_t     timestamp_ns;          /*!< \brief CLOCK_REALTIME when the message was sent */
+} itti_capture_record_header_t;
+
+/*! \struct  itti_capture_bstring_t
+* \brief bstring field of a captured message.
+*/
+typedef struct itti_capture_bstring_s {
+  uint32_t     offset;                /*!< \brief Offset of the field in ittiMsg */
+  int32_t      length;                /*!< \brief -1 for a NULL bstring */
+} itti_capture_bstring_t;
+
+/*! \brief Checked by itti_send_msg_to_task(), set by itti_capture_init(). */
+extern bool itti_capture_enabled;
+
+/*! \fn int itti_capture_init(const char * const capture_file, const uint32_t file_size, const uint32_t max_files)
+ * \brief Start capturing the messages sent through ITTI, previous files of the same capture are removed.
+ * \param[in] capture_file Prefix of the capture files.
+ * \param[in] file_size Size of a capture file, 0 for ITTI_CAPTURE_FILE_SIZE_DEFAULT.
+ * \param[in] max_files Number of files kept, the oldest is removed on rotation, 0 for ITTI_CAPTURE_MAX_FILES_DEFAULT.
+ * \return 0 on success, -1 otherwise.
+ */
+int itti_capture_init(const char * const capture_file, const uint32_t file_size, const uint32_t max_files);
+
+/*! \fn bool itti_capture_is_same_prefix(const char * const prefix1, const char * const prefix2)
+ * \brief Whether two capture file prefixes designate the same files, a capture can not be replayed while it is recorded.
+ */
+bool itti_capture_is_same_prefix(const char * const prefix1, const char * const prefix2);
+
+/*! \fn void itti_capture_message(const MessageDef * const message_p, const message_number_t message_number)
+ * \brief Append a message to the capture, called by itti_send_msg_to_task() before the message is enqueued.
+ */
+void itti_capture_message(const MessageDef * const message_p, const message_number_t message_number);
+
+/*! \fn void itti_capture_exit(void)
+ * \brief Stop the capture, the current file is truncated to its records.
+ */
+void itti_capture_exit(void);
+
+/*! \fn int itti_capture_replay_start(const char * const capture_file, const char * const task_name, const bool max_speed)
+ * \brief Start a thread reinjecting the messages of a capture sent to a task.
+ * Messages carrying pointers that are not described in the capture (timers, S11, ...) are skipped.
+ * \param[in] capture_file Prefix of the capture files, all <capture_file>.<index> are replayed in order.
+ * \param[in] task_name Name of the destination task, "TASK_S1AP" or "S1AP".
+ * \param[in] max_speed false to reproduce the original pacing, true to send as fast as the task dequeues.
+ * \return 0 on success, -1 otherwise.
+ */
+int itti_capture_replay_start(const char * const capture_file, const char * const task_name, const bool max_speed);
+
+#endif /* INTERTASK_INTERFACE_CAPTURE_H_ */
@@ -47,3 +47,6 @@ MESSAGE_DEF(DEBUG_LOG,          MESSAGE_PRIORITY_MED, IttiMsgEmpty, debug_log)
 
 /* Generic log message for text */
 MESSAGE_DEF(GENERIC_LOG,        MESSAGE_PRIORITY_MED, IttiMsgEmpty, generic_log)
+
+/* Queue of a task crossing its overload watermarks (ITTI_OVERLOAD_POLICY_SIGNAL) */
+MESSAGE_DEF(ITTI_OVERLOAD_IND,  MESSAGE_PRIORITY_MAX, itti_overload_ind_t, itti_overload_ind)
@@ -38,4 +38,13 @@ typedef struct IttiMsgText_s {
   char      text[];
 } IttiMsgText;
 
+#define ITTI_OVERLOAD_IND(mSGpTR)           (mSGpTR)->ittiMsg.itti_overload_ind
+
+typedef struct itti_overload_ind_s {
+  uint32_t  task_id;        ///< Task whose queue crossed a watermark
+  uint32_t  queue_depth;
+  uint32_t  queue_size;
+  bool      overloaded;     ///< true above the high watermark, false back below the low watermark
+} itti_overload_ind_t;
+
 #endif /* INTERTASK_MESSAGES_TYPES_H_ */
@@ -116,8 +116,8 @@ timer_handle_signal (
    * Notify task of timer expiry
    */
   if (itti_send_msg_to_task (task_id, instance, message_p) < 0) {
+    // the message has been released by itti_send_msg_to_task
     OAILOG_DEBUG (LOG_ITTI, "Failed to send msg TIMER_HAS_EXPIRED to task %u\n", task_id);
-    itti_free (TASK_TIMER, message_p);
     return -1;
   }
 
@@ -116,6 +116,19 @@ void itti_free_msg_content (MessageDef * const message_p)
   case NAS_CONTEXT_FAIL:
     // DO nothing
     break;
+  case NAS_CHECKPOINT_REQ:
+    break;
+  case NAS_CHECKPOINT_RSP:
+    free_wrapper ((void**)&message_p->ittiMsg.nas_checkpoint_rsp.ues_ptr);
+    break;
+  case NAS_IDLE_COMPACT_REQ:
+    free_wrapper ((void**)&message_p->ittiMsg.nas_idle_compact_req.ue_ids_ptr);
+    break;
+  case NAS_IDLE_COMPACT_RSP:
+    free_wrapper ((void**)&message_p->ittiMsg.nas_idle_compact_rsp.ue_ids_ptr);
+    break;
+  case NAS_IDLE_EXPAND_REQ:
+    break;
   case NAS_CONNECTION_ESTABLISHMENT_CNF:
     bdestroy_wrapper (&message_p->ittiMsg.nas_conn_est_cnf.nas_msg);
     AssertFatal(NULL == message_p->ittiMsg.nas_conn_est_cnf.nas_msg, "TODO clean pointer");
@@ -74,4 +74,13 @@ MESSAGE_DEF(NAS_CONTEXT_FAIL,                   MESSAGE_PRIORITY_MED,   itti_nas
 
 MESSAGE_DEF(NAS_IMPLICIT_DETACH_UE_IND,         MESSAGE_PRIORITY_MED,   itti_nas_implicit_detach_ue_ind_t, nas_implicit_detach_ue_ind)
 
+/** UE contexts checkpoint, the EMM contexts are read by the NAS EMM task. */
+MESSAGE_DEF(NAS_CHECKPOINT_REQ,                 MESSAGE_PRIORITY_MED,   itti_nas_checkpoint_req_t,       nas_checkpoint_req)
+MESSAGE_DEF(NAS_CHECKPOINT_RSP,                 MESSAGE_PRIORITY_MED,   itti_nas_checkpoint_rsp_t,       nas_checkpoint_rsp)
+
+/** Idle compaction, the EMM contexts are dropped and rebuilt by the NAS EMM task. */
+MESSAGE_DEF(NAS_IDLE_COMPACT_REQ,               MESSAGE_PRIORITY_MED,   itti_nas_idle_compact_req_t,     nas_idle_compact_req)
+MESSAGE_DEF(NAS_IDLE_COMPACT_RSP,               MESSAGE_PRIORITY_MED_PLUS, itti_nas_idle_compact_rsp_t,  nas_idle_compact_rsp)
+MESSAGE_DEF(NAS_IDLE_EXPAND_REQ,                MESSAGE_PRIORITY_MED_PLUS, itti_nas_idle_expand_req_t,   nas_idle_expand_req)
+
 
@@ -73,6 +73,12 @@
 #define NAS_CONTEXT_RES(mSGpTR)                  (mSGpTR)->ittiMsg.nas_context_res
 #define NAS_CONTEXT_FAIL(mSGpTR)                 (mSGpTR)->ittiMsg.nas_context_fail
 
+#define NAS_CHECKPOINT_REQ(mSGpTR)               (mSGpTR)->ittiMsg.nas_checkpoint_req
+#define NAS_CHECKPOINT_RSP(mSGpTR)               (mSGpTR)->ittiMsg.nas_checkpoint_rsp
+#define NAS_IDLE_COMPACT_REQ(mSGpTR)             (mSGpTR)->ittiMsg.nas_idle_compact_req
+#define NAS_IDLE_COMPACT_RSP(mSGpTR)             (mSGpTR)->ittiMsg.nas_idle_compact_rsp
+#define NAS_IDLE_EXPAND_REQ(mSGpTR)              (mSGpTR)->ittiMsg.nas_idle_expand_req
+
 typedef enum pdn_conn_rsp_cause_e {
   CAUSE_OK = 16,
   CAUSE_CONTEXT_NOT_FOUND = 64,
@@ -277,6 +283,33 @@ typedef struct itti_nas_context_fail_s {
 //  uint64_t                imsi;
 } itti_nas_context_fail_t;
 
+/** UE contexts checkpoint. */
+typedef struct itti_nas_checkpoint_req_s {
+  uint32_t                round;
+  uint32_t                nb_ues_max;
+} itti_nas_checkpoint_req_t;
+
+typedef struct itti_nas_checkpoint_rsp_s {
+  uint32_t                round;
+  uint32_t                nb_ues;
+  uintptr_t               ues_ptr;      /**< EMM parts of the registered UEs, freed with the message. */
+} itti_nas_checkpoint_rsp_t;
+
+/** Idle compaction of the ECM-IDLE UEs. */
+typedef struct itti_nas_idle_compact_req_s {
+  uint32_t                nb_ues;
+  uintptr_t               ue_ids_ptr;   /**< mme_ue_s1ap_id_t of the UEs to compact, freed with the message. */
+} itti_nas_idle_compact_req_t;
+
+typedef struct itti_nas_idle_compact_rsp_s {
+  uint32_t                nb_ues;
+  uintptr_t               ue_ids_ptr;   /**< mme_ue_s1ap_id_t of the UEs whose EMM contexts NAS dropped into their idle records, freed with the message. */
+} itti_nas_idle_compact_rsp_t;
+
+typedef struct itti_nas_idle_expand_req_s {
+  mme_ue_s1ap_id_t        ue_id;
+} itti_nas_idle_expand_req_t;
+
 typedef struct itti_nas_pdn_disconnect_req_s {
   mme_ue_s1ap_id_t        ue_id;
   pti_t                   pti;
@@ -0,0 +1,1386 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtp_tunnel_userspace.c
+* \brief Userspace GTP-U forwarding engine, third gtp_tunnel_ops backend.
+*
+*  Uplink:   S1-U UDP socket --recvmmsg--> TEID lookup, decapsulation --write--> TUN
+*  Downlink: TUN --read--> UE IP lookup, encapsulation --sendmmsg--> S1-U UDP socket
+*
+*  Each worker owns one SO_REUSEPORT UDP socket and one IFF_MULTI_QUEUE TUN queue,
+*  the kernel spreads flows on the workers like RSS would do on NIC queues.
+*  Tunnels are stored in flat open addressing tables keyed by local TEID and UE IPv4
+*  address, updated by the S/P-GW task and read by the workers once per batch.
+*  The UE table points to the bearer of the UE with the lowest EBI (no TFT
+*  classification), the other bearers of the UE are chained from it in EBI order.
+*
+*  While the UE is in ECM-IDLE, downlink packets are kept in a bounded per bearer
+*  buffer (drop oldest, TTL) taken from a packet pool allocated at init, and sent
+*  on the new S1-U tunnel when the Modify Bearer Request re-installs it.
+*/
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#include "bstrlib.h"
+
+#include "log.h"
+#include "common_defs.h"
+#include "common_types.h"
+#include "conversions.h"
+#include "dynamic_memory_check.h"
+#include "gtpv1u.h"
+#include "gtpv1u_sgw_defs.h"
+#include "spgw_config.h"
+#include "sgw_downlink_data_notification.h"
+#include "gtp_tunnel_userspace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GTPU_US_PKT_BUF_SIZE          2048
+#define GTPU_US_HEADROOM              GTPU_HEADER_OVERHEAD_MAX
+#define GTPU_US_POLL_TIMEOUT_MS       200
+#define GTPU_US_FLUSH_CHUNK           64
+#define GTPU_US_DL_PKT_DATA_SIZE      (GTPU_HEADER_MIN_SIZE + GTPU_US_PKT_BUF_SIZE - GTPU_US_HEADROOM)
+
+#define GTPU_FLAGS_V1_PT              0x30
+#define GTPU_FLAGS_VERSION_MASK       0xE0
+#define GTPU_FLAGS_PT                 0x10
+#define GTPU_FLAGS_E                  0x04
+#define GTPU_FLAGS_S                  0x02
+#define GTPU_FLAGS_OPTIONAL_MASK      0x07
+#define GTPU_HEADER_MIN_SIZE          8
+#define GTPU_HEADER_OPTIONAL_SIZE     4
+
+#define GTPU_MSG_ECHO_REQUEST         1
+#define GTPU_MSG_ECHO_RESPONSE        2
+#define GTPU_MSG_G_PDU                255
+
+#define GTPU_IE_RECOVERY              14
+
+#define GTPU_US_FHT_EMPTY             0
+#define GTPU_US_FHT_DELETED           UINT32_MAX
+
+/*
+ * Flat open addressing hash table, linear probing, uint32 key to tunnel slot.
+ * Values are tunnel index + 1 so that 0 marks an empty bucket.
+ */
+typedef struct gtpu_us_fht_s {
+  uint32_t   mask;
+  uint32_t   num_deleted;
+  uint32_t  *keys;
+  uint32_t  *values;
+} gtpu_us_fht_t;
+
+/*
+ * Downlink packet buffered while the UE is in ECM-IDLE. Packets are taken from a
+ * pool allocated once at init and chained per bearer, no allocation on the data path.
+ */
+typedef struct gtpu_us_dl_pkt_s {
+  uint64_t        arrival_ms;
+  uint32_t        length;             ///< IP packet length
+  uint32_t        next;               ///< next packet of the bearer, or next free packet, pool index + 1, 0 if none
+  uint8_t         data[GTPU_US_DL_PKT_DATA_SIZE]; ///< GTPU_HEADER_MIN_SIZE bytes of headroom followed by the IP packet
+} gtpu_us_dl_pkt_t;
+
+typedef struct gtpu_us_tunnel_s {
+  struct in_addr  ue;
+  struct in_addr  enb;
+  teid_t          i_tei;
+  teid_t          o_tei;              ///< INVALID_TEID when the UE is in ECM-IDLE
+  ebi_t           ebi;
+  bool            in_use;
+  uint32_t        next_ue_tunnel;     ///< next bearer of the same UE, tunnel index + 1, 0 if none
+  bool            dl_buffer_lock;     ///< workers share the read lock, the buffer needs its own
+  bool            dl_flushing;        ///< buffered packets are being sent, newer packets are still buffered
+  time_t          ddn_clamp_until;    ///< no DL data notification raised before this time
+  uint32_t        dl_head;            ///< oldest buffered packet, pool index + 1, 0 if none
+  uint32_t        dl_tail;
+  uint32_t        dl_count;
+} gtpu_us_tunnel_t;
+
+typedef struct gtpu_us_worker_s {
+  int                     id;
+  pthread_t               thread;
+  int                     udp_fd;
+  int                     tun_fd;
+
+  uint8_t                *ul_bufs;
+  struct mmsghdr         *ul_msgs;
+  struct iovec           *ul_iovs;
+  struct sockaddr_in     *ul_peers;
+  uint32_t               *ul_offsets;
+  uint32_t               *ul_lengths;
+
+  uint8_t                *dl_bufs;
+  uint32_t               *dl_lengths;
+  struct mmsghdr         *dl_msgs;
+  struct iovec           *dl_iovs;
+  struct sockaddr_in     *dl_peers;
+  struct in_addr         *ddn_ue;
+  ebi_t                  *ddn_ebi;
+
+  gtpu_userspace_stats_t  stats;
+} gtpu_us_worker_t;
+
+static struct {
+  bool                    is_enabled;
+  volatile bool           running;
+  bstring                 tun_name;
+  struct in_addr          s1u_addr;
+  int                     num_workers;
+  int                     batch_size;
+  uint8_t                 restart_counter;
+  uint32_t                dl_buffer_packets;
+  uint32_t                dl_buffer_ttl_ms;
+  int                     flush_fd;        ///< S1-U socket of the S/P-GW tasks sending the buffered packets
+
+  gtpu_us_dl_pkt_t       *dl_pool;
+  uint32_t                dl_pool_size;
+  uint32_t                dl_pool_free;    ///< first free packet, pool index + 1, 0 if none
+  uint32_t                dl_pool_num_free;
+  bool                    dl_pool_lock;
+
+  pthread_rwlock_t        lock;
+  uint32_t                max_tunnels;
+  gtpu_us_tunnel_t       *tunnels;
+  uint32_t               *free_slots;
+  uint32_t                num_free_slots;
+  gtpu_us_fht_t           teid_table;
+  gtpu_us_fht_t           ue_table;
+
+  gtpu_us_worker_t        workers[GTPU_USERSPACE_WORKERS_MAX];
+  gtpu_userspace_stats_t  flush_stats;     ///< updated atomically by the S/P-GW tasks
+} gtpu_us;
+
+extern spgw_config_t spgw_config;
+
+static int gtpu_us_uninit (void);
+
+//------------------------------------------------------------------------------
+static inline uint32_t gtpu_us_fht_hash (const uint32_t key)
+{
+  uint32_t h = key * 0x9E3779B1U;
+  return h ^ (h >> 16);
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_fht_init (gtpu_us_fht_t * const fht, const uint32_t min_size)
+{
+  uint32_t size = 16;
+  while (size < (min_size << 1)) {
+    size <<= 1;
+  }
+  fht->mask   = size - 1;
+  fht->keys   = calloc (size, sizeof (uint32_t));
+  fht->values = calloc (size, sizeof (uint32_t));
+  if ((!fht->keys) || (!fht->values)) {
+    free_wrapper ((void**)&fht->keys);
+    free_wrapper ((void**)&fht->values);
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_fht_clear (gtpu_us_fht_t * const fht)
+{
+  if (fht->values) {
+    memset (fht->keys, 0, (fht->mask + 1) * sizeof (uint32_t));
+    memset (fht->values, 0, (fht->mask + 1) * sizeof (uint32_t));
+  }
+  fht->num_deleted = 0;
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_fht_free (gtpu_us_fht_t * const fht)
+{
+  free_wrapper ((void**)&fht->keys);
+  free_wrapper ((void**)&fht->values);
+  fht->mask = 0;
+}
+
+//------------------------------------------------------------------------------
+static inline gtpu_us_tunnel_t *gtpu_us_fht_get (const gtpu_us_fht_t * const fht, const uint32_t key)
+{
+  uint32_t i = gtpu_us_fht_hash (key) & fht->mask;
+
+  for (uint32_t probe = 0; probe <= fht->mask; probe++) {
+    const uint32_t value = fht->values[i];
+    if (GTPU_US_FHT_EMPTY == value) {
+      return NULL;
+    }
+    if ((GTPU_US_FHT_DELETED != value) && (fht->keys[i] == key)) {
+      return &gtpu_us.tunnels[value - 1];
+    }
+    i = (i + 1) & fht->mask;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_fht_insert (gtpu_us_fht_t * const fht, const uint32_t key, const uint32_t tunnel_index)
+{
+  uint32_t i = gtpu_us_fht_hash (key) & fht->mask;
+  uint32_t first_deleted = UINT32_MAX;
+
+  for (uint32_t probe = 0; probe <= fht->mask; probe++) {
+    const uint32_t value = fht->values[i];
+    if (GTPU_US_FHT_EMPTY == value) {
+      break;
+    }
+    if (GTPU_US_FHT_DELETED == value) {
+      if (UINT32_MAX == first_deleted) first_deleted = i;
+    } else if (fht->keys[i] == key) {
+      fht->values[i] = tunnel_index + 1;
+      return RETURNok;
+    }
+    i = (i + 1) & fht->mask;
+  }
+  if (UINT32_MAX != first_deleted) {
+    i = first_deleted;
+    fht->num_deleted--;
+  } else if (GTPU_US_FHT_EMPTY != fht->values[i]) {
+    return RETURNerror;
+  }
+  fht->keys[i]   = key;
+  fht->values[i] = tunnel_index + 1;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_fht_remove (gtpu_us_fht_t * const fht, const uint32_t key, const uint32_t tunnel_index)
+{
+  uint32_t i = gtpu_us_fht_hash (key) & fht->mask;
+
+  for (uint32_t probe = 0; probe <= fht->mask; probe++) {
+    const uint32_t value = fht->values[i];
+    if (GTPU_US_FHT_EMPTY == value) {
+      return;
+    }
+    if ((GTPU_US_FHT_DELETED != value) && (fht->keys[i] == key)) {
+      if (value == (tunnel_index + 1)) {
+        fht->values[i] = GTPU_US_FHT_DELETED;
+        fht->num_deleted++;
+      }
+      return;
+    }
+    i = (i + 1) & fht->mask;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Deleted buckets lengthen the probe sequences of misses, purge them when they
+// reach a quarter of the table (called with the write lock held).
+static void gtpu_us_fht_purge_deleted (gtpu_us_fht_t * const fht)
+{
+  const uint32_t size = fht->mask + 1;
+
+  if (fht->num_deleted < (size >> 2)) {
+    return;
+  }
+  uint32_t *keys   = fht->keys;
+  uint32_t *values = fht->values;
+  fht->keys   = calloc (size, sizeof (uint32_t));
+  fht->values = calloc (size, sizeof (uint32_t));
+  if ((!fht->keys) || (!fht->values)) {
+    free_wrapper ((void**)&fht->keys);
+    free_wrapper ((void**)&fht->values);
+    fht->keys   = keys;
+    fht->values = values;
+    return;
+  }
+  fht->num_deleted = 0;
+  for (uint32_t i = 0; i < size; i++) {
+    if ((GTPU_US_FHT_EMPTY != values[i]) && (GTPU_US_FHT_DELETED != values[i])) {
+      gtpu_us_fht_insert (fht, keys[i], values[i] - 1);
+    }
+  }
+  free_wrapper ((void**)&keys);
+  free_wrapper ((void**)&values);
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_tun_open (const char * const name)
+{
+  struct ifreq ifr = {0};
+  int fd = open ("/dev/net/tun", O_RDWR | O_NONBLOCK);
+
+  if (fd < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot open /dev/net/tun: %s\n", strerror (errno));
+    return -1;
+  }
+  ifr.ifr_flags = IFF_TUN | IFF_NO_PI | IFF_MULTI_QUEUE;
+  strncpy (ifr.ifr_name, name, IFNAMSIZ - 1);
+  if (ioctl (fd, TUNSETIFF, (void *)&ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot attach queue to TUN device %s: %s\n", name, strerror (errno));
+    close (fd);
+    return -1;
+  }
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_udp_open (const struct in_addr addr)
+{
+  const int on = 1;
+  struct sockaddr_in sockaddr_s1u = {
+      .sin_family = AF_INET,
+      .sin_port = htons(GTPV1U_UDP_PORT),
+      .sin_addr = addr,
+  };
+  int fd = socket (AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+
+  if (fd < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot create S1U socket: %s\n", strerror (errno));
+    return -1;
+  }
+  if (setsockopt (fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof (on)) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot set SO_REUSEPORT on S1U socket: %s\n", strerror (errno));
+    close (fd);
+    return -1;
+  }
+  if (bind (fd, (struct sockaddr *)&sockaddr_s1u, sizeof (sockaddr_s1u)) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "bind S1U port: %s\n", strerror (errno));
+    close (fd);
+    return -1;
+  }
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+// Socket of the S/P-GW tasks sending the buffered downlink packets, bound to the S1-U
+// address only: the source port of a G-PDU is locally allocated (3GPP TS 29.281 #4.4.2.3)
+// and a socket sharing the S1-U port would take a share of the uplink datagrams.
+static int gtpu_us_flush_open (const struct in_addr addr)
+{
+  struct sockaddr_in sockaddr_s1u = {
+      .sin_family = AF_INET,
+      .sin_port = 0,
+      .sin_addr = addr,
+  };
+  int fd = socket (AF_INET, SOCK_DGRAM, 0);
+
+  if (fd < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot create S1U flush socket: %s\n", strerror (errno));
+    return -1;
+  }
+  if (bind (fd, (struct sockaddr *)&sockaddr_s1u, sizeof (sockaddr_s1u)) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "bind S1U flush socket: %s\n", strerror (errno));
+    close (fd);
+    return -1;
+  }
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_worker_alloc (gtpu_us_worker_t * const w, const int batch)
+{
+  w->ul_bufs    = calloc (batch, GTPU_US_PKT_BUF_SIZE);
+  w->ul_msgs    = calloc (batch, sizeof (struct mmsghdr));
+  w->ul_iovs    = calloc (batch, sizeof (struct iovec));
+  w->ul_peers   = calloc (batch, sizeof (struct sockaddr_in));
+  w->ul_offsets = calloc (batch, sizeof (uint32_t));
+  w->ul_lengths = calloc (batch, sizeof (uint32_t));
+  w->dl_bufs    = calloc (batch, GTPU_US_PKT_BUF_SIZE);
+  w->dl_lengths = calloc (batch, sizeof (uint32_t));
+  w->dl_msgs    = calloc (batch, sizeof (struct mmsghdr));
+  w->dl_iovs    = calloc (batch, sizeof (struct iovec));
+  w->dl_peers   = calloc (batch, sizeof (struct sockaddr_in));
+  w->ddn_ue     = calloc (batch, sizeof (struct in_addr));
+  w->ddn_ebi    = calloc (batch, sizeof (ebi_t));
+
+  if ((!w->ul_bufs) || (!w->ul_msgs) || (!w->ul_iovs) || (!w->ul_peers) || (!w->ul_offsets) || (!w->ul_lengths) ||
+      (!w->dl_bufs) || (!w->dl_lengths) || (!w->dl_msgs) || (!w->dl_iovs) || (!w->dl_peers) || (!w->ddn_ue) || (!w->ddn_ebi)) {
+    return RETURNerror;
+  }
+  for (int i = 0; i < batch; i++) {
+    w->ul_msgs[i].msg_hdr.msg_iov     = &w->ul_iovs[i];
+    w->ul_msgs[i].msg_hdr.msg_iovlen  = 1;
+    w->ul_msgs[i].msg_hdr.msg_name    = &w->ul_peers[i];
+    w->ul_msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+    w->ul_iovs[i].iov_base            = &w->ul_bufs[i * GTPU_US_PKT_BUF_SIZE];
+    w->ul_iovs[i].iov_len             = GTPU_US_PKT_BUF_SIZE;
+    w->dl_msgs[i].msg_hdr.msg_iov     = &w->dl_iovs[i];
+    w->dl_msgs[i].msg_hdr.msg_iovlen  = 1;
+    w->dl_msgs[i].msg_hdr.msg_name    = &w->dl_peers[i];
+    w->dl_msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_worker_free (gtpu_us_worker_t * const w)
+{
+  if (w->udp_fd >= 0) close (w->udp_fd);
+  if (w->tun_fd >= 0) close (w->tun_fd);
+  w->udp_fd = -1;
+  w->tun_fd = -1;
+  free_wrapper ((void**)&w->ul_bufs);
+  free_wrapper ((void**)&w->ul_msgs);
+  free_wrapper ((void**)&w->ul_iovs);
+  free_wrapper ((void**)&w->ul_peers);
+  free_wrapper ((void**)&w->ul_offsets);
+  free_wrapper ((void**)&w->ul_lengths);
+  free_wrapper ((void**)&w->dl_bufs);
+  free_wrapper ((void**)&w->dl_lengths);
+  free_wrapper ((void**)&w->dl_msgs);
+  free_wrapper ((void**)&w->dl_iovs);
+  free_wrapper ((void**)&w->dl_peers);
+  free_wrapper ((void**)&w->ddn_ue);
+  free_wrapper ((void**)&w->ddn_ebi);
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_send_echo_response (gtpu_us_worker_t * const w, const uint8_t * const req, const uint32_t req_len, const struct sockaddr_in * const peer)
+{
+  uint8_t rsp[GTPU_HEADER_MIN_SIZE + GTPU_HEADER_OPTIONAL_SIZE + 2] = {0};
+
+  rsp[0] = GTPU_FLAGS_V1_PT | GTPU_FLAGS_S;
+  rsp[1] = GTPU_MSG_ECHO_RESPONSE;
+  rsp[3] = GTPU_HEADER_OPTIONAL_SIZE + 2;
+  // TEID 0, sequence number copied from the request (29.281 clause 7.2.2)
+  if ((req[0] & GTPU_FLAGS_S) && (req_len >= (GTPU_HEADER_MIN_SIZE + GTPU_HEADER_OPTIONAL_SIZE))) {
+    rsp[8] = req[8];
+    rsp[9] = req[9];
+  }
+  rsp[12] = GTPU_IE_RECOVERY;
+  rsp[13] = gtpu_us.restart_counter;
+  if (sendto (w->udp_fd, rsp, sizeof (rsp), 0, (const struct sockaddr *)peer, sizeof (*peer)) < 0) {
+    w->stats.drop_io++;
+  } else {
+    w->stats.echo_responses++;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns the length of the GTP-U header including optional fields and
+// extension headers, or 0 if the datagram is malformed.
+static inline uint32_t gtpu_us_header_length (const uint8_t * const pkt, const uint32_t len)
+{
+  uint32_t hdr_len = GTPU_HEADER_MIN_SIZE;
+
+  if ((len < GTPU_HEADER_MIN_SIZE) || ((pkt[0] & (GTPU_FLAGS_VERSION_MASK | GTPU_FLAGS_PT)) != GTPU_FLAGS_V1_PT)) {
+    return 0;
+  }
+  if ((((uint32_t)pkt[2] << 8) | pkt[3]) + GTPU_HEADER_MIN_SIZE > len) {
+    return 0;
+  }
+  if (pkt[0] & GTPU_FLAGS_OPTIONAL_MASK) {
+    hdr_len += GTPU_HEADER_OPTIONAL_SIZE;
+    if (hdr_len > len) {
+      return 0;
+    }
+    if (pkt[0] & GTPU_FLAGS_E) {
+      uint8_t next_ext = pkt[hdr_len - 1];
+      while (next_ext) {
+        if (hdr_len >= len) return 0;
+        const uint32_t ext_len = ((uint32_t)pkt[hdr_len]) << 2;
+        if ((!ext_len) || ((hdr_len + ext_len) > len)) return 0;
+        next_ext = pkt[hdr_len + ext_len - 1];
+        hdr_len += ext_len;
+      }
+    }
+  }
+  return hdr_len;
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_uplink_batch (gtpu_us_worker_t * const w)
+{
+  int       num_fwd = 0;
+  const int n = recvmmsg (w->udp_fd, w->ul_msgs, gtpu_us.batch_size, MSG_DONTWAIT, NULL);
+
+  if (n <= 0) {
+    return;
+  }
+
+  pthread_rwlock_rdlock (&gtpu_us.lock);
+  for (int i = 0; i < n; i++) {
+    uint8_t        *pkt = w->ul_iovs[i].iov_base;
+    const uint32_t  len = w->ul_msgs[i].msg_len;
+    const uint32_t  hdr_len = gtpu_us_header_length (pkt, len);
+
+    w->stats.ul_rx_pkts++;
+    w->stats.ul_rx_bytes += len;
+    if (!hdr_len) {
+      w->stats.drop_malformed++;
+      continue;
+    }
+    if (GTPU_MSG_ECHO_REQUEST == pkt[1]) {
+      gtpu_us_send_echo_response (w, pkt, len, &w->ul_peers[i]);
+      continue;
+    }
+    if (GTPU_MSG_G_PDU != pkt[1]) {
+      w->stats.drop_malformed++;
+      continue;
+    }
+    uint32_t teid = 0;
+    memcpy (&teid, &pkt[4], sizeof (teid));
+    if (!gtpu_us_fht_get (&gtpu_us.teid_table, ntohl (teid))) {
+      w->stats.drop_no_tunnel++;
+      continue;
+    }
+    w->ul_offsets[num_fwd] = (uint32_t)(pkt - w->ul_bufs) + hdr_len;
+    w->ul_lengths[num_fwd] = GTPU_HEADER_MIN_SIZE + ((((uint32_t)pkt[2]) << 8) | pkt[3]) - hdr_len;
+    num_fwd++;
+  }
+  pthread_rwlock_unlock (&gtpu_us.lock);
+
+  // TUN has no batched write, one syscall per decapsulated packet
+  for (int i = 0; i < num_fwd; i++) {
+    if (write (w->tun_fd, &w->ul_bufs[w->ul_offsets[i]], w->ul_lengths[i]) < 0) {
+      w->stats.drop_io++;
+    } else {
+      w->stats.ul_tx_pkts++;
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    w->ul_msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline uint64_t gtpu_us_now_ms (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC_COARSE, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+//------------------------------------------------------------------------------
+static inline void gtpu_us_spin_lock (bool * const lock)
+{
+  while (__atomic_test_and_set (lock, __ATOMIC_ACQUIRE)) {
+    while (__atomic_load_n (lock, __ATOMIC_RELAXED));
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline void gtpu_us_spin_unlock (bool * const lock)
+{
+  __atomic_clear (lock, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+static inline gtpu_us_dl_pkt_t *gtpu_us_dl_pkt (const uint32_t ref)
+{
+  return (ref) ? &gtpu_us.dl_pool[ref - 1] : NULL;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_dl_pool_init (const uint32_t pool_size)
+{
+  gtpu_us.dl_pool_size     = 0;
+  gtpu_us.dl_pool_free     = 0;
+  gtpu_us.dl_pool_num_free = 0;
+  gtpu_us.dl_pool_lock     = false;
+  if (!pool_size) {
+    return RETURNok;
+  }
+  gtpu_us.dl_pool = calloc (pool_size, sizeof (gtpu_us_dl_pkt_t));
+  if (!gtpu_us.dl_pool) {
+    return RETURNerror;
+  }
+  for (uint32_t i = 0; i < pool_size; i++) {
+    gtpu_us.dl_pool[i].next = (i + 1 < pool_size) ? i + 2 : 0;
+  }
+  gtpu_us.dl_pool_size     = pool_size;
+  gtpu_us.dl_pool_free     = 1;
+  gtpu_us.dl_pool_num_free = pool_size;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t gtpu_us_dl_pool_get (void)
+{
+  uint32_t ref;
+
+  gtpu_us_spin_lock (&gtpu_us.dl_pool_lock);
+  ref = gtpu_us.dl_pool_free;
+  if (ref) {
+    gtpu_us.dl_pool_free = gtpu_us.dl_pool[ref - 1].next;
+    gtpu_us.dl_pool_num_free--;
+  }
+  gtpu_us_spin_unlock (&gtpu_us.dl_pool_lock);
+  return ref;
+}
+
+//------------------------------------------------------------------------------
+// Gives back a chain of count packets, from head to tail.
+static void gtpu_us_dl_pool_put (const uint32_t head, const uint32_t tail, const uint32_t count)
+{
+  if (!head) {
+    return;
+  }
+  gtpu_us_spin_lock (&gtpu_us.dl_pool_lock);
+  gtpu_us.dl_pool[tail - 1].next = gtpu_us.dl_pool_free;
+  gtpu_us.dl_pool_free = head;
+  gtpu_us.dl_pool_num_free += count;
+  gtpu_us_spin_unlock (&gtpu_us.dl_pool_lock);
+}
+
+//------------------------------------------------------------------------------
+// Called with the write lock held, or when the workers are stopped.
+static void gtpu_us_dl_buffer_free (gtpu_us_tunnel_t * const t)
+{
+  gtpu_us_dl_pool_put (t->dl_head, t->dl_tail, t->dl_count);
+  t->dl_head  = 0;
+  t->dl_tail  = 0;
+  t->dl_count = 0;
+}
+
+//------------------------------------------------------------------------------
+// Unchains the oldest buffered packet of the bearer, dl_buffer_lock held.
+static uint32_t gtpu_us_dl_buffer_pop (gtpu_us_tunnel_t * const t)
+{
+  const uint32_t ref = t->dl_head;
+
+  t->dl_head = gtpu_us.dl_pool[ref - 1].next;
+  if (!t->dl_head) {
+    t->dl_tail = 0;
+  }
+  t->dl_count--;
+  gtpu_us.dl_pool[ref - 1].next = 0;
+  return ref;
+}
+
+//------------------------------------------------------------------------------
+// Called by a worker with the read lock held. Expired packets are given back to
+// the pool, when the buffer of the bearer or the pool is full the oldest packet
+// of the bearer is reused, it is also the first one that would exceed the TTL.
+static void gtpu_us_dl_buffer_enqueue (gtpu_us_worker_t * const w, gtpu_us_tunnel_t * const t,
+    const uint8_t * const ip, const uint32_t len, const uint64_t now_ms)
+{
+  uint32_t expired_head = 0;
+  uint32_t expired_tail = 0;
+  uint32_t num_expired = 0;
+  uint32_t ref = 0;
+
+  gtpu_us_spin_lock (&t->dl_buffer_lock);
+  expired_head = t->dl_head;
+  while ((t->dl_count) && ((now_ms - gtpu_us_dl_pkt (t->dl_head)->arrival_ms) > gtpu_us.dl_buffer_ttl_ms)) {
+    expired_tail = t->dl_head;
+    t->dl_head = gtpu_us.dl_pool[expired_tail - 1].next;
+    t->dl_count--;
+    num_expired++;
+  }
+  if (!t->dl_head) {
+    t->dl_tail = 0;
+  }
+  if (num_expired) {
+    w->stats.drop_buffer_expired += num_expired;
+  }
+  if (t->dl_count < gtpu_us.dl_buffer_packets) {
+    if (num_expired) {
+      ref = expired_head;
+      expired_head = gtpu_us.dl_pool[ref - 1].next;
+      num_expired--;
+    } else {
+      ref = gtpu_us_dl_pool_get ();
+    }
+  }
+  if ((!ref) && (t->dl_count)) {
+    ref = gtpu_us_dl_buffer_pop (t);
+    w->stats.drop_buffer_full++;
+  }
+  if (ref) {
+    gtpu_us_dl_pkt_t * const pkt = &gtpu_us.dl_pool[ref - 1];
+    pkt->arrival_ms = now_ms;
+    pkt->length     = len;
+    pkt->next       = 0;
+    memcpy (&pkt->data[GTPU_HEADER_MIN_SIZE], ip, len);
+    if (t->dl_tail) {
+      gtpu_us.dl_pool[t->dl_tail - 1].next = ref;
+    } else {
+      t->dl_head = ref;
+    }
+    t->dl_tail = ref;
+    t->dl_count++;
+    w->stats.dl_buffered++;
+  } else {
+    w->stats.drop_buffer_full++;
+  }
+  gtpu_us_spin_unlock (&t->dl_buffer_lock);
+  if (num_expired) {
+    gtpu_us_dl_pool_put (expired_head, expired_tail, num_expired);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Sends a chain of buffered packets detached from its bearer on the flush socket
+// and gives them back to the pool. Runs on the S/P-GW task without the table lock.
+static void gtpu_us_dl_buffer_send (uint32_t head, const struct in_addr enb, const teid_t o_tei)
+{
+  struct mmsghdr      msgs[GTPU_US_FLUSH_CHUNK];
+  struct iovec        iovs[GTPU_US_FLUSH_CHUNK];
+  struct sockaddr_in  peer = {
+      .sin_family = AF_INET,
+      .sin_port = htons(GTPV1U_UDP_PORT),
+      .sin_addr = enb,
+  };
+  const uint32_t      o_tei_n = htonl (o_tei);
+  const uint64_t      now_ms = gtpu_us_now_ms ();
+
+  memset (msgs, 0, sizeof (msgs));
+  while (head) {
+    const uint32_t chunk_head = head;
+    uint32_t       chunk_tail = 0;
+    uint32_t       count = 0;
+    int            n = 0;
+
+    while ((head) && (count < GTPU_US_FLUSH_CHUNK)) {
+      gtpu_us_dl_pkt_t * const pkt = &gtpu_us.dl_pool[head - 1];
+      chunk_tail = head;
+      head = pkt->next;
+      count++;
+      if ((now_ms - pkt->arrival_ms) > gtpu_us.dl_buffer_ttl_ms) {
+        __atomic_add_fetch (&gtpu_us.flush_stats.drop_buffer_expired, 1, __ATOMIC_RELAXED);
+        continue;
+      }
+      uint8_t * const gtp = pkt->data;
+      gtp[0] = GTPU_FLAGS_V1_PT;
+      gtp[1] = GTPU_MSG_G_PDU;
+      gtp[2] = (uint8_t)(pkt->length >> 8);
+      gtp[3] = (uint8_t)(pkt->length);
+      memcpy (&gtp[4], &o_tei_n, sizeof (o_tei_n));
+      iovs[n].iov_base                = gtp;
+      iovs[n].iov_len                 = pkt->length + GTPU_HEADER_MIN_SIZE;
+      msgs[n].msg_hdr.msg_iov         = &iovs[n];
+      msgs[n].msg_hdr.msg_iovlen      = 1;
+      msgs[n].msg_hdr.msg_name        = &peer;
+      msgs[n].msg_hdr.msg_namelen     = sizeof (peer);
+      n++;
+    }
+    int sent = 0;
+    while (sent < n) {
+      const int rc = (gtpu_us.flush_fd >= 0) ? sendmmsg (gtpu_us.flush_fd, &msgs[sent], n - sent, 0) : -1;
+      if (rc <= 0) {
+        __atomic_add_fetch (&gtpu_us.flush_stats.drop_io, 1, __ATOMIC_RELAXED);
+        sent++;
+        continue;
+      }
+      __atomic_add_fetch (&gtpu_us.flush_stats.dl_flushed, rc, __ATOMIC_RELAXED);
+      sent += rc;
+    }
+    gtpu_us_dl_pool_put (chunk_head, chunk_tail, count);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Called by the S/P-GW task when the S1-U tunnel of a bearer with buffered packets
+// is re-installed, with the write lock held. The lock is released while sending:
+// dl_flushing keeps the workers buffering the newer packets of the bearer until
+// the buffer is empty, the order of the downlink packets is preserved.
+static void gtpu_us_dl_buffer_flush (gtpu_us_tunnel_t * t)
+{
+  const teid_t i_tei = t->i_tei;
+
+  t->dl_flushing = true;
+  while ((t) && (t->dl_count) && (INVALID_TEID != t->o_tei)) {
+    const uint32_t       head = t->dl_head;
+    const struct in_addr enb = t->enb;
+    const teid_t         o_tei = t->o_tei;
+
+    t->dl_head  = 0;
+    t->dl_tail  = 0;
+    t->dl_count = 0;
+    pthread_rwlock_unlock (&gtpu_us.lock);
+    gtpu_us_dl_buffer_send (head, enb, o_tei);
+    pthread_rwlock_wrlock (&gtpu_us.lock);
+    // the bearer may have been deleted meanwhile
+    t = gtpu_us_fht_get (&gtpu_us.teid_table, i_tei);
+  }
+  if (t) {
+    t->dl_flushing = false;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_downlink_batch (gtpu_us_worker_t * const w)
+{
+  int    n = 0;
+  int    num_tx = 0;
+  int    num_ddn = 0;
+  time_t now = 0;
+  uint64_t now_ms = 0;
+
+  while (n < gtpu_us.batch_size) {
+    const ssize_t r = read (w->tun_fd, &w->dl_bufs[n * GTPU_US_PKT_BUF_SIZE + GTPU_US_HEADROOM], GTPU_US_PKT_BUF_SIZE - GTPU_US_HEADROOM);
+    if (r <= 0) {
+      break;
+    }
+    w->dl_lengths[n++] = (uint32_t)r;
+  }
+  if (!n) {
+    return;
+  }
+
+  pthread_rwlock_rdlock (&gtpu_us.lock);
+  for (int i = 0; i < n; i++) {
+    uint8_t        *ip = &w->dl_bufs[i * GTPU_US_PKT_BUF_SIZE + GTPU_US_HEADROOM];
+    const uint32_t  len = w->dl_lengths[i];
+    uint32_t        dst = 0;
+
+    w->stats.dl_rx_pkts++;
+    w->stats.dl_rx_bytes += len;
+    if ((len < 20) || (4 != (ip[0] >> 4))) {
+      w->stats.drop_malformed++;
+      continue;
+    }
+    memcpy (&dst, &ip[16], sizeof (dst));
+    gtpu_us_tunnel_t *t = gtpu_us_fht_get (&gtpu_us.ue_table, dst);
+    if (!t) {
+      w->stats.drop_no_tunnel++;
+      continue;
+    }
+    if ((INVALID_TEID == t->o_tei) || (t->dl_flushing)) {
+      if (gtpu_us.dl_pool_size) {
+        if (!now_ms) now_ms = gtpu_us_now_ms ();
+        gtpu_us_dl_buffer_enqueue (w, t, ip, len, now_ms);
+      } else {
+        w->stats.drop_idle++;
+      }
+      if (t->dl_flushing) {
+        continue;
+      }
+      if (!now) now = time (NULL);
+      time_t clamp = __atomic_load_n (&t->ddn_clamp_until, __ATOMIC_RELAXED);
+      if ((now >= clamp) &&
+          __atomic_compare_exchange_n (&t->ddn_clamp_until, &clamp, now + PAGING_UNCONFIRMED_CLAMPING_TIMEOUT_SEC,
+              false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        w->ddn_ue[num_ddn]  = t->ue;
+        w->ddn_ebi[num_ddn] = t->ebi;
+        num_ddn++;
+      }
+      continue;
+    }
+    uint8_t *gtp = ip - GTPU_HEADER_MIN_SIZE;
+    const uint32_t o_tei = htonl (t->o_tei);
+    gtp[0] = GTPU_FLAGS_V1_PT;
+    gtp[1] = GTPU_MSG_G_PDU;
+    gtp[2] = (uint8_t)(len >> 8);
+    gtp[3] = (uint8_t)(len);
+    memcpy (&gtp[4], &o_tei, sizeof (o_tei));
+
+    w->dl_iovs[num_tx].iov_base          = gtp;
+    w->dl_iovs[num_tx].iov_len           = len + GTPU_HEADER_MIN_SIZE;
+    w->dl_peers[num_tx].sin_family       = AF_INET;
+    w->dl_peers[num_tx].sin_port         = htons (GTPV1U_UDP_PORT);
+    w->dl_peers[num_tx].sin_addr         = t->enb;
+    num_tx++;
+  }
+  pthread_rwlock_unlock (&gtpu_us.lock);
+
+  int sent = 0;
+  while (sent < num_tx) {
+    const int rc = sendmmsg (w->udp_fd, &w->dl_msgs[sent], num_tx - sent, 0);
+    if (rc <= 0) {
+      // skip the datagram that failed and keep going with the rest of the batch
+      w->stats.drop_io++;
+      sent++;
+      continue;
+    }
+    w->stats.dl_tx_pkts += rc;
+    sent += rc;
+  }
+
+  for (int i = 0; i < num_ddn; i++) {
+    w->stats.dl_data_notifications++;
+    sgw_notify_downlink_data (w->ddn_ue[i], w->ddn_ebi[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void *gtpu_us_worker_thread (void *args)
+{
+  gtpu_us_worker_t * const w = (gtpu_us_worker_t *)args;
+  const long num_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+  char       thread_name[16];
+
+  if (num_cpus > 0) {
+    cpu_set_t cpuset;
+    CPU_ZERO (&cpuset);
+    CPU_SET (w->id % num_cpus, &cpuset);
+    pthread_setaffinity_np (pthread_self (), sizeof (cpuset), &cpuset);
+  }
+  snprintf (thread_name, sizeof (thread_name), "gtpu_us_%d", w->id);
+  pthread_setname_np (pthread_self (), thread_name);
+
+  struct pollfd pfds[2] = {
+      {.fd = w->udp_fd, .events = POLLIN},
+      {.fd = w->tun_fd, .events = POLLIN},
+  };
+
+  while (gtpu_us.running) {
+    const int rc = poll (pfds, 2, GTPU_US_POLL_TIMEOUT_MS);
+    if (rc <= 0) {
+      continue;
+    }
+    if (pfds[0].revents & POLLIN) {
+      gtpu_us_uplink_batch (w);
+    }
+    if (pfds[1].revents & POLLIN) {
+      gtpu_us_downlink_batch (w);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_tables_init (const uint32_t max_tunnels)
+{
+  pthread_rwlockattr_t attr;
+
+  pthread_rwlockattr_init (&attr);
+  // workers take the read lock once per batch, do not starve tunnel updates
+  pthread_rwlockattr_setkind_np (&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+  pthread_rwlock_init (&gtpu_us.lock, &attr);
+  pthread_rwlockattr_destroy (&attr);
+
+  gtpu_us.max_tunnels = max_tunnels;
+  gtpu_us.tunnels     = calloc (max_tunnels, sizeof (gtpu_us_tunnel_t));
+  gtpu_us.free_slots  = calloc (max_tunnels, sizeof (uint32_t));
+  if ((!gtpu_us.tunnels) || (!gtpu_us.free_slots)) {
+    return RETURNerror;
+  }
+  for (uint32_t i = 0; i < max_tunnels; i++) {
+    gtpu_us.free_slots[i] = max_tunnels - 1 - i;
+  }
+  gtpu_us.num_free_slots = max_tunnels;
+  if ((RETURNok != gtpu_us_fht_init (&gtpu_us.teid_table, max_tunnels)) ||
+      (RETURNok != gtpu_us_fht_init (&gtpu_us.ue_table, max_tunnels))) {
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_tables_free (void)
+{
+  gtpu_us_fht_free (&gtpu_us.teid_table);
+  gtpu_us_fht_free (&gtpu_us.ue_table);
+  free_wrapper ((void**)&gtpu_us.tunnels);
+  free_wrapper ((void**)&gtpu_us.free_slots);
+  gtpu_us.num_free_slots = 0;
+  free_wrapper ((void**)&gtpu_us.dl_pool);
+  gtpu_us.dl_pool_size = 0;
+  pthread_rwlock_destroy (&gtpu_us.lock);
+}
+
+//------------------------------------------------------------------------------
+// Sets the MTU and the address of the TUN device and brings it up with netdevice
+// ioctls, no shell command is run.
+static int gtpu_us_tun_configure (const char * const name, const int mtu, const struct in_addr addr, const struct in_addr netmask)
+{
+  struct ifreq        ifr = {0};
+  struct sockaddr_in *sin = (struct sockaddr_in *)&ifr.ifr_addr;
+  int                 rc = RETURNerror;
+  int                 fd = socket (AF_INET, SOCK_DGRAM, 0);
+
+  if (fd < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot create socket to configure TUN device %s: %s\n", name, strerror (errno));
+    return RETURNerror;
+  }
+  strncpy (ifr.ifr_name, name, IFNAMSIZ - 1);
+  ifr.ifr_mtu = mtu;
+  if (ioctl (fd, SIOCSIFMTU, &ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot set MTU %d on TUN device %s: %s\n", mtu, name, strerror (errno));
+    goto end;
+  }
+  memset (&ifr.ifr_ifru, 0, sizeof (ifr.ifr_ifru));
+  sin->sin_family = AF_INET;
+  sin->sin_addr   = addr;
+  if (ioctl (fd, SIOCSIFADDR, &ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot set address on TUN device %s: %s\n", name, strerror (errno));
+    goto end;
+  }
+  sin->sin_addr   = netmask;
+  if (ioctl (fd, SIOCSIFNETMASK, &ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot set netmask on TUN device %s: %s\n", name, strerror (errno));
+    goto end;
+  }
+  memset (&ifr.ifr_ifru, 0, sizeof (ifr.ifr_ifru));
+  if (ioctl (fd, SIOCGIFFLAGS, &ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot get flags of TUN device %s: %s\n", name, strerror (errno));
+    goto end;
+  }
+  ifr.ifr_flags |= IFF_UP | IFF_RUNNING;
+  if (ioctl (fd, SIOCSIFFLAGS, &ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot bring TUN device %s up: %s\n", name, strerror (errno));
+    goto end;
+  }
+  rc = RETURNok;
+end:
+  close (fd);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_init (struct in_addr *ue_net, struct in_addr *ue_netmask, int mtu, int *fd0, int *fd1u)
+{
+  const spgw_gtpu_userspace_config_t * const config = &spgw_config.pgw_config.gtpu_userspace_config;
+
+  gtpu_us.tun_name    = (config->tun_name) ? bstrcpy (config->tun_name) : bfromcstr (GTPU_USERSPACE_DEVNAME_DEFAULT);
+  gtpu_us.num_workers = (config->num_workers > 0) ? config->num_workers : 1;
+  gtpu_us.batch_size  = (config->batch_size > 0) ? config->batch_size : 32;
+  gtpu_us.s1u_addr    = spgw_config.sgw_config.ipv4.S1u_S12_S4_up;
+  gtpu_us.dl_buffer_packets = config->dl_buffer_packets;
+  gtpu_us.dl_buffer_ttl_ms  = config->dl_buffer_ttl_ms;
+  gtpu_us.flush_fd    = -1;
+  if (gtpu_us.dl_buffer_packets > GTPU_USERSPACE_DL_BUFFER_PACKETS_MAX) gtpu_us.dl_buffer_packets = GTPU_USERSPACE_DL_BUFFER_PACKETS_MAX;
+  if (gtpu_us.num_workers > GTPU_USERSPACE_WORKERS_MAX) gtpu_us.num_workers = GTPU_USERSPACE_WORKERS_MAX;
+  if (gtpu_us.batch_size > GTPU_USERSPACE_BATCH_SIZE_MAX) gtpu_us.batch_size = GTPU_USERSPACE_BATCH_SIZE_MAX;
+
+  if (RETURNok != gtpu_us_tables_init ((config->max_tunnels) ? config->max_tunnels : GTPU_USERSPACE_MAX_TUNNELS_DEFAULT)) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot allocate GTP-U userspace tunnel tables\n");
+    gtpu_us_tables_free ();
+    return RETURNerror;
+  }
+  if (RETURNok != gtpu_us_dl_pool_init ((gtpu_us.dl_buffer_packets) ? config->dl_buffer_pool_packets : 0)) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot allocate GTP-U userspace DL buffer pool of %u packets\n", config->dl_buffer_pool_packets);
+    gtpu_us_tables_free ();
+    return RETURNerror;
+  }
+  if ((gtpu_us.dl_pool_size) && ((gtpu_us.flush_fd = gtpu_us_flush_open (gtpu_us.s1u_addr)) < 0)) {
+    gtpu_us_tables_free ();
+    return RETURNerror;
+  }
+
+  for (int i = 0; i < gtpu_us.num_workers; i++) {
+    gtpu_us_worker_t * const w = &gtpu_us.workers[i];
+    w->id     = i;
+    w->tun_fd = gtpu_us_tun_open (bdata(gtpu_us.tun_name));
+    w->udp_fd = gtpu_us_udp_open (gtpu_us.s1u_addr);
+    if ((w->tun_fd < 0) || (w->udp_fd < 0) || (RETURNok != gtpu_us_worker_alloc (w, gtpu_us.batch_size))) {
+      gtpu_us.num_workers = i + 1;
+      gtpu_us_uninit ();
+      return RETURNerror;
+    }
+  }
+  gtpu_us.is_enabled = true;
+
+  if (RETURNok != gtpu_us_tun_configure (bdata(gtpu_us.tun_name), mtu, (struct in_addr){.s_addr = ue_net->s_addr | htonl(1)}, *ue_netmask)) {
+    gtpu_us_uninit ();
+    return RETURNerror;
+  }
+
+  gtpu_us.running = true;
+  for (int i = 0; i < gtpu_us.num_workers; i++) {
+    if (pthread_create (&gtpu_us.workers[i].thread, NULL, gtpu_us_worker_thread, &gtpu_us.workers[i])) {
+      OAILOG_ERROR (LOG_GTPV1U, "Cannot create GTP-U userspace worker %d: %s\n", i, strerror (errno));
+      gtpu_us.num_workers = i;
+      gtpu_us_uninit ();
+      return RETURNerror;
+    }
+  }
+
+  // no GTPv0, S1-U socket of the first worker for bookkeeping only
+  *fd0  = -1;
+  *fd1u = gtpu_us.workers[0].udp_fd;
+  OAILOG_NOTICE (LOG_GTPV1U, "GTP-U userspace engine configured: device %s, %d workers, batch %d, %u tunnels max, DL buffer %u packets %u ms, pool %u packets\n",
+      bdata(gtpu_us.tun_name), gtpu_us.num_workers, gtpu_us.batch_size, gtpu_us.max_tunnels,
+      gtpu_us.dl_buffer_packets, gtpu_us.dl_buffer_ttl_ms, gtpu_us.dl_pool_size);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_uninit (void)
+{
+  if (gtpu_us.running) {
+    gtpu_us.running = false;
+    for (int i = 0; i < gtpu_us.num_workers; i++) {
+      pthread_join (gtpu_us.workers[i].thread, NULL);
+    }
+    gtpu_userspace_display_stats ();
+  }
+  for (int i = 0; i < gtpu_us.num_workers; i++) {
+    gtpu_us_worker_free (&gtpu_us.workers[i]);
+  }
+  gtpu_us.num_workers = 0;
+  if (gtpu_us.flush_fd >= 0) close (gtpu_us.flush_fd);
+  gtpu_us.flush_fd = -1;
+  if (gtpu_us.tunnels) {
+    gtpu_us_tables_free ();
+  }
+  bdestroy_wrapper (&gtpu_us.tun_name);
+  gtpu_us.is_enabled = false;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_reset (void)
+{
+  // TUN queues are not persistent, nothing survives a restart of the process
+  if (gtpu_us.is_enabled) {
+    pthread_rwlock_wrlock (&gtpu_us.lock);
+    gtpu_us_fht_clear (&gtpu_us.teid_table);
+    gtpu_us_fht_clear (&gtpu_us.ue_table);
+    for (uint32_t i = 0; i < gtpu_us.max_tunnels; i++) {
+      gtpu_us_dl_buffer_free (&gtpu_us.tunnels[i]);
+    }
+    memset (gtpu_us.tunnels, 0, gtpu_us.max_tunnels * sizeof (gtpu_us_tunnel_t));
+    for (uint32_t i = 0; i < gtpu_us.max_tunnels; i++) {
+      gtpu_us.free_slots[i] = gtpu_us.max_tunnels - 1 - i;
+    }
+    gtpu_us.num_free_slots = gtpu_us.max_tunnels;
+    pthread_rwlock_unlock (&gtpu_us.lock);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static inline gtpu_us_tunnel_t *gtpu_us_next_ue_tunnel (const gtpu_us_tunnel_t * const t)
+{
+  return (t->next_ue_tunnel) ? &gtpu_us.tunnels[t->next_ue_tunnel - 1] : NULL;
+}
+
+//------------------------------------------------------------------------------
+// Chains the bearer in the bearers of its UE, in EBI order (write lock held).
+static int gtpu_us_ue_link (gtpu_us_tunnel_t * const t)
+{
+  const uint32_t    index = (uint32_t)(t - gtpu_us.tunnels);
+  gtpu_us_tunnel_t *prev = gtpu_us_fht_get (&gtpu_us.ue_table, t->ue.s_addr);
+
+  if ((!prev) || (t->ebi < prev->ebi)) {
+    t->next_ue_tunnel = (prev) ? (uint32_t)(prev - gtpu_us.tunnels) + 1 : 0;
+    return gtpu_us_fht_insert (&gtpu_us.ue_table, t->ue.s_addr, index);
+  }
+  while ((prev->next_ue_tunnel) && (gtpu_us_next_ue_tunnel (prev)->ebi < t->ebi)) {
+    prev = gtpu_us_next_ue_tunnel (prev);
+  }
+  t->next_ue_tunnel = prev->next_ue_tunnel;
+  prev->next_ue_tunnel = index + 1;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+// Removes the bearer from the bearers of its UE (write lock held). When it was the
+// first one, the next bearer of the UE takes over the downlink traffic.
+static void gtpu_us_ue_unlink (gtpu_us_tunnel_t * const t)
+{
+  const uint32_t    index = (uint32_t)(t - gtpu_us.tunnels);
+  gtpu_us_tunnel_t *prev = gtpu_us_fht_get (&gtpu_us.ue_table, t->ue.s_addr);
+
+  if (prev == t) {
+    if (t->next_ue_tunnel) {
+      gtpu_us_fht_insert (&gtpu_us.ue_table, t->ue.s_addr, t->next_ue_tunnel - 1);
+    } else {
+      gtpu_us_fht_remove (&gtpu_us.ue_table, t->ue.s_addr, index);
+      gtpu_us_fht_purge_deleted (&gtpu_us.ue_table);
+    }
+  } else {
+    while ((prev) && (prev->next_ue_tunnel != (index + 1))) {
+      prev = gtpu_us_next_ue_tunnel (prev);
+    }
+    if (prev) {
+      prev->next_ue_tunnel = t->next_ue_tunnel;
+    }
+  }
+  t->next_ue_tunnel = 0;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_add_tunnel (struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei, ebi_t ebi)
+{
+  int  rc = RETURNok;
+  bool link_ue = true;
+
+  if (!gtpu_us.is_enabled)
+    return RETURNok;
+
+  pthread_rwlock_wrlock (&gtpu_us.lock);
+  gtpu_us_tunnel_t *t = gtpu_us_fht_get (&gtpu_us.teid_table, i_tei);
+  if (!t) {
+    if (!gtpu_us.num_free_slots) {
+      pthread_rwlock_unlock (&gtpu_us.lock);
+      OAILOG_ERROR (LOG_GTPV1U, "No more GTP-U userspace tunnel available (max %u)\n", gtpu_us.max_tunnels);
+      return RETURNerror;
+    }
+    const uint32_t index = gtpu_us.free_slots[--gtpu_us.num_free_slots];
+    t = &gtpu_us.tunnels[index];
+    memset (t, 0, sizeof (*t));
+    if (RETURNok != gtpu_us_fht_insert (&gtpu_us.teid_table, i_tei, index)) {
+      gtpu_us.free_slots[gtpu_us.num_free_slots++] = index;
+      pthread_rwlock_unlock (&gtpu_us.lock);
+      OAILOG_ERROR (LOG_GTPV1U, "Cannot insert GTP-U userspace tunnel " TEID_FMT "\n", i_tei);
+      return RETURNerror;
+    }
+    t->in_use = true;
+    t->i_tei  = i_tei;
+  } else if ((t->ue.s_addr != ue.s_addr) || (t->ebi != ebi)) {
+    gtpu_us_ue_unlink (t);
+  } else {
+    link_ue = false;
+  }
+  t->ue  = ue;
+  t->enb = enb;
+  t->ebi = ebi;
+  t->o_tei = o_tei;
+  t->ddn_clamp_until = 0;
+  if (link_ue) {
+    rc = gtpu_us_ue_link (t);
+  }
+  if ((t->dl_count) && (!t->dl_flushing) && (INVALID_TEID != o_tei)) {
+    // Modify Bearer Request after a service request or paging
+    gtpu_us_dl_buffer_flush (t);
+  }
+  pthread_rwlock_unlock (&gtpu_us.lock);
+
+  OAILOG_DEBUG (LOG_GTPV1U, "Add tunnel UE " IN_ADDR_FMT " eNB " IN_ADDR_FMT " i_tei " TEID_FMT " o_tei " TEID_FMT " ebi %u\n",
+      PRI_IN_ADDR(ue), PRI_IN_ADDR(enb), i_tei, o_tei, ebi);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_del_tunnel (struct in_addr ue, uint32_t i_tei, uint32_t o_tei)
+{
+  if (!gtpu_us.is_enabled)
+    return RETURNok;
+
+  pthread_rwlock_wrlock (&gtpu_us.lock);
+  if (INVALID_TEID == i_tei) {
+    // Release access bearers: keep the UE known for downlink data notification
+    gtpu_us_tunnel_t *t = gtpu_us_fht_get (&gtpu_us.ue_table, ue.s_addr);
+    while ((t) && (t->o_tei != o_tei)) {
+      t = gtpu_us_next_ue_tunnel (t);
+    }
+    if (t) {
+      t->o_tei = INVALID_TEID;
+      t->enb.s_addr = INADDR_ANY;
+      t->ddn_clamp_until = 0;
+    }
+  } else {
+    gtpu_us_tunnel_t *t = gtpu_us_fht_get (&gtpu_us.teid_table, i_tei);
+    if (t) {
+      const uint32_t index = (uint32_t)(t - gtpu_us.tunnels);
+      gtpu_us_fht_remove (&gtpu_us.teid_table, i_tei, index);
+      gtpu_us_fht_purge_deleted (&gtpu_us.teid_table);
+      gtpu_us_ue_unlink (t);
+      gtpu_us_dl_buffer_free (t);
+      t->in_use = false;
+      t->dl_flushing = false;
+      gtpu_us.free_slots[gtpu_us.num_free_slots++] = index;
+    }
+  }
+  pthread_rwlock_unlock (&gtpu_us.lock);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int gtpu_userspace_stop_dl_data_notification_ue (struct in_addr ue, uint16_t timeout)
+{
+  if (!gtpu_us.is_enabled)
+    return RETURNok;
+
+  pthread_rwlock_rdlock (&gtpu_us.lock);
+  gtpu_us_tunnel_t *t = gtpu_us_fht_get (&gtpu_us.ue_table, ue.s_addr);
+  if (t) {
+    __atomic_store_n (&t->ddn_clamp_until, time (NULL) + timeout, __ATOMIC_RELAXED);
+  }
+  pthread_rwlock_unlock (&gtpu_us.lock);
+  return (t) ? RETURNok:RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+void gtpu_userspace_get_stats (gtpu_userspace_stats_t * const stats)
+{
+  memset (stats, 0, sizeof (*stats));
+  for (int i = 0; i < gtpu_us.num_workers; i++) {
+    const gtpu_userspace_stats_t * const ws = &gtpu_us.workers[i].stats;
+    stats->ul_rx_pkts            += ws->ul_rx_pkts;
+    stats->ul_rx_bytes           += ws->ul_rx_bytes;
+    stats->ul_tx_pkts            += ws->ul_tx_pkts;
+    stats->dl_rx_pkts            += ws->dl_rx_pkts;
+    stats->dl_rx_bytes           += ws->dl_rx_bytes;
+    stats->dl_tx_pkts            += ws->dl_tx_pkts;
+    stats->drop_malformed        += ws->drop_malformed;
+    stats->drop_no_tunnel        += ws->drop_no_tunnel;
+    stats->drop_idle             += ws->drop_idle;
+    stats->drop_io               += ws->drop_io;
+    stats->echo_responses        += ws->echo_responses;
+    stats->dl_data_notifications += ws->dl_data_notifications;
+    stats->dl_buffered           += ws->dl_buffered;
+    stats->drop_buffer_full      += ws->drop_buffer_full;
+    stats->drop_buffer_expired   += ws->drop_buffer_expired;
+  }
+  stats->dl_flushed            += gtpu_us.flush_stats.dl_flushed;
+  stats->drop_buffer_expired   += gtpu_us.flush_stats.drop_buffer_expired;
+  stats->drop_io               += gtpu_us.flush_stats.drop_io;
+}
+
+//------------------------------------------------------------------------------
+void gtpu_userspace_display_stats (void)
+{
+  gtpu_userspace_stats_t stats;
+
+  gtpu_userspace_get_stats (&stats);
+  OAILOG_INFO (LOG_GTPV1U, "GTP-U userspace engine statistics (%d workers):\n", gtpu_us.num_workers);
+  OAILOG_INFO (LOG_GTPV1U, "    UL rx ...............: %" PRIu64 " pkts %" PRIu64 " bytes\n", stats.ul_rx_pkts, stats.ul_rx_bytes);
+  OAILOG_INFO (LOG_GTPV1U, "    UL tx ...............: %" PRIu64 " pkts\n", stats.ul_tx_pkts);
+  OAILOG_INFO (LOG_GTPV1U, "    DL rx ...............: %" PRIu64 " pkts %" PRIu64 " bytes\n", stats.dl_rx_pkts, stats.dl_rx_bytes);
+  OAILOG_INFO (LOG_GTPV1U, "    DL tx ...............: %" PRIu64 " pkts\n", stats.dl_tx_pkts);
+  OAILOG_INFO (LOG_GTPV1U, "    dropped malformed ...: %" PRIu64 "\n", stats.drop_malformed);
+  OAILOG_INFO (LOG_GTPV1U, "    dropped no tunnel ...: %" PRIu64 "\n", stats.drop_no_tunnel);
+  OAILOG_INFO (LOG_GTPV1U, "    dropped UE idle .....: %" PRIu64 "\n", stats.drop_idle);
+  OAILOG_INFO (LOG_GTPV1U, "    DL buffered .........: %" PRIu64 " flushed %" PRIu64 "\n", stats.dl_buffered, stats.dl_flushed);
+  OAILOG_INFO (LOG_GTPV1U, "    dropped buffer full .: %" PRIu64 " expired %" PRIu64 "\n", stats.drop_buffer_full, stats.drop_buffer_expired);
+  OAILOG_INFO (LOG_GTPV1U, "    dropped I/O .........: %" PRIu64 "\n", stats.drop_io);
+  OAILOG_INFO (LOG_GTPV1U, "    echo responses ......: %" PRIu64 "\n", stats.echo_responses);
+  OAILOG_INFO (LOG_GTPV1U, "    DL data notif. ......: %" PRIu64 "\n", stats.dl_data_notifications);
+}
+
+static const struct gtp_tunnel_ops gtpu_userspace_ops = {
+  .init         = gtpu_us_init,
+  .uninit       = gtpu_us_uninit,
+  .reset        = gtpu_us_reset,
+  .add_tunnel   = gtpu_us_add_tunnel,
+  .del_tunnel   = gtpu_us_del_tunnel,
+};
+
+const struct gtp_tunnel_ops *gtp_tunnel_ops_init(void) {
+  OAILOG_DEBUG (LOG_GTPV1U , "Initializing gtp_tunnel_ops_userspace\n");
+  return &gtpu_userspace_ops;
+}
+
+#ifdef __cplusplus
+}
+#endif
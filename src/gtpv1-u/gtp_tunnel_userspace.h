@@ -0,0 +1,80 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtp_tunnel_userspace.h
+* \brief Userspace GTP-U forwarding engine (TUN device + UDP sockets).
+*/
+
+#ifndef FILE_GTP_TUNNEL_USERSPACE_SEEN
+#define FILE_GTP_TUNNEL_USERSPACE_SEEN
+
+#include <stdint.h>
+#include <netinet/in.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GTPU_USERSPACE_DEVNAME_DEFAULT    "gtpu0"
+#define GTPU_USERSPACE_WORKERS_MAX        64
+#define GTPU_USERSPACE_BATCH_SIZE_MAX     256
+#define GTPU_USERSPACE_MAX_TUNNELS_DEFAULT 65536
+#define GTPU_USERSPACE_DL_BUFFER_PACKETS_MAX 1024
+
+typedef struct gtpu_userspace_stats_s {
+  uint64_t ul_rx_pkts;        ///< GTP-U datagrams received on S1-U
+  uint64_t ul_rx_bytes;
+  uint64_t ul_tx_pkts;        ///< decapsulated packets written to the TUN device
+  uint64_t dl_rx_pkts;        ///< IP packets read from the TUN device
+  uint64_t dl_rx_bytes;
+  uint64_t dl_tx_pkts;        ///< encapsulated packets sent to eNBs
+  uint64_t drop_malformed;
+  uint64_t drop_no_tunnel;
+  uint64_t drop_idle;         ///< downlink packets for UEs in ECM-IDLE, buffering disabled
+  uint64_t drop_buffer_full;  ///< oldest buffered packets pushed out of a full buffer
+  uint64_t drop_buffer_expired; ///< buffered packets older than the buffer TTL
+  uint64_t drop_io;           ///< failed TUN writes or UDP sends
+  uint64_t echo_responses;
+  uint64_t dl_data_notifications;
+  uint64_t dl_buffered;       ///< downlink packets buffered for UEs in ECM-IDLE
+  uint64_t dl_flushed;        ///< buffered packets sent when the UE came back to ECM-CONNECTED
+} gtpu_userspace_stats_t;
+
+/*
+ * Called by the S-GW when the MME acknowledged (or rejected) a downlink data
+ * notification: no new notification will be raised for this UE before timeout
+ * seconds elapsed. Same semantic as openflow_controller_stop_dl_data_notification_ue().
+ */
+int gtpu_userspace_stop_dl_data_notification_ue(struct in_addr ue, uint16_t timeout);
+
+/*
+ * Sum the per-worker counters into stats, counters are read without locking and
+ * may be slightly behind the workers.
+ */
+void gtpu_userspace_get_stats(gtpu_userspace_stats_t * const stats);
+
+void gtpu_userspace_display_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILE_GTP_TUNNEL_USERSPACE_SEEN */
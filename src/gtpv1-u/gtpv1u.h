@@ -31,6 +31,7 @@
 #include <arpa/inet.h>
 #include <net/if.h>
 #include "3gpp_23.003.h"
+#include "3gpp_24.007.h"
 
 #if ENABLE_OPENFLOW || ENABLE_OPENFLOW_MOSAIC
 #include "pgw_pcef_emulation.h"
@@ -76,6 +77,9 @@ extern "C" {
  *         @ue: UE IP address
  *         @i_tei: RX GTP Tunnel ID
  *         @o_tei: TX GTP Tunnel ID.
+ *     With the userspace engine, an INVALID_TEID i_tei only releases the eNB
+ *     side of the tunnel (UE in ECM-IDLE), downlink packets then raise a
+ *     downlink data notification.
  */
 struct gtp_tunnel_ops {
   int  (*init)(struct in_addr *ue_net, struct in_addr *ue_netmask, int mtu, int *fd0, int *fd1u);
@@ -93,6 +97,10 @@ struct gtp_tunnel_ops {
   int  (*add_tunnel)(struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei, imsi_t imsi);
   int  (*del_tunnel)(struct in_addr ue, uint32_t i_tei, uint32_t o_tei);
 #endif
+#if ENABLE_USERSPACE_GTPU
+  int  (*add_tunnel)(struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei, ebi_t ebi);
+  int  (*del_tunnel)(struct in_addr ue, uint32_t i_tei, uint32_t o_tei);
+#endif
 };
 
 uint32_t gtpv1u_new_teid(void);
@@ -45,6 +45,7 @@
 #include "mme_config.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 #include "mme_app_apn_selection.h"
 #include "mme_app_pdn_context.h"
 #include "mme_app_wrr_selection.h"
@@ -599,6 +600,7 @@ mme_app_handle_initial_ue_message (
   }
   ue_context->sctp_assoc_id_key = initial_pP->sctp_assoc_id;
   ue_context->e_utran_cgi = initial_pP->ecgi;
+  mme_stats_mark (ue_context->mme_ue_s1ap_id, INITIAL_UE_MESSAGE);
   // Notify S1AP about the mapping between mme_ue_s1ap_id and sctp assoc id + enb_ue_s1ap_id
   notify_s1ap_new_ue_mme_s1ap_id_association (ue_context->sctp_assoc_id_key, ue_context->enb_ue_s1ap_id, ue_context->mme_ue_s1ap_id);
   // Initialize timers to INVALID IDs
@@ -912,6 +914,7 @@ mme_app_handle_delete_session_rsp (
   }
   MSC_LOG_RX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 DELETE_SESSION_RESPONSE local S11 teid " TEID_FMT " IMSI " IMSI_64_FMT " ",
     delete_sess_resp_pP->teid, ue_context->emm_context._imsi64);
+  mme_stats_latency (ue_context->mme_ue_s1ap_id, S11_DELETE_SESSION);
   /*
    * Updating statistics
    */
@@ -991,6 +994,7 @@ mme_app_handle_create_sess_resp (
   mme_ue_s1ap_id = ue_context->mme_ue_s1ap_id;
   /** S10 Procedure. */
   s10_handover_procedure = mme_app_get_s10_procedure_mme_handover(ue_context);
+  mme_stats_latency (mme_ue_s1ap_id, S11_CREATE_SESSION);
   /** Idle TAU procedure. */
   emm_data_context_t * emm_context = emm_data_context_get(&_emm_data, mme_ue_s1ap_id);
   nas_ctx_req_proc_t *emm_cn_proc_ctx_req = NULL;
@@ -1127,6 +1131,8 @@ mme_app_handle_modify_bearer_resp (
   }
   MSC_LOG_RX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " IMSI " IMSI_64_FMT " ",
       modify_bearer_resp_pP->teid, ue_context->imsi);
+  mme_stats_latency (ue_context->mme_ue_s1ap_id, S11_MODIFY_BEARER);
+  mme_stats_latency (ue_context->mme_ue_s1ap_id, SERVICE_REQUEST);
   /*
    * Updating statistics
    */
@@ -1358,6 +1364,7 @@ mme_app_handle_downlink_data_notification(const itti_s11_downlink_data_notificat
   s1ap_paging_p->tmsi = ue_context->guti.m_tmsi;
   OAILOG_INFO(LOG_MME_APP, "Calculated ue_identity index value for UE with imsi " IMSI_64_FMT " and ueId " MME_UE_S1AP_ID_FMT" is %d. \n", ue_context->imsi, ue_context->mme_ue_s1ap_id, s1ap_paging_p->ue_identity_index);
 
+  mme_stats_inc (PAGING);
   /** S1AP Paging. */
   itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
 
@@ -1463,6 +1470,10 @@ mme_app_handle_release_access_bearers_resp (
     OAILOG_FUNC_OUT (LOG_MME_APP);
   }
   MSC_LOG_RX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 RELEASE_ACCESS_BEARERS_RESPONSE local S11 teid " TEID_FMT " IMSI " IMSI_64_FMT " ", rel_access_bearers_rsp_pP->teid, ue_context->emm_context._imsi64);
+  if ((ue_context->ecm_state == ECM_IDLE) && (ue_context->s1_bulk_released)) {
+    /** Sent by the bulk release of a reset or lost eNB, the S1 connection is already released. */
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
 
   S1ap_Cause_t            s1_ue_context_release_cause = {0};
   s1_ue_context_release_cause.present = S1ap_Cause_PR_radioNetwork;
@@ -124,10 +124,50 @@ bearer_context_t* mme_app_get_session_bearer_context(pdn_context_t * const pdn_c
 }
 
 //------------------------------------------------------------------------------
-void mme_app_get_free_bearer_context(ue_context_t * const ue_context, const ebi_t ebi, bearer_context_t ** bc_pp)
+ebi_t mme_app_get_free_bearer_ebi(const ue_context_t * const ue_context, const ebi_t ebi)
 {
-  bearer_context_t    bc_key = {.ebi = ebi};
-  (*bc_pp) = RB_FIND(BearerPool, &ue_context->bearer_pool, &bc_key);
+  if (EPS_BEARER_IDENTITY_UNASSIGNED != ebi) {
+    if ((EPS_BEARER_IDENTITY_FIRST <= ebi) && (EPS_BEARER_IDENTITY_LAST >= ebi) && (!ue_context->bearer_contexts[ebi - EPS_BEARER_IDENTITY_FIRST])) {
+      return ebi;
+    }
+    return EPS_BEARER_IDENTITY_UNASSIGNED;
+  }
+  for (ebi_t free_ebi = EPS_BEARER_IDENTITY_FIRST; free_ebi <= EPS_BEARER_IDENTITY_LAST; free_ebi++) {
+    if (!ue_context->bearer_contexts[free_ebi - EPS_BEARER_IDENTITY_FIRST]) {
+      return free_ebi;
+    }
+  }
+  return EPS_BEARER_IDENTITY_UNASSIGNED;
+}
+
+//------------------------------------------------------------------------------
+bearer_context_t *mme_app_new_ue_bearer_context(ue_context_t * const ue_context, const ebi_t ebi)
+{
+  const ebi_t          free_ebi = mme_app_get_free_bearer_ebi(ue_context, ebi);
+  bearer_context_t    *bearer_context = NULL;
+
+  if (EPS_BEARER_IDENTITY_UNASSIGNED == free_ebi) {
+    return NULL;
+  }
+  bearer_context = mme_app_new_bearer();
+  DevAssert(bearer_context);
+  bearer_context->ebi = free_ebi;
+  ue_context->bearer_contexts[free_ebi - EPS_BEARER_IDENTITY_FIRST] = bearer_context;
+  return bearer_context;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_release_ue_bearer_context(ue_context_t * const ue_context, bearer_context_t ** const bearer_context)
+{
+  const ebi_t          ebi = (*bearer_context)->ebi;
+
+  AssertFatal((EPS_BEARER_IDENTITY_LAST >= ebi) && (EPS_BEARER_IDENTITY_FIRST <= ebi), "Bad ebi %u", ebi);
+  DevAssert(ue_context->bearer_contexts[ebi - EPS_BEARER_IDENTITY_FIRST] == *bearer_context);
+  ue_context->bearer_contexts[ebi - EPS_BEARER_IDENTITY_FIRST] = NULL;
+  /** Free the TFT before putting the bearer context back into the free list. */
+  mme_app_bearer_context_initialize(*bearer_context);
+  mme_app_free_bearer_context(bearer_context);
+  *bearer_context = NULL;
 }
 
 //------------------------------------------------------------------------------
@@ -174,13 +214,8 @@ mme_app_register_dedicated_bearer_context(const mme_ue_s1ap_id_t ue_id, const es
     OAILOG_FUNC_RETURN (LOG_MME_APP, ESM_CAUSE_REQUEST_REJECTED_BY_GW);
     /** This should be enough, we don't need to additionally check for the states. */
   }
-  /** Removed a bearer context from the UE contexts bearer pool and adds it into the PDN sessions bearer pool. */
-  if(ded_ebi == EPS_BEARER_IDENTITY_UNASSIGNED)
-	  pBearerCtx = RB_MIN(BearerPool, &ue_context->bearer_pool);
-  else {
-	  mme_app_get_free_bearer_context(ue_context, ded_ebi, &pBearerCtx);
-  }
-  if(!pBearerCtx){
+  /** Check that an EBI is free (the requested one, else the lowest one), its bearer context is allocated once the request is verified. */
+  if(EPS_BEARER_IDENTITY_UNASSIGNED == mme_app_get_free_bearer_ebi(ue_context, ded_ebi)){
     OAILOG_ERROR(LOG_MME_APP,  "Could not find a free bearer context with for ue_id " MME_UE_S1AP_ID_FMT" for ded_ebi=%d! \n", ue_id, ded_ebi);
     OAILOG_FUNC_RETURN (LOG_MME_APP, ESM_CAUSE_REQUEST_REJECTED_BY_GW);
   }
@@ -196,8 +231,7 @@ mme_app_register_dedicated_bearer_context(const mme_ue_s1ap_id_t ue_id, const es
         ue_id, pdn_cid, linked_ebi, bc_tbc->tft->tftoperationcode);
     OAILOG_FUNC_RETURN (LOG_MME_APP, ESM_CAUSE_SEMANTIC_ERROR_IN_THE_TFT_OPERATION);
   }
-  DevAssert(!pBearerCtx->esm_ebr_context.tft);
-  esm_cause_t esm_cause = verify_traffic_flow_template (bc_tbc->tft, pBearerCtx->esm_ebr_context.tft);
+  esm_cause_t esm_cause = verify_traffic_flow_template (bc_tbc->tft, NULL);
   if(esm_cause != ESM_CAUSE_SUCCESS){
     OAILOG_ERROR(LOG_NAS_EMM, "EMMCN-SAP  - " "EPS bearer context of CBR received for UE " MME_UE_S1AP_ID_FMT" could not be verified due erroneous TFT. EsmCause %d. \n",
         ue_id, pdn_cid, linked_ebi, esm_cause);
@@ -207,7 +241,7 @@ mme_app_register_dedicated_bearer_context(const mme_ue_s1ap_id_t ue_id, const es
 
   // todo: LOCK_UE_CONTEXT(
   // todo: EBI must match
-  pBearerCtx = RB_REMOVE(BearerPool, &ue_context->bearer_pool, pBearerCtx);
+  pBearerCtx = mme_app_new_ue_bearer_context(ue_context, ded_ebi);
   DevAssert(pBearerCtx);
   AssertFatal((EPS_BEARER_IDENTITY_LAST >= pBearerCtx->ebi) && (EPS_BEARER_IDENTITY_FIRST <= pBearerCtx->ebi), "Bad ebi %u", pBearerCtx->ebi);
   /* Check that there is no collision when adding the bearer context into the PDN sessions bearer pool. */
@@ -728,12 +762,10 @@ mme_app_release_bearer_context(mme_ue_s1ap_id_t ue_id, const pdn_cid_t *pdn_cid,
    * So the delete function is unlike to GTPv2c tunnels.
    */
   // no timers to stop, no DSR to be sent..
-  /** Initialize the new bearer context. Nothing needs to be done in the ESM layer. */
-  mme_app_bearer_context_initialize(bearer_context);
-  /** Insert the bearer context into the free bearer of the ue context. */
-  RB_INSERT (BearerPool, &ue_context->bearer_pool, bearer_context);
   OAILOG_INFO(LOG_MME_APP, "Successfully deregistered the bearer context with ebi %d from PDN id %u and for ue_id " MME_UE_S1AP_ID_FMT "\n",
       bearer_context->ebi, bearer_context->pdn_cx_id, ue_id);
+  /** Release the bearer context, its EBI becomes free. Nothing needs to be done in the ESM layer. */
+  mme_app_release_ue_bearer_context(ue_context, &bearer_context);
   // TODO: UNLOCK_UE_CONTEXT!
   OAILOG_FUNC_OUT(LOG_MME_APP);
 }
@@ -36,7 +36,12 @@ void mme_app_bearer_context_initialize(bearer_context_t *bearer_context);
 /** Find an allocated PDN session bearer context. */
 bearer_context_t* mme_app_get_session_bearer_context(pdn_context_t * const pdn_context, const ebi_t ebi);
 
-void mme_app_get_free_bearer_context(ue_context_t * const ue_context, const ebi_t ebi, bearer_context_t ** bc_pp);
+/** The EBI if it is free, else the lowest free EBI for EPS_BEARER_IDENTITY_UNASSIGNED, else EPS_BEARER_IDENTITY_UNASSIGNED. */
+ebi_t mme_app_get_free_bearer_ebi(const ue_context_t * const ue_context, const ebi_t ebi);
+/** Allocate the bearer context of a free EBI of the UE (as in mme_app_get_free_bearer_ebi). */
+bearer_context_t *mme_app_new_ue_bearer_context(ue_context_t * const ue_context, const ebi_t ebi);
+/** Free the bearer context of the UE, its EBI becomes free. */
+void mme_app_release_ue_bearer_context(ue_context_t * const ue_context, bearer_context_t ** const bearer_context);
 
 // todo_: combine these two methods
 void mme_app_get_session_bearer_context_from_all(ue_context_t * const ue_context, const ebi_t ebi, bearer_context_t ** bc_pp);
@@ -0,0 +1,217 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_bulk_release.c
+  \brief Bulk release of the UEs of a reset or lost eNB.
+  Only used by the MME_APP task, the queues are not locked.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "assertions.h"
+#include "common_defs.h"
+#include "intertask_interface.h"
+#include "timer.h"
+#include "mme_config.h"
+#include "emm_data.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "mme_app_itti_messaging.h"
+#include "mme_app_statistics.h"
+#include "mme_app_bulk_release.h"
+
+#define MME_APP_BULK_RELEASE_MIN_QUEUE_SIZE 64
+
+/* UEs of one SGW waiting for their S11 Release Access Bearers, oldest at first */
+typedef struct mme_app_bulk_release_sgw_s {
+  struct in_addr                sgw_ipv4;
+  mme_ue_s1ap_id_t             *ue_ids;
+  uint32_t                      first;
+  uint32_t                      nb_ue_ids;
+  uint32_t                      size;
+} mme_app_bulk_release_sgw_t;
+
+static struct {
+  mme_app_bulk_release_sgw_t   *sgws;
+  uint32_t                      nb_sgws;
+  uint32_t                      next_sgw;       /* round robin over the SGWs */
+  uint32_t                      nb_queued;
+} bulk_release = {0};
+
+//------------------------------------------------------------------------------
+static mme_app_bulk_release_sgw_t *mme_app_bulk_release_get_sgw (const struct in_addr sgw_ipv4)
+{
+  mme_app_bulk_release_sgw_t             *sgw = NULL;
+
+  for (uint32_t i = 0; i < bulk_release.nb_sgws; i++) {
+    if (bulk_release.sgws[i].sgw_ipv4.s_addr == sgw_ipv4.s_addr) {
+      return &bulk_release.sgws[i];
+    }
+  }
+  sgw = realloc (bulk_release.sgws, (bulk_release.nb_sgws + 1) * sizeof (mme_app_bulk_release_sgw_t));
+  if (!sgw) {
+    return NULL;
+  }
+  bulk_release.sgws = sgw;
+  sgw = &bulk_release.sgws[bulk_release.nb_sgws++];
+  memset (sgw, 0, sizeof (*sgw));
+  sgw->sgw_ipv4 = sgw_ipv4;
+  return sgw;
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_bulk_release_push (mme_app_bulk_release_sgw_t * const sgw, const mme_ue_s1ap_id_t ue_id)
+{
+  if ((sgw->first + sgw->nb_ue_ids) == sgw->size) {
+    if (sgw->first) {
+      memmove (sgw->ue_ids, &sgw->ue_ids[sgw->first], sgw->nb_ue_ids * sizeof (mme_ue_s1ap_id_t));
+      sgw->first = 0;
+    } else {
+      const uint32_t                          size = (sgw->size) ? (sgw->size * 2) : MME_APP_BULK_RELEASE_MIN_QUEUE_SIZE;
+      mme_ue_s1ap_id_t                       *ue_ids = realloc (sgw->ue_ids, size * sizeof (mme_ue_s1ap_id_t));
+
+      if (!ue_ids) {
+        return false;
+      }
+      sgw->ue_ids = ue_ids;
+      sgw->size = size;
+    }
+  }
+  sgw->ue_ids[sgw->first + sgw->nb_ue_ids++] = ue_id;
+  bulk_release.nb_queued++;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_bulk_release_queue (ue_context_t * const ue_context)
+{
+  pdn_context_t                          *pdn_context = RB_MIN (PdnContexts, &ue_context->pdn_contexts);
+  mme_app_bulk_release_sgw_t             *sgw = NULL;
+
+  if (!pdn_context) {
+    return;
+  }
+  if (!mme_config.bulk_release_rate) {
+    mme_app_send_s11_release_access_bearers_req (ue_context);
+    return;
+  }
+  // the request goes to the SGW of the first PDN, see mme_app_send_s11_release_access_bearers_req()
+  sgw = mme_app_bulk_release_get_sgw (pdn_context->s_gw_address_s11_s4.address.ipv4_address);
+  if ((!sgw) || (!mme_app_bulk_release_push (sgw, ue_context->mme_ue_s1ap_id))) {
+    OAILOG_ERROR (LOG_MME_APP, "Bulk release: could not queue the S11 Release Access Bearers of UE " MME_UE_S1AP_ID_FMT ", sending it now\n", ue_context->mme_ue_s1ap_id);
+    mme_app_send_s11_release_access_bearers_req (ue_context);
+    return;
+  }
+  if (!mme_app_desc.bulk_release_timer_id) {
+    if (timer_setup (0, MME_APP_BULK_RELEASE_TICK_USEC, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &mme_app_desc.bulk_release_timer_id) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "Failed to request new timer for the bulk release\n");
+      mme_app_desc.bulk_release_timer_id = 0;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+bool mme_app_bulk_release_ue (ue_context_t * const ue_context, const enb_ue_s1ap_id_t enb_ue_s1ap_id, const uint32_t enb_id)
+{
+  emm_data_context_t                     *emm_context = NULL;
+
+  /*
+   * The UEs with a procedure to abort go through the per UE release
+   */
+  if ((UE_REGISTERED != ue_context->mm_state) || (ECM_CONNECTED != ue_context->ecm_state)
+      || (ue_context->enb_ue_s1ap_id != enb_ue_s1ap_id) || (ue_context->e_utran_cgi.cell_identity.enb_id != enb_id)
+      || (ue_context->s10_procedures) || (ue_context->s11_procedures)
+      || (ue_context->esm_procedures.pdn_connectivity_procedures) || (ue_context->esm_procedures.bearer_context_procedures)
+      || (MME_APP_TIMER_INACTIVE_ID != ue_context->initial_context_setup_rsp_timer.id)) {
+    return false;
+  }
+  emm_context = emm_data_context_get (&_emm_data, ue_context->mme_ue_s1ap_id);
+  if ((!emm_context) || (emm_context->emm_procedures)) {
+    return false;
+  }
+
+  ue_context->s1_bulk_released = true;
+  mme_app_ue_context_s1_release_enb_informations (ue_context);
+  mme_ue_context_update_ue_sig_connection_state (&mme_app_desc.mme_ue_contexts, ue_context, ECM_IDLE);
+  // S1AP only removes its UE reference, the eNB is gone or reset
+  mme_app_itti_ue_context_release (ue_context->mme_ue_s1ap_id, enb_ue_s1ap_id, S1AP_SCTP_SHUTDOWN_OR_RESET, enb_id);
+  mme_app_bulk_release_queue (ue_context);
+  mme_stats_inc (UE_BULK_RELEASED);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_bulk_release_send (void)
+{
+  uint32_t                                budget = (uint32_t)(((uint64_t)mme_config.bulk_release_rate * MME_APP_BULK_RELEASE_TICK_USEC) / 1000000);
+  ue_context_t                           *ue_context = NULL;
+
+  if (!budget) {
+    budget = 1;
+  }
+  while ((budget) && (bulk_release.nb_queued)) {
+    mme_app_bulk_release_sgw_t * const      sgw = &bulk_release.sgws[bulk_release.next_sgw++ % bulk_release.nb_sgws];
+
+    if (!sgw->nb_ue_ids) {
+      continue;
+    }
+    const mme_ue_s1ap_id_t                  ue_id = sgw->ue_ids[sgw->first++];
+
+    sgw->nb_ue_ids--;
+    bulk_release.nb_queued--;
+    if (!sgw->nb_ue_ids) {
+      sgw->first = 0;
+    }
+    ue_context = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue_id);
+    // a UE connected again meanwhile has its S1-U bearers modified by its service request
+    if ((ue_context) && (UE_REGISTERED == ue_context->mm_state) && (ECM_IDLE == ue_context->ecm_state)) {
+      mme_app_send_s11_release_access_bearers_req (ue_context);
+      budget--;
+    }
+  }
+  if ((!bulk_release.nb_queued) && (mme_app_desc.bulk_release_timer_id)) {
+    timer_remove (mme_app_desc.bulk_release_timer_id, NULL);
+    mme_app_desc.bulk_release_timer_id = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+void mme_app_bulk_release_exit (void)
+{
+  if (mme_app_desc.bulk_release_timer_id) {
+    timer_remove (mme_app_desc.bulk_release_timer_id, NULL);
+    mme_app_desc.bulk_release_timer_id = 0;
+  }
+  for (uint32_t i = 0; i < bulk_release.nb_sgws; i++) {
+    free_wrapper ((void**)&bulk_release.sgws[i].ue_ids);
+  }
+  free_wrapper ((void**)&bulk_release.sgws);
+  bulk_release.nb_sgws = 0;
+  bulk_release.nb_queued = 0;
+}
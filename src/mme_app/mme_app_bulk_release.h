@@ -0,0 +1,56 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_bulk_release.h
+  \brief Release of all the UEs of an eNB after an S1 reset or the loss of its SCTP association.
+  The registered UEs are moved to ECM-IDLE in one pass, their S11 Release Access Bearers
+  are queued per SGW and sent at MME_BULK_RELEASE_RATE, round robin over the SGWs.
+*/
+
+#ifndef FILE_MME_APP_BULK_RELEASE_SEEN
+#define FILE_MME_APP_BULK_RELEASE_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common_types.h"
+
+#define MME_APP_BULK_RELEASE_TICK_USEC      100000  /*!< \brief Period of the timer sending the queued S11 requests */
+
+struct ue_context_s;
+
+/*! \fn bool mme_app_bulk_release_ue(struct ue_context_s * const ue_context, const enb_ue_s1ap_id_t enb_ue_s1ap_id, const uint32_t enb_id)
+ * \brief Move a registered UE connected to the released eNB to ECM-IDLE and queue its S11 Release Access Bearers.
+ * \return false if the UE needs the per UE release (procedure running, not registered, connected elsewhere...).
+ */
+bool mme_app_bulk_release_ue(struct ue_context_s * const ue_context, const enb_ue_s1ap_id_t enb_ue_s1ap_id, const uint32_t enb_id);
+
+/*! \fn void mme_app_bulk_release_send(void)
+ * \brief Send the share of the queued S11 requests of one timer tick.
+ */
+void mme_app_bulk_release_send(void);
+
+/*! \fn void mme_app_bulk_release_exit(void)
+ * \brief Drop the queued S11 requests.
+ */
+void mme_app_bulk_release_exit(void);
+
+#endif /* FILE_MME_APP_BULK_RELEASE_SEEN */
@@ -0,0 +1,791 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_checkpoint.c
+  \brief Checkpoint and warm restart of the registered UEs.
+  A slot holds the MME_APP part (UE, PDN and bearer contexts) and the EMM part of a UE, each
+  part is rewritten only if it differs from its previous snapshot. The slots are only read and
+  written by the MME_APP task. The EMM contexts belong to the NAS EMM task: on NAS_CHECKPOINT_REQ
+  it copies the EMM part of its registered UEs and sends them back in NAS_CHECKPOINT_RSP.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "assertions.h"
+#include "common_defs.h"
+#include "intertask_interface.h"
+#include "mme_api.h"
+#include "emm_data.h"
+#include "emm_cause.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "mme_app_pdn_context.h"
+#include "mme_app_bearer_context.h"
+#include "mme_app_checkpoint.h"
+#include "mme_app_idle.h"
+
+#define MME_APP_CHECKPOINT_SLOT_MME_VALID   (1 << 0)
+#define MME_APP_CHECKPOINT_SLOT_EMM_VALID   (1 << 1)
+
+/* EMM context members kept in a slot, the authentication vectors and the procedures are not */
+#define MME_APP_CHECKPOINT_EMM_MEMBERS      (EMM_CTXT_MEMBER_IMSI | EMM_CTXT_MEMBER_IMEI | EMM_CTXT_MEMBER_IMEI_SV | \
+    EMM_CTXT_MEMBER_GUTI | EMM_CTXT_MEMBER_TAI_LIST | EMM_CTXT_MEMBER_LVR_TAI | EMM_CTXT_MEMBER_SECURITY | \
+    EMM_CTXT_MEMBER_UE_NETWORK_CAPABILITY_IE | EMM_CTXT_MEMBER_MS_NETWORK_CAPABILITY_IE | EMM_CTXT_MEMBER_CURRENT_DRX_PARAMETER)
+
+typedef struct mme_app_checkpoint_bearer_s {
+  ebi_t                       ebi;
+  ebi_t                       linked_ebi;             /* default EBI of the PDN */
+  mme_app_bearer_state_t      bearer_state;
+  uint8_t                     esm_ebr_state;
+  fteid_t                     s_gw_fteid_s1u;
+  fteid_t                     p_gw_fteid_s5_s8_up;
+  bearer_qos_t                bearer_level_qos;
+} mme_app_checkpoint_bearer_t;
+
+typedef struct mme_app_checkpoint_pdn_s {
+  context_identifier_t        context_identifier;
+  pdn_type_t                  pdn_type;
+  ebi_t                       default_ebi;
+  bool                        paa_present;
+  paa_t                       paa;
+  ip_address_t                p_gw_address_s5_s8_cp;
+  teid_t                      p_gw_teid_s5_s8_cp;
+  ip_address_t                s_gw_address_s11_s4;
+  teid_t                      s_gw_teid_s11_s4;
+  ambr_t                      subscribed_apn_ambr;
+  char                        apn_in_use[ACCESS_POINT_NAME_MAX_LENGTH + 1];
+  char                        apn_subscribed[ACCESS_POINT_NAME_MAX_LENGTH + 1];
+  char                        apn_oi_replacement[ACCESS_POINT_NAME_MAX_LENGTH + 1];
+} mme_app_checkpoint_pdn_t;
+
+typedef struct mme_app_checkpoint_mme_s {
+  imsi64_t                    imsi;
+  mme_ue_s1ap_id_t            mme_ue_s1ap_id;
+  teid_t                      mme_teid_s11;
+  teid_t                      s_gw_teid_s11_s4;
+  guti_t                      guti;
+  ecgi_t                      e_utran_cgi;
+  ard_t                       access_restriction_data;
+  ambr_t                      subscribed_ue_ambr;
+  rau_tau_timer_t             rau_tau_timer;
+  network_access_mode_t       access_mode;
+  subscriber_status_t         sub_status;
+  subscriber_status_t         subscriber_status;
+  network_access_mode_t       network_access_mode;
+  ebi_t                       next_def_ebi_offset;
+  uint8_t                     nb_pdns;
+  uint8_t                     nb_bearers;
+  char                        msisdn[MSISDN_LENGTH + 1];
+  char                        apn_oi_replacement[ACCESS_POINT_NAME_MAX_LENGTH + 1];
+  mme_app_checkpoint_pdn_t    pdns[MAX_APN_PER_UE];
+  mme_app_checkpoint_bearer_t bearers[MAX_NUM_BEARERS_UE];
+} mme_app_checkpoint_mme_t;
+
+typedef struct mme_app_checkpoint_emm_s {
+  uint32_t                    member_present_mask;
+  uint32_t                    member_valid_mask;
+  bool                        is_emergency;
+  bool                        is_has_been_attached;
+  uint8_t                     attach_type;
+  ksi_t                       ksi;
+  imsi_t                      imsi;
+  imei_t                      imei;
+  imeisv_t                    imeisv;
+  guti_t                      guti;
+  tai_t                       lvr_tai;
+  tai_t                       originating_tai;
+  ue_network_capability_t     ue_network_capability;
+  ms_network_capability_t     ms_network_capability;
+  drx_parameter_t             drx_parameter;
+  drx_parameter_t             current_drx_parameter;
+  emm_security_context_t      security;
+  tai_list_t                  tai_list;
+} mme_app_checkpoint_emm_t;
+
+/* EMM part of a UE, copied by the NAS EMM task */
+typedef struct mme_app_checkpoint_emm_ue_s {
+  mme_ue_s1ap_id_t            ue_id;
+  mme_app_checkpoint_emm_t    emm;
+} mme_app_checkpoint_emm_ue_t;
+
+typedef struct mme_app_checkpoint_emm_ues_s {
+  mme_app_checkpoint_emm_ue_t *ues;
+  uint32_t                    nb_ues;
+  uint32_t                    nb_ues_max;
+} mme_app_checkpoint_emm_ues_t;
+
+typedef struct mme_app_checkpoint_slot_s {
+  uint32_t                    flags;
+  uint32_t                    reserved;
+  mme_app_checkpoint_mme_t    mme;
+  mme_app_checkpoint_emm_t    emm;
+} mme_app_checkpoint_slot_t;
+
+typedef struct mme_app_checkpoint_desc_s {
+  int                         fd;
+  uint8_t                    *map;
+  size_t                      map_size;
+  uint32_t                    nb_slots;
+  /* Snapshot round that last saw the MME_APP and EMM parts of the UE of a slot, 0 for a free slot */
+  uint32_t                   *mme_round;
+  uint32_t                   *emm_round;
+  uint32_t                   *free_slots;
+  uint32_t                    nb_free_slots;
+  hash_table_uint64_ts_t     *ue_id_slot_htbl;      // data is the slot index
+  uint32_t                    round;
+  uint32_t                    pending_round;          /* round waiting for the EMM parts, 0 if none */
+  uint32_t                    nb_ues;
+  uint32_t                    nb_written;
+  uint32_t                    nb_missing;
+} mme_app_checkpoint_desc_t;
+
+static mme_app_checkpoint_desc_t          checkpoint = {.fd = -1};
+
+//------------------------------------------------------------------------------
+static inline mme_app_checkpoint_file_header_t * mme_app_checkpoint_header (uint8_t * const map)
+{
+  return (mme_app_checkpoint_file_header_t *)map;
+}
+
+//------------------------------------------------------------------------------
+static inline mme_app_checkpoint_slot_t * mme_app_checkpoint_slot (uint8_t * const map, const uint32_t index)
+{
+  return (mme_app_checkpoint_slot_t *)&map[MME_APP_CHECKPOINT_HEADER_SIZE + (size_t)index * sizeof (mme_app_checkpoint_slot_t)];
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_checkpoint_bstring_to_char (char * const dst, const size_t dst_size, const_bstring src)
+{
+  if ((src) && (blength (src))) {
+    const size_t length = ((size_t)blength (src) < dst_size) ? (size_t)blength (src) : dst_size - 1;
+    memcpy (dst, src->data, length);
+    dst[length] = '\0';
+  }
+}
+
+//------------------------------------------------------------------------------
+// the file may not hold a NUL terminated string
+static bstring mme_app_checkpoint_char_to_bstring (const char * const src, const size_t src_size)
+{
+  const size_t length = strnlen (src, src_size);
+
+  return (length) ? blk2bstr (src, length) : NULL;
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_checkpoint_write_mme (mme_app_checkpoint_mme_t * const mme, ue_context_t * const ue_context)
+{
+  pdn_context_t                          *pdn_context = NULL;
+  bearer_context_t                       *bearer_context = NULL;
+
+  mme->imsi                    = ue_context->imsi;
+  mme->mme_ue_s1ap_id          = ue_context->mme_ue_s1ap_id;
+  mme->mme_teid_s11            = ue_context->mme_teid_s11;
+  mme->s_gw_teid_s11_s4        = ue_context->s_gw_teid_s11_s4;
+  mme->guti                    = ue_context->guti;
+  mme->e_utran_cgi             = ue_context->e_utran_cgi;
+  mme->access_restriction_data = ue_context->access_restriction_data;
+  mme->subscribed_ue_ambr      = ue_context->subscribed_ue_ambr;
+  mme->rau_tau_timer           = ue_context->rau_tau_timer;
+  mme->access_mode             = ue_context->access_mode;
+  mme->sub_status              = ue_context->sub_status;
+  mme->subscriber_status       = ue_context->subscriber_status;
+  mme->network_access_mode     = ue_context->network_access_mode;
+  mme->next_def_ebi_offset     = ue_context->next_def_ebi_offset;
+  mme_app_checkpoint_bstring_to_char (mme->msisdn, sizeof (mme->msisdn), ue_context->msisdn);
+  mme_app_checkpoint_bstring_to_char (mme->apn_oi_replacement, sizeof (mme->apn_oi_replacement), ue_context->apn_oi_replacement);
+
+  RB_FOREACH (pdn_context, PdnContexts, &ue_context->pdn_contexts) {
+    if (MAX_APN_PER_UE <= mme->nb_pdns) break;
+    mme_app_checkpoint_pdn_t * const pdn = &mme->pdns[mme->nb_pdns++];
+    pdn->context_identifier    = pdn_context->context_identifier;
+    pdn->pdn_type              = pdn_context->pdn_type;
+    pdn->default_ebi           = pdn_context->default_ebi;
+    if (pdn_context->paa) {
+      pdn->paa_present         = true;
+      pdn->paa                 = *pdn_context->paa;
+    }
+    pdn->p_gw_address_s5_s8_cp = pdn_context->p_gw_address_s5_s8_cp;
+    pdn->p_gw_teid_s5_s8_cp    = pdn_context->p_gw_teid_s5_s8_cp;
+    pdn->s_gw_address_s11_s4   = pdn_context->s_gw_address_s11_s4;
+    pdn->s_gw_teid_s11_s4      = pdn_context->s_gw_teid_s11_s4;
+    pdn->subscribed_apn_ambr   = pdn_context->subscribed_apn_ambr;
+    mme_app_checkpoint_bstring_to_char (pdn->apn_in_use, sizeof (pdn->apn_in_use), pdn_context->apn_in_use);
+    mme_app_checkpoint_bstring_to_char (pdn->apn_subscribed, sizeof (pdn->apn_subscribed), pdn_context->apn_subscribed);
+    mme_app_checkpoint_bstring_to_char (pdn->apn_oi_replacement, sizeof (pdn->apn_oi_replacement), pdn_context->apn_oi_replacement);
+
+    RB_FOREACH (bearer_context, SessionBearers, &pdn_context->session_bearers) {
+      if (MAX_NUM_BEARERS_UE <= mme->nb_bearers) break;
+      mme_app_checkpoint_bearer_t * const bearer = &mme->bearers[mme->nb_bearers++];
+      bearer->ebi                 = bearer_context->ebi;
+      bearer->linked_ebi          = pdn_context->default_ebi;
+      bearer->bearer_state        = bearer_context->bearer_state;
+      bearer->esm_ebr_state       = (uint8_t)bearer_context->esm_ebr_context.status;
+      bearer->s_gw_fteid_s1u      = bearer_context->s_gw_fteid_s1u;
+      bearer->p_gw_fteid_s5_s8_up = bearer_context->p_gw_fteid_s5_s8_up;
+      bearer->bearer_level_qos    = bearer_context->bearer_level_qos;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_checkpoint_write_emm (mme_app_checkpoint_emm_t * const emm, const emm_data_context_t * const emm_context)
+{
+  emm->member_present_mask   = emm_context->member_present_mask & MME_APP_CHECKPOINT_EMM_MEMBERS;
+  emm->member_valid_mask     = emm_context->member_valid_mask & MME_APP_CHECKPOINT_EMM_MEMBERS;
+  emm->is_emergency          = emm_context->is_emergency;
+  emm->is_has_been_attached  = emm_context->is_has_been_attached;
+  emm->attach_type           = emm_context->attach_type;
+  emm->ksi                   = emm_context->ksi;
+  emm->imsi                  = emm_context->_imsi;
+  emm->imei                  = emm_context->_imei;
+  emm->imeisv                = emm_context->_imeisv;
+  emm->guti                  = emm_context->_guti;
+  emm->lvr_tai               = emm_context->_lvr_tai;
+  emm->originating_tai       = emm_context->originating_tai;
+  emm->ue_network_capability = emm_context->_ue_network_capability;
+  emm->ms_network_capability = emm_context->_ms_network_capability;
+  emm->drx_parameter         = emm_context->_drx_parameter;
+  emm->current_drx_parameter = emm_context->_current_drx_parameter;
+  emm->security              = emm_context->_security;
+  emm->tai_list              = emm_context->_tai_list;
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_checkpoint_get_slot (const mme_ue_s1ap_id_t ue_id, const bool allocate, uint32_t * const index)
+{
+  uint64_t                                data = 0;
+
+  if (HASH_TABLE_OK == hashtable_uint64_ts_get (checkpoint.ue_id_slot_htbl, (const hash_key_t)ue_id, &data)) {
+    *index = (uint32_t)data;
+    return true;
+  }
+  if ((!allocate) || (!checkpoint.nb_free_slots)) {
+    return false;
+  }
+  *index = checkpoint.free_slots[--checkpoint.nb_free_slots];
+  hashtable_uint64_ts_insert (checkpoint.ue_id_slot_htbl, (const hash_key_t)ue_id, (uint64_t)*index);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_checkpoint_release_slot (const uint32_t index)
+{
+  mme_app_checkpoint_slot_t * const slot = mme_app_checkpoint_slot (checkpoint.map, index);
+
+  hashtable_uint64_ts_remove (checkpoint.ue_id_slot_htbl, (const hash_key_t)slot->mme.mme_ue_s1ap_id);
+  slot->flags = 0;
+  checkpoint.mme_round[index] = 0;
+  checkpoint.emm_round[index] = 0;
+  checkpoint.free_slots[checkpoint.nb_free_slots++] = index;
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_checkpoint_ue_cb (const hash_key_t keyP, void * const ue_context_p, void *unused_param_pP, void **unused_result_pP)
+{
+  ue_context_t * const                    ue_context = (ue_context_t *)ue_context_p;
+  mme_app_checkpoint_mme_t                mme;
+  uint32_t                                index = 0;
+
+  // a UE in the middle of its attach or detach has to run it again
+  if ((!ue_context) || (UE_REGISTERED != ue_context->mm_state) || (INVALID_MME_UE_S1AP_ID == ue_context->mme_ue_s1ap_id)) {
+    return false;
+  }
+  if (!mme_app_checkpoint_get_slot (ue_context->mme_ue_s1ap_id, true, &index)) {
+    checkpoint.nb_missing++;
+    return false;
+  }
+  mme_app_checkpoint_slot_t * const slot = mme_app_checkpoint_slot (checkpoint.map, index);
+  if (ue_context->idle_ue) {
+    // a compacted UE did not change since its slot was written
+    if ((slot->flags & MME_APP_CHECKPOINT_SLOT_MME_VALID) && (slot->flags & MME_APP_CHECKPOINT_SLOT_EMM_VALID)) {
+      checkpoint.mme_round[index] = checkpoint.round;
+      checkpoint.emm_round[index] = checkpoint.round;
+      checkpoint.nb_ues++;
+      return false;
+    }
+    mme_app_idle_ue_expand (ue_context);
+  }
+  memset (&mme, 0, sizeof (mme));
+  mme_app_checkpoint_write_mme (&mme, ue_context);
+
+  if ((!(slot->flags & MME_APP_CHECKPOINT_SLOT_MME_VALID)) || (memcmp (&slot->mme, &mme, sizeof (mme)))) {
+    memcpy (&slot->mme, &mme, sizeof (mme));
+    slot->flags |= MME_APP_CHECKPOINT_SLOT_MME_VALID;
+    checkpoint.nb_written++;
+  }
+  checkpoint.mme_round[index] = checkpoint.round;
+  checkpoint.nb_ues++;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_checkpoint_emm_cb (const hash_key_t keyP, void * const emm_context_p, void *emm_ues_p, void **unused_result_pP)
+{
+  const emm_data_context_t * const        emm_context = (const emm_data_context_t *)emm_context_p;
+  mme_app_checkpoint_emm_ues_t * const    emm_ues = (mme_app_checkpoint_emm_ues_t *)emm_ues_p;
+
+  if ((!emm_context) || (EMM_REGISTERED != emm_context->_emm_fsm_state)) {
+    return false;
+  }
+  if (emm_ues->nb_ues >= emm_ues->nb_ues_max) {
+    // stop, the slots are all used
+    return true;
+  }
+  mme_app_checkpoint_emm_ue_t * const emm_ue = &emm_ues->ues[emm_ues->nb_ues++];
+  emm_ue->ue_id = emm_context->ue_id;
+  mme_app_checkpoint_write_emm (&emm_ue->emm, emm_context);
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_emm_snapshot (const itti_nas_checkpoint_req_t * const checkpoint_req)
+{
+  mme_app_checkpoint_emm_ues_t            emm_ues = {.ues = NULL, .nb_ues = 0, .nb_ues_max = 0};
+  MessageDef                             *message_p = NULL;
+
+  emm_ues.nb_ues_max = (_emm_data.ctx_coll_ue_id->num_elements < checkpoint_req->nb_ues_max) ?
+      _emm_data.ctx_coll_ue_id->num_elements : checkpoint_req->nb_ues_max;
+  if (emm_ues.nb_ues_max) {
+    emm_ues.ues = calloc (emm_ues.nb_ues_max, sizeof (mme_app_checkpoint_emm_ue_t));
+    if (!emm_ues.ues) {
+      emm_ues.nb_ues_max = 0;
+    }
+  }
+  if (emm_ues.ues) {
+    hashtable_ts_apply_callback_on_elements (_emm_data.ctx_coll_ue_id, mme_app_checkpoint_emm_cb, &emm_ues, NULL);
+  }
+  message_p = itti_alloc_new_message (TASK_NAS_EMM, NAS_CHECKPOINT_RSP);
+  NAS_CHECKPOINT_RSP (message_p).round = checkpoint_req->round;
+  NAS_CHECKPOINT_RSP (message_p).nb_ues = emm_ues.nb_ues;
+  NAS_CHECKPOINT_RSP (message_p).ues_ptr = (uintptr_t)emm_ues.ues;
+  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+// the EMM part of the UEs missing in the snapshot is invalidated, write back the slots
+static void mme_app_checkpoint_complete (void)
+{
+  mme_app_checkpoint_file_header_t       *header = NULL;
+
+  for (uint32_t index = 0; index < checkpoint.nb_slots; index++) {
+    if ((checkpoint.mme_round[index] == checkpoint.round) && (checkpoint.emm_round[index] != checkpoint.round)) {
+      mme_app_checkpoint_slot_t * const slot = mme_app_checkpoint_slot (checkpoint.map, index);
+      if (slot->flags & MME_APP_CHECKPOINT_SLOT_EMM_VALID) {
+        slot->flags &= ~MME_APP_CHECKPOINT_SLOT_EMM_VALID;
+        checkpoint.nb_written++;
+      }
+    }
+  }
+  checkpoint.pending_round = 0;
+
+  header = mme_app_checkpoint_header (checkpoint.map);
+  header->nb_ues = checkpoint.nb_ues;
+  header->snapshot_time_sec = (int64_t)time (NULL);
+  // the dirty pages are written back by the kernel, nothing to do for an unchanged UE
+  msync (checkpoint.map, checkpoint.map_size, MS_ASYNC);
+
+  if (checkpoint.nb_missing) {
+    OAILOG_WARNING (LOG_MME_APP, "Checkpoint: %u UEs not saved, no free slot (%u slots)\n", checkpoint.nb_missing, checkpoint.nb_slots);
+  }
+  OAILOG_DEBUG (LOG_MME_APP, "Checkpoint: %u UEs saved, %u slots updated\n", checkpoint.nb_ues, checkpoint.nb_written);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_handle_emm_snapshot (const itti_nas_checkpoint_rsp_t * const checkpoint_rsp)
+{
+  const mme_app_checkpoint_emm_ue_t * const emm_ues = (const mme_app_checkpoint_emm_ue_t *)checkpoint_rsp->ues_ptr;
+  uint32_t                                index = 0;
+
+  if ((!checkpoint.map) || (!checkpoint.pending_round) || (checkpoint_rsp->round != checkpoint.pending_round)) {
+    OAILOG_DEBUG (LOG_MME_APP, "Checkpoint: ignoring the EMM snapshot of round %u\n", checkpoint_rsp->round);
+    return;
+  }
+  for (uint32_t i = 0; i < checkpoint_rsp->nb_ues; i++) {
+    // the MME_APP part of the UE is written first
+    if ((!mme_app_checkpoint_get_slot (emm_ues[i].ue_id, false, &index)) || (checkpoint.mme_round[index] != checkpoint.round)) {
+      continue;
+    }
+    mme_app_checkpoint_slot_t * const slot = mme_app_checkpoint_slot (checkpoint.map, index);
+    if ((!(slot->flags & MME_APP_CHECKPOINT_SLOT_EMM_VALID)) || (memcmp (&slot->emm, &emm_ues[i].emm, sizeof (slot->emm)))) {
+      memcpy (&slot->emm, &emm_ues[i].emm, sizeof (slot->emm));
+      slot->flags |= MME_APP_CHECKPOINT_SLOT_EMM_VALID;
+      checkpoint.nb_written++;
+    }
+    checkpoint.emm_round[index] = checkpoint.round;
+  }
+  mme_app_checkpoint_complete ();
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_snapshot (void)
+{
+  MessageDef                             *message_p = NULL;
+
+  if (!checkpoint.map) {
+    return;
+  }
+  if (checkpoint.pending_round) {
+    OAILOG_WARNING (LOG_MME_APP, "Checkpoint: NAS did not answer the snapshot of round %u yet, skipping this one\n", checkpoint.pending_round);
+    return;
+  }
+  if (!(++checkpoint.round)) {
+    checkpoint.round = 1;
+  }
+  checkpoint.nb_ues = 0;
+  checkpoint.nb_written = 0;
+  checkpoint.nb_missing = 0;
+
+  hashtable_ts_apply_callback_on_elements (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, mme_app_checkpoint_ue_cb, NULL, NULL);
+
+  for (uint32_t index = 0; index < checkpoint.nb_slots; index++) {
+    if ((checkpoint.mme_round[index]) && (checkpoint.mme_round[index] != checkpoint.round)) {
+      // UE removed or not registered anymore
+      mme_app_checkpoint_release_slot (index);
+      checkpoint.nb_written++;
+    }
+  }
+
+  // the EMM parts are read by their owner, the slots are completed on NAS_CHECKPOINT_RSP
+  checkpoint.pending_round = checkpoint.round;
+  message_p = itti_alloc_new_message (TASK_MME_APP, NAS_CHECKPOINT_REQ);
+  NAS_CHECKPOINT_REQ (message_p).round = checkpoint.round;
+  NAS_CHECKPOINT_REQ (message_p).nb_ues_max = checkpoint.nb_slots;
+  if (RETURNok != itti_send_msg_to_task (TASK_NAS_EMM, INSTANCE_DEFAULT, message_p)) {
+    OAILOG_WARNING (LOG_MME_APP, "Checkpoint: NAS_CHECKPOINT_REQ dropped, EMM parts not updated\n");
+    // keep the EMM parts of the previous snapshot
+    for (uint32_t index = 0; index < checkpoint.nb_slots; index++) {
+      if (checkpoint.mme_round[index] == checkpoint.round) {
+        checkpoint.emm_round[index] = checkpoint.round;
+      }
+    }
+    mme_app_checkpoint_complete ();
+  }
+}
+
+//------------------------------------------------------------------------------
+static int mme_app_checkpoint_restore_ue (const mme_app_checkpoint_slot_t * const slot)
+{
+  const mme_app_checkpoint_mme_t * const  mme = &slot->mme;
+  const mme_app_checkpoint_emm_t * const  emm = &slot->emm;
+  ue_context_t                           *ue_context = NULL;
+  emm_data_context_t                     *emm_context = NULL;
+  pdn_context_t                          *pdn_context = NULL;
+
+  if ((INVALID_MME_UE_S1AP_ID == mme->mme_ue_s1ap_id) || (MAX_APN_PER_UE < mme->nb_pdns) || (MAX_NUM_BEARERS_UE < mme->nb_bearers)) {
+    return RETURNerror;
+  }
+  ue_context = mme_create_new_ue_context ();
+  if (!ue_context) {
+    return RETURNerror;
+  }
+  ue_context->imsi                    = mme->imsi;
+  ue_context->mme_ue_s1ap_id          = mme->mme_ue_s1ap_id;
+  ue_context->mme_teid_s11            = mme->mme_teid_s11;
+  ue_context->s_gw_teid_s11_s4        = mme->s_gw_teid_s11_s4;
+  ue_context->guti                    = mme->guti;
+  ue_context->is_guti_set             = true;
+  ue_context->e_utran_cgi             = mme->e_utran_cgi;
+  ue_context->access_restriction_data = mme->access_restriction_data;
+  ue_context->subscribed_ue_ambr      = mme->subscribed_ue_ambr;
+  ue_context->rau_tau_timer           = mme->rau_tau_timer;
+  ue_context->access_mode             = mme->access_mode;
+  ue_context->sub_status              = mme->sub_status;
+  ue_context->subscriber_status       = mme->subscriber_status;
+  ue_context->network_access_mode     = mme->network_access_mode;
+  ue_context->next_def_ebi_offset     = mme->next_def_ebi_offset;
+  ue_context->msisdn                  = mme_app_checkpoint_char_to_bstring (mme->msisdn, sizeof (mme->msisdn));
+  ue_context->apn_oi_replacement      = mme_app_checkpoint_char_to_bstring (mme->apn_oi_replacement, sizeof (mme->apn_oi_replacement));
+  // the S1 connection did not survive the restart
+  ue_context->ecm_state               = ECM_IDLE;
+  ue_context->mm_state                = UE_REGISTERED;
+
+  if (RETURNok != mme_insert_ue_context (&mme_app_desc.mme_ue_contexts, ue_context)) {
+    OAILOG_ERROR (LOG_MME_APP, "Checkpoint: could not insert the UE context " MME_UE_S1AP_ID_FMT " IMSI " IMSI_64_FMT "\n",
+        mme->mme_ue_s1ap_id, mme->imsi);
+    mme_app_ue_context_free_content (ue_context);
+    free_wrapper ((void**)&ue_context);
+    return RETURNerror;
+  }
+
+  emm_context = calloc (1, sizeof (emm_data_context_t));
+  if (!emm_context) {
+    mme_remove_ue_context (&mme_app_desc.mme_ue_contexts, ue_context);
+    return RETURNerror;
+  }
+  emm_context->ue_id = mme->mme_ue_s1ap_id;
+  emm_context->is_dynamic = true;
+  emm_init_context (emm_context, true);
+  emm_context->is_emergency           = emm->is_emergency;
+  emm_context->is_has_been_attached   = emm->is_has_been_attached;
+  emm_context->attach_type            = emm->attach_type;
+  emm_context->ksi                    = emm->ksi;
+  emm_context->_imsi                  = emm->imsi;
+  emm_context->_imsi64                = mme->imsi;
+  emm_context->_imei                  = emm->imei;
+  emm_context->_imeisv                = emm->imeisv;
+  emm_context->_guti                  = emm->guti;
+  emm_context->_lvr_tai               = emm->lvr_tai;
+  emm_context->originating_tai        = emm->originating_tai;
+  emm_context->_ue_network_capability = emm->ue_network_capability;
+  emm_context->_ms_network_capability = emm->ms_network_capability;
+  emm_context->_drx_parameter         = emm->drx_parameter;
+  emm_context->_current_drx_parameter = emm->current_drx_parameter;
+  emm_context->_security              = emm->security;
+  emm_context->_tai_list              = emm->tai_list;
+  emm_context->member_present_mask    = emm->member_present_mask;
+  emm_context->member_valid_mask      = emm->member_valid_mask;
+  emm_context->emm_cause              = EMM_CAUSE_SUCCESS;
+  emm_context->_emm_fsm_state         = EMM_REGISTERED;
+
+  if (RETURNok != emm_data_context_add (&_emm_data, emm_context)) {
+    OAILOG_ERROR (LOG_MME_APP, "Checkpoint: could not insert the EMM context " MME_UE_S1AP_ID_FMT " IMSI " IMSI_64_FMT "\n",
+        mme->mme_ue_s1ap_id, mme->imsi);
+    emm_data_context_remove (&_emm_data, emm_context, false);
+    free_wrapper ((void**)&emm_context);
+    mme_remove_ue_context (&mme_app_desc.mme_ue_contexts, ue_context);
+    return RETURNerror;
+  }
+
+  for (int i = 0; i < mme->nb_pdns; i++) {
+    const mme_app_checkpoint_pdn_t * const pdn = &mme->pdns[i];
+    pdn_context = calloc (1, sizeof (pdn_context_t));
+    if (!pdn_context) {
+      break;
+    }
+    pdn_context->context_identifier    = pdn->context_identifier;
+    pdn_context->pdn_type              = pdn->pdn_type;
+    pdn_context->default_ebi           = pdn->default_ebi;
+    if (pdn->paa_present) {
+      pdn_context->paa                 = calloc (1, sizeof (paa_t));
+      if (pdn_context->paa) {
+        *pdn_context->paa              = pdn->paa;
+      }
+    }
+    pdn_context->p_gw_address_s5_s8_cp = pdn->p_gw_address_s5_s8_cp;
+    pdn_context->p_gw_teid_s5_s8_cp    = pdn->p_gw_teid_s5_s8_cp;
+    pdn_context->s_gw_address_s11_s4   = pdn->s_gw_address_s11_s4;
+    pdn_context->s_gw_teid_s11_s4      = pdn->s_gw_teid_s11_s4;
+    pdn_context->subscribed_apn_ambr   = pdn->subscribed_apn_ambr;
+    pdn_context->apn_in_use            = mme_app_checkpoint_char_to_bstring (pdn->apn_in_use, sizeof (pdn->apn_in_use));
+    pdn_context->apn_subscribed        = mme_app_checkpoint_char_to_bstring (pdn->apn_subscribed, sizeof (pdn->apn_subscribed));
+    pdn_context->apn_oi_replacement    = mme_app_checkpoint_char_to_bstring (pdn->apn_oi_replacement, sizeof (pdn->apn_oi_replacement));
+    RB_INIT (&pdn_context->session_bearers);
+    RB_INSERT (PdnContexts, &ue_context->pdn_contexts, pdn_context);
+  }
+
+  for (int i = 0; i < mme->nb_bearers; i++) {
+    const mme_app_checkpoint_bearer_t * const bearer = &mme->bearers[i];
+    bearer_context_t                         *bearer_context = NULL;
+
+    RB_FOREACH (pdn_context, PdnContexts, &ue_context->pdn_contexts) {
+      if (pdn_context->default_ebi == bearer->linked_ebi) break;
+    }
+    if (pdn_context) {
+      bearer_context = mme_app_new_ue_bearer_context (ue_context, bearer->ebi);
+    }
+    if ((!bearer_context) || (!pdn_context)) {
+      OAILOG_WARNING (LOG_MME_APP, "Checkpoint: bearer ebi %u of UE " MME_UE_S1AP_ID_FMT " not restored\n", bearer->ebi, mme->mme_ue_s1ap_id);
+      continue;
+    }
+    bearer_context->linked_ebi                = bearer->linked_ebi;
+    bearer_context->pdn_cx_id                 = pdn_context->context_identifier;
+    bearer_context->bearer_state              = bearer->bearer_state & ~BEARER_STATE_ENB_CREATED;
+    bearer_context->esm_ebr_context.status    = (esm_ebr_state)bearer->esm_ebr_state;
+    bearer_context->s_gw_fteid_s1u            = bearer->s_gw_fteid_s1u;
+    bearer_context->p_gw_fteid_s5_s8_up       = bearer->p_gw_fteid_s5_s8_up;
+    bearer_context->bearer_level_qos          = bearer->bearer_level_qos;
+    RB_INSERT (SessionBearers, &pdn_context->session_bearers, bearer_context);
+  }
+
+  // the next UE ids and TEIDs are allocated after the restored ones
+  mme_app_ctx_reserve_ue_id (mme->mme_ue_s1ap_id);
+  mme_app_reserve_s11_teid (mme->mme_teid_s11);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_checkpoint_is_valid (const mme_app_checkpoint_file_header_t * const header, const size_t file_size)
+{
+  return ((MME_APP_CHECKPOINT_HEADER_SIZE <= file_size)
+      && (!memcmp (header->magic, MME_APP_CHECKPOINT_MAGIC, sizeof (header->magic)))
+      && (MME_APP_CHECKPOINT_VERSION == header->version)
+      && (sizeof (mme_app_checkpoint_slot_t) == header->slot_size)
+      && (MME_APP_CHECKPOINT_HEADER_SIZE + (size_t)header->nb_slots * sizeof (mme_app_checkpoint_slot_t) <= file_size));
+}
+
+//------------------------------------------------------------------------------
+// restore the UEs of the file, the slots of the UEs that could not be restored are cleared
+static uint32_t mme_app_checkpoint_restore (const size_t file_size, const char * const checkpoint_file)
+{
+  uint8_t                                *map = NULL;
+  mme_app_checkpoint_file_header_t       *header = NULL;
+  uint32_t                                nb_restored = 0;
+  uint32_t                                nb_failed = 0;
+  struct timespec                         start = {0}, end = {0};
+
+  map = mmap (NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, checkpoint.fd, 0);
+  if (MAP_FAILED == map) {
+    OAILOG_ERROR (LOG_MME_APP, "Checkpoint: could not map %s: %s\n", checkpoint_file, strerror (errno));
+    return 0;
+  }
+  header = mme_app_checkpoint_header (map);
+  if (!mme_app_checkpoint_is_valid (header, file_size)) {
+    OAILOG_WARNING (LOG_MME_APP, "Checkpoint: %s is not a checkpoint of this build, UEs not restored\n", checkpoint_file);
+    munmap (map, file_size);
+    return 0;
+  }
+  madvise (map, file_size, MADV_SEQUENTIAL);
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  for (uint32_t index = 0; index < header->nb_slots; index++) {
+    mme_app_checkpoint_slot_t * const slot = mme_app_checkpoint_slot (map, index);
+    if (!slot->flags) {
+      continue;
+    }
+    if ((slot->flags & MME_APP_CHECKPOINT_SLOT_EMM_VALID) && (slot->flags & MME_APP_CHECKPOINT_SLOT_MME_VALID)
+        && (RETURNok == mme_app_checkpoint_restore_ue (slot))) {
+      nb_restored++;
+      if (index < checkpoint.nb_slots) {
+        // the UE keeps its slot
+        hashtable_uint64_ts_insert (checkpoint.ue_id_slot_htbl, (const hash_key_t)slot->mme.mme_ue_s1ap_id, (uint64_t)index);
+        checkpoint.mme_round[index] = checkpoint.round;
+        checkpoint.emm_round[index] = checkpoint.round;
+        continue;
+      }
+    } else {
+      nb_failed++;
+    }
+    slot->flags = 0;
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  OAILOG_INFO (LOG_MME_APP, "Checkpoint: %u UEs restored (%u not restored) from %s in %ld ms, snapshot of %ld seconds ago\n",
+      nb_restored, nb_failed, checkpoint_file,
+      (long)((end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000),
+      (long)(time (NULL) - header->snapshot_time_sec));
+  munmap (map, file_size);
+  return nb_restored;
+}
+
+//------------------------------------------------------------------------------
+int mme_app_checkpoint_init (const char * const checkpoint_file, const uint32_t nb_slots)
+{
+  struct stat                             st = {0};
+  mme_app_checkpoint_file_header_t       *header = NULL;
+  bstring                                 b = NULL;
+
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  AssertFatal (sizeof (mme_app_checkpoint_file_header_t) <= MME_APP_CHECKPOINT_HEADER_SIZE, "Bad checkpoint header size");
+  if ((!checkpoint_file) || (!nb_slots)) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  checkpoint.nb_slots = nb_slots;
+  checkpoint.round = 1;
+  checkpoint.mme_round = calloc (nb_slots, sizeof (uint32_t));
+  checkpoint.emm_round = calloc (nb_slots, sizeof (uint32_t));
+  checkpoint.free_slots = calloc (nb_slots, sizeof (uint32_t));
+  b = bfromcstr ("mme_app_checkpoint_ue_id_slot_htbl");
+  checkpoint.ue_id_slot_htbl = hashtable_uint64_ts_create (nb_slots, NULL, b);
+  bdestroy_wrapper (&b);
+  if ((!checkpoint.mme_round) || (!checkpoint.emm_round) || (!checkpoint.free_slots) || (!checkpoint.ue_id_slot_htbl)) {
+    mme_app_checkpoint_exit ();
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+
+  checkpoint.fd = open (checkpoint_file, O_RDWR | O_CREAT, 0600);
+  if ((0 > checkpoint.fd) || (fstat (checkpoint.fd, &st))) {
+    OAILOG_ERROR (LOG_MME_APP, "Checkpoint: could not open %s: %s\n", checkpoint_file, strerror (errno));
+    mme_app_checkpoint_exit ();
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  if ((st.st_size) && (!mme_app_checkpoint_restore ((size_t)st.st_size, checkpoint_file))) {
+    // nothing kept from the previous file
+    if (ftruncate (checkpoint.fd, 0)) {
+      OAILOG_ERROR (LOG_MME_APP, "Checkpoint: could not truncate %s: %s\n", checkpoint_file, strerror (errno));
+    }
+  }
+
+  // sparse file, the pages of the slots never used are not allocated
+  checkpoint.map_size = MME_APP_CHECKPOINT_HEADER_SIZE + (size_t)nb_slots * sizeof (mme_app_checkpoint_slot_t);
+  if (ftruncate (checkpoint.fd, checkpoint.map_size)) {
+    OAILOG_ERROR (LOG_MME_APP, "Checkpoint: could not resize %s: %s\n", checkpoint_file, strerror (errno));
+    mme_app_checkpoint_exit ();
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  checkpoint.map = mmap (NULL, checkpoint.map_size, PROT_READ | PROT_WRITE, MAP_SHARED, checkpoint.fd, 0);
+  if (MAP_FAILED == checkpoint.map) {
+    OAILOG_ERROR (LOG_MME_APP, "Checkpoint: could not map %s: %s\n", checkpoint_file, strerror (errno));
+    checkpoint.map = NULL;
+    mme_app_checkpoint_exit ();
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  header = mme_app_checkpoint_header (checkpoint.map);
+  memcpy (header->magic, MME_APP_CHECKPOINT_MAGIC, sizeof (header->magic));
+  header->version = MME_APP_CHECKPOINT_VERSION;
+  header->slot_size = sizeof (mme_app_checkpoint_slot_t);
+  header->nb_slots = nb_slots;
+
+  // lowest slots first
+  for (uint32_t index = nb_slots; index > 0; index--) {
+    if (!checkpoint.mme_round[index - 1]) {
+      checkpoint.free_slots[checkpoint.nb_free_slots++] = index - 1;
+    }
+  }
+  OAILOG_INFO (LOG_MME_APP, "Checkpoint: %u slots of %zu bytes in %s\n", nb_slots, sizeof (mme_app_checkpoint_slot_t), checkpoint_file);
+  OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_exit (void)
+{
+  if (checkpoint.map) {
+    msync (checkpoint.map, checkpoint.map_size, MS_SYNC);
+    munmap (checkpoint.map, checkpoint.map_size);
+    checkpoint.map = NULL;
+  }
+  if (0 <= checkpoint.fd) {
+    close (checkpoint.fd);
+    checkpoint.fd = -1;
+  }
+  if (checkpoint.ue_id_slot_htbl) {
+    hashtable_uint64_ts_destroy (checkpoint.ue_id_slot_htbl);
+    checkpoint.ue_id_slot_htbl = NULL;
+  }
+  free_wrapper ((void**)&checkpoint.mme_round);
+  free_wrapper ((void**)&checkpoint.emm_round);
+  free_wrapper ((void**)&checkpoint.free_slots);
+  checkpoint.nb_free_slots = 0;
+  checkpoint.pending_round = 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_checkpoint.h
+  \brief Checkpoint of the registered UEs (MME_APP UE context, PDN and bearer contexts, EMM context)
+  in a mmap'd file of fixed size slots, one per UE, and bulk restore of the UE contexts at startup.
+  A snapshot only writes the slots that changed since the previous one, the kernel writes back the
+  dirty pages.
+*/
+
+#ifndef FILE_MME_APP_CHECKPOINT_SEEN
+#define FILE_MME_APP_CHECKPOINT_SEEN
+
+#include <stdint.h>
+
+struct itti_nas_checkpoint_req_s;
+struct itti_nas_checkpoint_rsp_s;
+
+#define MME_APP_CHECKPOINT_MAGIC            "OAIMMECP"
+#define MME_APP_CHECKPOINT_VERSION          2
+
+#define MME_APP_CHECKPOINT_TIMER_DEFAULT    10      /*!< \brief seconds between two snapshots */
+#define MME_APP_CHECKPOINT_HEADER_SIZE      4096    /*!< \brief the slots start on a page boundary */
+
+/*! \struct  mme_app_checkpoint_file_header_t
+* \brief Header of a checkpoint file. A checkpoint is only restored by a build with the same slot layout.
+*/
+typedef struct mme_app_checkpoint_file_header_s {
+  char         magic[8];
+  uint32_t     version;
+  uint32_t     slot_size;             /*!< \brief sizeof of a slot */
+  uint32_t     nb_slots;
+  uint32_t     nb_ues;                /*!< \brief UEs in the last snapshot */
+  int64_t      snapshot_time_sec;     /*!< \brief Time of the last snapshot */
+} mme_app_checkpoint_file_header_t;
+
+/*! \fn int mme_app_checkpoint_init(const char * const checkpoint_file, const uint32_t nb_slots)
+ * \brief Restore the UEs of an existing checkpoint file, then keep it for the next snapshots.
+ * Called by mme_app_init() once the MME_APP and EMM collections are created, before the MME_APP task runs.
+ * The restored UEs are ECM-IDLE, they reconnect with a service request or a TAU.
+ * \param[in] checkpoint_file Path of the file, created if it does not exist.
+ * \param[in] nb_slots Max number of UEs in the file.
+ * \return 0 on success, -1 otherwise.
+ */
+int mme_app_checkpoint_init(const char * const checkpoint_file, const uint32_t nb_slots);
+
+/*! \fn void mme_app_checkpoint_snapshot(void)
+ * \brief Update the MME_APP part of the slots of the registered UEs, release the slots of the UEs
+ * gone since the previous snapshot and ask the NAS EMM task for the EMM parts.
+ * Called by the MME_APP task on the checkpoint timer.
+ */
+void mme_app_checkpoint_snapshot(void);
+
+/*! \fn void mme_app_checkpoint_emm_snapshot(const struct itti_nas_checkpoint_req_s * const checkpoint_req)
+ * \brief Copy the EMM part of the registered UEs and send it to the MME_APP task in NAS_CHECKPOINT_RSP.
+ * Called by the NAS EMM task, the owner of the EMM contexts, on NAS_CHECKPOINT_REQ.
+ */
+void mme_app_checkpoint_emm_snapshot(const struct itti_nas_checkpoint_req_s * const checkpoint_req);
+
+/*! \fn void mme_app_checkpoint_handle_emm_snapshot(const struct itti_nas_checkpoint_rsp_s * const checkpoint_rsp)
+ * \brief Update the EMM part of the slots and complete the snapshot. Called by the MME_APP task on NAS_CHECKPOINT_RSP.
+ */
+void mme_app_checkpoint_handle_emm_snapshot(const struct itti_nas_checkpoint_rsp_s * const checkpoint_rsp);
+
+/*! \fn void mme_app_checkpoint_exit(void)
+ * \brief Write back and close the checkpoint file.
+ */
+void mme_app_checkpoint_exit(void);
+
+#endif /* FILE_MME_APP_CHECKPOINT_SEEN */
@@ -55,9 +55,12 @@
 #include "mme_app_ue_context.h"
 #include "mme_app_bearer_context.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 #include "mme_app_itti_messaging.h"
 #include "mme_app_procedures.h"
 #include "mme_app_pdn_context.h"
+#include "mme_app_idle.h"
+#include "mme_app_bulk_release.h"
 #include "s1ap_mme.h"
 #include "common_defs.h"
 #include "esm_ebr.h"
@@ -72,7 +75,7 @@
 //    struct timespec wait = {0}; // timed is useful for debug
 //    wait.tv_sec=start_time.tv_sec + 5;
 //    wait.tv_nsec=start_time.tv_usec*1000;
-//    rc = pthread_mutex_timedlock(&ue_context->recmutex, &wait);
+//    rc = pthread_mutex_timedlock(&ue_context->mutex, &wait);
 //    if (rc) {
 //      OAILOG_ERROR (LOG_MME_APP, "Cannot lock UE context mutex, err=%s\n", strerror(rc));
 //#if ASSERT_MUTEX
@@ -83,7 +86,7 @@
 //    }
 //#if DEBUG_MUTEX
 //    OAILOG_TRACE (LOG_MME_APP, "UE context mutex locked, count %d lock %d\n",
-//        ue_context->recmutex.__data.__count, ue_context->recmutex.__data.__lock);
+//        ue_context->mutex.__data.__count, ue_context->mutex.__data.__lock);
 //#endif
 //  }
 //  return rc;
@@ -92,13 +95,13 @@
 //int unlock_ue_contexts(ue_context_t * const ue_context) {
 //  int rc = RETURNerror;
 //  if (ue_context) {
-//    rc = pthread_mutex_unlock(&ue_context->recmutex);
+//    rc = pthread_mutex_unlock(&ue_context->mutex);
 //    if (rc) {
 //      OAILOG_ERROR (LOG_MME_APP, "Cannot unlock UE context mutex, err=%s\n", strerror(rc));
 //    }
 //#if DEBUG_MUTEX
 //    OAILOG_TRACE (LOG_MME_APP, "UE context mutex unlocked, count %d lock %d\n",
-//        ue_context->recmutex.__data.__count, ue_context->recmutex.__data.__lock);
+//        ue_context->mutex.__data.__count, ue_context->mutex.__data.__lock);
 //#endif
 //  }
 //  return rc;
@@ -110,20 +113,8 @@ ue_context_t *mme_create_new_ue_context (void)
 {
   ue_context_t                           *new_p = calloc (1, sizeof (ue_context_t));
   // todo: if MME_APP is to be locked,
-  pthread_mutexattr_t mutexattr = {0};
-  int rc = pthread_mutexattr_init(&mutexattr);
-  if (rc) {
-    OAILOG_ERROR (LOG_MME_APP, "Cannot create UE context, failed to init mutex attribute: %s\n", strerror(rc));
-    free_wrapper(&new_p);
-    return NULL;
-  }
-  rc = pthread_mutexattr_settype(&mutexattr, PTHREAD_MUTEX_RECURSIVE);
-  if (rc) {
-    OAILOG_ERROR (LOG_MME_APP, "Cannot create UE context, failed to set mutex attribute type: %s\n", strerror(rc));
-    free_wrapper(&new_p);
-    return NULL;
-  }
-  rc = pthread_mutex_init(&new_p->recmutex, &mutexattr);
+  // the UE context is never locked recursively, a plain mutex is enough
+  int rc = pthread_mutex_init(&new_p->mutex, NULL);
   if (rc) {
     OAILOG_ERROR (LOG_MME_APP, "Cannot create UE context, failed to init mutex: %s\n", strerror(rc));
     free_wrapper(&new_p);
@@ -152,18 +143,10 @@ ue_context_t *mme_create_new_ue_context (void)
 //  new_p->ue_radio_cap_length = 0;
   new_p->s1_ue_context_release_cause = S1AP_INVALID_CAUSE;
   RB_INIT(&new_p->pdn_contexts);
-
   /*
-   * Get 11 new bearers from the bearer pool.
-   * They might or might not be pre-allocated.
+   * No bearer context is allocated here, they are allocated on demand in the EBI
+   * slots (calloc'ed to NULL) when the PDN contexts and dedicated bearers are created.
    */
-  for(uint8_t ebi = 5; ebi < 5 + MAX_NUM_BEARERS_UE -1; ebi++) {
-    /** Insert 11 new bearers. */
-    bearer_context_t * bearer_ctx_p = mme_app_new_bearer();
-    DevAssert (bearer_ctx_p != NULL);
-    bearer_ctx_p->ebi = ebi;
-    RB_INSERT (BearerPool, &(new_p->bearer_pool), bearer_ctx_p);
-  }
   return new_p;
 }
 
@@ -249,47 +232,21 @@ void mme_app_ue_context_free_content (ue_context_t * const ue_context)
 
   DevAssert(RB_EMPTY(&ue_context->pdn_contexts));
 
-  if(!RB_EMPTY(&ue_context->bearer_pool)){
-    /** Assert that 10 Bearers exist. Put them all back to the pool. */
-    for (int i = 0; i < BEARERS_PER_UE - 1; i++) {
-      bearer_context_t * bearer_context = RB_MAX(BearerPool, &ue_context->bearer_pool);
-      if(bearer_context){
-        OAILOG_DEBUG(LOG_MME_APP, "Putting bearer context %p with ebi %d (i=%d) of UE "MME_UE_S1AP_ID_FMT ". \n",
-            bearer_context, bearer_context->ebi, i, ue_context->mme_ue_s1ap_id);
-        DevAssert(bearer_context);
-        /** Remove from the UE list. */
-        bearer_context = RB_REMOVE(BearerPool, &ue_context->bearer_pool, bearer_context);
-        DevAssert(bearer_context);
-        mme_app_free_bearer_context(&bearer_context);
-      } else{
-        OAILOG_DEBUG(LOG_MME_APP, "Could not find MAX bearer context for (i=%d) of UE "MME_UE_S1AP_ID_FMT ". Removing all. \n",
-            i, ue_context->mme_ue_s1ap_id);
-        break;
-      }
-    }
-    while(!RB_EMPTY(&ue_context->bearer_pool)){
-      bearer_context_t * bearer_context = NULL;
-      RB_FOREACH (bearer_context, BearerPool, &ue_context->bearer_pool) {
-        if(bearer_context)
-          break;
-      }
-      if(bearer_context){
-        OAILOG_ERROR(LOG_MME_APP, "Putting bearer context %p with ebi %d of UE "MME_UE_S1AP_ID_FMT " (second try). \n",
-            bearer_context, bearer_context->ebi, ue_context->mme_ue_s1ap_id);
-        DevAssert(bearer_context);
-        /** Remove from the UE list. */
-        bearer_context = RB_REMOVE(BearerPool, &ue_context->bearer_pool, bearer_context);
-        DevAssert(bearer_context);
-        mme_app_free_bearer_context(&bearer_context);
-      }else {
-        DevAssert(RB_EMPTY(&ue_context->bearer_pool));
-      }
+  /** A UE released while compacted only has its idle record. */
+  mme_app_idle_ue_free(ue_context);
+
+  /** Release any bearer context left in the EBI slots. */
+  for (int i = 0; i < MAX_NUM_BEARERS_UE; i++) {
+    if (ue_context->bearer_contexts[i]) {
+      OAILOG_WARNING(LOG_MME_APP, "Releasing remaining bearer context %p with ebi %d of UE "MME_UE_S1AP_ID_FMT ". \n",
+          ue_context->bearer_contexts[i], ue_context->bearer_contexts[i]->ebi, ue_context->mme_ue_s1ap_id);
+      bearer_context_t * bearer_context = ue_context->bearer_contexts[i];
+      mme_app_release_ue_bearer_context(ue_context, &bearer_context);
     }
-    OAILOG_DEBUG(LOG_MME_APP, "All bearers removed of UE "MME_UE_S1AP_ID_FMT ". \n", ue_context->mme_ue_s1ap_id);
-    RB_INIT(&ue_context->bearer_pool);
   }
 
   // todo: unlock?
+  pthread_mutex_destroy(&ue_context->mutex);
   memset(ue_context, 0, sizeof(*ue_context));
 }
 
@@ -338,6 +295,10 @@ mme_ue_context_exists_mme_ue_s1ap_id (
 
   hashtable_ts_get (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)mme_ue_s1ap_id, (void **)&ue_context);
   if (ue_context) {
+    if ((ue_context->idle_ue) && (TASK_MME_APP == itti_get_current_task_id ())) {
+      // the PDN and bearer contexts of a compacted UE are rebuilt by their owner before it is used
+      mme_app_idle_ue_expand (ue_context);
+    }
 //    lock_ue_contexts(ue_context);
 //    OAILOG_TRACE (LOG_MME_APP, "UE  " MME_UE_S1AP_ID_FMT " fetched MM state %s, ECM state %s\n ",mme_ue_s1ap_id,
 //        (ue_context->mm_state == UE_UNREGISTERED) ? "UE_UNREGISTERED":(ue_context->mm_state == UE_REGISTERED) ? "UE_REGISTERED":"UNKNOWN",
@@ -1478,6 +1439,12 @@ mme_app_handle_s1ap_ue_context_release_complete (
         s1ap_ue_context_release_complete->enb_ue_s1ap_id, s1ap_ue_context_release_complete->mme_ue_s1ap_id);
     OAILOG_FUNC_OUT (LOG_MME_APP);
   }
+  if ((ue_context->ecm_state == ECM_IDLE) && (ue_context->mm_state == UE_REGISTERED)
+      && (ue_context->s1_bulk_released) && (!ue_context->s10_procedures)) {
+    /** Already moved to ECM-IDLE when the eNB was reset or lost, S1AP only removed its UE reference. */
+    OAILOG_DEBUG(LOG_MME_APP, "UE context release complete for UE " MME_UE_S1AP_ID_FMT " already in ECM-IDLE. \n", ue_context->mme_ue_s1ap_id);
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
 
   /*
    * Check if there is a handover procedure ongoing.
@@ -1695,6 +1662,9 @@ void mme_ue_context_update_ue_sig_connection_state (
       }
     }
     if (ue_context->ecm_state == ECM_CONNECTED) {
+      struct timespec ts;
+      clock_gettime (CLOCK_MONOTONIC, &ts);
+      ue_context->ecm_idle_sec    = ts.tv_sec;
       ue_context->ecm_state       = ECM_IDLE;
       // Update Stats
       update_mme_app_stats_connected_ue_sub();
@@ -1703,6 +1673,7 @@ void mme_ue_context_update_ue_sig_connection_state (
   }else if ((ue_context->ecm_state == ECM_IDLE) && (new_ecm_state == ECM_CONNECTED))
   {
     ue_context->ecm_state = ECM_CONNECTED;
+    ue_context->s1_bulk_released = false;
 
     OAILOG_DEBUG (LOG_MME_APP, "MME_APP: UE Connection State changed to CONNECTED.enb_ue_s1ap_id = %d, mme_ue_s1ap_id = %d\n", ue_context->enb_ue_s1ap_id, ue_context->mme_ue_s1ap_id);
 
@@ -1811,13 +1782,31 @@ mme_app_handle_s1ap_ue_context_release_req (
 //}
 
 
+//------------------------------------------------------------------------------
+static bool
+_mme_app_bulk_release_ue (const mme_ue_s1ap_id_t mme_ue_s1ap_id, const enb_ue_s1ap_id_t enb_ue_s1ap_id, const uint32_t enb_id)
+{
+  struct ue_context_s                    *ue_context = NULL;
+
+  ue_context = mme_ue_context_exists_mme_ue_s1ap_id(&mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
+  return ((ue_context) && (mme_app_bulk_release_ue(ue_context, enb_ue_s1ap_id, enb_id)));
+}
+
 //------------------------------------------------------------------------------
 void mme_app_handle_s1ap_enb_deregistered_ind (const itti_s1ap_eNB_deregistered_ind_t * const enb_dereg_ind)
 {
+  int                                     nb_bulk_released = 0;
+
   for (int ue_idx = 0; ue_idx < enb_dereg_ind->nb_ue_to_deregister; ue_idx++) {
-      mme_app_send_nas_signalling_connection_rel_ind(enb_dereg_ind->mme_ue_s1ap_id[ue_idx]); /**< If any procedures were ongoing, kill them. */
-      _mme_app_handle_s1ap_ue_context_release(enb_dereg_ind->mme_ue_s1ap_id[ue_idx], enb_dereg_ind->enb_ue_s1ap_id[ue_idx], enb_dereg_ind->enb_id, S1AP_SCTP_SHUTDOWN_OR_RESET);
+    /** The registered UEs with no procedure running are moved to ECM-IDLE here, their S11 releases are rate limited. */
+    if (_mme_app_bulk_release_ue(enb_dereg_ind->mme_ue_s1ap_id[ue_idx], enb_dereg_ind->enb_ue_s1ap_id[ue_idx], enb_dereg_ind->enb_id)) {
+      nb_bulk_released++;
+      continue;
+    }
+    mme_app_send_nas_signalling_connection_rel_ind(enb_dereg_ind->mme_ue_s1ap_id[ue_idx]); /**< If any procedures were ongoing, kill them. */
+    _mme_app_handle_s1ap_ue_context_release(enb_dereg_ind->mme_ue_s1ap_id[ue_idx], enb_dereg_ind->enb_ue_s1ap_id[ue_idx], enb_dereg_ind->enb_id, S1AP_SCTP_SHUTDOWN_OR_RESET);
   }
+  OAILOG_DEBUG (LOG_MME_APP, "eNB %d deregistered: %d UEs bulk released out of %d\n", enb_dereg_ind->enb_id, nb_bulk_released, enb_dereg_ind->nb_ue_to_deregister);
 }
 
 //------------------------------------------------------------------------------
@@ -1831,6 +1820,10 @@ mme_app_handle_enb_reset_req (const itti_s1ap_enb_initiated_reset_req_t * const
   if (enb_reset_req->s1ap_reset_type == RESET_ALL) {
   // Full Reset. Trigger UE Context release release for all the connected UEs.
     for (int i = 0; i < enb_reset_req->num_ue; i++) {
+      if (_mme_app_bulk_release_ue(*(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
+                                   *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id),
+                                   enb_reset_req->enb_id))
+        continue;
       _mme_app_handle_s1ap_ue_context_release(*(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
                                             *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id),
                                             enb_reset_req->enb_id,
@@ -1842,6 +1835,10 @@ mme_app_handle_enb_reset_req (const itti_s1ap_enb_initiated_reset_req_t * const
       if (enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id == NULL &&
                           enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id == NULL)
         continue;
+      else if (_mme_app_bulk_release_ue(*(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
+                                        *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id),
+                                        enb_reset_req->enb_id))
+        continue;
       else
         _mme_app_handle_s1ap_ue_context_release(*(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
                                             *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id),
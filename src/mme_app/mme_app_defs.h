@@ -44,37 +44,14 @@ typedef struct mme_app_desc_s {
   long statistic_timer_id;
   uint32_t statistic_timer_period;
 
+  long checkpoint_timer_id;
+  long idle_compaction_timer_id;
+  long bulk_release_timer_id;
+
 
   uint32_t mme_mobility_management_timer_period;
 
-  /* Reader/writer lock */
-  pthread_rwlock_t rw_lock;
-
-
-  /* ***************Statistics*************
-   * number of attached UE,number of connected UE,
-   * number of idle UE,number of default bearers,
-   * number of S1_U bearers,number of PDN sessions
-   */
-
-  uint32_t               nb_enb_connected;
-  uint32_t               nb_ue_attached;
-  uint32_t               nb_ue_connected;
-  uint32_t               nb_default_eps_bearers;
-  uint32_t               nb_s1u_bearers;
-
-  /* ***************Changes in Statistics**************/
-
-  uint32_t               nb_ue_attached_since_last_stat;
-  uint32_t               nb_ue_detached_since_last_stat;
-  uint32_t               nb_ue_connected_since_last_stat;
-  uint32_t               nb_ue_disconnected_since_last_stat;
-  uint32_t               nb_eps_bearers_established_since_last_stat;
-  uint32_t               nb_eps_bearers_released_since_last_stat;
-  uint32_t               nb_enb_connected_since_last_stat;
-  uint32_t               nb_enb_released_since_last_stat;
-  uint32_t               nb_s1u_bearers_released_since_last_stat;
-  uint32_t               nb_s1u_bearers_established_since_last_stat;
+  /* Statistics are kept in per-thread counters, see mme_app_statistics.h */
 } mme_app_desc_t;
 
 extern mme_app_desc_t mme_app_desc;
@@ -206,8 +183,4 @@ void mme_app_handle_s10_context_acknowledge( const itti_s10_context_acknowledge_
 
 void mme_app_handle_downlink_data_notification (const itti_s11_downlink_data_notification_t * const saegw_dl_data_ntf_pP);
 
-#define mme_stats_read_lock(mMEsTATS)  pthread_rwlock_rdlock(&(mMEsTATS)->rw_lock)
-#define mme_stats_write_lock(mMEsTATS) pthread_rwlock_wrlock(&(mMEsTATS)->rw_lock)
-#define mme_stats_unlock(mMEsTATS)     pthread_rwlock_unlock(&(mMEsTATS)->rw_lock)
-
 #endif /* MME_APP_DEFS_H_ */
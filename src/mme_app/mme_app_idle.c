@@ -0,0 +1,656 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_idle.c
+  \brief Compaction of the ECM-IDLE UEs into idle records and expansion on their next lookup.
+  The MME_APP task selects the UEs, the NAS EMM task hangs the idle records and drops the EMM contexts
+  into them, then the MME_APP task moves the PDN and bearer contexts into them. The PDN and bearer contexts
+  are only rebuilt by the MME_APP task, the EMM context is rebuilt by the first EMM lookup, which
+  only creates it. The idle record of a UE context is hung, taken and freed under one lock.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "assertions.h"
+#include "common_defs.h"
+#include "conversions.h"
+#include "intertask_interface.h"
+#include "mme_api.h"
+#include "emm_data.h"
+#include "emm_cause.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "mme_app_bearer_context.h"
+#include "mme_app_statistics.h"
+#include "mme_app_idle.h"
+
+/* EMM context members that prevent the compaction, a procedure is still using them */
+#define MME_APP_IDLE_EMM_MEMBERS_BUSY   (EMM_CTXT_MEMBER_OLD_GUTI | EMM_CTXT_MEMBER_NON_CURRENT_SECURITY | EMM_CTXT_MEMBER_PENDING_DRX_PARAMETER)
+
+/* PDN connection with its default bearer, the UEs with dedicated bearers are not compacted */
+typedef struct mme_app_idle_pdn_s {
+  fteid_t                     s_gw_fteid_s1u;
+  fteid_t                     p_gw_fteid_s5_s8_up;
+  bearer_qos_t                bearer_level_qos;
+  paa_t                       paa;
+  ip_address_t                p_gw_address_s5_s8_cp;
+  ip_address_t                s_gw_address_s11_s4;
+  ambr_t                      subscribed_apn_ambr;
+  bstring                     apn_in_use;             /* taken from the PDN context, not copied */
+  bstring                     apn_subscribed;
+  bstring                     apn_oi_replacement;
+  context_identifier_t        context_identifier;
+  teid_t                      p_gw_teid_s5_s8_cp;
+  teid_t                      s_gw_teid_s11_s4;
+  ebi_t                       default_ebi;
+  uint8_t                     pdn_type;
+  mme_app_bearer_state_t      bearer_state;
+  uint8_t                     esm_ebr_state;
+  bool                        paa_present;
+} mme_app_idle_pdn_t;
+
+typedef struct mme_app_idle_ue_s {
+  /* EMM context, the TAI list is kept if it is a single partial list */
+  imsi_t                      imsi;
+  imei_t                      imei;
+  imeisv_t                    imeisv;
+  guti_t                      guti;
+  tai_t                       lvr_tai;
+  tai_t                       originating_tai;
+  partial_tai_list_t          partial_tai_list;
+  ue_network_capability_t     ue_network_capability;
+  ms_network_capability_t     ms_network_capability;
+  drx_parameter_t             drx_parameter;
+  drx_parameter_t             current_drx_parameter;
+  uint32_t                    member_present_mask;
+  uint32_t                    member_valid_mask;
+  /* Current EPS security context and the authentication vectors, the key schedules are set up again on first use */
+  auth_vector_t               vector[MAX_EPS_AUTH_VECTORS];
+  count_t                     dl_count;
+  count_t                     ul_count;
+  uint8_t                     nh_conj[AUTH_NH_SIZE];
+  uint8_t                     knas_enc[AUTH_KNAS_ENC_SIZE];
+  uint8_t                     knas_int[AUTH_KNAS_INT_SIZE];
+  int8_t                      vector_index;
+  uint8_t                     remaining_vectors;
+  uint8_t                     sc_type;
+  ksi_t                       eksi;
+  uint8_t                     ncc;
+  uint8_t                     selected_encryption;
+  uint8_t                     selected_integrity;
+  uint8_t                     eps_encryption;
+  uint8_t                     eps_integrity;
+  uint8_t                     umts_encryption;
+  uint8_t                     umts_integrity;
+  uint8_t                     gprs_encryption;
+  bool                        umts_present;
+  bool                        gprs_present;
+  uint8_t                     activated;
+  uint8_t                     direction_encode;
+  uint8_t                     direction_decode;
+  ksi_t                       ksi;
+  uint8_t                     attach_type;
+  uint8_t                     additional_update_type;
+  bool                        tai_list_present;
+  bool                        is_emergency;
+  bool                        is_has_been_attached;
+  bool                        is_initial_identity_imsi;
+  bool                        is_guti_based_attach;
+  /* PDN connections */
+  uint8_t                     nb_pdns;
+  mme_app_idle_pdn_t          pdns[MME_APP_IDLE_UE_MAX_PDNS];
+  /* parts not rebuilt yet, the record is freed once both are */
+  bool                        emm_present;
+  bool                        pdns_present;
+} mme_app_idle_ue_t;
+
+/* UEs selected by the MME_APP task for NAS_IDLE_COMPACT_REQ */
+typedef struct mme_app_idle_selection_s {
+  mme_ue_s1ap_id_t           *ue_ids;
+  uint32_t                    nb_ues;
+  uint32_t                    nb_ues_max;
+  time_t                      idle_since_sec;
+} mme_app_idle_selection_t;
+
+static pthread_mutex_t                    mme_app_idle_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t                           mme_app_idle_nb_compacted = 0;
+
+//------------------------------------------------------------------------------
+static time_t mme_app_idle_now_sec (void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+//------------------------------------------------------------------------------
+uint32_t mme_app_idle_nb_ues (void)
+{
+  return __atomic_load_n (&mme_app_idle_nb_compacted, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_idle_ue_is_compactable (const ue_context_t * const ue_context, const time_t idle_since_sec)
+{
+  pdn_context_t                          *pdn_context = NULL;
+  bearer_context_t                       *bearer_context = NULL;
+  int                                     nb_pdns = 0;
+
+  if ((UE_REGISTERED != ue_context->mm_state) || (ECM_IDLE != ue_context->ecm_state) || (ue_context->ecm_idle_sec > idle_since_sec)
+      || (ue_context->s10_procedures) || (ue_context->s11_procedures)
+      || (ue_context->esm_procedures.pdn_connectivity_procedures) || (ue_context->esm_procedures.bearer_context_procedures)
+      || (MME_APP_TIMER_INACTIVE_ID != ue_context->initial_context_setup_rsp_timer.id)) {
+    return false;
+  }
+  RB_FOREACH (pdn_context, PdnContexts, (struct PdnContexts *)&ue_context->pdn_contexts) {
+    if ((MME_APP_IDLE_UE_MAX_PDNS <= nb_pdns++) || (pdn_context->pco)) {
+      return false;
+    }
+    bearer_context = RB_MIN (SessionBearers, &pdn_context->session_bearers);
+    if ((!bearer_context) || (bearer_context->ebi != pdn_context->default_ebi) || (bearer_context->esm_ebr_context.tft)
+        || (RB_NEXT (SessionBearers, &pdn_context->session_bearers, bearer_context))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_idle_emm_is_compactable (const emm_data_context_t * const emm_context)
+{
+  return ((emm_context) && (emm_context->is_dynamic) && (EMM_REGISTERED == emm_context->_emm_fsm_state) && (!emm_context->emm_procedures)
+      && (1 >= emm_context->_tai_list.numberoflists) && (!(emm_context->member_present_mask & MME_APP_IDLE_EMM_MEMBERS_BUSY)));
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_idle_write_emm (mme_app_idle_ue_t * const idle_ue, const emm_data_context_t * const emm_context)
+{
+  const emm_security_context_t * const    security = &emm_context->_security;
+
+  idle_ue->imsi                     = emm_context->_imsi;
+  idle_ue->imei                     = emm_context->_imei;
+  idle_ue->imeisv                   = emm_context->_imeisv;
+  idle_ue->guti                     = emm_context->_guti;
+  idle_ue->lvr_tai                  = emm_context->_lvr_tai;
+  idle_ue->originating_tai          = emm_context->originating_tai;
+  idle_ue->tai_list_present         = (0 < emm_context->_tai_list.numberoflists);
+  if (idle_ue->tai_list_present) {
+    idle_ue->partial_tai_list       = emm_context->_tai_list.partial_tai_list[0];
+  }
+  idle_ue->ue_network_capability    = emm_context->_ue_network_capability;
+  idle_ue->ms_network_capability    = emm_context->_ms_network_capability;
+  idle_ue->drx_parameter            = emm_context->_drx_parameter;
+  idle_ue->current_drx_parameter    = emm_context->_current_drx_parameter;
+  idle_ue->ksi                      = emm_context->ksi;
+  idle_ue->attach_type              = emm_context->attach_type;
+  idle_ue->additional_update_type   = (uint8_t)emm_context->additional_update_type;
+  idle_ue->is_emergency             = emm_context->is_emergency;
+  idle_ue->is_has_been_attached     = emm_context->is_has_been_attached;
+  idle_ue->is_initial_identity_imsi = emm_context->is_initial_identity_imsi;
+  idle_ue->is_guti_based_attach     = emm_context->is_guti_based_attach;
+
+  idle_ue->member_present_mask      = emm_context->member_present_mask;
+  idle_ue->member_valid_mask        = emm_context->member_valid_mask;
+
+  memcpy (idle_ue->vector, emm_context->_vector, sizeof (idle_ue->vector));
+  idle_ue->remaining_vectors        = (uint8_t)emm_context->remaining_vectors;
+  idle_ue->vector_index             = (int8_t)security->vector_index;
+  idle_ue->sc_type                  = (uint8_t)security->sc_type;
+  idle_ue->eksi                     = security->eksi;
+  idle_ue->ncc                      = security->ncc;
+  memcpy (idle_ue->nh_conj, security->nh_conj, sizeof (idle_ue->nh_conj));
+  memcpy (idle_ue->knas_enc, security->knas_enc, sizeof (idle_ue->knas_enc));
+  memcpy (idle_ue->knas_int, security->knas_int, sizeof (idle_ue->knas_int));
+  idle_ue->dl_count                 = security->dl_count;
+  idle_ue->ul_count                 = security->ul_count;
+  idle_ue->eps_encryption           = security->capability.eps_encryption;
+  idle_ue->eps_integrity            = security->capability.eps_integrity;
+  idle_ue->umts_encryption          = security->capability.umts_encryption;
+  idle_ue->umts_integrity           = security->capability.umts_integrity;
+  idle_ue->gprs_encryption          = security->capability.gprs_encryption;
+  idle_ue->umts_present             = security->capability.umts_present;
+  idle_ue->gprs_present             = security->capability.gprs_present;
+  idle_ue->selected_encryption      = security->selected_algorithms.encryption;
+  idle_ue->selected_integrity       = security->selected_algorithms.integrity;
+  idle_ue->activated                = security->activated;
+  idle_ue->direction_encode         = security->direction_encode;
+  idle_ue->direction_decode         = security->direction_decode;
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_idle_read_emm (emm_data_context_t * const emm_context, const mme_app_idle_ue_t * const idle_ue)
+{
+  emm_security_context_t * const          security = &emm_context->_security;
+
+  emm_context->_imsi                    = idle_ue->imsi;
+  emm_context->_imsi64                  = imsi_to_imsi64 ((imsi_t *)&idle_ue->imsi);
+  emm_context->_imei                    = idle_ue->imei;
+  emm_context->_imeisv                  = idle_ue->imeisv;
+  emm_context->_guti                    = idle_ue->guti;
+  emm_context->_lvr_tai                 = idle_ue->lvr_tai;
+  emm_context->originating_tai          = idle_ue->originating_tai;
+  if (idle_ue->tai_list_present) {
+    emm_context->_tai_list.numberoflists = 1;
+    emm_context->_tai_list.partial_tai_list[0] = idle_ue->partial_tai_list;
+  }
+  emm_context->_ue_network_capability   = idle_ue->ue_network_capability;
+  emm_context->_ms_network_capability   = idle_ue->ms_network_capability;
+  emm_context->_drx_parameter           = idle_ue->drx_parameter;
+  emm_context->_current_drx_parameter   = idle_ue->current_drx_parameter;
+  emm_context->ksi                      = idle_ue->ksi;
+  emm_context->attach_type              = idle_ue->attach_type;
+  emm_context->additional_update_type   = (additional_update_type_t)idle_ue->additional_update_type;
+  emm_context->is_emergency             = idle_ue->is_emergency;
+  emm_context->is_has_been_attached     = idle_ue->is_has_been_attached;
+  emm_context->is_initial_identity_imsi = idle_ue->is_initial_identity_imsi;
+  emm_context->is_guti_based_attach     = idle_ue->is_guti_based_attach;
+  emm_context->member_present_mask      = idle_ue->member_present_mask;
+  emm_context->member_valid_mask        = idle_ue->member_valid_mask;
+
+  memcpy (emm_context->_vector, idle_ue->vector, sizeof (emm_context->_vector));
+  emm_context->remaining_vectors        = idle_ue->remaining_vectors;
+  security->vector_index                = idle_ue->vector_index;
+  security->sc_type                     = (emm_sc_type_t)idle_ue->sc_type;
+  security->eksi                        = idle_ue->eksi;
+  security->ncc                         = idle_ue->ncc;
+  memcpy (security->nh_conj, idle_ue->nh_conj, sizeof (security->nh_conj));
+  memcpy (security->knas_enc, idle_ue->knas_enc, sizeof (security->knas_enc));
+  memcpy (security->knas_int, idle_ue->knas_int, sizeof (security->knas_int));
+  security->dl_count                    = idle_ue->dl_count;
+  security->ul_count                    = idle_ue->ul_count;
+  security->capability.eps_encryption   = idle_ue->eps_encryption;
+  security->capability.eps_integrity    = idle_ue->eps_integrity;
+  security->capability.umts_encryption  = idle_ue->umts_encryption;
+  security->capability.umts_integrity   = idle_ue->umts_integrity;
+  security->capability.gprs_encryption  = idle_ue->gprs_encryption;
+  security->capability.umts_present     = idle_ue->umts_present;
+  security->capability.gprs_present     = idle_ue->gprs_present;
+  security->selected_algorithms.encryption = idle_ue->selected_encryption;
+  security->selected_algorithms.integrity  = idle_ue->selected_integrity;
+  security->activated                   = idle_ue->activated;
+  security->direction_encode            = idle_ue->direction_encode;
+  security->direction_decode            = idle_ue->direction_decode;
+  emm_context->emm_cause                = EMM_CAUSE_SUCCESS;
+  emm_context->_emm_fsm_state           = EMM_REGISTERED;
+}
+
+//------------------------------------------------------------------------------
+// move the PDN and bearer contexts of the UE into its idle record
+static void mme_app_idle_write_pdns (mme_app_idle_ue_t * const idle_ue, ue_context_t * const ue_context)
+{
+  pdn_context_t                          *pdn_context = NULL;
+  bearer_context_t                       *bearer_context = NULL;
+
+  while ((pdn_context = RB_MIN (PdnContexts, &ue_context->pdn_contexts))) {
+    mme_app_idle_pdn_t * const pdn = &idle_ue->pdns[idle_ue->nb_pdns++];
+
+    RB_REMOVE (PdnContexts, &ue_context->pdn_contexts, pdn_context);
+    pdn->context_identifier    = pdn_context->context_identifier;
+    pdn->pdn_type              = (uint8_t)pdn_context->pdn_type;
+    pdn->default_ebi           = pdn_context->default_ebi;
+    if (pdn_context->paa) {
+      pdn->paa_present         = true;
+      pdn->paa                 = *pdn_context->paa;
+      free_wrapper ((void**)&pdn_context->paa);
+    }
+    pdn->p_gw_address_s5_s8_cp = pdn_context->p_gw_address_s5_s8_cp;
+    pdn->p_gw_teid_s5_s8_cp    = pdn_context->p_gw_teid_s5_s8_cp;
+    pdn->s_gw_address_s11_s4   = pdn_context->s_gw_address_s11_s4;
+    pdn->s_gw_teid_s11_s4      = pdn_context->s_gw_teid_s11_s4;
+    pdn->subscribed_apn_ambr   = pdn_context->subscribed_apn_ambr;
+    pdn->apn_in_use            = pdn_context->apn_in_use;
+    pdn->apn_subscribed        = pdn_context->apn_subscribed;
+    pdn->apn_oi_replacement    = pdn_context->apn_oi_replacement;
+
+    bearer_context = RB_MIN (SessionBearers, &pdn_context->session_bearers);
+    RB_REMOVE (SessionBearers, &pdn_context->session_bearers, bearer_context);
+    pdn->bearer_state          = bearer_context->bearer_state;
+    pdn->esm_ebr_state         = (uint8_t)bearer_context->esm_ebr_context.status;
+    pdn->s_gw_fteid_s1u        = bearer_context->s_gw_fteid_s1u;
+    pdn->p_gw_fteid_s5_s8_up   = bearer_context->p_gw_fteid_s5_s8_up;
+    pdn->bearer_level_qos      = bearer_context->bearer_level_qos;
+    mme_app_release_ue_bearer_context (ue_context, &bearer_context);
+    free_wrapper ((void**)&pdn_context);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_idle_read_pdns (ue_context_t * const ue_context, mme_app_idle_ue_t * const idle_ue)
+{
+  for (int i = 0; i < idle_ue->nb_pdns; i++) {
+    mme_app_idle_pdn_t * const            pdn = &idle_ue->pdns[i];
+    pdn_context_t * const                 pdn_context = calloc (1, sizeof (pdn_context_t));
+    bearer_context_t                     *bearer_context = NULL;
+
+    DevAssert (pdn_context);
+    pdn_context->context_identifier    = pdn->context_identifier;
+    pdn_context->pdn_type              = (pdn_type_t)pdn->pdn_type;
+    pdn_context->default_ebi           = pdn->default_ebi;
+    if (pdn->paa_present) {
+      pdn_context->paa                 = calloc (1, sizeof (paa_t));
+      DevAssert (pdn_context->paa);
+      *pdn_context->paa                = pdn->paa;
+    }
+    pdn_context->p_gw_address_s5_s8_cp = pdn->p_gw_address_s5_s8_cp;
+    pdn_context->p_gw_teid_s5_s8_cp    = pdn->p_gw_teid_s5_s8_cp;
+    pdn_context->s_gw_address_s11_s4   = pdn->s_gw_address_s11_s4;
+    pdn_context->s_gw_teid_s11_s4      = pdn->s_gw_teid_s11_s4;
+    pdn_context->subscribed_apn_ambr   = pdn->subscribed_apn_ambr;
+    pdn_context->apn_in_use            = pdn->apn_in_use;
+    pdn_context->apn_subscribed        = pdn->apn_subscribed;
+    pdn_context->apn_oi_replacement    = pdn->apn_oi_replacement;
+    pdn->apn_in_use                    = NULL;
+    pdn->apn_subscribed                = NULL;
+    pdn->apn_oi_replacement            = NULL;
+    RB_INIT (&pdn_context->session_bearers);
+    RB_INSERT (PdnContexts, &ue_context->pdn_contexts, pdn_context);
+
+    // the EBI was freed by the compaction, nothing else allocated it since
+    bearer_context = mme_app_new_ue_bearer_context (ue_context, pdn->default_ebi);
+    DevAssert (bearer_context);
+    bearer_context->linked_ebi             = pdn->default_ebi;
+    bearer_context->pdn_cx_id              = pdn->context_identifier;
+    bearer_context->bearer_state           = pdn->bearer_state;
+    bearer_context->esm_ebr_context.status = (esm_ebr_state)pdn->esm_ebr_state;
+    bearer_context->s_gw_fteid_s1u         = pdn->s_gw_fteid_s1u;
+    bearer_context->p_gw_fteid_s5_s8_up    = pdn->p_gw_fteid_s5_s8_up;
+    bearer_context->bearer_level_qos       = pdn->bearer_level_qos;
+    RB_INSERT (SessionBearers, &pdn_context->session_bearers, bearer_context);
+  }
+  idle_ue->nb_pdns = 0;
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_idle_select_ue_cb (const hash_key_t keyP, void * const ue_context_p, void *selection_p, void **unused_result_pP)
+{
+  const ue_context_t * const              ue_context = (const ue_context_t *)ue_context_p;
+  mme_app_idle_selection_t * const        selection = (mme_app_idle_selection_t *)selection_p;
+
+  if ((!ue_context) || (ue_context->idle_ue) || (!mme_app_idle_ue_is_compactable (ue_context, selection->idle_since_sec))) {
+    return false;
+  }
+  if (selection->nb_ues >= selection->nb_ues_max) {
+    // stop, the next round takes the others
+    return true;
+  }
+  selection->ue_ids[selection->nb_ues++] = ue_context->mme_ue_s1ap_id;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_idle_compact_ues (const uint32_t idle_sec)
+{
+  mme_app_idle_selection_t                selection = {.ue_ids = NULL, .nb_ues = 0, .nb_ues_max = 0};
+  MessageDef                             *message_p = NULL;
+
+  selection.idle_since_sec = mme_app_idle_now_sec () - (time_t)idle_sec;
+  selection.nb_ues_max = mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl->num_elements;
+  if (!selection.nb_ues_max) {
+    return;
+  }
+  selection.ue_ids = calloc (selection.nb_ues_max, sizeof (mme_ue_s1ap_id_t));
+  if (!selection.ue_ids) {
+    return;
+  }
+  hashtable_ts_apply_callback_on_elements (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, mme_app_idle_select_ue_cb, (void *)&selection, NULL);
+  if (!selection.nb_ues) {
+    free_wrapper ((void**)&selection.ue_ids);
+    return;
+  }
+  // the EMM contexts belong to the NAS EMM task, it drops them itself
+  message_p = itti_alloc_new_message (TASK_MME_APP, NAS_IDLE_COMPACT_REQ);
+  NAS_IDLE_COMPACT_REQ (message_p).nb_ues = selection.nb_ues;
+  NAS_IDLE_COMPACT_REQ (message_p).ue_ids_ptr = (uintptr_t)selection.ue_ids;
+  if (RETURNok != itti_send_msg_to_task (TASK_NAS_EMM, INSTANCE_DEFAULT, message_p)) {
+    OAILOG_WARNING (LOG_MME_APP, "Idle compaction: could not send the request to NAS, retried next period\n");
+    return;
+  }
+  OAILOG_DEBUG (LOG_MME_APP, "Idle compaction: %u UEs selected, %u UEs compacted\n", selection.nb_ues, mme_app_idle_nb_ues ());
+}
+
+//------------------------------------------------------------------------------
+void mme_app_idle_emm_compact (const itti_nas_idle_compact_req_t * const compact_req)
+{
+  const mme_ue_s1ap_id_t * const          ue_ids = (const mme_ue_s1ap_id_t *)compact_req->ue_ids_ptr;
+  mme_ue_s1ap_id_t                       *compacted_ue_ids = NULL;
+  uint32_t                                nb_ues = 0;
+  MessageDef                             *message_p = NULL;
+
+  if ((!ue_ids) || (!compact_req->nb_ues)) {
+    return;
+  }
+  compacted_ue_ids = calloc (compact_req->nb_ues, sizeof (mme_ue_s1ap_id_t));
+  if (!compacted_ue_ids) {
+    return;
+  }
+  for (uint32_t i = 0; i < compact_req->nb_ues; i++) {
+    emm_data_context_t                   *emm_context = NULL;
+    ue_context_t                         *ue_context = NULL;
+    mme_app_idle_ue_t                    *idle_ue = NULL;
+
+    hashtable_ts_get (_emm_data.ctx_coll_ue_id, (const hash_key_t)ue_ids[i], (void **)&emm_context);
+    hashtable_ts_get (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_ids[i], (void **)&ue_context);
+    if ((!ue_context) || (!mme_app_idle_emm_is_compactable (emm_context))) {
+      continue;
+    }
+    /*
+     * The record is hung on the UE context before the EMM context is dropped, under the lock of the
+     * EMM lookups: there is no time when a lookup finds neither of them.
+     */
+    pthread_mutex_lock (&mme_app_idle_lock);
+    idle_ue = ue_context->idle_ue;
+    if (!idle_ue) {
+      idle_ue = calloc (1, sizeof (mme_app_idle_ue_t));
+      if (!idle_ue) {
+        pthread_mutex_unlock (&mme_app_idle_lock);
+        continue;
+      }
+      ue_context->idle_ue = idle_ue;
+      __atomic_add_fetch (&mme_app_idle_nb_compacted, 1, __ATOMIC_RELAXED);
+    }
+    // else the EMM context was rebuilt before the PDN and bearer contexts, they stay in the record
+    mme_app_idle_write_emm (idle_ue, emm_context);
+    idle_ue->emm_present = true;
+    // the GUTI and IMSI of the EMM collection point into the EMM context, they go with it
+    emm_data_context_remove (&_emm_data, emm_context, false);
+    free_wrapper ((void**)&emm_context);
+    pthread_mutex_unlock (&mme_app_idle_lock);
+    compacted_ue_ids[nb_ues++] = ue_ids[i];
+  }
+
+  if (!nb_ues) {
+    free_wrapper ((void**)&compacted_ue_ids);
+    return;
+  }
+  message_p = itti_alloc_new_message (TASK_NAS_EMM, NAS_IDLE_COMPACT_RSP);
+  NAS_IDLE_COMPACT_RSP (message_p).nb_ues = nb_ues;
+  NAS_IDLE_COMPACT_RSP (message_p).ue_ids_ptr = (uintptr_t)compacted_ue_ids;
+  if (RETURNok != itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p)) {
+    // the PDN and bearer contexts are kept, the records only hold the EMM contexts
+    OAILOG_WARNING (LOG_NAS_EMM, "Idle compaction: NAS_IDLE_COMPACT_RSP dropped, %u UEs not compacted by MME_APP\n", nb_ues);
+  }
+}
+
+//------------------------------------------------------------------------------
+// ask the NAS EMM task to rebuild the EMM context of a UE, queued before anything MME_APP sends next to NAS about it
+static void mme_app_idle_send_emm_expand (const mme_ue_s1ap_id_t ue_id)
+{
+  MessageDef                             *message_p = NULL;
+
+  message_p = itti_alloc_new_message (TASK_MME_APP, NAS_IDLE_EXPAND_REQ);
+  NAS_IDLE_EXPAND_REQ (message_p).ue_id = ue_id;
+  if (RETURNok != itti_send_msg_to_task (TASK_NAS_EMM, INSTANCE_DEFAULT, message_p)) {
+    OAILOG_WARNING (LOG_MME_APP, "Idle compaction: NAS_IDLE_EXPAND_REQ dropped, the EMM context of UE " MME_UE_S1AP_ID_FMT " is rebuilt on its next lookup\n", ue_id);
+  }
+}
+
+//------------------------------------------------------------------------------
+void mme_app_idle_handle_emm_compact (const itti_nas_idle_compact_rsp_t * const compact_rsp)
+{
+  const mme_ue_s1ap_id_t * const          ue_ids = (const mme_ue_s1ap_id_t *)compact_rsp->ue_ids_ptr;
+  // still idle, for however long
+  const time_t                            idle_since_sec = mme_app_idle_now_sec ();
+
+  for (uint32_t i = 0; (ue_ids) && (i < compact_rsp->nb_ues); i++) {
+    ue_context_t                         *ue_context = NULL;
+    bool                                  compacted = false;
+    bool                                  expand_emm = false;
+
+    hashtable_ts_get (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_ids[i], (void **)&ue_context);
+    if (!ue_context) {
+      // released meanwhile, with its record
+      continue;
+    }
+    pthread_mutex_lock (&mme_app_idle_lock);
+    if ((!ue_context->idle_ue) || (ue_context->idle_ue->pdns_present)) {
+      // EMM context rebuilt meanwhile, or PDN and bearer contexts moved by a previous round
+    } else if (mme_app_idle_ue_is_compactable (ue_context, idle_since_sec)) {
+      mme_app_idle_write_pdns (ue_context->idle_ue, ue_context);
+      ue_context->idle_ue->pdns_present = true;
+      compacted = true;
+    } else {
+      // left ECM-IDLE meanwhile, nothing of MME_APP to rebuild
+      expand_emm = ue_context->idle_ue->emm_present;
+    }
+    pthread_mutex_unlock (&mme_app_idle_lock);
+
+    if (compacted) {
+      mme_stats_inc (UE_IDLE_COMPACTED);
+    } else if (expand_emm) {
+      mme_app_idle_send_emm_expand (ue_context->mme_ue_s1ap_id);
+    }
+  }
+  OAILOG_DEBUG (LOG_MME_APP, "Idle compaction: %u UEs compacted\n", mme_app_idle_nb_ues ());
+}
+
+//------------------------------------------------------------------------------
+// take the idle record of a UE context once both parts are rebuilt, called with the lock held
+static mme_app_idle_ue_t *mme_app_idle_ue_take (ue_context_t * const ue_context)
+{
+  mme_app_idle_ue_t * const               idle_ue = ue_context->idle_ue;
+
+  if ((!idle_ue) || (idle_ue->emm_present) || (idle_ue->pdns_present)) {
+    return NULL;
+  }
+  ue_context->idle_ue = NULL;
+  __atomic_sub_fetch (&mme_app_idle_nb_compacted, 1, __ATOMIC_RELAXED);
+  return idle_ue;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_idle_ue_expand (ue_context_t * const ue_context)
+{
+  mme_app_idle_ue_t                      *idle_ue = NULL;
+  bool                                    expand_emm = false;
+
+  pthread_mutex_lock (&mme_app_idle_lock);
+  if ((!ue_context->idle_ue) || (!ue_context->idle_ue->pdns_present)) {
+    // expanded meanwhile, or only the EMM context is left to NAS
+    pthread_mutex_unlock (&mme_app_idle_lock);
+    return;
+  }
+  mme_app_idle_read_pdns (ue_context, ue_context->idle_ue);
+  ue_context->idle_ue->pdns_present = false;
+  expand_emm = ue_context->idle_ue->emm_present;
+  idle_ue = mme_app_idle_ue_take (ue_context);
+  pthread_mutex_unlock (&mme_app_idle_lock);
+
+  if (idle_ue) {
+    free_wrapper ((void**)&idle_ue);
+  }
+  if (expand_emm) {
+    mme_app_idle_send_emm_expand (ue_context->mme_ue_s1ap_id);
+  }
+  mme_stats_inc (UE_IDLE_EXPANDED);
+  OAILOG_DEBUG (LOG_MME_APP, "Idle compaction: UE " MME_UE_S1AP_ID_FMT " expanded\n", ue_context->mme_ue_s1ap_id);
+}
+
+//------------------------------------------------------------------------------
+emm_data_context_t *mme_app_idle_emm_expand (const mme_ue_s1ap_id_t ue_id)
+{
+  ue_context_t                           *ue_context = NULL;
+  emm_data_context_t                     *emm_context = NULL;
+  mme_app_idle_ue_t                      *idle_ue = NULL;
+
+  // not mme_ue_context_exists_mme_ue_s1ap_id(), the PDN and bearer contexts are left to MME_APP
+  hashtable_ts_get (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_id, (void **)&ue_context);
+  if (!ue_context) {
+    return NULL;
+  }
+  pthread_mutex_lock (&mme_app_idle_lock);
+  if ((!ue_context->idle_ue) || (!ue_context->idle_ue->emm_present)) {
+    // rebuilt meanwhile by another lookup
+    pthread_mutex_unlock (&mme_app_idle_lock);
+    hashtable_ts_get (_emm_data.ctx_coll_ue_id, (const hash_key_t)ue_id, (void **)&emm_context);
+    return emm_context;
+  }
+  emm_context = calloc (1, sizeof (emm_data_context_t));
+  DevAssert (emm_context);
+  emm_context->ue_id = ue_id;
+  emm_context->is_dynamic = true;
+  emm_init_context (emm_context, true);
+  mme_app_idle_read_emm (emm_context, ue_context->idle_ue);
+  if (RETURNok != emm_data_context_add (&_emm_data, emm_context)) {
+    OAILOG_ERROR (LOG_MME_APP, "Idle compaction: could not insert the EMM context of UE " MME_UE_S1AP_ID_FMT " IMSI " IMSI_64_FMT "\n",
+        ue_id, emm_context->_imsi64);
+  }
+  ue_context->idle_ue->emm_present = false;
+  idle_ue = mme_app_idle_ue_take (ue_context);
+  pthread_mutex_unlock (&mme_app_idle_lock);
+
+  if (idle_ue) {
+    free_wrapper ((void**)&idle_ue);
+  }
+  return emm_context;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_idle_ue_free (ue_context_t * const ue_context)
+{
+  mme_app_idle_ue_t                      *idle_ue = NULL;
+
+  pthread_mutex_lock (&mme_app_idle_lock);
+  idle_ue = ue_context->idle_ue;
+  if (idle_ue) {
+    ue_context->idle_ue = NULL;
+    __atomic_sub_fetch (&mme_app_idle_nb_compacted, 1, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock (&mme_app_idle_lock);
+
+  if (idle_ue) {
+    for (int i = 0; i < idle_ue->nb_pdns; i++) {
+      bdestroy_wrapper (&idle_ue->pdns[i].apn_in_use);
+      bdestroy_wrapper (&idle_ue->pdns[i].apn_subscribed);
+      bdestroy_wrapper (&idle_ue->pdns[i].apn_oi_replacement);
+    }
+    free_wrapper ((void**)&idle_ue);
+  }
+}
@@ -0,0 +1,91 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_idle.h
+  \brief Compact representation of the UEs staying in ECM-IDLE.
+  The EMM context, the PDN contexts and the bearer contexts of a UE idle for long enough are
+  replaced by one fixed size idle record hung on its UE context. The UE context stays in the
+  MME_APP collection (it is the key of the S1AP, S11 and timer references).
+  Each task only drops and rebuilds its own contexts: the NAS EMM task drops the EMM context on
+  NAS_IDLE_COMPACT_REQ, the MME_APP task rebuilds the PDN and bearer contexts the first time it
+  looks the UE up again (service request, TAU, paging, detach...) and asks the NAS EMM task to
+  rebuild the EMM context with NAS_IDLE_EXPAND_REQ.
+*/
+
+#ifndef FILE_MME_APP_IDLE_SEEN
+#define FILE_MME_APP_IDLE_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "3gpp_36.401.h"
+
+#define MME_APP_IDLE_UE_MAX_PDNS            2       /*!< \brief UEs with more PDN connections are not compacted */
+
+struct ue_context_s;
+struct emm_data_context_s;
+struct itti_nas_idle_compact_req_s;
+struct itti_nas_idle_compact_rsp_s;
+
+/*! \fn void mme_app_idle_compact_ues(const uint32_t idle_sec)
+ * \brief Select the registered UEs in ECM-IDLE since idle_sec seconds, with no procedure running,
+ * only default bearers and at most MME_APP_IDLE_UE_MAX_PDNS PDN connections, and send them to
+ * the NAS EMM task in NAS_IDLE_COMPACT_REQ. Called by the MME_APP task on the idle compaction timer.
+ */
+void mme_app_idle_compact_ues(const uint32_t idle_sec);
+
+/*! \fn void mme_app_idle_emm_compact(const struct itti_nas_idle_compact_req_s * const compact_req)
+ * \brief Copy the EMM contexts of the selected UEs with no EMM procedure running into idle records
+ * hung on their UE contexts, drop them and send the UEs to the MME_APP task in NAS_IDLE_COMPACT_RSP.
+ * Called by the NAS EMM task, the owner of the EMM contexts, on NAS_IDLE_COMPACT_REQ.
+ */
+void mme_app_idle_emm_compact(const struct itti_nas_idle_compact_req_s * const compact_req);
+
+/*! \fn void mme_app_idle_handle_emm_compact(const struct itti_nas_idle_compact_rsp_s * const compact_rsp)
+ * \brief Move the PDN and bearer contexts of the UEs still idle into their idle records, ask the
+ * NAS EMM task to rebuild the EMM context of the others. Called by the MME_APP task on NAS_IDLE_COMPACT_RSP.
+ */
+void mme_app_idle_handle_emm_compact(const struct itti_nas_idle_compact_rsp_s * const compact_rsp);
+
+/*! \fn void mme_app_idle_ue_expand(struct ue_context_s * const ue_context)
+ * \brief Rebuild the PDN and bearer contexts of a compacted UE and ask the NAS EMM task to rebuild
+ * its EMM context. Called by the UE context lookups of the MME_APP task only.
+ */
+void mme_app_idle_ue_expand(struct ue_context_s * const ue_context);
+
+/*! \fn struct emm_data_context_s *mme_app_idle_emm_expand(const mme_ue_s1ap_id_t ue_id)
+ * \brief Rebuild the EMM context of a compacted UE, nothing is using it meanwhile.
+ * Called by the EMM context lookups that missed and by the NAS EMM task on NAS_IDLE_EXPAND_REQ.
+ * @returns the EMM context, NULL if the UE is not compacted
+ */
+struct emm_data_context_s *mme_app_idle_emm_expand(const mme_ue_s1ap_id_t ue_id);
+
+/*! \fn void mme_app_idle_ue_free(struct ue_context_s * const ue_context)
+ * \brief Free the idle record of a UE context released while compacted.
+ */
+void mme_app_idle_ue_free(struct ue_context_s * const ue_context);
+
+/*! \fn uint32_t mme_app_idle_nb_ues(void)
+ * \brief Number of compacted UEs, lets the lookups that missed skip the idle records when none.
+ */
+uint32_t mme_app_idle_nb_ues(void);
+
+#endif /* FILE_MME_APP_IDLE_SEEN */
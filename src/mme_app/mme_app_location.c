@@ -46,6 +46,7 @@
 #include "common_defs.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 #include "mme_config.h"
 #include "mme_app_procedures.h"
 
@@ -70,6 +71,7 @@ int mme_app_handle_s6a_update_location_ans (
     MSC_LOG_EVENT (MSC_MMEAPP_MME, "0 S6A_UPDATE_LOCATION unknown imsi " IMSI_64_FMT" ", imsi64);
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
+  mme_stats_latency (ue_context->mme_ue_s1ap_id, S6A_UPDATE_LOCATION);
 
   /** Recheck that the EMM Data Context is found by the IMSI. */
   if ((emm_context = emm_data_context_get_by_imsi(&_emm_data, imsi64)) == NULL) {
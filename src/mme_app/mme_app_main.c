@@ -46,12 +46,14 @@
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
 #include "mme_app_statistics.h"
+#include "mme_app_checkpoint.h"
+#include "mme_app_idle.h"
+#include "mme_app_bulk_release.h"
 #include "common_defs.h"
-#include "mme_app_edns_emulation.h"
+#include "mme_app_wrr_selection.h"
 #include "mme_app_procedures.h"
 
-//mme_app_desc_t                          mme_app_desc;
-mme_app_desc_t                          mme_app_desc = {.rw_lock = PTHREAD_RWLOCK_INITIALIZER, 0} ;
+mme_app_desc_t                          mme_app_desc;
 
 
 void     *mme_app_thread (void *args);
@@ -87,6 +89,9 @@ void *mme_app_thread (void *args)
         /*
          * We received the update location answer message from HSS -> Handle it
          */
+        mme_stats_inc_outcome (S6A_UPDATE_LOCATION,
+            (S6A_RESULT_BASE == received_message_p->ittiMsg.s6a_update_location_ans.result.present) &&
+            (DIAMETER_SUCCESS == received_message_p->ittiMsg.s6a_update_location_ans.result.choice.base));
         mme_app_handle_s6a_update_location_ans (&received_message_p->ittiMsg.s6a_update_location_ans);
       }
       break;
@@ -95,6 +100,7 @@ void *mme_app_thread (void *args)
         /*
          * We received the cancel location request message from HSS -> Handle it
          */
+        mme_stats_inc (S6A_CANCEL_LOCATION);
         mme_app_handle_s6a_cancel_location_req (&received_message_p->ittiMsg.s6a_cancel_location_req);
       }
       break;
@@ -153,6 +159,7 @@ void *mme_app_thread (void *args)
       break;
 
     case S11_DOWNLINK_DATA_NOTIFICATION: {
+        mme_stats_inc (S11_DOWNLINK_DATA_NOTIFICATION);
         mme_app_handle_downlink_data_notification (&received_message_p->ittiMsg.s11_downlink_data_notification);
       }
       break;
@@ -183,6 +190,16 @@ void *mme_app_thread (void *args)
     }
     break;
 
+    case NAS_CHECKPOINT_RSP:{
+      mme_app_checkpoint_handle_emm_snapshot (&NAS_CHECKPOINT_RSP (received_message_p));
+    }
+    break;
+
+    case NAS_IDLE_COMPACT_RSP:{
+      mme_app_idle_handle_emm_compact (&NAS_IDLE_COMPACT_RSP (received_message_p));
+    }
+    break;
+
     case S11_CREATE_BEARER_REQUEST:
       mme_app_handle_s11_create_bearer_req (&received_message_p->ittiMsg.s11_create_bearer_request);
       break;
@@ -201,11 +218,13 @@ void *mme_app_thread (void *args)
       break;
 
     case S11_CREATE_SESSION_RESPONSE:{
+        mme_stats_inc_outcome (S11_CREATE_SESSION, REQUEST_ACCEPTED == received_message_p->ittiMsg.s11_create_session_response.cause.cause_value);
         mme_app_handle_create_sess_resp (&received_message_p->ittiMsg.s11_create_session_response);
       }
       break;
 
     case S11_DELETE_SESSION_RESPONSE: {
+      mme_stats_inc_outcome (S11_DELETE_SESSION, REQUEST_ACCEPTED == received_message_p->ittiMsg.s11_delete_session_response.cause.cause_value);
       mme_app_handle_delete_session_rsp (&received_message_p->ittiMsg.s11_delete_session_response);
       }
       break;
@@ -213,6 +232,7 @@ void *mme_app_thread (void *args)
     case S11_MODIFY_BEARER_RESPONSE:{
         struct ue_context_s                    *ue_context_p = NULL;
         ue_context_p = mme_ue_context_exists_s11_teid (&mme_app_desc.mme_ue_contexts, received_message_p->ittiMsg.s11_modify_bearer_response.teid);
+        mme_stats_inc_outcome (S11_MODIFY_BEARER, REQUEST_ACCEPTED == received_message_p->ittiMsg.s11_modify_bearer_response.cause.cause_value);
         if (ue_context_p == NULL) {
           MSC_LOG_RX_DISCARDED_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " ",
             received_message_p->ittiMsg.s11_modify_bearer_response.teid);
@@ -231,6 +251,7 @@ void *mme_app_thread (void *args)
       break;
 
     case S11_RELEASE_ACCESS_BEARERS_RESPONSE:{
+        mme_stats_inc_outcome (S11_RELEASE_ACCESS_BEARERS, REQUEST_ACCEPTED == received_message_p->ittiMsg.s11_release_access_bearers_response.cause.cause_value);
         mme_app_handle_release_access_bearers_resp (&received_message_p->ittiMsg.s11_release_access_bearers_response);
       }
       break;
@@ -448,6 +469,12 @@ void *mme_app_thread (void *args)
           mme_app_statistics_display ();
           /** Display the ITTI buffer. */
           itti_print_DEBUG ();
+        } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_desc.checkpoint_timer_id) {
+          mme_app_checkpoint_snapshot ();
+        } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_desc.idle_compaction_timer_id) {
+          mme_app_idle_compact_ues (mme_config.idle_compaction_timer);
+        } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_desc.bulk_release_timer_id) {
+          mme_app_bulk_release_send ();
         } else if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) {
           mme_ue_s1ap_id_t mme_ue_s1ap_id = *((mme_ue_s1ap_id_t *)(received_message_p->ittiMsg.timer_has_expired.arg));
           ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
@@ -502,7 +529,6 @@ int mme_app_init (const mme_config_t * mme_config_p)
   OAILOG_FUNC_IN (LOG_MME_APP);
 
   memset (&mme_app_desc, 0, sizeof (mme_app_desc));
-  // todo: (from develop)   pthread_rwlock_init (&mme_app_desc.rw_lock, NULL); && where to unlock it?
   bstring b = bfromcstr("mme_app_imsi_ue_context_htbl");
   mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl = hashtable_uint64_ts_create (mme_config.max_ues, NULL, b);
   btrunc(b, 0);
@@ -527,9 +553,30 @@ int mme_app_init (const mme_config_t * mme_config_p)
   mme_app_desc.mme_ue_contexts.imsi_subscription_profile_htbl = hashtable_ts_create (mme_config.max_ues, NULL, NULL, b);
   bdestroy_wrapper (&b);
 
-  if (mme_app_edns_init(mme_config_p)) {
+  if (mme_app_wrr_selection_init(mme_config_p)) {
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
+
+  /*
+   * Restore the UEs of the last checkpoint before the task handles any message
+   */
+  if ((mme_config_p->checkpoint_file) && (blength (mme_config_p->checkpoint_file))) {
+    if (mme_app_checkpoint_init (bdata (mme_config_p->checkpoint_file), mme_config_p->max_ues)) {
+      OAILOG_ERROR (LOG_MME_APP, "Failed to open the checkpoint file %s, UE contexts are not saved\n", bdata (mme_config_p->checkpoint_file));
+    } else if (timer_setup (mme_config_p->checkpoint_timer, 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &mme_app_desc.checkpoint_timer_id) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "Failed to request new timer for checkpoint with %ds " "of periocidity\n", mme_config_p->checkpoint_timer);
+      mme_app_desc.checkpoint_timer_id = 0;
+    }
+  }
+  /*
+   * The UEs are compacted between one and two timer periods after they went ECM-IDLE
+   */
+  if (mme_config_p->idle_compaction_timer) {
+    if (timer_setup (mme_config_p->idle_compaction_timer, 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &mme_app_desc.idle_compaction_timer_id) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "Failed to request new timer for idle compaction with %ds " "of periocidity\n", mme_config_p->idle_compaction_timer);
+      mme_app_desc.idle_compaction_timer_id = 0;
+    }
+  }
   /*
    * Create the thread associated with MME applicative layer
    */
@@ -549,6 +596,9 @@ int mme_app_init (const mme_config_t * mme_config_p)
     OAILOG_ERROR (LOG_MME_APP, "Failed to request new timer for statistics with %ds " "of periocidity\n", mme_config_p->mme_statistic_timer);
     mme_app_desc.statistic_timer_id = 0;
   }
+  if (mme_config_p->mme_statistic_http_port) {
+    mme_app_statistics_http_start (mme_config_p->mme_statistic_http_port);
+  }
 
   OAILOG_DEBUG (LOG_MME_APP, "Initializing MME applicative layer: DONE -- ASSERTING\n");
   OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
@@ -559,7 +609,16 @@ void mme_app_exit (void)
 {
   // todo: also check other timers!
   timer_remove(mme_app_desc.statistic_timer_id, NULL);
-  mme_app_edns_exit();
+  if (mme_app_desc.checkpoint_timer_id) {
+    timer_remove(mme_app_desc.checkpoint_timer_id, NULL);
+  }
+  if (mme_app_desc.idle_compaction_timer_id) {
+    timer_remove(mme_app_desc.idle_compaction_timer_id, NULL);
+  }
+  mme_app_bulk_release_exit();
+  // the last periodic snapshot is kept, NAS may already be cleaned up
+  mme_app_checkpoint_exit();
+  mme_app_wrr_selection_exit();
   hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl);
   hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl);
   hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl);
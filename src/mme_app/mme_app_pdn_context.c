@@ -63,6 +63,16 @@ static void mme_app_free_pdn_context (pdn_context_t ** const pdn_context);
 
 static teid_t                           mme_app_teid_generator = 0x00000001;
 
+//------------------------------------------------------------------------------
+void mme_app_reserve_s11_teid (const teid_t teid)
+{
+  teid_t next = mme_app_teid_generator;
+  // the S11 TEID is also the M-TMSI of the GUTI, a restored UE keeps both
+  while ((next <= teid) && (!__sync_bool_compare_and_swap (&mme_app_teid_generator, next, teid + 1))) {
+    next = mme_app_teid_generator;
+  }
+}
+
 //------------------------------------------------------------------------------
 void mme_app_get_pdn_context (mme_ue_s1ap_id_t ue_id, pdn_cid_t const context_id, ebi_t const default_ebi, bstring const apn_subscribed, pdn_context_t **pdn_ctx)
 {
@@ -186,12 +196,9 @@ mme_app_esm_create_pdn_context(mme_ue_s1ap_id_t ue_id, const ebi_t linked_ebi, c
   }
 
   bearer_context_t * free_bearer = NULL;
-  if(linked_ebi != EPS_BEARER_IDENTITY_UNASSIGNED){
-	  mme_app_get_free_bearer_context(ue_context, linked_ebi, &free_bearer); /**< Find the EBI which is matching (should be available). */
-  } else{
-	  free_bearer = RB_MIN(BearerPool, &ue_context->bearer_pool); /**< Find the EBI which is matching (should be available). */
-  }
-  if(!free_bearer){
+  /** The EBI which is matching (should be available), else the lowest free one. */
+  ebi_t free_ebi = mme_app_get_free_bearer_ebi(ue_context, linked_ebi);
+  if(EPS_BEARER_IDENTITY_UNASSIGNED == free_ebi){
     OAILOG_ERROR(LOG_MME_APP, "No available bearer context could be found for UE: " MME_UE_S1AP_ID_FMT " with linked_ebi=%d. \n", ue_id, linked_ebi);
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
@@ -213,19 +220,20 @@ mme_app_esm_create_pdn_context(mme_ue_s1ap_id_t ue_id, const ebi_t linked_ebi, c
         &ue_context->guti);
   }
 
-  bearer_context_t *bc_test = NULL;
   /** List all bearer contexts. */
-  RB_FOREACH(bc_test, BearerPool, &ue_context->bearer_pool){
-    OAILOG_TRACE (LOG_MME_APP, "Current bearer context %p with ebi %d for pdn_context %p for APN \"%s\" and cid=%d for UE: " MME_UE_S1AP_ID_FMT ". \n",
-        bc_test, bc_test->ebi, (*pdn_context_pp), bdata((*pdn_context_pp)->apn_subscribed),
-        (*pdn_context_pp)->context_identifier, ue_id);
+  for (int i = 0; i < MAX_NUM_BEARERS_UE; i++) {
+    if (ue_context->bearer_contexts[i]) {
+      OAILOG_TRACE (LOG_MME_APP, "Current bearer context %p with ebi %d for pdn_context %p for APN \"%s\" and cid=%d for UE: " MME_UE_S1AP_ID_FMT ". \n",
+          ue_context->bearer_contexts[i], ue_context->bearer_contexts[i]->ebi, (*pdn_context_pp), bdata((*pdn_context_pp)->apn_subscribed),
+          (*pdn_context_pp)->context_identifier, ue_id);
+    }
   }
   /*
    * Check if an APN configuration exists. If so, use it to update the fields.
    */
   mme_app_pdn_context_init(ue_context, (*pdn_context_pp));
-  /** Get the default bearer context directly. */
-  free_bearer = RB_REMOVE(BearerPool, &ue_context->bearer_pool, free_bearer);
+  /** Allocate the default bearer context directly. */
+  free_bearer = mme_app_new_ue_bearer_context(ue_context, free_ebi);
   DevAssert(free_bearer);
   AssertFatal((EPS_BEARER_IDENTITY_LAST >= free_bearer->ebi) && (EPS_BEARER_IDENTITY_FIRST <= free_bearer->ebi), "Bad ebi %u", free_bearer->ebi);
   /* Check that there is no collision when adding the bearer context into the PDN sessions bearer pool. */
@@ -446,7 +454,6 @@ mme_app_esm_detach(mme_ue_s1ap_id_t ue_id){
     pdn_context = RB_MIN(PdnContexts, &ue_context->pdn_contexts);
   }
   OAILOG_INFO(LOG_MME_APP, "Removed all ESM contexts of UE: " MME_UE_S1AP_ID_FMT " for detach. \n", ue_id);
-  bearer_context_t * bc_free = RB_MIN(BearerPool, &ue_context->bearer_pool);
   // todo: UNLOCK UE CONTEXTS
   OAILOG_FUNC_OUT(LOG_MME_APP);
 }
@@ -640,14 +647,12 @@ mme_app_pdn_process_session_creation(mme_ue_s1ap_id_t ue_id, fteid_t * saegw_s11
       /** Check that it is a dedicated bearer. */
       DevAssert(pdn_context->default_ebi != bearer_id);
       /*
-       * Release all session bearers of the PDN context back into the UE pool.
+       * Release all session bearers of the PDN context, their EBIs become free in the UE context.
        */
       if(bearer_context){
         DevAssert(RB_REMOVE(SessionBearers, &pdn_context->session_bearers, bearer_context));
-        /** Initialize the new bearer context. */
-        mme_app_bearer_context_initialize(bearer_context);
-        /** Insert the bearer context into the free bearer of the ue context. */
-        RB_INSERT (BearerPool, &ue_context->bearer_pool, bearer_context);
+        /** Release the bearer context, its EBI becomes free. */
+        mme_app_release_ue_bearer_context(ue_context, &bearer_context);
         OAILOG_WARNING(LOG_MME_APP, "Successfully deregistered the bearer context (ebi=%d) from PDN \"%s\" and for ue_id " MME_UE_S1AP_ID_FMT "\n", bearer_id, bdata(pdn_context->apn_subscribed), ue_id);
       }
       continue;
@@ -718,7 +723,7 @@ static void mme_app_delete_pdn_context(ue_context_t * const ue_context, pdn_cont
   pdn_context_t *pdn_context_removed = RB_REMOVE(PdnContexts, &ue_context->pdn_contexts, (*pdn_context_pp));
   DevAssert(pdn_context_removed);
   /*
-   * Release all session bearers of the PDN context back into the UE pool.
+   * Release all session bearers of the PDN context, their EBIs become free in the UE context.
    */
   bearer_context_t * pBearerCtx = RB_MIN(SessionBearers, &(*pdn_context_pp)->session_bearers);
   while(pBearerCtx){
@@ -731,7 +736,7 @@ static void mme_app_delete_pdn_context(ue_context_t * const ue_context, pdn_cont
     // TODO Look at "free_traffic_flow_template"
     //free_traffic_flow_template(&pdn->bearer[i]->tft);
     /*
-     * We don't have one pool where tunnels are allocated. We allocate a fixed number of bearer contexts at the beginning inside the UE context.
+     * Bearer contexts are allocated on demand in the EBI slots of the UE context.
      * So the delete function is unlike to GTPv2c tunnels.
      */
     // no timers to stop, no DSR to be sent..
@@ -747,12 +752,10 @@ static void mme_app_delete_pdn_context(ue_context_t * const ue_context, pdn_cont
     //        }
     //        copy_protocol_configuration_options((*pdn_context_pP)->pco, pco);
     //      }
-    /** Initialize the new bearer context. */
-    mme_app_bearer_context_initialize(pBearerCtx);
-    /** Insert the bearer context into the free bearer of the ue context. */
-    RB_INSERT (BearerPool, &ue_context->bearer_pool, pBearerCtx);
     OAILOG_INFO(LOG_MME_APP, "Successfully deregistered the bearer context with ebi %d from PDN id %u and for ue_id " MME_UE_S1AP_ID_FMT "\n",
         pBearerCtx->ebi, (*pdn_context_pp)->context_identifier, ue_context->mme_ue_s1ap_id);
+    /** Release the bearer context, its EBI becomes free. */
+    mme_app_release_ue_bearer_context(ue_context, &pBearerCtx);
     pBearerCtx = RB_MIN(SessionBearers, &(*pdn_context_pp)->session_bearers);
   }
   /** Successfully removed all bearer contexts, clean up the PDN context procedure. */
@@ -74,6 +74,8 @@ mme_app_validate_bearer_resource_modification(mme_ue_s1ap_id_t ue_id, ebi_t ebi,
  * Receive Bearer Context VOs to send in CSR/Handover Request, etc..
  * Will set bearer state, unless it is null.
  */
+void mme_app_reserve_s11_teid (const teid_t teid);
+
 void mme_app_get_bearer_contexts_to_be_created(pdn_context_t * pdn_context, bearer_contexts_to_be_created_t *bc_tbc, mme_app_bearer_state_t bc_state);
 
 #endif
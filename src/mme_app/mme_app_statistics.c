@@ -19,6 +19,7 @@
  *      contact@openairinterface.org
  */
 
+
 /*! \file mme_app_statistics.c
   \brief
   \author Sebastien ROUX
@@ -27,155 +28,410 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
 #include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
 #include "bstrlib.h"
 
 #include "log.h"
+#include "common_defs.h"
 #include "intertask_interface.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
 #include "mme_app_statistics.h"
 
+#define MME_STATS_HTTP_REQUEST_MAX   2048
+#define MME_STATS_HTTP_TIMEOUT_S     1
 
+#define MME_STATS_NAME(cOUNTER, nAME, hELP)  nAME,
+#define MME_STATS_HELP(cOUNTER, nAME, hELP)  hELP,
+static const char * const               mme_stats_names[MME_STATS_MAX] = {MME_STATS_COUNTERS(MME_STATS_NAME)};
+static const char * const               mme_stats_helps[MME_STATS_MAX] = {MME_STATS_COUNTERS(MME_STATS_HELP)};
+#undef MME_STATS_NAME
+#undef MME_STATS_HELP
 
-int mme_app_statistics_display (
-  void)
+#define MME_STATS_LATENCY_NAME(lATENCY, nAME, sTART, hELP)   nAME,
+#define MME_STATS_LATENCY_START(lATENCY, nAME, sTART, hELP)  MME_STATS_MARK_##sTART,
+#define MME_STATS_LATENCY_HELP(lATENCY, nAME, sTART, hELP)   hELP,
+static const char * const               mme_stats_latency_names[MME_STATS_LATENCY_MAX] = {MME_STATS_LATENCIES(MME_STATS_LATENCY_NAME)};
+static const mme_stats_mark_t           mme_stats_latency_starts[MME_STATS_LATENCY_MAX] = {MME_STATS_LATENCIES(MME_STATS_LATENCY_START)};
+static const char * const               mme_stats_latency_helps[MME_STATS_LATENCY_MAX] = {MME_STATS_LATENCIES(MME_STATS_LATENCY_HELP)};
+#undef MME_STATS_LATENCY_NAME
+#undef MME_STATS_LATENCY_START
+#undef MME_STATS_LATENCY_HELP
+
+/* Percentiles reported for each latency */
+static const double                     mme_stats_percentiles[] = {50.0, 90.0, 99.0, 99.9};
+#define MME_STATS_PERCENTILES_MAX       (sizeof (mme_stats_percentiles) / sizeof (mme_stats_percentiles[0]))
+
+/* Gauges derived from the counters */
+typedef struct mme_stats_gauge_s {
+  const char                             *name;
+  const char                             *help;
+  mme_stats_counter_t                     added;
+  mme_stats_counter_t                     removed;
+} mme_stats_gauge_t;
+
+static const mme_stats_gauge_t          mme_stats_gauges[] = {
+  {"enb_connected",   "Connected eNBs",               MME_STATS_ENB_CONNECTED,              MME_STATS_ENB_RELEASED},
+  {"ue_attached",     "Attached UEs",                 MME_STATS_UE_ATTACHED,                MME_STATS_UE_DETACHED},
+  {"ue_connected",    "ECM-CONNECTED UEs",            MME_STATS_UE_CONNECTED,               MME_STATS_UE_DISCONNECTED},
+  {"default_bearers", "Default EPS bearers",          MME_STATS_DEFAULT_BEARER_ESTABLISHED, MME_STATS_DEFAULT_BEARER_RELEASED},
+  {"s1u_bearers",     "S1-U bearers",                 MME_STATS_S1U_BEARER_ESTABLISHED,     MME_STATS_S1U_BEARER_RELEASED},
+};
+
+__thread mme_stats_shard_t             *g_mme_stats_shard = NULL;
+
+static mme_stats_shard_t               *mme_stats_shards[MME_STATS_SHARDS_MAX] = {NULL};
+static uint32_t                         mme_stats_nb_shards = 0;
+static mme_stats_shard_t                mme_stats_shared_shard = {.is_shared = true};
+
+//------------------------------------------------------------------------------
+mme_stats_shard_t *mme_stats_new_shard (void)
 {
-  OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
-  OAILOG_DEBUG (LOG_MME_APP, "               |   Current Status| Added since last display|  Removed since last display |\n");
-  OAILOG_DEBUG (LOG_MME_APP, "Connected eNBs | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_enb_connected,
-                                          mme_app_desc.nb_enb_connected_since_last_stat,mme_app_desc.nb_enb_released_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "Attached UEs   | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_ue_attached,
-                                          mme_app_desc.nb_ue_attached_since_last_stat,mme_app_desc.nb_ue_detached_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "Connected UEs  | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_ue_connected,
-                                          mme_app_desc.nb_ue_connected_since_last_stat,mme_app_desc.nb_ue_disconnected_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "Default Bearers| %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_default_eps_bearers,
-                                          mme_app_desc.nb_eps_bearers_established_since_last_stat,mme_app_desc.nb_eps_bearers_released_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "S1-U Bearers   | %10u      |     %10u              |    %10u               |\n\n",mme_app_desc.nb_s1u_bearers,
-                                          mme_app_desc.nb_s1u_bearers_established_since_last_stat,mme_app_desc.nb_s1u_bearers_released_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
+  mme_stats_shard_t                      *shard = NULL;
+  const uint32_t                          index = __atomic_fetch_add (&mme_stats_nb_shards, 1, __ATOMIC_RELAXED);
 
-  mme_stats_write_lock (&mme_app_desc);
+  if ((index < MME_STATS_SHARDS_MAX) && (!posix_memalign ((void **)&shard, 64, sizeof (mme_stats_shard_t)))) {
+    memset (shard, 0, sizeof (mme_stats_shard_t));
+    __atomic_store_n (&mme_stats_shards[index], shard, __ATOMIC_RELEASE);
+  } else {
+    shard = &mme_stats_shared_shard;
+  }
+  g_mme_stats_shard = shard;
+  return shard;
+}
 
-  // resetting stats for next display
-  mme_app_desc.nb_enb_connected_since_last_stat = 0;
-  mme_app_desc.nb_enb_released_since_last_stat  = 0;
-  mme_app_desc.nb_ue_connected_since_last_stat  = 0;
-  mme_app_desc.nb_ue_disconnected_since_last_stat  = 0;
-  mme_app_desc.nb_s1u_bearers_established_since_last_stat = 0;
-  mme_app_desc.nb_s1u_bearers_released_since_last_stat = 0;
-  mme_app_desc.nb_eps_bearers_established_since_last_stat = 0;
-  mme_app_desc.nb_eps_bearers_released_since_last_stat = 0;
-  mme_app_desc.nb_ue_attached_since_last_stat = 0;
-  mme_app_desc.nb_ue_detached_since_last_stat = 0;
+//------------------------------------------------------------------------------
+uint64_t mme_stats_get (const mme_stats_counter_t counter)
+{
+  uint64_t                                value = __atomic_load_n (&mme_stats_shared_shard.counters[counter], __ATOMIC_RELAXED);
 
-  mme_stats_unlock(&mme_app_desc);
+  for (int i = 0; i < MME_STATS_SHARDS_MAX; i++) {
+    const mme_stats_shard_t * const shard = __atomic_load_n (&mme_stats_shards[i], __ATOMIC_ACQUIRE);
+    if (shard) {
+      value += __atomic_load_n (&shard->counters[counter], __ATOMIC_RELAXED);
+    }
+  }
+  return value;
+}
 
-  return 0;
+//------------------------------------------------------------------------------
+static inline uint64_t mme_stats_now_ns (void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static void mme_stats_histogram_record (const mme_stats_latency_t latency, const uint64_t value_us)
+{
+  mme_stats_shard_t                      *shard = g_mme_stats_shard;
+
+  if (!shard) {
+    shard = mme_stats_new_shard ();
+  }
+  mme_stats_histogram_t * const histogram = &shard->latencies[latency];
+  const uint32_t                index = mme_stats_histogram_index (value_us);
+  if (shard->is_shared) {
+    __atomic_fetch_add (&histogram->buckets[index], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&histogram->sum_us, value_us, __ATOMIC_RELAXED);
+  } else {
+    __atomic_store_n (&histogram->buckets[index], histogram->buckets[index] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n (&histogram->sum_us, histogram->sum_us + value_us, __ATOMIC_RELAXED);
+  }
 }
 
-/*********************************** Utility Functions to update Statistics**************************************/
+//------------------------------------------------------------------------------
+static void mme_stats_histogram_get (const mme_stats_latency_t latency, mme_stats_histogram_t * const histogram)
+{
+  memset (histogram, 0, sizeof (*histogram));
+  for (int i = -1; i < MME_STATS_SHARDS_MAX; i++) {
+    const mme_stats_shard_t * const shard = (0 > i) ? &mme_stats_shared_shard : __atomic_load_n (&mme_stats_shards[i], __ATOMIC_ACQUIRE);
+    if (shard) {
+      for (int b = 0; b < MME_STATS_HISTOGRAM_BUCKETS; b++) {
+        histogram->buckets[b] += __atomic_load_n (&shard->latencies[latency].buckets[b], __ATOMIC_RELAXED);
+      }
+      histogram->sum_us += __atomic_load_n (&shard->latencies[latency].sum_us, __ATOMIC_RELAXED);
+    }
+  }
+}
 
-// Number of Connected eNBs
-void update_mme_app_stats_connected_enb_add(void)
+//------------------------------------------------------------------------------
+void mme_stats_mark_ue (const mme_ue_s1ap_id_t ue_id, const mme_stats_mark_t mark)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_enb_connected)++;
-  (mme_app_desc.nb_enb_connected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  ue_context_t * const ue_context = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue_id);
+
+  if (ue_context) {
+    __atomic_store_n (&ue_context->stats_marks[mark], mme_stats_now_ns (), __ATOMIC_RELAXED);
+  }
 }
-void update_mme_app_stats_connected_enb_sub(void)
+
+//------------------------------------------------------------------------------
+void mme_stats_latency_ue (const mme_ue_s1ap_id_t ue_id, const mme_stats_latency_t latency)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_enb_connected !=0)
-    (mme_app_desc.nb_enb_connected)--;
-  (mme_app_desc.nb_enb_released_since_last_stat)--;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  ue_context_t * const ue_context = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue_id);
+
+  if (ue_context) {
+    // the stage may end in another task than its start, only one of them records it
+    const uint64_t start_ns = __atomic_exchange_n (&ue_context->stats_marks[mme_stats_latency_starts[latency]], 0, __ATOMIC_RELAXED);
+    if (start_ns) {
+      const uint64_t now_ns = mme_stats_now_ns ();
+      mme_stats_histogram_record (latency, (now_ns > start_ns) ? (now_ns - start_ns) / 1000 : 0);
+    }
+  }
 }
 
+//------------------------------------------------------------------------------
+uint64_t mme_stats_get_percentile (const mme_stats_latency_t latency, const double percentile, uint64_t * const count)
+{
+  mme_stats_histogram_t                   histogram;
 
+  mme_stats_histogram_get (latency, &histogram);
+  const uint64_t nb_values = mme_stats_histogram_count (&histogram);
+  if (count) *count = nb_values;
+  return mme_stats_histogram_percentile (&histogram, nb_values, percentile);
+}
 
-/*****************************************************/
-// Number of Connected UEs
-void update_mme_app_stats_connected_ue_add(void)
+//------------------------------------------------------------------------------
+static void mme_stats_get_all (uint64_t counters[MME_STATS_MAX])
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_ue_connected)++;
-  (mme_app_desc.nb_ue_connected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  for (int c = 0; c < MME_STATS_MAX; c++) {
+    counters[c] = mme_stats_get (c);
+  }
 }
-void update_mme_app_stats_connected_ue_sub(void)
+
+//------------------------------------------------------------------------------
+static uint64_t mme_stats_gauge_value (const uint64_t counters[MME_STATS_MAX], const mme_stats_gauge_t * const gauge)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_ue_connected !=0)
-    (mme_app_desc.nb_ue_connected)--;
-  (mme_app_desc.nb_ue_disconnected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  // a removal may be counted without its addition (released before the stats were displayed the first time)
+  return (counters[gauge->added] > counters[gauge->removed]) ? counters[gauge->added] - counters[gauge->removed] : 0;
 }
 
-/*****************************************************/
-// Number of S1U Bearers
-void update_mme_app_stats_s1u_bearer_add(void)
+//------------------------------------------------------------------------------
+int mme_app_statistics_display (
+  void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_s1u_bearers)++;
-  (mme_app_desc.nb_s1u_bearers_established_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  // only called by the MME_APP task
+  static uint64_t                         last[MME_STATS_MAX] = {0};
+  uint64_t                                counters[MME_STATS_MAX];
+
+  mme_stats_get_all (counters);
+
+  OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
+  OAILOG_DEBUG (LOG_MME_APP, "               |   Current Status| Added since last display|  Removed since last display |\n");
+  for (int g = 0; g < sizeof (mme_stats_gauges) / sizeof (mme_stats_gauges[0]); g++) {
+    const mme_stats_gauge_t * const gauge = &mme_stats_gauges[g];
+    OAILOG_DEBUG (LOG_MME_APP, "%-15s| %10" PRIu64 "      |     %10" PRIu64 "              |    %10" PRIu64 "               |\n", gauge->help,
+        mme_stats_gauge_value (counters, gauge), counters[gauge->added] - last[gauge->added], counters[gauge->removed] - last[gauge->removed]);
+  }
+  OAILOG_DEBUG (LOG_MME_APP, "\n");
+  for (int c = MME_STATS_ATTACH_REQUEST; c < MME_STATS_MAX; c++) {
+    if (counters[c]) {
+      OAILOG_DEBUG (LOG_MME_APP, "%-40s %10" PRIu64 " (+%" PRIu64 ")\n", mme_stats_names[c], counters[c], counters[c] - last[c]);
+    }
+  }
+  OAILOG_DEBUG (LOG_MME_APP, "\n%-40s %10s %10s %10s %10s %10s\n", "Latency (us)", "count", "p50", "p90", "p99", "p99.9");
+  for (int l = 0; l < MME_STATS_LATENCY_MAX; l++) {
+    mme_stats_histogram_t histogram;
+    mme_stats_histogram_get (l, &histogram);
+    const uint64_t count = mme_stats_histogram_count (&histogram);
+    if (count) {
+      OAILOG_DEBUG (LOG_MME_APP, "%-40s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n", mme_stats_latency_names[l], count,
+          mme_stats_histogram_percentile (&histogram, count, mme_stats_percentiles[0]), mme_stats_histogram_percentile (&histogram, count, mme_stats_percentiles[1]),
+          mme_stats_histogram_percentile (&histogram, count, mme_stats_percentiles[2]), mme_stats_histogram_percentile (&histogram, count, mme_stats_percentiles[3]));
+    }
+  }
+  OAILOG_DEBUG (LOG_MME_APP, "\n%-40s %10s %10s %10s %10s %10s %10s\n", "ITTI queue", "depth", "max", "dropped", "blocked", "p50 (us)", "p99 (us)");
+  for (task_id_t t = TASK_FIRST; t < TASK_MAX; t++) {
+    itti_task_queue_stats_t queue;
+    itti_get_task_queue_stats (t, &queue);
+    if (queue.nb_enqueued) {
+      OAILOG_DEBUG (LOG_MME_APP, "%-40s %10u %10u %10" PRIu64 " %10" PRIu64 " %10u %10u%s\n", itti_get_task_name (t), queue.queue_depth, queue.high_water_mark,
+          queue.nb_dropped, queue.nb_blocked, queue.dwell_p50_us, queue.dwell_p99_us, (queue.overloaded) ? " overloaded" : "");
+    }
+  }
+  OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
+
+  memcpy (last, counters, sizeof (last));
+  return 0;
 }
-void update_mme_app_stats_s1u_bearer_sub(void)
+
+//------------------------------------------------------------------------------
+// One family per metric, one sample per task
+static void mme_app_statistics_prometheus_itti (bstring body)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_s1u_bearers !=0)
-    (mme_app_desc.nb_s1u_bearers)--;
-  (mme_app_desc.nb_s1u_bearers_released_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  itti_task_queue_stats_t                 queues[TASK_MAX];
+
+  for (task_id_t t = TASK_FIRST; t < TASK_MAX; t++) {
+    itti_get_task_queue_stats (t, &queues[t]);
+  }
+#define MME_STATS_ITTI_FAMILY(nAME, tYPE, hELP, fMT, vALUE) \
+  do { \
+    bformata (body, "# HELP mme_itti_queue_" nAME " " hELP "\n# TYPE mme_itti_queue_" nAME " " tYPE "\n"); \
+    for (task_id_t t = TASK_FIRST; t < TASK_MAX; t++) { \
+      bformata (body, "mme_itti_queue_" nAME "{task=\"%s\"} " fMT "\n", itti_get_task_name (t), (vALUE)); \
+    } \
+  } while (0)
+  MME_STATS_ITTI_FAMILY ("size", "gauge", "Number of slots of the queue of the task", "%u", queues[t].queue_size);
+  MME_STATS_ITTI_FAMILY ("depth", "gauge", "Number of messages waiting in the queue of the task", "%u", queues[t].queue_depth);
+  MME_STATS_ITTI_FAMILY ("high_water_mark", "gauge", "Max number of messages waiting in the queue of the task", "%u", queues[t].high_water_mark);
+  MME_STATS_ITTI_FAMILY ("overloaded", "gauge", "1 while the queue of the task is above its high watermark", "%d", (int)queues[t].overloaded);
+  MME_STATS_ITTI_FAMILY ("enqueued", "counter", "Messages sent to the task", "%" PRIu64, queues[t].nb_enqueued);
+  MME_STATS_ITTI_FAMILY ("dropped", "counter", "Messages to the task dropped by the overload policy", "%" PRIu64, queues[t].nb_dropped);
+  MME_STATS_ITTI_FAMILY ("blocked", "counter", "Senders that waited for a free slot in the queue of the task", "%" PRIu64, queues[t].nb_blocked);
+#undef MME_STATS_ITTI_FAMILY
+  bformata (body, "# HELP mme_itti_queue_dwell_seconds Time spent by the messages in the queue of the task\n# TYPE mme_itti_queue_dwell_seconds summary\n");
+  for (task_id_t t = TASK_FIRST; t < TASK_MAX; t++) {
+    const char * const name = itti_get_task_name (t);
+    bformata (body, "mme_itti_queue_dwell_seconds{task=\"%s\",quantile=\"0.5\"} %.6f\n", name, queues[t].dwell_p50_us / 1e6);
+    bformata (body, "mme_itti_queue_dwell_seconds{task=\"%s\",quantile=\"0.9\"} %.6f\n", name, queues[t].dwell_p90_us / 1e6);
+    bformata (body, "mme_itti_queue_dwell_seconds{task=\"%s\",quantile=\"0.99\"} %.6f\n", name, queues[t].dwell_p99_us / 1e6);
+    bformata (body, "mme_itti_queue_dwell_seconds_sum{task=\"%s\"} %.6f\nmme_itti_queue_dwell_seconds_count{task=\"%s\"} %" PRIu64 "\n",
+        name, queues[t].dwell_sum_us / 1e6, name, queues[t].nb_dequeued);
+  }
 }
 
-/*****************************************************/
-// Number of Default EPS Bearers
-void update_mme_app_stats_default_bearer_add(void)
+//------------------------------------------------------------------------------
+// Prometheus text exposition format 0.0.4
+static bstring mme_app_statistics_prometheus (void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_default_eps_bearers)++;
-  (mme_app_desc.nb_eps_bearers_established_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  uint64_t                                counters[MME_STATS_MAX];
+  bstring                                 body = bfromcstralloc (32768, "");
+
+  mme_stats_get_all (counters);
+  for (int g = 0; g < sizeof (mme_stats_gauges) / sizeof (mme_stats_gauges[0]); g++) {
+    const mme_stats_gauge_t * const gauge = &mme_stats_gauges[g];
+    bformata (body, "# HELP mme_%s %s\n# TYPE mme_%s gauge\nmme_%s %" PRIu64 "\n",
+        gauge->name, gauge->help, gauge->name, gauge->name, mme_stats_gauge_value (counters, gauge));
+  }
+  for (int c = 0; c < MME_STATS_MAX; c++) {
+    bformata (body, "# HELP mme_%s %s\n# TYPE mme_%s counter\nmme_%s %" PRIu64 "\n",
+        mme_stats_names[c], mme_stats_helps[c], mme_stats_names[c], mme_stats_names[c], counters[c]);
+  }
+  for (int l = 0; l < MME_STATS_LATENCY_MAX; l++) {
+    mme_stats_histogram_t histogram;
+    const char * const    name = mme_stats_latency_names[l];
+    mme_stats_histogram_get (l, &histogram);
+    const uint64_t count = mme_stats_histogram_count (&histogram);
+    bformata (body, "# HELP mme_%s_latency_seconds %s\n# TYPE mme_%s_latency_seconds summary\n", name, mme_stats_latency_helps[l], name);
+    for (int p = 0; p < MME_STATS_PERCENTILES_MAX; p++) {
+      bformata (body, "mme_%s_latency_seconds{quantile=\"%g\"} %.6f\n", name, mme_stats_percentiles[p] / 100.0,
+          mme_stats_histogram_percentile (&histogram, count, mme_stats_percentiles[p]) / 1e6);
+    }
+    bformata (body, "mme_%s_latency_seconds_sum %.6f\nmme_%s_latency_seconds_count %" PRIu64 "\n", name, histogram.sum_us / 1e6, name, count);
+  }
+  mme_app_statistics_prometheus_itti (body);
+  return body;
 }
-void update_mme_app_stats_default_bearer_sub(void)
+
+//------------------------------------------------------------------------------
+static int mme_app_statistics_http_send (const int fd, const char * buffer, size_t length)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_default_eps_bearers !=0)
-    (mme_app_desc.nb_default_eps_bearers)--;
-  (mme_app_desc.nb_eps_bearers_released_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  while (length) {
+    const ssize_t sent = send (fd, buffer, length, MSG_NOSIGNAL);
+    if (0 > sent) {
+      if (EINTR == errno) continue;
+      return RETURNerror;
+    }
+    buffer += sent;
+    length -= sent;
+  }
+  return RETURNok;
 }
 
-/*****************************************************/
-// Number of Attached UEs
-void update_mme_app_stats_attached_ue_add(void)
+//------------------------------------------------------------------------------
+static void mme_app_statistics_http_serve (const int fd)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_ue_attached)++;
-  (mme_app_desc.nb_ue_attached_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  char                                    request[MME_STATS_HTTP_REQUEST_MAX];
+  size_t                                  length = 0;
+  const struct timeval                    timeout = {.tv_sec = MME_STATS_HTTP_TIMEOUT_S, .tv_usec = 0};
+  bstring                                 response = NULL;
+
+  setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+  while (length < sizeof (request) - 1) {
+    const ssize_t received = recv (fd, &request[length], sizeof (request) - 1 - length, 0);
+    if (0 >= received) break;
+    length += received;
+    request[length] = '\0';
+    if (strstr (request, "\r\n\r\n")) break;
+  }
+  request[length] = '\0';
+
+  if ((!strncmp (request, "GET /metrics ", 13)) || (!strncmp (request, "GET / ", 6))) {
+    bstring body = mme_app_statistics_prometheus ();
+    response = bformat ("HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", blength (body));
+    bconcat (response, body);
+    bdestroy (body);
+  } else {
+    response = bfromcstr ("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+  }
+  mme_app_statistics_http_send (fd, (const char *)response->data, blength (response));
+  bdestroy (response);
 }
-void update_mme_app_stats_attached_ue_sub(void)
+
+//------------------------------------------------------------------------------
+static void *mme_app_statistics_http_thread (void *args)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_ue_attached !=0)
-    (mme_app_desc.nb_ue_attached)--;
-  (mme_app_desc.nb_ue_detached_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  const int                               listen_fd = (int)(intptr_t)args;
+
+  while (true) {
+    const int fd = accept (listen_fd, NULL, NULL);
+    if (0 > fd) {
+      if ((EINTR == errno) || (ECONNABORTED == errno)) continue;
+      OAILOG_ERROR (LOG_MME_APP, "Statistics HTTP endpoint accept failed: %s\n", strerror (errno));
+      break;
+    }
+    mme_app_statistics_http_serve (fd);
+    close (fd);
+  }
+  close (listen_fd);
+  return NULL;
 }
-/*****************************************************/
 
+//------------------------------------------------------------------------------
+int mme_app_statistics_http_start (const uint16_t port)
+{
+  struct sockaddr_in                      addr = {0};
+  const int                               reuse = 1;
+  pthread_t                               thread;
+  pthread_attr_t                          attr;
+  int                                     fd = socket (AF_INET, SOCK_STREAM, 0);
+
+  if (0 > fd) {
+    OAILOG_ERROR (LOG_MME_APP, "Statistics HTTP endpoint socket failed: %s\n", strerror (errno));
+    return RETURNerror;
+  }
+  setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof (reuse));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if ((bind (fd, (struct sockaddr *)&addr, sizeof (addr))) || (listen (fd, 8))) {
+    OAILOG_ERROR (LOG_MME_APP, "Statistics HTTP endpoint on 127.0.0.1:%u failed: %s\n", port, strerror (errno));
+    close (fd);
+    return RETURNerror;
+  }
+  pthread_attr_init (&attr);
+  pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+  if (pthread_create (&thread, &attr, mme_app_statistics_http_thread, (void *)(intptr_t)fd)) {
+    OAILOG_ERROR (LOG_MME_APP, "Statistics HTTP endpoint thread creation failed\n");
+    pthread_attr_destroy (&attr);
+    close (fd);
+    return RETURNerror;
+  }
+  pthread_attr_destroy (&attr);
+  OAILOG_INFO (LOG_MME_APP, "Statistics served on http://127.0.0.1:%u/metrics\n", port);
+  return RETURNok;
+}
@@ -19,6 +19,7 @@
  *      contact@openairinterface.org
  */
 
+
 /*! \file mme_app_statistics.h
   \brief
   \author Sebastien ROUX
@@ -28,18 +29,246 @@
 #ifndef FILE_MME_APP_STATISTICS_SEEN
 #define FILE_MME_APP_STATISTICS_SEEN
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common_types.h"
+
+/* Counters of the MME, name of the metric, help text.
+ * A gauge (connected eNBs, attached UEs, ...) is the difference of an added and a removed counter.
+ */
+#define MME_STATS_COUNTERS(cOUNTER) \
+  cOUNTER(ENB_CONNECTED,              "enb_connected_total",              "eNB S1 setups") \
+  cOUNTER(ENB_RELEASED,               "enb_released_total",               "eNB S1 releases") \
+  cOUNTER(UE_CONNECTED,               "ue_connected_total",               "UE transitions to ECM-CONNECTED") \
+  cOUNTER(UE_DISCONNECTED,            "ue_disconnected_total",            "UE transitions to ECM-IDLE") \
+  cOUNTER(UE_ATTACHED,                "ue_attached_total",                "UE transitions to EMM-REGISTERED") \
+  cOUNTER(UE_DETACHED,                "ue_detached_total",                "UE transitions to EMM-DEREGISTERED") \
+  cOUNTER(UE_IDLE_COMPACTED,          "ue_idle_compacted_total",          "ECM-IDLE UEs compacted into an idle record") \
+  cOUNTER(UE_IDLE_EXPANDED,           "ue_idle_expanded_total",           "Compacted UEs expanded back on lookup") \
+  cOUNTER(UE_BULK_RELEASED,           "ue_bulk_released_total",           "UEs moved to ECM-IDLE by an eNB reset or SCTP loss") \
+  cOUNTER(DEFAULT_BEARER_ESTABLISHED, "default_bearer_established_total", "Default EPS bearers established") \
+  cOUNTER(DEFAULT_BEARER_RELEASED,    "default_bearer_released_total",    "Default EPS bearers released") \
+  cOUNTER(S1U_BEARER_ESTABLISHED,     "s1u_bearer_established_total",     "S1-U bearers established") \
+  cOUNTER(S1U_BEARER_RELEASED,        "s1u_bearer_released_total",        "S1-U bearers released") \
+  cOUNTER(ATTACH_REQUEST,             "attach_request_total",             "Attach requests received") \
+  cOUNTER(ATTACH_ACCEPT,              "attach_accept_total",              "Attach accepts sent") \
+  cOUNTER(ATTACH_REJECT,              "attach_reject_total",              "Attach rejects sent") \
+  cOUNTER(ATTACH_COMPLETE,            "attach_complete_total",            "Attach completes received") \
+  cOUNTER(DETACH_UE_INITIATED,        "detach_ue_initiated_total",        "Detach requests received") \
+  cOUNTER(DETACH_NETWORK_INITIATED,   "detach_network_initiated_total",   "Detach procedures started by the MME") \
+  cOUNTER(TAU_REQUEST,                "tau_request_total",                "Tracking area update requests received") \
+  cOUNTER(TAU_ACCEPT,                 "tau_accept_total",                 "Tracking area update accepts sent") \
+  cOUNTER(TAU_REJECT,                 "tau_reject_total",                 "Tracking area update rejects sent") \
+  cOUNTER(SERVICE_REQUEST,            "service_request_total",            "Service requests received") \
+  cOUNTER(SERVICE_REJECT,             "service_reject_total",             "Service rejects sent") \
+  cOUNTER(PAGING,                     "paging_total",                     "Paging requests sent to S1AP") \
+  cOUNTER(S11_CREATE_SESSION_REQUEST, "s11_create_session_request_total", "S11 create session requests sent") \
+  cOUNTER(S11_CREATE_SESSION_SUCCESS, "s11_create_session_success_total", "S11 create session responses accepted") \
+  cOUNTER(S11_CREATE_SESSION_FAILURE, "s11_create_session_failure_total", "S11 create session responses rejected") \
+  cOUNTER(S11_MODIFY_BEARER_SUCCESS,  "s11_modify_bearer_success_total",  "S11 modify bearer responses accepted") \
+  cOUNTER(S11_MODIFY_BEARER_FAILURE,  "s11_modify_bearer_failure_total",  "S11 modify bearer responses rejected") \
+  cOUNTER(S11_DELETE_SESSION_SUCCESS, "s11_delete_session_success_total", "S11 delete session responses accepted") \
+  cOUNTER(S11_DELETE_SESSION_FAILURE, "s11_delete_session_failure_total", "S11 delete session responses rejected") \
+  cOUNTER(S11_RELEASE_ACCESS_BEARERS_SUCCESS, "s11_release_access_bearers_success_total", "S11 release access bearers responses accepted") \
+  cOUNTER(S11_RELEASE_ACCESS_BEARERS_FAILURE, "s11_release_access_bearers_failure_total", "S11 release access bearers responses rejected") \
+  cOUNTER(S11_DOWNLINK_DATA_NOTIFICATION, "s11_downlink_data_notification_total", "S11 downlink data notifications received") \
+  cOUNTER(S6A_AUTH_INFO_REQUEST,      "s6a_auth_info_request_total",      "S6a authentication information requests sent") \
+  cOUNTER(S6A_AUTH_INFO_SUCCESS,      "s6a_auth_info_success_total",      "S6a authentication information answers with success") \
+  cOUNTER(S6A_AUTH_INFO_FAILURE,      "s6a_auth_info_failure_total",      "S6a authentication information answers with an error") \
+  cOUNTER(S6A_UPDATE_LOCATION_REQUEST,"s6a_update_location_request_total","S6a update location requests sent") \
+  cOUNTER(S6A_UPDATE_LOCATION_SUCCESS,"s6a_update_location_success_total","S6a update location answers with success") \
+  cOUNTER(S6A_UPDATE_LOCATION_FAILURE,"s6a_update_location_failure_total","S6a update location answers with an error") \
+  cOUNTER(S6A_REQUEST_MERGED,         "s6a_request_merged_total",         "S6a AIR and ULR merged into an identical pending request") \
+  cOUNTER(S6A_REQUEST_FAILOVER,       "s6a_request_failover_total",       "S6a AIR and ULR sent again to another HSS") \
+  cOUNTER(S6A_CANCEL_LOCATION,        "s6a_cancel_location_total",        "S6a cancel location requests received")
+
+#define MME_STATS_ENUM(cOUNTER, nAME, hELP)  MME_STATS_##cOUNTER,
+typedef enum mme_stats_counter_e {
+  MME_STATS_COUNTERS(MME_STATS_ENUM)
+  MME_STATS_MAX,
+} mme_stats_counter_t;
+#undef MME_STATS_ENUM
+
+#define MME_STATS_SHARDS_MAX   128
+
+/* Starts of the stages, stamped in the UE context. */
+#define MME_STATS_MARKS(mARK) \
+  mARK(INITIAL_UE_MESSAGE) \
+  mARK(ATTACH_REQUEST) \
+  mARK(ATTACH_ACCEPT) \
+  mARK(S6A_AUTH_INFO_REQUEST) \
+  mARK(S6A_AUTH_INFO_ANSWER) \
+  mARK(S6A_UPDATE_LOCATION_REQUEST) \
+  mARK(S11_CREATE_SESSION_REQUEST) \
+  mARK(S11_MODIFY_BEARER_REQUEST) \
+  mARK(S11_DELETE_SESSION_REQUEST) \
+  mARK(SERVICE_REQUEST) \
+  mARK(TAU_REQUEST)
+
+#define MME_STATS_MARK_ENUM(mARK)  MME_STATS_MARK_##mARK,
+typedef enum mme_stats_mark_e {
+  MME_STATS_MARKS(MME_STATS_MARK_ENUM)
+  MME_STATS_MARK_MAX,
+} mme_stats_mark_t;
+#undef MME_STATS_MARK_ENUM
+
+/* Latencies of the procedures and of their stages, name of the metric, mark of the start, help text.
+ * A latency is recorded once per mark, the mark is cleared when the end of the stage is reached.
+ */
+#define MME_STATS_LATENCIES(lATENCY) \
+  lATENCY(ATTACH,                    "attach",                               ATTACH_REQUEST,              "Attach request to attach complete") \
+  lATENCY(INITIAL_UE_MESSAGE_TO_AIR, "initial_ue_message_to_air",            INITIAL_UE_MESSAGE,          "Initial UE message to S6a authentication information request") \
+  lATENCY(S6A_AUTH_INFO,             "s6a_auth_info",                        S6A_AUTH_INFO_REQUEST,       "S6a authentication information round trip") \
+  lATENCY(AIA_TO_SECURITY_MODE_COMPLETE, "aia_to_security_mode_complete",    S6A_AUTH_INFO_ANSWER,        "S6a authentication information answer to security mode complete") \
+  lATENCY(S6A_UPDATE_LOCATION,       "s6a_update_location",                  S6A_UPDATE_LOCATION_REQUEST, "S6a update location round trip") \
+  lATENCY(S11_CREATE_SESSION,        "s11_create_session",                   S11_CREATE_SESSION_REQUEST,  "S11 create session round trip") \
+  lATENCY(ATTACH_ACCEPT_TO_COMPLETE, "attach_accept_to_complete",            ATTACH_ACCEPT,               "Attach accept to attach complete") \
+  lATENCY(S11_MODIFY_BEARER,         "s11_modify_bearer",                    S11_MODIFY_BEARER_REQUEST,   "S11 modify bearer round trip") \
+  lATENCY(S11_DELETE_SESSION,        "s11_delete_session",                   S11_DELETE_SESSION_REQUEST,  "S11 delete session round trip") \
+  lATENCY(SERVICE_REQUEST,           "service_request",                      SERVICE_REQUEST,             "Service request to S11 modify bearer response") \
+  lATENCY(TAU,                       "tau",                                  TAU_REQUEST,                 "Tracking area update request to accept")
+
+#define MME_STATS_LATENCY_ENUM(lATENCY, nAME, sTART, hELP)  MME_STATS_LATENCY_##lATENCY,
+typedef enum mme_stats_latency_e {
+  MME_STATS_LATENCIES(MME_STATS_LATENCY_ENUM)
+  MME_STATS_LATENCY_MAX,
+} mme_stats_latency_t;
+#undef MME_STATS_LATENCY_ENUM
+
+/* Latency histograms in microseconds, log-linear buckets as in HdrHistogram:
+ * values below 2^MME_STATS_HISTOGRAM_SUB_BITS have their own bucket, above each power of 2 is
+ * split in 2^MME_STATS_HISTOGRAM_SUB_BITS buckets (6.25% of relative error), up to 2^32 us.
+ */
+#define MME_STATS_HISTOGRAM_SUB_BITS     4
+#define MME_STATS_HISTOGRAM_MAX_BITS     32
+#define MME_STATS_HISTOGRAM_BUCKETS      ((MME_STATS_HISTOGRAM_MAX_BITS - MME_STATS_HISTOGRAM_SUB_BITS + 1) << MME_STATS_HISTOGRAM_SUB_BITS)
+
+typedef struct mme_stats_histogram_s {
+  uint64_t     buckets[MME_STATS_HISTOGRAM_BUCKETS];
+  uint64_t     sum_us;
+} mme_stats_histogram_t;
+
+/* Also used by the load generator (src/test/oai_mme_loadgen.c) for its own latencies. */
+static inline uint32_t mme_stats_histogram_index (uint64_t value_us)
+{
+  if (value_us >> MME_STATS_HISTOGRAM_MAX_BITS) {
+    value_us = (UINT64_C(1) << MME_STATS_HISTOGRAM_MAX_BITS) - 1;
+  }
+  if (value_us < (1 << MME_STATS_HISTOGRAM_SUB_BITS)) {
+    return value_us;
+  }
+  const uint32_t msb = 63 - __builtin_clzll (value_us);
+  return ((msb - MME_STATS_HISTOGRAM_SUB_BITS + 1) << MME_STATS_HISTOGRAM_SUB_BITS) +
+      ((value_us >> (msb - MME_STATS_HISTOGRAM_SUB_BITS)) & ((1 << MME_STATS_HISTOGRAM_SUB_BITS) - 1));
+}
+
+// Highest value in microseconds counted in a bucket
+static inline uint64_t mme_stats_histogram_value (const uint32_t index)
+{
+  if (index < (1 << MME_STATS_HISTOGRAM_SUB_BITS)) {
+    return index;
+  }
+  const uint32_t shift = (index >> MME_STATS_HISTOGRAM_SUB_BITS) - 1;
+  const uint64_t sub = (index & ((1 << MME_STATS_HISTOGRAM_SUB_BITS) - 1)) | (1 << MME_STATS_HISTOGRAM_SUB_BITS);
+  return ((sub + 1) << shift) - 1;
+}
+
+static inline uint64_t mme_stats_histogram_count (const mme_stats_histogram_t * const histogram)
+{
+  uint64_t                                count = 0;
+
+  for (int b = 0; b < MME_STATS_HISTOGRAM_BUCKETS; b++) {
+    count += histogram->buckets[b];
+  }
+  return count;
+}
+
+static inline uint64_t mme_stats_histogram_percentile (const mme_stats_histogram_t * const histogram, const uint64_t count, const double percentile)
+{
+  uint64_t                                rank = (uint64_t)((percentile / 100.0) * count + 0.5);
+  uint64_t                                seen = 0;
+
+  if (!count) return 0;
+  if (!rank) rank = 1;
+  for (int b = 0; b < MME_STATS_HISTOGRAM_BUCKETS; b++) {
+    seen += histogram->buckets[b];
+    if (seen >= rank) {
+      return mme_stats_histogram_value (b);
+    }
+  }
+  return mme_stats_histogram_value (MME_STATS_HISTOGRAM_BUCKETS - 1);
+}
+
+/*! \struct  mme_stats_shard_t
+* \brief Counters of a thread, only written by this thread, summed by the readers.
+*/
+typedef struct mme_stats_shard_s {
+  uint64_t     counters[MME_STATS_MAX];
+  mme_stats_histogram_t latencies[MME_STATS_LATENCY_MAX];
+  bool         is_shared;           /*!< \brief Shard of the threads beyond MME_STATS_SHARDS_MAX, updated atomically */
+} __attribute__ ((aligned (64))) mme_stats_shard_t;
+
+extern __thread mme_stats_shard_t *g_mme_stats_shard;
+
+mme_stats_shard_t *mme_stats_new_shard(void);
+
+static inline void mme_stats_add (const mme_stats_counter_t counter, const uint64_t value)
+{
+  mme_stats_shard_t *shard = g_mme_stats_shard;
+
+  if (!shard) {
+    shard = mme_stats_new_shard ();
+  }
+  if (shard->is_shared) {
+    __atomic_fetch_add (&shard->counters[counter], value, __ATOMIC_RELAXED);
+  } else {
+    __atomic_store_n (&shard->counters[counter], shard->counters[counter] + value, __ATOMIC_RELAXED);
+  }
+}
+
+#define mme_stats_inc(cOUNTER)  mme_stats_add (MME_STATS_##cOUNTER, 1)
+
+/*! \fn void mme_stats_mark_ue(const mme_ue_s1ap_id_t ue_id, const mme_stats_mark_t mark)
+ * \brief Stamp the start of a stage in the UE context, if it exists.
+ */
+void mme_stats_mark_ue(const mme_ue_s1ap_id_t ue_id, const mme_stats_mark_t mark);
+
+/*! \fn void mme_stats_latency_ue(const mme_ue_s1ap_id_t ue_id, const mme_stats_latency_t latency)
+ * \brief Record the time elapsed since the start mark of a latency in the UE context, if it was stamped.
+ */
+void mme_stats_latency_ue(const mme_ue_s1ap_id_t ue_id, const mme_stats_latency_t latency);
+
+#define mme_stats_mark(uE_iD, mARK)         mme_stats_mark_ue (uE_iD, MME_STATS_MARK_##mARK)
+#define mme_stats_latency(uE_iD, lATENCY)   mme_stats_latency_ue (uE_iD, MME_STATS_LATENCY_##lATENCY)
+
+/*! \fn uint64_t mme_stats_get_percentile(const mme_stats_latency_t latency, const double percentile, uint64_t * const count)
+ * \brief Value in microseconds of a percentile of a latency, the highest value of its bucket.
+ * \param[out] count Number of values recorded, if not NULL.
+ */
+uint64_t mme_stats_get_percentile(const mme_stats_latency_t latency, const double percentile, uint64_t * const count);
+#define mme_stats_inc_outcome(cOUNTER, sUCCESS) \
+  mme_stats_add ((sUCCESS) ? MME_STATS_##cOUNTER##_SUCCESS : MME_STATS_##cOUNTER##_FAILURE, 1)
+
+uint64_t mme_stats_get(const mme_stats_counter_t counter);
+
 int mme_app_statistics_display(void);
 
+/*! \fn int mme_app_statistics_http_start(const uint16_t port)
+ * \brief Serve the counters in the Prometheus text format on http://127.0.0.1:<port>/metrics.
+ */
+int mme_app_statistics_http_start(const uint16_t port);
+
 /*********************************** Utility Functions to update Statistics**************************************/
-void update_mme_app_stats_connected_enb_add(void);
-void update_mme_app_stats_connected_enb_sub(void);
-void update_mme_app_stats_connected_ue_add(void);
-void update_mme_app_stats_connected_ue_sub(void);
-void update_mme_app_stats_s1u_bearer_add(void);
-void update_mme_app_stats_s1u_bearer_sub(void);
-void update_mme_app_stats_default_bearer_add(void);
-void update_mme_app_stats_default_bearer_sub(void);
-void update_mme_app_stats_attached_ue_add(void);
-void update_mme_app_stats_attached_ue_sub(void);
+#define update_mme_app_stats_connected_enb_add()    mme_stats_inc (ENB_CONNECTED)
+#define update_mme_app_stats_connected_enb_sub()    mme_stats_inc (ENB_RELEASED)
+#define update_mme_app_stats_connected_ue_add()     mme_stats_inc (UE_CONNECTED)
+#define update_mme_app_stats_connected_ue_sub()     mme_stats_inc (UE_DISCONNECTED)
+#define update_mme_app_stats_s1u_bearer_add()       mme_stats_inc (S1U_BEARER_ESTABLISHED)
+#define update_mme_app_stats_s1u_bearer_sub()       mme_stats_inc (S1U_BEARER_RELEASED)
+#define update_mme_app_stats_default_bearer_add()   mme_stats_inc (DEFAULT_BEARER_ESTABLISHED)
+#define update_mme_app_stats_default_bearer_sub()   mme_stats_inc (DEFAULT_BEARER_RELEASED)
+#define update_mme_app_stats_attached_ue_add()      mme_stats_inc (UE_ATTACHED)
+#define update_mme_app_stats_attached_ue_sub()      mme_stats_inc (UE_DETACHED)
 
 #endif /* FILE_MME_APP_STATISTICS_SEEN */
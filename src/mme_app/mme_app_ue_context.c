@@ -302,9 +302,17 @@ mme_ue_s1ap_id_t mme_app_ctx_get_new_ue_id(void)
   return tmp;
 }
 
+//------------------------------------------------------------------------------
+void mme_app_ctx_reserve_ue_id(const mme_ue_s1ap_id_t ue_id)
+{
+  mme_ue_s1ap_id_t next = mme_app_ue_s1ap_id_generator;
+  // a restored UE keeps its id, the next ones are allocated after it
+  while ((next <= ue_id) && (!__sync_bool_compare_and_swap (&mme_app_ue_s1ap_id_generator, next, ue_id + 1))) {
+    next = mme_app_ue_s1ap_id_generator;
+  }
+}
+
 /*
- * Generate the functions to operate inside the bearer pool.
+ * Generate the functions to operate inside the session bearers of a PDN context.
  */
 RB_GENERATE (SessionBearers, bearer_context_s, bearerContextRbtNode, mme_app_compare_bearer_context)
-
-RB_GENERATE (BearerPool, bearer_context_s, bearerContextRbtNode, mme_app_compare_bearer_context)
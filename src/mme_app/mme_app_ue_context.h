@@ -53,6 +53,7 @@
 #include "security_types.h"
 #include "emm_data.h"
 #include "esm_data.h"
+#include "mme_app_statistics.h"
 
 typedef enum {
   ECM_IDLE = 0,
@@ -280,7 +281,7 @@ typedef struct ue_context_s {
 //  bool came_from_tau; /**< For test. */
 
   // todo: ue context mutex
-  pthread_mutex_t recmutex;  // mutex on the ue_context_t
+  pthread_mutex_t mutex;  // mutex on the ue_context_t
 
   /* Basic identifier for ue. IMSI is encoded on maximum of 15 digits of 4 bits,
    * so usage of an unsigned integer on 64 bits is necessary.
@@ -292,10 +293,13 @@ typedef struct ue_context_s {
 
   ecm_state_t             ecm_state;                // ECM state ECM-IDLE, ECM-CONNECTED.
                                                     // not set/read
+  time_t                  ecm_idle_sec;             // CLOCK_MONOTONIC seconds of the last transition to ECM-IDLE
+  struct mme_app_idle_ue_s *idle_ue;                // EMM, PDN and bearer contexts while compacted, see mme_app_idle.h
 
 //  S1ap_Cause_t            s1_ue_context_release_cause;
   // todo: enum s1cause
   enum s1cause            s1_ue_context_release_cause;
+  bool                    s1_bulk_released;         // S1 released by mme_app_bulk_release_ue(), until the UE connects again
 
   // Globally Unique Temporary Identity can be found in emm_nas_context
   //bool                   is_guti_set;                 // is GUTI has been set
@@ -419,12 +423,12 @@ typedef struct ue_context_s {
   network_access_mode_t  access_mode;                  // set by S6A UPDATE LOCATION ANSWER
 
   /*
-   * List of empty bearer context.
-   * Take the bearer contexts from here and put them into the PDN context.
+   * Bearer contexts of the UE by EBI (slot ebi - EPS_BEARER_IDENTITY_FIRST).
+   * A bearer context is allocated when its EBI is given to a PDN connection and released with it,
+   * an empty slot is a free EBI.
    */
-  // todo: check if they are necessary!
   #define MAX_NUM_BEARERS_UE    11 /**< Maximum number of bearers. */
-  RB_HEAD(BearerPool, bearer_context_s) bearer_pool;
+  bearer_context_t      *bearer_contexts[MAX_NUM_BEARERS_UE];
 
   /*
    * List of empty bearer context.
@@ -474,6 +478,9 @@ typedef struct ue_context_s {
   // todo: remove laters
   ebi_t                        next_def_ebi_offset;
 
+  // CLOCK_MONOTONIC time in ns of the start of the stages measured by the statistics, 0 if not started
+  uint64_t                     stats_marks[MME_STATS_MARK_MAX];
+
 } ue_context_t;
 
 
@@ -575,6 +582,12 @@ void mme_ue_context_update_coll_keys(
 
 void mme_ue_context_dump_coll_keys(void);
 
+/** \brief Update the ECM state of a UE, its eNB key and its ECM-IDLE timers
+ **/
+void mme_ue_context_update_ue_sig_connection_state(mme_ue_context_t * const mme_ue_context_p,
+                                                   struct ue_context_s *ue_context,
+                                                   ecm_state_t new_ecm_state);
+
 /** \brief Insert a new UE context in the tree of known UEs.
  * At least the IMSI should be known to insert the context in the tree.
  * \param ue_context_p The UE context to insert
@@ -633,6 +646,10 @@ void mme_app_free_bearer_context(bearer_context_t ** bc);
 
 void mme_app_ue_context_s1_release_enb_informations(ue_context_t *ue_context);
 
+/** \brief Allocate the next MME UE S1AP ids after ue_id (restored UE contexts).
+ **/
+void mme_app_ctx_reserve_ue_id(const mme_ue_s1ap_id_t ue_id);
+
 ambr_t mme_app_total_p_gw_apn_ambr(ue_context_t *ue_context);
 
 ambr_t mme_app_total_p_gw_apn_ambr_rest(ue_context_t *ue_context, pdn_cid_t pci);
@@ -640,8 +657,6 @@ ambr_t mme_app_total_p_gw_apn_ambr_rest(ue_context_t *ue_context, pdn_cid_t pci)
 /* Declaration (prototype) of the function to store pdn and bearer contexts. */
 RB_PROTOTYPE(PdnContexts, pdn_context_s, pdn_ctx_rbt_Node, mme_app_compare_pdn_context)
 
-RB_PROTOTYPE(BearerPool, bearer_context_s, bearer_ctx_rbt_Node, mme_app_compare_bearer_context)
-
 RB_PROTOTYPE(SessionBearers, bearer_context_s, bearer_ctx_rbt_Node, mme_app_compare_bearer_context)
 
 #endif /* FILE_MME_APP_UE_CONTEXT_SEEN */
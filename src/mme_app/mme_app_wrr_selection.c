@@ -31,7 +31,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 
 #include "bstrlib.h"
 
@@ -41,66 +44,211 @@
 #include "dynamic_memory_check.h"
 #include "TrackingAreaIdentity.h"
 #include "mme_config.h"
-#include "mme_app_edns_emulation.h"
+#include "s11_mme.h"
 #include "mme_app_wrr_selection.h"
 
+// The weights are scaled so that the pending Create Session Requests of an SGW can lower them
+#define MME_APP_WRR_LOAD_SCALE 16
+
+// Service of a TAI: MCC and MNC values of the TAI FQDN (3GPP TS 23.003 19.4.2.3), TAC
+#define MME_APP_WRR_KEY(iNTERFACEtYPE, mCC, mNC, tAC) \
+  (((uint64_t)(iNTERFACEtYPE) << 48) | ((uint64_t)(mCC) << 32) | ((uint64_t)(mNC) << 16) | (uint64_t)(tAC))
+
+typedef struct mme_app_wrr_peer_s {
+  struct in_addr                addr;
+  int32_t                       weight;           /* configured weight */
+  int32_t                       current_weight;   /* smooth weighted round robin state */
+} mme_app_wrr_peer_t;
+
+typedef struct mme_app_wrr_service_s {
+  uint64_t                      key;              /* see MME_APP_WRR_KEY() */
+  uint32_t                      first_peer;       /* index in peers */
+  uint32_t                      nb_peers;
+} mme_app_wrr_service_t;
+
+typedef struct mme_app_wrr_table_s {
+  mme_app_wrr_service_t        *services;         /* sorted by key */
+  uint32_t                      nb_services;
+  mme_app_wrr_peer_t           *peers;
+  bool                          load_aware;
+} mme_app_wrr_table_t;
+
+typedef struct mme_app_wrr_entry_s {
+  uint64_t                      key;
+  int                           index;            /* in the configuration, keeps its order among equal keys */
+} mme_app_wrr_entry_t;
+
+// the table is built by mme_app_init before any UE procedure selects a peer, only the WRR state changes afterwards
+static pthread_mutex_t                  mme_app_wrr_lock = PTHREAD_MUTEX_INITIALIZER;
+static mme_app_wrr_table_t              mme_app_wrr_table = {0};
+
 //------------------------------------------------------------------------------
-void mme_app_select_service(const tai_t * const tai, struct in_addr * const service_in_addr, const interface_type_t interface_type)
+static int mme_app_wrr_entry_cmp (const void *a, const void *b)
 {
+  const mme_app_wrr_entry_t * const       ea = (const mme_app_wrr_entry_t *)a;
+  const mme_app_wrr_entry_t * const       eb = (const mme_app_wrr_entry_t *)b;
 
-  // see in 3GPP TS 29.303 version 10.5.0 Release 10:
-  // 5.2 Procedures for Discovering and Selecting an MME or SGW (service: ="x-3gpp-mme:x-s10/s11" )
-  // ....
-
-  // do it the simplest way for now
-  //
-  char tmp[8];
-  bstring application_unique_string = bfromcstr("tac-lb");
-  if (0 < snprintf(tmp, 8, "%02x", tai->tac & 0x00FF)) {
-    bcatcstr(application_unique_string, tmp);
-  } else {
-    service_in_addr->s_addr = 0;
-    return;
+  if (ea->key != eb->key) {
+    return (ea->key < eb->key) ? -1 : 1;
   }
-  bcatcstr(application_unique_string, ".tac-hb");
-  if (0 < snprintf(tmp, 8, "%02x", tai->tac >> 8)) {
-    bcatcstr(application_unique_string, tmp);
-  } else {
-    goto lookup_error;
+  return ea->index - eb->index;
+}
+
+//------------------------------------------------------------------------------
+static int mme_app_wrr_service_cmp (const void *key, const void *service)
+{
+  const uint64_t                          k = *(const uint64_t *)key;
+  const uint64_t                          s = ((const mme_app_wrr_service_t *)service)->key;
+
+  return (k < s) ? -1 : ((k > s) ? 1 : 0);
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_wrr_service_id_key (const_bstring id, const interface_type_t interface_type, uint64_t * const key)
+{
+  unsigned int                            tac_lb = 0;
+  unsigned int                            tac_hb = 0;
+  unsigned int                            mnc = 0;
+  unsigned int                            mcc = 0;
+  int                                     length = 0;
+
+  if ((4 != sscanf ((const char *)id->data, "tac-lb%2x.tac-hb%2x.tac.epc.mnc%3u.mcc%3u.3gppnetwork.org%n", &tac_lb, &tac_hb, &mnc, &mcc, &length))
+      || (length != blength (id))) {
+    return false;
   }
-  bcatcstr(application_unique_string, ".tac.epc.mnc");
-  uint16_t mnc = (tai->plmn.mnc_digit1 *10) + tai->plmn.mnc_digit2;
+  *key = MME_APP_WRR_KEY (interface_type, mcc, mnc, (tac_hb << 8) | tac_lb);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static uint64_t mme_app_wrr_tai_key (const tai_t * const tai, const interface_type_t interface_type)
+{
+  const uint16_t                          mcc = (tai->plmn.mcc_digit1 * 100) + (tai->plmn.mcc_digit2 * 10) + tai->plmn.mcc_digit3;
+  uint16_t                                mnc = (tai->plmn.mnc_digit1 *10) + tai->plmn.mnc_digit2;
+
   if (10 > tai->plmn.mnc_digit3) {
     mnc = (mnc *10) + tai->plmn.mnc_digit3;
   }
-  if (0 < snprintf(tmp, 8, "%03u",mnc)) {
-    bcatcstr(application_unique_string, tmp);
-  } else {
-    goto lookup_error;
+  return MME_APP_WRR_KEY (interface_type, mcc, mnc, tai->tac);
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_wrr_table_free (mme_app_wrr_table_t * const table)
+{
+  free_wrapper ((void**)&table->services);
+  free_wrapper ((void**)&table->peers);
+  table->nb_services = 0;
+}
+
+//------------------------------------------------------------------------------
+int mme_app_wrr_selection_init (const mme_config_t * const mme_config_p)
+{
+  const int                               nb_service_entries = mme_config_p->e_dns_emulation.nb_service_entries;
+  mme_app_wrr_entry_t                    *entries = NULL;
+  mme_app_wrr_table_t                     table = {0};
+  uint32_t                                nb_entries = 0;
+
+  /*
+   * See in 3GPP TS 29.303 version 10.5.0 Release 10:
+   * 5.2 Procedures for Discovering and Selecting an MME or SGW (service: ="x-3gpp-mme:x-s10/s11" )
+   * The configured services are resolved once into a table sorted by TAI, the entries
+   * with the same ID are the peers served weighted round robin.
+   */
+  if (nb_service_entries) {
+    entries = calloc (nb_service_entries, sizeof (mme_app_wrr_entry_t));
+    table.services = calloc (nb_service_entries, sizeof (mme_app_wrr_service_t));
+    table.peers = calloc (nb_service_entries, sizeof (mme_app_wrr_peer_t));
+    if ((!entries) || (!table.services) || (!table.peers)) {
+      free_wrapper ((void**)&entries);
+      mme_app_wrr_table_free (&table);
+      return RETURNerror;
+    }
   }
-  bcatcstr(application_unique_string, ".mcc");
-  if (0 < snprintf(tmp, 8, "%u%u%u",
-      tai->plmn.mcc_digit1,
-      tai->plmn.mcc_digit2,
-      tai->plmn.mcc_digit3)) {
-    bcatcstr(application_unique_string, tmp);
-  } else {
-    goto lookup_error;
+  for (int i = 0; i < nb_service_entries; i++) {
+    const interface_type_t                  interface_type = mme_config_p->e_dns_emulation.interface_type[i];
+
+    if ((INADDR_ANY == mme_config_p->e_dns_emulation.service_ip_addr[i].s_addr) ||
+        ((S11_SGW_GTP_C != interface_type) && (S10_MME_GTP_C != interface_type))) {
+      // Do not halt the config process
+      continue;
+    }
+    if (!mme_app_wrr_service_id_key (mme_config_p->e_dns_emulation.service_id[i], interface_type, &entries[nb_entries].key)) {
+      OAILOG_WARNING (LOG_MME_APP, "Ignoring service %s, not a TAI FQDN\n", bdata (mme_config_p->e_dns_emulation.service_id[i]));
+      continue;
+    }
+    entries[nb_entries++].index = i;
+  }
+  qsort (entries, nb_entries, sizeof (mme_app_wrr_entry_t), mme_app_wrr_entry_cmp);
+
+  for (uint32_t i = 0; i < nb_entries; i++) {
+    mme_app_wrr_peer_t * const              peer = &table.peers[i];
+
+    if ((!table.nb_services) || (table.services[table.nb_services - 1].key != entries[i].key)) {
+      table.services[table.nb_services].key = entries[i].key;
+      table.services[table.nb_services].first_peer = i;
+      table.nb_services++;
+    }
+    table.services[table.nb_services - 1].nb_peers++;
+    peer->addr = mme_config_p->e_dns_emulation.service_ip_addr[entries[i].index];
+    peer->weight = mme_config_p->e_dns_emulation.weight[entries[i].index];
+  }
+  table.load_aware = mme_config_p->sgw_selection_load_aware;
+  free_wrapper ((void**)&entries);
+
+  mme_app_wrr_table = table;
+  OAILOG_INFO (LOG_MME_APP, "Service selection table: %u TAI services, %u peers\n", table.nb_services, nb_entries);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_wrr_selection_exit (void)
+{
+  mme_app_wrr_table_free (&mme_app_wrr_table);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_select_service(const tai_t * const tai, struct in_addr * const service_in_addr, const interface_type_t interface_type)
+{
+  const uint64_t                          key = mme_app_wrr_tai_key (tai, interface_type);
+  mme_app_wrr_service_t                  *service = NULL;
+  mme_app_wrr_peer_t                     *selected = NULL;
+
+  service = bsearch (&key, mme_app_wrr_table.services, mme_app_wrr_table.nb_services, sizeof (mme_app_wrr_service_t), mme_app_wrr_service_cmp);
+  if (!service) {
+    OAILOG_DEBUG (LOG_MME_APP, "No service entry for TAI " TAI_FMT "\n", TAI_ARG(tai));
+    return;
   }
-  bcatcstr(application_unique_string, ".3gppnetwork.org");
 
-  struct in_addr* entry = mme_app_edns_get_wrr_entry(application_unique_string, interface_type);
+  if (1 == service->nb_peers) {
+    selected = &mme_app_wrr_table.peers[service->first_peer];
+    service_in_addr->s_addr = selected->addr.s_addr;
+  } else {
+    int32_t                                 total_weight = 0;
+
+    /*
+     * Smooth weighted round robin: the peers of a weight twice bigger are selected twice
+     * more often, interleaved with the others. The NAS and MME_APP tasks both select.
+     */
+    pthread_mutex_lock (&mme_app_wrr_lock);
+    for (uint32_t i = service->first_peer; i < (service->first_peer + service->nb_peers); i++) {
+      mme_app_wrr_peer_t * const              peer = &mme_app_wrr_table.peers[i];
+      int32_t                                 weight = peer->weight * MME_APP_WRR_LOAD_SCALE;
 
-  if (entry) {
-    service_in_addr->s_addr = entry->s_addr;
+      if ((mme_app_wrr_table.load_aware) && (S11_SGW_GTP_C == interface_type)) {
+        weight = weight / (int32_t)(1 + s11_mme_nb_pending_create_sessions (peer->addr));
+        if (!weight) {
+          weight = 1;
+        }
+      }
+      peer->current_weight += weight;
+      total_weight += weight;
+      if ((!selected) || (peer->current_weight > selected->current_weight)) {
+        selected = peer;
+      }
+    }
+    selected->current_weight -= total_weight;
+    service_in_addr->s_addr = selected->addr.s_addr;
+    pthread_mutex_unlock (&mme_app_wrr_lock);
   }
-  OAILOG_DEBUG (LOG_MME_APP, "Service lookup %s returned %s\n", application_unique_string->data, inet_ntoa (*service_in_addr));
-  bdestroy_wrapper(&application_unique_string);
-  return;
-
-lookup_error:
-  OAILOG_WARNING (LOG_MME_APP, "Failed service lookup for TAI " TAI_FMT "\n", TAI_ARG(tai));
-  service_in_addr->s_addr = 0;
-  bdestroy_wrapper(&application_unique_string);
-  return;
+  OAILOG_DEBUG (LOG_MME_APP, "Service lookup for TAI " TAI_FMT " returned %s\n", TAI_ARG(tai), inet_ntoa (*service_in_addr));
 }
@@ -30,6 +30,18 @@
   \email: lionel.gauthier@eurecom.fr
 */
 
+struct mme_config_s;
+
+/*! \fn int mme_app_wrr_selection_init(const struct mme_config_s * const mme_config_p)
+ * \brief Build the TAI indexed selection table from the WRR_LIST_SELECTION entries, once at init.
+ */
+int mme_app_wrr_selection_init(const struct mme_config_s * const mme_config_p);
+
+void mme_app_wrr_selection_exit(void);
+
+/*! \fn void mme_app_select_service(const tai_t * const tai, struct in_addr * const mme_in_addr, const interface_type_t interface_type)
+ * \brief Next peer of the TAI for the interface, weighted round robin. The address is left unchanged if none.
+ */
 void mme_app_select_service(const tai_t * const tai, struct in_addr * const mme_in_addr, const interface_type_t interface_type);
 
 #endif
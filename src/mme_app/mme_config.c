@@ -47,8 +47,10 @@
 #include "log.h"
 #include "conversions.h"
 #include "intertask_interface.h"
+#include "intertask_interface_capture.h"
 #include "common_defs.h"
 #include "mme_config.h"
+#include "mme_app_checkpoint.h"
 #include "spgw_config.h"
 #include "s1ap_mme_ta.h"
 
@@ -163,6 +165,7 @@ static void mme_config_init (mme_config_t * config_pP)
   pthread_rwlock_init (&config_pP->rw_lock, NULL);
   config_pP->log_config.output             = NULL;
   config_pP->log_config.is_output_thread_safe = false;
+  config_pP->log_config.binary_output      = NULL;
   config_pP->log_config.color              = false;
   config_pP->log_config.udp_log_level      = MAX_LOG_LEVEL; // Means invalid
   config_pP->log_config.gtpv1u_log_level   = MAX_LOG_LEVEL; // will not overwrite existing log levels if MME and S-GW bundled in same executable
@@ -212,10 +215,33 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->s6a_config.conf_file = bfromcstr(S6A_CONF_FILE);
   config_pP->itti_config.queue_size = ITTI_QUEUE_MAX_ELEMENTS;
   config_pP->itti_config.log_file = NULL;
+  config_pP->itti_config.capture_file = NULL;
+  config_pP->itti_config.capture_file_size = ITTI_CAPTURE_FILE_SIZE_DEFAULT / (1024*1024);
+  config_pP->itti_config.capture_max_files = ITTI_CAPTURE_MAX_FILES_DEFAULT;
+  config_pP->itti_config.replay_file = NULL;
+  config_pP->itti_config.replay_task = NULL;
+  config_pP->itti_config.replay_max_speed = false;
+  config_pP->itti_config.overload_policy = ITTI_OVERLOAD_POLICY_BLOCK;
+  config_pP->itti_config.overload_block_timeout = ITTI_OVERLOAD_BLOCK_TIMEOUT_DEFAULT;
+  config_pP->itti_config.overload_drop_priority = MESSAGE_PRIORITY_MED_PLUS;
+  config_pP->itti_config.overload_signal_task = NULL;
   config_pP->sctp_config.in_streams = SCTP_IN_STREAMS;
   config_pP->sctp_config.out_streams = SCTP_OUT_STREAMS;
+  config_pP->udp_config.batch_size = UDP_BATCH_SIZE_DEFAULT;
+  config_pP->udp_config.reuse_port = false;
+  config_pP->benchmark_config.stub_hss = false;
+  config_pP->benchmark_config.stub_sgw = false;
+  config_pP->benchmark_config.stub_apn = bfromcstr("internet");
+  config_pP->benchmark_config.stub_sgw_ddn_percent = 0;
+  config_pP->benchmark_config.stub_sgw_ddn_delay_ms = 1000;
   config_pP->relative_capacity = RELATIVE_CAPACITY;
   config_pP->mme_statistic_timer = MME_STATISTIC_TIMER_S;
+  config_pP->mme_statistic_http_port = 0;
+  config_pP->checkpoint_file = NULL;
+  config_pP->checkpoint_timer = MME_APP_CHECKPOINT_TIMER_DEFAULT;
+  config_pP->idle_compaction_timer = 0;
+  config_pP->bulk_release_rate = 2000;
+  config_pP->sgw_selection_load_aware = false;
 
   // todo: sgw address?
 //  config_pP->ipv4.sgw_s11 = 0;
@@ -270,7 +296,9 @@ void mme_config_exit (void)
 {
   pthread_rwlock_destroy (&mme_config.rw_lock);
   bdestroy_wrapper(&mme_config.log_config.output);
+  bdestroy_wrapper(&mme_config.log_config.binary_output);
   bdestroy_wrapper(&mme_config.realm);
+  bdestroy_wrapper(&mme_config.checkpoint_file);
   bdestroy_wrapper(&mme_config.config_file);
 
   /*
@@ -280,7 +308,15 @@ void mme_config_exit (void)
   bdestroy_wrapper(&mme_config.ipv4.if_name_s11);
   bdestroy_wrapper(&mme_config.s6a_config.conf_file);
   bdestroy_wrapper(&mme_config.s6a_config.hss_host_name);
+  for (int i = 0; i < mme_config.s6a_config.nb_hss_peers; i++) {
+    bdestroy_wrapper(&mme_config.s6a_config.hss_peers[i].host_name);
+  }
+  bdestroy_wrapper(&mme_config.benchmark_config.stub_apn);
   bdestroy_wrapper(&mme_config.itti_config.log_file);
+  bdestroy_wrapper(&mme_config.itti_config.capture_file);
+  bdestroy_wrapper(&mme_config.itti_config.replay_file);
+  bdestroy_wrapper(&mme_config.itti_config.replay_task);
+  bdestroy_wrapper(&mme_config.itti_config.overload_signal_task);
 
   free_wrapper((void**)&mme_config.served_tai.plmn_mcc);
   free_wrapper((void**)&mme_config.served_tai.plmn_mnc);
@@ -376,6 +412,16 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         }
       }
 
+      if (config_setting_lookup_string (setting, LOG_CONFIG_STRING_BINARY_OUTPUT, (const char **)&astring)) {
+        if ((astring != NULL) && (strlen (astring))) {
+          if (config_pP->log_config.binary_output) {
+            bassigncstr(config_pP->log_config.binary_output , astring);
+          } else {
+            config_pP->log_config.binary_output = bfromcstr(astring);
+          }
+        }
+      }
+
       if (config_setting_lookup_string (setting, LOG_CONFIG_STRING_COLOR, (const char **)&astring)) {
         if (0 == strcasecmp("yes", astring)) config_pP->log_config.color = true;
         else config_pP->log_config.color = false;
@@ -477,6 +523,36 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       config_pP->mme_statistic_timer = (uint32_t) aint;
     }
 
+    if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_STATISTIC_HTTP_PORT, &aint))) {
+      AssertFatal ((0 <= aint) && (65536 > aint), "Bad statistics HTTP port %d\n", aint);
+      config_pP->mme_statistic_http_port = (uint16_t) aint;
+    }
+
+    if ((config_setting_lookup_string (setting_mme, MME_CONFIG_STRING_CHECKPOINT_FILE, (const char **)&astring))) {
+      if (strlen (astring)) {
+        config_pP->checkpoint_file = bfromcstr (astring);
+      }
+    }
+
+    if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_CHECKPOINT_TIMER, &aint))) {
+      AssertFatal (0 < aint, "Bad checkpoint timer %d\n", aint);
+      config_pP->checkpoint_timer = (uint32_t) aint;
+    }
+
+    if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_IDLE_COMPACTION_TIMER, &aint))) {
+      AssertFatal (0 <= aint, "Bad idle compaction timer %d\n", aint);
+      config_pP->idle_compaction_timer = (uint32_t) aint;
+    }
+
+    if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_BULK_RELEASE_RATE, &aint))) {
+      AssertFatal (0 <= aint, "Bad bulk release rate %d\n", aint);
+      config_pP->bulk_release_rate = (uint32_t) aint;
+    }
+
+    if ((config_setting_lookup_string (setting_mme, MME_CONFIG_STRING_SGW_SELECTION_LOAD_AWARE, (const char **)&astring))) {
+      config_pP->sgw_selection_load_aware = (strcasecmp (astring, "yes") == 0);
+    }
+
     if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_MME_MOBILITY_COMPLETION_TIMER, &aint))) {
       config_pP->mme_mobility_completion_timer = (uint32_t) aint;
     }
@@ -531,6 +607,50 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE, &aint))) {
         config_pP->itti_config.queue_size = (uint32_t) aint;
       }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_CAPTURE_FILE, (const char **)&astring))) {
+        config_pP->itti_config.capture_file = bfromcstr (astring);
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_CAPTURE_FILE_SIZE, &aint))) {
+        AssertFatal ((0 < aint) && (4096 > aint), "Bad ITTI capture file size %d MB\n", aint);
+        config_pP->itti_config.capture_file_size = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_CAPTURE_MAX_FILES, &aint))) {
+        config_pP->itti_config.capture_max_files = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_REPLAY_FILE, (const char **)&astring))) {
+        config_pP->itti_config.replay_file = bfromcstr (astring);
+      }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_REPLAY_TASK, (const char **)&astring))) {
+        config_pP->itti_config.replay_task = bfromcstr (astring);
+      }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_REPLAY_MAX_SPEED, (const char **)&astring))) {
+        config_pP->itti_config.replay_max_speed = (strcasecmp (astring, "yes") == 0);
+      }
+      // the capture starts by removing the files of its prefix
+      AssertFatal ((!config_pP->itti_config.capture_file) || (!config_pP->itti_config.replay_file) ||
+          (!itti_capture_is_same_prefix (bdata(config_pP->itti_config.capture_file), bdata(config_pP->itti_config.replay_file))),
+          "ITTI capture and replay files can not have the same prefix %s\n", bdata(config_pP->itti_config.capture_file));
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_OVERLOAD_POLICY, (const char **)&astring))) {
+        static const char * const policies[ITTI_OVERLOAD_POLICY_MAX] = ITTI_OVERLOAD_POLICY_STRINGS;
+        config_pP->itti_config.overload_policy = ITTI_OVERLOAD_POLICY_MAX;
+        for (int i = 0; i < ITTI_OVERLOAD_POLICY_MAX; i++) {
+          if (strcasecmp (astring, policies[i]) == 0) {
+            config_pP->itti_config.overload_policy = i;
+          }
+        }
+        AssertFatal (ITTI_OVERLOAD_POLICY_MAX != config_pP->itti_config.overload_policy, "Bad ITTI overload policy %s (BLOCK, DROP or SIGNAL)\n", astring);
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_OVERLOAD_BLOCK_TIMEOUT, &aint))) {
+        AssertFatal (0 <= aint, "Bad ITTI overload block timeout %d ms\n", aint);
+        config_pP->itti_config.overload_block_timeout = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_OVERLOAD_DROP_PRIORITY, &aint))) {
+        AssertFatal ((MESSAGE_PRIORITY_MIN <= aint) && (MESSAGE_PRIORITY_MAX >= aint), "Bad ITTI overload drop priority %d\n", aint);
+        config_pP->itti_config.overload_drop_priority = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_OVERLOAD_SIGNAL_TASK, (const char **)&astring))) {
+        config_pP->itti_config.overload_signal_task = bfromcstr (astring);
+      }
     }
     // S6A SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_S6A_CONFIG);
@@ -568,6 +688,47 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         } else
           AssertFatal (1 == 0, "You have to provide a valid MME hostname %s=...\n", MME_CONFIG_STRING_S6A_MME_HOSTNAME);
       }
+
+      for (i = 0; i < config_pP->s6a_config.nb_hss_peers; i++) {
+        bdestroy_wrapper (&config_pP->s6a_config.hss_peers[i].host_name);
+      }
+      config_pP->s6a_config.nb_hss_peers = 0;
+
+      if (config_pP->s6a_config.hss_host_name) {
+        config_pP->s6a_config.hss_peers[0].host_name = bstrcpy (config_pP->s6a_config.hss_host_name);
+        config_pP->s6a_config.hss_peers[0].weight = 1;
+        if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_HSS_WEIGHT, &aint))) {
+          AssertFatal (0 < aint, "Bad HSS weight %d\n", aint);
+          config_pP->s6a_config.hss_peers[0].weight = (uint32_t) aint;
+        }
+        config_pP->s6a_config.nb_hss_peers = 1;
+      }
+
+      subsetting = config_setting_get_member (setting, MME_CONFIG_STRING_S6A_HSS_PEERS);
+      if (subsetting != NULL) {
+        num = config_setting_length (subsetting);
+        AssertFatal ((config_pP->s6a_config.nb_hss_peers + num) <= MAX_HSS_PEERS, "Too many HSS peers configured %d\n", config_pP->s6a_config.nb_hss_peers + num);
+
+        for (i = 0; i < num; i++) {
+          sub2setting = config_setting_get_elem (subsetting, i);
+
+          if (sub2setting != NULL) {
+            const int n = config_pP->s6a_config.nb_hss_peers;
+
+            if ((config_setting_lookup_string (sub2setting, MME_CONFIG_STRING_S6A_HSS_HOSTNAME, (const char **)&astring)) && (astring != NULL)) {
+              config_pP->s6a_config.hss_peers[n].host_name = bfromcstr (astring);
+            } else {
+              AssertFatal (1 == 0, "You have to provide a valid HSS hostname in %s %s=...\n", MME_CONFIG_STRING_S6A_HSS_PEERS, MME_CONFIG_STRING_S6A_HSS_HOSTNAME);
+            }
+            config_pP->s6a_config.hss_peers[n].weight = 1;
+            if ((config_setting_lookup_int (sub2setting, MME_CONFIG_STRING_S6A_WEIGHT, &aint))) {
+              AssertFatal (0 < aint, "Bad HSS weight %d\n", aint);
+              config_pP->s6a_config.hss_peers[n].weight = (uint32_t) aint;
+            }
+            config_pP->s6a_config.nb_hss_peers++;
+          }
+        }
+      }
     }
     // SCTP SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_SCTP_CONFIG);
@@ -581,6 +742,55 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         config_pP->sctp_config.out_streams = (uint16_t) aint;
       }
     }
+    // UDP SETTING
+    setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_UDP_CONFIG);
+
+    if (setting != NULL) {
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_UDP_BATCH_SIZE, &aint))) {
+        AssertFatal ((aint > 0) && (aint <= UDP_BATCH_SIZE_MAX), "%s must be in [1..%d]\n", MME_CONFIG_STRING_UDP_BATCH_SIZE, UDP_BATCH_SIZE_MAX);
+        config_pP->udp_config.batch_size = (uint16_t) aint;
+      }
+
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_UDP_REUSE_PORT, (const char **)&astring))) {
+        if (strcasecmp (astring, "yes") == 0)
+          config_pP->udp_config.reuse_port = true;
+        else
+          config_pP->udp_config.reuse_port = false;
+      }
+    }
+    // BENCHMARK SETTING
+    setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_BENCHMARK_CONFIG);
+
+    if (setting != NULL) {
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_BENCHMARK_STUB_HSS, (const char **)&astring))) {
+        if (strcasecmp (astring, "yes") == 0)
+          config_pP->benchmark_config.stub_hss = true;
+        else
+          config_pP->benchmark_config.stub_hss = false;
+      }
+
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_BENCHMARK_STUB_SGW, (const char **)&astring))) {
+        if (strcasecmp (astring, "yes") == 0)
+          config_pP->benchmark_config.stub_sgw = true;
+        else
+          config_pP->benchmark_config.stub_sgw = false;
+      }
+
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_BENCHMARK_STUB_APN, (const char **)&astring))) {
+        if (astring != NULL) {
+          bassigncstr(config_pP->benchmark_config.stub_apn , astring);
+        }
+      }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_BENCHMARK_STUB_SGW_DDN_PERCENT, &aint))) {
+        AssertFatal ((aint >= 0) && (aint <= 100), "%s must be in [0..100]\n", MME_CONFIG_STRING_BENCHMARK_STUB_SGW_DDN_PERCENT);
+        config_pP->benchmark_config.stub_sgw_ddn_percent = (uint32_t) aint;
+      }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_BENCHMARK_STUB_SGW_DDN_DELAY, &aint))) {
+        config_pP->benchmark_config.stub_sgw_ddn_delay_ms = (uint32_t) aint;
+      }
+    }
     // S1AP SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_S1AP_CONFIG);
 
@@ -944,6 +1154,11 @@ static int mme_config_parse_file (mme_config_t * config_pP)
           break;
         }
         config_pP->e_dns_emulation.service_id[i] = bfromcstr(id);
+        config_pP->e_dns_emulation.weight[i] = 1;
+        if ((config_setting_lookup_int (sub2setting, MME_CONFIG_STRING_WEIGHT, &aint))) {
+          AssertFatal ((0 < aint) && (256 > aint), "Bad WRR weight %d for service %s\n", aint, id);
+          config_pP->e_dns_emulation.weight[i] = (uint8_t) aint;
+        }
 
         /** Check S11 Endpoint (service="x-3gpp-sgw:x-s11"). */
         if ((config_setting_lookup_string (sub2setting, SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S11, (const char **)&sgw_ip_address_for_s11)
@@ -1041,7 +1256,24 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- Extended service request .............: %s\n", config_pP->eps_network_feature_support.extended_service_request == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Unauth IMSI support ..................: %s\n", config_pP->unauthenticated_imsi_supported == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Relative capa ........................: %u\n", config_pP->relative_capacity);
-  OAILOG_INFO (LOG_CONFIG, "- Statistics timer .....................: %u (seconds)\n\n", config_pP->mme_statistic_timer);
+  OAILOG_INFO (LOG_CONFIG, "- Statistics timer .....................: %u (seconds)\n", config_pP->mme_statistic_timer);
+  OAILOG_INFO (LOG_CONFIG, "- Statistics HTTP port .................: %u%s\n", config_pP->mme_statistic_http_port, (config_pP->mme_statistic_http_port) ? "" : " (disabled)");
+  if (config_pP->checkpoint_file) {
+    OAILOG_INFO (LOG_CONFIG, "- UE contexts checkpoint ...............: %s every %u seconds\n", bdata(config_pP->checkpoint_file), config_pP->checkpoint_timer);
+  } else {
+    OAILOG_INFO (LOG_CONFIG, "- UE contexts checkpoint ...............: disabled\n");
+  }
+  if (config_pP->idle_compaction_timer) {
+    OAILOG_INFO (LOG_CONFIG, "- Idle UE compaction ...................: after %u seconds in ECM-IDLE\n", config_pP->idle_compaction_timer);
+  } else {
+    OAILOG_INFO (LOG_CONFIG, "- Idle UE compaction ...................: disabled\n");
+  }
+  if (config_pP->bulk_release_rate) {
+    OAILOG_INFO (LOG_CONFIG, "- eNB reset/loss S11 releases ..........: %u per second\n", config_pP->bulk_release_rate);
+  } else {
+    OAILOG_INFO (LOG_CONFIG, "- eNB reset/loss S11 releases ..........: no limit\n");
+  }
+  OAILOG_INFO (LOG_CONFIG, "- SGW selection ........................: %s\n\n", (config_pP->sgw_selection_load_aware) ? "weighted, load aware" : "weighted");
   OAILOG_INFO (LOG_CONFIG, "- S1-MME:\n");
   OAILOG_INFO (LOG_CONFIG, "    port number ......: %d\n", config_pP->s1ap_config.port_number);
   OAILOG_INFO (LOG_CONFIG, "- IP:\n");
@@ -1056,9 +1288,35 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- ITTI:\n");
   OAILOG_INFO (LOG_CONFIG, "    queue size .......: %u (bytes)\n", config_pP->itti_config.queue_size);
   OAILOG_INFO (LOG_CONFIG, "    log file .........: %s\n", bdata(config_pP->itti_config.log_file));
+  if (config_pP->itti_config.capture_file) {
+    OAILOG_INFO (LOG_CONFIG, "    capture file .....: %s (%u files of %u MB)\n", bdata(config_pP->itti_config.capture_file),
+        config_pP->itti_config.capture_max_files, config_pP->itti_config.capture_file_size);
+  }
+  if (config_pP->itti_config.replay_file) {
+    OAILOG_INFO (LOG_CONFIG, "    replay file ......: %s to %s at %s speed\n", bdata(config_pP->itti_config.replay_file),
+        bdata(config_pP->itti_config.replay_task), (config_pP->itti_config.replay_max_speed) ? "maximum" : "original");
+  }
+  {
+    static const char * const policies[ITTI_OVERLOAD_POLICY_MAX] = ITTI_OVERLOAD_POLICY_STRINGS;
+    OAILOG_INFO (LOG_CONFIG, "    overload policy ..: %s (block timeout %u ms, drop priority < %u, signal task %s)\n",
+        policies[config_pP->itti_config.overload_policy], config_pP->itti_config.overload_block_timeout,
+        config_pP->itti_config.overload_drop_priority,
+        (config_pP->itti_config.overload_signal_task) ? bdata(config_pP->itti_config.overload_signal_task) : "TASK_S1AP");
+  }
   OAILOG_INFO (LOG_CONFIG, "- SCTP:\n");
   OAILOG_INFO (LOG_CONFIG, "    in streams .......: %u\n", config_pP->sctp_config.in_streams);
   OAILOG_INFO (LOG_CONFIG, "    out streams ......: %u\n", config_pP->sctp_config.out_streams);
+  OAILOG_INFO (LOG_CONFIG, "- UDP:\n");
+  OAILOG_INFO (LOG_CONFIG, "    batch size .......: %u\n", config_pP->udp_config.batch_size);
+  OAILOG_INFO (LOG_CONFIG, "    reuse port .......: %s\n", (config_pP->udp_config.reuse_port) ? "true":"false");
+  if ((config_pP->benchmark_config.stub_hss) || (config_pP->benchmark_config.stub_sgw)) {
+    OAILOG_INFO (LOG_CONFIG, "- BENCHMARK:\n");
+    OAILOG_INFO (LOG_CONFIG, "    HSS stub .........: %s\n", (config_pP->benchmark_config.stub_hss) ? "true":"false");
+    OAILOG_INFO (LOG_CONFIG, "    SGW stub .........: %s\n", (config_pP->benchmark_config.stub_sgw) ? "true":"false");
+    OAILOG_INFO (LOG_CONFIG, "    stub APN .........: %s\n", bdata(config_pP->benchmark_config.stub_apn));
+    OAILOG_INFO (LOG_CONFIG, "    DDN percent ......: %u\n", config_pP->benchmark_config.stub_sgw_ddn_percent);
+    OAILOG_INFO (LOG_CONFIG, "    DDN delay ........: %u ms\n", config_pP->benchmark_config.stub_sgw_ddn_delay_ms);
+  }
   OAILOG_INFO (LOG_CONFIG, "- GUMMEIs (PLMN|MMEGI|MMEC):\n");
   for (j = 0; j < config_pP->gummei.nb; j++) {
     OAILOG_INFO (LOG_CONFIG, "            " PLMN_FMT "|%u|%u \n",
@@ -1116,10 +1374,16 @@ static void mme_config_display (mme_config_t * config_pP)
 
   OAILOG_INFO (LOG_CONFIG, "- S6A:\n");
   OAILOG_INFO (LOG_CONFIG, "    conf file ........: %s\n", bdata(config_pP->s6a_config.conf_file));
+  for (j = 0; j < config_pP->s6a_config.nb_hss_peers; j++) {
+    OAILOG_INFO (LOG_CONFIG, "    HSS peer .........: %s weight %u\n", bdata(config_pP->s6a_config.hss_peers[j].host_name), config_pP->s6a_config.hss_peers[j].weight);
+  }
   OAILOG_INFO (LOG_CONFIG, "- Logging:\n");
   OAILOG_INFO (LOG_CONFIG, "    Output ..............: %s\n", bdata(config_pP->log_config.output));
   OAILOG_INFO (LOG_CONFIG, "    Output thread safe ..: %s\n", (config_pP->log_config.is_output_thread_safe) ? "true":"false");
   OAILOG_INFO (LOG_CONFIG, "    Output with color ...: %s\n", (config_pP->log_config.color) ? "true":"false");
+  if (config_pP->log_config.binary_output) {
+    OAILOG_INFO (LOG_CONFIG, "    Binary output .......: %s\n", bdata(config_pP->log_config.binary_output));
+  }
   OAILOG_INFO (LOG_CONFIG, "    UDP log level........: %s\n", OAILOG_LEVEL_INT2STR(config_pP->log_config.udp_log_level));
   OAILOG_INFO (LOG_CONFIG, "    GTPV2-C log level....: %s\n", OAILOG_LEVEL_INT2STR(config_pP->log_config.gtpv2c_log_level));
   OAILOG_INFO (LOG_CONFIG, "    SCTP log level.......: %s\n", OAILOG_LEVEL_INT2STR(config_pP->log_config.sctp_log_level));
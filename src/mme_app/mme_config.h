@@ -39,6 +39,7 @@
 #include "log.h"
 
 #define MAX_GUMMEI                2
+#define MAX_HSS_PEERS             8
 
 #define MME_CONFIG_STRING_MME_CONFIG                     "MME"
 #define MME_CONFIG_STRING_PID_DIRECTORY                  "PID_DIRECTORY"
@@ -53,6 +54,12 @@
 #define MME_CONFIG_STRING_MAXUE                          "MAXUE"
 #define MME_CONFIG_STRING_RELATIVE_CAPACITY              "RELATIVE_CAPACITY"
 #define MME_CONFIG_STRING_STATISTIC_TIMER                "MME_STATISTIC_TIMER"
+#define MME_CONFIG_STRING_STATISTIC_HTTP_PORT            "MME_STATISTIC_HTTP_PORT"
+#define MME_CONFIG_STRING_CHECKPOINT_FILE                "MME_CHECKPOINT_FILE"
+#define MME_CONFIG_STRING_CHECKPOINT_TIMER               "MME_CHECKPOINT_TIMER"
+#define MME_CONFIG_STRING_IDLE_COMPACTION_TIMER          "MME_IDLE_COMPACTION_TIMER"
+#define MME_CONFIG_STRING_BULK_RELEASE_RATE              "MME_BULK_RELEASE_RATE"
+#define MME_CONFIG_STRING_SGW_SELECTION_LOAD_AWARE       "MME_SGW_SELECTION_LOAD_AWARE"
 #define MME_CONFIG_STRING_MME_MOBILITY_COMPLETION_TIMER  "MME_MOBILITY_COMPLETION_TIMER"
 #define MME_CONFIG_STRING_MME_S10_HANDOVER_COMPLETION_TIMER  "MME_S10_HANDOVER_COMPLETION_TIMER"
 
@@ -68,16 +75,40 @@
 
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG     "INTERTASK_INTERFACE"
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE "ITTI_QUEUE_SIZE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_CAPTURE_FILE      "ITTI_CAPTURE_FILE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_CAPTURE_FILE_SIZE "ITTI_CAPTURE_FILE_SIZE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_CAPTURE_MAX_FILES "ITTI_CAPTURE_MAX_FILES"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_REPLAY_FILE       "ITTI_REPLAY_FILE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_REPLAY_TASK       "ITTI_REPLAY_TASK"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_REPLAY_MAX_SPEED  "ITTI_REPLAY_MAX_SPEED"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_OVERLOAD_POLICY   "ITTI_OVERLOAD_POLICY"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_OVERLOAD_BLOCK_TIMEOUT "ITTI_OVERLOAD_BLOCK_TIMEOUT"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_OVERLOAD_DROP_PRIORITY "ITTI_OVERLOAD_DROP_PRIORITY"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_OVERLOAD_SIGNAL_TASK   "ITTI_OVERLOAD_SIGNAL_TASK"
 
 #define MME_CONFIG_STRING_S6A_CONFIG                     "S6A"
 #define MME_CONFIG_STRING_S6A_CONF_FILE_PATH             "S6A_CONF"
 #define MME_CONFIG_STRING_S6A_HSS_HOSTNAME               "HSS_HOSTNAME"
 #define MME_CONFIG_STRING_S6A_MME_HOSTNAME               "MME_HOSTNAME"
+#define MME_CONFIG_STRING_S6A_HSS_WEIGHT                 "HSS_WEIGHT"
+#define MME_CONFIG_STRING_S6A_HSS_PEERS                  "HSS_PEERS"
+#define MME_CONFIG_STRING_S6A_WEIGHT                     "WEIGHT"
 
 #define MME_CONFIG_STRING_SCTP_CONFIG                    "SCTP"
 #define MME_CONFIG_STRING_SCTP_INSTREAMS                 "SCTP_INSTREAMS"
 #define MME_CONFIG_STRING_SCTP_OUTSTREAMS                "SCTP_OUTSTREAMS"
 
+#define MME_CONFIG_STRING_UDP_CONFIG                     "UDP"
+#define MME_CONFIG_STRING_UDP_BATCH_SIZE                 "UDP_BATCH_SIZE"
+#define MME_CONFIG_STRING_UDP_REUSE_PORT                 "UDP_REUSE_PORT"
+
+#define MME_CONFIG_STRING_BENCHMARK_CONFIG               "BENCHMARK"
+#define MME_CONFIG_STRING_BENCHMARK_STUB_HSS             "STUB_HSS"
+#define MME_CONFIG_STRING_BENCHMARK_STUB_SGW             "STUB_SGW"
+#define MME_CONFIG_STRING_BENCHMARK_STUB_APN             "STUB_APN"
+#define MME_CONFIG_STRING_BENCHMARK_STUB_SGW_DDN_PERCENT "STUB_SGW_DDN_PERCENT"
+#define MME_CONFIG_STRING_BENCHMARK_STUB_SGW_DDN_DELAY   "STUB_SGW_DDN_DELAY"
+
 
 #define MME_CONFIG_STRING_S1AP_CONFIG                    "S1AP"
 #define MME_CONFIG_STRING_S1AP_OUTCOME_TIMER             "S1AP_OUTCOME_TIMER"
@@ -137,6 +168,7 @@
 //#define MME_CONFIG_STRING_MME_LIST_SELECTION             "MME_LIST_SELECTION"
 
 #define MME_CONFIG_STRING_ID                             "ID"
+#define MME_CONFIG_STRING_WEIGHT                         "WEIGHT"
 
 typedef enum {
    RUN_MODE_BASIC,
@@ -166,6 +198,12 @@ typedef struct mme_config_s {
   uint8_t relative_capacity;
 
   uint32_t mme_statistic_timer;
+  uint16_t mme_statistic_http_port;   // Prometheus endpoint on 127.0.0.1, 0 to disable
+  bstring  checkpoint_file;           // UE contexts saved and restored at startup, NULL to disable
+  uint32_t checkpoint_timer;
+  uint32_t idle_compaction_timer;     // seconds in ECM-IDLE before a UE is compacted, 0 to disable
+  uint32_t bulk_release_rate;         // S11 Release Access Bearers per second after an eNB reset or loss, 0 for no limit
+  bool     sgw_selection_load_aware;  // lower the WRR weight of the SGWs with pending Create Session Requests
   uint32_t mme_mobility_completion_timer;
   uint32_t mme_s10_handover_completion_timer;
 
@@ -202,6 +240,19 @@ typedef struct mme_config_s {
     uint16_t out_streams;
   } sctp_config;
 
+  struct {
+    uint16_t batch_size;
+    bool     reuse_port;
+  } udp_config;
+
+  struct {
+    bool     stub_hss;                  // S6a answered in-process by TASK_S6A, no freeDiameter
+    bool     stub_sgw;                  // S11 answered in-process by TASK_S11, no GTPv2-C
+    bstring  stub_apn;                  // APN of the subscription returned by the HSS stub
+    uint32_t stub_sgw_ddn_percent;      // % of the released UEs paged by the SGW stub
+    uint32_t stub_sgw_ddn_delay_ms;     // delay between the release and the downlink data notification
+  } benchmark_config;
+
   struct {
     uint16_t port_number;
     uint8_t  outcome_drop_timer_sec;
@@ -231,11 +282,27 @@ typedef struct mme_config_s {
     bstring conf_file;
     bstring hss_host_name;
     bstring mme_host_name;
+    // HSS_HOSTNAME first, then the HSS_PEERS entries, the requests are shared according to the weights
+    uint8_t  nb_hss_peers;
+    struct {
+      bstring  host_name;
+      uint32_t weight;
+    } hss_peers[MAX_HSS_PEERS];
   } s6a_config;
 
   struct {
     uint32_t  queue_size;
     bstring   log_file;
+    bstring   capture_file;             // messages captured in capture_file.<index> if set
+    uint32_t  capture_file_size;        // in MB
+    uint32_t  capture_max_files;
+    bstring   replay_file;              // capture replayed into replay_task if set
+    bstring   replay_task;
+    bool      replay_max_speed;
+    int       overload_policy;          // itti_overload_policy_t
+    uint32_t  overload_block_timeout;   // in ms
+    uint32_t  overload_drop_priority;   // message_priorities_t
+    bstring   overload_signal_task;
   } itti_config;
 
   struct {
@@ -267,6 +334,7 @@ typedef struct mme_config_s {
     bstring        service_id[MME_CONFIG_MAX_SERVICE];
     interface_type_t interface_type[MME_CONFIG_MAX_SERVICE];
     struct in_addr service_ip_addr[MME_CONFIG_MAX_SERVICE];
+    uint8_t        weight[MME_CONFIG_MAX_SERVICE];       // WRR weight among the entries of the same ID
     /** MME entries. */
 
   } e_dns_emulation;
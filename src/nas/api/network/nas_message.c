@@ -133,6 +133,17 @@ static uint32_t _nas_message_get_mac (
     int const direction,
     emm_security_context_t * const emm_security_context);
 
+static const nas_stream_key_schedule_t *_nas_message_key_schedule (
+    nas_stream_key_schedule_t * const key_schedule,
+    const uint8_t * const key);
+
+/*
+ * Buffer of the deciphered messages, per thread, grown on demand. The received
+ * buffer is left untouched since it may be decoded again (complete TAU request).
+ */
+static __thread unsigned char          *_nas_message_plain_buffer = NULL;
+static __thread size_t                  _nas_message_plain_buffer_size = 0;
+
 /****************************************************************************/
 /******************  E X P O R T E D    F U N C T I O N S  ******************/
 /****************************************************************************/
@@ -826,27 +837,42 @@ static int _nas_message_protected_decode (
 {
   OAILOG_FUNC_IN (LOG_NAS);
   int                                     bytes = TLV_BUFFER_TOO_SHORT;
-  unsigned char                    *const plain_msg = (unsigned char *)calloc (1, length);
+  unsigned char                          *plain_msg = buffer;
 
-  if (plain_msg) {
+  if ((SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED_NEW == header->security_header_type) && (emm_security_context) &&
+      ((NAS_SECURITY_ALGORITHMS_EEA1 == emm_security_context->selected_algorithms.encryption) ||
+       (NAS_SECURITY_ALGORITHMS_EEA2 == emm_security_context->selected_algorithms.encryption))) {
     /*
-     * Decrypt the security protected NAS message
+     * Only a ciphered message needs a buffer of its own, the others are decoded in place
      */
-    header->protocol_discriminator = _nas_message_decrypt (
-        plain_msg,
-        buffer,
-        header->security_header_type,
-        header->message_authentication_code,
-        header->sequence_number,
-        length, emm_security_context,
-        status);
-    /*
-     * Decode the decrypted message as plain NAS message
-     */
-    bytes = _nas_message_plain_decode (plain_msg, header, msg, length);
-    free_wrapper ((void**)&plain_msg);
+    if (_nas_message_plain_buffer_size < length) {
+      unsigned char                          *plain_buffer = (unsigned char *)realloc (_nas_message_plain_buffer, length);
+
+      if (!plain_buffer) {
+        OAILOG_FUNC_RETURN (LOG_NAS, bytes);
+      }
+      _nas_message_plain_buffer = plain_buffer;
+      _nas_message_plain_buffer_size = length;
+    }
+    plain_msg = _nas_message_plain_buffer;
   }
 
+  /*
+   * Decrypt the security protected NAS message
+   */
+  header->protocol_discriminator = _nas_message_decrypt (
+      plain_msg,
+      buffer,
+      header->security_header_type,
+      header->message_authentication_code,
+      header->sequence_number,
+      length, emm_security_context,
+      status);
+  /*
+   * Decode the decrypted message as plain NAS message
+   */
+  bytes = _nas_message_plain_decode (plain_msg, header, msg, length);
+
   OAILOG_FUNC_RETURN (LOG_NAS, bytes);
 }
 
@@ -991,27 +1017,20 @@ static int _nas_message_protected_encode (
   OAILOG_FUNC_IN (LOG_NAS);
   emm_security_context_t                 *emm_security_context = (emm_security_context_t *) security;
   int                                     bytes = TLV_BUFFER_TOO_SHORT;
-  unsigned char                          *plain_msg = (unsigned char *)calloc (1, length);
 
-  if (plain_msg) {
+  /*
+   * Encode the security protected NAS message as plain NAS message, in place
+   * after the security header
+   */
+  int                                     size = _nas_message_plain_encode (buffer, &msg->header,
+                                                                            &msg->plain, length);
+
+  if (size > 0) {
     /*
-     * Encode the security protected NAS message as plain NAS message
+     * Encrypt the encoded plain NAS message in place
      */
-    int                                     size = _nas_message_plain_encode (plain_msg, &msg->header,
-                                                                              &msg->plain, length);
-
-    if (size > 0) {
-      //static uint8_t seq = 0;
-      /*
-       * Encrypt the encoded plain NAS message
-       */
-      bytes = _nas_message_encrypt (buffer, plain_msg, msg->header.security_header_type, msg->header.message_authentication_code, msg->header.sequence_number,
-          emm_security_context->direction_encode, size, emm_security_context);
-      //seq, size);
-      //seq ++;
-    }
-
-    free_wrapper ((void**)&plain_msg);
+    bytes = _nas_message_encrypt (buffer, buffer, msg->header.security_header_type, msg->header.message_authentication_code, msg->header.sequence_number,
+        emm_security_context->direction_encode, size, emm_security_context);
   }
 
   OAILOG_FUNC_RETURN (LOG_NAS, bytes);
@@ -1068,7 +1087,9 @@ static int _nas_message_decrypt (
     // todo: currently also in this case trying to get the security context from the source MME
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED:
     OAILOG_DEBUG (LOG_NAS, "No decryption of message length %lu according to security header type 0x%02x\n", length, security_header_type);
-    memcpy (dest, src, length);
+    if (dest != src) {
+      memcpy (dest, src, length);
+    }
     DECODE_U8 (dest, *(uint8_t *) (&header), size);
     OAILOG_FUNC_RETURN (LOG_NAS, header.protocol_discriminator);
     //LOG_FUNC_RETURN (LOG_NAS, length);
@@ -1138,7 +1159,8 @@ static int _nas_message_decrypt (
            * length in bits
            */
           stream_cipher.blength = length << 3;
-          nas_stream_encrypt_eea2 (&stream_cipher, (uint8_t*)dest);
+          nas_stream_encrypt_eea2_scheduled (_nas_message_key_schedule (&emm_security_context->knas_enc_schedule, emm_security_context->knas_enc),
+              &stream_cipher, (uint8_t*)dest);
           /*
            * Decode the first octet (security header type or EPS bearer identity,
            * * * * and protocol discriminator)
@@ -1150,7 +1172,9 @@ static int _nas_message_decrypt (
 
         case NAS_SECURITY_ALGORITHMS_EEA0:
           OAILOG_DEBUG (LOG_NAS, "NAS_SECURITY_ALGORITHMS_EEA0 dir %d ul_count.seq_num %d dl_count.seq_num %d\n", direction, emm_security_context->ul_count.seq_num, emm_security_context->dl_count.seq_num);
-          memcpy (dest, src, length);
+          if (dest != src) {
+            memcpy (dest, src, length);
+          }
           /*
            * Decode the first octet (security header type or EPS bearer identity,
            * * * * and protocol discriminator)
@@ -1161,7 +1185,9 @@ static int _nas_message_decrypt (
 
         default:
           OAILOG_ERROR(LOG_NAS, "Unknown Cyphering protection algorithm %d\n", emm_security_context->selected_algorithms.encryption);
-          memcpy (dest, src, length);
+          if (dest != src) {
+            memcpy (dest, src, length);
+          }
           /*
            * Decode the first octet (security header type or EPS bearer identity,
            * * * * and protocol discriminator)
@@ -1230,7 +1256,9 @@ static int _nas_message_encrypt (
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED:
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_NEW:
     OAILOG_DEBUG (LOG_NAS, "No encryption of message according to security header type 0x%02x\n", security_header_type);
-    memcpy (dest, src, length);
+    if (dest != src) {
+      memcpy (dest, src, length);
+    }
     OAILOG_FUNC_RETURN (LOG_NAS, length);
     break;
 
@@ -1282,14 +1310,17 @@ static int _nas_message_encrypt (
          * length in bits
          */
         stream_cipher.blength = length << 3;
-        nas_stream_encrypt_eea2 (&stream_cipher, (uint8_t*)dest);
+        nas_stream_encrypt_eea2_scheduled (_nas_message_key_schedule (&emm_security_context->knas_enc_schedule, emm_security_context->knas_enc),
+            &stream_cipher, (uint8_t*)dest);
         OAILOG_FUNC_RETURN (LOG_NAS, length);
       }
       break;
 
     case NAS_SECURITY_ALGORITHMS_EEA0:
       OAILOG_DEBUG (LOG_NAS, "NAS_SECURITY_ALGORITHMS_EEA0 dir %d ul_count.seq_num %d dl_count.seq_num %d\n", direction, emm_security_context->ul_count.seq_num, emm_security_context->dl_count.seq_num);
-      memcpy (dest, src, length);
+      if (dest != src) {
+        memcpy (dest, src, length);
+      }
       OAILOG_FUNC_RETURN (LOG_NAS, length);
       break;
 
@@ -1409,7 +1440,8 @@ static uint32_t _nas_message_get_mac (
        * length in bits
        */
       stream_cipher.blength = length << 3;
-      nas_stream_encrypt_eia2 (&stream_cipher, mac);
+      nas_stream_encrypt_eia2_scheduled (_nas_message_key_schedule (&emm_security_context->knas_int_schedule, emm_security_context->knas_int),
+          &stream_cipher, mac);
       OAILOG_DEBUG (LOG_NAS, "NAS_SECURITY_ALGORITHMS_EIA2 returned MAC %x.%x.%x.%x(%u) for length %lu direction %d, count %d\n",
           mac[0], mac[1], mac[2], mac[3], *((uint32_t *) & mac), length, direction, count);
       mac32 = (uint32_t *) & mac;
@@ -1431,3 +1463,30 @@ static uint32_t _nas_message_get_mac (
 
   OAILOG_FUNC_RETURN (LOG_NAS, 0);
 }
+
+/****************************************************************************
+ **                                                                        **
+ ** Name:  _nas_message_key_schedule()                                   **
+ **                                                                        **
+ ** Description: Return the key schedule of a NAS key of the security      **
+ **    context, set up again if the key has changed since its last use    **
+ **                                                                        **
+ ** Inputs   key_schedule: Key schedule cached in the security context    **
+ **    key:     NAS key (knas_enc or knas_int)                            **
+ **    Others:  None                                                   **
+ **                                                                        **
+ ** Outputs:   None                                                      **
+ **      Return:  The key schedule of the key                        **
+ **    Others:  None                                                   **
+ **                                                                        **
+ ***************************************************************************/
+static const nas_stream_key_schedule_t *_nas_message_key_schedule (
+    nas_stream_key_schedule_t * const key_schedule,
+    const uint8_t * const key)
+{
+  if ((!key_schedule->valid) || (memcmp (key_schedule->key, key, sizeof (key_schedule->key)))) {
+    nas_stream_key_schedule_init (key_schedule, key);
+  }
+
+  return key_schedule;
+}
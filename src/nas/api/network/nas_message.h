@@ -50,6 +50,9 @@ Description Defines the layer 3 messages supported by the NAS sublayer
 
 #define NAS_MESSAGE_SECURITY_HEADER_SIZE    6
 #define NAS_MESSAGE_SERVICE_REQUEST_SECURITY_HEADER_SIZE 4
+/* Spare room allocated with a downlink NAS message, the S1AP downlink NAS transport
+ * is encoded around it in the same buffer (S1AP_DOWNLINK_NAS_TRANSPORT_OVERHEAD_MAX) */
+#define NAS_MESSAGE_S1AP_SPARE_SIZE         32
 /****************************************************************************/
 /************************  G L O B A L    T Y P E S  ************************/
 /****************************************************************************/
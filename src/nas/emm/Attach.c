@@ -90,6 +90,7 @@
 #include "mme_config.h"
 #include "nas_itti_messaging.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 
 
 /****************************************************************************/
@@ -208,6 +209,8 @@ int emm_proc_attach_request (
     imsi64 = imsi_to_imsi64(ies->imsi);
   }
 
+  mme_stats_inc (ATTACH_REQUEST);
+  mme_stats_mark (ue_id, ATTACH_REQUEST);
   OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  ATTACH - EPS attach type = %s (%d) requested (ue_id=" MME_UE_S1AP_ID_FMT ")\n",
       _emm_attach_type_str[ies->type], ies->type, ue_id);
   /*
@@ -527,6 +530,9 @@ int emm_proc_attach_complete (
        * Upon receiving an ATTACH COMPLETE message, the MME shall enter state EMM-REGISTERED
        * and consider the GUTI sent in the ATTACH ACCEPT message as valid.
        */
+      mme_stats_inc (ATTACH_COMPLETE);
+      mme_stats_latency (ue_id, ATTACH);
+      mme_stats_latency (ue_id, ATTACH_ACCEPT_TO_COMPLETE);
       REQUIREMENT_3GPP_24_301(R10_5_5_1_2_4__20);
       emm_ctx_set_attribute_valid(emm_context, EMM_CTXT_MEMBER_GUTI);
       /** Add the EMM context by GUTI. */
@@ -988,6 +994,7 @@ int _emm_attach_reject(emm_data_context_t * emm_context, nas_emm_attach_proc_t *
    * Notify EMM-AS SAP that Attach Reject message has to be sent
    * onto the network
    */
+  mme_stats_inc (ATTACH_REJECT);
   emm_sap.primitive = EMMAS_ESTABLISH_REJ;
   emm_sap.u.emm_as.u.establish.ue_id = attach_proc->ue_id;
   emm_sap.u.emm_as.u.establish.eps_id.guti = NULL;
@@ -1565,6 +1572,8 @@ static int _emm_send_attach_accept (emm_data_context_t * emm_context)
     }
 
     _emm_attach_update(emm_context, attach_proc->ies);
+    mme_stats_inc (ATTACH_ACCEPT);
+    mme_stats_mark (ue_id, ATTACH_ACCEPT);
     /*
      * Notify EMM-AS SAP that Attach Accept message together with an Activate
      * Default EPS Bearer Context Request message has to be sent to the UE
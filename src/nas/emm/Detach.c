@@ -71,6 +71,7 @@
 #include "mme_app_ue_context.h"
 #include "nas_itti_messaging.h" 
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 
 static void _emm_proc_create_procedure_detach_request(emm_data_context_t * const emm_context, emm_detach_request_ies_t * const ies);
 
@@ -194,6 +195,7 @@ emm_proc_detach (
   OAILOG_FUNC_IN (LOG_NAS_EMM);
   int                                     rc = RETURNerror;
 
+  mme_stats_inc (DETACH_NETWORK_INITIATED);
   OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Initiate detach type = %s (%d) for ueId " MME_UE_S1AP_ID_FMT " \n.", _emm_detach_type_str[detach_type], detach_type, ue_id);
 
   emm_data_context_t                     *emm_context = emm_data_context_get (&_emm_data, ue_id);
@@ -367,6 +369,7 @@ emm_proc_detach_request (
   int                                     rc;
   bool                                    switch_off = params->switch_off;
 
+  mme_stats_inc (DETACH_UE_INITIATED);
   OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Detach type = %s (%d) requested (ue_id=" MME_UE_S1AP_ID_FMT ")\n", _emm_detach_type_str[params->type], params->type, ue_id);
   /*
    * Get the UE context
@@ -76,6 +76,7 @@
 #include "common_defs.h"
 #include "secu_defs.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 #include "nas_itti_messaging.h"
 
 /****************************************************************************/
@@ -385,6 +386,7 @@ emm_proc_security_mode_complete (mme_ue_s1ap_id_t ue_id, const imeisv_mobile_ide
   nas_emm_smc_proc_t * smc_proc = get_nas_common_procedure_smc(emm_ctx);
 
   if (smc_proc){
+    mme_stats_latency (ue_id, AIA_TO_SECURITY_MODE_COMPLETE);
     /*
      * Stop timer T3460
      */
@@ -71,6 +71,7 @@
 
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 
 /****************************************************************************/
 /****************  E X T E R N A L    D E F I N I T I O N S  ****************/
@@ -103,6 +104,7 @@ emm_proc_service_reject (
 {
   int rc = RETURNok;
   OAILOG_FUNC_IN (LOG_NAS_EMM);
+  mme_stats_inc (SERVICE_REJECT);
   rc = _emm_service_reject (ue_id, emm_cause);
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
 }
@@ -72,6 +72,7 @@
 #include "nas_timer.h"
 #include "common_defs.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 #include "mme_config.h"
 #include "mme_app_procedures.h"
 #include "mme_app_wrr_selection.h"
@@ -151,6 +152,8 @@ int emm_proc_tracking_area_update_request (
   nas_emm_tau_proc_t                     *tau_procedure = NULL;
 
   *emm_cause = EMM_CAUSE_SUCCESS;
+  mme_stats_inc (TAU_REQUEST);
+  mme_stats_mark (ue_id, TAU_REQUEST);
   /*
    * Get the UE's EMM context if it exists
    * First check if the MME_APP UE context is valid.
@@ -915,6 +918,7 @@ static int _emm_tracking_area_update_reject( const mme_ue_s1ap_id_t ue_id, const
   emm_sap_t                               emm_sap = {0};
   emm_data_context_t                     *emm_context = NULL;
 
+  mme_stats_inc (TAU_REJECT);
   OAILOG_WARNING (LOG_NAS_EMM, "EMM-PROC- Sending Tracking Area Update Reject. ue_id=" MME_UE_S1AP_ID_FMT ", cause=%d)\n",
       ue_id, emm_cause);
   /*
@@ -1192,6 +1196,8 @@ static int _emm_tracking_area_update_accept (nas_emm_tau_proc_t * const tau_proc
     if (!emm_context) {
       OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
     }
+    mme_stats_inc (TAU_ACCEPT);
+    mme_stats_latency (tau_proc->ue_id, TAU);
 
     /**
      * Check the EPS Update type:
@@ -47,6 +47,7 @@ Description Defines internal private data handled by EPS Mobility
 #include "3gpp_24.301.h"
 #include "3gpp_24.008.h"
 #include "securityDef.h"
+#include "secu_defs.h"
 
 #include "nas_emm_procedures.h"
 #include "emm_fsm.h"
@@ -87,6 +88,8 @@ typedef struct emm_security_context_s {
   int vector_index;   /* Pointer on vector */
   uint8_t knas_enc[AUTH_KNAS_ENC_SIZE];/* NAS cyphering key               */
   uint8_t knas_int[AUTH_KNAS_INT_SIZE];/* NAS integrity key               */
+  nas_stream_key_schedule_t knas_enc_schedule; /* EEA2 key schedule of knas_enc, set up on first use */
+  nas_stream_key_schedule_t knas_int_schedule; /* EIA2 key schedule of knas_int, set up on first use */
   uint8_t ncc:3; /* next hop chaining counter for handover. */
   uint8_t nh_conj[AUTH_NH_SIZE];      /* nh */
 
@@ -50,6 +50,7 @@
 #include "mme_config.h"
 #include "secu_defs.h"
 #include "mme_app_defs.h"
+#include "mme_app_idle.h"
 #include "nas_itti_messaging.h"
 
 #include "mme_ie_defs.h"
@@ -659,6 +660,10 @@ emm_data_context_get (
   DevAssert (emm_data );
   if (INVALID_MME_UE_S1AP_ID != ue_id) {
     hashtable_ts_get (emm_data->ctx_coll_ue_id, (const hash_key_t)(ue_id), (void **)&emm_data_context_p);
+    if ((!emm_data_context_p) && (mme_app_idle_nb_ues ())) {
+      // the EMM context of a compacted UE is rebuilt from its idle record
+      emm_data_context_p = mme_app_idle_emm_expand (ue_id);
+    }
     OAILOG_INFO (LOG_NAS_EMM, "EMM-CTX - get UE id " MME_UE_S1AP_ID_FMT " context %p\n", ue_id, emm_data_context_p);
   }
   return emm_data_context_p;
@@ -672,10 +677,16 @@ emm_data_context_get_by_imsi (
 {
   hashtable_rc_t                          h_rc = HASH_TABLE_OK;
   mme_ue_s1ap_id_t                       *emm_ue_id_p = NULL;
+  uint64_t                                mme_ue_s1ap_id64 = 0;
 
   DevAssert (emm_data );
 
   h_rc = hashtable_ts_get (emm_data->ctx_coll_imsi, (const hash_key_t)imsi64,  /* sizeof(imsi64_t), */(void **)&emm_ue_id_p);
+  if ((HASH_TABLE_OK != h_rc) && (mme_app_idle_nb_ues ()) &&
+      (HASH_TABLE_OK == hashtable_uint64_ts_get (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl, (const hash_key_t)imsi64, &mme_ue_s1ap_id64)) &&
+      (mme_app_idle_emm_expand ((mme_ue_s1ap_id_t)mme_ue_s1ap_id64))) {
+    h_rc = hashtable_ts_get (emm_data->ctx_coll_imsi, (const hash_key_t)imsi64, (void **)&emm_ue_id_p);
+  }
 
   if (HASH_TABLE_OK == h_rc) {
     struct emm_data_context_s * tmp = emm_data_context_get (emm_data, (const hash_key_t)*emm_ue_id_p);
@@ -697,12 +708,18 @@ emm_data_context_get_by_guti (
 {
   hashtable_rc_t                          h_rc = HASH_TABLE_OK;
   mme_ue_s1ap_id_t                        *emm_ue_id_p = NULL;
+  uint64_t                                mme_ue_s1ap_id64 = 0;
 
   DevAssert (emm_data );
 
   if ( guti) {
 
     h_rc = obj_hashtable_uint64_ts_get (emm_data->ctx_coll_guti, (const void *)guti, sizeof (*guti), (void **) &emm_ue_id_p);
+    if ((HASH_TABLE_OK != h_rc) && (mme_app_idle_nb_ues ()) &&
+        (HASH_TABLE_OK == obj_hashtable_uint64_ts_get (mme_app_desc.mme_ue_contexts.guti_ue_context_htbl, (const void *)guti, sizeof (*guti), &mme_ue_s1ap_id64)) &&
+        (mme_app_idle_emm_expand ((mme_ue_s1ap_id_t)mme_ue_s1ap_id64))) {
+      h_rc = obj_hashtable_uint64_ts_get (emm_data->ctx_coll_guti, (const void *)guti, sizeof (*guti), (void **) &emm_ue_id_p);
+    }
 
     if (HASH_TABLE_OK == h_rc) {
       struct emm_data_context_s * tmp = emm_data_context_get (emm_data, *emm_ue_id_p);
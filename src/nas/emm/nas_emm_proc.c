@@ -53,6 +53,7 @@
 #include "dynamic_memory_check.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 
 /****************************************************************************/
 /****************  E X T E R N A L    D E F I N I T I O N S  ****************/
@@ -310,6 +311,7 @@ nas_proc_authentication_info_answer (
     MSC_LOG_EVENT (MSC_MMEAPP_MME, "0 S6A_AUTH_INFO_ANS Unknown imsi " IMSI_64_FMT, imsi64);
     OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNerror);
   }
+  mme_stats_latency (ctxt->ue_id, S6A_AUTH_INFO);
 
   if ((aia->result.present == S6A_RESULT_BASE)
       && (aia->result.choice.base == DIAMETER_SUCCESS)) {
@@ -320,10 +322,13 @@ nas_proc_authentication_info_answer (
     DevCheck(aia->auth_info.nb_of_vectors > 0, aia->auth_info.nb_of_vectors, 1, 0);
 
     OAILOG_DEBUG (LOG_NAS_EMM, "INFORMING NAS ABOUT AUTH RESP SUCCESS got %u vector(s)\n", aia->auth_info.nb_of_vectors);
+    mme_stats_inc (S6A_AUTH_INFO_SUCCESS);
+    mme_stats_mark (ctxt->ue_id, S6A_AUTH_INFO_ANSWER);
 
     rc = nas_proc_auth_param_res (ctxt->ue_id, aia->auth_info.nb_of_vectors, aia->auth_info.eutran_vector);
   } else {
     OAILOG_ERROR (LOG_NAS_EMM, "INFORMING NAS ABOUT AUTH RESP ERROR CODE\n");
+    mme_stats_inc (S6A_AUTH_INFO_FAILURE);
     MSC_LOG_EVENT (MSC_MMEAPP_MME, "0 S6A_AUTH_INFO_ANS S6A Failure imsi " IMSI_64_FMT, imsi64);
 
     /*
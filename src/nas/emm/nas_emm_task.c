@@ -46,6 +46,8 @@
 #include "itti_free_defined_msg.h"
 #include "mme_config.h"
 #include "nas_network.h"
+#include "mme_app_checkpoint.h"
+#include "mme_app_idle.h"
 
 static void nas_emm_exit(void);
 
@@ -133,6 +135,21 @@ static void *nas_emm_intertask_interface (void *args_p)
     }
     break;
 
+    case NAS_CHECKPOINT_REQ:{
+       mme_app_checkpoint_emm_snapshot (&NAS_CHECKPOINT_REQ (received_message_p));
+    }
+    break;
+
+    case NAS_IDLE_COMPACT_REQ:{
+       mme_app_idle_emm_compact (&NAS_IDLE_COMPACT_REQ (received_message_p));
+    }
+    break;
+
+    case NAS_IDLE_EXPAND_REQ:{
+       mme_app_idle_emm_expand (NAS_IDLE_EXPAND_REQ (received_message_p).ue_id);
+    }
+    break;
+
     case TERMINATE_MESSAGE:{
       nas_emm_exit();
       OAI_FPRINTF_INFO("TASK_NAS_EMM terminated\n");
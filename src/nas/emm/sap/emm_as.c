@@ -901,7 +901,7 @@ static int _emm_as_encode (bstring *info, nas_message_t * msg,
   /*
    * Allocate memory to the NAS information container
    */
-  *info = bfromcstralloc(length, "\0");
+  *info = bfromcstralloc(length + NAS_MESSAGE_S1AP_SPARE_SIZE, "\0");
 
   if (*info) {
     /*
@@ -951,7 +951,7 @@ static int _emm_as_encrypt (bstring *info, const nas_message_security_header_t *
   /*
    * Allocate memory to the NAS information container
    */
-  *info = bfromcstralloc(length, "\0");
+  *info = bfromcstralloc(length + NAS_MESSAGE_S1AP_SPARE_SIZE, "\0");
 
   if (*info) {
     /*
@@ -59,6 +59,7 @@
 #include "mme_config.h"
 #include "3gpp_requirements_24.301.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 #include "emm_recv.h"
 #include "emm_proc.h"
 #include "emm_cause.h"
@@ -795,6 +796,8 @@ emm_recv_service_request (
   emm_data_context_t * emm_ctx = NULL;
   *emm_cause = EMM_CAUSE_PROTOCOL_ERROR; 
 
+  mme_stats_inc (SERVICE_REQUEST);
+  mme_stats_mark (ue_id, SERVICE_REQUEST);
   OAILOG_INFO (LOG_NAS_EMM, "EMMAS-SAP - Received Service Request message, Security context %s Integrity protected %s MAC matched %s Ciphered %s\n",
       (decode_status->security_context_available)?"yes":"no",
       (decode_status->integrity_protected_message)?"yes":"no",
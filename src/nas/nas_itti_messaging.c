@@ -52,6 +52,7 @@
 #include "nas_emm_proc.h"
 #include "esm_proc.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
 
 //------------------------------------------------------------------------------
 int
@@ -331,6 +332,8 @@ void nas_itti_pdn_config_req(
    * todo: remove this?
    */
   s6a_ulr_p->skip_subscriber_data = 0;
+  mme_stats_inc (S6A_UPDATE_LOCATION_REQUEST);
+  mme_stats_mark (ue_idP, S6A_UPDATE_LOCATION_REQUEST);
   MSC_LOG_TX_MESSAGE (MSC_NAS_ESM, MSC_S6A_MME, NULL, 0, "0 S6A_UPDATE_LOCATION_REQ imsi %s", s6a_ulr_p->imsi);
   int rc =  itti_send_msg_to_task (TASK_S6A, INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_RETURN (LOG_MME_APP, rc);
@@ -446,6 +449,9 @@ void nas_itti_auth_info_req(
     memcpy (auth_info_req->auts, auts_pP->data, blength(auts_pP));
   }
 
+  mme_stats_inc (S6A_AUTH_INFO_REQUEST);
+  mme_stats_latency (ue_idP, INITIAL_UE_MESSAGE_TO_AIR);
+  mme_stats_mark (ue_idP, S6A_AUTH_INFO_REQUEST);
   MSC_LOG_TX_MESSAGE (MSC_NAS_MME, MSC_S6A_MME, NULL, 0, "0 S6A_AUTH_INFO_REQ IMSI "IMSI_64_FMT" visited_plmn "PLMN_FMT" re_sync %u",
       auth_info_req->imsi, PLMN_ARG(visited_plmnP), auth_info_req->re_synchronization);
   itti_send_msg_to_task (TASK_S6A, INSTANCE_DEFAULT, message_p);
@@ -63,6 +63,8 @@
 #include "mme_config.h"
 
 #include "intertask_interface_init.h"
+#include "intertask_interface_capture.h"
+#include "itti_free_defined_msg.h"
 
 #include "sctp_primitives_server.h"
 #include "udp_primitives_server.h"
@@ -78,6 +80,7 @@
 #include <freeDiameter/freeDiameter-host.h>
 #include <freeDiameter/libfdcore.h>
 #include "s6a_defs.h"
+#include "s6a_stub.h"
 
 #include "oai_mme.h"
 #include "pid_file.h"
@@ -158,17 +161,38 @@ main (
           NULL,
 #endif
           NULL));
+  if (mme_config.itti_config.capture_file) {
+    CHECK_INIT_RETURN (itti_capture_init (bdata(mme_config.itti_config.capture_file),
+        mme_config.itti_config.capture_file_size * 1024 * 1024, mme_config.itti_config.capture_max_files));
+  }
+  itti_set_overload_policy (mme_config.itti_config.overload_policy, mme_config.itti_config.overload_block_timeout,
+      mme_config.itti_config.overload_drop_priority,
+      itti_get_task_id ((mme_config.itti_config.overload_signal_task) ? bdata(mme_config.itti_config.overload_signal_task) : "TASK_S1AP"));
+  itti_set_free_msg_content (itti_free_msg_content);
   MSC_INIT (MSC_MME, THREAD_MAX + TASK_MAX);
   CHECK_INIT_RETURN (nas_emm_init (&mme_config));
   CHECK_INIT_RETURN (nas_esm_init ());
   CHECK_INIT_RETURN (sctp_init (&mme_config));
   CHECK_INIT_RETURN (udp_init ());
   CHECK_INIT_RETURN (s10_mme_init (&mme_config));
-  CHECK_INIT_RETURN (s11_mme_init (&mme_config));
+  if (mme_config.benchmark_config.stub_sgw) {
+    CHECK_INIT_RETURN (s11_mme_stub_init (&mme_config));
+  } else {
+    CHECK_INIT_RETURN (s11_mme_init (&mme_config));
+  }
   CHECK_INIT_RETURN (s1ap_mme_init());
   CHECK_INIT_RETURN (mme_app_init (&mme_config));
-  CHECK_INIT_RETURN (s6a_init (&mme_config));
+  if (mme_config.benchmark_config.stub_hss) {
+    CHECK_INIT_RETURN (s6a_stub_init (&mme_config));
+  } else {
+    CHECK_INIT_RETURN (s6a_init (&mme_config));
+  }
   OAILOG_DEBUG(LOG_MME_APP, "MME app initialization complete\n");
+  if (mme_config.itti_config.replay_file) {
+    CHECK_INIT_RETURN (itti_capture_replay_start (bdata(mme_config.itti_config.replay_file),
+        (mme_config.itti_config.replay_task) ? bdata(mme_config.itti_config.replay_task) : "TASK_S1AP",
+        mme_config.itti_config.replay_max_speed));
+  }
 
   /*
    * Handle signals here
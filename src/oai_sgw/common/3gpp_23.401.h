@@ -66,6 +66,9 @@ typedef struct sgw_eps_bearer_ctxt_s {
   // SDF identifier
   uint8_t               num_sdf;
   uint32_t              sdf_id[TRAFFIC_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX];
+
+  bool                  ddn_pending;                      ///< DDN sent or delayed for this bearer, 3GPP TS 23.401 #5.3.4.3
+  uint64_t              ddn_pending_since_ms;
 } sgw_eps_bearer_ctxt_t;
 
 
@@ -91,6 +94,19 @@ typedef struct sgw_pdn_connection_s {
 } sgw_pdn_connection_t;
 
 
+/** @struct sgw_ddn_context_t
+ *  @brief Downlink data notification state of a UE, 3GPP TS 23.401 #5.3.4.3,
+ *  the pending state is kept per bearer in sgw_eps_bearer_ctxt_t
+ */
+typedef struct sgw_ddn_context_s {
+  long                 delay_timer_id;                 ///< armed while a DDN is delayed, 0 otherwise
+  ebi_t                delayed_ebi;                    ///< bearer notified when the delay timer expires
+  uint64_t             delay_until_ms;                 ///< Data Notification Delay (DDN Ack) or Delay Downlink Packet Notification Request (MBR)
+  uint8_t              throttling_factor;              ///< DL low priority traffic Throttling, percentage of DDNs to suppress
+  uint8_t              throttling_credit;
+  uint64_t             throttling_until_ms;
+} sgw_ddn_context_t;
+
 /** @struct sgw_eps_bearer_context_information_t
  *  @brief Useful parameters to know in SGW application layer. They are set
  * according to 3GPP TS.23.401 #5.7.3
@@ -117,6 +133,8 @@ typedef struct sgw_eps_bearer_context_information_s {
   // TODO more than one PDN connection;
   sgw_pdn_connection_t   pdn_connection;
 
+  sgw_ddn_context_t      ddn;
+
   void                  *trxn;
   // TODO change this saved_message (add procedure/transaction)
   itti_s11_create_session_request_t saved_message;
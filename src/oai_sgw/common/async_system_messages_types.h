@@ -33,12 +33,22 @@ extern "C" {
 #endif
 
 #define ASYNC_SYSTEM_COMMAND(mSGpTR)                     ((itti_async_system_command_t*)(mSGpTR)->itti_msg)
+#define ASYNC_SYSTEM_RESULT(mSGpTR)                      ((itti_async_system_result_t*)(mSGpTR)->itti_msg)
 
 typedef struct itti_async_system_command_s {
   bstring                  system_command;
   bool                     is_abort_on_error;
+  bool                     is_ordered;          ///< run after the commands queued before it, before the ones queued after it
+  bool                     is_result_requested; ///< send an ASYNC_SYSTEM_RESULT to the sender task on completion
+  uint64_t                 context;             ///< opaque for TASK_ASYNC_SYSTEM, copied in the result
 } itti_async_system_command_t;
 
+typedef struct itti_async_system_result_s {
+  bstring                  system_command;
+  int                      status;              ///< exit status of the command, -1 if it could not be run
+  uint64_t                 context;
+} itti_async_system_result_t;
+
 #ifdef __cplusplus
 }
 #endif
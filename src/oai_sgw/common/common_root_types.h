@@ -179,6 +179,15 @@ typedef uint64_t bitrate_t;
 typedef char*    APN_t;
 typedef uint8_t  APNRestriction_t;
 typedef uint8_t  DelayValue_t;
+
+/* Throttling Information Element
+ * 3GPP TS 29.274 #8.85
+ */
+typedef struct throttling_s {
+  uint8_t  throttling_delay_unit;     ///< 0: 2 s, 1: 1 min, 2: 10 min, 3: 1 hour, 4: 10 hours, 7: deactivated
+  uint8_t  throttling_delay_value;
+  uint8_t  throttling_factor;         ///< Percentage of low priority DL data notifications to drop, 0..100
+} throttling_t;
 typedef uint8_t  priority_level_t;
 #define PRIORITY_LEVEL_FMT                "0x%"PRIu8
 #define PRIORITY_LEVEL_SCAN_FMT            SCNu8
@@ -1289,6 +1289,8 @@ typedef struct itti_s11_downlink_data_notification_acknowledge_s {
   teid_t          teid;                   ///< Tunnel Endpoint Identifier
   teid_t          local_teid;                   ///< Tunnel Endpoint Identifier
   gtpv2c_cause_t  cause;
+  DelayValue_t    data_notification_delay;            ///< Delay Value in integer multiples of 50 millisecs, or zero
+  throttling_t    dl_low_priority_traffic_throttling; ///< DL low priority traffic Throttling
   imsi_t          imsi;
   // Recovery           ///< optional This IE shall be included if contacting the peer for the first time
   // Private Extension  ///< optional
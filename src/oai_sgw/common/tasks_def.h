@@ -45,6 +45,14 @@ TASK_DEF(TASK_S6A,      TASK_PRIORITY_MED, 256)
 TASK_DEF(TASK_SCTP,     TASK_PRIORITY_MED, 256)
 /// Serving and Proxy Gateway Application task
 TASK_DEF(TASK_SPGW_APP, TASK_PRIORITY_MED, 256)
+/// Additional SPGW_APP workers, sessions are sharded on the local S11 teid (see SPGW_APP_WORKERS)
+TASK_DEF(TASK_SPGW_APP_1, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_SPGW_APP_2, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_SPGW_APP_3, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_SPGW_APP_4, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_SPGW_APP_5, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_SPGW_APP_6, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_SPGW_APP_7, TASK_PRIORITY_MED, 256)
 /// UDP task
 TASK_DEF(TASK_UDP,      TASK_PRIORITY_MED, 256)
 //LOGGING TXT TASK
@@ -1502,6 +1502,35 @@ gtpv2c_delay_value_ie_set (
   return RETURNok;
 }
 
+//------------------------------------------------------------------------------
+nw_rc_t
+gtpv2c_throttling_ie_get (
+  uint8_t ieType,
+  uint16_t ieLength,
+  uint8_t ieInstance,
+  uint8_t * ieValue,
+  void *arg)
+{
+  throttling_t                           *throttling = (throttling_t *) arg;
+
+  DevAssert (arg );
+
+  if (ieLength != 2) {
+    return NW_GTPV2C_IE_INCORRECT;
+  }
+
+  throttling->throttling_delay_unit  = (ieValue[0] >> 5) & 0x07;
+  throttling->throttling_delay_value = ieValue[0] & 0x1F;
+  throttling->throttling_factor      = ieValue[1];
+  if (throttling->throttling_factor > 100) {
+    // 29.274: values above 100 shall be interpreted as 0
+    throttling->throttling_factor = 0;
+  }
+  OAILOG_DEBUG (LOG_S11, "\t - Throttling delay unit %u value %u factor %u\n",
+      throttling->throttling_delay_unit, throttling->throttling_delay_value, throttling->throttling_factor);
+  return NW_OK;
+}
+
 //------------------------------------------------------------------------------
 nw_rc_t
 gtpv2c_ue_time_zone_ie_get (
@@ -149,6 +149,11 @@ int gtpv2c_ip_address_ie_set(nw_gtpv2c_msg_handle_t *msg, const gtp_ip_address_t
 nw_rc_t gtpv2c_delay_value_ie_get(uint8_t ieType, uint16_t ieLength, uint8_t ieInstance, uint8_t *ieValue, void *arg);
 int gtpv2c_delay_value_ie_set(nw_gtpv2c_msg_handle_t *msg, const DelayValue_t *delay_value);
 
+/* Throttling Information Element
+ * 3GPP TS 29.274 #8.85
+ */
+nw_rc_t gtpv2c_throttling_ie_get(uint8_t ieType, uint16_t ieLength, uint8_t ieInstance, uint8_t *ieValue, void *arg);
+
 /* UE Time Zone Information Element
  * 3GPP TS 29.274 #8.44
  */
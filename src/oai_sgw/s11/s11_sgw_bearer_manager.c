@@ -44,6 +44,7 @@
 #include "NwGtpv2cMsg.h"
 #include "NwGtpv2cMsgParser.h"
 #include "sgw_ie_defs.h"
+#include "sgw_defs.h"
 #include "s11_common.h"
 #include "s11_sgw_bearer_manager.h"
 #include "s11_ie_formatter.h"
@@ -162,7 +163,7 @@ s11_sgw_handle_modify_bearer_request (
   DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_for_s11_teid (request_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
@@ -288,7 +289,7 @@ s11_sgw_handle_release_access_bearers_request (
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
 
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_for_s11_teid (request_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
@@ -452,7 +453,7 @@ s11_sgw_handle_create_bearer_response (
   DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_for_s11_teid (resp_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 #ifdef __cplusplus
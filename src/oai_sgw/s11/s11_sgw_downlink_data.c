@@ -44,6 +44,7 @@
 #include "NwGtpv2cMsg.h"
 #include "NwGtpv2cMsgParser.h"
 #include "sgw_ie_defs.h"
+#include "sgw_defs.h"
 #include "s11_common.h"
 #include "s11_sgw_session_manager.h"
 #include "s11_ie_formatter.h"
@@ -156,6 +157,21 @@ s11_sgw_handle_downlink_data_notification_ack (
       &resp_p->imsi);
   DevAssert (NW_OK == rc);
 
+  /*
+   * Data Notification Delay IE
+   */
+  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_DELAY_VALUE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      gtpv2c_delay_value_ie_get,
+      &resp_p->data_notification_delay);
+  DevAssert (NW_OK == rc);
+
+  /*
+   * DL low priority traffic Throttling IE
+   */
+  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_THROTTLING, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      gtpv2c_throttling_ie_get,
+      &resp_p->dl_low_priority_traffic_throttling);
+  DevAssert (NW_OK == rc);
 
   /*
    * Run the parser
@@ -183,7 +199,7 @@ s11_sgw_handle_downlink_data_notification_ack (
   DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_for_s11_teid (resp_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
@@ -251,7 +267,7 @@ s11_sgw_handle_downlink_data_notification_failure_ind (
    DevAssert (NW_OK == rc);
    rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
    DevAssert (NW_OK == rc);
-   return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+   return itti_send_msg_to_task (sgw_task_for_s11_teid (initial_p->teid), INSTANCE_DEFAULT, message_p);
  }
 
 
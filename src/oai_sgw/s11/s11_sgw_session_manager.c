@@ -44,6 +44,7 @@
 #include "NwGtpv2cMsg.h"
 #include "NwGtpv2cMsgParser.h"
 #include "sgw_ie_defs.h"
+#include "sgw_defs.h"
 #include "s11_common.h"
 #include "s11_sgw_session_manager.h"
 #include "s11_ie_formatter.h"
@@ -263,7 +264,7 @@ s11_sgw_handle_create_session_request (
   DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_for_s11_teid (create_session_request_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
@@ -456,7 +457,7 @@ s11_sgw_handle_delete_session_request (
   DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_for_s11_teid (delete_session_request_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
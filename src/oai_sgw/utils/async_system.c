@@ -20,11 +20,16 @@
  */
 
 /*! \file async_system.c
-   \brief
+   \brief Runs the commands of the S/P-GW in child processes (posix_spawn, no shell when not needed),
+   \ up to ASYNC_SYSTEM_WORKERS_MAX at the same time. iptables commands keep their order and are
+   \ coalesced in iptables-restore transactions. An ordered command waits for the completion of the
+   \ commands queued before it, the commands queued after it wait for its own completion. Completions are collected on the stderr pipes of the
+   \ children, through the ITTI event loop of TASK_ASYNC_SYSTEM.
    \author  Lionel GAUTHIER
    \date 2017
    \email: lionel.gauthier@eurecom.fr
 */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -35,12 +40,17 @@
 #include <inttypes.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 #include <ctype.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
 
 #include "bstrlib.h"
+#include "queue.h"
 
 #include "intertask_interface.h"
 #include "log.h"
@@ -55,16 +65,468 @@
 extern "C" {
 #endif
 
+extern char **environ;
+
+#define ASYNC_SYSTEM_ARGV_MAX          128
+#define ASYNC_SYSTEM_STDERR_MAX        1024
+// iptables-restore input is written at once in the pipe, stay under the pipe capacity
+#define ASYNC_SYSTEM_IPTABLES_BATCH_BYTES_MAX 32768
+
+typedef struct async_system_job_s {
+  bstring                                 command;
+  bool                                    is_abort_on_error;
+  bool                                    is_result_requested;
+  bool                                    is_ordered;          // barrier between the commands queued before and after it
+  bool                                    is_batch_disabled;   // retried alone after the failure of its batch
+  task_id_t                               requester;
+  uint64_t                                context;
+  STAILQ_ENTRY (async_system_job_s)       entries;
+} async_system_job_t;
+
+STAILQ_HEAD (async_system_job_list_s, async_system_job_s);
+
+typedef struct async_system_child_s {
+  pid_t                                   pid;                 // 0 if the slot is free
+  int                                     err_fd;              // read end of the stderr of the child
+  bool                                    is_iptables;
+  bool                                    is_ordered;
+  int                                     nb_jobs;
+  bstring                                 err_output;
+  struct async_system_job_list_s          jobs;                // 1 job, or the rules of an iptables-restore batch
+} async_system_child_t;
+
+static struct async_system_job_list_s     async_system_pending;
+static async_system_child_t               async_system_children[ASYNC_SYSTEM_WORKERS_MAX];
+static bool                               async_system_iptables_running = false;
+static bool                               async_system_ordered_running = false;
+
 //-------------------------------
 void async_system_exit (void);
 void* async_system_task (__attribute__ ((unused)) void *args_p);
 
+//------------------------------------------------------------------------------
+static bool async_system_is_iptables (const_bstring command)
+{
+  return (0 == strncmp ((const char *)command->data, "iptables ", 9));
+}
+
+//------------------------------------------------------------------------------
+// Split command in argv in place (buffer is modified), returns false if a shell is needed
+static bool async_system_split (char *buffer, char *argv[], const int argv_max)
+{
+  char                                   *in = buffer;
+  char                                   *out = buffer;
+  int                                     argc = 0;
+
+  while (*in) {
+    while (isspace (*in)) in++;
+    if (!*in) break;
+    if (argc >= argv_max - 1) return false;
+    argv[argc++] = out;
+    while ((*in) && (!isspace (*in))) {
+      if (('\'' == *in) || ('"' == *in)) {
+        const char quote = *in++;
+        while ((*in) && (*in != quote)) {
+          if (('"' == quote) && (strchr ("$`\\", *in))) return false;
+          *out++ = *in++;
+        }
+        if (!*in) return false;
+        in++;
+      } else if (strchr ("|&;<>()$`\\*?[]{}~#", *in)) {
+        return false;
+      } else {
+        *out++ = *in++;
+      }
+    }
+    if (*in) in++;
+    *out++ = '\0';
+  }
+  argv[argc] = NULL;
+  return (argc > 0);
+}
+
+//------------------------------------------------------------------------------
+// Convert "iptables [-t table] <rule>" to a line of iptables-restore, false if not possible
+static bool async_system_iptables_to_restore_line (const_bstring command, bstring table, bstring line)
+{
+  static const char * const               commands[] = {"-A", "-I", "-D", "-F", "-N", "-X", "-Z", "-P", NULL};
+  char                                   *argv[ASYNC_SYSTEM_ARGV_MAX];
+  char                                   *buffer = strdup ((const char *)command->data);
+  bool                                    is_command_found = false;
+
+  bassigncstr (table, "filter");
+  btrunc (line, 0);
+  if (!async_system_split (buffer, argv, ASYNC_SYSTEM_ARGV_MAX)) {
+    free_wrapper ((void**)&buffer);
+    return false;
+  }
+  for (int i = 1; argv[i]; i++) {
+    if ((!strcmp (argv[i], "-t")) || (!strcmp (argv[i], "--table"))) {
+      if (!argv[i+1]) break;
+      bassigncstr (table, argv[++i]);
+      continue;
+    }
+    if (('\0' == argv[i][0]) || (strpbrk (argv[i], " \t\"'"))) {
+      // would need quoting in iptables-restore
+      free_wrapper ((void**)&buffer);
+      return false;
+    }
+    if (!blength(line)) {
+      for (int c = 0; commands[c]; c++) {
+        if (!strcmp (argv[i], commands[c])) is_command_found = true;
+      }
+    } else {
+      bconchar (line, ' ');
+    }
+    bcatcstr (line, argv[i]);
+  }
+  free_wrapper ((void**)&buffer);
+  return is_command_found;
+}
+
+//------------------------------------------------------------------------------
+static void async_system_job_free (async_system_job_t ** job)
+{
+  bdestroy_wrapper (&(*job)->command);
+  free_wrapper ((void**)job);
+}
+
+//------------------------------------------------------------------------------
+static void async_system_job_done (async_system_job_t * job, const int status, const_bstring err_output)
+{
+  if (status) {
+    OAILOG_ERROR (LOG_ASYNC_SYSTEM, "ERROR in system command %s: %d %s\n", bdata(job->command), status, (err_output) ? bdata(err_output) : "");
+    if (job->is_abort_on_error) {
+      async_system_job_free (&job);
+      exit (-1);              // may be not exit
+    }
+  } else {
+    OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "Done system command %s\n", bdata(job->command));
+  }
+
+  if (job->is_result_requested) {
+    MessageDef *message_p = itti_alloc_new_message_sized (TASK_ASYNC_SYSTEM, ASYNC_SYSTEM_RESULT, sizeof(itti_async_system_result_t));
+    AssertFatal (message_p , "itti_alloc_new_message Failed");
+    ASYNC_SYSTEM_RESULT (message_p)->system_command = job->command;
+    ASYNC_SYSTEM_RESULT (message_p)->status = status;
+    ASYNC_SYSTEM_RESULT (message_p)->context = job->context;
+    job->command = NULL;
+    itti_send_msg_to_task (job->requester, INSTANCE_DEFAULT, message_p);
+  }
+  async_system_job_free (&job);
+}
+
+//------------------------------------------------------------------------------
+static int async_system_spawn (async_system_child_t * const child, char * const argv[], const_bstring stdin_data)
+{
+  int                                     err_pipe[2] = {-1, -1};
+  int                                     in_pipe[2] = {-1, -1};
+  posix_spawn_file_actions_t              file_actions;
+  posix_spawnattr_t                       attr;
+  sigset_t                                no_signals;
+  int                                     rc = 0;
+
+  if (pipe2 (err_pipe, O_CLOEXEC)) {
+    return errno;
+  }
+  if ((stdin_data) && (pipe2 (in_pipe, O_CLOEXEC))) {
+    rc = errno;
+    close (err_pipe[0]);
+    close (err_pipe[1]);
+    return rc;
+  }
+  posix_spawn_file_actions_init (&file_actions);
+  posix_spawn_file_actions_adddup2 (&file_actions, err_pipe[1], STDERR_FILENO);
+  if (stdin_data) {
+    posix_spawn_file_actions_adddup2 (&file_actions, in_pipe[0], STDIN_FILENO);
+  }
+  // SIGPIPE is blocked in this task
+  sigemptyset (&no_signals);
+  posix_spawnattr_init (&attr);
+  posix_spawnattr_setsigmask (&attr, &no_signals);
+  posix_spawnattr_setflags (&attr, POSIX_SPAWN_SETSIGMASK);
+
+  rc = posix_spawnp (&child->pid, argv[0], &file_actions, &attr, argv, environ);
+  posix_spawnattr_destroy (&attr);
+  posix_spawn_file_actions_destroy (&file_actions);
+  close (err_pipe[1]);
+
+  if (stdin_data) {
+    close (in_pipe[0]);
+    if ((!rc) && (write (in_pipe[1], bdata(stdin_data), blength(stdin_data)) != blength(stdin_data))) {
+      OAILOG_ERROR (LOG_ASYNC_SYSTEM, "Failed to write the input of %s: %s\n", argv[0], strerror (errno));
+    }
+    close (in_pipe[1]);
+  }
+  if (rc) {
+    child->pid = 0;
+    close (err_pipe[0]);
+    return rc;
+  }
+  fcntl (err_pipe[0], F_SETFL, O_NONBLOCK);
+  child->err_fd = err_pipe[0];
+  itti_subscribe_event_fd (TASK_ASYNC_SYSTEM, child->err_fd);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Run the jobs of child, return false if they could not be started (the jobs are then completed)
+static bool async_system_start (async_system_child_t * const child, const_bstring stdin_data)
+{
+  async_system_job_t                     *job = STAILQ_FIRST (&child->jobs);
+  char                                   *argv[ASYNC_SYSTEM_ARGV_MAX];
+  char                                   *buffer = NULL;
+  int                                     rc = 0;
+
+  btrunc (child->err_output, 0);
+  if (stdin_data) {
+    char *restore_argv[] = {"iptables-restore", "--noflush", NULL};
+    OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "iptables-restore of %d rules:\n%s", child->nb_jobs, bdata(stdin_data));
+    rc = async_system_spawn (child, restore_argv, stdin_data);
+  } else {
+    buffer = strdup ((const char *)job->command->data);
+    if (async_system_split (buffer, argv, ASYNC_SYSTEM_ARGV_MAX)) {
+      OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "spawn: %s\n", bdata(job->command));
+    } else {
+      argv[0] = "/bin/sh";
+      argv[1] = "-c";
+      argv[2] = (char *)bdata(job->command);
+      argv[3] = NULL;
+      OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "spawn /bin/sh -c: %s\n", bdata(job->command));
+    }
+    rc = async_system_spawn (child, argv, NULL);
+    free_wrapper ((void**)&buffer);
+  }
+
+  if (rc) {
+    OAILOG_ERROR (LOG_ASYNC_SYSTEM, "posix_spawn failed: %s\n", strerror (rc));
+    while ((job = STAILQ_FIRST (&child->jobs))) {
+      STAILQ_REMOVE_HEAD (&child->jobs, entries);
+      async_system_job_done (job, -1, NULL);
+    }
+    child->nb_jobs = 0;
+    return false;
+  }
+  if (child->is_iptables) {
+    async_system_iptables_running = true;
+  }
+  if (child->is_ordered) {
+    async_system_ordered_running = true;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static async_system_child_t * async_system_get_free_child (void)
+{
+  for (int i = 0; i < ASYNC_SYSTEM_WORKERS_MAX; i++) {
+    if (!async_system_children[i].pid) {
+      return &async_system_children[i];
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static bool async_system_is_child_running (void)
+{
+  for (int i = 0; i < ASYNC_SYSTEM_WORKERS_MAX; i++) {
+    if (async_system_children[i].pid) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Start the iptables commands, one at a time, consecutive rules in one iptables-restore transaction
+static void async_system_schedule_iptables (void)
+{
+  async_system_child_t                   *child = NULL;
+  async_system_job_t                     *job = NULL;
+  async_system_job_t                     *next = NULL;
+  bstring                                 restore = NULL;
+  bstring                                 table = NULL;
+  bstring                                 current_table = NULL;
+  bstring                                 line = NULL;
+
+  while ((!async_system_iptables_running) && (child = async_system_get_free_child ())) {
+    // first pending iptables command, not past an ordered one
+    STAILQ_FOREACH (job, &async_system_pending, entries) {
+      if ((job->is_ordered) || (async_system_is_iptables (job->command))) break;
+    }
+    if ((!job) || (job->is_ordered)) return;
+
+    STAILQ_INIT (&child->jobs);
+    child->nb_jobs = 0;
+    child->is_iptables = true;
+    child->is_ordered = false;
+    restore = bfromcstr ("");
+    table = bfromcstr ("");
+    current_table = bfromcstr ("");
+    line = bfromcstr ("");
+
+    while ((job) && (child->nb_jobs < ASYNC_SYSTEM_IPTABLES_BATCH_MAX)) {
+      next = STAILQ_NEXT (job, entries);
+      if (job->is_ordered) break;
+      if (async_system_is_iptables (job->command)) {
+        const bool is_batchable = (!job->is_batch_disabled) && (async_system_iptables_to_restore_line (job->command, table, line)) &&
+                                  (blength(restore) + blength(line) + blength(table) + 16 < ASYNC_SYSTEM_IPTABLES_BATCH_BYTES_MAX);
+        // a command that can not be coalesced runs alone
+        if ((!is_batchable) && (child->nb_jobs)) break;
+        STAILQ_REMOVE (&async_system_pending, job, async_system_job_s, entries);
+        STAILQ_INSERT_TAIL (&child->jobs, job, entries);
+        child->nb_jobs += 1;
+        if (!is_batchable) break;
+        if (biseq (table, current_table) != 1) {
+          if (blength(current_table)) bcatcstr (restore, "COMMIT\n");
+          bformata (restore, "*%s\n", bdata(table));
+          bassign (current_table, table);
+        }
+        bconcat (restore, line);
+        bconchar (restore, '\n');
+      }
+      job = next;
+    }
+    if (blength(current_table)) bcatcstr (restore, "COMMIT\n");
+
+    // a single rule does not need a transaction
+    async_system_start (child, (child->nb_jobs > 1) ? restore : NULL);
+    bdestroy_wrapper (&restore);
+    bdestroy_wrapper (&table);
+    bdestroy_wrapper (&current_table);
+    bdestroy_wrapper (&line);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start an ordered command alone, once the commands queued before it have completed
+static void async_system_schedule_ordered (void)
+{
+  async_system_child_t                   *child = NULL;
+  async_system_job_t                     *job = NULL;
+
+  while ((!async_system_ordered_running) && (!async_system_is_child_running ()) &&
+         (job = STAILQ_FIRST (&async_system_pending)) && (job->is_ordered)) {
+    child = async_system_get_free_child ();
+    STAILQ_REMOVE_HEAD (&async_system_pending, entries);
+    STAILQ_INIT (&child->jobs);
+    STAILQ_INSERT_TAIL (&child->jobs, job, entries);
+    child->nb_jobs = 1;
+    child->is_iptables = async_system_is_iptables (job->command);
+    child->is_ordered = true;
+    // not started: completed already, the next one may go
+    async_system_start (child, NULL);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start the other commands in order, as long as there are free children
+static void async_system_schedule (void)
+{
+  async_system_child_t                   *child = NULL;
+  async_system_job_t                     *job = NULL;
+
+  async_system_schedule_ordered ();
+  if (async_system_ordered_running) {
+    return;
+  }
+  async_system_schedule_iptables ();
+
+  job = STAILQ_FIRST (&async_system_pending);
+  // the commands queued after an ordered one wait for it
+  while ((job) && (!job->is_ordered) && (child = async_system_get_free_child ())) {
+    async_system_job_t *next = STAILQ_NEXT (job, entries);
+    if (!async_system_is_iptables (job->command)) {
+      STAILQ_REMOVE (&async_system_pending, job, async_system_job_s, entries);
+      STAILQ_INIT (&child->jobs);
+      STAILQ_INSERT_TAIL (&child->jobs, job, entries);
+      child->nb_jobs = 1;
+      child->is_iptables = false;
+      child->is_ordered = false;
+      async_system_start (child, NULL);
+    }
+    job = next;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void async_system_child_exited (async_system_child_t * const child, int wstatus)
+{
+  async_system_job_t                     *job = NULL;
+  int                                     status = (WIFEXITED (wstatus)) ? WEXITSTATUS (wstatus) : -1;
+
+  itti_unsubscribe_event_fd (TASK_ASYNC_SYSTEM, child->err_fd);
+  close (child->err_fd);
+  child->err_fd = -1;
+  child->pid = 0;
+  if (child->is_iptables) {
+    async_system_iptables_running = false;
+  }
+  if (child->is_ordered) {
+    async_system_ordered_running = false;
+  }
+
+  if ((status) && (child->nb_jobs > 1)) {
+    // the transaction applied nothing, run the rules one by one to isolate the faulty one(s)
+    OAILOG_WARNING (LOG_ASYNC_SYSTEM, "iptables-restore of %d rules failed: %s\n", child->nb_jobs, bdata(child->err_output));
+    STAILQ_FOREACH (job, &child->jobs, entries) {
+      job->is_batch_disabled = true;
+    }
+    STAILQ_CONCAT (&child->jobs, &async_system_pending);
+    STAILQ_CONCAT (&async_system_pending, &child->jobs);
+  } else {
+    while ((job = STAILQ_FIRST (&child->jobs))) {
+      STAILQ_REMOVE_HEAD (&child->jobs, entries);
+      async_system_job_done (job, status, child->err_output);
+    }
+  }
+  child->nb_jobs = 0;
+}
+
+//------------------------------------------------------------------------------
+static void async_system_collect (void)
+{
+  char                                    buffer[256];
+  int                                     wstatus = 0;
+
+  for (int i = 0; i < ASYNC_SYSTEM_WORKERS_MAX; i++) {
+    async_system_child_t * const child = &async_system_children[i];
+    ssize_t                      n = 0;
+
+    if (!child->pid) continue;
+    while ((n = read (child->err_fd, buffer, sizeof (buffer))) > 0) {
+      if (blength(child->err_output) < ASYNC_SYSTEM_STDERR_MAX) {
+        bcatblk (child->err_output, buffer, n);
+      }
+    }
+    if (0 == n) {
+      // end of file: the child is exiting
+      while ((waitpid (child->pid, &wstatus, 0) < 0) && (EINTR == errno));
+      async_system_child_exited (child, wstatus);
+    } else if (waitpid (child->pid, &wstatus, WNOHANG) == child->pid) {
+      // exited, a process it started still holds its stderr
+      async_system_child_exited (child, wstatus);
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 void* async_system_task (__attribute__ ((unused)) void *args_p)
 {
   MessageDef                             *received_message_p = NULL;
-  int                                     rc = 0;
+  sigset_t                                sigpipe;
 
+  // a child exiting before reading its input must not kill the process
+  sigemptyset (&sigpipe);
+  sigaddset (&sigpipe, SIGPIPE);
+  pthread_sigmask (SIG_BLOCK, &sigpipe, NULL);
+
+  STAILQ_INIT (&async_system_pending);
+  for (int i = 0; i < ASYNC_SYSTEM_WORKERS_MAX; i++) {
+    async_system_children[i].err_output = bfromcstr ("");
+    async_system_children[i].err_fd = -1;
+  }
   itti_mark_task_ready (TASK_ASYNC_SYSTEM);
 
   while (1) {
@@ -75,18 +537,17 @@ void* async_system_task (__attribute__ ((unused)) void *args_p)
       switch (ITTI_MSG_ID (received_message_p)) {
 
       case ASYNC_SYSTEM_COMMAND:{
-          rc = 0;
-          OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "C system() call: %s\n", bdata(ASYNC_SYSTEM_COMMAND (received_message_p)->system_command));
-          rc = system (bdata(ASYNC_SYSTEM_COMMAND (received_message_p)->system_command));
-
-          if (rc) {
-            OAILOG_ERROR (LOG_ASYNC_SYSTEM, "ERROR in system command %s: %d\n", bdata(ASYNC_SYSTEM_COMMAND (received_message_p)->system_command), rc);
-            if (ASYNC_SYSTEM_COMMAND (received_message_p)->is_abort_on_error) {
-              bdestroy_wrapper(&ASYNC_SYSTEM_COMMAND (received_message_p)->system_command);
-              exit (-1);              // may be not exit
-            }
-            bdestroy_wrapper(&ASYNC_SYSTEM_COMMAND (received_message_p)->system_command);
-          }
+          async_system_job_t *job = calloc (1, sizeof (async_system_job_t));
+          AssertFatal (job, "calloc failed");
+          job->command = ASYNC_SYSTEM_COMMAND (received_message_p)->system_command;
+          job->is_abort_on_error = ASYNC_SYSTEM_COMMAND (received_message_p)->is_abort_on_error;
+          job->is_result_requested = ASYNC_SYSTEM_COMMAND (received_message_p)->is_result_requested;
+          job->is_ordered = ASYNC_SYSTEM_COMMAND (received_message_p)->is_ordered;
+          job->context = ASYNC_SYSTEM_COMMAND (received_message_p)->context;
+          job->requester = ITTI_MSG_ORIGIN_ID (received_message_p);
+          ASYNC_SYSTEM_COMMAND (received_message_p)->system_command = NULL;
+          OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "Queued system command: %s\n", bdata(job->command));
+          STAILQ_INSERT_TAIL (&async_system_pending, job, entries);
         }
         break;
 
@@ -105,6 +566,8 @@ void* async_system_task (__attribute__ ((unused)) void *args_p)
       itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
       received_message_p = NULL;
     }
+    async_system_collect ();
+    async_system_schedule ();
   }
   return NULL;
 }
@@ -123,19 +586,17 @@ int async_system_init (void)
 }
 
 //------------------------------------------------------------------------------
-int async_system_command (int sender_itti_task, bool is_abort_on_error, char *format, ...)
+static int async_system_vcommand (int sender_itti_task, bool is_abort_on_error, bool is_ordered, bool is_result_requested, uint64_t context, char *format, va_list args)
 {
-  va_list                                 args;
   int                                     rv    = 0;
   bstring                                 bstr = NULL;
-  va_start (args, format);
   bstr = bfromcstralloc(1024, " ");
   btrunc(bstr, 0);
   rv = bvcformata (bstr, 1024, format, args); // big number, see bvcformata
-  va_end (args);
 
-  if (NULL == bstr) {
+  if ((NULL == bstr) || (BSTR_ERR == rv)) {
     OAILOG_ERROR(LOG_ASYNC_SYSTEM, "Error while formatting system command");
+    bdestroy_wrapper (&bstr);
     return RETURNerror;
   }
   MessageDef                             *message_p = NULL;
@@ -143,13 +604,56 @@ int async_system_command (int sender_itti_task, bool is_abort_on_error, char *fo
   AssertFatal (message_p , "itti_alloc_new_message Failed");
   ASYNC_SYSTEM_COMMAND (message_p)->system_command = bstr;
   ASYNC_SYSTEM_COMMAND (message_p)->is_abort_on_error = is_abort_on_error;
+  ASYNC_SYSTEM_COMMAND (message_p)->is_ordered = is_ordered;
+  ASYNC_SYSTEM_COMMAND (message_p)->is_result_requested = is_result_requested;
+  ASYNC_SYSTEM_COMMAND (message_p)->context = context;
   rv = itti_send_msg_to_task (TASK_ASYNC_SYSTEM, INSTANCE_DEFAULT, message_p);
   return rv;
 }
 
+//------------------------------------------------------------------------------
+int async_system_command (int sender_itti_task, bool is_abort_on_error, char *format, ...)
+{
+  va_list                                 args;
+  int                                     rv    = 0;
+  va_start (args, format);
+  rv = async_system_vcommand (sender_itti_task, is_abort_on_error, false, false, 0, format, args);
+  va_end (args);
+  return rv;
+}
+
+//------------------------------------------------------------------------------
+int async_system_command_ordered (int sender_itti_task, bool is_abort_on_error, char *format, ...)
+{
+  va_list                                 args;
+  int                                     rv    = 0;
+  va_start (args, format);
+  rv = async_system_vcommand (sender_itti_task, is_abort_on_error, true, false, 0, format, args);
+  va_end (args);
+  return rv;
+}
+
+//------------------------------------------------------------------------------
+int async_system_command_with_result (int sender_itti_task, uint64_t context, char *format, ...)
+{
+  va_list                                 args;
+  int                                     rv    = 0;
+  va_start (args, format);
+  rv = async_system_vcommand (sender_itti_task, false, false, true, context, format, args);
+  va_end (args);
+  return rv;
+}
+
 //------------------------------------------------------------------------------
 void async_system_exit (void)
 {
+  async_system_job_t                     *job = NULL;
+
+  // running children are not waited for
+  while ((job = STAILQ_FIRST (&async_system_pending))) {
+    STAILQ_REMOVE_HEAD (&async_system_pending, entries);
+    async_system_job_free (&job);
+  }
   OAI_FPRINTF_INFO("TASK_ASYNC_SYSTEM terminated");
 }
 
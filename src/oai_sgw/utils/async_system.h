@@ -35,9 +35,29 @@
 extern "C" {
 #endif
 
+#define ASYNC_SYSTEM_WORKERS_MAX             4   ///< commands running at the same time
+#define ASYNC_SYSTEM_IPTABLES_BATCH_MAX      64  ///< iptables rules coalesced in one iptables-restore
+
 int async_system_init (void);
+
+/*
+ * Queue a command, it is run without shell unless it uses shell syntax.
+ * iptables commands are run in order, other commands may run concurrently.
+ */
 int async_system_command (int sender_itti_task, bool is_abort_on_error, char *format, ...);
 
+/*
+ * Same as async_system_command(), the command starts once all the commands queued before it
+ * have completed and the commands queued after it start once it has completed.
+ */
+int async_system_command_ordered (int sender_itti_task, bool is_abort_on_error, char *format, ...);
+
+/*
+ * Same as async_system_command(), an ASYNC_SYSTEM_RESULT carrying context and
+ * the exit status of the command is sent to sender_itti_task on completion.
+ */
+int async_system_command_with_result (int sender_itti_task, uint64_t context, char *format, ...);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,4 +31,10 @@
 
 int s11_mme_init(const mme_config_t * const mme_config);
 
+/* In-process S+P-GW for benchmarking (BENCHMARK.STUB_SGW), in place of s11_mme_init() */
+int s11_mme_stub_init(const mme_config_t * const mme_config);
+
+/* Create Session Requests sent to this S-GW and not answered yet (0 with the in-process S+P-GW) */
+uint32_t s11_mme_nb_pending_create_sessions(const struct in_addr sgw_ipv4);
+
 #endif /* FILE_S11_MME_SEEN */
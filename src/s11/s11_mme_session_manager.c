@@ -31,9 +31,11 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <netinet/in.h>
 
 #include "bstrlib.h"
 
+#include "dynamic_memory_check.h"
 #include "hashtable.h"
 #include "obj_hashtable.h"
 #include "log.h"
@@ -58,6 +60,83 @@
 
 extern hash_table_ts_t                        *s11_mme_teid_2_gtv2c_teid_handle;
 
+/*
+ * Create Session Requests waiting for their response: SGW IPv4 address by local S11 teid,
+ * and number of them by SGW IPv4 address (read by the SGW selection of MME_APP).
+ */
+static hash_table_uint64_ts_t                 *s11_mme_pending_csr_sgw = NULL;
+static hash_table_uint64_ts_t                 *s11_mme_sgw_nb_pending_csr = NULL;
+
+//------------------------------------------------------------------------------
+int s11_mme_pending_create_session_init (const uint32_t max_ues)
+{
+  bstring b = bfromcstr("s11_mme_pending_csr_sgw");
+  s11_mme_pending_csr_sgw = hashtable_uint64_ts_create (max_ues, NULL, b);
+  bassigncstr(b, "s11_mme_sgw_nb_pending_csr");
+  s11_mme_sgw_nb_pending_csr = hashtable_uint64_ts_create (64, NULL, b);
+  bdestroy_wrapper (&b);
+  if ((!s11_mme_pending_csr_sgw) || (!s11_mme_sgw_nb_pending_csr)) {
+    return RETURNerror;
+  }
+  s11_mme_pending_csr_sgw->log_enabled = false;
+  s11_mme_sgw_nb_pending_csr->log_enabled = false;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s11_mme_pending_create_session_exit (void)
+{
+  if (s11_mme_pending_csr_sgw) {
+    hashtable_uint64_ts_destroy (s11_mme_pending_csr_sgw);
+    s11_mme_pending_csr_sgw = NULL;
+  }
+  if (s11_mme_sgw_nb_pending_csr) {
+    hashtable_uint64_ts_destroy (s11_mme_sgw_nb_pending_csr);
+    s11_mme_sgw_nb_pending_csr = NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void s11_mme_pending_create_session_begin (const teid_t local_teid, const struct in_addr sgw_ipv4)
+{
+  uint64_t                                sgw = 0;
+  uint64_t                                nb_pending = 0;
+
+  if ((!s11_mme_pending_csr_sgw) || (HASH_TABLE_OK == hashtable_uint64_ts_get (s11_mme_pending_csr_sgw, (hash_key_t)local_teid, &sgw))) {
+    return;
+  }
+  hashtable_uint64_ts_insert (s11_mme_pending_csr_sgw, (hash_key_t)local_teid, (uint64_t)sgw_ipv4.s_addr);
+  // only the S11 task updates the counters
+  hashtable_uint64_ts_get (s11_mme_sgw_nb_pending_csr, (hash_key_t)sgw_ipv4.s_addr, &nb_pending);
+  hashtable_uint64_ts_insert (s11_mme_sgw_nb_pending_csr, (hash_key_t)sgw_ipv4.s_addr, nb_pending + 1);
+}
+
+//------------------------------------------------------------------------------
+static void s11_mme_pending_create_session_end (const teid_t local_teid)
+{
+  uint64_t                                sgw = 0;
+  uint64_t                                nb_pending = 0;
+
+  if ((!s11_mme_pending_csr_sgw) || (HASH_TABLE_OK != hashtable_uint64_ts_get (s11_mme_pending_csr_sgw, (hash_key_t)local_teid, &sgw))) {
+    return;
+  }
+  hashtable_uint64_ts_free (s11_mme_pending_csr_sgw, (hash_key_t)local_teid);
+  if ((HASH_TABLE_OK == hashtable_uint64_ts_get (s11_mme_sgw_nb_pending_csr, (hash_key_t)sgw, &nb_pending)) && (nb_pending)) {
+    hashtable_uint64_ts_insert (s11_mme_sgw_nb_pending_csr, (hash_key_t)sgw, nb_pending - 1);
+  }
+}
+
+//------------------------------------------------------------------------------
+uint32_t s11_mme_nb_pending_create_sessions (const struct in_addr sgw_ipv4)
+{
+  uint64_t                                nb_pending = 0;
+
+  if (s11_mme_sgw_nb_pending_csr) {
+    hashtable_uint64_ts_get (s11_mme_sgw_nb_pending_csr, (hash_key_t)sgw_ipv4.s_addr, &nb_pending);
+  }
+  return (uint32_t)nb_pending;
+}
+
 //------------------------------------------------------------------------------
 int
 s11_mme_create_session_request (
@@ -162,6 +241,7 @@ s11_mme_create_session_request (
     OAILOG_WARNING (LOG_S11, "Could not save GTPv2-C hTunnel %p for local teid %X\n", (void*)ulp_req.u_api_info.initialReqInfo.hTunnel, ulp_req.u_api_info.initialReqInfo.teidLocal);
     OAILOG_FUNC_RETURN (LOG_S11, RETURNerror);
   }
+  s11_mme_pending_create_session_begin (req_p->sender_fteid_for_cp.teid, req_p->peer_ip);
   OAILOG_FUNC_RETURN (LOG_S11, RETURNok);
 }
 
@@ -184,6 +264,7 @@ s11_mme_handle_create_session_response (
   resp_p = &message_p->ittiMsg.s11_create_session_response;
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
+  s11_mme_pending_create_session_end (resp_p->teid);
 
   /*
    * Create a new message parser
@@ -421,6 +502,8 @@ s11_mme_handle_delete_session_response (
       MSC_LOG_EVENT (MSC_S11_MME, "Deleted teid " TEID_FMT "", resp_p->teid);
       hash_rc = hashtable_ts_free(s11_mme_teid_2_gtv2c_teid_handle, (hash_key_t) resp_p->teid);
       DevAssert (HASH_TABLE_OK == hash_rc);
+      // the stack drops the requests of a deleted tunnel without failure indication
+      s11_mme_pending_create_session_end (resp_p->teid);
     }
 
   }
@@ -453,6 +536,7 @@ s11_mme_handle_ulp_error_indicatior(
     rsp_p->trxn = (void *)pUlpApi->u_api_info.rspFailureInfo.hUlpTrxn;
     /** Set the cause. */
     rsp_p->cause.cause_value = SYSTEM_FAILURE; /**< Would mean that this message either did not come at all or could not be dealt with properly. */
+    s11_mme_pending_create_session_end (rsp_p->teid);
   }
     break;
   case NW_GTP_MODIFY_BEARER_REQ:
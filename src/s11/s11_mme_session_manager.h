@@ -45,4 +45,9 @@ int s11_mme_modify_bearer_request(nw_gtpv2c_stack_handle_t *stack_p, itti_s11_mo
 
 int s11_mme_handle_ulp_error_indicatior(nw_gtpv2c_stack_handle_t * stack_p, nw_gtpv2c_ulp_api_t * pUlpApi);
 
+/* @brief Accounting of the Create Session Requests waiting for their response, per S-GW. */
+int s11_mme_pending_create_session_init (const uint32_t max_ues);
+
+void s11_mme_pending_create_session_exit (void);
+
 #endif /* FILE_S11_MME_SESSION_MANAGER_SEEN */
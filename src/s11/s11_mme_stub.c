@@ -0,0 +1,276 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s11_mme_stub.c
+  \brief In-process S+P-GW answering the S11 requests of the MME without GTPv2-C, for benchmarking
+  (BENCHMARK.STUB_SGW="yes"). The S11 SGW TEID of a session is the MME S11 TEID, the UE addresses are
+  allocated from 10.0.0.0/8. A part of the UEs released to ECM-IDLE are paged back with a downlink data
+  notification (BENCHMARK.STUB_SGW_DDN_PERCENT), to drive the paging/service request procedure.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "assertions.h"
+#include "log.h"
+#include "msc.h"
+#include "mme_config.h"
+#include "intertask_interface.h"
+#include "itti_free_defined_msg.h"
+#include "timer.h"
+#include "s11_mme.h"
+
+#define S11_STUB_UE_ADDRESS_POOL      0x0A000000   // 10.0.0.0/8
+#define S11_STUB_UE_ADDRESS_MASK      0x00FFFFFF
+
+static uint32_t                         s11_stub_ddn_percent = 0;
+static uint32_t                         s11_stub_ddn_delay_ms = 0;
+static uint32_t                         s11_stub_ddn_credit = 0;
+static uint32_t                         s11_stub_ue_address = 0;
+static struct in_addr                   s11_stub_address = {0};
+// the MME only checks that a DDN has a transaction, the stub ignores the acknowledges
+static int                              s11_stub_ddn_trxn = 0;
+
+//------------------------------------------------------------------------------
+static void s11_stub_fteid (fteid_t * const fteid, const interface_type_t interface_type, const teid_t teid)
+{
+  memset (fteid, 0, sizeof (*fteid));
+  fteid->ipv4 = 1;
+  fteid->interface_type = interface_type;
+  fteid->teid = teid;
+  fteid->ipv4_address = s11_stub_address;
+}
+
+//------------------------------------------------------------------------------
+static void s11_stub_create_session_response (const itti_s11_create_session_request_t * const csr_p)
+{
+  MessageDef                             *message_p = NULL;
+  itti_s11_create_session_response_t     *csresp_p = NULL;
+  const teid_t                            mme_teid = csr_p->sender_fteid_for_cp.teid;
+
+  message_p = itti_alloc_new_message (TASK_S11, S11_CREATE_SESSION_RESPONSE);
+  csresp_p = &message_p->ittiMsg.s11_create_session_response;
+  csresp_p->teid = mme_teid;
+  csresp_p->cause.cause_value = REQUEST_ACCEPTED;
+  s11_stub_fteid (&csresp_p->s11_sgw_fteid, S11_SGW_GTP_C, mme_teid);
+  s11_stub_fteid (&csresp_p->s5_s8_pgw_fteid, S5_S8_PGW_GTP_C, mme_teid);
+  // the MME_APP takes the ownership of the PAA
+  csresp_p->paa = calloc (1, sizeof (paa_t));
+  csresp_p->paa->pdn_type = IPv4;
+  s11_stub_ue_address = (s11_stub_ue_address + 1) & S11_STUB_UE_ADDRESS_MASK;
+  if (!s11_stub_ue_address) s11_stub_ue_address = 1;
+  csresp_p->paa->ipv4_address.s_addr = htonl (S11_STUB_UE_ADDRESS_POOL | s11_stub_ue_address);
+  csresp_p->ambr = csr_p->ambr;
+  if (csr_p->bearer_contexts_to_be_created) {
+    csresp_p->bearer_contexts_created.num_bearer_context = csr_p->bearer_contexts_to_be_created->num_bearer_context;
+    for (int i = 0; i < csr_p->bearer_contexts_to_be_created->num_bearer_context; i++) {
+      const bearer_context_to_be_created_t * const bc_tbc = &csr_p->bearer_contexts_to_be_created->bearer_contexts[i];
+      bearer_context_created_t * const bc_created = &csresp_p->bearer_contexts_created.bearer_contexts[i];
+
+      bc_created->eps_bearer_id = bc_tbc->eps_bearer_id;
+      bc_created->cause.cause_value = REQUEST_ACCEPTED;
+      // one S1-U TEID per bearer: MME S11 TEID and EBI
+      s11_stub_fteid (&bc_created->s1u_sgw_fteid, S1_U_SGW_GTP_U, (mme_teid << 4) | bc_tbc->eps_bearer_id);
+      s11_stub_fteid (&bc_created->s5_s8_u_pgw_fteid, S5_S8_PGW_GTP_U, (mme_teid << 4) | bc_tbc->eps_bearer_id);
+      bc_created->bearer_level_qos = bc_tbc->bearer_level_qos;
+    }
+  }
+  csresp_p->trxn = csr_p->trxn;
+  csresp_p->peer_ip = s11_stub_address;
+  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+static void s11_stub_modify_bearer_response (const itti_s11_modify_bearer_request_t * const mbr_p)
+{
+  MessageDef                             *message_p = NULL;
+  itti_s11_modify_bearer_response_t      *mbresp_p = NULL;
+
+  message_p = itti_alloc_new_message (TASK_S11, S11_MODIFY_BEARER_RESPONSE);
+  mbresp_p = &message_p->ittiMsg.s11_modify_bearer_response;
+  mbresp_p->teid = mbr_p->local_teid;
+  mbresp_p->cause.cause_value = REQUEST_ACCEPTED;
+  mbresp_p->bearer_contexts_modified.num_bearer_context = mbr_p->bearer_contexts_to_be_modified.num_bearer_context;
+  for (int i = 0; i < mbr_p->bearer_contexts_to_be_modified.num_bearer_context; i++) {
+    const bearer_context_to_be_modified_t * const bc_tbm = &mbr_p->bearer_contexts_to_be_modified.bearer_contexts[i];
+    bearer_context_modified_t * const bc_modified = &mbresp_p->bearer_contexts_modified.bearer_contexts[i];
+
+    bc_modified->eps_bearer_id = bc_tbm->eps_bearer_id;
+    bc_modified->cause.cause_value = REQUEST_ACCEPTED;
+    s11_stub_fteid (&bc_modified->s1u_sgw_fteid, S1_U_SGW_GTP_U, (mbr_p->local_teid << 4) | bc_tbm->eps_bearer_id);
+  }
+  mbresp_p->trxn = mbr_p->trxn;
+  mbresp_p->internal_flags = mbr_p->internal_flags;
+  mbresp_p->peer_ip = s11_stub_address;
+  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+static void s11_stub_delete_session_response (const itti_s11_delete_session_request_t * const dsr_p)
+{
+  MessageDef                             *message_p = NULL;
+  itti_s11_delete_session_response_t     *dsresp_p = NULL;
+
+  message_p = itti_alloc_new_message (TASK_S11, S11_DELETE_SESSION_RESPONSE);
+  dsresp_p = &message_p->ittiMsg.s11_delete_session_response;
+  dsresp_p->teid = dsr_p->local_teid;
+  dsresp_p->cause.cause_value = REQUEST_ACCEPTED;
+  dsresp_p->internal_flags = dsr_p->internal_flags;
+  dsresp_p->trxn = dsr_p->trxn;
+  dsresp_p->peer_ip = s11_stub_address;
+  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+static void s11_stub_release_access_bearers_response (const itti_s11_release_access_bearers_request_t * const rabr_p)
+{
+  MessageDef                             *message_p = NULL;
+  itti_s11_release_access_bearers_response_t *rabresp_p = NULL;
+
+  message_p = itti_alloc_new_message (TASK_S11, S11_RELEASE_ACCESS_BEARERS_RESPONSE);
+  rabresp_p = &message_p->ittiMsg.s11_release_access_bearers_response;
+  rabresp_p->teid = rabr_p->local_teid;
+  rabresp_p->cause.cause_value = REQUEST_ACCEPTED;
+  rabresp_p->trxn = rabr_p->trxn;
+  rabresp_p->peer_ip = s11_stub_address;
+  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+
+  /*
+   * Downlink data for s11_stub_ddn_percent % of the UEs going to ECM-IDLE,
+   * evenly spread: a credit of 100 triggers a notification.
+   */
+  if (s11_stub_ddn_percent) {
+    s11_stub_ddn_credit += s11_stub_ddn_percent;
+    if (s11_stub_ddn_credit >= 100) {
+      long                                    timer_id = 0;
+
+      s11_stub_ddn_credit -= 100;
+      if (timer_setup (s11_stub_ddn_delay_ms / 1000, (s11_stub_ddn_delay_ms % 1000) * 1000, TASK_S11, INSTANCE_DEFAULT,
+          TIMER_ONE_SHOT, (void *)(uintptr_t)rabr_p->local_teid, &timer_id) < 0) {
+        OAILOG_ERROR (LOG_S11, "Failed to start the downlink data notification timer for local S11 teid " TEID_FMT "\n", rabr_p->local_teid);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void s11_stub_downlink_data_notification (const teid_t mme_teid)
+{
+  MessageDef                             *message_p = NULL;
+  itti_s11_downlink_data_notification_t  *ddn_p = NULL;
+
+  message_p = itti_alloc_new_message (TASK_S11, S11_DOWNLINK_DATA_NOTIFICATION);
+  ddn_p = &message_p->ittiMsg.s11_downlink_data_notification;
+  ddn_p->teid = mme_teid;
+  ddn_p->cause.cause_value = REQUEST_ACCEPTED;
+  ddn_p->trxn = &s11_stub_ddn_trxn;
+  ddn_p->peer_ip = s11_stub_address.s_addr;
+  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+static void *s11_mme_stub_thread (void *args)
+{
+  itti_mark_task_ready (TASK_S11);
+
+  while (1) {
+    MessageDef                             *received_message_p = NULL;
+
+    itti_receive_msg (TASK_S11, &received_message_p);
+    assert (received_message_p );
+
+    switch (ITTI_MSG_ID (received_message_p)) {
+    case S11_CREATE_SESSION_REQUEST:{
+        s11_stub_create_session_response (&received_message_p->ittiMsg.s11_create_session_request);
+      }
+      break;
+
+    case S11_MODIFY_BEARER_REQUEST:{
+        s11_stub_modify_bearer_response (&received_message_p->ittiMsg.s11_modify_bearer_request);
+      }
+      break;
+
+    case S11_DELETE_SESSION_REQUEST:{
+        s11_stub_delete_session_response (&received_message_p->ittiMsg.s11_delete_session_request);
+      }
+      break;
+
+    case S11_RELEASE_ACCESS_BEARERS_REQUEST:{
+        s11_stub_release_access_bearers_response (&received_message_p->ittiMsg.s11_release_access_bearers_request);
+      }
+      break;
+
+    case TIMER_HAS_EXPIRED:{
+        s11_stub_downlink_data_notification ((teid_t)(uintptr_t)received_message_p->ittiMsg.timer_has_expired.arg);
+      }
+      break;
+
+    case S11_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE:
+    case S11_CREATE_BEARER_RESPONSE:
+    case S11_UPDATE_BEARER_RESPONSE:
+    case S11_DELETE_BEARER_RESPONSE:
+    case S11_DELETE_BEARER_COMMAND:
+    case S11_BEARER_RESOURCE_COMMAND:
+      // no dedicated bearer procedure initiated by the stub
+      break;
+
+    case TERMINATE_MESSAGE:{
+        itti_exit_task ();
+      }
+      break;
+
+    default:{
+        OAILOG_ERROR (LOG_S11, "Unknown message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+      }
+      break;
+    }
+
+    itti_free_msg_content(received_message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+    received_message_p = NULL;
+  }
+
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int s11_mme_stub_init (const mme_config_t * const mme_config_p)
+{
+  OAILOG_DEBUG (LOG_S11, "Initializing S11 S+P-GW stub\n");
+  s11_stub_ddn_percent = mme_config_p->benchmark_config.stub_sgw_ddn_percent;
+  s11_stub_ddn_delay_ms = mme_config_p->benchmark_config.stub_sgw_ddn_delay_ms;
+  s11_stub_address.s_addr = htonl (INADDR_LOOPBACK);
+
+  if (itti_create_task (TASK_S11, &s11_mme_stub_thread, NULL) < 0) {
+    OAILOG_ERROR (LOG_S11, "s11 stub create task\n");
+    return RETURNerror;
+  }
+  OAILOG_WARNING (LOG_S11, "S11 answered by the S+P-GW stub, %u%% of the idle UEs paged after %u ms\n", s11_stub_ddn_percent, s11_stub_ddn_delay_ms);
+  return RETURNok;
+}
@@ -396,6 +396,11 @@ int s11_mme_init (const mme_config_t * const mme_config_p)
   s11_mme_teid_2_gtv2c_teid_handle = hashtable_ts_create(mme_config_p->max_ues, HASH_TABLE_DEFAULT_HASH_FUNC, hash_free_int_func, b);
   bdestroy_wrapper (&b);
 
+  if (s11_mme_pending_create_session_init (mme_config_p->max_ues)) {
+    OAILOG_ERROR (LOG_S11, "Failed to create the pending Create Session Requests tables\n");
+    goto fail;
+  }
+
   OAILOG_DEBUG (LOG_S11, "Initializing S11 interface: DONE\n");
   return ret;
 fail:
@@ -407,4 +412,5 @@ static void s11_mme_exit (void)
 {
   nwGtpv2cFinalize (s11_mme_stack_handle);
   hashtable_ts_destroy(s11_mme_teid_2_gtv2c_teid_handle);
+  s11_mme_pending_create_session_exit ();
 }
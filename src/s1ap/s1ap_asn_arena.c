@@ -0,0 +1,200 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_asn_arena.c
+  \brief Per PDU bump allocator of the asn1c S1AP code, one arena per thread.
+  Each block is preceded by its size, for REALLOC. Freeing the last block of a chunk gives its
+  room back, which covers the temporary IE structures of the generated decoder.
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "s1ap_asn_arena.h"
+
+#define S1AP_ASN_ARENA_ALIGN(sIzE)     (((sIzE) + 15) & ~((size_t)15))
+#define S1AP_ASN_ARENA_HEADER_SIZE     16
+
+typedef struct s1ap_asn_arena_chunk_s {
+  struct s1ap_asn_arena_chunk_s *next;
+  size_t                         size;     /*!< \brief bytes of data */
+  size_t                         used;
+  uint8_t                        data[] __attribute__ ((aligned (16)));
+} s1ap_asn_arena_chunk_t;
+
+typedef struct s1ap_asn_arena_s {
+  unsigned int                   depth;    /*!< \brief nested s1ap_asn_arena_begin() */
+  s1ap_asn_arena_chunk_t        *chunks;   /*!< \brief in use, the current one first */
+  s1ap_asn_arena_chunk_t        *spare;
+  unsigned int                   nb_spare;
+} s1ap_asn_arena_t;
+
+static __thread s1ap_asn_arena_t        g_s1ap_asn_arena = {0};
+
+//------------------------------------------------------------------------------
+void s1ap_asn_arena_begin (void)
+{
+  g_s1ap_asn_arena.depth++;
+}
+
+//------------------------------------------------------------------------------
+void s1ap_asn_arena_end (void)
+{
+  s1ap_asn_arena_t * const                arena = &g_s1ap_asn_arena;
+
+  if ((!arena->depth) || (--arena->depth)) {
+    return;
+  }
+  while (arena->chunks) {
+    s1ap_asn_arena_chunk_t               *chunk = arena->chunks;
+
+    arena->chunks = chunk->next;
+    if ((S1AP_ASN_ARENA_CHUNK_SIZE == chunk->size) && (arena->nb_spare < S1AP_ASN_ARENA_RETAINED_MAX)) {
+      chunk->used = 0;
+      chunk->next = arena->spare;
+      arena->spare = chunk;
+      arena->nb_spare++;
+    } else {
+      free (chunk);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static s1ap_asn_arena_chunk_t *s1ap_asn_arena_find_chunk (const void * const ptr)
+{
+  for (s1ap_asn_arena_chunk_t *chunk = g_s1ap_asn_arena.chunks; chunk; chunk = chunk->next) {
+    if (((const uint8_t *)ptr >= chunk->data) && ((const uint8_t *)ptr < &chunk->data[chunk->used])) {
+      return chunk;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+bool s1ap_asn_arena_owns (const void * const ptr)
+{
+  return (ptr && g_s1ap_asn_arena.depth && s1ap_asn_arena_find_chunk (ptr));
+}
+
+//------------------------------------------------------------------------------
+void *s1ap_asn_arena_malloc (const size_t size)
+{
+  s1ap_asn_arena_t * const                arena = &g_s1ap_asn_arena;
+  s1ap_asn_arena_chunk_t                 *chunk = arena->chunks;
+  const size_t                            needed = S1AP_ASN_ARENA_HEADER_SIZE + S1AP_ASN_ARENA_ALIGN (size);
+  uint8_t                                *block = NULL;
+
+  if (!arena->depth) {
+    return malloc (size);
+  }
+  if ((!chunk) || (chunk->used + needed > chunk->size)) {
+    if ((needed <= S1AP_ASN_ARENA_CHUNK_SIZE) && (arena->spare)) {
+      chunk = arena->spare;
+      arena->spare = chunk->next;
+      arena->nb_spare--;
+    } else {
+      const size_t                        chunk_size = (needed > S1AP_ASN_ARENA_CHUNK_SIZE) ? needed : S1AP_ASN_ARENA_CHUNK_SIZE;
+
+      if (!(chunk = malloc (sizeof (*chunk) + chunk_size))) {
+        return NULL;
+      }
+      chunk->size = chunk_size;
+      chunk->used = 0;
+    }
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+  }
+  block = &chunk->data[chunk->used];
+  chunk->used += needed;
+  *(size_t *)block = size;
+  return block + S1AP_ASN_ARENA_HEADER_SIZE;
+}
+
+//------------------------------------------------------------------------------
+void *s1ap_asn_arena_calloc (const size_t nmemb, const size_t size)
+{
+  void                                   *ptr = NULL;
+
+  if (!g_s1ap_asn_arena.depth) {
+    return calloc (nmemb, size);
+  }
+  if ((size) && (nmemb > SIZE_MAX / size)) {
+    return NULL;
+  }
+  if ((ptr = s1ap_asn_arena_malloc (nmemb * size))) {
+    memset (ptr, 0, nmemb * size);
+  }
+  return ptr;
+}
+
+//------------------------------------------------------------------------------
+void *s1ap_asn_arena_realloc (void * const ptr, const size_t size)
+{
+  s1ap_asn_arena_chunk_t                 *chunk = NULL;
+  size_t                                  old_size = 0;
+  void                                   *new_ptr = NULL;
+
+  if (!ptr) {
+    return s1ap_asn_arena_malloc (size);
+  }
+  if ((!g_s1ap_asn_arena.depth) || (!(chunk = s1ap_asn_arena_find_chunk (ptr)))) {
+    return realloc (ptr, size);
+  }
+  // the header keeps the allocated size, a shrunk block is not given back
+  old_size = *(size_t *)((uint8_t *)ptr - S1AP_ASN_ARENA_HEADER_SIZE);
+  if (size <= S1AP_ASN_ARENA_ALIGN (old_size)) {
+    return ptr;
+  }
+  // last block of the chunk: grow it in place
+  if (((uint8_t *)ptr + S1AP_ASN_ARENA_ALIGN (old_size) == &chunk->data[chunk->used]) &&
+      (chunk->used - S1AP_ASN_ARENA_ALIGN (old_size) + S1AP_ASN_ARENA_ALIGN (size) <= chunk->size)) {
+    chunk->used += S1AP_ASN_ARENA_ALIGN (size) - S1AP_ASN_ARENA_ALIGN (old_size);
+    *(size_t *)((uint8_t *)ptr - S1AP_ASN_ARENA_HEADER_SIZE) = size;
+    return ptr;
+  }
+  if ((new_ptr = s1ap_asn_arena_malloc (size))) {
+    memcpy (new_ptr, ptr, old_size);
+  }
+  return new_ptr;
+}
+
+//------------------------------------------------------------------------------
+void s1ap_asn_arena_free (void * const ptr)
+{
+  s1ap_asn_arena_chunk_t                 *chunk = NULL;
+
+  if (!ptr) {
+    return;
+  }
+  if ((!g_s1ap_asn_arena.depth) || (!(chunk = s1ap_asn_arena_find_chunk (ptr)))) {
+    free (ptr);
+    return;
+  }
+  // released with the arena, unless it is the last block of its chunk
+  const size_t                            size = *(size_t *)((uint8_t *)ptr - S1AP_ASN_ARENA_HEADER_SIZE);
+
+  if ((uint8_t *)ptr + S1AP_ASN_ARENA_ALIGN (size) == &chunk->data[chunk->used]) {
+    chunk->used -= S1AP_ASN_ARENA_HEADER_SIZE + S1AP_ASN_ARENA_ALIGN (size);
+  }
+}
@@ -0,0 +1,60 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file s1ap_asn_arena.h
+  \brief Per PDU bump allocator of the asn1c S1AP code. generate_asn1 routes the CALLOC, MALLOC,
+  REALLOC and FREEMEM macros of the generated asn_internal.h to it: between s1ap_asn_arena_begin()
+  and s1ap_asn_arena_end() the asn1c allocations of the calling thread are carved from chunks
+  retained across PDUs and all released by s1ap_asn_arena_end(); outside they go to the C library.
+  Memory allocated in the arena must neither be used nor freed after s1ap_asn_arena_end().
+*/
+
+#ifndef FILE_S1AP_ASN_ARENA_SEEN
+#define FILE_S1AP_ASN_ARENA_SEEN
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define S1AP_ASN_ARENA_CHUNK_SIZE      (64 * 1024)
+#define S1AP_ASN_ARENA_RETAINED_MAX    4            /*!< \brief chunks kept per thread after s1ap_asn_arena_end() */
+
+/*! \fn void s1ap_asn_arena_begin(void)
+ * \brief Route the asn1c allocations of the calling thread to its arena, calls may be nested.
+ */
+void s1ap_asn_arena_begin(void);
+
+/*! \fn void s1ap_asn_arena_end(void)
+ * \brief End of the outermost scope: release at once all the memory allocated in the arena.
+ */
+void s1ap_asn_arena_end(void);
+
+/*! \fn bool s1ap_asn_arena_owns(const void * const ptr)
+ * \brief True if ptr has been allocated in the arena of the calling thread since the outermost s1ap_asn_arena_begin().
+ */
+bool s1ap_asn_arena_owns(const void * const ptr);
+
+void *s1ap_asn_arena_malloc(const size_t size);
+void *s1ap_asn_arena_calloc(const size_t nmemb, const size_t size);
+void *s1ap_asn_arena_realloc(void * const ptr, const size_t size);
+void  s1ap_asn_arena_free(void * const ptr);
+
+#endif /* FILE_S1AP_ASN_ARENA_SEEN */
@@ -30,12 +30,34 @@
 #include <stdint.h>
 
 #include "s1ap_common.h"
+#include "s1ap_asn_arena.h"
 #include "dynamic_memory_check.h"
 #include "log.h"
 
 int                                     asn_debug = 0;
 int                                     asn1_xer_print = 0;
 
+// The encoded PDU is released with free() by the callers: copy it out of the asn1c arena
+static int
+s1ap_asn_arena_export (
+  uint8_t ** buffer,
+  const ssize_t length)
+{
+  uint8_t                                *copy = NULL;
+
+  if (!s1ap_asn_arena_owns (*buffer)) {
+    return 0;
+  }
+  if (!(copy = malloc (length))) {
+    FREEMEM (*buffer);
+    *buffer = NULL;
+    return -1;
+  }
+  memcpy (copy, *buffer, length);
+  FREEMEM (*buffer);
+  *buffer = copy;
+  return 0;
+}
 
 ssize_t
 s1ap_generate_initiating_message (
@@ -65,12 +87,15 @@ s1ap_generate_initiating_message (
   ASN_STRUCT_FREE_CONTENTS_ONLY (*td, sptr);
 
   if ((encoded = aper_encode_to_new_buffer (&asn_DEF_S1AP_PDU, 0, &pdu, (void **)buffer)) < 0) {
-    free_wrapper(&pdu.choice.initiatingMessage.value.buf); /**< Deallocate explicitly. */
+    FREEMEM (pdu.choice.initiatingMessage.value.buf); /**< Deallocate explicitly. */
     OAILOG_ERROR (LOG_S1AP, "Encoding of %s failed\n", td->name);
     return -1;
   }
-  free_wrapper(&pdu.choice.initiatingMessage.value.buf); /**< Deallocate explicitly. */
+  FREEMEM (pdu.choice.initiatingMessage.value.buf); /**< Deallocate explicitly. */
 
+  if (s1ap_asn_arena_export (buffer, encoded) < 0) {
+    return -1;
+  }
   *length = encoded;
   return encoded;
 }
@@ -107,8 +132,11 @@ s1ap_generate_successfull_outcome (
     return -1;
   }
 
-  free_wrapper(&pdu.choice.successfulOutcome.value.buf);
+  FREEMEM (pdu.choice.successfulOutcome.value.buf);
 
+  if (s1ap_asn_arena_export (buffer, encoded) < 0) {
+    return -1;
+  }
   *length = encoded;
   return encoded;
 }
@@ -144,8 +172,11 @@ s1ap_generate_unsuccessfull_outcome (
     OAILOG_ERROR (LOG_S1AP, "Encoding of %s failed\n", td->name);
     return -1;
   }
-  free_wrapper(&pdu.choice.successfulOutcome.value.buf);
+  FREEMEM (pdu.choice.successfulOutcome.value.buf);
 
+  if (s1ap_asn_arena_export (buffer, encoded) < 0) {
+    return -1;
+  }
   *length = encoded;
   return encoded;
 }
@@ -159,24 +190,23 @@ s1ap_new_ie (
 {
   S1ap_IE_t                              *buff;
 
-  if ((buff = malloc (sizeof (S1ap_IE_t))) == NULL) {
+  if ((buff = CALLOC (1, sizeof (S1ap_IE_t))) == NULL) {
     // Possible error on malloc
     return NULL;
   }
 
-  memset ((void *)buff, 0, sizeof (S1ap_IE_t));
   buff->id = id;
   buff->criticality = criticality;
 
   if (ANY_fromType_aper (&buff->value, type, sptr) < 0) {
     OAILOG_ERROR (LOG_S1AP, "Encoding of %s failed\n", type->name);
-    free_wrapper ((void**)&buff);
+    FREEMEM (buff);
     return NULL;
   }
 
   if (asn1_xer_print)
     if (xer_fprint (stdout, &asn_DEF_S1ap_IE, buff) < 0) {
-      free_wrapper ((void**)&buff);
+      FREEMEM (buff);
       return NULL;
     }
 
@@ -189,3 +219,159 @@ s1ap_handle_criticality (
   S1ap_Criticality_t criticality)
 {
 }
+
+/*
+ * The NAS transport messages are most of the S1AP traffic: their APER encoding is written
+ * here by hand (X.691 aligned variant, same output as asn1c) instead of going through
+ * the IE structures, ANY_fromType_aper() and aper_encode_to_new_buffer().
+ */
+#define S1AP_APER_LENGTH_SIZE_MAX  2
+#define S1AP_APER_LENGTH_MAX       16383   // above, the length determinant is fragmented
+
+// Unconstrained length determinant, -1 if it needs the fragmented form
+static int
+s1ap_aper_put_length (
+  uint8_t * buffer,
+  const uint32_t length)
+{
+  if (length < 128) {
+    buffer[0] = length;
+    return 1;
+  }
+  if (length <= S1AP_APER_LENGTH_MAX) {
+    buffer[0] = 0x80 | (length >> 8);
+    buffer[1] = length & 0xFF;
+    return 2;
+  }
+  return -1;
+}
+
+// IE of a MME UE S1AP ID (0..2^32-1) or an eNB UE S1AP ID (0..2^24-1): number of octets in 2 bits, then the octets
+static int
+s1ap_aper_put_ue_s1ap_id_ie (
+  uint8_t * buffer,
+  const S1ap_ProtocolIE_ID_t id,
+  const uint32_t value)
+{
+  int                                     octets = 1;
+  int                                     size = 0;
+
+  while ((octets < 4) && (value >> (8 * octets))) {
+    octets++;
+  }
+  buffer[size++] = id >> 8;
+  buffer[size++] = id & 0xFF;
+  buffer[size++] = S1ap_Criticality_reject << 6;
+  buffer[size++] = 1 + octets;
+  buffer[size++] = (octets - 1) << 6;
+  for (int i = octets - 1; i >= 0; i--) {
+    buffer[size++] = value >> (8 * i);
+  }
+  return size;
+}
+
+static ssize_t
+s1ap_encode_nas_transport (
+  bstring nas_pdu,
+  const e_S1ap_ProcedureCode procedureCode,
+  const uint32_t mme_ue_s1ap_id,
+  const uint32_t enb_ue_s1ap_id,
+  const uint8_t * const trailer,
+  const int trailer_length,
+  const int nb_trailer_ies)
+{
+  uint8_t                                 header[S1AP_DOWNLINK_NAS_TRANSPORT_OVERHEAD_MAX];
+  uint8_t                                 ies[S1AP_DOWNLINK_NAS_TRANSPORT_OVERHEAD_MAX];
+  int                                     header_length = 0;
+  int                                     ies_length = 0;
+  int                                     nas_length = blength (nas_pdu);
+  int                                     rc = 0;
+
+  if ((!nas_pdu) || (nas_length <= 0)) {
+    return -1;
+  }
+  // protocolIEs: extension bit, number of IEs on 16 bits
+  ies[ies_length++] = 0;
+  ies[ies_length++] = 0;
+  ies[ies_length++] = 3 + nb_trailer_ies;
+  ies_length += s1ap_aper_put_ue_s1ap_id_ie (&ies[ies_length], S1ap_ProtocolIE_ID_id_MME_UE_S1AP_ID, mme_ue_s1ap_id);
+  ies_length += s1ap_aper_put_ue_s1ap_id_ie (&ies[ies_length], S1ap_ProtocolIE_ID_id_eNB_UE_S1AP_ID, enb_ue_s1ap_id);
+  ies[ies_length++] = S1ap_ProtocolIE_ID_id_NAS_PDU >> 8;
+  ies[ies_length++] = S1ap_ProtocolIE_ID_id_NAS_PDU & 0xFF;
+  ies[ies_length++] = S1ap_Criticality_reject << 6;
+  // the NAS PDU octet string in its open type, left to asn1c if either length needs the fragmented form
+  if ((rc = s1ap_aper_put_length (&ies[ies_length], nas_length + ((nas_length < 128) ? 1 : 2))) < 0) {
+    return -1;
+  }
+  ies_length += rc;
+  ies_length += s1ap_aper_put_length (&ies[ies_length], nas_length);
+
+  // initiatingMessage, procedure code, criticality ignore, open type length of the value
+  header[header_length++] = (S1AP_PDU_PR_initiatingMessage - 1) << 5;
+  header[header_length++] = procedureCode;
+  header[header_length++] = S1ap_Criticality_ignore << 6;
+  if ((rc = s1ap_aper_put_length (&header[header_length], ies_length + nas_length + trailer_length)) < 0) {
+    return -1;
+  }
+  header_length += rc;
+  memcpy (&header[header_length], ies, ies_length);
+  header_length += ies_length;
+
+  if (balloc (nas_pdu, header_length + nas_length + trailer_length + 1) != BSTR_OK) {
+    return -1;
+  }
+  memmove (&nas_pdu->data[header_length], nas_pdu->data, nas_length);
+  memcpy (nas_pdu->data, header, header_length);
+  if (trailer_length) {
+    memcpy (&nas_pdu->data[header_length + nas_length], trailer, trailer_length);
+  }
+  nas_pdu->slen = header_length + nas_length + trailer_length;
+  nas_pdu->data[nas_pdu->slen] = '\0';
+  return nas_pdu->slen;
+}
+
+ssize_t
+s1ap_encode_downlink_nas_transport (
+  bstring nas_pdu,
+  const uint32_t mme_ue_s1ap_id,
+  const uint32_t enb_ue_s1ap_id)
+{
+  return s1ap_encode_nas_transport (nas_pdu, S1ap_ProcedureCode_id_downlinkNASTransport, mme_ue_s1ap_id, enb_ue_s1ap_id, NULL, 0, 0);
+}
+
+ssize_t
+s1ap_encode_uplink_nas_transport (
+  bstring nas_pdu,
+  const uint32_t mme_ue_s1ap_id,
+  const uint32_t enb_ue_s1ap_id,
+  const uint8_t plmn[3],
+  const uint16_t tac,
+  const uint32_t cell_identity)
+{
+  uint8_t                                 trailer[S1AP_UPLINK_NAS_TRANSPORT_OVERHEAD_MAX - S1AP_DOWNLINK_NAS_TRANSPORT_OVERHEAD_MAX];
+  int                                     size = 0;
+
+  // EUTRAN CGI: extension and optional bits, PLMN identity, cell identity on 28 bits
+  trailer[size++] = S1ap_ProtocolIE_ID_id_EUTRAN_CGI >> 8;
+  trailer[size++] = S1ap_ProtocolIE_ID_id_EUTRAN_CGI & 0xFF;
+  trailer[size++] = S1ap_Criticality_ignore << 6;
+  trailer[size++] = 8;
+  trailer[size++] = 0;
+  memcpy (&trailer[size], plmn, 3);
+  size += 3;
+  trailer[size++] = cell_identity >> 20;
+  trailer[size++] = cell_identity >> 12;
+  trailer[size++] = cell_identity >> 4;
+  trailer[size++] = (cell_identity & 0x0F) << 4;
+  // TAI: extension and optional bits, PLMN identity, TAC
+  trailer[size++] = S1ap_ProtocolIE_ID_id_TAI >> 8;
+  trailer[size++] = S1ap_ProtocolIE_ID_id_TAI & 0xFF;
+  trailer[size++] = S1ap_Criticality_ignore << 6;
+  trailer[size++] = 6;
+  trailer[size++] = 0;
+  memcpy (&trailer[size], plmn, 3);
+  size += 3;
+  trailer[size++] = tac >> 8;
+  trailer[size++] = tac & 0xFF;
+  return s1ap_encode_nas_transport (nas_pdu, S1ap_ProcedureCode_id_uplinkNASTransport, mme_ue_s1ap_id, enb_ue_s1ap_id, trailer, size, 2);
+}
@@ -476,4 +476,40 @@ S1ap_IE_t *s1ap_new_ie(S1ap_ProtocolIE_ID_t   id,
  **/
 void s1ap_handle_criticality(S1ap_Criticality_t criticality);
 
+/* Bytes added around the NAS PDU by the NAS transport encoders below */
+#define S1AP_DOWNLINK_NAS_TRANSPORT_OVERHEAD_MAX  32
+#define S1AP_UPLINK_NAS_TRANSPORT_OVERHEAD_MAX    (S1AP_DOWNLINK_NAS_TRANSPORT_OVERHEAD_MAX + 22)
+
+/** \brief Encode a downlink NAS transport (no optional IE) around the NAS PDU, in place:
+ the APER header and the two S1AP IDs are written in front of the NAS PDU, that is moved
+ within the buffer of the bstring. No copy if the bstring has S1AP_DOWNLINK_NAS_TRANSPORT_OVERHEAD_MAX
+ bytes of spare room, see NAS_MESSAGE_S1AP_SPARE_SIZE.
+ \param nas_pdu NAS PDU, the S1AP PDU on return
+ \param mme_ue_s1ap_id MME UE S1AP ID
+ \param enb_ue_s1ap_id eNB UE S1AP ID
+ @returns size in bytes of the S1AP PDU on success or -1 on failure (nas_pdu unchanged), in particular
+ when a length determinant would need the fragmented form (NAS PDU of more than about 16K bytes)
+ **/
+ssize_t s1ap_encode_downlink_nas_transport(
+  bstring                 nas_pdu,
+  const uint32_t          mme_ue_s1ap_id,
+  const uint32_t          enb_ue_s1ap_id);
+
+/** \brief Encode an uplink NAS transport (no optional IE) around the NAS PDU, in place.
+ \param nas_pdu NAS PDU, the S1AP PDU on return
+ \param mme_ue_s1ap_id MME UE S1AP ID
+ \param enb_ue_s1ap_id eNB UE S1AP ID
+ \param plmn PLMN identity of the EUTRAN CGI and the TAI, as encoded in S1AP
+ \param tac Tracking area code
+ \param cell_identity 28 bits E-UTRAN cell identity
+ @returns size in bytes of the S1AP PDU on success or -1 on failure (nas_pdu unchanged)
+ **/
+ssize_t s1ap_encode_uplink_nas_transport(
+  bstring                 nas_pdu,
+  const uint32_t          mme_ue_s1ap_id,
+  const uint32_t          enb_ue_s1ap_id,
+  const uint8_t           plmn[3],
+  const uint16_t          tac,
+  const uint32_t          cell_identity);
+
 #endif /* FILE_S1AP_COMMON_SEEN */
@@ -50,6 +50,7 @@
 #include "timer.h"
 #include "itti_free_defined_msg.h"
 #include "s1ap_mme.h"
+#include "s1ap_asn_arena.h"
 #include "s1ap_mme_decoder.h"
 #include "s1ap_mme_handlers.h"
 #include "s1ap_mme_nas_procedures.h"
@@ -58,6 +59,7 @@
 #include "dynamic_memory_check.h"
 #include "3gpp_23.003.h"
 #include "mme_config.h"
+#include "mme_app_statistics.h"
 
 
 #if S1AP_DEBUG_LIST
@@ -153,6 +155,11 @@ s1ap_mme_thread (
       }
       break;
 
+    case ITTI_OVERLOAD_IND:{
+        s1ap_handle_itti_overload_ind (&ITTI_OVERLOAD_IND (received_message_p));
+      }
+      break;
+
 
     // From MME_APP task
     case MME_APP_CONNECTION_ESTABLISHMENT_CNF:{
@@ -215,8 +222,9 @@ s1ap_mme_thread (
         s1ap_message                            message = {0};
 
         /*
-         * Invoke S1AP message decoder
+         * Invoke S1AP message decoder, the asn1c structures of the PDU live in the arena until its end
          */
+        s1ap_asn_arena_begin ();
         if (s1ap_mme_decode_pdu (&message, SCTP_DATA_IND (received_message_p).payload, &message_id) < 0) {
           // TODO: Notify eNB of failure with right cause
           OAILOG_ERROR (LOG_S1AP, "Failed to decode new buffer\n");
@@ -227,6 +235,7 @@ s1ap_mme_thread (
         if (message_id != MESSAGES_ID_MAX) {
           s1ap_free_mme_decode_pdu(&message, message_id);
         }
+        s1ap_asn_arena_end ();
 
         /*
          * Free received PDU array
@@ -36,6 +36,7 @@
 #include "intertask_interface.h"
 #include "mme_api.h"
 #include "s1ap_common.h"
+#include "s1ap_asn_arena.h"
 #include "s1ap_ies_defs.h"
 #include "s1ap_mme_encoder.h"
 #include "assertions.h"
@@ -81,6 +82,16 @@ static inline int                       s1ap_mme_encode_paging(
   uint8_t ** buffer,
   uint32_t * length);
 
+static inline int                       s1ap_mme_encode_overload_start (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length);
+
+static inline int                       s1ap_mme_encode_overload_stop (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length);
+
 static inline int                       s1ap_mme_encode_initiating (
   s1ap_message * message_p,
   MessagesIds *message_id,
@@ -171,23 +182,34 @@ s1ap_mme_encode_pdu (
   DevAssert (buffer != NULL);
   DevAssert (length != NULL);
 
+  int                                     rc = -1;
+
+  /*
+   * The asn1c structures built from the IEs only live until the PDU is encoded,
+   * the encoded buffer is copied out of the arena by s1ap_generate_*
+   */
+  s1ap_asn_arena_begin ();
 
   switch (message_p->direction) {
   case S1AP_PDU_PR_initiatingMessage:
-    return s1ap_mme_encode_initiating (message_p, message_id, buffer, length);
+    rc = s1ap_mme_encode_initiating (message_p, message_id, buffer, length);
+    break;
 
   case S1AP_PDU_PR_successfulOutcome:
-    return s1ap_mme_encode_successfull_outcome (message_p, message_id, buffer, length);
+    rc = s1ap_mme_encode_successfull_outcome (message_p, message_id, buffer, length);
+    break;
 
   case S1AP_PDU_PR_unsuccessfulOutcome:
-    return s1ap_mme_encode_unsuccessfull_outcome (message_p, message_id, buffer, length);
+    rc = s1ap_mme_encode_unsuccessfull_outcome (message_p, message_id, buffer, length);
+    break;
 
   default:
     OAILOG_NOTICE (LOG_S1AP, "Unknown message outcome (%d) or not implemented", (int)message_p->direction);
     break;
   }
 
-  return -1;
+  s1ap_asn_arena_end ();
+  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -216,6 +238,10 @@ int s1ap_free_mme_encode_pdu(
     return free_s1ap_mmestatustransfer(&message->msg.s1ap_MMEStatusTransferIEs);
   case S1AP_PAGING_LOG:
     return free_s1ap_paging(&message->msg.s1ap_PagingIEs);
+  case S1AP_OVERLOAD_START_LOG:
+    return free_s1ap_overloadstart(&message->msg.s1ap_OverloadStartIEs);
+  case S1AP_OVERLOAD_STOP_LOG:
+    return free_s1ap_overloadstop(&message->msg.s1ap_OverloadStopIEs);
   case S1AP_PATH_SWITCH_ACK_LOG:
     return free_s1ap_pathswitchrequestacknowledge(&message->msg.s1ap_PathSwitchRequestAcknowledgeIEs);
   case S1AP_HANDOVER_COMMAND_LOG:
@@ -281,6 +307,14 @@ s1ap_mme_encode_initiating (
     *message_id = S1AP_PAGING_LOG;
     return s1ap_mme_encode_paging(message_p, buffer, length);
 
+  case S1ap_ProcedureCode_id_OverloadStart:
+    *message_id = S1AP_OVERLOAD_START_LOG;
+    return s1ap_mme_encode_overload_start (message_p, buffer, length);
+
+  case S1ap_ProcedureCode_id_OverloadStop:
+    *message_id = S1AP_OVERLOAD_STOP_LOG;
+    return s1ap_mme_encode_overload_stop (message_p, buffer, length);
+
   default:
     OAILOG_NOTICE (LOG_S1AP, "Unknown procedure ID (%d) for initiating message_p\n", (int)message_p->procedureCode);
     break;
@@ -678,3 +712,41 @@ s1ap_mme_encode_paging(
 
   return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_Paging, message_p->criticality, &asn_DEF_S1ap_E_RABSetupRequest, paging_p);
 }
+
+//------------------------------------------------------------------------------
+static inline int
+s1ap_mme_encode_overload_start (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length)
+{
+  S1ap_OverloadStart_t                    overload_start;
+  S1ap_OverloadStart_t                   *overload_start_p = &overload_start;
+
+  memset (overload_start_p, 0, sizeof (S1ap_OverloadStart_t));
+
+  if (s1ap_encode_s1ap_overloadstarties (overload_start_p, &message_p->msg.s1ap_OverloadStartIEs) < 0) {
+    return -1;
+  }
+
+  return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_OverloadStart, message_p->criticality, &asn_DEF_S1ap_OverloadStart, overload_start_p);
+}
+
+//------------------------------------------------------------------------------
+static inline int
+s1ap_mme_encode_overload_stop (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length)
+{
+  S1ap_OverloadStop_t                     overload_stop;
+  S1ap_OverloadStop_t                    *overload_stop_p = &overload_stop;
+
+  memset (overload_stop_p, 0, sizeof (S1ap_OverloadStop_t));
+
+  if (s1ap_encode_s1ap_overloadstopies (overload_stop_p, &message_p->msg.s1ap_OverloadStopIEs) < 0) {
+    return -1;
+  }
+
+  return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_OverloadStop, message_p->criticality, &asn_DEF_S1ap_OverloadStop, overload_stop_p);
+}
@@ -926,7 +926,9 @@ s1ap_mme_generate_ue_context_release_command (
     /** Notify the MME_APP layer that error handling context removals can continue. */
     S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id = mme_ue_s1ap_id;
     MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 S1AP_UE_CONTEXT_RELEASE_COMPLETE mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ", S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id);
-    itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+    if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+      OAILOG_ERROR (LOG_S1AP, "S1AP_UE_CONTEXT_RELEASE_COMPLETE dropped, MME_APP is overloaded\n");
+    }
     OAILOG_FUNC_RETURN (LOG_S1AP, rc);
   }
 }
@@ -982,7 +984,9 @@ s1ap_handle_ue_context_release_command (
     /** Notify the MME_APP layer that error handling context removals can continue. */
     S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id = ue_context_release_command_pP->mme_ue_s1ap_id;
     MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 S1AP_UE_CONTEXT_RELEASE_COMPLETE mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ", S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id);
-    itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+    if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+      OAILOG_ERROR (LOG_S1AP, "S1AP_UE_CONTEXT_RELEASE_COMPLETE dropped, MME_APP is overloaded\n");
+    }
     OAILOG_FUNC_RETURN (LOG_S1AP, rc);
   } else {
     /** We send the mme_ue_s1ap_id explicitly, since it may be 0 in some handover complete procedures. */
@@ -1039,7 +1043,9 @@ s1ap_mme_handle_ue_context_release_complete (
 
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 S1AP_UE_CONTEXT_RELEASE_COMPLETE mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ", S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id);
 
-  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "S1AP_UE_CONTEXT_RELEASE_COMPLETE dropped, MME_APP is overloaded\n");
+  }
   OAILOG_DEBUG (LOG_S1AP, "Removed UE " MME_UE_S1AP_ID_FMT "\n", (uint32_t) ueContextReleaseComplete_p->mme_ue_s1ap_id);
   OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
 }
@@ -1693,7 +1699,9 @@ s1ap_mme_handle_handover_resource_allocation_response(const sctp_assoc_id_t asso
       */
      handover_failure_p->cause          = S1AP_SYSTEM_FAILURE;
      MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 Sending manually S1AP_HANDOVER_FAILURE for mme_ue_s1ap_id  " MME_UE_S1AP_ID_FMT " ", mme_ue_s1ap_id);
-     itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+     if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+       OAILOG_ERROR (LOG_S1AP, "S1AP_HANDOVER_FAILURE dropped, MME_APP is overloaded\n");
+     }
      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
   }
 
@@ -1715,7 +1723,9 @@ s1ap_mme_handle_handover_resource_allocation_response(const sctp_assoc_id_t asso
      */
     handover_failure_p->cause          = S1AP_SYSTEM_FAILURE;
     MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 Sending manually S1AP_HANDOVER_FAILURE for mme_ue_s1ap_id  " MME_UE_S1AP_ID_FMT " ", mme_ue_s1ap_id);
-    itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+    if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+      OAILOG_ERROR (LOG_S1AP, "S1AP_HANDOVER_FAILURE dropped, MME_APP is overloaded\n");
+    }
     itti_s1ap_ue_context_release_command_t *ue_context_release_cmd_p = &((itti_s1ap_ue_context_release_command_t){ .enb_ue_s1ap_id = ue_ref_p->enb_ue_s1ap_id, .enb_id = ue_ref_p->enb->enb_id, .cause = S1AP_SYSTEM_FAILURE});
     /** Remove the UE-Reference to the target-eNB implicitly. Don't need to wait for the UE_CONTEXT_REMOVAL_COMMAND_COMPLETE. */
     s1ap_handle_ue_context_release_command(ue_context_release_cmd_p); /**< Send a removal message and remove the context also directly. */
@@ -1746,7 +1756,9 @@ s1ap_mme_handle_handover_resource_allocation_response(const sctp_assoc_id_t asso
      */
     handover_failure_p->cause          = S1AP_SYSTEM_FAILURE;
     MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 Sending manually S1AP_HANDOVER_FAILURE for mme_ue_s1ap_id  " MME_UE_S1AP_ID_FMT " ", mme_ue_s1ap_id);
-    itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+    if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+      OAILOG_ERROR (LOG_S1AP, "S1AP_HANDOVER_FAILURE dropped, MME_APP is overloaded\n");
+    }
     itti_s1ap_ue_context_release_command_t *ue_context_release_cmd_p = &((itti_s1ap_ue_context_release_command_t){ .enb_ue_s1ap_id = enb_ue_s1ap_id, .enb_id = enb_ref->enb_id, .cause = S1AP_SYSTEM_FAILURE});
     /** Remove the UE-Reference to the target-eNB implicitly. Don't need to wait for the UE_CONTEXT_REMOVAL_COMMAND_COMPLETE. */
     s1ap_handle_ue_context_release_command(ue_context_release_cmd_p); /**< Send a removal message and remove the context also directly. */
@@ -1938,7 +1950,9 @@ s1ap_mme_handle_handover_resource_allocation_failure(const sctp_assoc_id_t assoc
 
   /** No timer to stop on the target-MME side. */
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 Sending manually S1AP_HANDOVER_FAILURE for mme_ue_s1ap_id  " MME_UE_S1AP_ID_FMT " ", handover_failure_p->mme_ue_s1ap_id);
-  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "S1AP_HANDOVER_FAILURE dropped, MME_APP is overloaded\n");
+  }
   /** No UE context to release. */
   OAILOG_FUNC_OUT (LOG_S1AP);
 }
@@ -2037,7 +2051,9 @@ static bool s1ap_send_enb_deregistered_ind (
     // max ues reached
     if (arg->current_ue_index == 0 && arg->handled_ues > 0) {
       S1AP_ENB_DEREGISTERED_IND (arg->message_p).nb_ue_to_deregister = S1AP_ITTI_UE_PER_DEREGISTER_MESSAGE;
-      itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, arg->message_p);
+      if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, arg->message_p) < 0) {
+        OAILOG_ERROR (LOG_S1AP, "S1AP_ENB_DEREGISTERED_IND dropped, MME_APP is overloaded\n");
+      }
       MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_NAS_MME, NULL, 0, "0 S1AP_ENB_DEREGISTERED_IND num ue to deregister %u",
           S1AP_ENB_DEREGISTERED_IND (arg->message_p).nb_ue_to_deregister);
       arg->message_p = NULL;
@@ -2134,7 +2150,9 @@ s1ap_handle_sctp_disconnection (
       S1AP_ENB_DEREGISTERED_IND (message_p).enb_ue_s1ap_id[arg.current_ue_index] = 0;
     }
     MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_NAS_MME, NULL, 0, "0 S1AP_ENB_DEREGISTERED_IND num ue to deregister %u", S1AP_ENB_DEREGISTERED_IND (message_p).nb_ue_to_deregister);
-    itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+    if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+      OAILOG_ERROR (LOG_S1AP, "S1AP_ENB_DEREGISTERED_IND dropped, MME_APP is overloaded\n");
+    }
     message_p = NULL;
 //  }
 
@@ -2145,6 +2163,78 @@ s1ap_handle_sctp_disconnection (
   OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
 }
 
+//------------------------------------------------------------------------------
+static bool s1ap_send_overload_message (
+    __attribute__((unused)) const hash_key_t keyP,
+    void * const dataP,
+    void *argP,
+    __attribute__((unused)) void ** resultP)
+{
+  enb_description_t                      *enb_ref = (enb_description_t*)dataP;
+  const bool                              overload_start = *(const bool*)argP;
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  s1ap_message                            message = {0};
+
+  if ((!enb_ref) || (S1AP_READY != enb_ref->s1_state)) {
+    return false;
+  }
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  message.criticality = S1ap_Criticality_ignore;
+  if (overload_start) {
+    message.procedureCode = S1ap_ProcedureCode_id_OverloadStart;
+    message.msg.s1ap_OverloadStartIEs.overloadResponse.present = S1ap_OverloadResponse_PR_overloadAction;
+    message.msg.s1ap_OverloadStartIEs.overloadResponse.choice.overloadAction = S1ap_OverloadAction_reject_non_emergency_mo_dt;
+  } else {
+    message.procedureCode = S1ap_ProcedureCode_id_OverloadStop;
+  }
+  if (s1ap_mme_encode_pdu (&message, &message_id, &buffer, &length) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Failed to encode S1AP Overload %s for eNB %u\n", (overload_start) ? "Start" : "Stop", enb_ref->enb_id);
+    return false;
+  }
+  MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_S1AP_ENB, NULL, 0, "0 Overload%s/initiatingMessage assoc_id %u", (overload_start) ? "Start" : "Stop", enb_ref->sctp_assoc_id);
+  bstring b = blk2bstr(buffer, length);
+  free(buffer);
+  s1ap_free_mme_encode_pdu(&message, message_id);
+  s1ap_mme_itti_send_sctp_request (&b, enb_ref->sctp_assoc_id, 0, INVALID_MME_UE_S1AP_ID);
+  return false;
+}
+
+//------------------------------------------------------------------------------
+int
+s1ap_handle_itti_overload_ind (
+    const itti_overload_ind_t * const overload_ind_p)
+{
+  static bool                             overloaded_tasks[TASK_MAX] = {false};
+  static uint32_t                         nb_overloaded_tasks = 0;
+  bool                                    overload_start = false;
+
+  OAILOG_FUNC_IN (LOG_S1AP);
+  DevAssert (overload_ind_p != NULL);
+  DevAssert (overload_ind_p->task_id < TASK_MAX);
+  OAILOG_WARNING (LOG_S1AP, "Queue of task %s %s overload (%u/%u messages)\n", itti_get_task_name (overload_ind_p->task_id),
+      (overload_ind_p->overloaded) ? "entered" : "left", overload_ind_p->queue_depth, overload_ind_p->queue_size);
+  if (overloaded_tasks[overload_ind_p->task_id] == overload_ind_p->overloaded) {
+    OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+  }
+  overloaded_tasks[overload_ind_p->task_id] = overload_ind_p->overloaded;
+  /*
+   * The MME is overloaded as long as one of its tasks is
+   */
+  if (overload_ind_p->overloaded) {
+    if (nb_overloaded_tasks++) {
+      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+    }
+    overload_start = true;
+  } else if (--nb_overloaded_tasks) {
+    OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+  }
+  OAILOG_NOTICE (LOG_S1AP, "Sending S1AP Overload %s to the eNBs\n", (overload_start) ? "Start" : "Stop");
+  hashtable_ts_apply_callback_on_elements(&g_s1ap_enb_coll, s1ap_send_overload_message, (void*)&overload_start, NULL);
+  OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+}
+
 //------------------------------------------------------------------------------
 int
 s1ap_handle_new_association (
@@ -2482,7 +2572,9 @@ s1ap_mme_handle_ue_context_rel_comp_timer_expiry (void *arg)
   memset ((void *)&message_p->ittiMsg.s1ap_ue_context_release_complete, 0, sizeof (itti_s1ap_ue_context_release_complete_t));
   S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id = ue_ref_p->mme_ue_s1ap_id;
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 S1AP_UE_CONTEXT_RELEASE_COMPLETE mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ", S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id);
-  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "S1AP_UE_CONTEXT_RELEASE_COMPLETE dropped, MME_APP is overloaded\n");
+  }
   DevAssert(ue_ref_p->s1_ue_state == S1AP_UE_WAITING_CRR);
   OAILOG_DEBUG (LOG_S1AP, "Removed S1AP UE " MME_UE_S1AP_ID_FMT "\n", (uint32_t) ue_ref_p->mme_ue_s1ap_id);
   s1ap_remove_ue (ue_ref_p);
@@ -2590,7 +2682,9 @@ s1ap_mme_handle_error_ind_message (const sctp_assoc_id_t assoc_id, const sctp_st
   S1AP_ERROR_INDICATION (message_p).cause = S1AP_HANDOVER_FAILED;
 
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 S1AP_ERROR_INDICATION mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ", S1AP_ERROR_INDICATION (message_p).mme_ue_s1ap_id);
-  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "S1AP_ERROR_INDICATION dropped, MME_APP is overloaded\n");
+  }
 
   OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
 }
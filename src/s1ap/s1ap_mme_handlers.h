@@ -83,6 +83,11 @@ int s1ap_handle_sctp_disconnection(const sctp_assoc_id_t assoc_id, bool reset);
 
 int s1ap_handle_new_association(sctp_new_peer_t *sctp_new_peer_p);
 
+/** \brief Start (first overloaded task) or stop (last task back to normal) the S1 overload procedure towards all the eNBs
+ * \param overload_ind_p ITTI_OVERLOAD_IND sent by ITTI with ITTI_OVERLOAD_POLICY_SIGNAL
+ **/
+int s1ap_handle_itti_overload_ind(const itti_overload_ind_t * const overload_ind_p);
+
 int s1ap_mme_set_cause(S1ap_Cause_t *cause_p, const S1ap_Cause_PR cause_type, const long cause_value);
 
 int s1ap_mme_generate_s1_setup_failure(
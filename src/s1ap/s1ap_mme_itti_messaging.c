@@ -113,7 +113,7 @@ s1ap_mme_itti_nas_downlink_cnf (
   return itti_send_msg_to_task (TASK_NAS_ESM, INSTANCE_DEFAULT, message_p);
 }
 //------------------------------------------------------------------------------
-void s1ap_mme_itti_s1ap_initial_ue_message(
+int s1ap_mme_itti_s1ap_initial_ue_message(
   const sctp_assoc_id_t   assoc_id,
   const uint32_t          enb_id,
   const enb_ue_s1ap_id_t  enb_ue_s1ap_id,
@@ -186,8 +186,7 @@ void s1ap_mme_itti_s1ap_initial_ue_message(
         (9 < S1AP_INITIAL_UE_MESSAGE(message_p).tai.mnc_digit3) ? ' ': (char)(S1AP_INITIAL_UE_MESSAGE(message_p).tai.mnc_digit3 + 0x30),
         S1AP_INITIAL_UE_MESSAGE(message_p).tai.tac,
         S1AP_INITIAL_UE_MESSAGE(message_p).nas->slen);
-  itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
-  OAILOG_FUNC_OUT (LOG_S1AP);
+  OAILOG_FUNC_RETURN (LOG_S1AP, itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p));
 }
 
 //------------------------------------------------------------------------------
@@ -223,7 +222,7 @@ static int s1ap_mme_non_delivery_cause_2_nas_data_rej_cause(const S1ap_Cause_t *
   return AS_FAILURE;
 }
 //------------------------------------------------------------------------------
-void s1ap_mme_itti_nas_non_delivery_ind(
+int s1ap_mme_itti_nas_non_delivery_ind(
     const mme_ue_s1ap_id_t ue_id, uint8_t * const nas_msg, const size_t nas_msg_length, const S1ap_Cause_t * const cause)
 {
   MessageDef     *message_p = NULL;
@@ -246,6 +245,5 @@ void s1ap_mme_itti_nas_non_delivery_ind(
 
   // should be sent to MME_APP, but this one would forward it to NAS_MME, so send it directly to NAS_MME
   // but let's see
-  itti_send_msg_to_task(TASK_NAS_EMM, INSTANCE_DEFAULT, message_p);
-  OAILOG_FUNC_OUT (LOG_S1AP);
+  OAILOG_FUNC_RETURN (LOG_S1AP, itti_send_msg_to_task(TASK_NAS_EMM, INSTANCE_DEFAULT, message_p));
 }
@@ -43,7 +43,7 @@ int s1ap_mme_itti_nas_uplink_ind(const mme_ue_s1ap_id_t ue_id,
 
 int s1ap_mme_itti_nas_downlink_cnf (const mme_ue_s1ap_id_t ue_id, const bool is_success);
 
-void s1ap_mme_itti_s1ap_initial_ue_message(
+int s1ap_mme_itti_s1ap_initial_ue_message(
   const sctp_assoc_id_t   assoc_id,
   const uint32_t          enb_id,
   const enb_ue_s1ap_id_t  enb_ue_s1ap_id,
@@ -102,6 +102,6 @@ static inline void s1ap_mme_itti_nas_establish_ind(
   OAILOG_FUNC_OUT (LOG_S1AP);
 }
 #endif
-void s1ap_mme_itti_nas_non_delivery_ind(const mme_ue_s1ap_id_t ue_id, uint8_t * const nas_msg, const size_t nas_msg_length, const S1ap_Cause_t * const cause);
+int s1ap_mme_itti_nas_non_delivery_ind(const mme_ue_s1ap_id_t ue_id, uint8_t * const nas_msg, const size_t nas_msg_length, const S1ap_Cause_t * const cause);
 
 #endif /* FILE_S1AP_MME_ITTI_MESSAGING_SEEN */
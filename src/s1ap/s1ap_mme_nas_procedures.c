@@ -192,7 +192,7 @@ s1ap_mme_handle_initial_ue_message (
         initialUEMessage_p->rrC_Establishment_Cause,
         &tai, &cgi, &s_tmsi, &gummei);
 #else
-    s1ap_mme_itti_s1ap_initial_ue_message (assoc_id,
+    if (RETURNok != s1ap_mme_itti_s1ap_initial_ue_message (assoc_id,
         ue_ref->enb->enb_id,
         ue_ref->enb_ue_s1ap_id,
         ue_ref->mme_ue_s1ap_id,
@@ -207,7 +207,15 @@ s1ap_mme_handle_initial_ue_message (
         NULL, // CELL ACCESS MODE
         NULL, // GW Transport Layer Address
         NULL  //Relay Node Indicator
-        );
+        )) {
+      /*
+       * MME_APP is overloaded and will never hear of this UE, do not keep an S1AP context waiting for it.
+       * The eNB will release the RRC connection and the UE will retry.
+       */
+      OAILOG_WARNING (LOG_S1AP, "S1AP:Initial UE Message- Dropped by MME_APP, removing S1AP UE Context, eNBUeS1APId:" ENB_UE_S1AP_ID_FMT "\n", enb_ue_s1ap_id);
+      s1ap_remove_ue (ue_ref);
+      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+    }
 #endif
 #endif
   }else {
@@ -304,11 +312,10 @@ s1ap_mme_handle_uplink_nas_transport (
                       uplinkNASTransport_p->nas_pdu.size);
 
   bstring b = blk2bstr(uplinkNASTransport_p->nas_pdu.buf, uplinkNASTransport_p->nas_pdu.size);
-  s1ap_mme_itti_nas_uplink_ind (uplinkNASTransport_p->mme_ue_s1ap_id,
+  OAILOG_FUNC_RETURN (LOG_S1AP, s1ap_mme_itti_nas_uplink_ind (uplinkNASTransport_p->mme_ue_s1ap_id,
                                 &b,
                                 &tai,
-                                &ecgi);
-  OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+                                &ecgi));
 }
 
 
@@ -357,11 +364,42 @@ s1ap_mme_handle_nas_non_delivery (
     OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
   }
   //TODO: forward NAS PDU to NAS
-  s1ap_mme_itti_nas_non_delivery_ind (nasNonDeliveryIndication_p->mme_ue_s1ap_id,
+  OAILOG_FUNC_RETURN (LOG_S1AP, s1ap_mme_itti_nas_non_delivery_ind (nasNonDeliveryIndication_p->mme_ue_s1ap_id,
                                       nasNonDeliveryIndication_p->nas_pdu.buf,
                                       nasNonDeliveryIndication_p->nas_pdu.size,
-                                      &nasNonDeliveryIndication_p->cause);
-  OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+                                      &nasNonDeliveryIndication_p->cause));
+}
+
+//------------------------------------------------------------------------------
+// asn1c encoding of a downlink NAS transport whose NAS PDU is too long for s1ap_encode_downlink_nas_transport()
+static int
+s1ap_generate_downlink_nas_transport_asn1c (
+  const ue_description_t * const ue_ref,
+  bstring *payload)
+{
+  S1ap_DownlinkNASTransportIEs_t         *downlinkNasTransport = NULL;
+  s1ap_message                            message = {0};
+  uint8_t                                *buffer_p = NULL;
+  uint32_t                                length = 0;
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  int                                     rc = RETURNerror;
+
+  message.procedureCode = S1ap_ProcedureCode_id_downlinkNASTransport;
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  message.criticality = S1ap_Criticality_ignore;
+  downlinkNasTransport = &message.msg.s1ap_DownlinkNASTransportIEs;
+  downlinkNasTransport->mme_ue_s1ap_id = ue_ref->mme_ue_s1ap_id;
+  downlinkNasTransport->eNB_UE_S1AP_ID = ue_ref->enb_ue_s1ap_id;
+  OCTET_STRING_fromBuf (&downlinkNasTransport->nas_pdu, (char *)bdata(*payload), blength(*payload));
+
+  if (s1ap_mme_encode_pdu (&message, &message_id, &buffer_p, &length) >= 0) {
+    bdestroy_wrapper (payload);
+    *payload = blk2bstr(buffer_p, length);
+    free_wrapper ((void**)&buffer_p);
+    rc = RETURNok;
+  }
+  s1ap_free_mme_encode_pdu (&message, message_id);
+  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -374,9 +412,8 @@ s1ap_generate_downlink_nas_transport (
 {
   OAILOG_FUNC_IN (LOG_S1AP);
   ue_description_t                       *ue_ref = NULL;
-  uint8_t                                *buffer_p = NULL;
-  uint32_t                                length = 0;
-  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  ssize_t                                 length = 0;
+  int                                     nas_length = 0;
   void                                   *id = NULL;
 
   // Try to retrieve SCTP association id using mme_ue_s1ap_id
@@ -411,41 +448,25 @@ s1ap_generate_downlink_nas_transport (
 
   /*
    * We have fount the UE in the list.
-   * * * * Create new IE list message and encode it.
+   * * * * Encode the message around the NAS PDU: the bstring, allocated by NAS with spare room
+   * * * * for the S1AP header, is sent to the SCTP task as is.
    */
-  S1ap_DownlinkNASTransportIEs_t         *downlinkNasTransport = NULL;
-  s1ap_message                            message = {0};
-
-  message.procedureCode = S1ap_ProcedureCode_id_downlinkNASTransport;
-  message.direction = S1AP_PDU_PR_initiatingMessage;
 //  ue_ref->s1_ue_state = S1AP_UE_CONNECTED; todo: detach procedure might be ongoing
-  downlinkNasTransport = &message.msg.s1ap_DownlinkNASTransportIEs;
-  /*
-   * Setting UE informations with the ones fount in ue_ref
-   */
-  downlinkNasTransport->mme_ue_s1ap_id = ue_ref->mme_ue_s1ap_id;
-  downlinkNasTransport->eNB_UE_S1AP_ID = ue_ref->enb_ue_s1ap_id;
-  /*eNB
-   * Fill in the NAS pdu
-   */
-  OCTET_STRING_fromBuf (&downlinkNasTransport->nas_pdu, (char *)bdata(*payload), blength(*payload));
-  bdestroy_wrapper (payload);
-
-  if (s1ap_mme_encode_pdu (&message, &message_id, &buffer_p, &length) < 0) {
-    // TODO: handle something
+  nas_length = blength(*payload);
+  if (((length = s1ap_encode_downlink_nas_transport (*payload, ue_ref->mme_ue_s1ap_id, ue_ref->enb_ue_s1ap_id)) < 0) &&
+      (s1ap_generate_downlink_nas_transport_asn1c (ue_ref, payload) != RETURNok)) {
+    OAILOG_ERROR (LOG_S1AP, "Encoding of DOWNLINK_NAS_TRANSPORT failed ue_id = " MME_UE_S1AP_ID_FMT "\n", ue_id);
+    bdestroy_wrapper (payload);
     OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
   }
   OAILOG_NOTICE (LOG_S1AP, "Send S1AP DOWNLINK_NAS_TRANSPORT message ue_id = " MME_UE_S1AP_ID_FMT " MME_UE_S1AP_ID = " MME_UE_S1AP_ID_FMT " eNB_UE_S1AP_ID = " ENB_UE_S1AP_ID_FMT "\n",
-      ue_id, (mme_ue_s1ap_id_t)downlinkNasTransport->mme_ue_s1ap_id, (enb_ue_s1ap_id_t)downlinkNasTransport->eNB_UE_S1AP_ID);
+      ue_id, ue_ref->mme_ue_s1ap_id, ue_ref->enb_ue_s1ap_id);
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME,
       MSC_S1AP_ENB,
       NULL, 0,
-      "0 downlinkNASTransport/initiatingMessage ue_id " MME_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " enb_ue_s1ap_id" ENB_UE_S1AP_ID_FMT " nas length %u",
-      ue_id, (mme_ue_s1ap_id_t)downlinkNasTransport->mme_ue_s1ap_id, (enb_ue_s1ap_id_t)downlinkNasTransport->eNB_UE_S1AP_ID, length);
-  bstring b = blk2bstr(buffer_p, length);
-  free(buffer_p);
-  s1ap_free_mme_encode_pdu(&message, message_id);
-  s1ap_mme_itti_send_sctp_request (&b , ue_ref->enb->sctp_assoc_id, ue_ref->sctp_stream_send, ue_ref->mme_ue_s1ap_id);
+      "0 downlinkNASTransport/initiatingMessage ue_id " MME_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " enb_ue_s1ap_id" ENB_UE_S1AP_ID_FMT " nas length %d",
+      ue_id, ue_ref->mme_ue_s1ap_id, ue_ref->enb_ue_s1ap_id, nas_length);
+  s1ap_mme_itti_send_sctp_request (payload, ue_ref->enb->sctp_assoc_id, ue_ref->sctp_stream_send, ue_ref->mme_ue_s1ap_id);
 
   OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
 }
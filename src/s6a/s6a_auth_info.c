@@ -213,10 +213,14 @@ s6a_aia_cb (
   struct msg                             *ans = NULL;
   struct msg                             *qry = NULL;
   struct avp                             *avp = NULL;
+  struct avp                             *avp_result_code = NULL;
+  struct avp                             *avp_experimental_result = NULL;
+  struct avp                             *avp_authentication_info = NULL;
   struct avp_hdr                         *hdr = NULL;
   MessageDef                             *message_p = NULL;
   s6a_auth_info_ans_t                    *s6a_auth_info_ans_p = NULL;
   int                                     skip_auth_res = 0;
+  bool                                    forward = true;
 
   DevAssert (msg );
   ans = *msg;
@@ -239,12 +243,38 @@ s6a_aia_cb (
   }
 
   /*
-   * Retrieve the result-code
+   * Locate the AVPs of interest in a single walk over the answer
    */
-  CHECK_FCT (fd_msg_search_avp (ans, s6a_fd_cnf.dataobj_s6a_result_code, &avp));
+  CHECK_FCT (fd_msg_browse (ans, MSG_BRW_FIRST_CHILD, &avp, NULL));
 
-  if (avp) {
+  while (avp) {
     CHECK_FCT (fd_msg_avp_hdr (avp, &hdr));
+
+    switch (hdr->avp_code) {
+    case AVP_CODE_RESULT_CODE:
+      avp_result_code = avp;
+      break;
+
+    case AVP_CODE_EXPERIMENTAL_RESULT:
+      avp_experimental_result = avp;
+      break;
+
+    case AVP_CODE_AUTHENTICATION_INFO:
+      avp_authentication_info = avp;
+      break;
+
+    default:
+      break;
+    }
+
+    CHECK_FCT (fd_msg_browse (avp, MSG_BRW_NEXT, &avp, NULL));
+  }
+
+  /*
+   * Retrieve the result-code
+   */
+  if (avp_result_code) {
+    CHECK_FCT (fd_msg_avp_hdr (avp_result_code, &hdr));
     s6a_auth_info_ans_p->result.present = S6A_RESULT_BASE;
     s6a_auth_info_ans_p->result.choice.base = hdr->avp_value->u32;
     MSC_LOG_TX_MESSAGE (MSC_S6A_MME, MSC_NAS_MME, NULL, 0, "0 S6A_AUTH_INFO_ANS imsi %s %s", s6a_auth_info_ans_p->imsi, retcode_2_string (s6a_auth_info_ans_p->result.choice.base));
@@ -260,16 +290,14 @@ s6a_aia_cb (
      * The result-code is not present, may be it is an experimental result
      * * * * avp indicating a 3GPP specific failure.
      */
-    CHECK_FCT (fd_msg_search_avp (ans, s6a_fd_cnf.dataobj_s6a_experimental_result, &avp));
-
-    if (avp) {
+    if (avp_experimental_result) {
       /*
        * The procedure has failed within the HSS.
        * * * * NOTE: contrary to result-code, the experimental-result is a grouped
        * * * * AVP and requires parsing its childs to get the code back.
        */
       s6a_auth_info_ans_p->result.present = S6A_RESULT_EXPERIMENTAL;
-      s6a_parse_experimental_result (avp, &s6a_auth_info_ans_p->result.choice.experimental);
+      s6a_parse_experimental_result (avp_experimental_result, &s6a_auth_info_ans_p->result.choice.experimental);
       MSC_LOG_TX_MESSAGE (MSC_S6A_MME, MSC_NAS_MME, NULL, 0, "0 S6A_AUTH_INFO_ANS imsi %s %s", s6a_auth_info_ans_p->imsi, experimental_retcode_2_string (s6a_auth_info_ans_p->result.choice.experimental));
       skip_auth_res = 1;
     } else {
@@ -284,20 +312,30 @@ s6a_aia_cb (
   }
 
   if (skip_auth_res == 0) {
-    CHECK_FCT (fd_msg_search_avp (ans, s6a_fd_cnf.dataobj_s6a_authentication_info, &avp));
-
-    if (avp) {
-      CHECK_FCT (s6a_parse_authentication_info_avp (avp, &s6a_auth_info_ans_p->auth_info));
+    if (avp_authentication_info) {
+      CHECK_FCT (s6a_parse_authentication_info_avp (avp_authentication_info, &s6a_auth_info_ans_p->auth_info));
     } else {
       DevMessage ("We requested E-UTRAN vectors with an immediate response...\n");
       return RETURNerror;
     }
   }
+  forward = s6a_inflight_end (S6A_INFLIGHT_AIR, s6a_auth_info_ans_p->imsi, qry,
+      (S6A_RESULT_BASE == s6a_auth_info_ans_p->result.present) ? s6a_auth_info_ans_p->result.choice.base : 0);
   fd_msg_free(*msg);
   *msg = NULL;
 
-  itti_send_msg_to_task (TASK_NAS_EMM, INSTANCE_DEFAULT, message_p);
+  if (forward) {
+    itti_send_msg_to_task (TASK_NAS_EMM, INSTANCE_DEFAULT, message_p);
+  } else {
+    /*
+     * Sent again to another HSS peer, its answer is forwarded instead
+     */
+    itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+  }
+  return RETURNok;
 err:
+  s6a_inflight_end (S6A_INFLIGHT_AIR, s6a_auth_info_ans_p->imsi, qry, 0);
+  itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
   return RETURNok;
 }
 
@@ -306,90 +344,44 @@ s6a_generate_authentication_info_req (
   s6a_auth_info_req_t * air_p)
 {
   struct avp                             *avp;
-  struct msg                             *msg;
-  struct session                         *sess;
+  struct msg                             *msg = NULL;
+  struct msg                             *qry;
   union avp_value                         value;
+  s6a_template_t                         *template_p = NULL;
+  int                                     hss_peer = 0;
+  int                                     ret = 0;
 
   DevAssert (air_p );
   /*
-   * Create the new update location request message
+   * An identical AIR pending for the IMSI (attach retried by the UE) is not sent again
    */
-  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_air, 0, &msg));
-  /*
-   * Create a new session
-   */
-  CHECK_FCT (fd_sess_new (&sess, fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len, (os0_t) "apps6a", 6));
-  {
-    os0_t                                   sid;
-    size_t                                  sidlen;
-
-    CHECK_FCT (fd_sess_getsid (sess, &sid, &sidlen));
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_session_id, 0, &avp));
-    value.os.data = sid;
-    value.os.len = sidlen;
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_FIRST_CHILD, avp));
+  hss_peer = s6a_inflight_air_begin (air_p);
+  if (0 > hss_peer) {
+    return RETURNok;
   }
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_auth_session_state, 0, &avp));
+  template_p = &s6a_fd_cnf.hss_peers[hss_peer].request_template;
   /*
-   * No State maintained
+   * Create the new authentication information request from the constant AVPs of the HSS:
+   * session id, auth session state, origin and destination
    */
-  value.i32 = 1;
-  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-  CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-  /*
-   * Add Origin_Host & Origin_Realm
-   */
-  CHECK_FCT (fd_msg_add_origin (msg, 0));
-  mme_config_read_lock (&mme_config);
-  /*
-   * Destination Host
-   */
-  {
-    bstring                                 host = bstrcpy(mme_config.s6a_config.hss_host_name);
-
-    bconchar(host, '.');
-    bconcat (host, mme_config.realm);
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_host, 0, &avp));
-    value.os.data = (unsigned char *)bdata(host);
-    value.os.len = blength(host);
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-    bdestroy_wrapper(&host);
-  }
-  /*
-   * Destination_Realm
-   */
-  {
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_realm, 0, &avp));
-    value.os.data = (unsigned char *)bdata(mme_config.realm);
-    value.os.len = blength(mme_config.realm);
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-  }
-  mme_config_unlock (&mme_config);
+  CHECK_FCT_DO (ret = s6a_template_new_request (template_p, s6a_fd_cnf.dataobj_s6a_air, &msg), goto err);
   /*
    * Adding the User-Name (IMSI)
    */
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_user_name, 0, &avp));
+  CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_user_name, 0, &avp), goto err);
   value.os.data = (unsigned char *)air_p->imsi;
   value.os.len = strlen (air_p->imsi);
-  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-  CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
+  CHECK_FCT_DO (ret = fd_msg_avp_setvalue (avp, &value), goto err);
+  CHECK_FCT_DO (ret = fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp), goto err);
   /*
    * Adding the visited plmn id
    */
   {
-    uint8_t                                 plmn[3] = { 0x00, 0x00, 0x00 };     //{ 0x02, 0xF8, 0x29 };
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_visited_plmn_id, 0, &avp));
-    PLMN_T_TO_TBCD (air_p->visited_plmn,
-                    plmn, mme_config_find_mnc_length (air_p->visited_plmn.mcc_digit1, air_p->visited_plmn.mcc_digit2, air_p->visited_plmn.mcc_digit3, air_p->visited_plmn.mnc_digit1, air_p->visited_plmn.mnc_digit2, air_p->visited_plmn.mnc_digit3)
-      );
-    value.os.data = plmn;
+    CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_visited_plmn_id, 0, &avp), goto err);
+    value.os.data = (uint8_t *)s6a_template_visited_plmn_id (template_p, &air_p->visited_plmn);
     value.os.len = 3;
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-    OAILOG_DEBUG (LOG_S6A, "%s plmn: %02X%02X%02X\n", __FUNCTION__, plmn[0], plmn[1], plmn[2]);
+    CHECK_FCT_DO (ret = fd_msg_avp_setvalue (avp, &value), goto err);
+    CHECK_FCT_DO (ret = fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp), goto err);
     OAILOG_DEBUG (LOG_S6A, "%s visited_plmn: %02X%02X%02X\n", __FUNCTION__, value.os.data[0], value.os.data[1], value.os.data[2]);
   }
   /*
@@ -398,38 +390,58 @@ s6a_generate_authentication_info_req (
   {
     struct avp                             *child_avp;
 
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_req_eutran_auth_info, 0, &avp));
+    CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_req_eutran_auth_info, 0, &avp), goto err);
     /*
      * Add the number of requested vectors
      */
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_number_of_requested_vectors, 0, &child_avp));
+    CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_number_of_requested_vectors, 0, &child_avp), goto err);
     value.u32 = air_p->nb_of_vectors;
-    CHECK_FCT (fd_msg_avp_setvalue (child_avp, &value));
-    CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
+    CHECK_FCT_DO (ret = fd_msg_avp_setvalue (child_avp, &value), goto err);
+    CHECK_FCT_DO (ret = fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp), goto err);
     /*
      * We want to use the vectors immediately in HSS so we have to add
      * * * * the Immediate-Response-Preferred AVP.
      * * * * Value of this AVP is not significant.
      */
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_immediate_response_pref, 0, &child_avp));
+    CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_immediate_response_pref, 0, &child_avp), goto err);
     value.u32 = 0;
-    CHECK_FCT (fd_msg_avp_setvalue (child_avp, &value));
-    CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
+    CHECK_FCT_DO (ret = fd_msg_avp_setvalue (child_avp, &value), goto err);
+    CHECK_FCT_DO (ret = fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp), goto err);
 
     /*
      * Re-synchronization information containing the AUTS computed at USIM
      */
     if (air_p->re_synchronization) {
       OAILOG_DEBUG (LOG_S6A, "Added Re-Synchronistaion for UE \n");
-      CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_re_synchronization_info, 0, &child_avp));
+      CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_re_synchronization_info, 0, &child_avp), goto err);
       value.os.len = RESYNC_PARAM_LENGTH;
       value.os.data = air_p->auts;
-      CHECK_FCT (fd_msg_avp_setvalue (child_avp, &value));
-      CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
+      CHECK_FCT_DO (ret = fd_msg_avp_setvalue (child_avp, &value), goto err);
+      CHECK_FCT_DO (ret = fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp), goto err);
     }
 
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
+    CHECK_FCT_DO (ret = fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp), goto err);
+  }
+  /*
+   * The answer is matched to the in-flight request by its query
+   */
+  qry = msg;
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air_p->imsi, qry);
+  ret = fd_msg_send (&msg, NULL, NULL);
+  if (ret) {
+    OAILOG_ERROR (LOG_S6A, "Failed to send S6a AIR for IMSI %s: %d\n", air_p->imsi, ret);
+    s6a_inflight_end (S6A_INFLIGHT_AIR, air_p->imsi, qry, 0);
+    return ret;
   }
-  CHECK_FCT (fd_msg_send (&msg, NULL, NULL));
   return RETURNok;
+err:
+  /*
+   * Not sent, the in-flight entry is released so that a retry of the UE is sent again
+   */
+  OAILOG_ERROR (LOG_S6A, "S6a AIR for IMSI %s could not be built: %d\n", air_p->imsi, ret);
+  if (msg) {
+    fd_msg_free (msg);
+  }
+  s6a_inflight_end (S6A_INFLIGHT_AIR, air_p->imsi, NULL, 0);
+  return ret;
 }
@@ -70,6 +70,43 @@
     (x == DIAMETER_AUTHENTICATION_DATA_UNAVAILABLE) || \
     (x == DIAMETER_ERROR_UNKOWN_SERVING_NODE))
 
+/* Constant AVPs of the requests sent to an HSS peer, prepared once instead of for
+ * each request. A request is created from them and only gets its session id, IMSI
+ * and own AVPs (requested vectors, ULR flags...) added.
+ */
+typedef struct s6a_template_s {
+  bstring  destination_host;       /* hss_host_name.realm */
+  bstring  destination_realm;
+  uint8_t  mme_plmn_id[3];         /* Visited-PLMN-Id of the ULR, TBCD of the first GUMMEI PLMN */
+  bool     visited_plmn_valid;     /* Visited-PLMN-Id of the last AIR */
+  plmn_t   visited_plmn;
+  uint8_t  visited_plmn_id[3];
+} s6a_template_t;
+
+/* An HSS of the realm. The AIR and ULR are sent to the open HSS peer with the
+ * fewest pending requests relative to its weight.
+ */
+typedef struct s6a_hss_peer_s {
+  s6a_template_t    request_template;  /* constant AVPs of the requests to this HSS */
+  uint32_t          weight;
+  struct peer_hdr  *peer;              /* freeDiameter peer, NULL until known, protected by the in-flight table lock */
+  uint32_t          inflight;          /* requests sent and not answered yet, protected by the in-flight table lock */
+} s6a_hss_peer_t;
+
+/* Pending AIR and ULR, by IMSI: an identical request for the same IMSI received
+ * while one is pending is not sent, the answer of the pending one serves both
+ * (the answers are matched to the UE contexts by IMSI).
+ * A request still unanswered after S6A_INFLIGHT_TIMEOUT_SEC no longer absorbs
+ * the identical ones.
+ */
+#define S6A_INFLIGHT_TIMEOUT_SEC    (5)
+#define S6A_INFLIGHT_HT_SIZE        (4096)
+
+typedef enum {
+  S6A_INFLIGHT_AIR = 0,
+  S6A_INFLIGHT_ULR,
+} s6a_inflight_type_t;
+
 typedef struct {
   struct dict_object *dataobj_s6a_vendor;     /* s6a vendor object */
   struct dict_object *dataobj_s6a_app;        /* s6a application object */
@@ -125,6 +162,9 @@ typedef struct {
   struct disp_hdl *clr_hdl;   /* Cancel Location Request Handle */
   struct disp_hdl *rr_hdl;    /* Reset Request Handle */
   struct disp_hdl *na_hdl;    /* Reset Request Handle */
+
+  uint8_t         nb_hss_peers;
+  s6a_hss_peer_t  hss_peers[MAX_HSS_PEERS];
 } s6a_fd_cnf_t;
 
 extern s6a_fd_cnf_t s6a_fd_cnf;
@@ -157,6 +197,7 @@ extern s6a_fd_cnf_t s6a_fd_cnf;
 
 #define AVP_CODE_3GPP_CHARGING_CHARACTERISTICS     (13)
 #define AVP_CODE_VENDOR_ID                         (266)
+#define AVP_CODE_RESULT_CODE                       (268)
 #define AVP_CODE_EXPERIMENTAL_RESULT               (297)
 #define AVP_CODE_EXPERIMENTAL_RESULT_CODE          (298)
 #define AVP_CODE_MIP_HOME_AGENT_ADDRESS            (334)
@@ -249,10 +290,36 @@ int s6a_init(const mme_config_t *mme_config);
 
 int s6a_fd_new_peer(void);
 
+int s6a_hss_peers_init(const mme_config_t * const mme_config_p);
+
+void s6a_hss_peers_exit(void);
+
+int s6a_hss_peer_select(const uint32_t excluded_hss_peers);
+
 void s6a_peer_connected_cb(struct peer_info *info, void *arg);
 
 int s6a_fd_init_dict_objs(void);
 
+int s6a_template_init(s6a_template_t * const template_p, const mme_config_t * const mme_config_p, const_bstring hss_host_name);
+
+void s6a_template_free(s6a_template_t * const template_p);
+
+const uint8_t *s6a_template_visited_plmn_id(s6a_template_t * const template_p, const plmn_t * const visited_plmn);
+
+int s6a_template_new_request(const s6a_template_t * const template_p, struct dict_object * const command, struct msg ** const msg);
+
+int s6a_inflight_init(void);
+
+void s6a_inflight_exit(void);
+
+int s6a_inflight_hss_peer_select(void);
+
+void s6a_inflight_hss_peer_found(const int hss_peer, struct peer_hdr * const peer);
+
+void s6a_inflight_sent(const s6a_inflight_type_t type, const char * const imsi, struct msg * const query);
+
+bool s6a_inflight_end(const s6a_inflight_type_t type, const char * const imsi, struct msg * const query, const uint32_t result_code);
+
 int s6a_parse_subscription_data(struct avp *avp_subscription_data,
                                 subscription_data_t *subscription_data);
 
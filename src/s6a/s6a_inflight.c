@@ -0,0 +1,309 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_inflight.c
+   \brief Pending AIR and ULR by IMSI: merging of the identical requests and failover to another HSS peer.
+   The requests are sent by the S6A task, the answers are received in the freeDiameter threads.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "hashtable.h"
+#include "log.h"
+#include "assertions.h"
+#include "conversions.h"
+#include "common_defs.h"
+#include "intertask_interface.h"
+#include "mme_app_statistics.h"
+#include "s6a_defs.h"
+#include "s6a_messages.h"
+
+// The IMSI is at most 15 digits (< 2^50)
+#define S6A_INFLIGHT_KEY(tYPE, iMSI64)  (((hash_key_t)(tYPE) << 56) | (hash_key_t)(iMSI64))
+
+typedef struct s6a_inflight_s {
+  struct msg                   *query;            /* request sent to the HSS, NULL while it is sent again */
+  int                           hss_peer;         /* index in s6a_fd_cnf.hss_peers, -1 once no more accounted on it */
+  uint32_t                      tried_hss_peers;  /* HSS peers the request was sent to */
+  bool                          failover;         /* sent again to another HSS peer by the S6A task */
+  uint32_t                      nb_merged;
+  time_t                        sent_sec;
+  union {
+    s6a_auth_info_req_t         air;
+    s6a_update_location_req_t   ulr;
+  } u;
+} s6a_inflight_t;
+
+static pthread_mutex_t                  s6a_inflight_lock = PTHREAD_MUTEX_INITIALIZER;
+static hash_table_t                    *s6a_inflight_htbl = NULL;
+
+//------------------------------------------------------------------------------
+static time_t s6a_inflight_now_sec (void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+//------------------------------------------------------------------------------
+static hash_key_t s6a_inflight_key (const s6a_inflight_type_t type, const char * const imsi)
+{
+  imsi64_t                                imsi64 = 0;
+
+  IMSI_STRING_TO_IMSI64 (imsi, &imsi64);
+  return S6A_INFLIGHT_KEY (type, imsi64);
+}
+
+//------------------------------------------------------------------------------
+static bool s6a_inflight_is_same_request (const s6a_inflight_type_t type, const s6a_inflight_t * const inflight, const void * const request)
+{
+  if (S6A_INFLIGHT_AIR == type) {
+    const s6a_auth_info_req_t * const air_p = (const s6a_auth_info_req_t *)request;
+
+    if ((air_p->nb_of_vectors != inflight->u.air.nb_of_vectors) ||
+        (air_p->re_synchronization != inflight->u.air.re_synchronization) ||
+        (memcmp (&air_p->visited_plmn, &inflight->u.air.visited_plmn, sizeof (plmn_t)))) {
+      return false;
+    }
+    // a re-synchronization carries the AUTS of a new authentication challenge
+    return ((!air_p->re_synchronization) || (!memcmp (air_p->auts, inflight->u.air.auts, sizeof (air_p->auts))));
+  } else {
+    const s6a_update_location_req_t * const ulr_p = (const s6a_update_location_req_t *)request;
+
+    return ((ulr_p->skip_subscriber_data == inflight->u.ulr.skip_subscriber_data) &&
+            (ulr_p->initial_attach == inflight->u.ulr.initial_attach) &&
+            (ulr_p->rat_type == inflight->u.ulr.rat_type) &&
+            (!memcmp (&ulr_p->visited_plmn, &inflight->u.ulr.visited_plmn, sizeof (plmn_t))));
+  }
+}
+
+//------------------------------------------------------------------------------
+static void s6a_inflight_release_hss_peer (s6a_inflight_t * const inflight)
+{
+  if (0 <= inflight->hss_peer) {
+    s6a_fd_cnf.hss_peers[inflight->hss_peer].inflight--;
+    inflight->hss_peer = -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+int s6a_inflight_init (void)
+{
+  bstring b = bfromcstr ("s6a_inflight");
+
+  s6a_inflight_htbl = hashtable_create (S6A_INFLIGHT_HT_SIZE, NULL, free_wrapper, b);
+  bdestroy_wrapper (&b);
+  if (!s6a_inflight_htbl) {
+    OAILOG_ERROR (LOG_S6A, "Failed to create the S6a in-flight requests table\n");
+    return RETURNerror;
+  }
+  s6a_inflight_htbl->log_enabled = false;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s6a_inflight_exit (void)
+{
+  pthread_mutex_lock (&s6a_inflight_lock);
+  if (s6a_inflight_htbl) {
+    hashtable_destroy (s6a_inflight_htbl);
+    s6a_inflight_htbl = NULL;
+  }
+  pthread_mutex_unlock (&s6a_inflight_lock);
+}
+
+//------------------------------------------------------------------------------
+static int s6a_inflight_begin (const s6a_inflight_type_t type, const char * const imsi, const void * const request)
+{
+  const hash_key_t                        key = s6a_inflight_key (type, imsi);
+  const time_t                            now = s6a_inflight_now_sec ();
+  s6a_inflight_t                         *inflight = NULL;
+  int                                     hss_peer = -1;
+
+  pthread_mutex_lock (&s6a_inflight_lock);
+  hashtable_get (s6a_inflight_htbl, key, (void **)&inflight);
+
+  if (inflight) {
+    if (inflight->failover) {
+      inflight->failover = false;
+    } else if (((now - inflight->sent_sec) < S6A_INFLIGHT_TIMEOUT_SEC) && (s6a_inflight_is_same_request (type, inflight, request))) {
+      /*
+       * The answer of the pending request is forwarded for this one too
+       */
+      inflight->nb_merged++;
+      pthread_mutex_unlock (&s6a_inflight_lock);
+      mme_stats_inc (S6A_REQUEST_MERGED);
+      OAILOG_DEBUG (LOG_S6A, "S6a %s for IMSI %s merged into the pending one\n", (S6A_INFLIGHT_AIR == type) ? "AIR" : "ULR", imsi);
+      return -1;
+    } else {
+      /*
+       * Superseded or unanswered for too long, the answer of the pending request
+       * (if any) is still forwarded but no more accounted on its HSS peer.
+       */
+      s6a_inflight_release_hss_peer (inflight);
+      inflight->tried_hss_peers = 0;
+      inflight->nb_merged = 0;
+    }
+  } else {
+    inflight = calloc (1, sizeof (*inflight));
+    if (!inflight) {
+      /*
+       * Sent untracked, its answer is forwarded as is
+       */
+      hss_peer = s6a_hss_peer_select (0);
+      pthread_mutex_unlock (&s6a_inflight_lock);
+      OAILOG_ERROR (LOG_S6A, "S6a %s for IMSI %s not tracked, out of memory\n", (S6A_INFLIGHT_AIR == type) ? "AIR" : "ULR", imsi);
+      return (0 > hss_peer) ? 0 : hss_peer;
+    }
+    inflight->hss_peer = -1;
+    hashtable_insert (s6a_inflight_htbl, key, inflight);
+  }
+
+  if (S6A_INFLIGHT_AIR == type) {
+    inflight->u.air = *(const s6a_auth_info_req_t *)request;
+  } else {
+    inflight->u.ulr = *(const s6a_update_location_req_t *)request;
+  }
+
+  hss_peer = s6a_hss_peer_select (inflight->tried_hss_peers);
+  if (0 > hss_peer) {
+    /*
+     * No HSS peer open, freeDiameter queues the request or answers DIAMETER_UNABLE_TO_DELIVER
+     */
+    hss_peer = 0;
+  }
+  inflight->hss_peer = hss_peer;
+  inflight->tried_hss_peers |= (1U << hss_peer);
+  inflight->query = NULL;
+  inflight->sent_sec = now;
+  s6a_fd_cnf.hss_peers[hss_peer].inflight++;
+  pthread_mutex_unlock (&s6a_inflight_lock);
+  return hss_peer;
+}
+
+//------------------------------------------------------------------------------
+int s6a_inflight_air_begin (const s6a_auth_info_req_t * const air_p)
+{
+  return s6a_inflight_begin (S6A_INFLIGHT_AIR, air_p->imsi, air_p);
+}
+
+//------------------------------------------------------------------------------
+int s6a_inflight_ulr_begin (const s6a_update_location_req_t * const ulr_p)
+{
+  return s6a_inflight_begin (S6A_INFLIGHT_ULR, ulr_p->imsi, ulr_p);
+}
+
+//------------------------------------------------------------------------------
+int s6a_inflight_hss_peer_select (void)
+{
+  int                                     hss_peer = -1;
+
+  /*
+   * For the requests not tracked in the table (NR)
+   */
+  pthread_mutex_lock (&s6a_inflight_lock);
+  hss_peer = s6a_hss_peer_select (0);
+  pthread_mutex_unlock (&s6a_inflight_lock);
+  return (0 > hss_peer) ? 0 : hss_peer;
+}
+
+//------------------------------------------------------------------------------
+void s6a_inflight_hss_peer_found (const int hss_peer, struct peer_hdr * const peer)
+{
+  /*
+   * s6a_hss_peer_select() reads and sets it under the lock, in the S6A task and the freeDiameter threads
+   */
+  pthread_mutex_lock (&s6a_inflight_lock);
+  s6a_fd_cnf.hss_peers[hss_peer].peer = peer;
+  pthread_mutex_unlock (&s6a_inflight_lock);
+}
+
+//------------------------------------------------------------------------------
+void s6a_inflight_sent (const s6a_inflight_type_t type, const char * const imsi, struct msg * const query)
+{
+  const hash_key_t                        key = s6a_inflight_key (type, imsi);
+  s6a_inflight_t                         *inflight = NULL;
+
+  pthread_mutex_lock (&s6a_inflight_lock);
+  hashtable_get (s6a_inflight_htbl, key, (void **)&inflight);
+  if (inflight) {
+    inflight->query = query;
+  }
+  pthread_mutex_unlock (&s6a_inflight_lock);
+}
+
+//------------------------------------------------------------------------------
+bool s6a_inflight_end (const s6a_inflight_type_t type, const char * const imsi, struct msg * const query, const uint32_t result_code)
+{
+  const hash_key_t                        key = s6a_inflight_key (type, imsi);
+  s6a_inflight_t                         *inflight = NULL;
+  MessageDef                             *message_p = NULL;
+
+  pthread_mutex_lock (&s6a_inflight_lock);
+  hashtable_get (s6a_inflight_htbl, key, (void **)&inflight);
+
+  if ((inflight) && (inflight->query == query)) {
+    const int                               hss_peer = inflight->hss_peer;
+
+    s6a_inflight_release_hss_peer (inflight);
+
+    if (((ER_DIAMETER_UNABLE_TO_DELIVER == result_code) || (ER_DIAMETER_TOO_BUSY == result_code)) &&
+        (0 <= s6a_hss_peer_select (inflight->tried_hss_peers))) {
+      /*
+       * Another HSS peer is open, the S6A task sends the request again
+       * instead of forwarding the failure
+       */
+      if (S6A_INFLIGHT_AIR == type) {
+        message_p = itti_alloc_new_message (TASK_S6A, S6A_AUTH_INFO_REQ);
+        message_p->ittiMsg.s6a_auth_info_req = inflight->u.air;
+      } else {
+        message_p = itti_alloc_new_message (TASK_S6A, S6A_UPDATE_LOCATION_REQ);
+        message_p->ittiMsg.s6a_update_location_req = inflight->u.ulr;
+      }
+      inflight->failover = true;
+      inflight->query = NULL;
+      OAILOG_WARNING (LOG_S6A, "S6a %s for IMSI %s failed on HSS %s (%u), sending it to another HSS\n", (S6A_INFLIGHT_AIR == type) ? "AIR" : "ULR", imsi,
+          (0 <= hss_peer) ? bdata (s6a_fd_cnf.hss_peers[hss_peer].request_template.destination_host) : "?", result_code);
+    } else {
+      if (inflight->nb_merged) {
+        OAILOG_DEBUG (LOG_S6A, "S6a %s answer for IMSI %s serves %u merged requests\n", (S6A_INFLIGHT_AIR == type) ? "AIR" : "ULR", imsi, inflight->nb_merged);
+      }
+      hashtable_free (s6a_inflight_htbl, key);
+    }
+  }
+  pthread_mutex_unlock (&s6a_inflight_lock);
+
+  if (message_p) {
+    mme_stats_inc (S6A_REQUEST_FAILOVER);
+    itti_send_msg_to_task (TASK_S6A, INSTANCE_DEFAULT, message_p);
+    return false;
+  }
+  return true;
+}
@@ -27,6 +27,9 @@ int s6a_generate_update_location(s6a_update_location_req_t *ulr_p);
 int s6a_generate_authentication_info_req(s6a_auth_info_req_t *uar_p);
 int s6a_generate_notify_req(s6a_notify_req_t *uar_p);
 
+int s6a_inflight_air_begin(const s6a_auth_info_req_t * const air_p);
+int s6a_inflight_ulr_begin(const s6a_update_location_req_t * const ulr_p);
+
 int s6a_ula_cb(struct msg **msg, struct avp *paramavp,
                struct session *sess, void *opaque,
                enum disp_action *act);
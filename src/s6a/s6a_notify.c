@@ -135,67 +135,14 @@ s6a_generate_notify_req (
 {
   struct avp                             *avp;
   struct msg                             *msg;
-  struct session                         *sess;
   union avp_value                         value;
 
   DevAssert (nr_p );
   /*
-   * Create the new notify request
+   * Create the new notify request from the constant AVPs of the HSS:
+   * session id, auth session state, origin and destination
    */
-  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_nr, 0, &msg));
-  /*
-   * Create a new session
-   */
-  CHECK_FCT (fd_sess_new (&sess, fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len, (os0_t) "apps6a", 6));
-  {
-    os0_t                                   sid;
-    size_t                                  sidlen;
-
-    CHECK_FCT (fd_sess_getsid (sess, &sid, &sidlen));
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_session_id, 0, &avp));
-    value.os.data = sid;
-    value.os.len = sidlen;
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_FIRST_CHILD, avp));
-  }
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_auth_session_state, 0, &avp));
-  /*
-   * No State maintained
-   */
-  value.i32 = 1;
-  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-  CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-  /*
-   * Add Origin_Host & Origin_Realm
-   */
-  CHECK_FCT (fd_msg_add_origin (msg, 0));
-  mme_config_read_lock (&mme_config);
-  /*
-   * Destination Host
-   */
-  {
-    bstring                                 host = bstrcpy(mme_config.s6a_config.hss_host_name);
-
-    bconchar(host, '.');
-    bconcat (host, mme_config.realm);
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_host, 0, &avp));
-    value.os.data = (unsigned char *)bdata(host);
-    value.os.len = blength(host);
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-    bdestroy_wrapper(&host);
-  }
-  /*
-   * Destination_Realm
-   */
-  {
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_realm, 0, &avp));
-    value.os.data = (unsigned char *)bdata(mme_config.realm);
-    value.os.len = blength(mme_config.realm);
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-  }
-  mme_config_unlock (&mme_config);
+  CHECK_FCT (s6a_template_new_request (&s6a_fd_cnf.hss_peers[s6a_inflight_hss_peer_select ()].request_template, s6a_fd_cnf.dataobj_s6a_nr, &msg));
   /*
    * Adding the User-Name (IMSI)
    */
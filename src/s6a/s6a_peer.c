@@ -85,22 +85,95 @@ s6a_peer_connected_cb (
 #endif
 }
 
+//------------------------------------------------------------------------------
+int s6a_hss_peers_init (const mme_config_t * const mme_config_p)
+{
+  int                                     i = 0;
+
+  if (0 == mme_config_p->s6a_config.nb_hss_peers) {
+    OAILOG_ERROR (LOG_S6A, "No HSS configured\n");
+    return RETURNerror;
+  }
+
+  for (i = 0; i < mme_config_p->s6a_config.nb_hss_peers; i++) {
+    s6a_hss_peer_t                         *hss_peer = &s6a_fd_cnf.hss_peers[i];
+
+    if (s6a_template_init (&hss_peer->request_template, mme_config_p, mme_config_p->s6a_config.hss_peers[i].host_name)) {
+      return RETURNerror;
+    }
+    hss_peer->weight = mme_config_p->s6a_config.hss_peers[i].weight;
+    hss_peer->peer = NULL;
+    hss_peer->inflight = 0;
+    s6a_fd_cnf.nb_hss_peers++;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s6a_hss_peers_exit (void)
+{
+  int                                     i = 0;
+
+  for (i = 0; i < s6a_fd_cnf.nb_hss_peers; i++) {
+    s6a_template_free (&s6a_fd_cnf.hss_peers[i].request_template);
+  }
+  s6a_fd_cnf.nb_hss_peers = 0;
+}
+
+//------------------------------------------------------------------------------
+// Called with the in-flight table lock held
+static bool s6a_hss_peer_is_open (s6a_hss_peer_t * const hss_peer)
+{
+  if (!hss_peer->peer) {
+    /*
+     * The peer is known by freeDiameter once its connection has been attempted
+     */
+    if (fd_peer_getbyid (bdata (hss_peer->request_template.destination_host), blength (hss_peer->request_template.destination_host), 0, &hss_peer->peer)) {
+      hss_peer->peer = NULL;
+    }
+    if (!hss_peer->peer) {
+      return false;
+    }
+  }
+  return (STATE_OPEN == fd_peer_get_state (hss_peer->peer));
+}
+
+//------------------------------------------------------------------------------
+int s6a_hss_peer_select (const uint32_t excluded_hss_peers)
+{
+  int                                     selected = -1;
+  int                                     i = 0;
+
+  /*
+   * Among the open HSS peers not excluded, the one with the fewest pending requests
+   * relative to its weight: (inflight + 1) / weight is minimal.
+   */
+  for (i = 0; i < s6a_fd_cnf.nb_hss_peers; i++) {
+    s6a_hss_peer_t                         *hss_peer = &s6a_fd_cnf.hss_peers[i];
+
+    if ((excluded_hss_peers & (1U << i)) || (!s6a_hss_peer_is_open (hss_peer))) {
+      continue;
+    }
+    if ((0 > selected) ||
+        (((uint64_t)hss_peer->inflight + 1) * s6a_fd_cnf.hss_peers[selected].weight <
+         ((uint64_t)s6a_fd_cnf.hss_peers[selected].inflight + 1) * hss_peer->weight)) {
+      selected = i;
+    }
+  }
+  return selected;
+}
+
+//------------------------------------------------------------------------------
 int
 s6a_fd_new_peer (
   void)
 {
-  char                                    host_name[100];
-  size_t                                  host_name_len = 0;
   int                                     ret = 0;
+  int                                     i = 0;
 #if FD_CONF_FILE_NO_CONNECT_PEERS_CONFIGURED
   struct peer_info                        info = {0};
 #endif
 
-  if (mme_config_read_lock (&mme_config) ) {
-    OAILOG_ERROR (LOG_S6A, "Failed to lock configuration for reading\n");
-    return RETURNerror;
-  }
-
 //  if (fd_g_config->cnf_diamid ) {
 //    free (fd_g_config->cnf_diamid);
 //    fd_g_config->cnf_diamid_len = 0;
@@ -114,82 +187,86 @@ s6a_fd_new_peer (
 //  fd_g_config->cnf_diamid = strdup (host_name);
 //  fd_g_config->cnf_diamid_len = strlen (fd_g_config->cnf_diamid);
   OAILOG_DEBUG (LOG_S6A, "Diameter identity of MME: %s with length: %zd\n", fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len);
-  bstring                                 hss_name = bstrcpy(mme_config.s6a_config.hss_host_name);
-  bconchar(hss_name, '.');
-  bconcat (hss_name, mme_config.realm);
+#if FD_CONF_FILE_NO_CONNECT_PEERS_CONFIGURED
+  for (i = 0; i < s6a_fd_cnf.nb_hss_peers; i++) {
+    bstring                                 hss_name = s6a_fd_cnf.hss_peers[i].request_template.destination_host;
 
-  if (mme_config_unlock (&mme_config) ) {
-    OAILOG_ERROR (LOG_S6A, "Failed to unlock configuration\n");
-    return RETURNerror;
+    memset (&info, 0, sizeof (info));
+    info.pi_diamid    = bdata(hss_name);
+    info.pi_diamidlen = blength (hss_name);
+    OAILOG_DEBUG (LOG_S6A, "Diameter identity of HSS: %s with length: %zd\n", info.pi_diamid, info.pi_diamidlen);
+    info.config.pic_flags.sec     = PI_SEC_NONE;
+    info.config.pic_flags.pro3    = PI_P3_DEFAULT;
+    info.config.pic_flags.pro4    = PI_P4_TCP;
+    info.config.pic_flags.alg     = PI_ALGPREF_TCP;
+    info.config.pic_flags.exp     = PI_EXP_INACTIVE;
+    info.config.pic_flags.persist = PI_PRST_NONE;
+    info.config.pic_port          = 3868;
+    info.config.pic_lft           = 3600;
+    info.config.pic_tctimer       = 7; // retry time-out connection
+    info.config.pic_twtimer       = 60; // watchdog
+    CHECK_FCT (fd_peer_add (&info, "", s6a_peer_connected_cb, NULL));
   }
-#if FD_CONF_FILE_NO_CONNECT_PEERS_CONFIGURED
-  info.pi_diamid    = bdata(hss_name);
-  info.pi_diamidlen = blength (hss_name);
-  OAILOG_DEBUG (LOG_S6A, "Diameter identity of HSS: %s with length: %zd\n", info.pi_diamid, info.pi_diamidlen);
-  info.config.pic_flags.sec     = PI_SEC_NONE;
-  info.config.pic_flags.pro3    = PI_P3_DEFAULT;
-  info.config.pic_flags.pro4    = PI_P4_TCP;
-  info.config.pic_flags.alg     = PI_ALGPREF_TCP;
-  info.config.pic_flags.exp     = PI_EXP_INACTIVE;
-  info.config.pic_flags.persist = PI_PRST_NONE;
-  info.config.pic_port          = 3868;
-  info.config.pic_lft           = 3600;
-  info.config.pic_tctimer       = 7; // retry time-out connection
-  info.config.pic_twtimer       = 60; // watchdog
-  CHECK_FCT (fd_peer_add (&info, "", s6a_peer_connected_cb, NULL));
 
   return ret;
 #else
-  DiamId_t          diamid    = bdata(hss_name);
-  size_t            diamidlen = blength (hss_name);
-  struct peer_hdr  *peer      = NULL;
   int               nb_tries  = 0;
   int               timeout   = fd_g_config->cnf_timer_tc;
 
+  /*
+   * The S6a interface is usable as soon as one HSS peer is open,
+   * the others are picked up by s6a_hss_peer_select when they get connected.
+   */
   for (nb_tries = 0; nb_tries < NB_MAX_TRIES; nb_tries++) {
     OAILOG_DEBUG (LOG_S6A, "S6a peer connection attempt %d / %d\n",
                   1 + nb_tries, NB_MAX_TRIES);
-    ret = fd_peer_getbyid( diamid, diamidlen, 0, &peer );
+    for (i = 0; i < s6a_fd_cnf.nb_hss_peers; i++) {
+      s6a_hss_peer_t   *hss_peer  = &s6a_fd_cnf.hss_peers[i];
+      DiamId_t          diamid    = bdata(hss_peer->request_template.destination_host);
+      size_t            diamidlen = blength (hss_peer->request_template.destination_host);
+      struct peer_hdr  *peer      = NULL;
 
-    if (peer && peer->info.config.pic_tctimer != 0) {
-        timeout = peer->info.config.pic_tctimer;
-    }
+      ret = fd_peer_getbyid( diamid, diamidlen, 0, &peer );
+
+      if (peer && peer->info.config.pic_tctimer != 0) {
+          timeout = peer->info.config.pic_tctimer;
+      }
+
+      if (!ret) {
+        if (peer) {
+          s6a_inflight_hss_peer_found (i, peer);
+          ret = fd_peer_get_state(peer);
+          if (STATE_OPEN == ret) {
+            MessageDef                             *message_p;
+
+            OAILOG_DEBUG (LOG_S6A, "Peer %*s is now connected...\n", (int)diamidlen, diamid);
+            /*
+             * Inform S1AP that connection to HSS is established
+             */
+            message_p = itti_alloc_new_message (TASK_S6A, ACTIVATE_MESSAGE);
+            itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
 
-    if (!ret) {
-      if (peer) {
-        ret = fd_peer_get_state(peer);
-        if (STATE_OPEN == ret) {
-          MessageDef                             *message_p;
-
-          OAILOG_DEBUG (LOG_S6A, "Peer %*s is now connected...\n", (int)diamidlen, diamid);
-          /*
-           * Inform S1AP that connection to HSS is established
-           */
-          message_p = itti_alloc_new_message (TASK_S6A, ACTIVATE_MESSAGE);
-          itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
-
-          {
-            FILE *fp = NULL;
-            bstring  filename = bformat("/tmp/mme_%d.status", g_pid);
-            fp = fopen(bdata(filename), "w+");
-            bdestroy_wrapper(&filename);
-            fflush(fp);
-            fclose(fp);
+            {
+              FILE *fp = NULL;
+              bstring  filename = bformat("/tmp/mme_%d.status", g_pid);
+              fp = fopen(bdata(filename), "w+");
+              bdestroy_wrapper(&filename);
+              fflush(fp);
+              fclose(fp);
+            }
+            return RETURNok;
+          } else {
+            OAILOG_DEBUG (LOG_S6A, "S6a peer %s state is %d\n", diamid, ret);
           }
-          bdestroy_wrapper(&hss_name);
-          return RETURNok;
-        } else {
-          OAILOG_DEBUG (LOG_S6A, "S6a peer state is %d\n", ret);
+        }  else {
+          OAILOG_DEBUG (LOG_S6A, "Could not get S6a peer informations %s\n", diamid);
         }
-      }  else {
-        OAILOG_DEBUG (LOG_S6A, "Could not get S6a peer informations %s\n", diamid);
+      } else {
+        OAILOG_DEBUG (LOG_S6A, "Could not get S6a peer by id: %s\n", diamid);
       }
-    } else {
-      OAILOG_DEBUG (LOG_S6A, "Could not get S6a peer by id: %s\n", diamid);
     }
     sleep(timeout);
   }
-  bdestroy_wrapper(&hss_name);
   if(fd_g_config->cnf_diamid){
     free_wrapper((void **) &fd_g_config->cnf_diamid);
   }
@@ -0,0 +1,176 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_stub.c
+  \brief In-process HSS for benchmarking, see s6a_stub.h.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+
+#include "mme_config.h"
+#include "assertions.h"
+#include "conversions.h"
+#include "intertask_interface.h"
+#include "itti_free_defined_msg.h"
+#include "common_defs.h"
+#include "s6a_stub.h"
+#include "msc.h"
+#include "log.h"
+
+#define S6A_STUB_UE_AMBR_UL           (50000000)
+#define S6A_STUB_UE_AMBR_DL           (100000000)
+
+static bstring                          s6a_stub_apn = NULL;
+static uint32_t                         s6a_stub_sequence = 0;
+
+static void *s6a_stub_thread (void *args);
+
+//------------------------------------------------------------------------------
+static void s6a_stub_auth_info_ans (const s6a_auth_info_req_t * const air_p)
+{
+  MessageDef                             *message_p = NULL;
+  s6a_auth_info_ans_t                    *aia_p = NULL;
+  imsi64_t                                imsi64 = 0;
+
+  IMSI_STRING_TO_IMSI64 ((char *)air_p->imsi, &imsi64);
+  message_p = itti_alloc_new_message (TASK_S6A, S6A_AUTH_INFO_ANS);
+  aia_p = &message_p->ittiMsg.s6a_auth_info_ans;
+  memcpy (aia_p->imsi, air_p->imsi, air_p->imsi_length);
+  aia_p->imsi_length = air_p->imsi_length;
+  aia_p->result.present = S6A_RESULT_BASE;
+  aia_p->result.choice.base = DIAMETER_SUCCESS;
+  // the UE does not check the SQN of the stub vectors, a re-synchronization gets a new vector
+  aia_p->auth_info.nb_of_vectors = 1;
+  eutran_vector_t * const vector = &aia_p->auth_info.eutran_vector[0];
+  s6a_stub_generate_vector (imsi64, ++s6a_stub_sequence, vector->rand, vector->xres.data, vector->autn, vector->kasme);
+  vector->xres.size = S6A_STUB_RES_LENGTH;
+
+  MSC_LOG_TX_MESSAGE (MSC_S6A_MME, MSC_NAS_MME, NULL, 0, "0 S6A_AUTH_INFO_ANS imsi %s (stub)", aia_p->imsi);
+  itti_send_msg_to_task (TASK_NAS_EMM, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+static void s6a_stub_update_location_ans (const s6a_update_location_req_t * const ulr_p)
+{
+  MessageDef                             *message_p = NULL;
+  s6a_update_location_ans_t              *ula_p = NULL;
+  subscription_data_t                    *subscription_data = NULL;
+  apn_configuration_t                    *apn_config = NULL;
+
+  message_p = itti_alloc_new_message (TASK_S6A, S6A_UPDATE_LOCATION_ANS);
+  ula_p = &message_p->ittiMsg.s6a_update_location_ans;
+  ula_p->ue_id = ulr_p->ue_id;
+  memcpy (ula_p->imsi, ulr_p->imsi, ulr_p->imsi_length);
+  ula_p->imsi_length = ulr_p->imsi_length;
+  ula_p->result.present = S6A_RESULT_BASE;
+  ula_p->result.choice.base = DIAMETER_SUCCESS;
+
+  // the MME_APP takes the ownership of the subscription data
+  subscription_data = calloc (1, sizeof (subscription_data_t));
+  subscription_data->subscriber_status = SS_SERVICE_GRANTED;
+  subscription_data->access_mode = NAM_PACKET_AND_CIRCUIT;
+  // MSISDN: the last digits of the IMSI
+  subscription_data->msisdn_length = (ulr_p->imsi_length > 10) ? 10 : ulr_p->imsi_length;
+  memcpy (subscription_data->msisdn, &ulr_p->imsi[ulr_p->imsi_length - subscription_data->msisdn_length], subscription_data->msisdn_length);
+  subscription_data->subscribed_ambr.br_ul = S6A_STUB_UE_AMBR_UL;
+  subscription_data->subscribed_ambr.br_dl = S6A_STUB_UE_AMBR_DL;
+  subscription_data->apn_config_profile.context_identifier = 1;
+  subscription_data->apn_config_profile.all_apn_conf_ind = ALL_APN_CONFIGURATIONS_INCLUDED;
+  subscription_data->apn_config_profile.nb_apns = 1;
+  apn_config = &subscription_data->apn_config_profile.apn_configuration[0];
+  apn_config->context_identifier = 1;
+  apn_config->nb_ip_address = 0;
+  apn_config->pdn_type = IPv4;
+  apn_config->service_selection_length = snprintf (apn_config->service_selection, SERVICE_SELECTION_MAX_LENGTH, "%s", bdata(s6a_stub_apn));
+  apn_config->subscribed_qos.qci = QCI_9;
+  apn_config->subscribed_qos.allocation_retention_priority.priority_level = 15;
+  apn_config->subscribed_qos.allocation_retention_priority.pre_emp_vulnerability = PRE_EMPTION_VULNERABILITY_ENABLED;
+  apn_config->subscribed_qos.allocation_retention_priority.pre_emp_capability = PRE_EMPTION_CAPABILITY_DISABLED;
+  apn_config->ambr.br_ul = S6A_STUB_UE_AMBR_UL;
+  apn_config->ambr.br_dl = S6A_STUB_UE_AMBR_DL;
+  ula_p->subscription_data = subscription_data;
+
+  MSC_LOG_TX_MESSAGE (MSC_S6A_MME, MSC_MMEAPP_MME, NULL, 0, "0 S6A_UPDATE_LOCATION_ANS imsi %s (stub)", ula_p->imsi);
+  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+static void *s6a_stub_thread (void *args)
+{
+  itti_mark_task_ready (TASK_S6A);
+  MSC_START_USE ();
+
+  while (1) {
+    MessageDef                             *received_message_p = NULL;
+
+    itti_receive_msg (TASK_S6A, &received_message_p);
+    DevAssert (received_message_p );
+
+    switch (ITTI_MSG_ID (received_message_p)) {
+    case S6A_AUTH_INFO_REQ:{
+        s6a_stub_auth_info_ans (&received_message_p->ittiMsg.s6a_auth_info_req);
+      }
+      break;
+    case S6A_UPDATE_LOCATION_REQ:{
+        s6a_stub_update_location_ans (&received_message_p->ittiMsg.s6a_update_location_req);
+      }
+      break;
+    case S6A_NOTIFY_REQ:{
+        // no answer expected by the MME
+      }
+      break;
+    case TERMINATE_MESSAGE:{
+        bdestroy_wrapper (&s6a_stub_apn);
+        itti_exit_task ();
+      }
+      break;
+    default:{
+        OAILOG_DEBUG (LOG_S6A, "Unknown message ID %d: %s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+      }
+      break;
+    }
+    itti_free_msg_content(received_message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+    received_message_p = NULL;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int s6a_stub_init (const struct mme_config_s * const mme_config_p)
+{
+  OAILOG_DEBUG (LOG_S6A, "Initializing S6a HSS stub\n");
+  s6a_stub_apn = bstrcpy (mme_config_p->benchmark_config.stub_apn);
+
+  if (itti_create_task (TASK_S6A, &s6a_stub_thread, NULL) < 0) {
+    OAILOG_ERROR (LOG_S6A, "s6a stub create task\n");
+    return RETURNerror;
+  }
+  OAILOG_WARNING (LOG_S6A, "S6a answered by the HSS stub, APN %s\n", bdata(s6a_stub_apn));
+  return RETURNok;
+}
@@ -0,0 +1,87 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_stub.h
+  \brief In-process HSS answering the S6a requests of the MME without freeDiameter, for benchmarking
+  (BENCHMARK.STUB_HSS="yes"). Every IMSI is subscribed with one default APN.
+  The authentication vectors are not Milenage ones: they are derived from the IMSI with the KDF
+  of TS 33.401, so that a simulated UE (src/test/oai_mme_loadgen) computes the same RES and KASME.
+*/
+
+#ifndef FILE_S6A_STUB_SEEN
+#define FILE_S6A_STUB_SEEN
+
+#include <stdint.h>
+#include <string.h>
+
+#include "secu_defs.h"
+
+#define S6A_STUB_RES_LENGTH           8
+
+// FC values of the stub vectors, out of the range used by TS 33.401 Annex A
+#define S6A_STUB_FC_K                 0x70
+#define S6A_STUB_FC_RES_AUTN          0x71
+#define S6A_STUB_FC_KASME             0x72
+
+/*! \fn void s6a_stub_generate_vector(const uint64_t imsi64, const uint32_t sequence, uint8_t rand[16], uint8_t res[S6A_STUB_RES_LENGTH], uint8_t autn[16], uint8_t kasme[32])
+ * \brief Authentication vector of an IMSI, shared by the HSS stub (XRES) and the simulated UEs (RES).
+ * \param[in] imsi64 IMSI of the subscriber.
+ * \param[in] sequence Makes RAND unique per authentication.
+ */
+static inline void s6a_stub_generate_vector (const uint64_t imsi64, const uint32_t sequence,
+    uint8_t rand[16], uint8_t res[S6A_STUB_RES_LENGTH], uint8_t autn[16], uint8_t kasme[32])
+{
+  static const uint8_t                    secret[16] = {'O','A','I','-','M','M','E','-','B','E','N','C','H','M','A','R'};
+  uint8_t                                 k[32];
+  uint8_t                                 s[17];
+  uint8_t                                 out[32];
+
+  s[0] = S6A_STUB_FC_K;
+  for (int i = 0; i < 8; i++) {
+    s[1 + i] = (uint8_t)(imsi64 >> (56 - 8*i));
+  }
+  kdf (secret, sizeof (secret), s, 9, k, sizeof (k));
+
+  memcpy (rand, &s[1], 8);
+  for (int i = 0; i < 4; i++) {
+    rand[8 + i]  = (uint8_t)(sequence >> (24 - 8*i));
+    rand[12 + i] = (uint8_t)~rand[8 + i];
+  }
+
+  s[0] = S6A_STUB_FC_RES_AUTN;
+  memcpy (&s[1], rand, 16);
+  kdf (k, sizeof (k), s, sizeof (s), out, sizeof (out));
+  memcpy (res, out, S6A_STUB_RES_LENGTH);
+  memcpy (autn, &out[S6A_STUB_RES_LENGTH], 16);
+  autn[6] |= 0x80;                      // AMF separation bit, E-UTRAN vector
+
+  s[0] = S6A_STUB_FC_KASME;
+  kdf (k, sizeof (k), s, sizeof (s), kasme, 32);
+}
+
+struct mme_config_s;
+
+/*! \fn int s6a_stub_init(const struct mme_config_s * const mme_config)
+ * \brief Create TASK_S6A answering the AIR and ULR in-process, in place of s6a_init().
+ */
+int s6a_stub_init(const struct mme_config_s * const mme_config);
+
+#endif /* FILE_S6A_STUB_SEEN */
@@ -250,6 +250,18 @@ int s6a_init (
     OAILOG_DEBUG (LOG_S6A, "s6a_fd_init_dict_objs done\n");
   }
 
+  ret = s6a_hss_peers_init (mme_config_p);
+  if (ret) {
+    OAILOG_ERROR (LOG_S6A, "An error occurred during s6a_hss_peers_init.\n");
+    return ret;
+  }
+
+  ret = s6a_inflight_init ();
+  if (ret) {
+    OAILOG_ERROR (LOG_S6A, "An error occurred during s6a_inflight_init.\n");
+    return ret;
+  }
+
   if (itti_create_task (TASK_S6A, &s6a_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_S6A, "s6a create task\n");
     return RETURNerror;
@@ -270,6 +282,8 @@ static void s6a_exit(void)
     timer_remove(timer_id, NULL);
   }
   // Release all resources
+  s6a_inflight_exit();
+  s6a_hss_peers_exit();
   free_wrapper((void **) &fd_g_config->cnf_diamid);
   fd_g_config->cnf_diamid_len = 0;
   int    rv = RETURNok;
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_template.c
+   \brief Constant AVPs of the S6a requests, prepared once per HSS peer
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "mme_config.h"
+#include "assertions.h"
+#include "conversions.h"
+#include "common_defs.h"
+#include "s6a_defs.h"
+
+//------------------------------------------------------------------------------
+int s6a_template_init (s6a_template_t * const template_p, const mme_config_t * const mme_config_p, const_bstring hss_host_name)
+{
+  plmn_t                                  plmn_mme;
+
+  DevAssert (template_p);
+  memset (template_p, 0, sizeof (*template_p));
+
+  template_p->destination_host = bstrcpy (hss_host_name);
+  bconchar (template_p->destination_host, '.');
+  bconcat (template_p->destination_host, mme_config_p->realm);
+  template_p->destination_realm = bstrcpy (mme_config_p->realm);
+
+  plmn_mme = mme_config_p->gummei.gummei[0].plmn;
+  PLMN_T_TO_TBCD (plmn_mme,
+                  template_p->mme_plmn_id,
+                  mme_config_find_mnc_length (plmn_mme.mcc_digit1, plmn_mme.mcc_digit2, plmn_mme.mcc_digit3, plmn_mme.mnc_digit1, plmn_mme.mnc_digit2, plmn_mme.mnc_digit3)
+    );
+  OAILOG_DEBUG (LOG_S6A, "S6a requests to %s realm %s, MME PLMN %02X%02X%02X\n", bdata (template_p->destination_host), bdata (template_p->destination_realm),
+      template_p->mme_plmn_id[0], template_p->mme_plmn_id[1], template_p->mme_plmn_id[2]);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s6a_template_free (s6a_template_t * const template_p)
+{
+  bdestroy_wrapper (&template_p->destination_host);
+  bdestroy_wrapper (&template_p->destination_realm);
+}
+
+//------------------------------------------------------------------------------
+const uint8_t *s6a_template_visited_plmn_id (s6a_template_t * const template_p, const plmn_t * const visited_plmn)
+{
+  /*
+   * The UEs are mostly served in the same PLMN, the TBCD of the last one is kept
+   */
+  if ((!template_p->visited_plmn_valid) || (memcmp (&template_p->visited_plmn, visited_plmn, sizeof (plmn_t)))) {
+    PLMN_T_TO_TBCD ((*visited_plmn),
+                    template_p->visited_plmn_id,
+                    mme_config_find_mnc_length (visited_plmn->mcc_digit1, visited_plmn->mcc_digit2, visited_plmn->mcc_digit3,
+                        visited_plmn->mnc_digit1, visited_plmn->mnc_digit2, visited_plmn->mnc_digit3)
+      );
+    template_p->visited_plmn = *visited_plmn;
+    template_p->visited_plmn_valid = true;
+  }
+
+  return template_p->visited_plmn_id;
+}
+
+//------------------------------------------------------------------------------
+int s6a_template_new_request (const s6a_template_t * const template_p, struct dict_object * const command, struct msg ** const msg)
+{
+  struct avp                             *avp = NULL;
+  struct session                         *sess = NULL;
+  union avp_value                         value;
+
+  DevAssert (template_p);
+  DevAssert (template_p->destination_host);
+  /*
+   * Create the new request message
+   */
+  CHECK_FCT (fd_msg_new (command, 0, msg));
+  /*
+   * Create a new session
+   */
+  CHECK_FCT (fd_sess_new (&sess, fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len, (os0_t) "apps6a", 6));
+  {
+    os0_t                                   sid;
+    size_t                                  sidlen;
+
+    CHECK_FCT (fd_sess_getsid (sess, &sid, &sidlen));
+    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_session_id, 0, &avp));
+    value.os.data = sid;
+    value.os.len = sidlen;
+    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+    CHECK_FCT (fd_msg_avp_add (*msg, MSG_BRW_FIRST_CHILD, avp));
+  }
+  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_auth_session_state, 0, &avp));
+  /*
+   * No State maintained
+   */
+  value.i32 = 1;
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  CHECK_FCT (fd_msg_avp_add (*msg, MSG_BRW_LAST_CHILD, avp));
+  /*
+   * Add Origin_Host & Origin_Realm
+   */
+  CHECK_FCT (fd_msg_add_origin (*msg, 0));
+  /*
+   * Destination Host
+   */
+  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_host, 0, &avp));
+  value.os.data = (unsigned char *)bdata (template_p->destination_host);
+  value.os.len = blength (template_p->destination_host);
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  CHECK_FCT (fd_msg_avp_add (*msg, MSG_BRW_LAST_CHILD, avp));
+  /*
+   * Destination_Realm
+   */
+  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_realm, 0, &avp));
+  value.os.data = (unsigned char *)bdata (template_p->destination_realm);
+  value.os.len = blength (template_p->destination_realm);
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  CHECK_FCT (fd_msg_avp_add (*msg, MSG_BRW_LAST_CHILD, avp));
+  return RETURNok;
+}
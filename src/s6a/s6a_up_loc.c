@@ -165,6 +165,14 @@ s6a_ula_cb (
 
 err:
   ans_p = NULL;
+  if (!s6a_inflight_end (S6A_INFLIGHT_ULR, s6a_update_location_ans_p->imsi, qry_p,
+      (S6A_RESULT_BASE == s6a_update_location_ans_p->result.present) ? s6a_update_location_ans_p->result.choice.base : 0)) {
+    /*
+     * Sent again to another HSS peer, its answer is forwarded instead
+     */
+    itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+    return RETURNok;
+  }
   itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
   OAILOG_DEBUG (LOG_S6A, "Sending S6A_UPDATE_LOCATION_ANS to task MME_APP\n");
   return RETURNok;
@@ -176,106 +184,56 @@ s6a_generate_update_location (
 {
   struct avp                             *avp_p = NULL;
   struct msg                             *msg_p = NULL;
-  struct session                         *sess_p = NULL;
+  struct msg                             *qry_p = NULL;
   union avp_value                         value;
+  s6a_template_t                         *template_p = NULL;
+  int                                     hss_peer = 0;
+  int                                     ret = 0;
 
   DevAssert (ulr_pP );
   /*
-   * Create the new update location request message
+   * An identical ULR pending for the IMSI is not sent again
    */
-  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_ulr, 0, &msg_p));
-  /*
-   * Create a new session
-   */
-  CHECK_FCT (fd_sess_new (&sess_p, fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len, (os0_t) "apps6a", 6));
-  {
-    os0_t                                   sid;
-    size_t                                  sidlen;
-
-    CHECK_FCT (fd_sess_getsid (sess_p, &sid, &sidlen));
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_session_id, 0, &avp_p));
-    value.os.data = sid;
-    value.os.len = sidlen;
-    CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-    CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_FIRST_CHILD, avp_p));
+  hss_peer = s6a_inflight_ulr_begin (ulr_pP);
+  if (0 > hss_peer) {
+    return RETURNok;
   }
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_auth_session_state, 0, &avp_p));
+  template_p = &s6a_fd_cnf.hss_peers[hss_peer].request_template;
   /*
-   * No State maintained
+   * Create the new update location request from the constant AVPs of the HSS:
+   * session id, auth session state, origin and destination
    */
-  value.i32 = 1;
-  CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-  CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-  /*
-   * Add Origin_Host & Origin_Realm
-   */
-  CHECK_FCT (fd_msg_add_origin (msg_p, 0));
-  mme_config_read_lock (&mme_config);
-  /*
-   * Destination Host
-   */
-  {
-    bstring                                 host = bstrcpy(mme_config.s6a_config.hss_host_name);
-
-    bconchar(host, '.');
-    bconcat (host, mme_config.realm);
-
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_host, 0, &avp_p));
-    value.os.data = (unsigned char *)bdata(host);
-    value.os.len = blength(host);
-    CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-    CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-    bdestroy_wrapper(&host);
-  }
-  /*
-   * Destination_Realm
-   */
-  {
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_realm, 0, &avp_p));
-    value.os.data = (unsigned char *)bdata(mme_config.realm);
-    value.os.len = blength(mme_config.realm);
-    CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-    CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-  }
-  mme_config_unlock (&mme_config);
+  CHECK_FCT_DO (ret = s6a_template_new_request (template_p, s6a_fd_cnf.dataobj_s6a_ulr, &msg_p), goto err);
   /*
    * Adding the User-Name (IMSI)
    */
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_user_name, 0, &avp_p));
+  CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_user_name, 0, &avp_p), goto err);
   value.os.data = (unsigned char *)ulr_pP->imsi;
   value.os.len = strlen (ulr_pP->imsi);
-  CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-  CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
+  CHECK_FCT_DO (ret = fd_msg_avp_setvalue (avp_p, &value), goto err);
+  CHECK_FCT_DO (ret = fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p), goto err);
   /*
    * Adding the visited plmn id
    */
   {
-    uint8_t                                 plmn[3];
-    plmn_t                                  plmn_mme;
-
-    plmn_mme = mme_config.gummei.gummei[0].plmn;
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_visited_plmn_id, 0, &avp_p));
-    PLMN_T_TO_TBCD (plmn_mme,
-                    plmn,
-                    mme_config_find_mnc_length (plmn_mme.mcc_digit1, plmn_mme.mcc_digit2, plmn_mme.mcc_digit3, plmn_mme.mnc_digit1, plmn_mme.mnc_digit2, plmn_mme.mnc_digit3)
-      );
-    value.os.data = plmn;
+    CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_visited_plmn_id, 0, &avp_p), goto err);
+    value.os.data = template_p->mme_plmn_id;
     value.os.len = 3;
-    CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-    CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
+    CHECK_FCT_DO (ret = fd_msg_avp_setvalue (avp_p, &value), goto err);
+    CHECK_FCT_DO (ret = fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p), goto err);
   }
   /*
    * Adding the RAT-Type
    */
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_rat_type, 0, &avp_p));
+  CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_rat_type, 0, &avp_p), goto err);
   DevCheck (ulr_pP->rat_type == RAT_EUTRAN, ulr_pP->rat_type, 0, 0);
   value.u32 = ulr_pP->rat_type;
-  CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-  CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
+  CHECK_FCT_DO (ret = fd_msg_avp_setvalue (avp_p, &value), goto err);
+  CHECK_FCT_DO (ret = fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p), goto err);
   /*
    * Adding ULR-Flags
    */
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_ulr_flags, 0, &avp_p));
+  CHECK_FCT_DO (ret = fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_ulr_flags, 0, &avp_p), goto err);
   value.u32 = 0;
   /*
    * Identify the ULR as coming from S6A interface (i.e. from MME)
@@ -293,13 +251,30 @@ s6a_generate_update_location (
     FLAGS_SET (value.u32, ULR_INITIAL_ATTACH_IND);
   }
 
-  CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-  CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-
-  struct avp                             *avp1_p = NULL;
-  CHECK_FCT (fd_msg_search_avp (msg_p, s6a_fd_cnf.dataobj_s6a_ulr_flags, &avp1_p));
+  CHECK_FCT_DO (ret = fd_msg_avp_setvalue (avp_p, &value), goto err);
+  CHECK_FCT_DO (ret = fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p), goto err);
 
-  CHECK_FCT (fd_msg_send (&msg_p, NULL, NULL));
+  /*
+   * The answer is matched to the in-flight request by its query
+   */
+  qry_p = msg_p;
+  s6a_inflight_sent (S6A_INFLIGHT_ULR, ulr_pP->imsi, qry_p);
+  ret = fd_msg_send (&msg_p, NULL, NULL);
+  if (ret) {
+    OAILOG_ERROR (LOG_S6A, "Failed to send s6a ulr for imsi=%s: %d\n", ulr_pP->imsi, ret);
+    s6a_inflight_end (S6A_INFLIGHT_ULR, ulr_pP->imsi, qry_p, 0);
+    return ret;
+  }
   OAILOG_DEBUG (LOG_S6A, "Sending s6a ulr for imsi=%s\n", ulr_pP->imsi);
   return RETURNok;
+err:
+  /*
+   * Not sent, the in-flight entry is released so that a retry of the UE is sent again
+   */
+  OAILOG_ERROR (LOG_S6A, "S6a ULR for IMSI %s could not be built: %d\n", ulr_pP->imsi, ret);
+  if (msg_p) {
+    fd_msg_free (msg_p);
+  }
+  s6a_inflight_end (S6A_INFLIGHT_ULR, ulr_pP->imsi, NULL, 0);
+  return ret;
 }
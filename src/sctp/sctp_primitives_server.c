@@ -513,7 +513,9 @@ static inline int sctp_read_from_socket (int sd, int ppid)
 
     OAILOG_DEBUG (LOG_SCTP, "[%d][%d] Msg of length %d received from port %u, on stream %d, PPID %d\n", sinfo.sinfo_assoc_id, sd, n, ntohs (addr.sin6_port), sinfo.sinfo_stream, ntohl (sinfo.sinfo_ppid));
     bstring payload = blk2bstr(buffer, n);
-    sctp_itti_send_new_message_ind (&payload, sinfo.sinfo_assoc_id, sinfo.sinfo_stream, association->instreams, association->outstreams);
+    if (sctp_itti_send_new_message_ind (&payload, sinfo.sinfo_assoc_id, sinfo.sinfo_stream, association->instreams, association->outstreams) < 0) {
+      OAILOG_WARNING (LOG_SCTP, "[%d][%d] Msg of length %d dropped, S1AP is overloaded\n", sinfo.sinfo_assoc_id, sd, n);
+    }
   }
 
   OAILOG_DEBUG (LOG_SCTP, "SCTP RETURNING!!\n");
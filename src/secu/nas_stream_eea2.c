@@ -81,3 +81,51 @@ nas_stream_encrypt_eea2 (
   free_wrapper ((void**)&ctx);
   return 0;
 }
+
+//------------------------------------------------------------------------------
+int
+nas_stream_encrypt_eea2_scheduled (
+  const nas_stream_key_schedule_t * const key_schedule,
+  nas_stream_cipher_t * const stream_cipher,
+  uint8_t * const out)
+{
+  uint8_t                                 m[16] = {0};
+  uint8_t                                 key_stream[16];
+  uint32_t                                local_count;
+  uint32_t                                zero_bit = 0;
+  uint32_t                                byte_length;
+  uint32_t                                i;
+  int                                     j;
+
+  DevAssert (key_schedule != NULL);
+  DevAssert (key_schedule->valid);
+  DevAssert (stream_cipher != NULL);
+  DevAssert (out != NULL);
+  zero_bit = stream_cipher->blength & 0x7;
+  byte_length = stream_cipher->blength >> 3;
+
+  if (zero_bit > 0)
+    byte_length += 1;
+
+  local_count = hton_int32 (stream_cipher->count);
+  memcpy (&m[0], &local_count, 4);
+  m[4] = ((stream_cipher->bearer & 0x1F) << 3) | ((stream_cipher->direction & 0x01) << 2);
+
+  /*
+   * AES-CTR, out may alias the message
+   */
+  for (i = 0; i < byte_length; i++) {
+    if (!(i & 0xF)) {
+      NAS_STREAM_AES_ENCRYPT (&key_schedule->aes, sizeof (key_stream), key_stream, m);
+
+      for (j = 15; (j >= 0) && !(++m[j]); j--);
+    }
+
+    out[i] = stream_cipher->message[i] ^ key_stream[i & 0xF];
+  }
+
+  if (zero_bit > 0)
+    out[byte_length - 1] = out[byte_length - 1] & (uint8_t) (0xFF << (8 - zero_bit));
+
+  return 0;
+}
@@ -93,3 +93,67 @@ nas_stream_encrypt_eia2 (
   free_wrapper ((void**)&m);
   return 0;
 }
+
+//------------------------------------------------------------------------------
+int
+nas_stream_encrypt_eia2_scheduled (
+  const nas_stream_key_schedule_t * const key_schedule,
+  nas_stream_cipher_t * const stream_cipher,
+  uint8_t out[4])
+{
+  uint8_t                                 m[8] = {0};
+  uint8_t                                 x[16] = {0};
+  uint32_t                                local_count = 0;
+  uint32_t                                m_length;
+  uint32_t                                total_length;
+  uint32_t                                nb_blocks;
+  uint32_t                                block;
+  uint32_t                                position;
+  int                                     i;
+
+  DevAssert (key_schedule != NULL);
+  DevAssert (key_schedule->valid);
+  DevAssert (stream_cipher != NULL);
+  DevAssert (out != NULL);
+  m_length = stream_cipher->blength >> 3;
+
+  if (stream_cipher->blength & 0x7)
+    m_length += 1;
+
+  local_count = hton_int32 (stream_cipher->count);
+  memcpy (&m[0], &local_count, 4);
+  m[4] = ((stream_cipher->bearer & 0x1F) << 3) | ((stream_cipher->direction & 0x01) << 2);
+
+  /*
+   * AES-CMAC (RFC 4493) of count, bearer, direction || message, read in place
+   */
+  total_length = m_length + sizeof (m);
+  nb_blocks = (total_length + 15) >> 4;
+
+  for (block = 0; block < nb_blocks; block++) {
+    for (i = 0; i < 16; i++) {
+      position = (block << 4) + i;
+
+      if (position < sizeof (m)) {
+        x[i] ^= m[position];
+      } else if (position < total_length) {
+        x[i] ^= stream_cipher->message[position - sizeof (m)];
+      } else if (position == total_length) {
+        x[i] ^= 0x80;
+      }
+    }
+
+    if (block == nb_blocks - 1) {
+      const uint8_t                          *subkey = (total_length & 0xF) ? key_schedule->cmac_k2 : key_schedule->cmac_k1;
+
+      for (i = 0; i < 16; i++) {
+        x[i] ^= subkey[i];
+      }
+    }
+
+    NAS_STREAM_AES_ENCRYPT (&key_schedule->aes, sizeof (x), x, x);
+  }
+
+  memcpy ((void*)out, x, 4);
+  return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <nettle/aes.h>
+
+#include "assertions.h"
+#include "secu_defs.h"
+
+//------------------------------------------------------------------------------
+// RFC 4493 section 2.3, subkey = input << 1, xor Rb if the msb of input is set
+static void
+nas_stream_cmac_subkey (
+  uint8_t * const subkey,
+  const uint8_t * const input)
+{
+  int                                     i;
+
+  for (i = 0; i < 15; i++) {
+    subkey[i] = (uint8_t) (input[i] << 1) | (input[i + 1] >> 7);
+  }
+
+  subkey[15] = (uint8_t) (input[15] << 1);
+
+  if (input[0] & 0x80) {
+    subkey[15] ^= 0x87;
+  }
+}
+
+//------------------------------------------------------------------------------
+void
+nas_stream_key_schedule_init (
+  nas_stream_key_schedule_t * const key_schedule,
+  const uint8_t key[16])
+{
+  uint8_t                                 l[16] = {0};
+
+  DevAssert (key_schedule != NULL);
+  DevAssert (key != NULL);
+  memcpy (key_schedule->key, key, sizeof (key_schedule->key));
+  NAS_STREAM_AES_SET_ENCRYPT_KEY (&key_schedule->aes, key_schedule->key);
+  NAS_STREAM_AES_ENCRYPT (&key_schedule->aes, sizeof (l), l, l);
+  nas_stream_cmac_subkey (key_schedule->cmac_k1, l);
+  nas_stream_cmac_subkey (key_schedule->cmac_k2, key_schedule->cmac_k1);
+  key_schedule->valid = true;
+}
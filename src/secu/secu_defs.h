@@ -22,6 +22,9 @@
 #ifndef FILE_SECU_DEFS_SEEN
 #define FILE_SECU_DEFS_SEEN
 
+#include <stdbool.h>
+#include <nettle/aes.h>
+
 #include "security_types.h"
 
 
@@ -74,6 +77,30 @@ typedef struct {
   uint32_t  blength;
 } nas_stream_cipher_t;
 
+/*
+ * AES key schedule of a NAS key, with the CMAC subkeys for EIA2, set up once per key
+ * instead of for each message (the key is kept to detect a key change)
+ */
+#if NETTLE_VERSION_MAJOR < 3
+typedef struct aes_ctx     nas_stream_aes_ctx_t;
+#  define NAS_STREAM_AES_SET_ENCRYPT_KEY(cTX, kEY)      aes_set_encrypt_key(cTX, 16, kEY)
+#  define NAS_STREAM_AES_ENCRYPT(cTX, lEN, dST, sRC)    aes_encrypt(cTX, lEN, dST, sRC)
+#else
+typedef struct aes128_ctx  nas_stream_aes_ctx_t;
+#  define NAS_STREAM_AES_SET_ENCRYPT_KEY(cTX, kEY)      aes128_set_encrypt_key(cTX, kEY)
+#  define NAS_STREAM_AES_ENCRYPT(cTX, lEN, dST, sRC)    aes128_encrypt(cTX, lEN, dST, sRC)
+#endif
+
+typedef struct nas_stream_key_schedule_s {
+  bool                  valid;
+  uint8_t               key[16];
+  nas_stream_aes_ctx_t  aes;
+  uint8_t               cmac_k1[16];
+  uint8_t               cmac_k2[16];
+} nas_stream_key_schedule_t;
+
+void nas_stream_key_schedule_init(nas_stream_key_schedule_t * const key_schedule, const uint8_t key[16]);
+
 int nas_stream_encrypt_eea1(nas_stream_cipher_t * const stream_cipher, uint8_t * const out);
 
 int nas_stream_encrypt_eia1(nas_stream_cipher_t * const stream_cipher, uint8_t const out[4]);
@@ -82,6 +109,11 @@ int nas_stream_encrypt_eea2(nas_stream_cipher_t * const stream_cipher, uint8_t *
 
 int nas_stream_encrypt_eia2(nas_stream_cipher_t * const stream_cipher, uint8_t const out[4]);
 
+/* out may be the message itself, stream_cipher->key is not used */
+int nas_stream_encrypt_eea2_scheduled(const nas_stream_key_schedule_t * const key_schedule, nas_stream_cipher_t * const stream_cipher, uint8_t * const out);
+
+int nas_stream_encrypt_eia2_scheduled(const nas_stream_key_schedule_t * const key_schedule, nas_stream_cipher_t * const stream_cipher, uint8_t out[4]);
+
 #undef SECU_DEBUG
 
 #endif /* FILE_SECU_DEFS_SEEN */
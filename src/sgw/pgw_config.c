@@ -80,7 +80,8 @@ int pgw_config_process (pgw_config_t * config_pP)
   conf_ipv4_list_elm_t                   *ip4_ref = NULL;
 
 #if ENABLE_LIBGTPNL
-  async_system_command (TASK_ASYNC_SYSTEM, PGW_ABORT_ON_ERROR, "iptables -t mangle -F OUTPUT");
+  // after the sysctl sequence, the rules are flushed before any other command runs
+  async_system_command_ordered (TASK_ASYNC_SYSTEM, PGW_ABORT_ON_ERROR, "iptables -t mangle -F OUTPUT");
   async_system_command (TASK_ASYNC_SYSTEM, PGW_ABORT_ON_ERROR, "iptables -t mangle -F POSTROUTING");
 
   if (config_pP->masquerade_SGI) {
@@ -122,7 +123,7 @@ int pgw_config_process (pgw_config_t * config_pP)
       STAILQ_INSERT_TAIL (&config_pP->ipv4_pool_list, ip4_ref, ipv4_entries);
 
       if (config_pP->arp_ue_linux) {
-#if ENABLE_LIBGTPNL
+#if ENABLE_LIBGTPNL || ENABLE_USERSPACE_GTPU
          async_system_command (TASK_ASYNC_SYSTEM, PGW_ABORT_ON_ERROR, "arp -nDs %s %s pub", inet_ntoa(ip4_ref->addr), bdata(config_pP->ipv4.if_name_SGI));
 #else
          async_system_command (TASK_ASYNC_SYSTEM, PGW_ABORT_ON_ERROR, "arp -nDs %s %s pub", inet_ntoa(ip4_ref->addr), bdata(config_pP->ovs_config.bridge_name));
@@ -284,6 +285,49 @@ int pgw_config_parse_file (pgw_config_t * config_pP)
         }
       }
     } // optional section
+#endif
+#if ENABLE_USERSPACE_GTPU
+    config_setting_t* gtpu_us_settings = config_setting_get_member (setting_pgw, PGW_CONFIG_STRING_GTPU_USERSPACE_CONFIG);
+    config_pP->gtpu_userspace_config.num_workers = 1;
+    config_pP->gtpu_userspace_config.batch_size = 32;
+    config_pP->gtpu_userspace_config.max_tunnels = 65536;
+    config_pP->gtpu_userspace_config.dl_buffer_packets = 16;
+    config_pP->gtpu_userspace_config.dl_buffer_ttl_ms = 5000;
+    config_pP->gtpu_userspace_config.dl_buffer_pool_packets = 16384;
+    if (gtpu_us_settings) {
+      char* tun_name = NULL;
+      libconfig_int gtpu_us_int = 0;
+      if (config_setting_lookup_string (gtpu_us_settings, PGW_CONFIG_STRING_GTPU_USERSPACE_TUN_DEVICE_NAME, (const char **)&tun_name)) {
+        config_pP->gtpu_userspace_config.tun_name = bfromcstr (tun_name);
+      }
+      if (config_setting_lookup_int (gtpu_us_settings, PGW_CONFIG_STRING_GTPU_USERSPACE_NUM_WORKERS, &gtpu_us_int)) {
+        AssertFatal((gtpu_us_int > 0) && (gtpu_us_int <= 64), "Bad " PGW_CONFIG_STRING_GTPU_USERSPACE_NUM_WORKERS " value %d\n", (int)gtpu_us_int);
+        config_pP->gtpu_userspace_config.num_workers = gtpu_us_int;
+      }
+      if (config_setting_lookup_int (gtpu_us_settings, PGW_CONFIG_STRING_GTPU_USERSPACE_BATCH_SIZE, &gtpu_us_int)) {
+        AssertFatal((gtpu_us_int > 0) && (gtpu_us_int <= 256), "Bad " PGW_CONFIG_STRING_GTPU_USERSPACE_BATCH_SIZE " value %d\n", (int)gtpu_us_int);
+        config_pP->gtpu_userspace_config.batch_size = gtpu_us_int;
+      }
+      if (config_setting_lookup_int (gtpu_us_settings, PGW_CONFIG_STRING_GTPU_USERSPACE_MAX_TUNNELS, &gtpu_us_int)) {
+        AssertFatal(gtpu_us_int > 0, "Bad " PGW_CONFIG_STRING_GTPU_USERSPACE_MAX_TUNNELS " value %d\n", (int)gtpu_us_int);
+        config_pP->gtpu_userspace_config.max_tunnels = gtpu_us_int;
+      }
+      if (config_setting_lookup_int (gtpu_us_settings, PGW_CONFIG_STRING_GTPU_USERSPACE_DL_BUFFER_PACKETS, &gtpu_us_int)) {
+        AssertFatal((gtpu_us_int >= 0) && (gtpu_us_int <= 1024), "Bad " PGW_CONFIG_STRING_GTPU_USERSPACE_DL_BUFFER_PACKETS " value %d\n", (int)gtpu_us_int);
+        config_pP->gtpu_userspace_config.dl_buffer_packets = gtpu_us_int;
+      }
+      if (config_setting_lookup_int (gtpu_us_settings, PGW_CONFIG_STRING_GTPU_USERSPACE_DL_BUFFER_TTL_MS, &gtpu_us_int)) {
+        AssertFatal(gtpu_us_int > 0, "Bad " PGW_CONFIG_STRING_GTPU_USERSPACE_DL_BUFFER_TTL_MS " value %d\n", (int)gtpu_us_int);
+        config_pP->gtpu_userspace_config.dl_buffer_ttl_ms = gtpu_us_int;
+      }
+      if (config_setting_lookup_int (gtpu_us_settings, PGW_CONFIG_STRING_GTPU_USERSPACE_DL_BUFFER_POOL_PACKETS, &gtpu_us_int)) {
+        AssertFatal(gtpu_us_int >= 0, "Bad " PGW_CONFIG_STRING_GTPU_USERSPACE_DL_BUFFER_POOL_PACKETS " value %d\n", (int)gtpu_us_int);
+        config_pP->gtpu_userspace_config.dl_buffer_pool_packets = gtpu_us_int;
+      }
+    } // optional section
+    if (!config_pP->gtpu_userspace_config.tun_name) {
+      config_pP->gtpu_userspace_config.tun_name = bfromcstr ("gtpu0");
+    }
 #endif
     subsetting = config_setting_get_member (setting_pgw, PGW_CONFIG_STRING_NETWORK_INTERFACES_CONFIG);
 
@@ -424,15 +468,24 @@ int pgw_config_parse_file (pgw_config_t * config_pP)
     OAI_FPRINTF_INFO ("UE MTU : %u\n", config_pP->ue_mtu);
     if (config_setting_lookup_string (setting_pgw, PGW_CONFIG_STRING_GTPV1U_REALIZATION, (const char **)&astring)) {
       if (strcasecmp (astring, PGW_CONFIG_STRING_NO_GTP_KERNEL_AVAILABLE) == 0) {
+        config_pP->gtpv1u_realization = GTPV1U_REALIZATION_NONE;
         config_pP->use_gtp_kernel_module = false;
         config_pP->enable_loading_gtp_kernel_module = false;
         OAI_FPRINTF_INFO ("Protocol configuration options: push MTU, push DNS, IP address allocation via NAS signalling\n");
       } else if (strcasecmp (astring, PGW_CONFIG_STRING_GTP_KERNEL_MODULE) == 0) {
+        config_pP->gtpv1u_realization = GTPV1U_REALIZATION_KERNEL_MODULE;
         config_pP->use_gtp_kernel_module = true;
         config_pP->enable_loading_gtp_kernel_module = true;
       } else if (strcasecmp (astring, PGW_CONFIG_STRING_GTP_KERNEL) == 0) {
+        config_pP->gtpv1u_realization = GTPV1U_REALIZATION_KERNEL;
         config_pP->use_gtp_kernel_module = true;
         config_pP->enable_loading_gtp_kernel_module = false;
+#if ENABLE_USERSPACE_GTPU
+      } else if (strcasecmp (astring, PGW_CONFIG_STRING_GTP_USERSPACE) == 0) {
+        config_pP->gtpv1u_realization = GTPV1U_REALIZATION_USERSPACE;
+        config_pP->use_gtp_kernel_module = false;
+        config_pP->enable_loading_gtp_kernel_module = false;
+#endif
       }
     }
 
@@ -534,6 +587,18 @@ void pgw_config_display (pgw_config_t * config_p)
 #if ENABLE_LIBGTPNL
   OAILOG_INFO (LOG_SPGW_APP, "    User TCP MSS clamping : %s\n", config_p->ue_tcp_mss_clamp == 0 ? "false" : "true");
   OAILOG_INFO (LOG_SPGW_APP, "    User IP masquerading  : %s\n", config_p->masquerade_SGI == 0 ? "false" : "true");
+#endif
+#if ENABLE_USERSPACE_GTPU
+  if (GTPV1U_REALIZATION_USERSPACE == config_p->gtpv1u_realization) {
+    OAILOG_INFO (LOG_SPGW_APP, "- GTPv1U .................: Enabled (userspace engine)\n");
+    OAILOG_INFO (LOG_SPGW_APP, "    TUN device ...........: %s\n", bdata(config_p->gtpu_userspace_config.tun_name));
+    OAILOG_INFO (LOG_SPGW_APP, "    Workers ..............: %d\n", config_p->gtpu_userspace_config.num_workers);
+    OAILOG_INFO (LOG_SPGW_APP, "    Batch size ...........: %d\n", config_p->gtpu_userspace_config.batch_size);
+    OAILOG_INFO (LOG_SPGW_APP, "    Max tunnels ..........: %u\n", config_p->gtpu_userspace_config.max_tunnels);
+    OAILOG_INFO (LOG_SPGW_APP, "    DL buffer ............: %u packets per bearer, TTL %u ms, %u packets pool\n",
+        config_p->gtpu_userspace_config.dl_buffer_packets, config_p->gtpu_userspace_config.dl_buffer_ttl_ms,
+        config_p->gtpu_userspace_config.dl_buffer_pool_packets);
+  } else
 #endif
   if (config_p->use_gtp_kernel_module) {
     OAILOG_INFO (LOG_SPGW_APP, "- GTPv1U .................: Enabled (Linux kernel module)\n");
@@ -63,6 +63,7 @@ extern "C" {
 #define PGW_CONFIG_STRING_NO_GTP_KERNEL_AVAILABLE               "NO_GTP_KERNEL_AVAILABLE"
 #define PGW_CONFIG_STRING_GTP_KERNEL_MODULE                     "GTP_KERNEL_MODULE"
 #define PGW_CONFIG_STRING_GTP_KERNEL                            "GTP_KERNEL"
+#define PGW_CONFIG_STRING_GTP_USERSPACE                         "GTP_USERSPACE"
 
 #define PGW_CONFIG_STRING_INTERFACE_DISABLED                    "none"
 
@@ -84,6 +85,14 @@ extern "C" {
 #define PGW_CONFIG_STRING_OVS_L2_EGRESS_PORT                    "L2_EGRESS_PORT"
 #define PGW_CONFIG_STRING_OVS_UPLINK_MAC                        "UPLINK_MAC"
 #define PGW_CONFIG_STRING_OVS_SGI_ARP_CACHE                     "SGI_ARP_CACHE"
+#define PGW_CONFIG_STRING_GTPU_USERSPACE_CONFIG                 "GTPU_USERSPACE"
+#define PGW_CONFIG_STRING_GTPU_USERSPACE_TUN_DEVICE_NAME        "TUN_DEVICE_NAME"
+#define PGW_CONFIG_STRING_GTPU_USERSPACE_NUM_WORKERS            "NUM_WORKERS"
+#define PGW_CONFIG_STRING_GTPU_USERSPACE_BATCH_SIZE             "BATCH_SIZE"
+#define PGW_CONFIG_STRING_GTPU_USERSPACE_MAX_TUNNELS            "MAX_TUNNELS"
+#define PGW_CONFIG_STRING_GTPU_USERSPACE_DL_BUFFER_PACKETS      "DL_BUFFER_PACKETS"
+#define PGW_CONFIG_STRING_GTPU_USERSPACE_DL_BUFFER_TTL_MS       "DL_BUFFER_TTL_MS"
+#define PGW_CONFIG_STRING_GTPU_USERSPACE_DL_BUFFER_POOL_PACKETS "DL_BUFFER_POOL_PACKETS"
 #define PGW_CONFIG_STRING_IP                                    "IP"
 #define PGW_CONFIG_STRING_MAC                                   "MAC"
 
@@ -112,6 +121,23 @@ typedef struct spgw_ovs_config_s {
   sgi_arp_boot_cache_t sgi_arp_boot_cache;
 } spgw_ovs_config_t;
 
+typedef enum gtpv1u_realization_e {
+  GTPV1U_REALIZATION_NONE = 0,         // NO_GTP_KERNEL_AVAILABLE
+  GTPV1U_REALIZATION_KERNEL_MODULE,    // GTP_KERNEL_MODULE, the module is loaded/unloaded
+  GTPV1U_REALIZATION_KERNEL,           // GTP_KERNEL
+  GTPV1U_REALIZATION_USERSPACE,        // GTP_USERSPACE, userspace forwarding engine
+} gtpv1u_realization_t;
+
+typedef struct spgw_gtpu_userspace_config_s {
+  bstring  tun_name;      // TUN device carrying UE traffic on the SGi side
+  int      num_workers;   // forwarding threads, one S1-U socket and one TUN queue each
+  int      batch_size;    // packets handled per recvmmsg/sendmmsg call
+  uint32_t max_tunnels;
+  uint32_t dl_buffer_packets; // downlink packets buffered per bearer while the UE is in ECM-IDLE, 0 disables buffering
+  uint32_t dl_buffer_ttl_ms;  // buffered packets older than this are discarded
+  uint32_t dl_buffer_pool_packets; // downlink packets buffered for all the bearers, allocated at init
+} spgw_gtpu_userspace_config_t;
+
 #include "pgw_pcef_emulation.h"
 
 typedef struct pgw_config_s {
@@ -159,6 +185,7 @@ typedef struct pgw_config_s {
 
   bool      force_push_pco;
   uint16_t  ue_mtu;
+  gtpv1u_realization_t gtpv1u_realization;  // tunnels are installed by the gtp_tunnel_ops backend if not GTPV1U_REALIZATION_NONE
   bool      use_gtp_kernel_module;
   bool      enable_loading_gtp_kernel_module;
 
@@ -175,6 +202,9 @@ typedef struct pgw_config_s {
 #if ENABLE_OPENFLOW
   spgw_ovs_config_t ovs_config;
 #endif
+#if ENABLE_USERSPACE_GTPU
+  spgw_gtpu_userspace_config_t gtpu_userspace_config;
+#endif
 
   STAILQ_HEAD(ipv4_pool_head_s, conf_ipv4_list_elm_s) ipv4_pool_list;
 } pgw_config_t;
@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <errno.h>
 #include <string.h>
+#include <pthread.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -60,6 +61,9 @@ extern "C" {
 
 extern pgw_app_t                        pgw_app;
 
+// SPGW_APP workers allocate and release PAA addresses concurrently
+static pthread_mutex_t                  pgw_paa_ipv4_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 
 // Load in PGW pool, configured PAA address pool
 void
@@ -114,7 +118,9 @@ pgw_get_free_ipv4_paa_address (
 {
   struct ipv4_list_elm_s        *ipv4_p = NULL;
 
+  pthread_mutex_lock (&pgw_paa_ipv4_pool_mutex);
   if (STAILQ_EMPTY (&pgw_app.ipv4_list_free)) {
+    pthread_mutex_unlock (&pgw_paa_ipv4_pool_mutex);
     addr_pP->s_addr = INADDR_ANY;
     return RETURNerror;
   }
@@ -123,6 +129,7 @@ pgw_get_free_ipv4_paa_address (
   STAILQ_REMOVE (&pgw_app.ipv4_list_free, ipv4_p, ipv4_list_elm_s, ipv4_entries);
   STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_allocated, ipv4_p, ipv4_entries);
   addr_pP->s_addr = ipv4_p->addr.s_addr;
+  pthread_mutex_unlock (&pgw_paa_ipv4_pool_mutex);
   return RETURNok;
 }
 
@@ -132,13 +139,16 @@ pgw_release_free_ipv4_paa_address (
 {
   struct ipv4_list_elm_s        *ipv4_p = NULL;
 
+  pthread_mutex_lock (&pgw_paa_ipv4_pool_mutex);
   STAILQ_FOREACH (ipv4_p, &pgw_app.ipv4_list_allocated, ipv4_entries) {
     if (ipv4_p->addr.s_addr == addr_pP->s_addr) {
       STAILQ_REMOVE (&pgw_app.ipv4_list_allocated, ipv4_p, ipv4_list_elm_s, ipv4_entries);
       STAILQ_INSERT_HEAD (&pgw_app.ipv4_list_free, ipv4_p, ipv4_entries);
+      pthread_mutex_unlock (&pgw_paa_ipv4_pool_mutex);
       return RETURNok;
     }
   }
+  pthread_mutex_unlock (&pgw_paa_ipv4_pool_mutex);
   return RETURNerror;
 }
 
@@ -59,8 +59,8 @@ typedef struct sgw_app_s {
   // key is S11 S-GW local teid, value is S11 tunnel id pair
   hash_table_ts_t *s11teid2mme_hashtable;
 
-  // key is paa, value is S11 s-gw local teid
-  obj_hash_table_uint64_t *ip2s11teid;
+  // key is the paa IPv4 address (network order), value is S11 s-gw local teid
+  hash_table_uint64_ts_t *ip2s11teid;
 
   // key is S1-U S-GW local teid
   //hash_table_t *s1uteid2enb_hashtable;
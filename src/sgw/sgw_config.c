@@ -93,6 +93,7 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
   char                                   *S11 = NULL;
   libconfig_int                           sgw_udp_port_S1u_S12_S4_up = 2152;
   libconfig_int                           sgw_udp_port_S11 = 2123;
+  libconfig_int                           spgw_app_workers = 1;
   config_setting_t                       *subsetting = NULL;
   const char                             *astring = NULL;
   bstring                                 address = NULL;
@@ -199,6 +200,27 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
     }
     OAILOG_SET_CONFIG(&config_pP->log_config);
 
+    // INTERTASK_INTERFACE setting
+    config_pP->itti_config.spgw_app_workers = 1;
+    subsetting = config_setting_get_member (setting_sgw, SGW_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG);
+
+    if (subsetting) {
+      if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_SPGW_APP_WORKERS, &spgw_app_workers)) {
+        if ((spgw_app_workers < 1) || (spgw_app_workers > SPGW_APP_WORKERS_MAX)) {
+          OAILOG_WARNING (LOG_SPGW_APP, "%s=%d out of range [1..%d], using 1\n", SGW_CONFIG_STRING_SPGW_APP_WORKERS, (int)spgw_app_workers, SPGW_APP_WORKERS_MAX);
+          spgw_app_workers = 1;
+        }
+#if !ENABLE_USERSPACE_GTPU
+        // only the userspace GTP-U backend supports concurrent add/del of tunnels
+        if (spgw_app_workers > 1) {
+          OAILOG_WARNING (LOG_SPGW_APP, "%s=%d needs the userspace GTP-U backend, using 1\n", SGW_CONFIG_STRING_SPGW_APP_WORKERS, (int)spgw_app_workers);
+          spgw_app_workers = 1;
+        }
+#endif
+        config_pP->itti_config.spgw_app_workers = spgw_app_workers;
+      }
+    }
+
     subsetting = config_setting_get_member (setting_sgw, SGW_CONFIG_STRING_NETWORK_INTERFACES_CONFIG);
 
     if (subsetting) {
@@ -293,6 +315,7 @@ void sgw_config_display (sgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "- ITTI:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    queue size .......: %u (bytes)\n", config_p->itti_config.queue_size);
   OAILOG_INFO (LOG_SPGW_APP, "    log file .........: %s\n", bdata(config_p->itti_config.log_file));
+  OAILOG_INFO (LOG_SPGW_APP, "    SPGW_APP workers .: %u\n", config_p->itti_config.spgw_app_workers);
 
   OAILOG_INFO (LOG_SPGW_APP, "- Logging:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    Output ..............: %s\n", bdata(config_p->log_config.output));
@@ -48,6 +48,10 @@ extern "C" {
 #define SGW_CONFIG_STRING_SGW_INTERFACE_NAME_FOR_S11            "SGW_INTERFACE_NAME_FOR_S11"
 #define SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S11              "SGW_IPV4_ADDRESS_FOR_S11"
 #define SGW_CONFIG_STRING_SGW_UDP_PORT_FOR_S11                  "SGW_UDP_PORT_FOR_S11"
+#define SGW_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG            "INTERTASK_INTERFACE"
+#define SGW_CONFIG_STRING_SPGW_APP_WORKERS                      "SPGW_APP_WORKERS"
+
+#define SPGW_APP_WORKERS_MAX 8 // TASK_SPGW_APP .. TASK_SPGW_APP_7
 
 #define SPGW_ABORT_ON_ERROR true
 #define SPGW_WARN_ON_ERROR false
@@ -60,6 +64,7 @@ typedef struct sgw_config_s {
   struct {
     uint32_t  queue_size;
     bstring   log_file;
+    uint32_t  spgw_app_workers; ///< number of SPGW_APP tasks, sessions are sharded on the local S11 teid
   } itti_config;
 
   struct {
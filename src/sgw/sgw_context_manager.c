@@ -32,7 +32,9 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
+#include <pthread.h>
 #include <netinet/in.h>
 
 #include "bstrlib.h"
@@ -50,6 +52,7 @@
 #include "3gpp_23.401.h"
 #include "sgw_defs.h"
 #include "sgw_context_manager.h"
+#include "sgw_downlink_data_notification.h"
 #include "sgw.h"
 
 #ifdef __cplusplus
@@ -58,6 +61,115 @@ extern "C" {
 
 extern sgw_app_t                        sgw_app;
 
+#define SGW_CM_SLAB_CHUNK_ITEMS 32
+
+/*
+ * Per SPGW_APP worker slabs of the bearer and session contexts. Each item points to the slab it
+ * was carved from: an item freed by another thread goes back to its owner through a lock free
+ * list the owner takes whole when its own free list is empty. The chunks are released by sgw_exit.
+ */
+typedef struct sgw_cm_slab_s {
+  struct sgw_cm_slab_s                   *next;                 // all the slabs, see sgw_cm_slab_exit()
+  void                                   *chunks;               // chunks carved by this slab, linked by their header
+  void                                   *free_list;            // owner thread only
+  void                                   *remote_free_list;     // pushed by the other threads
+} sgw_cm_slab_t;
+
+/* Header of a chunk and of each item in it, keeps the items aligned as malloc() does */
+typedef union sgw_cm_slab_header_u {
+  void                                   *next_chunk;
+  sgw_cm_slab_t                          *slab;
+  max_align_t                             align;
+} sgw_cm_slab_header_t;
+
+static pthread_mutex_t                  sgw_cm_slabs_lock = PTHREAD_MUTEX_INITIALIZER;
+static sgw_cm_slab_t                   *sgw_cm_slabs = NULL;
+static __thread sgw_cm_slab_t          *sgw_eps_bearer_ctxt_slab = NULL;
+static __thread sgw_cm_slab_t          *sgw_bearer_context_information_slab = NULL;
+
+//-----------------------------------------------------------------------------
+static void *sgw_cm_slab_alloc (sgw_cm_slab_t ** const thread_slab, const size_t item_size)
+{
+  sgw_cm_slab_t                          *slab = *thread_slab;
+  char                                   *item = NULL;
+  const size_t                            stride = sizeof (sgw_cm_slab_header_t) +
+      ((item_size + sizeof (sgw_cm_slab_header_t) - 1) / sizeof (sgw_cm_slab_header_t)) * sizeof (sgw_cm_slab_header_t);
+
+  if (!slab) {
+    slab = calloc (1, sizeof (sgw_cm_slab_t));
+    if (!slab) {
+      return NULL;
+    }
+    pthread_mutex_lock (&sgw_cm_slabs_lock);
+    slab->next = sgw_cm_slabs;
+    sgw_cm_slabs = slab;
+    pthread_mutex_unlock (&sgw_cm_slabs_lock);
+    *thread_slab = slab;
+  }
+  if (!slab->free_list) {
+    slab->free_list = __atomic_exchange_n (&slab->remote_free_list, NULL, __ATOMIC_ACQUIRE);
+  }
+  if (!slab->free_list) {
+    char                                   *chunk = malloc (sizeof (sgw_cm_slab_header_t) + SGW_CM_SLAB_CHUNK_ITEMS * stride);
+
+    if (!chunk) {
+      return NULL;
+    }
+    ((sgw_cm_slab_header_t *)chunk)->next_chunk = slab->chunks;
+    slab->chunks = chunk;
+    for (int i = SGW_CM_SLAB_CHUNK_ITEMS - 1; i >= 0; i--) {
+      sgw_cm_slab_header_t * const          header = (sgw_cm_slab_header_t *)&chunk[sizeof (sgw_cm_slab_header_t) + i * stride];
+
+      header->slab = slab;
+      *(void **)&header[1] = slab->free_list;
+      slab->free_list = &header[1];
+    }
+  }
+  item = slab->free_list;
+  slab->free_list = *(void **)item;
+  memset (item, 0, item_size);
+  return item;
+}
+
+//-----------------------------------------------------------------------------
+static void sgw_cm_slab_free (sgw_cm_slab_t ** const thread_slab, void ** const item)
+{
+  sgw_cm_slab_t * const                   slab = ((sgw_cm_slab_header_t *)*item)[-1].slab;
+
+  if (slab == *thread_slab) {
+    *(void **)*item = slab->free_list;
+    slab->free_list = *item;
+  } else {
+    // freed by another worker, given back to the owner
+    void                                   *head = __atomic_load_n (&slab->remote_free_list, __ATOMIC_RELAXED);
+
+    do {
+      *(void **)*item = head;
+    } while (!__atomic_compare_exchange_n (&slab->remote_free_list, &head, *item, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  }
+  *item = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void sgw_cm_slab_exit (void)
+{
+  sgw_cm_slab_t                          *slab = NULL;
+
+  pthread_mutex_lock (&sgw_cm_slabs_lock);
+  while ((slab = sgw_cm_slabs)) {
+    sgw_cm_slabs = slab->next;
+    while (slab->chunks) {
+      void                                   *chunk = slab->chunks;
+
+      slab->chunks = ((sgw_cm_slab_header_t *)chunk)->next_chunk;
+      free_wrapper (&chunk);
+    }
+    free_wrapper ((void**)&slab);
+  }
+  pthread_mutex_unlock (&sgw_cm_slabs_lock);
+  sgw_eps_bearer_ctxt_slab = NULL;
+  sgw_bearer_context_information_slab = NULL;
+}
 
 //-----------------------------------------------------------------------------
 static bool
@@ -173,9 +285,15 @@ sgw_get_new_S11_tunnel_id (
 //-----------------------------------------------------------------------------
 {
   // TO DO: RANDOM
-  static teid_t                           tunnel_id = 100;
+  // Each SPGW_APP worker allocates the teids it owns (teid modulo number of workers == worker index)
+  static __thread teid_t                  tunnel_id = 0;
+  const uint32_t                          workers = sgw_worker_count ();
 
-  tunnel_id += 1;
+  if (!tunnel_id) {
+    tunnel_id = 101 + ((sgw_worker_index () + workers - (101 % workers)) % workers);
+  } else {
+    tunnel_id += workers;
+  }
   return tunnel_id;
 }
 
@@ -226,7 +344,7 @@ sgw_eps_bearer_ctxt_t *sgw_cm_create_eps_bearer_context (void)
 {
   sgw_eps_bearer_ctxt_t                 *sgw_eps_bearer_ctxt = NULL;
 
-  sgw_eps_bearer_ctxt = calloc (1, sizeof (sgw_eps_bearer_ctxt_t));
+  sgw_eps_bearer_ctxt = sgw_cm_slab_alloc (&sgw_eps_bearer_ctxt_slab, sizeof (sgw_eps_bearer_ctxt_t));
 
   if (sgw_eps_bearer_ctxt == NULL) {
     /*
@@ -273,56 +391,25 @@ void sgw_cm_free_pdn_connection (sgw_pdn_connection_t * pdn_connectionP)
 void sgw_free_sgw_eps_bearer_context (sgw_eps_bearer_ctxt_t ** sgw_eps_bearer_ctxt)
 {
   if (*sgw_eps_bearer_ctxt) {
-    // nothing to do actually
-    free_wrapper((void**) sgw_eps_bearer_ctxt);
+    sgw_cm_slab_free (&sgw_eps_bearer_ctxt_slab, (void **)sgw_eps_bearer_ctxt);
   }
 }
 
 //-----------------------------------------------------------------------------
 int sgw_register_paging_paa(const teid_t local_s11_teid, const paa_t * const paa)
 {
-  char str[INET6_ADDRSTRLEN+1] = {0};
-
+  // Only the IPv4 address of the UE is looked up by the downlink data notifications
   switch (paa->pdn_type) {
   case  IPv4:
-    if (inet_ntop(AF_INET, &paa->ipv4_address, str, INET6_ADDRSTRLEN) == NULL) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to register PAA IPv4 address\n");
-      return RETURNerror;
-    }
-    if (HASH_TABLE_OK != obj_hashtable_uint64_ts_insert (sgw_app.ip2s11teid, strdup(str), strlen(str), local_s11_teid)) {
+  case IPv4_AND_v6:
+    if (HASH_TABLE_OK != hashtable_uint64_ts_insert (sgw_app.ip2s11teid, (hash_key_t)paa->ipv4_address.s_addr, local_s11_teid)) {
       OAILOG_ERROR (LOG_SPGW_APP, "Failed to register PAA IPv4 address\n");
       return RETURNerror;
     }
-    OAILOG_DEBUG (LOG_SPGW_APP, "Register PAA IPv4 address for paging in sgw_app.ip2s11teid[" TEID_FMT "]=%s\n", local_s11_teid, str);
-
+    OAILOG_DEBUG (LOG_SPGW_APP, "Register PAA IPv4 address for paging in sgw_app.ip2s11teid[" TEID_FMT "]=%"PRIu8".%"PRIu8".%"PRIu8".%"PRIu8"\n",
+        local_s11_teid, NIPADDR(paa->ipv4_address.s_addr));
     break;
   case IPv6:
-    if (inet_ntop(AF_INET6, &paa->ipv6_address, str, INET6_ADDRSTRLEN) == NULL) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to register PAA IPv6 address\n");
-      return RETURNerror;
-    }
-    if (HASH_TABLE_OK != obj_hashtable_uint64_ts_insert (sgw_app.ip2s11teid, strdup(str), strlen(str), local_s11_teid)) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to register PAA IPv6 address\n");
-      return RETURNerror;
-    }
-    break;
-  case IPv4_AND_v6:
-    if (inet_ntop(AF_INET, &paa->ipv4_address, str, INET6_ADDRSTRLEN) == NULL) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to register PAA IPv4 address\n");
-      return RETURNerror;
-    }
-    if (HASH_TABLE_OK != obj_hashtable_uint64_ts_insert (sgw_app.ip2s11teid, strdup(str), strlen(str), local_s11_teid)) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to register PAA IPv4 address\n");
-      return RETURNerror;
-    }
-    if (inet_ntop(AF_INET6, &paa->ipv6_address, str, INET6_ADDRSTRLEN) == NULL) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to register PAA IPv6 address\n");
-      return RETURNerror;
-    }
-    if (HASH_TABLE_OK != obj_hashtable_uint64_ts_insert (sgw_app.ip2s11teid, strdup(str), strlen(str), local_s11_teid)) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to register PAA IPv6 address\n");
-      return RETURNerror;
-    }
     break;
   default:
     return RETURNerror;
@@ -333,50 +420,17 @@ int sgw_register_paging_paa(const teid_t local_s11_teid, const paa_t * const paa
 //-----------------------------------------------------------------------------
 int sgw_deregister_paging_paa(const paa_t * const paa)
 {
-  char str[INET6_ADDRSTRLEN+1] = {0};
-
   switch (paa->pdn_type) {
   case  IPv4:
-    if (inet_ntop(AF_INET, &paa->ipv4_address, str, INET6_ADDRSTRLEN) == NULL) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to deregister PAA IPv4 address\n");
-      return RETURNerror;
-    }
-    if (HASH_TABLE_OK != obj_hashtable_uint64_ts_free (sgw_app.ip2s11teid, str, strlen(str))) {
+  case IPv4_AND_v6:
+    if (HASH_TABLE_OK != hashtable_uint64_ts_free (sgw_app.ip2s11teid, (hash_key_t)paa->ipv4_address.s_addr)) {
       OAILOG_ERROR (LOG_SPGW_APP, "Failed to deregister PAA IPv4 address\n");
       return RETURNerror;
     }
-    OAILOG_DEBUG (LOG_SPGW_APP, "Deregistered PAA IPv4 address for paging in sgw_app.ip2s11teid[%s]\n", str);
+    OAILOG_DEBUG (LOG_SPGW_APP, "Deregistered PAA IPv4 address for paging in sgw_app.ip2s11teid[%"PRIu8".%"PRIu8".%"PRIu8".%"PRIu8"]\n",
+        NIPADDR(paa->ipv4_address.s_addr));
     break;
   case IPv6:
-    if (inet_ntop(AF_INET6, &paa->ipv6_address, str, INET6_ADDRSTRLEN) == NULL) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to deregister PAA IPv6 address\n");
-      return RETURNerror;
-    }
-    if (HASH_TABLE_OK != obj_hashtable_uint64_ts_free (sgw_app.ip2s11teid, str, strlen(str))) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to deregister PAA IPv6 address\n");
-      return RETURNerror;
-    }
-    OAILOG_DEBUG (LOG_SPGW_APP, "Deregistered PAA IPv6 address for paging in sgw_app.ip2s11teid[%s]\n", str);
-    break;
-  case IPv4_AND_v6:
-    if (inet_ntop(AF_INET, &paa->ipv4_address, str, INET6_ADDRSTRLEN) == NULL) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to deregister PAA IPv4 address\n");
-      return RETURNerror;
-    }
-    if (HASH_TABLE_OK != obj_hashtable_uint64_ts_free (sgw_app.ip2s11teid, str, strlen(str))) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to deregister PAA IPv4 address\n");
-      return RETURNerror;
-    }
-    OAILOG_DEBUG (LOG_SPGW_APP, "Deregistered PAA IPv4 address for paging in sgw_app.ip2s11teid[%s]\n", str);
-    if (inet_ntop(AF_INET6, &paa->ipv6_address, str, INET6_ADDRSTRLEN) == NULL) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to deregister PAA IPv6 address\n");
-      return RETURNerror;
-    }
-    if (HASH_TABLE_OK != obj_hashtable_uint64_ts_free (sgw_app.ip2s11teid, str, strlen(str))) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to deregister PAA IPv6 address\n");
-      return RETURNerror;
-    }
-    OAILOG_DEBUG (LOG_SPGW_APP, "Deregistered PAA IPv6 address for paging in sgw_app.ip2s11teid[%s]\n", str);
     break;
   default:
     return RETURNerror;
@@ -397,7 +451,7 @@ int sgw_get_subscriber_id_from_ipv4(const struct in_addr* dest_ip, char** imsi,
 
   sgw_display_s11_bearer_context_information_mapping();
 
-  if (HASH_TABLE_OK != obj_hashtable_uint64_ts_get (sgw_app.ip2s11teid, str, strlen(str), &teid)) {
+  if (HASH_TABLE_OK != hashtable_uint64_ts_get (sgw_app.ip2s11teid, (hash_key_t)dest_ip->s_addr, &teid)) {
     return RETURNerror;
   }
   *s11_lteid = (teid_t)teid;
@@ -426,13 +480,14 @@ void sgw_cm_free_s_plus_p_gw_eps_bearer_context_information (s_plus_p_gw_eps_bea
 {
   if (*contextP) {
 
+    sgw_ddn_stop (&(*contextP)->sgw_eps_bearer_context_information);
     sgw_cm_free_pdn_connection(&(*contextP)->sgw_eps_bearer_context_information.pdn_connection);
 
     if ((*contextP)->pgw_eps_bearer_context_information.apns ) {
       obj_hashtable_ts_destroy ((*contextP)->pgw_eps_bearer_context_information.apns);
     }
 
-    free_wrapper ((void**)contextP);
+    sgw_cm_slab_free (&sgw_bearer_context_information_slab, (void **)contextP);
   }
 }
 
@@ -451,7 +506,7 @@ sgw_cm_create_bearer_context_information_in_collection (
 {
   s_plus_p_gw_eps_bearer_context_information_t *new_bearer_context_information = NULL;
 
-  new_bearer_context_information = calloc (1, sizeof (s_plus_p_gw_eps_bearer_context_information_t));
+  new_bearer_context_information = sgw_cm_slab_alloc (&sgw_bearer_context_information_slab, sizeof (s_plus_p_gw_eps_bearer_context_information_t));
 
   if (new_bearer_context_information == NULL) {
     /*
@@ -471,16 +526,7 @@ sgw_cm_create_bearer_context_information_in_collection (
    * return NULL;
    * }
    */
-  bstring b = bfromcstr("pgw_eps_bearer_ctxt_info_apns");
-  new_bearer_context_information->pgw_eps_bearer_context_information.apns =
-      obj_hashtable_ts_create (32, NULL, NULL, (void (*) (void **))pgw_lite_cm_free_apn, b);
-  bdestroy_wrapper (&b);
-
-  if (new_bearer_context_information->pgw_eps_bearer_context_information.apns == NULL) {
-    OAILOG_ERROR (LOG_SPGW_APP, "Failed to create APN collection object entry for EPS bearer S11 teid " TEID_FMT "\n", teid);
-    sgw_cm_free_s_plus_p_gw_eps_bearer_context_information (&new_bearer_context_information);
-    return NULL;
-  }
+  // The PGW APN collection (pgw_eps_bearer_context_information.apns) is not used, it is left NULL
 
   /*
    * Trying to insert the new tunnel into the tree.
@@ -516,7 +562,7 @@ sgw_eps_bearer_ctxt_t *sgw_cm_create_eps_bearer_ctxt_in_collection (
   AssertFatal ((eps_bearer_idP >= EPS_BEARER_IDENTITY_FIRST) && (eps_bearer_idP <= EPS_BEARER_IDENTITY_LAST), "Bad parameter ebi %u", eps_bearer_idP);
 
   if (!sgw_pdn_connection->sgw_eps_bearers_array[EBI_TO_INDEX(eps_bearer_idP)]) {
-    new_eps_bearer_entry = calloc (1, sizeof (sgw_eps_bearer_ctxt_t));
+    new_eps_bearer_entry = sgw_cm_slab_alloc (&sgw_eps_bearer_ctxt_slab, sizeof (sgw_eps_bearer_ctxt_t));
 
     if (new_eps_bearer_entry == NULL) {
       /*
@@ -575,9 +621,8 @@ sgw_cm_remove_eps_bearer_entry (
   if ((ebi < EPS_BEARER_IDENTITY_FIRST) || (ebi > EPS_BEARER_IDENTITY_LAST)) {
     return RETURNerror;
   }
-  sgw_eps_bearer_ctxt_t * sgw_eps_bearer_ctxt = sgw_pdn_connection->sgw_eps_bearers_array[EBI_TO_INDEX(ebi)];
-  if (sgw_eps_bearer_ctxt) {
-    sgw_free_sgw_eps_bearer_context(&sgw_eps_bearer_ctxt);
+  if (sgw_pdn_connection->sgw_eps_bearers_array[EBI_TO_INDEX(ebi)]) {
+    sgw_free_sgw_eps_bearer_context(&sgw_pdn_connection->sgw_eps_bearers_array[EBI_TO_INDEX(ebi)]);
     return RETURNok;
   }
   return RETURNerror;
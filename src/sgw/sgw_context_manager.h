@@ -72,6 +72,7 @@ sgw_eps_bearer_ctxt_t *                sgw_cm_create_eps_bearer_context(void);
 sgw_pdn_connection_t *                 sgw_cm_create_pdn_connection(void);
 void                                   sgw_cm_free_pdn_connection(sgw_pdn_connection_t *pdn_connectionP);
 void                                   sgw_free_sgw_eps_bearer_context (sgw_eps_bearer_ctxt_t ** sgw_eps_bearer_ctxt);
+void                                   sgw_cm_slab_exit(void);
 int                                    sgw_register_paging_paa(const teid_t local_s11_teid, const paa_t * const paa);
 int                                    sgw_deregister_paging_paa(const paa_t * const paa);
 int                                    sgw_get_subscriber_id_from_ipv4(const struct in_addr* dest_ip, char** imsi, teid_t * s11_lteid);
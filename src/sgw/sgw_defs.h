@@ -29,6 +29,7 @@
 #ifndef FILE_SGW_DEFS_SEEN
 #define FILE_SGW_DEFS_SEEN
 #include "spgw_config.h"
+#include "intertask_interface_types.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +37,20 @@ extern "C" {
 
 int sgw_init(spgw_config_t *spgw_config_pP);
 
+/*
+ * The SPGW_APP runs on up to SPGW_APP_WORKERS_MAX tasks, a session is owned by the task
+ * of index (local S11 teid modulo number of workers), all messages for a session must be
+ * sent to sgw_task_for_s11_teid(). A local S11 teid of 0 (Create Session Request)
+ * selects a worker in round robin, the worker then allocates a teid it owns.
+ */
+task_id_t sgw_task_for_s11_teid(const teid_t local_s11_teid);
+
+/* Index of the SPGW_APP worker running the calling thread, 0 if not a worker. */
+uint32_t sgw_worker_index(void);
+
+/* Number of SPGW_APP workers. */
+uint32_t sgw_worker_count(void);
+
 #ifdef __cplusplus
 }
 #endif
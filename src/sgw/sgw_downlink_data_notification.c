@@ -21,6 +21,10 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include <string.h>
+#include <arpa/inet.h>
 
 
 
@@ -35,7 +39,16 @@
 #include "sgw_context_manager.h"
 #include "gtpv1_u_messages_types.h"
 #include "sgw.h"
+#include "sgw_defs.h"
+#include "sgw_handler_gtpu.h"
+#include "timer.h"
+#if ENABLE_USERSPACE_GTPU
+#include "gtp_tunnel_userspace.h"
+#define sgw_stop_dl_data_notification_ue gtpu_userspace_stop_dl_data_notification_ue
+#else
 #include "ControllerMain.h"
+#define sgw_stop_dl_data_notification_ue openflow_controller_stop_dl_data_notification_ue
+#endif
 
 
 #ifdef __cplusplus
@@ -44,6 +57,128 @@ extern "C" {
 
 extern sgw_app_t                        sgw_app;
 
+//------------------------------------------------------------------------------
+static uint64_t sgw_ddn_now_ms (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+//------------------------------------------------------------------------------
+// Throttling delay, 3GPP TS 29.274 #8.85, undefined units are interpreted as 1 minute
+static uint64_t sgw_ddn_throttling_delay_ms (const throttling_t * const throttling)
+{
+  static const uint64_t unit_ms[] = {2000, 60000, 600000, 3600000, 36000000, 60000, 60000, 0};
+  return unit_ms[throttling->throttling_delay_unit & 0x07] * throttling->throttling_delay_value;
+}
+
+//------------------------------------------------------------------------------
+bool sgw_ddn_check (s_plus_p_gw_eps_bearer_context_information_t * const ctx_p, const ebi_t ebi)
+{
+  sgw_eps_bearer_context_information_t * const sgw_ctxt_p = &ctx_p->sgw_eps_bearer_context_information;
+  sgw_ddn_context_t * const ddn = &sgw_ctxt_p->ddn;
+  const uint64_t now_ms = sgw_ddn_now_ms ();
+  sgw_eps_bearer_ctxt_t *eps_bearer_ctxt_p = sgw_cm_get_eps_bearer_entry (&sgw_ctxt_p->pdn_connection, ebi);
+
+  if (!eps_bearer_ctxt_p) {
+    eps_bearer_ctxt_p = sgw_cm_get_eps_bearer_entry (&sgw_ctxt_p->pdn_connection, sgw_ctxt_p->pdn_connection.default_bearer);
+    if (!eps_bearer_ctxt_p) {
+      return false;
+    }
+  }
+
+  // a new DDN is only sent for a bearer with a higher priority (lower ARP priority level) than the pending ones
+  for (int i = 0; i < BEARERS_PER_UE; i++) {
+    sgw_eps_bearer_ctxt_t * const pending_p = sgw_ctxt_p->pdn_connection.sgw_eps_bearers_array[i];
+    if ((!pending_p) || (!pending_p->ddn_pending)) {
+      continue;
+    }
+    if ((now_ms - pending_p->ddn_pending_since_ms) >= (PAGING_CONFIRMED_CLAMPING_TIMEOUT_SEC * 1000)) {
+      // neither answered nor user plane re-established, notify again
+      pending_p->ddn_pending = false;
+      continue;
+    }
+    if (pending_p->eps_bearer_qos.pl <= eps_bearer_ctxt_p->eps_bearer_qos.pl) {
+      OAILOG_DEBUG (LOG_SPGW_APP, "DL Data Notification already pending for S11 teid " TEID_FMT " ebi %u, ebi %u not sent\n",
+          sgw_ctxt_p->s_gw_teid_S11_S4, pending_p->eps_bearer_id, eps_bearer_ctxt_p->eps_bearer_id);
+      return false;
+    }
+  }
+
+  if ((ddn->throttling_factor) && (now_ms < ddn->throttling_until_ms) &&
+      (eps_bearer_ctxt_p->eps_bearer_qos.pl >= DDN_LOW_PRIORITY_ARP_PRIORITY_LEVEL_MIN)) {
+    // drop throttling_factor percent of the notifications, evenly spread
+    ddn->throttling_credit += ddn->throttling_factor;
+    if (ddn->throttling_credit >= 100) {
+      ddn->throttling_credit -= 100;
+      OAILOG_DEBUG (LOG_SPGW_APP, "DL Data Notification throttled for S11 teid " TEID_FMT " ebi %u\n", sgw_ctxt_p->s_gw_teid_S11_S4, eps_bearer_ctxt_p->eps_bearer_id);
+      return false;
+    }
+  }
+
+  eps_bearer_ctxt_p->ddn_pending = true;
+  eps_bearer_ctxt_p->ddn_pending_since_ms = now_ms;
+  if (now_ms < ddn->delay_until_ms) {
+    const uint64_t delay_ms = ddn->delay_until_ms - now_ms;
+    ddn->delayed_ebi = eps_bearer_ctxt_p->eps_bearer_id;
+    if (ddn->delay_timer_id) {
+      // already delayed, the timer notifies the higher priority bearer
+      return false;
+    }
+    if (RETURNok == timer_setup (delay_ms / 1000, (delay_ms % 1000) * 1000, sgw_task_for_s11_teid (sgw_ctxt_p->s_gw_teid_S11_S4), INSTANCE_DEFAULT, TIMER_ONE_SHOT,
+        (void*)(uintptr_t)sgw_ctxt_p->s_gw_teid_S11_S4, &ddn->delay_timer_id)) {
+      OAILOG_DEBUG (LOG_SPGW_APP, "DL Data Notification delayed %" PRIu64 " ms for S11 teid " TEID_FMT " ebi %u\n", delay_ms, sgw_ctxt_p->s_gw_teid_S11_S4, ddn->delayed_ebi);
+      return false;
+    }
+    ddn->delay_timer_id = 0;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void sgw_ddn_set_delay (sgw_eps_bearer_context_information_t * const sgw_ctxt_p, const DelayValue_t delay_value)
+{
+  if (delay_value) {
+    sgw_ctxt_p->ddn.delay_until_ms = sgw_ddn_now_ms () + ((uint64_t)delay_value * DDN_DELAY_VALUE_UNIT_MS);
+  }
+}
+
+//------------------------------------------------------------------------------
+void sgw_ddn_stop (sgw_eps_bearer_context_information_t * const sgw_ctxt_p)
+{
+  for (int i = 0; i < BEARERS_PER_UE; i++) {
+    if (sgw_ctxt_p->pdn_connection.sgw_eps_bearers_array[i]) {
+      sgw_ctxt_p->pdn_connection.sgw_eps_bearers_array[i]->ddn_pending = false;
+    }
+  }
+  if (sgw_ctxt_p->ddn.delay_timer_id) {
+    timer_remove (sgw_ctxt_p->ddn.delay_timer_id, NULL);
+    sgw_ctxt_p->ddn.delay_timer_id = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+int sgw_handle_ddn_delay_timer_expiry (const teid_t s11_teid, const long timer_id)
+{
+  OAILOG_FUNC_IN(LOG_SPGW_APP);
+  s_plus_p_gw_eps_bearer_context_information_t *ctx_p = NULL;
+
+  if (HASH_TABLE_OK == hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, s11_teid, (void **)&ctx_p)) {
+    sgw_eps_bearer_context_information_t * const sgw_ctxt_p = &ctx_p->sgw_eps_bearer_context_information;
+    sgw_ddn_context_t * const ddn = &sgw_ctxt_p->ddn;
+    sgw_eps_bearer_ctxt_t * const eps_bearer_ctxt_p = sgw_cm_get_eps_bearer_entry (&sgw_ctxt_p->pdn_connection, ddn->delayed_ebi);
+    // the timer may have been stopped while its expiry was queued
+    if (ddn->delay_timer_id == timer_id) {
+      ddn->delay_timer_id = 0;
+      if ((eps_bearer_ctxt_p) && (eps_bearer_ctxt_p->ddn_pending)) {
+        eps_bearer_ctxt_p->ddn_pending_since_ms = sgw_ddn_now_ms ();
+        OAILOG_FUNC_RETURN(LOG_SPGW_APP, sgw_send_s11_downlink_data_notification (ctx_p, ddn->delayed_ebi));
+      }
+    }
+  }
+  OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
+}
 
 //------------------------------------------------------------------------------
 int sgw_notify_downlink_data(const struct in_addr ue_ip, const ebi_t ebi)
@@ -51,6 +186,7 @@ int sgw_notify_downlink_data(const struct in_addr ue_ip, const ebi_t ebi)
 
   Gtpv1uDownlinkDataNotification     *gtpv1u_dl_data = NULL;
   MessageDef                             *message_p = NULL;
+  uint64_t                                s11_teid = 0;
 
   // thread of OF controller
   if ((message_p = itti_alloc_new_message_sized (TASK_UNKNOWN, GTPV1U_DOWNLINK_DATA_NOTIFICATION, sizeof(Gtpv1uDownlinkDataNotification)))) {
@@ -58,7 +194,11 @@ int sgw_notify_downlink_data(const struct in_addr ue_ip, const ebi_t ebi)
     gtpv1u_dl_data->ue_ip = ue_ip;
     gtpv1u_dl_data->eps_bearer_id = ebi;
 
-    int rv = itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+    // route to the SPGW_APP worker owning the session, unknown UEs are left to the first worker
+    if (sgw_worker_count () > 1) {
+      hashtable_uint64_ts_get (sgw_app.ip2s11teid, (hash_key_t)ue_ip.s_addr, &s11_teid);
+    }
+    int rv = itti_send_msg_to_task (sgw_task_for_s11_teid ((teid_t)s11_teid), INSTANCE_DEFAULT, message_p);
     return rv;
   }
   OAILOG_ERROR (LOG_SPGW_APP, "Failed to send GTPV1U_DOWNLINK_DATA_NOTIFICATION to task TASK_SPGW_APP\n");
@@ -76,6 +216,25 @@ sgw_handle_s11_downlink_data_notification_ack (
 
   // TODO procedure for DL DATA NOTIFICATION
   if (RETURNok == (rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, ack->teid, (void **)&bearer_ctxt_info_p))) {
+    sgw_ddn_context_t * const ddn = &bearer_ctxt_info_p->sgw_eps_bearer_context_information.ddn;
+    const throttling_t * const throttling = &ack->dl_low_priority_traffic_throttling;
+    uint16_t clamping_timeout = PAGING_CONFIRMED_CLAMPING_TIMEOUT_SEC;
+
+    if (sgw_ddn_throttling_delay_ms (throttling)) {
+      ddn->throttling_factor = throttling->throttling_factor;
+      ddn->throttling_until_ms = sgw_ddn_now_ms () + sgw_ddn_throttling_delay_ms (throttling);
+    } else if ((throttling->throttling_delay_unit & 0x07) == 0x07) {
+      // throttling deactivated
+      ddn->throttling_factor = 0;
+    }
+    if ((REQUEST_ACCEPTED == ack->cause.cause_value) && (ack->data_notification_delay)) {
+      // MME asks to delay the DDN instead of paging now, the next trigger arms the delay
+      sgw_ddn_stop (&bearer_ctxt_info_p->sgw_eps_bearer_context_information);
+      sgw_ddn_set_delay (&bearer_ctxt_info_p->sgw_eps_bearer_context_information, ack->data_notification_delay);
+      clamping_timeout = 0;
+    } else if (REQUEST_ACCEPTED != ack->cause.cause_value) {
+      sgw_ddn_stop (&bearer_ctxt_info_p->sgw_eps_bearer_context_information);
+    }
     int bidx = 0;
     while ((NULL == bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[bidx]) && (bidx < BEARERS_PER_UE)) {
       bidx++;
@@ -85,7 +244,7 @@ sgw_handle_s11_downlink_data_notification_ack (
       if ((IPv4 == paa.pdn_type) || (IPv4_AND_v6 == paa.pdn_type)) {
         switch (ack->cause.cause_value) {
         case REQUEST_ACCEPTED:
-          openflow_controller_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_CONFIRMED_CLAMPING_TIMEOUT_SEC);
+          sgw_stop_dl_data_notification_ue(paa.ipv4_address, clamping_timeout);
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         case TEMP_REJECT_HO_IN_PROGRESS:
@@ -95,7 +254,7 @@ sgw_handle_s11_downlink_data_notification_ack (
         case UNABLE_TO_PAGE_UE:
         case CONTEXT_NOT_FOUND:
         case UNABLE_TO_PAGE_UE_DUE_TO_SUSPENSION:
-          openflow_controller_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_REJECTED_CLAMPING_TIMEOUT_SEC);
+          sgw_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_REJECTED_CLAMPING_TIMEOUT_SEC);
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         default:
@@ -119,6 +278,7 @@ sgw_handle_s11_downlink_data_notification_failure_ind (
 
   // TODO procedure for DL DATA NOTIFICATION
   if (RETURNok == (rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, ind->teid, (void **)&bearer_ctxt_info_p))) {
+    sgw_ddn_stop (&bearer_ctxt_info_p->sgw_eps_bearer_context_information);
     int bidx = 0;
     while ((NULL == bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[bidx]) && (bidx < BEARERS_PER_UE)) {
       bidx++;
@@ -128,14 +288,14 @@ sgw_handle_s11_downlink_data_notification_failure_ind (
       if ((IPv4 == paa.pdn_type) || (IPv4_AND_v6 == paa.pdn_type)) {
         switch (ind->cause.cause_value) {
         case SERVICE_DENIED:
-          openflow_controller_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_SERVICE_DENIED_CLAMPING_TIMEOUT_SEC);
+          sgw_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_SERVICE_DENIED_CLAMPING_TIMEOUT_SEC);
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         case UE_ALREADY_RE_ATTACHED:
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         case UE_NOT_RESPONDING:
-          openflow_controller_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_UE_NOT_RESPONDING_CLAMPING_TIMEOUT_SEC);
+          sgw_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_UE_NOT_RESPONDING_CLAMPING_TIMEOUT_SEC);
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         default:
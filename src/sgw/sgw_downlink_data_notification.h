@@ -34,6 +34,8 @@ extern "C" {
 #include <netinet/in.h>
 #include "3gpp_24.007.h"
 #include "s11_messages_types.h"
+#include "3gpp_23.401.h"
+#include "sgw_context_manager.h"
 
 #define PAGING_UNCONFIRMED_CLAMPING_TIMEOUT_SEC        6
 #define PAGING_CONFIRMED_CLAMPING_TIMEOUT_SEC          60
@@ -41,8 +43,27 @@ extern "C" {
 #define PAGING_SERVICE_DENIED_CLAMPING_TIMEOUT_SEC     180
 #define PAGING_REJECTED_CLAMPING_TIMEOUT_SEC           8192
 
+// Delay Value IE unit, 3GPP TS 29.274 #8.27
+#define DDN_DELAY_VALUE_UNIT_MS                        50
+// ARP priority levels subject to DL low priority traffic throttling (operator policy, 3GPP TS 23.401 #4.3.7.4.1a)
+#define DDN_LOW_PRIORITY_ARP_PRIORITY_LEVEL_MIN        10
+
 int sgw_notify_downlink_data(const struct in_addr ue_ip, const ebi_t ebi);
 
+/*
+ * Called on a downlink data trigger from the user plane, returns true if a DDN has
+ * to be sent now. A DDN is not sent while a previous one is pending, is held until
+ * the end of a requested delay and low priority DDNs are throttled.
+ */
+bool sgw_ddn_check (s_plus_p_gw_eps_bearer_context_information_t * const ctx_p, const ebi_t ebi);
+
+void sgw_ddn_set_delay (sgw_eps_bearer_context_information_t * const sgw_ctxt_p, const DelayValue_t delay_value);
+
+// User plane re-established (Modify Bearer Request) or context released.
+void sgw_ddn_stop (sgw_eps_bearer_context_information_t * const sgw_ctxt_p);
+
+int sgw_handle_ddn_delay_timer_expiry (const teid_t s11_teid, const long timer_id);
+
 int sgw_handle_s11_downlink_data_notification_ack (const itti_s11_downlink_data_notification_acknowledge_t * const ack);
 
 int sgw_handle_s11_downlink_data_notification_failure_ind (const itti_s11_downlink_data_notification_failure_indication_t * const ind);
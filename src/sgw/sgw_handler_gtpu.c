@@ -55,6 +55,8 @@
 #include "gtpv1_u_messages_types.h"
 #include "s11_messages_types.h"
 #include "sgw_context_manager.h"
+#include "sgw_handler_gtpu.h"
+#include "sgw_downlink_data_notification.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -62,6 +64,55 @@ extern "C" {
 
 extern sgw_app_t                        sgw_app;
 
+//------------------------------------------------------------------------------
+int
+sgw_send_s11_downlink_data_notification (
+  s_plus_p_gw_eps_bearer_context_information_t * const ctx_p, const ebi_t ebi)
+{
+  OAILOG_FUNC_IN(LOG_SPGW_APP);
+  sgw_eps_bearer_context_information_t * const sgw_ctxt = &ctx_p->sgw_eps_bearer_context_information;
+  sgw_eps_bearer_ctxt_t *eps_bearer_ctxt_p = sgw_cm_get_eps_bearer_entry (&sgw_ctxt->pdn_connection, ebi);
+  int rc = RETURNerror;
+
+  if (!eps_bearer_ctxt_p) {
+    eps_bearer_ctxt_p = sgw_cm_get_eps_bearer_entry (&sgw_ctxt->pdn_connection, sgw_ctxt->pdn_connection.default_bearer);
+  }
+  MessageDef  *message_p = itti_alloc_new_message_sized (TASK_SPGW_APP, S11_DOWNLINK_DATA_NOTIFICATION,
+      sizeof(itti_s11_downlink_data_notification_t));
+
+  if (message_p) {
+    itti_s11_downlink_data_notification_t *s11_downlink_data_notification = S11_DOWNLINK_DATA_NOTIFICATION(message_p);
+
+    // bearer that received the downlink data
+    s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_EPS_BEARER_ID;
+    s11_downlink_data_notification->ebi = (eps_bearer_ctxt_p) ? eps_bearer_ctxt_p->eps_bearer_id : sgw_ctxt->pdn_connection.default_bearer;
+
+    // ARP
+    if (eps_bearer_ctxt_p) {
+      s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_ARP;
+      s11_downlink_data_notification->arp.pre_emp_capability = eps_bearer_ctxt_p->eps_bearer_qos.pci;
+      s11_downlink_data_notification->arp.pre_emp_vulnerability = eps_bearer_ctxt_p->eps_bearer_qos.pvi;
+      s11_downlink_data_notification->arp.priority_level = eps_bearer_ctxt_p->eps_bearer_qos.pl;
+    }
+
+    // IMSI
+    s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_IMSI;
+    s11_downlink_data_notification->imsi = sgw_ctxt->imsi;
+
+    s11_downlink_data_notification->teid = sgw_ctxt->mme_teid_S11;
+
+    //s11_create_bearer_request->trxn = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn;
+    s11_downlink_data_notification->peer_ip.s_addr = sgw_ctxt->mme_ip_address_S11.address.ipv4_address.s_addr;
+    s11_downlink_data_notification->local_teid = sgw_ctxt->s_gw_teid_S11_S4;
+    OAILOG_DEBUG (LOG_SPGW_APP,
+        "Tx DOWNLINK_DATA_NOTIFICATION -> TASK_S11, S11 MME teid "TEID_FMT" S11 S-GW teid "TEID_FMT"\n",
+        s11_downlink_data_notification->teid,
+        s11_downlink_data_notification->local_teid);
+    rc = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  }
+  OAILOG_FUNC_RETURN(LOG_SPGW_APP, rc);
+}
+
 //------------------------------------------------------------------------------
 int
 sgw_handle_gtpu_downlink_data_notification (
@@ -82,39 +133,11 @@ sgw_handle_gtpu_downlink_data_notification (
     hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, s11lteid, (void **)&s_plus_p_gw_eps_bearer_ctxt_info_p);
 
     if (HASH_TABLE_OK == hash_rc) {
-      MessageDef  *message_p = itti_alloc_new_message_sized (TASK_SPGW_APP, S11_DOWNLINK_DATA_NOTIFICATION,
-          sizeof(itti_s11_downlink_data_notification_t));
-
-      if (message_p) {
-        itti_s11_downlink_data_notification_t *s11_downlink_data_notification = S11_DOWNLINK_DATA_NOTIFICATION(message_p);
-
-        // TODO EBI
-        s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_EPS_BEARER_ID;
-        //s11_downlink_data_notification->ebi = gtpu_dl_data_notif->eps_bearer_id;
-        s11_downlink_data_notification->ebi = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.default_bearer;
-
-        // ARP
-        s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_ARP;
-        s11_downlink_data_notification->arp.pre_emp_capability = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[0]->eps_bearer_qos.pci;
-        s11_downlink_data_notification->arp.pre_emp_vulnerability = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[0]->eps_bearer_qos.pvi;
-        s11_downlink_data_notification->arp.priority_level = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[0]->eps_bearer_qos.pl;
-
-        // IMSI
-        s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_IMSI;
-        s11_downlink_data_notification->imsi = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi;
-
-        s11_downlink_data_notification->teid = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.mme_teid_S11;
-
-        //s11_create_bearer_request->trxn = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn;
-        s11_downlink_data_notification->peer_ip.s_addr = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.mme_ip_address_S11.address.ipv4_address.s_addr;
-        s11_downlink_data_notification->local_teid = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.s_gw_teid_S11_S4;
-        OAILOG_DEBUG (LOG_SPGW_APP,
-            "Tx DOWNLINK_DATA_NOTIFICATION -> TASK_S11, S11 MME teid "TEID_FMT" S11 S-GW teid "TEID_FMT"\n",
-            s11_downlink_data_notification->teid,
-            s11_downlink_data_notification->local_teid);
-        rc = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
-        OAILOG_FUNC_RETURN(LOG_SPGW_APP, rc);
+      // the user plane triggers once per clamping period, a DDN may already be pending, delayed or throttled
+      if (!sgw_ddn_check (s_plus_p_gw_eps_bearer_ctxt_info_p, gtpu_dl_data_notif->eps_bearer_id)) {
+        OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
       }
+      rc = sgw_send_s11_downlink_data_notification (s_plus_p_gw_eps_bearer_ctxt_info_p, gtpu_dl_data_notif->eps_bearer_id);
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, rc);
     }
 #if DEBUG_IS_ON
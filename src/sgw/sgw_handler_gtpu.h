@@ -30,11 +30,14 @@
 #define FILE_SGW_HANDLER_GTPU_SEEN
 
 #include "gtpv1_u_messages_types.h"
+#include "sgw_context_manager.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+int sgw_send_s11_downlink_data_notification (s_plus_p_gw_eps_bearer_context_information_t * const ctx_p, const ebi_t ebi);
+
 int sgw_handle_gtpu_downlink_data_notification (const Gtpv1uDownlinkDataNotification * const gtpu_dl_data_notif);
 
 #ifdef __cplusplus
@@ -64,6 +64,7 @@
 #include "async_system.h"
 #include "ip_forward_messages_types.h"
 #include "s11_messages_types.h"
+#include "sgw_downlink_data_notification.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -77,8 +78,7 @@ static uint32_t                         g_gtpv1u_teid = 0;
 //------------------------------------------------------------------------------
 uint32_t sgw_get_new_s1u_teid (void)
 {
-  __sync_fetch_and_add(&g_gtpv1u_teid, 1);
-  return g_gtpv1u_teid;
+  return __sync_add_and_fetch(&g_gtpv1u_teid, 1);
 }
 
 
@@ -170,7 +170,7 @@ sgw_handle_create_session_request (
     if (session_req_pP->apn) {
       s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.apn_in_use = strdup (session_req_pP->apn);
     } else {
-      s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.apn_in_use = "NO APN";
+      s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.apn_in_use = strdup ("NO APN");
     }
 
     s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.default_bearer = session_req_pP->bearer_contexts_to_be_created.bearer_contexts[0].eps_bearer_id;
@@ -685,11 +685,15 @@ sgw_handle_sgi_endpoint_updated (
 #elif ENABLE_OPENFLOW
       imsi_t imsi = new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi;
       rv = gtp_tunnel_ops->add_tunnel(ue, enb, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, eps_bearer_ctxt_p->enb_teid_S1u, resp_pP->eps_bearer_id, imsi, pgw_pcef_get_rule_by_id(SDF_ID_NGBR_DEFAULT));
+#elif ENABLE_USERSPACE_GTPU
+      rv = gtp_tunnel_ops->add_tunnel(ue, enb, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, eps_bearer_ctxt_p->enb_teid_S1u, resp_pP->eps_bearer_id);
 #endif
 
       if (rv < 0) {
         OAILOG_ERROR (LOG_SPGW_APP, "ERROR in setting up TUNNEL err=%d\n", rv);
       }
+      // user plane re-established, buffered packets flushed by the tunnel backend
+      sgw_ddn_stop (&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information);
 
 #if ENABLE_LIBGTPNL
       bstring marking_command = bformat(
@@ -803,6 +807,8 @@ sgw_handle_sgi_endpoint_deleted (
           OAILOG_ERROR (LOG_SPGW_APP, "ERROR in deleting TUNNEL\n");
         }
       }
+#elif ENABLE_USERSPACE_GTPU
+      rv = gtp_tunnel_ops->del_tunnel(eps_bearer_ctxt_p->paa.ipv4_address, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, eps_bearer_ctxt_p->enb_teid_S1u);
 #endif
 
     }
@@ -836,6 +842,9 @@ sgw_handle_modify_bearer_request (
       new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.default_bearer =
           modify_bearer_pP->bearer_contexts_to_be_modified.bearer_contexts[0].eps_bearer_id;
       new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn = modify_bearer_pP->trxn;
+      if (S11_MODIFY_BEARER_REQUEST_PR_IE_DELAY_DOWNLINK_PACKET_NOTIFICATION_REQUEST & modify_bearer_pP->ie_presence_mask) {
+        sgw_ddn_set_delay (&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information, modify_bearer_pP->delay_dl_packet_notif_req);
+      }
 
       eps_bearer_ctxt_p =
           sgw_cm_get_eps_bearer_entry(&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection,
@@ -962,7 +971,7 @@ sgw_handle_delete_session_request (
         if (eps_bearer_ctxt_p) {
           if (ebi != delete_session_req_pP->lbi) {
             sgw_deregister_paging_paa(&eps_bearer_ctxt_p->paa);
-#if ENABLE_LIBGTPNL
+#if ENABLE_LIBGTPNL || ENABLE_USERSPACE_GTPU
             rv = gtp_tunnel_ops->del_tunnel(eps_bearer_ctxt_p->paa.ipv4_address, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, eps_bearer_ctxt_p->enb_teid_S1u);
             if (rv < 0) {
               OAILOG_ERROR (LOG_SPGW_APP, "ERROR in deleting TUNNEL " TEID_FMT " (eNB) <-> (SGW) " TEID_FMT "\n",
@@ -992,9 +1001,9 @@ sgw_handle_delete_session_request (
 
       eps_bearer_ctxt_p = sgw_cm_get_eps_bearer_entry(&ctx_p->sgw_eps_bearer_context_information.pdn_connection, delete_session_req_pP->lbi);
       if (eps_bearer_ctxt_p) {
-        if (spgw_config.pgw_config.use_gtp_kernel_module) {
+        if (GTPV1U_REALIZATION_NONE != spgw_config.pgw_config.gtpv1u_realization) {
           sgw_deregister_paging_paa(&eps_bearer_ctxt_p->paa);
-#if ENABLE_LIBGTPNL
+#if ENABLE_LIBGTPNL || ENABLE_USERSPACE_GTPU
           rv = gtp_tunnel_ops->del_tunnel(eps_bearer_ctxt_p->paa.ipv4_address, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, eps_bearer_ctxt_p->enb_teid_S1u);
           if (rv < 0) {
             OAILOG_ERROR (LOG_SPGW_APP, "ERROR in deleting TUNNEL " TEID_FMT " (eNB) <-> (SGW) " TEID_FMT "\n",
@@ -1133,12 +1142,18 @@ sgw_handle_release_access_bearers_request (
             OAILOG_ERROR (LOG_SPGW_APP, "ERROR in deleting TUNNEL\n");
           }
         }
+#elif ENABLE_USERSPACE_GTPU
+        rv = gtp_tunnel_ops->del_tunnel(eps_bearer_ctxt->paa.ipv4_address, INVALID_TEID, eps_bearer_ctxt->enb_teid_S1u);
+        if (rv < 0) {
+          OAILOG_ERROR (LOG_SPGW_APP, "ERROR in releasing TUNNEL\n");
+        }
 #endif
         sgw_release_all_enb_related_information(eps_bearer_ctxt);
       }
     }
-    // TODO The S-GW starts buffering downlink packets received for the UE
-    // (set target on GTPUSP to order the buffering)
+    // The S-GW starts buffering downlink packets received for the UE (userspace GTP-U backend),
+    // DL data notifications restart from a clean state
+    sgw_ddn_stop (&ctx_p->sgw_eps_bearer_context_information);
     MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_RELEASE_ACCESS_BEARERS_RESPONSE S11 MME teid " TEID_FMT " cause REQUEST_ACCEPTED", release_access_bearers_resp_p->teid);
     rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
 
@@ -1180,7 +1195,7 @@ int sgw_no_pcef_create_dedicated_bearer(s11_teid_t teid)
       //s11_create_bearer_request->pti;
       OAILOG_DEBUG (LOG_SPGW_APP, "Creating bearer teid " TEID_FMT " remote teid " TEID_FMT "\n", teid, s11_create_bearer_request->teid);
 
-      sgw_eps_bearer_ctxt_t *eps_bearer_ctxt_p  = calloc (1, sizeof (sgw_eps_bearer_ctxt_t));
+      sgw_eps_bearer_ctxt_t *eps_bearer_ctxt_p  = sgw_cm_create_eps_bearer_context ();
       sgw_eps_bearer_ctxt_t *default_eps_bearer_entry_p =
                 sgw_cm_get_eps_bearer_entry(&s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection,
                     s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.default_bearer);
@@ -1294,12 +1309,14 @@ sgw_handle_create_bearer_response (
                   struct in_addr ue = {.s_addr = 0};
                   ue.s_addr = eps_bearer_ctxt_p->paa.ipv4_address.s_addr;
 
-                  if (spgw_config.pgw_config.use_gtp_kernel_module) {
+                  if (GTPV1U_REALIZATION_NONE != spgw_config.pgw_config.gtpv1u_realization) {
 #if ENABLE_LIBGTPNL
                     rv = gtp_tunnel_ops->add_tunnel(ue, enb, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, eps_bearer_ctxt_p->enb_teid_S1u, eps_bearer_ctxt_p->eps_bearer_id);
 #elif ENABLE_OPENFLOW
                     imsi_t imsi = ctx_p->sgw_eps_bearer_context_information.imsi;
                     rv = gtp_tunnel_ops->add_tunnel(ue, enb, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, eps_bearer_ctxt_p->enb_teid_S1u, eps_bearer_ctxt_p->eps_bearer_id, imsi, pgw_pcef_get_rule_by_id(pgw_ni_cbr_proc->sdf_id));
+#elif ENABLE_USERSPACE_GTPU
+                    rv = gtp_tunnel_ops->add_tunnel(ue, enb, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, eps_bearer_ctxt_p->enb_teid_S1u, eps_bearer_ctxt_p->eps_bearer_id);
 #endif
                     if (rv < 0) {
                       OAILOG_ERROR (LOG_SPGW_APP, "ERROR in setting up TUNNEL err=%d\n", rv);
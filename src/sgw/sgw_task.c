@@ -48,9 +48,11 @@
 #include "common_defs.h"
 #include "intertask_interface.h"
 #include "itti_free_defined_msg.h"
+#include "timer_messages_types.h"
 #include "sgw_ie_defs.h"
 #include "3gpp_23.401.h"
 #include "sgw_defs.h"
+#include "sgw_context_manager.h"
 #include "sgw_handlers.h"
 #include "sgw_handler_gtpu.h"
 #include "sgw_downlink_data_notification.h"
@@ -72,17 +74,52 @@ pgw_app_t                               pgw_app;
 
 extern __pid_t g_pid;
 
+static const task_id_t sgw_worker_tasks[SPGW_APP_WORKERS_MAX] = {
+    TASK_SPGW_APP,   TASK_SPGW_APP_1, TASK_SPGW_APP_2, TASK_SPGW_APP_3,
+    TASK_SPGW_APP_4, TASK_SPGW_APP_5, TASK_SPGW_APP_6, TASK_SPGW_APP_7};
+static uint32_t          sgw_workers = 1;
+static uint32_t          sgw_next_worker = 0;
+static uint32_t          sgw_exited_workers = 0;
+static __thread uint32_t sgw_worker = 0;
+
 static void sgw_exit(void);
 
+//------------------------------------------------------------------------------
+task_id_t sgw_task_for_s11_teid(const teid_t local_s11_teid)
+{
+  if (1 == sgw_workers) {
+    return TASK_SPGW_APP;
+  }
+  if (0 == local_s11_teid) {
+    return sgw_worker_tasks[__sync_fetch_and_add (&sgw_next_worker, 1) % sgw_workers];
+  }
+  return sgw_worker_tasks[local_s11_teid % sgw_workers];
+}
+
+//------------------------------------------------------------------------------
+uint32_t sgw_worker_index(void)
+{
+  return sgw_worker;
+}
+
+//------------------------------------------------------------------------------
+uint32_t sgw_worker_count(void)
+{
+  return sgw_workers;
+}
+
 //------------------------------------------------------------------------------
 static void *sgw_intertask_interface (void *args_p)
 {
-  itti_mark_task_ready (TASK_SPGW_APP);
+  const task_id_t task_id = sgw_worker_tasks[(uintptr_t)args_p];
+
+  sgw_worker = (uint32_t)(uintptr_t)args_p;
+  itti_mark_task_ready (task_id);
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
 
-    itti_receive_msg (TASK_SPGW_APP, &received_message_p);
+    itti_receive_msg (task_id, &received_message_p);
 
     switch (ITTI_MSG_ID (received_message_p)) {
     case GTPV1U_CREATE_TUNNEL_RESP:{
@@ -106,6 +143,13 @@ static void *sgw_intertask_interface (void *args_p)
     }
     break;
 
+    case TIMER_HAS_EXPIRED:{
+      // only timer of this task: delayed DL data notification, arg is the local S11 teid
+      sgw_handle_ddn_delay_timer_expiry ((teid_t)(uintptr_t)TIMER_HAS_EXPIRED(received_message_p)->arg,
+          TIMER_HAS_EXPIRED(received_message_p)->timer_id);
+    }
+    break;
+
     case GTPV1U_UPDATE_TUNNEL_RESP:{
         sgw_handle_gtpv1uUpdateTunnelResp (GTPV1U_UPDATE_TUNNEL_RESP(received_message_p));
       }
@@ -184,7 +228,10 @@ static void *sgw_intertask_interface (void *args_p)
       break;
 
     case TERMINATE_MESSAGE:{
-        sgw_exit();
+        // shared tables are released once, by the last worker leaving them
+        if (sgw_workers == __sync_add_and_fetch (&sgw_exited_workers, 1)) {
+          sgw_exit();
+        }
         itti_exit_task ();
       }
       break;
@@ -227,11 +274,11 @@ int sgw_init (spgw_config_t *spgw_config_pP)
   }
 
   bassigncstr(b, "ip2s11teid_hashtable");
-  sgw_app.ip2s11teid = obj_hashtable_uint64_ts_create (512, NULL, NULL, b);
+  sgw_app.ip2s11teid = hashtable_uint64_ts_create (512, NULL, b);
   btrunc(b, 0);
 
   if (sgw_app.ip2s11teid == NULL) {
-    perror ("obj_hashtable_uint64_ts_create");
+    perror ("hashtable_uint64_ts_create");
     bdestroy_wrapper (&b);
     OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
     return RETURNerror;
@@ -271,10 +318,16 @@ int sgw_init (spgw_config_t *spgw_config_pP)
   }
 #endif
 
-  if (itti_create_task (TASK_SPGW_APP, &sgw_intertask_interface, NULL) < 0) {
-    perror ("pthread_create");
-    OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
-    return RETURNerror;
+  sgw_workers = spgw_config_pP->sgw_config.itti_config.spgw_app_workers;
+  if ((sgw_workers < 1) || (sgw_workers > SPGW_APP_WORKERS_MAX)) {
+    sgw_workers = 1;
+  }
+  for (uintptr_t worker = 0; worker < sgw_workers; worker++) {
+    if (itti_create_task (sgw_worker_tasks[worker], &sgw_intertask_interface, (void*)worker) < 0) {
+      perror ("pthread_create");
+      OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
+      return RETURNerror;
+    }
   }
 
   FILE *fp = NULL;
@@ -297,7 +350,7 @@ static void sgw_exit(void)
     hashtable_ts_destroy (sgw_app.s11teid2mme_hashtable);
   }
   if (sgw_app.ip2s11teid) {
-    obj_hashtable_uint64_ts_destroy (sgw_app.ip2s11teid);
+    hashtable_uint64_ts_destroy (sgw_app.ip2s11teid);
   }
   /*if (sgw_app.s1uteid2enb_hashtable) {
     hashtable_destroy (sgw_app.s1uteid2enb_hashtable);
@@ -305,6 +358,8 @@ static void sgw_exit(void)
   if (sgw_app.s11_bearer_context_information_hashtable) {
     hashtable_ts_destroy (sgw_app.s11_bearer_context_information_hashtable);
   }
+  // after the last bearer and session context is freed
+  sgw_cm_slab_exit ();
 
   //P-GW code
   struct conf_ipv4_list_elm_s   *conf_ipv4_p = NULL;
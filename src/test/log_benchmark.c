@@ -0,0 +1,134 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file log_benchmark.c
+   \brief Cost of a log call on the logging thread: bstring formatting path (OUTPUT to /dev/null)
+   versus the deferred binary backend (BINARY_OUTPUT).
+   Usage: log_benchmark [nb_threads] [nb_messages_per_thread] [binary_log_file]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "shared_ts_log.h"
+
+#define LOG_BENCHMARK_THREADS_MAX 64
+
+static long                               nb_messages = 200000;
+
+//------------------------------------------------------------------------------
+static void * log_benchmark_thread (__attribute__ ((unused)) void *args)
+{
+  const uint64_t                          imsi64 = 208950000000001;
+
+  for (long i = 0; i < nb_messages; i++) {
+    // typical MME-APP line
+    OAILOG_INFO (LOG_MME_APP, "UE " "%06" PRIX32 " imsi " "%" PRIu64 " enb_ue_s1ap_id %06x state %s bearers %d\n",
+        (uint32_t)i, imsi64 + i, (unsigned int)i & 0x00FFFFFF, (i & 1) ? "ECM_CONNECTED" : "ECM_IDLE", (int)(i % 11));
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static double log_benchmark_run (const int nb_threads)
+{
+  pthread_t                               threads[LOG_BENCHMARK_THREADS_MAX];
+  struct timespec                         start, end;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int t = 0; t < nb_threads; t++) {
+    pthread_create (&threads[t], NULL, log_benchmark_thread, NULL);
+  }
+  for (int t = 0; t < nb_threads; t++) {
+    pthread_join (threads[t], NULL);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / ((double)nb_messages * nb_threads);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  int                                     nb_threads = 4;
+  const char                             *binary_file = "/tmp/log_benchmark.blog";
+  log_config_t                            config;
+  double                                  ns_text = 0;
+  double                                  ns_binary = 0;
+
+  if (argc > 1) nb_threads = atoi (argv[1]);
+  if (argc > 2) nb_messages = atol (argv[2]);
+  if (argc > 3) binary_file = argv[3];
+  if ((nb_threads < 1) || (nb_threads > LOG_BENCHMARK_THREADS_MAX) || (nb_messages < 1)) {
+    fprintf (stderr, "Usage: %s [nb_threads (1..%d)] [nb_messages_per_thread] [binary_log_file]\n", argv[0], LOG_BENCHMARK_THREADS_MAX);
+    return EXIT_FAILURE;
+  }
+
+  shared_log_init (nb_threads + 1);
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_DEBUG, nb_threads + 1);
+
+  // current path: formatted in bstrings by the logging thread, written unbuffered
+  memset (&config, 0, sizeof (config));
+  // keep the levels set by log_init()
+  config.udp_log_level = MAX_LOG_LEVEL;
+  config.gtpv1u_log_level = MAX_LOG_LEVEL;
+  config.gtpv2c_log_level = MAX_LOG_LEVEL;
+  config.sctp_log_level = MAX_LOG_LEVEL;
+  config.s1ap_log_level = MAX_LOG_LEVEL;
+  config.nas_log_level = MAX_LOG_LEVEL;
+  config.mme_app_log_level = MAX_LOG_LEVEL;
+  config.spgw_app_log_level = MAX_LOG_LEVEL;
+  config.s10_log_level = MAX_LOG_LEVEL;
+  config.s11_log_level = MAX_LOG_LEVEL;
+  config.s6a_log_level = MAX_LOG_LEVEL;
+  config.secu_log_level = MAX_LOG_LEVEL;
+  config.util_log_level = MAX_LOG_LEVEL;
+  config.msc_log_level = MAX_LOG_LEVEL;
+  config.xml_log_level = MAX_LOG_LEVEL;
+  config.mme_scenario_player_log_level = MAX_LOG_LEVEL;
+  config.async_system_log_level = MAX_LOG_LEVEL;
+  config.itti_log_level = MAX_LOG_LEVEL;
+  config.output = bfromcstr ("/dev/null");
+  config.is_output_thread_safe = false;
+  config.color = false;
+  log_set_config (&config);
+  ns_text = log_benchmark_run (nb_threads);
+
+  // binary backend
+  config.binary_output = bfromcstr (binary_file);
+  log_set_config (&config);
+  ns_binary = log_benchmark_run (nb_threads);
+
+  log_exit ();
+  bdestroy (config.output);
+  bdestroy (config.binary_output);
+
+  fprintf (stdout, "%d threads x %ld messages\n", nb_threads, nb_messages);
+  fprintf (stdout, "  bstring formatting : %8.1f ns/message\n", ns_text);
+  fprintf (stdout, "  binary backend     : %8.1f ns/message (decode %s with oai_log_decode, dropped messages are reported there)\n", ns_binary, binary_file);
+  return EXIT_SUCCESS;
+}
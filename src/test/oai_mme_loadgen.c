@@ -0,0 +1,680 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file oai_mme_loadgen.c
+   \brief S1 signalling load generator, see oai_mme_loadgen.h.
+   First phase: all the UEs attach at the attach rate, then go ECM-IDLE after the hold time.
+   Second phase: for the duration, a weighted mix of attach, detach, TAU and service request is started
+   at the rate on UEs picked at random, the paging comes from the downlink data notifications of the
+   S-GW stub. Prints the throughput every second and the latency percentiles of each phase.
+   The MME runs with BENCHMARK.STUB_HSS and BENCHMARK.STUB_SGW, its TAI list and GUMMEI match -m -n -t,
+   MAX_ENB and MAX_UE are above -e and -u.
+   Usage: oai_mme_loadgen -h
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+
+#include "bstrlib.h"
+#include "hashtable.h"
+#include "log.h"
+#include "shared_ts_log.h"
+#include "oai_mme_loadgen.h"
+
+#define LOADGEN_EPOLL_EVENTS              64
+#define LOADGEN_PICK_TRIES                64
+#define LOADGEN_S1_SETUP_TIMEOUT_MS       5000
+#define LOADGEN_NS_PER_MS                 UINT64_C(1000000)
+#define LOADGEN_NS_PER_SEC                UINT64_C(1000000000)
+
+loadgen_t                                 loadgen = {
+  .mme_address = "127.0.0.1",
+  .mme_port = LOADGEN_S1AP_PORT,
+  .nb_enbs = 16,
+  .nb_ues = 10000,
+  .first_imsi64 = UINT64_C(208930000000001),
+  .tac = 1,
+  .attach_rate = 500,
+  .rate = 1000,
+  .duration_sec = 60,
+  .hold_ms = 500,
+  .timeout_ms = 5000,
+  .weights = {5, 5, 20, 70},
+};
+
+static const char * const                 loadgen_procedure_names[LOADGEN_PROC_MAX] = {
+  "attach", "detach", "tau", "service_request", "paging", "s1_release"
+};
+
+static TAILQ_HEAD(loadgen_timeout_list_s, loadgen_ue_s) loadgen_timeout_list = TAILQ_HEAD_INITIALIZER(loadgen_timeout_list);
+static TAILQ_HEAD(loadgen_release_list_s, loadgen_ue_s) loadgen_release_list = TAILQ_HEAD_INITIALIZER(loadgen_release_list);
+
+static int                                loadgen_epoll_fd = -1;
+static uint64_t                           loadgen_random_state = UINT64_C(0x2545F4914F6CDD1D);
+static uint32_t                           loadgen_nb_s1_setups = 0;
+static bool                               loadgen_s1_setup_failed = false;
+static uint64_t                           loadgen_last_succeeded[LOADGEN_PROC_MAX] = {0};
+
+//------------------------------------------------------------------------------
+uint64_t loadgen_now_ns (void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * LOADGEN_NS_PER_SEC + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+// xorshift64*, the runs are reproducible with -s
+static uint64_t loadgen_random (void)
+{
+  loadgen_random_state ^= loadgen_random_state >> 12;
+  loadgen_random_state ^= loadgen_random_state << 25;
+  loadgen_random_state ^= loadgen_random_state >> 27;
+  return loadgen_random_state * UINT64_C(2685821657736338717);
+}
+
+//------------------------------------------------------------------------------
+loadgen_ue_t *loadgen_ue_get (const uint32_t enb_ue_s1ap_id)
+{
+  const uint32_t                          index = enb_ue_s1ap_id & (LOADGEN_UES_MAX - 1);
+
+  if (index >= loadgen.nb_ues) {
+    return NULL;
+  }
+  loadgen_ue_t * const ue = &loadgen.ues[index];
+  // messages for a previous S1 connection of the UE are dropped
+  if (!ue->connected || (ue->enb_ue_s1ap_id != enb_ue_s1ap_id)) {
+    return NULL;
+  }
+  return ue;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_set_mme_ue_s1ap_id (loadgen_ue_t * const ue, const uint32_t mme_ue_s1ap_id)
+{
+  ue->mme_ue_s1ap_id = mme_ue_s1ap_id;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_ue_clear_guti (loadgen_ue_t * const ue)
+{
+  loadgen_ue_t                           *other = NULL;
+
+  if (!ue->has_guti) {
+    return;
+  }
+  // the M-TMSI may have been reallocated to another UE meanwhile
+  if ((hashtable_get (loadgen.ue_by_m_tmsi, ue->m_tmsi, (void **)&other) == HASH_TABLE_OK) && (other == ue)) {
+    hashtable_remove (loadgen.ue_by_m_tmsi, ue->m_tmsi, (void **)&other);
+  }
+  ue->has_guti = false;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_set_guti (loadgen_ue_t * const ue, const uint8_t guti[10])
+{
+  loadgen_ue_clear_guti (ue);
+  memcpy (ue->guti, guti, sizeof (ue->guti));
+  ue->m_tmsi = ((uint32_t)guti[6] << 24) | ((uint32_t)guti[7] << 16) | ((uint32_t)guti[8] << 8) | guti[9];
+  ue->has_guti = true;
+  hashtable_insert (loadgen.ue_by_m_tmsi, ue->m_tmsi, ue);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_ue_connect (loadgen_ue_t * const ue)
+{
+  ue->generation++;
+  ue->enb_ue_s1ap_id = LOADGEN_ENB_UE_S1AP_ID (ue);
+  ue->mme_ue_s1ap_id = 0;               // known with the first downlink message
+  ue->connected = true;
+  loadgen.nb_connected++;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_ue_disconnect (loadgen_ue_t * const ue)
+{
+  if (ue->in_release_list) {
+    TAILQ_REMOVE (&loadgen_release_list, ue, release_entry);
+    ue->in_release_list = false;
+  }
+  if (ue->connected) {
+    ue->connected = false;
+    loadgen.nb_connected--;
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_deregister (loadgen_ue_t * const ue)
+{
+  loadgen_ue_clear_guti (ue);
+  ue->registered = false;
+  ue->security.active = false;
+  ue->security.ksi = LOADGEN_NAS_KSI_NONE;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_ue_procedure_start (loadgen_ue_t * const ue, const loadgen_procedure_t procedure, const uint64_t now_ns)
+{
+  ue->procedure = procedure;
+  ue->procedure_start_ns = now_ns;
+  // same timeout for all the procedures: the list stays sorted by deadline
+  ue->deadline_ns = now_ns + loadgen.timeout_ms * LOADGEN_NS_PER_MS;
+  TAILQ_INSERT_TAIL (&loadgen_timeout_list, ue, timeout_entry);
+  ue->in_timeout_list = true;
+  loadgen.nb_pending++;
+  loadgen.stats[procedure].started++;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_procedure_end (loadgen_ue_t * const ue, const loadgen_procedure_t procedure, const loadgen_result_t result)
+{
+  loadgen_procedure_stats_t              *stats = NULL;
+  const uint64_t                          now_ns = loadgen_now_ns ();
+
+  if ((LOADGEN_PROC_NONE == procedure) || (ue->procedure != procedure)) {
+    loadgen.unexpected_messages++;
+    return;
+  }
+  stats = &loadgen.stats[procedure];
+  if (ue->in_timeout_list) {
+    TAILQ_REMOVE (&loadgen_timeout_list, ue, timeout_entry);
+    ue->in_timeout_list = false;
+  }
+  ue->procedure = LOADGEN_PROC_NONE;
+  loadgen.nb_pending--;
+
+  if (LOADGEN_RESULT_SUCCESS == result) {
+    const uint64_t                        latency_us = (now_ns - ue->procedure_start_ns) / 1000;
+
+    stats->succeeded++;
+    stats->latency.buckets[mme_stats_histogram_index (latency_us)]++;
+    stats->latency.sum_us += latency_us;
+    if (latency_us > stats->max_us) {
+      stats->max_us = latency_us;
+    }
+    if (ue->connected && (LOADGEN_PROC_S1_RELEASE != procedure) && !ue->in_release_list) {
+      ue->release_ns = now_ns + loadgen.hold_ms * LOADGEN_NS_PER_MS;
+      TAILQ_INSERT_TAIL (&loadgen_release_list, ue, release_entry);
+      ue->in_release_list = true;
+    }
+    return;
+  }
+
+  if (LOADGEN_RESULT_REJECTED == result) {
+    stats->rejected++;
+  } else {
+    stats->timed_out++;
+  }
+  if (loadgen.verbose) {
+    fprintf (stderr, "UE %" PRIu64 " %s %s\n", ue->imsi64, loadgen_procedure_names[procedure],
+        (LOADGEN_RESULT_REJECTED == result) ? "rejected" : "timed out");
+  }
+  // start again from scratch, the next procedure of the UE is an attach
+  if (ue->connected) {
+    loadgen_s1ap_send_ue_context_release_request (ue);
+    loadgen_ue_disconnect (ue);
+  }
+  loadgen_ue_deregister (ue);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_ue_start (loadgen_ue_t * const ue, const loadgen_procedure_t procedure, const uint64_t now_ns)
+{
+  loadgen_ue_connect (ue);
+  loadgen_ue_procedure_start (ue, procedure, now_ns);
+  switch (procedure) {
+  case LOADGEN_PROC_ATTACH:
+    loadgen_nas_send_attach_request (ue);
+    break;
+  case LOADGEN_PROC_DETACH:
+    loadgen_nas_send_detach_request (ue);
+    break;
+  case LOADGEN_PROC_TAU:
+    loadgen_nas_send_tau_request (ue);
+    break;
+  case LOADGEN_PROC_SERVICE_REQUEST:
+    loadgen_nas_send_service_request (ue, false);
+    break;
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_enb_s1_setup_result (loadgen_enb_t * const enb, const bool success)
+{
+  if (enb->s1_setup_done) {
+    return;
+  }
+  enb->s1_setup_done = true;
+  loadgen_nb_s1_setups++;
+  if (!success) {
+    fprintf (stderr, "S1 setup of eNB %u rejected by the MME\n", enb->enb_id);
+    loadgen_s1_setup_failed = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_initial_context_setup (loadgen_ue_t * const ue, const uint8_t * const nas_pdu, const int nas_length, const uint8_t * const ebis, const int nb_ebis)
+{
+  const loadgen_procedure_t               procedure = ue->procedure;
+
+  if (nas_pdu) {
+    // the attach accept
+    loadgen_nas_handle_downlink (ue, nas_pdu, nas_length);
+    if (!ue->connected) {
+      return;
+    }
+  }
+  loadgen_s1ap_send_initial_context_setup_response (ue, ebis, nb_ebis);
+  if (LOADGEN_PROC_ATTACH == procedure) {
+    if (ue->registered) {
+      loadgen_nas_send_attach_complete (ue);
+    }
+  } else if ((LOADGEN_PROC_SERVICE_REQUEST == procedure) || (LOADGEN_PROC_PAGING == procedure)) {
+    loadgen_ue_procedure_end (ue, procedure, LOADGEN_RESULT_SUCCESS);
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_context_release_command (loadgen_ue_t * const ue)
+{
+  loadgen_ue_disconnect (ue);
+  if (LOADGEN_PROC_S1_RELEASE == ue->procedure) {
+    loadgen_ue_procedure_end (ue, LOADGEN_PROC_S1_RELEASE, LOADGEN_RESULT_SUCCESS);
+  } else if (LOADGEN_PROC_NONE != ue->procedure) {
+    // released by the MME in the middle of a procedure
+    loadgen_ue_procedure_end (ue, ue->procedure, LOADGEN_RESULT_REJECTED);
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_enb_paging (loadgen_enb_t * const enb, const uint32_t m_tmsi)
+{
+  loadgen_ue_t                           *ue = NULL;
+
+  if (hashtable_get (loadgen.ue_by_m_tmsi, m_tmsi, (void **)&ue) != HASH_TABLE_OK) {
+    return;
+  }
+  // the MME pages on all the eNBs of the tracking area, the UE only listens to its cell
+  if ((ue->enb != enb) || !ue->registered || ue->connected || (LOADGEN_PROC_NONE != ue->procedure)) {
+    return;
+  }
+  loadgen_ue_connect (ue);
+  loadgen_ue_procedure_start (ue, LOADGEN_PROC_PAGING, loadgen_now_ns ());
+  loadgen_nas_send_service_request (ue, true);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_expire (const uint64_t now_ns)
+{
+  loadgen_ue_t                           *ue = NULL;
+
+  while ((ue = TAILQ_FIRST (&loadgen_timeout_list)) && (ue->deadline_ns <= now_ns)) {
+    loadgen_ue_procedure_end (ue, ue->procedure, LOADGEN_RESULT_TIMEOUT);
+  }
+  while ((ue = TAILQ_FIRST (&loadgen_release_list)) && (ue->release_ns <= now_ns)) {
+    TAILQ_REMOVE (&loadgen_release_list, ue, release_entry);
+    ue->in_release_list = false;
+    if (ue->connected && (LOADGEN_PROC_NONE == ue->procedure)) {
+      loadgen_ue_procedure_start (ue, LOADGEN_PROC_S1_RELEASE, now_ns);
+      loadgen_s1ap_send_ue_context_release_request (ue);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_poll (const int timeout_ms)
+{
+  struct epoll_event                      events[LOADGEN_EPOLL_EVENTS];
+  int                                     n = epoll_wait (loadgen_epoll_fd, events, LOADGEN_EPOLL_EVENTS, timeout_ms);
+
+  for (int i = 0; i < n; i++) {
+    if (loadgen_s1ap_receive ((loadgen_enb_t *)events[i].data.ptr) < 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// UE of the given EMM state, ECM-IDLE and without ongoing procedure, close to a random index
+static loadgen_ue_t *loadgen_ue_pick (const bool registered)
+{
+  uint32_t                                index = loadgen_random () % loadgen.nb_ues;
+
+  for (int i = 0; i < LOADGEN_PICK_TRIES; i++) {
+    loadgen_ue_t * const ue = &loadgen.ues[index];
+
+    if ((ue->registered == registered) && !ue->connected && (LOADGEN_PROC_NONE == ue->procedure)) {
+      return ue;
+    }
+    if (++index == loadgen.nb_ues) {
+      index = 0;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static loadgen_procedure_t loadgen_mix_pick (void)
+{
+  uint32_t                                total = 0;
+  uint32_t                                r = 0;
+
+  for (int p = 0; p < LOADGEN_PROC_PAGING; p++) {
+    total += loadgen.weights[p];
+  }
+  r = loadgen_random () % total;
+  for (int p = 0; p < LOADGEN_PROC_PAGING; p++) {
+    if (r < loadgen.weights[p]) {
+      return (loadgen_procedure_t)p;
+    }
+    r -= loadgen.weights[p];
+  }
+  return LOADGEN_PROC_SERVICE_REQUEST;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_report_period (const uint64_t elapsed_ns)
+{
+  uint64_t                                failed = 0;
+
+  fprintf (stdout, "%5.1fs", (double)elapsed_ns / LOADGEN_NS_PER_SEC);
+  for (int p = 0; p < LOADGEN_PROC_MAX; p++) {
+    fprintf (stdout, " %s %" PRIu64 "/s", loadgen_procedure_names[p], loadgen.stats[p].succeeded - loadgen_last_succeeded[p]);
+    loadgen_last_succeeded[p] = loadgen.stats[p].succeeded;
+    failed += loadgen.stats[p].rejected + loadgen.stats[p].timed_out;
+  }
+  fprintf (stdout, " | pending %u connected %u failed %" PRIu64 "\n", loadgen.nb_pending, loadgen.nb_connected, failed);
+  fflush (stdout);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_report (const char * const phase, const uint64_t elapsed_ns)
+{
+  const double                            elapsed_sec = (double)elapsed_ns / LOADGEN_NS_PER_SEC;
+
+  fprintf (stdout, "\n%s: %.1f s, %" PRIu64 " unexpected messages, %" PRIu64 " send errors, %" PRIu64 " procedures skipped (no UE in the right state)\n",
+      phase, elapsed_sec, loadgen.unexpected_messages, loadgen.send_errors, loadgen.skipped);
+  fprintf (stdout, "%-16s %9s %9s %8s %8s %8s %9s %9s %9s %9s %9s\n",
+      "procedure", "started", "succeeded", "rejected", "timeout", "per sec", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+  for (int p = 0; p < LOADGEN_PROC_MAX; p++) {
+    const loadgen_procedure_stats_t * const stats = &loadgen.stats[p];
+    const uint64_t                        count = mme_stats_histogram_count (&stats->latency);
+
+    fprintf (stdout, "%-16s %9" PRIu64 " %9" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8.0f %9" PRIu64 " %9" PRIu64 " %9" PRIu64 " %9" PRIu64 " %9" PRIu64 "\n",
+        loadgen_procedure_names[p], stats->started, stats->succeeded, stats->rejected, stats->timed_out,
+        (elapsed_sec > 0) ? stats->succeeded / elapsed_sec : 0.0,
+        mme_stats_histogram_percentile (&stats->latency, count, 50),
+        mme_stats_histogram_percentile (&stats->latency, count, 90),
+        mme_stats_histogram_percentile (&stats->latency, count, 99),
+        mme_stats_histogram_percentile (&stats->latency, count, 99.9),
+        stats->max_us);
+  }
+  fprintf (stdout, "\n");
+  fflush (stdout);
+}
+
+//------------------------------------------------------------------------------
+// Runs until all the UEs are ECM-IDLE without procedure, or the drain timeout
+static int loadgen_drain (void)
+{
+  const uint64_t                          end_ns = loadgen_now_ns () + (2 * loadgen.timeout_ms + loadgen.hold_ms) * LOADGEN_NS_PER_MS;
+  uint64_t                                now_ns = 0;
+
+  while ((loadgen.nb_pending || loadgen.nb_connected) && ((now_ns = loadgen_now_ns ()) < end_ns)) {
+    loadgen_expire (now_ns);
+    if (loadgen_poll (1) < 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_attach_phase (void)
+{
+  const uint64_t                          start_ns = loadgen_now_ns ();
+  uint64_t                                report_ns = start_ns + LOADGEN_NS_PER_SEC;
+  uint32_t                                nb_started = 0;
+
+  while (nb_started < loadgen.nb_ues) {
+    const uint64_t                        now_ns = loadgen_now_ns ();
+    uint64_t                              target = ((now_ns - start_ns) * loadgen.attach_rate) / LOADGEN_NS_PER_SEC + 1;
+
+    if (target > loadgen.nb_ues) {
+      target = loadgen.nb_ues;
+    }
+    while (nb_started < target) {
+      loadgen_ue_start (&loadgen.ues[nb_started++], LOADGEN_PROC_ATTACH, now_ns);
+    }
+    loadgen_expire (now_ns);
+    if (now_ns >= report_ns) {
+      loadgen_report_period (now_ns - start_ns);
+      report_ns += LOADGEN_NS_PER_SEC;
+    }
+    if (loadgen_poll (1) < 0) {
+      return -1;
+    }
+  }
+  if (loadgen_drain () < 0) {
+    return -1;
+  }
+  loadgen_report ("Attach phase", loadgen_now_ns () - start_ns);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_mix_phase (void)
+{
+  const uint64_t                          start_ns = loadgen_now_ns ();
+  const uint64_t                          end_ns = start_ns + loadgen.duration_sec * LOADGEN_NS_PER_SEC;
+  uint64_t                                report_ns = start_ns + LOADGEN_NS_PER_SEC;
+  uint64_t                                nb_started = 0;
+  uint64_t                                now_ns = 0;
+
+  while ((now_ns = loadgen_now_ns ()) < end_ns) {
+    const uint64_t                        target = ((now_ns - start_ns) * loadgen.rate) / LOADGEN_NS_PER_SEC + 1;
+
+    while (nb_started < target) {
+      const loadgen_procedure_t           procedure = loadgen_mix_pick ();
+      loadgen_ue_t * const                ue = loadgen_ue_pick (LOADGEN_PROC_ATTACH != procedure);
+
+      nb_started++;
+      if (ue) {
+        loadgen_ue_start (ue, procedure, now_ns);
+      } else {
+        loadgen.skipped++;
+      }
+    }
+    loadgen_expire (now_ns);
+    if (now_ns >= report_ns) {
+      loadgen_report_period (now_ns - start_ns);
+      report_ns += LOADGEN_NS_PER_SEC;
+    }
+    if (loadgen_poll (1) < 0) {
+      return -1;
+    }
+  }
+  // the procedures in progress count in the phase, not the time to drain them
+  const uint64_t                          elapsed_ns = loadgen_now_ns () - start_ns;
+  if (loadgen_drain () < 0) {
+    return -1;
+  }
+  loadgen_report ("Mix phase", elapsed_ns);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_plmn_encode (const char * const mcc, const char * const mnc, uint8_t plmn[3])
+{
+  const size_t                            mnc_length = strlen (mnc);
+
+  if ((strlen (mcc) != 3) || (mnc_length < 2) || (mnc_length > 3)) {
+    return -1;
+  }
+  plmn[0] = ((mcc[1] - '0') << 4) | (mcc[0] - '0');
+  plmn[1] = (((mnc_length == 3) ? (mnc[2] - '0') : 0xF) << 4) | (mcc[2] - '0');
+  plmn[2] = ((mnc[1] - '0') << 4) | (mnc[0] - '0');
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_usage (const char * const name)
+{
+  fprintf (stderr, "Usage: %s [options]\n", name);
+  fprintf (stderr, "  -a address   MME S1-MME address (%s)\n", loadgen.mme_address);
+  fprintf (stderr, "  -p port      MME S1-MME SCTP port (%u)\n", loadgen.mme_port);
+  fprintf (stderr, "  -e eNBs      simulated eNBs, one SCTP association each (%u, max %u)\n", loadgen.nb_enbs, LOADGEN_ENBS_MAX);
+  fprintf (stderr, "  -u UEs       simulated UEs (%u, max %u)\n", loadgen.nb_ues, LOADGEN_UES_MAX);
+  fprintf (stderr, "  -i IMSI      IMSI of the first UE (%" PRIu64 ")\n", loadgen.first_imsi64);
+  fprintf (stderr, "  -m MCC -n MNC -t TAC   tracking area of the eNBs (208 93 %u)\n", loadgen.tac);
+  fprintf (stderr, "  -A rate      attaches per second of the attach phase (%u)\n", loadgen.attach_rate);
+  fprintf (stderr, "  -r rate      procedures per second of the mix phase (%u)\n", loadgen.rate);
+  fprintf (stderr, "  -d seconds   duration of the mix phase (%u)\n", loadgen.duration_sec);
+  fprintf (stderr, "  -x a:d:t:s   weights of attach, detach, TAU and service request in the mix (%u:%u:%u:%u)\n",
+      loadgen.weights[0], loadgen.weights[1], loadgen.weights[2], loadgen.weights[3]);
+  fprintf (stderr, "  -H ms        time a UE stays connected before the UE context release request (%u)\n", loadgen.hold_ms);
+  fprintf (stderr, "  -T ms        procedure timeout (%u)\n", loadgen.timeout_ms);
+  fprintf (stderr, "  -s seed      random seed\n");
+  fprintf (stderr, "  -v           print the failed procedures\n");
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  const char                             *mcc = "208";
+  const char                             *mnc = "93";
+  int                                     c = 0;
+
+  while ((c = getopt (argc, argv, "a:A:d:e:hH:i:m:n:p:r:s:t:T:u:vx:")) != -1) {
+    switch (c) {
+    case 'a': loadgen.mme_address = optarg; break;
+    case 'A': loadgen.attach_rate = atoi (optarg); break;
+    case 'd': loadgen.duration_sec = atoi (optarg); break;
+    case 'e': loadgen.nb_enbs = atoi (optarg); break;
+    case 'H': loadgen.hold_ms = atoi (optarg); break;
+    case 'i': loadgen.first_imsi64 = strtoull (optarg, NULL, 10); break;
+    case 'm': mcc = optarg; break;
+    case 'n': mnc = optarg; break;
+    case 'p': loadgen.mme_port = atoi (optarg); break;
+    case 'r': loadgen.rate = atoi (optarg); break;
+    case 's': loadgen_random_state = strtoull (optarg, NULL, 0) | 1; break;
+    case 't': loadgen.tac = atoi (optarg); break;
+    case 'T': loadgen.timeout_ms = atoi (optarg); break;
+    case 'u': loadgen.nb_ues = atoi (optarg); break;
+    case 'v': loadgen.verbose = true; break;
+    case 'x':
+      if (sscanf (optarg, "%u:%u:%u:%u", &loadgen.weights[0], &loadgen.weights[1], &loadgen.weights[2], &loadgen.weights[3]) != 4) {
+        loadgen_usage (argv[0]);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'h':
+    default:
+      loadgen_usage (argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if ((loadgen.nb_enbs < 1) || (loadgen.nb_enbs > LOADGEN_ENBS_MAX) || (loadgen.nb_ues < 1) || (loadgen.nb_ues > LOADGEN_UES_MAX) ||
+      (loadgen.attach_rate < 1) || (loadgen.rate < 1) || (loadgen.timeout_ms < 1) ||
+      (loadgen.weights[0] + loadgen.weights[1] + loadgen.weights[2] + loadgen.weights[3] == 0) ||
+      (loadgen_plmn_encode (mcc, mnc, loadgen.plmn) < 0)) {
+    loadgen_usage (argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // the S1AP library logs its encoding errors
+  shared_log_init (1);
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+
+  loadgen.enbs = calloc (loadgen.nb_enbs, sizeof (loadgen_enb_t));
+  loadgen.ues = calloc (loadgen.nb_ues, sizeof (loadgen_ue_t));
+  loadgen.ue_by_m_tmsi = hashtable_create (loadgen.nb_ues, NULL, hash_free_int_func, bfromcstr ("loadgen_ue_by_m_tmsi"));
+  loadgen_epoll_fd = epoll_create1 (0);
+  if (!loadgen.enbs || !loadgen.ues || !loadgen.ue_by_m_tmsi || (loadgen_epoll_fd < 0)) {
+    fprintf (stderr, "Initialization failed\n");
+    return EXIT_FAILURE;
+  }
+  for (uint32_t u = 0; u < loadgen.nb_ues; u++) {
+    loadgen_ue_t * const ue = &loadgen.ues[u];
+
+    ue->index = u;
+    ue->imsi64 = loadgen.first_imsi64 + u;
+    ue->enb = &loadgen.enbs[u % loadgen.nb_enbs];
+    ue->procedure = LOADGEN_PROC_NONE;
+    ue->security.ksi = LOADGEN_NAS_KSI_NONE;
+  }
+
+  for (uint32_t e = 0; e < loadgen.nb_enbs; e++) {
+    loadgen_enb_t * const enb = &loadgen.enbs[e];
+    struct epoll_event                    event = {.events = EPOLLIN, .data.ptr = enb};
+
+    enb->index = e;
+    enb->enb_id = e + 1;
+    if ((loadgen_s1ap_connect (enb) < 0) || (epoll_ctl (loadgen_epoll_fd, EPOLL_CTL_ADD, enb->sd, &event) < 0)) {
+      fprintf (stderr, "eNB %u: cannot connect to the MME %s:%u\n", enb->enb_id, loadgen.mme_address, loadgen.mme_port);
+      return EXIT_FAILURE;
+    }
+  }
+  const uint64_t                          s1_setup_end_ns = loadgen_now_ns () + LOADGEN_S1_SETUP_TIMEOUT_MS * LOADGEN_NS_PER_MS;
+  while ((loadgen_nb_s1_setups < loadgen.nb_enbs) && (loadgen_now_ns () < s1_setup_end_ns)) {
+    if (loadgen_poll (10) < 0) {
+      return EXIT_FAILURE;
+    }
+  }
+  if (loadgen_s1_setup_failed || (loadgen_nb_s1_setups < loadgen.nb_enbs)) {
+    fprintf (stderr, "%u/%u S1 setups done\n", loadgen_nb_s1_setups, loadgen.nb_enbs);
+    return EXIT_FAILURE;
+  }
+  fprintf (stdout, "%u eNBs connected to %s:%u, %u UEs from IMSI %" PRIu64 "\n",
+      loadgen.nb_enbs, loadgen.mme_address, loadgen.mme_port, loadgen.nb_ues, loadgen.first_imsi64);
+
+  if (loadgen_attach_phase () < 0) {
+    return EXIT_FAILURE;
+  }
+  memset (loadgen.stats, 0, sizeof (loadgen.stats));
+  memset (loadgen_last_succeeded, 0, sizeof (loadgen_last_succeeded));
+  loadgen.unexpected_messages = 0;
+  loadgen.send_errors = 0;
+  loadgen.skipped = 0;
+  if (loadgen_mix_phase () < 0) {
+    return EXIT_FAILURE;
+  }
+
+  for (uint32_t e = 0; e < loadgen.nb_enbs; e++) {
+    close (loadgen.enbs[e].sd);
+  }
+  close (loadgen_epoll_fd);
+  hashtable_destroy (loadgen.ue_by_m_tmsi);
+  free (loadgen.ues);
+  free (loadgen.enbs);
+  log_exit ();
+  return EXIT_SUCCESS;
+}
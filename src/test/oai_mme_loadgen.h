@@ -0,0 +1,185 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file oai_mme_loadgen.h
+  \brief S1 signalling load generator: simulated eNBs (one SCTP association each) and UEs driving
+  attach, detach, TAU, service request and paging procedures against an MME running with the
+  BENCHMARK stubs (STUB_HSS answers S6a, STUB_SGW answers S11 and triggers the paging).
+  The UEs compute the authentication vectors of the HSS stub (s6a_stub.h).
+*/
+
+#ifndef FILE_OAI_MME_LOADGEN_SEEN
+#define FILE_OAI_MME_LOADGEN_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/queue.h>
+
+#include "mme_app_statistics.h"
+
+#define LOADGEN_S1AP_PORT                 36412
+#define LOADGEN_S1AP_PPID                 18
+#define LOADGEN_S1AP_STREAM_NON_UE        0
+#define LOADGEN_S1AP_STREAM_UE            1
+
+#define LOADGEN_ENBS_MAX                  4096
+// eNB UE S1AP ID: 4 bits of generation, 20 bits of UE index
+#define LOADGEN_UE_INDEX_BITS             20
+#define LOADGEN_UES_MAX                   (1 << LOADGEN_UE_INDEX_BITS)
+#define LOADGEN_ENB_UE_S1AP_ID(uE)        ((((uE)->generation & 0xF) << LOADGEN_UE_INDEX_BITS) | (uE)->index)
+
+#define LOADGEN_NAS_PDU_MAX               512
+#define LOADGEN_NAS_KSI_NONE              7
+
+typedef enum loadgen_procedure_e {
+  LOADGEN_PROC_ATTACH = 0,
+  LOADGEN_PROC_DETACH,
+  LOADGEN_PROC_TAU,
+  LOADGEN_PROC_SERVICE_REQUEST,
+  LOADGEN_PROC_PAGING,             /*!< \brief Paging received to service request accepted */
+  LOADGEN_PROC_S1_RELEASE,         /*!< \brief UE context release request to release command */
+  LOADGEN_PROC_MAX,
+  LOADGEN_PROC_NONE = LOADGEN_PROC_MAX
+} loadgen_procedure_t;
+
+typedef enum loadgen_result_e {
+  LOADGEN_RESULT_SUCCESS = 0,
+  LOADGEN_RESULT_REJECTED,
+  LOADGEN_RESULT_TIMEOUT,
+} loadgen_result_t;
+
+typedef struct loadgen_nas_security_s {
+  bool         active;
+  uint8_t      ksi;
+  uint8_t      eea;
+  uint8_t      eia;
+  uint8_t      kasme[32];
+  uint8_t      knas_enc[16];
+  uint8_t      knas_int[16];
+  uint32_t     ul_count;             /*!< \brief overflow << 8 | sequence number */
+  uint32_t     dl_count;
+} loadgen_nas_security_t;
+
+typedef struct loadgen_enb_s {
+  uint32_t     index;
+  uint32_t     enb_id;               /*!< \brief macro eNB ID */
+  int          sd;
+  bool         s1_setup_done;
+} loadgen_enb_t;
+
+typedef struct loadgen_ue_s {
+  uint32_t                   index;
+  uint64_t                   imsi64;
+  loadgen_enb_t             *enb;
+
+  bool                       registered;       /*!< \brief EMM-REGISTERED */
+  bool                       connected;        /*!< \brief S1 connection, ECM-CONNECTED */
+  loadgen_procedure_t        procedure;        /*!< \brief ongoing procedure */
+  uint64_t                   procedure_start_ns;
+
+  uint32_t                   generation;       /*!< \brief incremented for each S1 connection */
+  uint32_t                   enb_ue_s1ap_id;
+  uint32_t                   mme_ue_s1ap_id;
+
+  bool                       has_guti;
+  uint8_t                    guti[10];         /*!< \brief PLMN, MMEGI, MMEC, M-TMSI as in the EPS mobile identity */
+  uint32_t                   m_tmsi;
+  uint8_t                    ebi;              /*!< \brief default bearer */
+  loadgen_nas_security_t     security;
+
+  uint64_t                   deadline_ns;
+  bool                       in_timeout_list;
+  TAILQ_ENTRY(loadgen_ue_s)  timeout_entry;
+  uint64_t                   release_ns;
+  bool                       in_release_list;
+  TAILQ_ENTRY(loadgen_ue_s)  release_entry;
+} loadgen_ue_t;
+
+typedef struct loadgen_procedure_stats_s {
+  uint64_t                   started;
+  uint64_t                   succeeded;
+  uint64_t                   rejected;
+  uint64_t                   timed_out;
+  uint64_t                   max_us;
+  mme_stats_histogram_t      latency;
+} loadgen_procedure_stats_t;
+
+typedef struct loadgen_s {
+  // options
+  const char                *mme_address;
+  uint16_t                   mme_port;
+  uint32_t                   nb_enbs;
+  uint32_t                   nb_ues;
+  uint64_t                   first_imsi64;
+  uint8_t                    plmn[3];          /*!< \brief PLMN identity as encoded in S1AP and NAS */
+  uint16_t                   tac;
+  uint32_t                   attach_rate;      /*!< \brief attaches per second of the first phase */
+  uint32_t                   rate;             /*!< \brief procedures per second of the mix */
+  uint32_t                   duration_sec;
+  uint32_t                   hold_ms;          /*!< \brief connected time before the UE context release request */
+  uint32_t                   timeout_ms;
+  uint32_t                   weights[LOADGEN_PROC_PAGING];  /*!< \brief mix of attach, detach, TAU, service request */
+  bool                       verbose;
+
+  loadgen_enb_t             *enbs;
+  loadgen_ue_t              *ues;
+  struct hash_table_s       *ue_by_m_tmsi;
+  uint32_t                   nb_pending;       /*!< \brief UEs with an ongoing procedure */
+  uint32_t                   nb_connected;
+  uint64_t                   unexpected_messages;
+  uint64_t                   send_errors;
+  uint64_t                   skipped;          /*!< \brief mix procedures without UE in the right state */
+
+  loadgen_procedure_stats_t  stats[LOADGEN_PROC_MAX];
+} loadgen_t;
+
+extern loadgen_t loadgen;
+
+// oai_mme_loadgen.c
+uint64_t loadgen_now_ns(void);
+loadgen_ue_t *loadgen_ue_get(const uint32_t enb_ue_s1ap_id);
+void loadgen_ue_set_mme_ue_s1ap_id(loadgen_ue_t * const ue, const uint32_t mme_ue_s1ap_id);
+void loadgen_ue_set_guti(loadgen_ue_t * const ue, const uint8_t guti[10]);
+void loadgen_ue_deregister(loadgen_ue_t * const ue);
+void loadgen_ue_procedure_end(loadgen_ue_t * const ue, const loadgen_procedure_t procedure, const loadgen_result_t result);
+void loadgen_enb_s1_setup_result(loadgen_enb_t * const enb, const bool success);
+void loadgen_ue_initial_context_setup(loadgen_ue_t * const ue, const uint8_t * const nas_pdu, const int nas_length, const uint8_t * const ebis, const int nb_ebis);
+void loadgen_ue_context_release_command(loadgen_ue_t * const ue);
+void loadgen_enb_paging(loadgen_enb_t * const enb, const uint32_t m_tmsi);
+
+// oai_mme_loadgen_s1ap.c
+int loadgen_s1ap_connect(loadgen_enb_t * const enb);
+int loadgen_s1ap_receive(loadgen_enb_t * const enb);
+int loadgen_s1ap_send_initial_ue_message(loadgen_ue_t * const ue, const uint8_t * const nas_pdu, const int nas_length, const bool mt_access);
+int loadgen_s1ap_send_uplink_nas_transport(loadgen_ue_t * const ue, const uint8_t * const nas_pdu, const int nas_length);
+int loadgen_s1ap_send_initial_context_setup_response(loadgen_ue_t * const ue, const uint8_t * const ebis, const int nb_ebis);
+int loadgen_s1ap_send_ue_context_release_request(loadgen_ue_t * const ue);
+int loadgen_s1ap_send_ue_context_release_complete(loadgen_enb_t * const enb, const uint32_t mme_ue_s1ap_id, const uint32_t enb_ue_s1ap_id);
+
+// oai_mme_loadgen_nas.c
+int loadgen_nas_send_attach_request(loadgen_ue_t * const ue);
+int loadgen_nas_send_detach_request(loadgen_ue_t * const ue);
+int loadgen_nas_send_tau_request(loadgen_ue_t * const ue);
+int loadgen_nas_send_service_request(loadgen_ue_t * const ue, const bool mt_access);
+int loadgen_nas_send_attach_complete(loadgen_ue_t * const ue);
+void loadgen_nas_handle_downlink(loadgen_ue_t * const ue, const uint8_t * const nas_pdu, const int nas_length);
+
+#endif /* FILE_OAI_MME_LOADGEN_SEEN */
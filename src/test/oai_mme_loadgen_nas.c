@@ -0,0 +1,505 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file oai_mme_loadgen_nas.c
+   \brief UE side of the load generator: the few EMM messages of the simulated procedures, encoded
+   by hand (TS 24.301) with the NAS security of the UE (TS 33.401), the downlink messages are parsed
+   as far as the procedures need. The downlink MACs are not checked.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "3gpp_24.007.h"
+#include "3gpp_24.301.h"
+#include "NasSecurityAlgorithms.h"
+#include "secu_defs.h"
+#include "s6a_stub.h"
+#include "oai_mme_loadgen.h"
+
+#define LOADGEN_NAS_SECURITY_HEADER_SIZE  6
+#define LOADGEN_NAS_KEY_SIZE              16
+
+// EPS mobile identity (GUTI) and TV IEs of fixed length in the attach and TAU accepts
+#define LOADGEN_NAS_IEI_GUTI              0x50
+#define LOADGEN_NAS_GUTI_LENGTH           11
+#define LOADGEN_NAS_IEI_IMEISV            0x23
+#define LOADGEN_NAS_IEI_UE_NETWORK_CAPABILITY    0x58
+#define LOADGEN_NAS_IEI_LAST_VISITED_TAI         0x52
+#define LOADGEN_NAS_IEI_EPS_BEARER_CONTEXT_STATUS 0x57
+
+// EEA0, 128-EEA1, 128-EEA2 and 128-EIA1, 128-EIA2
+static const uint8_t                      loadgen_nas_ue_network_capability[3] = {0x02, 0xE0, 0x60};
+
+//------------------------------------------------------------------------------
+static void loadgen_nas_mac (const loadgen_nas_security_t * const security, const uint8_t direction, const uint32_t count,
+    const uint8_t * const message, const int length, uint8_t mac[4])
+{
+  nas_stream_cipher_t                     stream_cipher = {
+    .key = (uint8_t *)security->knas_int,
+    .key_length = LOADGEN_NAS_KEY_SIZE,
+    .count = count,
+    .bearer = 0,
+    .direction = direction,
+    .message = (uint8_t *)message,
+    .blength = length << 3,
+  };
+
+  switch (security->eia) {
+  case NAS_SECURITY_ALGORITHMS_EIA1:
+    nas_stream_encrypt_eia1 (&stream_cipher, mac);
+    break;
+  case NAS_SECURITY_ALGORITHMS_EIA2:
+    nas_stream_encrypt_eia2 (&stream_cipher, mac);
+    break;
+  default:
+    memset (mac, 0, 4);
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_nas_cipher (const loadgen_nas_security_t * const security, const uint8_t direction, const uint32_t count,
+    const uint8_t * const in, const int length, uint8_t * const out)
+{
+  nas_stream_cipher_t                     stream_cipher = {
+    .key = (uint8_t *)security->knas_enc,
+    .key_length = LOADGEN_NAS_KEY_SIZE,
+    .count = count,
+    .bearer = 0,
+    .direction = direction,
+    .message = (uint8_t *)in,
+    .blength = length << 3,
+  };
+
+  switch (security->eea) {
+  case NAS_SECURITY_ALGORITHMS_EEA1:
+    nas_stream_encrypt_eea1 (&stream_cipher, out);
+    break;
+  case NAS_SECURITY_ALGORITHMS_EEA2:
+    nas_stream_encrypt_eea2 (&stream_cipher, out);
+    break;
+  default:
+    memcpy (out, in, length);
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Security protected NAS message, the initial ones go in the initial UE message
+static int loadgen_nas_send_protected (loadgen_ue_t * const ue, const uint8_t security_header_type,
+    const uint8_t * const plain, const int length, const bool initial)
+{
+  loadgen_nas_security_t * const          security = &ue->security;
+  uint8_t                                 buffer[LOADGEN_NAS_PDU_MAX];
+  uint8_t                                 mac[4];
+
+  if (length + LOADGEN_NAS_SECURITY_HEADER_SIZE > LOADGEN_NAS_PDU_MAX) {
+    return -1;
+  }
+  buffer[0] = (security_header_type << 4) | EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[5] = security->ul_count & 0xFF;
+  if ((SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED == security_header_type) ||
+      (SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED_NEW == security_header_type)) {
+    loadgen_nas_cipher (security, SECU_DIRECTION_UPLINK, security->ul_count, plain, length, &buffer[LOADGEN_NAS_SECURITY_HEADER_SIZE]);
+  } else {
+    memcpy (&buffer[LOADGEN_NAS_SECURITY_HEADER_SIZE], plain, length);
+  }
+  // over the sequence number and the message
+  loadgen_nas_mac (security, SECU_DIRECTION_UPLINK, security->ul_count, &buffer[5], length + 1, mac);
+  memcpy (&buffer[1], mac, 4);
+  security->ul_count++;
+  if (initial) {
+    return loadgen_s1ap_send_initial_ue_message (ue, buffer, length + LOADGEN_NAS_SECURITY_HEADER_SIZE, false);
+  }
+  return loadgen_s1ap_send_uplink_nas_transport (ue, buffer, length + LOADGEN_NAS_SECURITY_HEADER_SIZE);
+}
+
+//------------------------------------------------------------------------------
+// EPS mobile identity LV, IMSI of 15 digits
+static int loadgen_nas_imsi_identity (const loadgen_ue_t * const ue, uint8_t * const buffer)
+{
+  char                                    digits[16];
+  int                                     size = 0;
+
+  snprintf (digits, sizeof (digits), "%015" PRIu64, ue->imsi64);
+  buffer[size++] = 8;
+  buffer[size++] = ((digits[0] - '0') << 4) | 0x09;      // odd number of digits, IMSI
+  for (int i = 1; i < 15; i += 2) {
+    buffer[size++] = ((digits[i + 1] - '0') << 4) | (digits[i] - '0');
+  }
+  return size;
+}
+
+//------------------------------------------------------------------------------
+// EPS mobile identity LV, GUTI
+static int loadgen_nas_guti_identity (const loadgen_ue_t * const ue, uint8_t * const buffer)
+{
+  buffer[0] = LOADGEN_NAS_GUTI_LENGTH;
+  buffer[1] = 0xF6;                     // even number of digits, GUTI
+  memcpy (&buffer[2], ue->guti, sizeof (ue->guti));
+  return 2 + sizeof (ue->guti);
+}
+
+//------------------------------------------------------------------------------
+// Mobile identity TLV, IMEISV of 16 digits derived from the IMSI
+static int loadgen_nas_imeisv (const loadgen_ue_t * const ue, uint8_t * const buffer)
+{
+  char                                    digits[17];
+  int                                     size = 0;
+
+  snprintf (digits, sizeof (digits), "35%012" PRIu64 "01", ue->imsi64 % UINT64_C(1000000000000));
+  buffer[size++] = LOADGEN_NAS_IEI_IMEISV;
+  buffer[size++] = 9;
+  buffer[size++] = ((digits[0] - '0') << 4) | 0x03;      // even number of digits, IMEISV
+  for (int i = 1; i < 16; i += 2) {
+    buffer[size++] = (((i + 1 < 16) ? (digits[i + 1] - '0') : 0x0F) << 4) | (digits[i] - '0');
+  }
+  return size;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_send_attach_request (loadgen_ue_t * const ue)
+{
+  uint8_t                                 buffer[64];
+  int                                     size = 0;
+
+  ue->security.active = false;
+  ue->security.ksi = LOADGEN_NAS_KSI_NONE;
+  buffer[size++] = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[size++] = ATTACH_REQUEST;
+  buffer[size++] = (LOADGEN_NAS_KSI_NONE << 4) | 0x01;  // no key, EPS attach
+  size += loadgen_nas_imsi_identity (ue, &buffer[size]);
+  memcpy (&buffer[size], loadgen_nas_ue_network_capability, sizeof (loadgen_nas_ue_network_capability));
+  size += sizeof (loadgen_nas_ue_network_capability);
+  // ESM message container: PDN connectivity request, IPv4, initial request
+  buffer[size++] = 0;
+  buffer[size++] = 4;
+  buffer[size++] = EPS_SESSION_MANAGEMENT_MESSAGE;
+  buffer[size++] = 1;                   // PTI
+  buffer[size++] = PDN_CONNECTIVITY_REQUEST;
+  buffer[size++] = 0x11;
+  return loadgen_s1ap_send_initial_ue_message (ue, buffer, size, false);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_send_detach_request (loadgen_ue_t * const ue)
+{
+  uint8_t                                 buffer[32];
+  int                                     size = 0;
+
+  buffer[size++] = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[size++] = DETACH_REQUEST;
+  buffer[size++] = (ue->security.ksi << 4) | 0x01;      // normal detach, EPS detach
+  size += loadgen_nas_guti_identity (ue, &buffer[size]);
+  return loadgen_nas_send_protected (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED, buffer, size, true);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_send_tau_request (loadgen_ue_t * const ue)
+{
+  uint8_t                                 buffer[48];
+  int                                     size = 0;
+
+  buffer[size++] = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[size++] = TRACKING_AREA_UPDATE_REQUEST;
+  buffer[size++] = (ue->security.ksi << 4) | 0x00;      // TA updating
+  size += loadgen_nas_guti_identity (ue, &buffer[size]);
+  buffer[size++] = LOADGEN_NAS_IEI_UE_NETWORK_CAPABILITY;
+  memcpy (&buffer[size], loadgen_nas_ue_network_capability, sizeof (loadgen_nas_ue_network_capability));
+  size += sizeof (loadgen_nas_ue_network_capability);
+  buffer[size++] = LOADGEN_NAS_IEI_LAST_VISITED_TAI;
+  memcpy (&buffer[size], loadgen.plmn, 3);
+  size += 3;
+  buffer[size++] = loadgen.tac >> 8;
+  buffer[size++] = loadgen.tac & 0xFF;
+  buffer[size++] = LOADGEN_NAS_IEI_EPS_BEARER_CONTEXT_STATUS;
+  buffer[size++] = 2;
+  buffer[size++] = (ue->ebi < 8) ? (1 << ue->ebi) : 0;
+  buffer[size++] = (ue->ebi < 8) ? 0 : (1 << (ue->ebi - 8));
+  return loadgen_nas_send_protected (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED, buffer, size, true);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_send_service_request (loadgen_ue_t * const ue, const bool mt_access)
+{
+  loadgen_nas_security_t * const          security = &ue->security;
+  uint8_t                                 buffer[4];
+  uint8_t                                 mac[4];
+
+  // KSI and the 5 LSBs of the sequence number, short MAC over the first 2 octets
+  buffer[0] = (SECURITY_HEADER_TYPE_SERVICE_REQUEST << 4) | EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[1] = (security->ksi << 5) | (security->ul_count & 0x1F);
+  loadgen_nas_mac (security, SECU_DIRECTION_UPLINK, security->ul_count, buffer, 2, mac);
+  buffer[2] = mac[2];
+  buffer[3] = mac[3];
+  security->ul_count++;
+  return loadgen_s1ap_send_initial_ue_message (ue, buffer, sizeof (buffer), mt_access);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_send_attach_complete (loadgen_ue_t * const ue)
+{
+  uint8_t                                 buffer[8];
+  int                                     size = 0;
+
+  buffer[size++] = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[size++] = ATTACH_COMPLETE;
+  // ESM message container: activate default EPS bearer context accept
+  buffer[size++] = 0;
+  buffer[size++] = 3;
+  buffer[size++] = (ue->ebi << 4) | EPS_SESSION_MANAGEMENT_MESSAGE;
+  buffer[size++] = 0;                   // PTI
+  buffer[size++] = ACTIVATE_DEFAULT_EPS_BEARER_CONTEXT_ACCEPT;
+  return loadgen_nas_send_protected (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED, buffer, size, false);
+}
+
+//------------------------------------------------------------------------------
+// GUTI in the optional IEs of an attach or TAU accept
+static bool loadgen_nas_find_guti (const uint8_t * const ies, const int length, uint8_t guti[10])
+{
+  int                                     offset = 0;
+
+  while (offset < length) {
+    const uint8_t                         iei = ies[offset];
+
+    if (iei >= 0x80) {
+      // type 1, IEI in the high nibble
+      offset += 1;
+      continue;
+    }
+    switch (iei) {
+    case 0x13:                          // location area identification
+      offset += 6;
+      continue;
+    case 0x17:                          // T3402
+    case 0x53:                          // EMM cause
+    case 0x59:                          // T3423
+    case 0x5A:                          // T3412
+      offset += 2;
+      continue;
+    default:
+      break;
+    }
+    if (offset + 1 >= length) {
+      break;
+    }
+    if ((LOADGEN_NAS_IEI_GUTI == iei) && (LOADGEN_NAS_GUTI_LENGTH == ies[offset + 1]) &&
+        (offset + 2 + LOADGEN_NAS_GUTI_LENGTH <= length) && (0x06 == (ies[offset + 2] & 0x07))) {
+      memcpy (guti, &ies[offset + 3], 10);
+      return true;
+    }
+    offset += 2 + ies[offset + 1];
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_nas_handle_authentication_request (loadgen_ue_t * const ue, const uint8_t * const message, const int length)
+{
+  uint8_t                                 rand[16];
+  uint8_t                                 autn[16];
+  uint8_t                                 buffer[2 + 1 + S6A_STUB_RES_LENGTH];
+  uint32_t                                sequence = 0;
+
+  // KSI, RAND, AUTN LV
+  if (length < 3 + 16 + 17) {
+    loadgen.unexpected_messages++;
+    return;
+  }
+  sequence = ((uint32_t)message[11] << 24) | ((uint32_t)message[12] << 16) | ((uint32_t)message[13] << 8) | message[14];
+  s6a_stub_generate_vector (ue->imsi64, sequence, rand, &buffer[3], autn, ue->security.kasme);
+  if (memcmp (rand, &message[3], sizeof (rand)) || memcmp (autn, &message[20], sizeof (autn))) {
+    // not a vector of the HSS stub
+    loadgen_ue_procedure_end (ue, ue->procedure, LOADGEN_RESULT_REJECTED);
+    return;
+  }
+  ue->security.ksi = message[2] & 0x07;
+  buffer[0] = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[1] = AUTHENTICATION_RESPONSE;
+  buffer[2] = S6A_STUB_RES_LENGTH;
+  loadgen_s1ap_send_uplink_nas_transport (ue, buffer, sizeof (buffer));
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_nas_handle_security_mode_command (loadgen_ue_t * const ue, const uint8_t * const message, const int length)
+{
+  loadgen_nas_security_t * const          security = &ue->security;
+  uint8_t                                 buffer[16];
+  int                                     size = 0;
+
+  // selected NAS security algorithms, KSI, replayed UE security capabilities
+  if (length < 4) {
+    loadgen.unexpected_messages++;
+    return;
+  }
+  security->eea = (message[2] >> 4) & 0x07;
+  security->eia = message[2] & 0x07;
+  security->ksi = message[3] & 0x07;
+  derive_key_nas (NAS_ENC_ALG, security->eea, security->kasme, security->knas_enc);
+  derive_key_nas (NAS_INT_ALG, security->eia, security->kasme, security->knas_int);
+  security->active = true;
+  security->ul_count = 0;
+
+  buffer[size++] = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[size++] = SECURITY_MODE_COMPLETE;
+  size += loadgen_nas_imeisv (ue, &buffer[size]);
+  loadgen_nas_send_protected (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED_NEW, buffer, size, false);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_nas_handle_identity_request (loadgen_ue_t * const ue)
+{
+  uint8_t                                 buffer[16];
+  int                                     size = 0;
+
+  buffer[size++] = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[size++] = IDENTITY_RESPONSE;
+  size += loadgen_nas_imsi_identity (ue, &buffer[size]);
+  loadgen_s1ap_send_uplink_nas_transport (ue, buffer, size);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_nas_handle_attach_accept (loadgen_ue_t * const ue, const uint8_t * const message, const int length)
+{
+  uint8_t                                 guti[10];
+  int                                     offset = 4;   // EPS attach result, T3412
+  int                                     esm_length = 0;
+
+  // TAI list LV, ESM message container LV-E with the activate default EPS bearer context request
+  if (offset >= length) {
+    goto error;
+  }
+  offset += 1 + message[offset];
+  if (offset + 2 > length) {
+    goto error;
+  }
+  esm_length = (message[offset] << 8) | message[offset + 1];
+  offset += 2;
+  if ((esm_length < 1) || (offset + esm_length > length)) {
+    goto error;
+  }
+  ue->ebi = message[offset] >> 4;
+  offset += esm_length;
+  if (!loadgen_nas_find_guti (&message[offset], length - offset, guti)) {
+    goto error;
+  }
+  loadgen_ue_set_guti (ue, guti);
+  ue->registered = true;
+  loadgen_ue_procedure_end (ue, LOADGEN_PROC_ATTACH, LOADGEN_RESULT_SUCCESS);
+  return;
+
+error:
+  loadgen.unexpected_messages++;
+  loadgen_ue_procedure_end (ue, LOADGEN_PROC_ATTACH, LOADGEN_RESULT_REJECTED);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_nas_handle_tau_accept (loadgen_ue_t * const ue, const uint8_t * const message, const int length)
+{
+  uint8_t                                 guti[10];
+  uint8_t                                 buffer[2];
+
+  // EPS update result, then optional IEs
+  if ((length > 3) && loadgen_nas_find_guti (&message[3], length - 3, guti)) {
+    loadgen_ue_set_guti (ue, guti);
+    buffer[0] = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+    buffer[1] = TRACKING_AREA_UPDATE_COMPLETE;
+    loadgen_nas_send_protected (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED, buffer, sizeof (buffer), false);
+  }
+  loadgen_ue_procedure_end (ue, LOADGEN_PROC_TAU, LOADGEN_RESULT_SUCCESS);
+}
+
+//------------------------------------------------------------------------------
+void loadgen_nas_handle_downlink (loadgen_ue_t * const ue, const uint8_t * const nas_pdu, const int nas_length)
+{
+  uint8_t                                 plain[LOADGEN_NAS_PDU_MAX];
+  const uint8_t                          *message = nas_pdu;
+  int                                     length = nas_length;
+  uint8_t                                 security_header_type = 0;
+
+  if (length < 2) {
+    loadgen.unexpected_messages++;
+    return;
+  }
+  security_header_type = nas_pdu[0] >> 4;
+  if (SECURITY_HEADER_TYPE_NOT_PROTECTED != security_header_type) {
+    loadgen_nas_security_t * const       security = &ue->security;
+    const uint8_t                         sequence_number = nas_pdu[5];
+
+    length -= LOADGEN_NAS_SECURITY_HEADER_SIZE;
+    if ((length < 2) || (length > LOADGEN_NAS_PDU_MAX)) {
+      loadgen.unexpected_messages++;
+      return;
+    }
+    if (sequence_number < (security->dl_count & 0xFF)) {
+      security->dl_count += 0x100;
+    }
+    security->dl_count = (security->dl_count & ~0xFF) | sequence_number;
+    message = &nas_pdu[LOADGEN_NAS_SECURITY_HEADER_SIZE];
+    if (security->active && ((SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED == security_header_type) ||
+          (SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED_NEW == security_header_type))) {
+      loadgen_nas_cipher (security, SECU_DIRECTION_DOWNLINK, security->dl_count, message, length, plain);
+      message = plain;
+    }
+  }
+  if (EPS_MOBILITY_MANAGEMENT_MESSAGE != (message[0] & 0x0F)) {
+    loadgen.unexpected_messages++;
+    return;
+  }
+
+  switch (message[1]) {
+  case AUTHENTICATION_REQUEST:
+    loadgen_nas_handle_authentication_request (ue, message, length);
+    break;
+  case SECURITY_MODE_COMMAND:
+    loadgen_nas_handle_security_mode_command (ue, message, length);
+    break;
+  case IDENTITY_REQUEST:
+    loadgen_nas_handle_identity_request (ue);
+    break;
+  case ATTACH_ACCEPT:
+    loadgen_nas_handle_attach_accept (ue, message, length);
+    break;
+  case DETACH_ACCEPT:
+    loadgen_ue_deregister (ue);
+    loadgen_ue_procedure_end (ue, LOADGEN_PROC_DETACH, LOADGEN_RESULT_SUCCESS);
+    break;
+  case TRACKING_AREA_UPDATE_ACCEPT:
+    loadgen_nas_handle_tau_accept (ue, message, length);
+    break;
+  case ATTACH_REJECT:
+  case AUTHENTICATION_REJECT:
+  case TRACKING_AREA_UPDATE_REJECT:
+  case SERVICE_REJECT:
+  case SECURITY_MODE_REJECT:
+    loadgen_ue_procedure_end (ue, ue->procedure, LOADGEN_RESULT_REJECTED);
+    break;
+  case EMM_INFORMATION:
+    break;
+  default:
+    loadgen.unexpected_messages++;
+    break;
+  }
+}
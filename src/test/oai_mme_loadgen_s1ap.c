@@ -0,0 +1,505 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file oai_mme_loadgen_s1ap.c
+   \brief eNB side of the load generator: SCTP associations, S1AP encoding of the uplink messages
+   with the S1AP library of the MME (hand written fast path for the uplink NAS transport),
+   decoding and dispatch of the downlink messages.
+   The IEs of the uplink messages point to stack buffers, they are copied by the encoder.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/sctp.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "oai_mme_loadgen.h"
+
+#define LOADGEN_S1AP_RECV_BUFFER_SIZE     8192
+#define LOADGEN_S1AP_RECV_BURST           64
+#define LOADGEN_S1AP_SEND_TIMEOUT_MS      1000
+#define LOADGEN_E_RABS_MAX                8
+
+// S1-U address of the eNBs in the initial context setup responses, the S-GW stub does not use it
+static uint8_t                            loadgen_s1u_address[4] = {127, 0, 0, 1};
+
+//------------------------------------------------------------------------------
+static int loadgen_s1ap_sendmsg (loadgen_enb_t * const enb, const uint16_t stream, const uint8_t * const buffer, const uint32_t length)
+{
+  int                                     rc = 0;
+
+  while ((rc = sctp_sendmsg (enb->sd, buffer, length, NULL, 0, htonl (LOADGEN_S1AP_PPID), 0, stream, 0, 0)) < 0) {
+    struct pollfd                         fds = {.fd = enb->sd, .events = POLLOUT};
+
+    // send buffer full: the MME does not keep up, wait for it
+    if (((errno != EAGAIN) && (errno != EWOULDBLOCK)) || (poll (&fds, 1, LOADGEN_S1AP_SEND_TIMEOUT_MS) <= 0)) {
+      loadgen.send_errors++;
+      break;
+    }
+  }
+  return (rc < 0) ? -1 : 0;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_s1ap_send (loadgen_enb_t * const enb, const uint16_t stream, uint8_t * const buffer, const uint32_t length)
+{
+  int                                     rc = loadgen_s1ap_sendmsg (enb, stream, buffer, length);
+
+  free (buffer);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_s1ap_set_tai (S1ap_TAI_t * const tai, uint8_t tac[2])
+{
+  tac[0] = loadgen.tac >> 8;
+  tac[1] = loadgen.tac & 0xFF;
+  tai->pLMNidentity.buf = loadgen.plmn;
+  tai->pLMNidentity.size = 3;
+  tai->tAC.buf = tac;
+  tai->tAC.size = 2;
+}
+
+//------------------------------------------------------------------------------
+// One cell per eNB: 28 bits cell identity, eNB ID and cell 0
+static void loadgen_s1ap_set_eutran_cgi (S1ap_EUTRAN_CGI_t * const cgi, const loadgen_enb_t * const enb, uint8_t cell_id[4])
+{
+  const uint32_t                          value = (enb->enb_id << 8) << 4;
+
+  cell_id[0] = value >> 24;
+  cell_id[1] = value >> 16;
+  cell_id[2] = value >> 8;
+  cell_id[3] = value;
+  cgi->pLMNidentity.buf = loadgen.plmn;
+  cgi->pLMNidentity.size = 3;
+  cgi->cell_ID.buf = cell_id;
+  cgi->cell_ID.size = 4;
+  cgi->cell_ID.bits_unused = 4;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_s1ap_send_s1_setup_request (loadgen_enb_t * const enb)
+{
+  S1ap_S1SetupRequestIEs_t                ies;
+  S1ap_S1SetupRequest_t                   s1SetupRequest;
+  S1ap_SupportedTAs_Item_t                ta;
+  S1ap_PLMNidentity_t                     plmn;
+  uint8_t                                 enb_id[3];
+  uint8_t                                 tac[2];
+  char                                    name[32];
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  int                                     rc = 0;
+
+  memset (&ies, 0, sizeof (ies));
+  memset (&s1SetupRequest, 0, sizeof (s1SetupRequest));
+  memset (&ta, 0, sizeof (ta));
+  memset (&plmn, 0, sizeof (plmn));
+
+  // macro eNB ID: 20 bits
+  enb_id[0] = enb->enb_id >> 12;
+  enb_id[1] = enb->enb_id >> 4;
+  enb_id[2] = (enb->enb_id & 0x0F) << 4;
+  ies.global_ENB_ID.pLMNidentity.buf = loadgen.plmn;
+  ies.global_ENB_ID.pLMNidentity.size = 3;
+  ies.global_ENB_ID.eNB_ID.present = S1ap_ENB_ID_PR_macroENB_ID;
+  ies.global_ENB_ID.eNB_ID.choice.macroENB_ID.buf = enb_id;
+  ies.global_ENB_ID.eNB_ID.choice.macroENB_ID.size = 3;
+  ies.global_ENB_ID.eNB_ID.choice.macroENB_ID.bits_unused = 4;
+
+  ies.presenceMask |= S1AP_S1SETUPREQUESTIES_ENBNAME_PRESENT;
+  ies.eNBname.size = snprintf (name, sizeof (name), "loadgen-enb-%u", enb->enb_id);
+  ies.eNBname.buf = (uint8_t *)name;
+
+  tac[0] = loadgen.tac >> 8;
+  tac[1] = loadgen.tac & 0xFF;
+  ta.tAC.buf = tac;
+  ta.tAC.size = 2;
+  plmn.buf = loadgen.plmn;
+  plmn.size = 3;
+  ASN_SEQUENCE_ADD (&ta.broadcastPLMNs.list, &plmn);
+  ASN_SEQUENCE_ADD (&ies.supportedTAs.list, &ta);
+  ies.defaultPagingDRX = S1ap_PagingDRX_v64;
+
+  rc = s1ap_encode_s1ap_s1setuprequesties (&s1SetupRequest, &ies);
+  free (ta.broadcastPLMNs.list.array);
+  free (ies.supportedTAs.list.array);
+  if (rc < 0) {
+    return -1;
+  }
+  if (s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_S1Setup, S1ap_Criticality_reject,
+        &asn_DEF_S1ap_S1SetupRequest, &s1SetupRequest) < 0) {
+    return -1;
+  }
+  return loadgen_s1ap_send (enb, LOADGEN_S1AP_STREAM_NON_UE, buffer, length);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_connect (loadgen_enb_t * const enb)
+{
+  struct sockaddr_in                      addr;
+  struct sctp_initmsg                     init;
+
+  memset (&addr, 0, sizeof (addr));
+  memset (&init, 0, sizeof (init));
+  if ((enb->sd = socket (AF_INET, SOCK_STREAM, IPPROTO_SCTP)) < 0) {
+    return -1;
+  }
+  init.sinit_num_ostreams = 2;
+  init.sinit_max_instreams = 2;
+  init.sinit_max_attempts = 4;
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (loadgen.mme_port);
+  if ((setsockopt (enb->sd, IPPROTO_SCTP, SCTP_INITMSG, &init, sizeof (init)) < 0) ||
+      (inet_pton (AF_INET, loadgen.mme_address, &addr.sin_addr) != 1) ||
+      (connect (enb->sd, (struct sockaddr *)&addr, sizeof (addr)) < 0) ||
+      (fcntl (enb->sd, F_SETFL, fcntl (enb->sd, F_GETFL) | O_NONBLOCK) < 0)) {
+    close (enb->sd);
+    enb->sd = -1;
+    return -1;
+  }
+  return loadgen_s1ap_send_s1_setup_request (enb);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_send_initial_ue_message (loadgen_ue_t * const ue, const uint8_t * const nas_pdu, const int nas_length, const bool mt_access)
+{
+  S1ap_InitialUEMessageIEs_t              ies;
+  S1ap_InitialUEMessage_t                 initialUEMessage;
+  uint8_t                                 tac[2];
+  uint8_t                                 cell_id[4];
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+
+  memset (&ies, 0, sizeof (ies));
+  memset (&initialUEMessage, 0, sizeof (initialUEMessage));
+  ies.eNB_UE_S1AP_ID = ue->enb_ue_s1ap_id;
+  ies.nas_pdu.buf = (uint8_t *)nas_pdu;
+  ies.nas_pdu.size = nas_length;
+  loadgen_s1ap_set_tai (&ies.tai, tac);
+  loadgen_s1ap_set_eutran_cgi (&ies.eutran_cgi, ue->enb, cell_id);
+  ies.rrC_Establishment_Cause = mt_access ? S1ap_RRC_Establishment_Cause_mt_Access : S1ap_RRC_Establishment_Cause_mo_Signalling;
+  if (ue->has_guti) {
+    ies.presenceMask |= S1AP_INITIALUEMESSAGEIES_S_TMSI_PRESENT;
+    ies.s_tmsi.mMEC.buf = &ue->guti[5];
+    ies.s_tmsi.mMEC.size = 1;
+    ies.s_tmsi.m_TMSI.buf = &ue->guti[6];
+    ies.s_tmsi.m_TMSI.size = 4;
+  }
+  if ((s1ap_encode_s1ap_initialuemessageies (&initialUEMessage, &ies) < 0) ||
+      (s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_initialUEMessage, S1ap_Criticality_ignore,
+          &asn_DEF_S1ap_InitialUEMessage, &initialUEMessage) < 0)) {
+    return -1;
+  }
+  return loadgen_s1ap_send (ue->enb, LOADGEN_S1AP_STREAM_UE, buffer, length);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_send_uplink_nas_transport (loadgen_ue_t * const ue, const uint8_t * const nas_pdu, const int nas_length)
+{
+  bstring                                 pdu = NULL;
+  int                                     rc = -1;
+
+  // same fast path as the downlink NAS transport of the MME
+  if (!(pdu = bfromcstralloc (nas_length + S1AP_UPLINK_NAS_TRANSPORT_OVERHEAD_MAX + 1, ""))) {
+    return -1;
+  }
+  bcatblk (pdu, nas_pdu, nas_length);
+  if (s1ap_encode_uplink_nas_transport (pdu, ue->mme_ue_s1ap_id, ue->enb_ue_s1ap_id, loadgen.plmn, loadgen.tac, ue->enb->enb_id << 8) > 0) {
+    rc = loadgen_s1ap_sendmsg (ue->enb, LOADGEN_S1AP_STREAM_UE, pdu->data, blength (pdu));
+  }
+  bdestroy (pdu);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_send_initial_context_setup_response (loadgen_ue_t * const ue, const uint8_t * const ebis, const int nb_ebis)
+{
+  S1ap_InitialContextSetupResponseIEs_t   ies;
+  S1ap_InitialContextSetupResponse_t      initialContextSetupResponse;
+  S1ap_E_RABSetupItemCtxtSURes_t          items[LOADGEN_E_RABS_MAX];
+  uint8_t                                 teids[LOADGEN_E_RABS_MAX][4];
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  int                                     rc = 0;
+
+  memset (&ies, 0, sizeof (ies));
+  memset (&initialContextSetupResponse, 0, sizeof (initialContextSetupResponse));
+  memset (items, 0, sizeof (items));
+  ies.mme_ue_s1ap_id = ue->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = ue->enb_ue_s1ap_id;
+  for (int i = 0; (i < nb_ebis) && (i < LOADGEN_E_RABS_MAX); i++) {
+    const uint32_t                        teid = (ue->index << 4) | ebis[i];
+
+    teids[i][0] = teid >> 24;
+    teids[i][1] = teid >> 16;
+    teids[i][2] = teid >> 8;
+    teids[i][3] = teid;
+    items[i].e_RAB_ID = ebis[i];
+    items[i].transportLayerAddress.buf = loadgen_s1u_address;
+    items[i].transportLayerAddress.size = 4;
+    items[i].gTP_TEID.buf = teids[i];
+    items[i].gTP_TEID.size = 4;
+    ASN_SEQUENCE_ADD (&ies.e_RABSetupListCtxtSURes.s1ap_E_RABSetupItemCtxtSURes, &items[i]);
+  }
+  rc = s1ap_encode_s1ap_initialcontextsetupresponseies (&initialContextSetupResponse, &ies);
+  free (ies.e_RABSetupListCtxtSURes.s1ap_E_RABSetupItemCtxtSURes.array);
+  if ((rc < 0) ||
+      (s1ap_generate_successfull_outcome (&buffer, &length, S1ap_ProcedureCode_id_InitialContextSetup, S1ap_Criticality_reject,
+          &asn_DEF_S1ap_InitialContextSetupResponse, &initialContextSetupResponse) < 0)) {
+    return -1;
+  }
+  return loadgen_s1ap_send (ue->enb, LOADGEN_S1AP_STREAM_UE, buffer, length);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_send_ue_context_release_request (loadgen_ue_t * const ue)
+{
+  S1ap_UEContextReleaseRequestIEs_t       ies;
+  S1ap_UEContextReleaseRequest_t          ueContextReleaseRequest;
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+
+  memset (&ies, 0, sizeof (ies));
+  memset (&ueContextReleaseRequest, 0, sizeof (ueContextReleaseRequest));
+  ies.mme_ue_s1ap_id = ue->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = ue->enb_ue_s1ap_id;
+  ies.cause.present = S1ap_Cause_PR_radioNetwork;
+  ies.cause.choice.radioNetwork = S1ap_CauseRadioNetwork_user_inactivity;
+  if ((s1ap_encode_s1ap_uecontextreleaserequesties (&ueContextReleaseRequest, &ies) < 0) ||
+      (s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_UEContextReleaseRequest, S1ap_Criticality_ignore,
+          &asn_DEF_S1ap_UEContextReleaseRequest, &ueContextReleaseRequest) < 0)) {
+    return -1;
+  }
+  return loadgen_s1ap_send (ue->enb, LOADGEN_S1AP_STREAM_UE, buffer, length);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_send_ue_context_release_complete (loadgen_enb_t * const enb, const uint32_t mme_ue_s1ap_id, const uint32_t enb_ue_s1ap_id)
+{
+  S1ap_UEContextReleaseCompleteIEs_t      ies;
+  S1ap_UEContextReleaseComplete_t         ueContextReleaseComplete;
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+
+  memset (&ies, 0, sizeof (ies));
+  memset (&ueContextReleaseComplete, 0, sizeof (ueContextReleaseComplete));
+  ies.mme_ue_s1ap_id = mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+  if ((s1ap_encode_s1ap_uecontextreleasecompleteies (&ueContextReleaseComplete, &ies) < 0) ||
+      (s1ap_generate_successfull_outcome (&buffer, &length, S1ap_ProcedureCode_id_UEContextRelease, S1ap_Criticality_reject,
+          &asn_DEF_S1ap_UEContextReleaseComplete, &ueContextReleaseComplete) < 0)) {
+    return -1;
+  }
+  return loadgen_s1ap_send (enb, LOADGEN_S1AP_STREAM_UE, buffer, length);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_s1ap_handle_downlink_nas_transport (ANY_t * const value)
+{
+  S1ap_DownlinkNASTransportIEs_t          ies;
+  loadgen_ue_t                           *ue = NULL;
+
+  if (s1ap_decode_s1ap_downlinknastransporties (&ies, value) < 0) {
+    loadgen.unexpected_messages++;
+    return;
+  }
+  if ((ue = loadgen_ue_get (ies.eNB_UE_S1AP_ID))) {
+    loadgen_ue_set_mme_ue_s1ap_id (ue, ies.mme_ue_s1ap_id);
+    loadgen_nas_handle_downlink (ue, ies.nas_pdu.buf, ies.nas_pdu.size);
+  } else {
+    loadgen.unexpected_messages++;
+  }
+  free_s1ap_downlinknastransport (&ies);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_s1ap_handle_initial_context_setup_request (ANY_t * const value)
+{
+  S1ap_InitialContextSetupRequestIEs_t    ies;
+  loadgen_ue_t                           *ue = NULL;
+  uint8_t                                 ebis[LOADGEN_E_RABS_MAX];
+  int                                     nb_ebis = 0;
+  const uint8_t                          *nas_pdu = NULL;
+  int                                     nas_length = 0;
+
+  if (s1ap_decode_s1ap_initialcontextsetuprequesties (&ies, value) < 0) {
+    loadgen.unexpected_messages++;
+    return;
+  }
+  if ((ue = loadgen_ue_get (ies.eNB_UE_S1AP_ID))) {
+    for (int i = 0; (i < ies.e_RABToBeSetupListCtxtSUReq.s1ap_E_RABToBeSetupItemCtxtSUReq.count) && (nb_ebis < LOADGEN_E_RABS_MAX); i++) {
+      const S1ap_E_RABToBeSetupItemCtxtSUReq_t * const item = (S1ap_E_RABToBeSetupItemCtxtSUReq_t *)ies.e_RABToBeSetupListCtxtSUReq.s1ap_E_RABToBeSetupItemCtxtSUReq.array[i];
+
+      ebis[nb_ebis++] = item->e_RAB_ID;
+      if (item->nAS_PDU && !nas_pdu) {
+        nas_pdu = item->nAS_PDU->buf;
+        nas_length = item->nAS_PDU->size;
+      }
+    }
+    loadgen_ue_set_mme_ue_s1ap_id (ue, ies.mme_ue_s1ap_id);
+    loadgen_ue_initial_context_setup (ue, nas_pdu, nas_length, ebis, nb_ebis);
+  } else {
+    loadgen.unexpected_messages++;
+  }
+  free_s1ap_initialcontextsetuprequest (&ies);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_s1ap_handle_ue_context_release_command (loadgen_enb_t * const enb, ANY_t * const value)
+{
+  S1ap_UEContextReleaseCommandIEs_t       ies;
+  loadgen_ue_t                           *ue = NULL;
+
+  if (s1ap_decode_s1ap_uecontextreleasecommandies (&ies, value) < 0) {
+    loadgen.unexpected_messages++;
+    return;
+  }
+  if (S1ap_UE_S1AP_IDs_PR_uE_S1AP_ID_pair == ies.uE_S1AP_IDs.present) {
+    const S1ap_UE_S1AP_ID_pair_t * const  pair = &ies.uE_S1AP_IDs.choice.uE_S1AP_ID_pair;
+
+    // also completes the releases of S1 connections the UE already dropped
+    loadgen_s1ap_send_ue_context_release_complete (enb, pair->mME_UE_S1AP_ID, pair->eNB_UE_S1AP_ID);
+    if ((ue = loadgen_ue_get (pair->eNB_UE_S1AP_ID))) {
+      loadgen_ue_context_release_command (ue);
+    }
+  } else {
+    // the MME has no S1 connection for this MME UE S1AP ID
+    loadgen.unexpected_messages++;
+  }
+  free_s1ap_uecontextreleasecommand (&ies);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_s1ap_handle_paging (loadgen_enb_t * const enb, ANY_t * const value)
+{
+  S1ap_PagingIEs_t                        ies;
+
+  if (s1ap_decode_s1ap_pagingies (&ies, value) < 0) {
+    loadgen.unexpected_messages++;
+    return;
+  }
+  if ((S1ap_UEPagingID_PR_s_TMSI == ies.uePagingID.present) && (4 == ies.uePagingID.choice.s_TMSI.m_TMSI.size)) {
+    const uint8_t * const                 m_tmsi = ies.uePagingID.choice.s_TMSI.m_TMSI.buf;
+
+    loadgen_enb_paging (enb, ((uint32_t)m_tmsi[0] << 24) | ((uint32_t)m_tmsi[1] << 16) | ((uint32_t)m_tmsi[2] << 8) | m_tmsi[3]);
+  }
+  free_s1ap_paging (&ies);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_s1ap_handle_pdu (loadgen_enb_t * const enb, const uint8_t * const buffer, const int length)
+{
+  S1AP_PDU_t                              pdu;
+  S1AP_PDU_t                             *pdu_p = &pdu;
+  asn_dec_rval_t                          dec_ret = {(RC_OK)};
+
+  memset (&pdu, 0, sizeof (pdu));
+  dec_ret = aper_decode (NULL, &asn_DEF_S1AP_PDU, (void **)&pdu_p, buffer, length, 0, 0);
+  if (dec_ret.code != RC_OK) {
+    loadgen.unexpected_messages++;
+    ASN_STRUCT_FREE_CONTENTS_ONLY (asn_DEF_S1AP_PDU, &pdu);
+    return;
+  }
+
+  switch (pdu.present) {
+  case S1AP_PDU_PR_initiatingMessage:
+    switch (pdu.choice.initiatingMessage.procedureCode) {
+    case S1ap_ProcedureCode_id_downlinkNASTransport:
+      loadgen_s1ap_handle_downlink_nas_transport (&pdu.choice.initiatingMessage.value);
+      break;
+    case S1ap_ProcedureCode_id_InitialContextSetup:
+      loadgen_s1ap_handle_initial_context_setup_request (&pdu.choice.initiatingMessage.value);
+      break;
+    case S1ap_ProcedureCode_id_UEContextRelease:
+      loadgen_s1ap_handle_ue_context_release_command (enb, &pdu.choice.initiatingMessage.value);
+      break;
+    case S1ap_ProcedureCode_id_Paging:
+      loadgen_s1ap_handle_paging (enb, &pdu.choice.initiatingMessage.value);
+      break;
+    default:
+      loadgen.unexpected_messages++;
+      break;
+    }
+    break;
+  case S1AP_PDU_PR_successfulOutcome:
+    if (S1ap_ProcedureCode_id_S1Setup == pdu.choice.successfulOutcome.procedureCode) {
+      loadgen_enb_s1_setup_result (enb, true);
+    } else {
+      loadgen.unexpected_messages++;
+    }
+    break;
+  case S1AP_PDU_PR_unsuccessfulOutcome:
+    if (S1ap_ProcedureCode_id_S1Setup == pdu.choice.unsuccessfulOutcome.procedureCode) {
+      loadgen_enb_s1_setup_result (enb, false);
+    } else {
+      loadgen.unexpected_messages++;
+    }
+    break;
+  default:
+    loadgen.unexpected_messages++;
+    break;
+  }
+  ASN_STRUCT_FREE_CONTENTS_ONLY (asn_DEF_S1AP_PDU, &pdu);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_receive (loadgen_enb_t * const enb)
+{
+  uint8_t                                 buffer[LOADGEN_S1AP_RECV_BUFFER_SIZE];
+
+  // bounded so that a busy association does not starve the others, epoll reports it again
+  for (int i = 0; i < LOADGEN_S1AP_RECV_BURST; i++) {
+    struct sctp_sndrcvinfo                sinfo;
+    int                                   flags = 0;
+    int                                   n = 0;
+
+    memset (&sinfo, 0, sizeof (sinfo));
+    n = sctp_recvmsg (enb->sd, buffer, sizeof (buffer), NULL, NULL, &sinfo, &flags);
+    if (n < 0) {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+        return 0;
+      }
+      fprintf (stderr, "eNB %u: SCTP receive failed: %s\n", enb->enb_id, strerror (errno));
+      return -1;
+    }
+    if (0 == n) {
+      fprintf (stderr, "eNB %u: association closed by the MME\n", enb->enb_id);
+      return -1;
+    }
+    if (flags & MSG_NOTIFICATION) {
+      continue;
+    }
+    loadgen_s1ap_handle_pdu (enb, buffer, n);
+  }
+  return 0;
+}
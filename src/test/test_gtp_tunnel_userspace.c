@@ -0,0 +1,320 @@
+#define _GNU_SOURCE
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* the tunnel tables and the GTP-U header parser are static to the engine */
+#undef _GNU_SOURCE
+#include "gtp_tunnel_userspace.c"
+
+#define TEST_MAX_TUNNELS 64
+#define TEST_DL_BUFFER_PACKETS 4
+#define TEST_DL_POOL_PACKETS 8
+#define TEST_DL_TTL_MS 1000
+
+spgw_config_t spgw_config;
+
+int sgw_notify_downlink_data(const struct in_addr ue_ip, const ebi_t ebi)
+{
+    return RETURNok;
+}
+
+static void tables_setup(void)
+{
+    memset(&gtpu_us, 0, sizeof(gtpu_us));
+    ck_assert_int_eq(gtpu_us_tables_init(TEST_MAX_TUNNELS), RETURNok);
+    gtpu_us.dl_buffer_packets = TEST_DL_BUFFER_PACKETS;
+    gtpu_us.dl_buffer_ttl_ms  = TEST_DL_TTL_MS;
+    gtpu_us.flush_fd          = -1;
+    ck_assert_int_eq(gtpu_us_dl_pool_init(TEST_DL_POOL_PACKETS), RETURNok);
+    gtpu_us.is_enabled = true;
+}
+
+static void tables_teardown(void)
+{
+    gtpu_us_tables_free();
+    gtpu_us.is_enabled = false;
+}
+
+static const gtpu_us_tunnel_t *ue_tunnel(const uint32_t ue)
+{
+    return gtpu_us_fht_get(&gtpu_us.ue_table, htonl(ue));
+}
+
+static void dl_enqueue(gtpu_us_worker_t *w, const teid_t i_tei, const uint8_t id, const uint64_t now_ms)
+{
+    uint8_t ip[20] = {0x45};
+
+    ip[19] = id;
+    gtpu_us_dl_buffer_enqueue(w, gtpu_us_fht_get(&gtpu_us.teid_table, i_tei), ip, sizeof(ip), now_ms);
+}
+
+START_TEST(header_length_test)
+{
+    /* G-PDU, no optional field, 4 bytes of payload */
+    uint8_t gpdu[12] = {0x30, 0xff, 0x00, 0x04, 0x00, 0x00, 0x00, 0x01};
+    /* G-PDU with sequence number and one 4 bytes extension header, 4 bytes of payload */
+    uint8_t gpdu_ext[20] = {0x36, 0xff, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x85,
+                            0x01, 0x00, 0x05, 0x00};
+
+    ck_assert_uint_eq(gtpu_us_header_length(gpdu, sizeof(gpdu)), 8);
+    ck_assert_uint_eq(gtpu_us_header_length(gpdu_ext, sizeof(gpdu_ext)), 16);
+
+    /* shorter than the header, or than the length field */
+    ck_assert_uint_eq(gtpu_us_header_length(gpdu, 7), 0);
+    ck_assert_uint_eq(gtpu_us_header_length(gpdu, 11), 0);
+    /* GTP' or version 2 */
+    gpdu[0] = 0x20;
+    ck_assert_uint_eq(gtpu_us_header_length(gpdu, sizeof(gpdu)), 0);
+    gpdu[0] = 0x50;
+    ck_assert_uint_eq(gtpu_us_header_length(gpdu, sizeof(gpdu)), 0);
+    /* extension header running past the datagram */
+    gpdu_ext[12] = 0x03;
+    ck_assert_uint_eq(gtpu_us_header_length(gpdu_ext, sizeof(gpdu_ext)), 0);
+    /* zero length extension header */
+    gpdu_ext[12] = 0x00;
+    ck_assert_uint_eq(gtpu_us_header_length(gpdu_ext, sizeof(gpdu_ext)), 0);
+}
+END_TEST
+
+START_TEST(flat_hash_table_test)
+{
+    gtpu_us_fht_t fht = {0};
+    uint32_t      i;
+
+    memset(&gtpu_us, 0, sizeof(gtpu_us));
+    gtpu_us.tunnels = calloc(TEST_MAX_TUNNELS, sizeof(gtpu_us_tunnel_t));
+    ck_assert_int_eq(gtpu_us_fht_init(&fht, TEST_MAX_TUNNELS), RETURNok);
+
+    for (i = 0; i < TEST_MAX_TUNNELS; i++) {
+        ck_assert_int_eq(gtpu_us_fht_insert(&fht, 1000 + i, i), RETURNok);
+    }
+    for (i = 0; i < TEST_MAX_TUNNELS; i++) {
+        ck_assert_ptr_eq(gtpu_us_fht_get(&fht, 1000 + i), &gtpu_us.tunnels[i]);
+    }
+    ck_assert_ptr_null(gtpu_us_fht_get(&fht, 999));
+
+    /* removed keys do not hide the keys probed after them, even once purged */
+    for (i = 0; i < TEST_MAX_TUNNELS; i += 2) {
+        gtpu_us_fht_remove(&fht, 1000 + i, i);
+    }
+    gtpu_us_fht_purge_deleted(&fht);
+    ck_assert_uint_eq(fht.num_deleted, 0);
+    for (i = 0; i < TEST_MAX_TUNNELS; i++) {
+        if (i & 1) {
+            ck_assert_ptr_eq(gtpu_us_fht_get(&fht, 1000 + i), &gtpu_us.tunnels[i]);
+        } else {
+            ck_assert_ptr_null(gtpu_us_fht_get(&fht, 1000 + i));
+        }
+    }
+
+    /* a key is only removed by the tunnel it points to */
+    gtpu_us_fht_remove(&fht, 1001, 3);
+    ck_assert_ptr_eq(gtpu_us_fht_get(&fht, 1001), &gtpu_us.tunnels[1]);
+
+    gtpu_us_fht_free(&fht);
+    free_wrapper((void**)&gtpu_us.tunnels);
+}
+END_TEST
+
+START_TEST(ue_bearers_test)
+{
+    const struct in_addr ue = {.s_addr = htonl(0xac100002)};
+    const struct in_addr enb = {.s_addr = htonl(0xc0a80c02)};
+
+    tables_setup();
+
+    /* dedicated bearer installed before the default bearer */
+    ck_assert_int_eq(gtpu_us_add_tunnel(ue, enb, 0x102, 0x202, 6), RETURNok);
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->ebi, 6);
+    ck_assert_int_eq(gtpu_us_add_tunnel(ue, enb, 0x101, 0x201, 5), RETURNok);
+    ck_assert_int_eq(gtpu_us_add_tunnel(ue, enb, 0x103, 0x203, 7), RETURNok);
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->ebi, 5);
+
+    /* Modify Bearer Request of an installed bearer */
+    ck_assert_int_eq(gtpu_us_add_tunnel(ue, enb, 0x101, 0x301, 5), RETURNok);
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->o_tei, 0x301);
+    ck_assert_uint_eq(gtpu_us.num_free_slots, TEST_MAX_TUNNELS - 3);
+
+    /* release access bearers reaches every bearer of the UE */
+    ck_assert_int_eq(gtpu_us_del_tunnel(ue, INVALID_TEID, 0x203), RETURNok);
+    ck_assert_uint_eq(gtpu_us_fht_get(&gtpu_us.teid_table, 0x103)->o_tei, INVALID_TEID);
+    ck_assert_uint_eq(gtpu_us_fht_get(&gtpu_us.teid_table, 0x102)->o_tei, 0x202);
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->o_tei, 0x301);
+
+    /* deleting the default bearer keeps the UE reachable on its dedicated bearers */
+    ck_assert_int_eq(gtpu_us_del_tunnel(ue, 0x101, 0x301), RETURNok);
+    ck_assert_ptr_null(gtpu_us_fht_get(&gtpu_us.teid_table, 0x101));
+    ck_assert_ptr_nonnull(ue_tunnel(0xac100002));
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->ebi, 6);
+
+    ck_assert_int_eq(gtpu_us_del_tunnel(ue, 0x103, INVALID_TEID), RETURNok);
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->ebi, 6);
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->next_ue_tunnel, 0);
+    ck_assert_int_eq(gtpu_us_del_tunnel(ue, 0x102, 0x202), RETURNok);
+    ck_assert_ptr_null(ue_tunnel(0xac100002));
+    ck_assert_uint_eq(gtpu_us.num_free_slots, TEST_MAX_TUNNELS);
+
+    tables_teardown();
+}
+END_TEST
+
+START_TEST(tunnel_slots_test)
+{
+    const struct in_addr enb = {.s_addr = htonl(0xc0a80c02)};
+    uint32_t             i;
+
+    tables_setup();
+
+    for (i = 0; i < TEST_MAX_TUNNELS; i++) {
+        const struct in_addr ue = {.s_addr = htonl(0xac100002 + i)};
+        ck_assert_int_eq(gtpu_us_add_tunnel(ue, enb, 0x100 + i, 0x200 + i, 5), RETURNok);
+    }
+    ck_assert_int_eq(gtpu_us_add_tunnel((struct in_addr){.s_addr = htonl(0xac100001)}, enb, 0x1ff, 0x2ff, 5), RETURNerror);
+
+    /* enough deletions to purge the deleted buckets of both tables */
+    for (i = 0; i < TEST_MAX_TUNNELS; i += 2) {
+        const struct in_addr ue = {.s_addr = htonl(0xac100002 + i)};
+        ck_assert_int_eq(gtpu_us_del_tunnel(ue, 0x100 + i, 0x200 + i), RETURNok);
+    }
+    for (i = 0; i < TEST_MAX_TUNNELS; i++) {
+        const gtpu_us_tunnel_t *t = ue_tunnel(0xac100002 + i);
+        if (i & 1) {
+            ck_assert_ptr_nonnull(t);
+            ck_assert_uint_eq(t->i_tei, 0x100 + i);
+            ck_assert_ptr_eq(gtpu_us_fht_get(&gtpu_us.teid_table, 0x100 + i), t);
+        } else {
+            ck_assert_ptr_null(t);
+            ck_assert_ptr_null(gtpu_us_fht_get(&gtpu_us.teid_table, 0x100 + i));
+        }
+    }
+    ck_assert_uint_eq(gtpu_us.num_free_slots, TEST_MAX_TUNNELS / 2);
+
+    tables_teardown();
+}
+END_TEST
+
+START_TEST(dl_buffer_test)
+{
+    const struct in_addr ue = {.s_addr = htonl(0xac100002)};
+    const struct in_addr ue2 = {.s_addr = htonl(0xac100003)};
+    const struct in_addr enb = {.s_addr = htonl(INADDR_LOOPBACK)};
+    gtpu_us_worker_t     w = {0};
+    uint64_t             now_ms = gtpu_us_now_ms();
+    uint8_t              i;
+
+    tables_setup();
+    ck_assert_int_eq(gtpu_us_add_tunnel(ue, enb, 0x101, 0x201, 5), RETURNok);
+    ck_assert_int_eq(gtpu_us_add_tunnel(ue2, enb, 0x102, 0x202, 5), RETURNok);
+    ck_assert_int_eq(gtpu_us_del_tunnel(ue, INVALID_TEID, 0x201), RETURNok);
+    ck_assert_int_eq(gtpu_us_del_tunnel(ue2, INVALID_TEID, 0x202), RETURNok);
+
+    /* the oldest packets of a full bearer buffer are reused */
+    for (i = 0; i < TEST_DL_BUFFER_PACKETS + 2; i++) {
+        dl_enqueue(&w, 0x101, i, now_ms);
+    }
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->dl_count, TEST_DL_BUFFER_PACKETS);
+    ck_assert_uint_eq(gtpu_us_dl_pkt(ue_tunnel(0xac100002)->dl_head)->data[GTPU_HEADER_MIN_SIZE + 19], 2);
+    ck_assert_uint_eq(w.stats.drop_buffer_full, 2);
+    ck_assert_uint_eq(gtpu_us.dl_pool_num_free, TEST_DL_POOL_PACKETS - TEST_DL_BUFFER_PACKETS);
+
+    /* expired packets go back to the pool */
+    dl_enqueue(&w, 0x101, 10, now_ms + TEST_DL_TTL_MS + 1);
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->dl_count, 1);
+    ck_assert_uint_eq(w.stats.drop_buffer_expired, TEST_DL_BUFFER_PACKETS);
+    ck_assert_uint_eq(gtpu_us.dl_pool_num_free, TEST_DL_POOL_PACKETS - 1);
+
+    /* an empty pool drops the packets of bearers with nothing buffered */
+    for (i = 0; i < TEST_DL_POOL_PACKETS; i++) {
+        dl_enqueue(&w, 0x102, i, now_ms);
+    }
+    ck_assert_uint_eq(ue_tunnel(0xac100003)->dl_count, TEST_DL_BUFFER_PACKETS);
+    ck_assert_uint_eq(gtpu_us.dl_pool_num_free, TEST_DL_POOL_PACKETS - 1 - TEST_DL_BUFFER_PACKETS);
+    ck_assert_int_eq(gtpu_us_del_tunnel(ue2, 0x102, INVALID_TEID), RETURNok);
+    ck_assert_uint_eq(gtpu_us.dl_pool_num_free, TEST_DL_POOL_PACKETS - 1);
+
+    tables_teardown();
+}
+END_TEST
+
+START_TEST(dl_flush_test)
+{
+    const struct in_addr ue = {.s_addr = htonl(0xac100002)};
+    const struct in_addr enb = {.s_addr = htonl(INADDR_LOOPBACK)};
+    struct sockaddr_in   s1u = {.sin_family = AF_INET, .sin_port = htons(GTPV1U_UDP_PORT), .sin_addr = enb};
+    gtpu_us_worker_t     w = {0};
+    uint64_t             now_ms = gtpu_us_now_ms();
+    uint8_t              rx[64];
+    int                  enb_fd;
+    uint8_t              i;
+
+    tables_setup();
+    gtpu_us.flush_fd = gtpu_us_flush_open(enb);
+    ck_assert_int_ge(gtpu_us.flush_fd, 0);
+    /* the eNB side is only checked when the GTP-U port is free on this host */
+    enb_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (bind(enb_fd, (struct sockaddr *)&s1u, sizeof(s1u)) < 0) {
+        close(enb_fd);
+        enb_fd = -1;
+    }
+
+    ck_assert_int_eq(gtpu_us_add_tunnel(ue, enb, 0x101, 0x201, 5), RETURNok);
+    ck_assert_int_eq(gtpu_us_del_tunnel(ue, INVALID_TEID, 0x201), RETURNok);
+    for (i = 0; i < 3; i++) {
+        dl_enqueue(&w, 0x101, i, now_ms);
+    }
+
+    /* Modify Bearer Request: the buffer is sent in order on the new tunnel and given back */
+    ck_assert_int_eq(gtpu_us_add_tunnel(ue, enb, 0x101, 0x301, 5), RETURNok);
+    ck_assert_uint_eq(ue_tunnel(0xac100002)->dl_count, 0);
+    ck_assert(!ue_tunnel(0xac100002)->dl_flushing);
+    ck_assert_uint_eq(gtpu_us.flush_stats.dl_flushed, 3);
+    ck_assert_uint_eq(gtpu_us.dl_pool_num_free, TEST_DL_POOL_PACKETS);
+    for (i = 0; (enb_fd >= 0) && (i < 3); i++) {
+        ck_assert_int_eq(recv(enb_fd, rx, sizeof(rx), 0), GTPU_HEADER_MIN_SIZE + 20);
+        ck_assert_uint_eq(rx[1], GTPU_MSG_G_PDU);
+        ck_assert_uint_eq(((uint32_t)rx[4] << 24) | ((uint32_t)rx[5] << 16) | ((uint32_t)rx[6] << 8) | rx[7], 0x301);
+        ck_assert_uint_eq(rx[GTPU_HEADER_MIN_SIZE + 19], i);
+    }
+
+    if (enb_fd >= 0) close(enb_fd);
+    close(gtpu_us.flush_fd);
+    tables_teardown();
+}
+END_TEST
+
+Suite * gtp_tunnel_userspace_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("GTP-U userspace engine tests");
+
+    /* Core test case */
+    tc_core = tcase_create("GTP-U userspace tunnel tables test");
+    tcase_add_test(tc_core, header_length_test);
+    tcase_add_test(tc_core, flat_hash_table_test);
+    tcase_add_test(tc_core, ue_bearers_test);
+    tcase_add_test(tc_core, tunnel_slots_test);
+    tcase_add_test(tc_core, dl_buffer_test);
+    tcase_add_test(tc_core, dl_flush_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = gtp_tunnel_userspace_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,186 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <check.h>
+
+#include "log_binary.h"
+
+#define TEST_LOG_BINARY_TEXT_MAX 1024
+
+typedef struct test_log_binary_s {
+  bool    is_supported;
+  bool    is_rendered;
+  char    expected[TEST_LOG_BINARY_TEXT_MAX];
+  char   *rendered;
+} test_log_binary_t;
+
+// encode the arguments as a logging thread does, render them as oai_log_decode does
+static void test_log_binary_round_trip (test_log_binary_t * const result, const char * const format, ...)
+{
+  uint8_t  buffer[LOG_BINARY_RECORD_MAX];
+  char     signature[LOG_BINARY_ARGS_MAX];
+  int      nb_args = 0;
+  size_t   length = 0;
+  size_t   rendered_size = 0;
+  FILE    *out = NULL;
+  va_list  args;
+
+  memset (result, 0, sizeof (*result));
+  va_start (args, format);
+  vsnprintf (result->expected, sizeof (result->expected), format, args);
+  va_end (args);
+
+  result->is_supported = log_binary_format_signature (format, signature, &nb_args);
+  if (!result->is_supported) return;
+
+  va_start (args, format);
+  length = log_binary_encode_args (buffer, 0, sizeof (buffer), signature, nb_args, args);
+  va_end (args);
+
+  out = open_memstream (&result->rendered, &rendered_size);
+  result->is_rendered = log_binary_render (out, format, buffer, length);
+  fclose (out);
+}
+
+#define ck_assert_round_trip(fOrMaT, ...) do {                                  \
+    test_log_binary_t rEsUlT;                                                   \
+    test_log_binary_round_trip (&rEsUlT, fOrMaT, ##__VA_ARGS__);                \
+    ck_assert_msg (rEsUlT.is_supported, "format not supported: %s", fOrMaT);    \
+    ck_assert_msg (rEsUlT.is_rendered, "truncated arguments: %s", fOrMaT);      \
+    ck_assert_str_eq (rEsUlT.rendered, rEsUlT.expected);                        \
+    free (rEsUlT.rendered);                                                     \
+  } while (0)
+
+START_TEST(log_binary_integers_test)
+{
+  ck_assert_round_trip ("%d %i %u %x %X %o", -12, 34, 4000000000U, 0xbeef, 0xCAFE, 0755);
+  ck_assert_round_trip ("%ld %lu %lld %llx", -1L, 1UL << 40, -(1LL << 50), 0x123456789abcdefULL);
+  ck_assert_round_trip ("%zu %jd %td", (size_t)123456789012, (intmax_t)-42, (ptrdiff_t)-7);
+  ck_assert_round_trip ("%" PRIu64 " %" PRIx32 " %" PRId16, UINT64_MAX, UINT32_MAX, INT16_MIN);
+  ck_assert_round_trip ("%c%c%c", 'o', 'a', 'i');
+}
+END_TEST
+
+START_TEST(log_binary_short_char_test)
+{
+  // the arguments are promoted to int, printed back as short/char
+  ck_assert_round_trip ("%hx %hhx", -1, -1);
+  ck_assert_round_trip ("%hd %hu %hhd %hhu", 70000, 70000, 300, 300);
+  ck_assert_round_trip ("%04hX %02hhX", (short)0xABCD, (signed char)0xEF);
+  ck_assert_round_trip ("%" PRIx8 " %" PRIu8 " %" PRIi16, (uint8_t)0xfe, (uint8_t)255, (int16_t)-2);
+}
+END_TEST
+
+START_TEST(log_binary_flags_width_precision_test)
+{
+  ck_assert_round_trip ("[%-8d] [%+d] [% d] [%#x] [%08.3f]", 5, 6, 7, 255, 3.14159);
+  ck_assert_round_trip ("[%*d] [%-*d] [%.*s] [%*.*f]", 6, 42, 4, 1, 3, "abcdef", 10, 2, 2.5);
+  ck_assert_round_trip ("%f %e %g %a", 1.5, -2.25e-10, 1e100, 0.125);
+  ck_assert_round_trip ("100%% %d%%", 50);
+}
+END_TEST
+
+START_TEST(log_binary_strings_pointers_test)
+{
+  char *null_string = NULL;
+
+  ck_assert_round_trip ("%s", "");
+  ck_assert_round_trip ("<%s> <%10s> <%-10s|>", "a", "bcd", "efg");
+  ck_assert_round_trip ("%s then %d", null_string, 3);
+  ck_assert_round_trip ("%p %p", (void *)0x7fff12345678, (void *)NULL);
+  ck_assert_round_trip ("no argument");
+}
+END_TEST
+
+START_TEST(log_binary_long_string_test)
+{
+  char               long_string[LOG_BINARY_STRING_MAX + 100];
+  test_log_binary_t  result;
+
+  memset (long_string, 'x', sizeof (long_string) - 1);
+  long_string[sizeof (long_string) - 1] = '\0';
+  test_log_binary_round_trip (&result, "%s|%d", long_string, 9);
+  ck_assert (result.is_supported);
+  ck_assert (result.is_rendered);
+  // truncated to LOG_BINARY_STRING_MAX, the following arguments are kept
+  ck_assert_int_eq (strlen (result.rendered), LOG_BINARY_STRING_MAX + 2);
+  ck_assert_str_eq (&result.rendered[LOG_BINARY_STRING_MAX], "|9");
+  free (result.rendered);
+}
+END_TEST
+
+START_TEST(log_binary_unsupported_test)
+{
+  char  signature[LOG_BINARY_ARGS_MAX];
+  int   nb_args = 0;
+
+  ck_assert (!log_binary_format_signature ("%n", signature, &nb_args));
+  ck_assert (!log_binary_format_signature ("%Lf", signature, &nb_args));
+  ck_assert (!log_binary_format_signature ("%ls", signature, &nb_args));
+  ck_assert (!log_binary_format_signature ("%1$d", signature, &nb_args));
+  ck_assert (log_binary_format_signature ("%hhu %lld %s %p %f", signature, &nb_args));
+  ck_assert_int_eq (nb_args, 5);
+  ck_assert (0 == memcmp (signature, "ilspd", 5));
+}
+END_TEST
+
+Suite *log_binary_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Binary log tests");
+
+    tc_core = tcase_create("Encode render");
+    tcase_add_test(tc_core, log_binary_integers_test);
+    tcase_add_test(tc_core, log_binary_short_char_test);
+    tcase_add_test(tc_core, log_binary_flags_width_precision_test);
+    tcase_add_test(tc_core, log_binary_strings_pointers_test);
+    tcase_add_test(tc_core, log_binary_long_string_test);
+    tcase_add_test(tc_core, log_binary_unsupported_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = log_binary_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,489 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+/*
+ * The checkpoint is tested alone: the MME_APP and EMM collections are plain hash tables,
+ * the ITTI messages exchanged with the NAS EMM task are handed over by the test.
+ */
+#include "mme_app_checkpoint.c"
+
+#define TEST_CHECKPOINT_SLOTS     8
+
+mme_app_desc_t                            mme_app_desc;
+
+static MessageDef                        *test_sent_message = NULL;
+static bool                               test_drop_messages = false;
+static mme_ue_s1ap_id_t                   test_reserved_ue_id = 0;
+static teid_t                             test_reserved_teid = 0;
+static char                               test_checkpoint_file[] = "/tmp/test_mme_app_checkpoint.XXXXXX";
+
+//------------------------------------------------------------------------------
+// Stubs of the log, MME_APP, EMM and ITTI functions used by the checkpoint
+//------------------------------------------------------------------------------
+log_level_t g_oai_log_level[MAX_LOG_PROTOS] = {[0 ... MAX_LOG_PROTOS - 1] = OAILOG_LEVEL_WARNING};
+
+void log_message (log_thread_ctxt_t * const thread_ctxtP, const log_level_t log_levelP, const log_proto_t protoP,
+    const char *const source_fileP, const unsigned int line_numP, char *format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  vfprintf (stderr, format, args);
+  va_end (args);
+}
+
+void log_func (bool is_entering, const log_proto_t protoP, const char *const source_fileP, const unsigned int line_numP, const char *const function)
+{
+}
+
+void log_func_return (const log_proto_t protoP, const char *const source_fileP, const unsigned int line_numP, const char *const functionP, const long return_codeP)
+{
+}
+
+MessageDef *itti_alloc_new_message (task_id_t origin_task_id, MessagesIds message_id)
+{
+  MessageDef *message_p = calloc (1, sizeof (MessageDef));
+
+  message_p->ittiMsgHeader.messageId = message_id;
+  message_p->ittiMsgHeader.originTaskId = origin_task_id;
+  return message_p;
+}
+
+int itti_send_msg_to_task (task_id_t task_id, instance_t instance, MessageDef *message)
+{
+  if (test_drop_messages) {
+    if (NAS_CHECKPOINT_RSP == message->ittiMsgHeader.messageId) {
+      free_wrapper ((void**)&NAS_CHECKPOINT_RSP (message).ues_ptr);
+    }
+    free (message);
+    return -1;
+  }
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  test_sent_message = message;
+  return RETURNok;
+}
+
+ue_context_t *mme_create_new_ue_context (void)
+{
+  ue_context_t *ue_context = calloc (1, sizeof (ue_context_t));
+
+  RB_INIT (&ue_context->pdn_contexts);
+  return ue_context;
+}
+
+int mme_insert_ue_context (mme_ue_context_t * const mme_ue_context, const struct ue_context_s * const ue_context)
+{
+  return (HASH_TABLE_OK == hashtable_ts_insert (mme_ue_context->mme_ue_s1ap_id_ue_context_htbl,
+      (const hash_key_t)ue_context->mme_ue_s1ap_id, (void *)ue_context)) ? RETURNok : RETURNerror;
+}
+
+void mme_remove_ue_context (mme_ue_context_t * const mme_ue_context, struct ue_context_s * const ue_context)
+{
+  hashtable_ts_free (mme_ue_context->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context->mme_ue_s1ap_id);
+}
+
+void mme_app_ue_context_free_content (ue_context_t * const ue_context)
+{
+  pdn_context_t *pdn_context = NULL;
+
+  bdestroy_wrapper (&ue_context->msisdn);
+  bdestroy_wrapper (&ue_context->apn_oi_replacement);
+  for (int i = 0; i < MAX_NUM_BEARERS_UE; i++) {
+    if (ue_context->bearer_contexts[i]) free_wrapper ((void**)&ue_context->bearer_contexts[i]);
+  }
+  while ((pdn_context = RB_MIN (PdnContexts, &ue_context->pdn_contexts))) {
+    RB_REMOVE (PdnContexts, &ue_context->pdn_contexts, pdn_context);
+    bdestroy_wrapper (&pdn_context->apn_in_use);
+    bdestroy_wrapper (&pdn_context->apn_subscribed);
+    bdestroy_wrapper (&pdn_context->apn_oi_replacement);
+    if (pdn_context->paa) free_wrapper ((void**)&pdn_context->paa);
+    free_wrapper ((void**)&pdn_context);
+  }
+}
+
+bearer_context_t *mme_app_new_ue_bearer_context (ue_context_t * const ue_context, const ebi_t ebi)
+{
+  bearer_context_t *bearer_context = calloc (1, sizeof (bearer_context_t));
+
+  bearer_context->ebi = ebi;
+  ue_context->bearer_contexts[EBI_TO_INDEX (ebi)] = bearer_context;
+  return bearer_context;
+}
+
+void mme_app_ctx_reserve_ue_id (const mme_ue_s1ap_id_t ue_id)
+{
+  if (ue_id > test_reserved_ue_id) test_reserved_ue_id = ue_id;
+}
+
+void mme_app_reserve_s11_teid (const teid_t teid)
+{
+  if (teid > test_reserved_teid) test_reserved_teid = teid;
+}
+
+void mme_app_idle_ue_expand (struct ue_context_s * const ue_context)
+{
+  ck_abort_msg ("no compacted UE in this test");
+}
+
+void emm_init_context (struct emm_data_context_s * const emm_context, const bool init_esm_ctxt)
+{
+}
+
+int emm_data_context_add (emm_data_t * emm_data, struct emm_data_context_s *elm)
+{
+  return (HASH_TABLE_OK == hashtable_ts_insert (emm_data->ctx_coll_ue_id, (const hash_key_t)elm->ue_id, elm)) ? RETURNok : RETURNerror;
+}
+
+struct emm_data_context_s *emm_data_context_remove (emm_data_t * emm_data, struct emm_data_context_s *elm, bool clear_fields)
+{
+  hashtable_ts_remove (emm_data->ctx_coll_ue_id, (const hash_key_t)elm->ue_id, (void **)&elm);
+  return elm;
+}
+
+//------------------------------------------------------------------------------
+// The RB trees of mme_app_ue_context.c, PDN contexts ordered by context identifier
+//------------------------------------------------------------------------------
+static int test_compare_pdn_context (struct pdn_context_s *a, struct pdn_context_s *b)
+{
+  return (a->context_identifier > b->context_identifier) - (a->context_identifier < b->context_identifier);
+}
+
+static int test_compare_bearer_context (struct bearer_context_s *a, struct bearer_context_s *b)
+{
+  return (a->ebi > b->ebi) - (a->ebi < b->ebi);
+}
+
+#define mme_app_compare_pdn_context    test_compare_pdn_context
+#define mme_app_compare_bearer_context test_compare_bearer_context
+RB_GENERATE (PdnContexts, pdn_context_s, pdnCtxRbtNode, mme_app_compare_pdn_context)
+RB_GENERATE (SessionBearers, bearer_context_s, bearerContextRbtNode, mme_app_compare_bearer_context)
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+static void test_free_ue_context (void **ue_context_p)
+{
+  mme_app_ue_context_free_content ((ue_context_t *)*ue_context_p);
+  free_wrapper (ue_context_p);
+}
+
+static void test_collections_create (void)
+{
+  mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl = hashtable_ts_create (64, NULL, test_free_ue_context, NULL);
+  _emm_data.ctx_coll_ue_id = hashtable_ts_create (64, NULL, NULL, NULL);
+}
+
+static void test_collections_destroy (void)
+{
+  hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl);
+  hashtable_ts_destroy (_emm_data.ctx_coll_ue_id);
+}
+
+static void test_add_ue (const mme_ue_s1ap_id_t ue_id, const int nb_pdns)
+{
+  ue_context_t       *ue_context = mme_create_new_ue_context ();
+  emm_data_context_t *emm_context = calloc (1, sizeof (emm_data_context_t));
+
+  ue_context->mme_ue_s1ap_id = ue_id;
+  ue_context->imsi = 208950000000000 + ue_id;
+  ue_context->mme_teid_s11 = 0x1000 + ue_id;
+  ue_context->mm_state = UE_REGISTERED;
+  ue_context->msisdn = bformat ("3361234%04u", ue_id);
+  ue_context->apn_oi_replacement = bformat ("ue%u.mnc095.mcc208.gprs", ue_id);
+  for (int i = 0; i < nb_pdns; i++) {
+    pdn_context_t    *pdn_context = calloc (1, sizeof (pdn_context_t));
+    bearer_context_t *bearer_context = mme_app_new_ue_bearer_context (ue_context, 5 + i);
+
+    pdn_context->context_identifier = i;
+    pdn_context->default_ebi = 5 + i;
+    pdn_context->apn_in_use = bformat ("apn%d.ue%u", i, ue_id);
+    pdn_context->apn_subscribed = bformat ("apn%d", i);
+    pdn_context->apn_oi_replacement = bformat ("pdn%d.mnc095.mcc208.gprs", i);
+    RB_INIT (&pdn_context->session_bearers);
+    RB_INSERT (PdnContexts, &ue_context->pdn_contexts, pdn_context);
+    bearer_context->linked_ebi = 5 + i;
+    bearer_context->s_gw_fteid_s1u.teid = 0x2000 + ue_id * 16 + i;
+    RB_INSERT (SessionBearers, &pdn_context->session_bearers, bearer_context);
+  }
+  ck_assert_int_eq (mme_insert_ue_context (&mme_app_desc.mme_ue_contexts, ue_context), RETURNok);
+
+  emm_context->ue_id = ue_id;
+  emm_context->_emm_fsm_state = EMM_REGISTERED;
+  emm_context->_guti.m_tmsi = 0xc0000000 + ue_id;
+  emm_context->_security.ul_count.seq_num = ue_id & 0xff;
+  emm_context->member_present_mask = EMM_CTXT_MEMBER_GUTI | EMM_CTXT_MEMBER_SECURITY;
+  emm_context->member_valid_mask = EMM_CTXT_MEMBER_GUTI | EMM_CTXT_MEMBER_SECURITY;
+  ck_assert_int_eq (emm_data_context_add (&_emm_data, emm_context), RETURNok);
+}
+
+static void test_remove_ue (const mme_ue_s1ap_id_t ue_id)
+{
+  emm_data_context_t *emm_context = NULL;
+
+  hashtable_ts_free (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_id);
+  hashtable_ts_remove (_emm_data.ctx_coll_ue_id, (const hash_key_t)ue_id, (void **)&emm_context);
+  free_wrapper ((void**)&emm_context);
+}
+
+// run a snapshot, the NAS EMM task answers the request
+static void test_snapshot (void)
+{
+  MessageDef *message_p = NULL;
+
+  mme_app_checkpoint_snapshot ();
+  message_p = test_sent_message;
+  test_sent_message = NULL;
+  ck_assert_ptr_ne (message_p, NULL);
+  ck_assert_int_eq (message_p->ittiMsgHeader.messageId, NAS_CHECKPOINT_REQ);
+  mme_app_checkpoint_emm_snapshot (&NAS_CHECKPOINT_REQ (message_p));
+  free (message_p);
+
+  message_p = test_sent_message;
+  test_sent_message = NULL;
+  ck_assert_ptr_ne (message_p, NULL);
+  ck_assert_int_eq (message_p->ittiMsgHeader.messageId, NAS_CHECKPOINT_RSP);
+  mme_app_checkpoint_handle_emm_snapshot (&NAS_CHECKPOINT_RSP (message_p));
+  ck_assert_uint_eq (checkpoint.pending_round, 0);
+  free_wrapper ((void**)&NAS_CHECKPOINT_RSP (message_p).ues_ptr);
+  free (message_p);
+}
+
+// empty the collections and restore them from the checkpoint file
+static void test_restart (void)
+{
+  mme_app_checkpoint_exit ();
+  test_collections_destroy ();
+  test_collections_create ();
+  ck_assert_int_eq (mme_app_checkpoint_init (test_checkpoint_file, TEST_CHECKPOINT_SLOTS), RETURNok);
+}
+
+static uint32_t test_nb_ues (void)
+{
+  return mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl->num_elements;
+}
+
+static void setup (void)
+{
+  int fd = -1;
+
+  strcpy (test_checkpoint_file, "/tmp/test_mme_app_checkpoint.XXXXXX");
+  fd = mkstemp (test_checkpoint_file);
+  ck_assert_int_ge (fd, 0);
+  close (fd);
+  test_collections_create ();
+  test_drop_messages = false;
+  ck_assert_int_eq (mme_app_checkpoint_init (test_checkpoint_file, TEST_CHECKPOINT_SLOTS), RETURNok);
+}
+
+static void teardown (void)
+{
+  mme_app_checkpoint_exit ();
+  test_collections_destroy ();
+  unlink (test_checkpoint_file);
+}
+
+//------------------------------------------------------------------------------
+START_TEST(checkpoint_restore_test)
+{
+  ue_context_t       *ue_context = NULL;
+  emm_data_context_t *emm_context = NULL;
+  pdn_context_t      *pdn_context = NULL;
+
+  test_add_ue (1, 1);
+  test_add_ue (2, 2);
+  test_add_ue (7, 0);
+  test_snapshot ();
+  test_restart ();
+
+  ck_assert_uint_eq (test_nb_ues (), 3);
+  ck_assert_uint_eq (test_reserved_ue_id, 7);
+  ck_assert_uint_eq (test_reserved_teid, 0x1007);
+
+  ck_assert_int_eq (hashtable_ts_get (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, 2, (void **)&ue_context), HASH_TABLE_OK);
+  ck_assert_uint_eq (ue_context->imsi, 208950000000002);
+  ck_assert_int_eq (ue_context->ecm_state, ECM_IDLE);
+  ck_assert_str_eq (bdata (ue_context->msisdn), "33612340002");
+  ck_assert_str_eq (bdata (ue_context->apn_oi_replacement), "ue2.mnc095.mcc208.gprs");
+  int i = 0;
+  RB_FOREACH (pdn_context, PdnContexts, &ue_context->pdn_contexts) {
+    char apn_in_use[32];
+
+    snprintf (apn_in_use, sizeof (apn_in_use), "apn%d.ue2", i);
+    ck_assert_str_eq (bdata (pdn_context->apn_in_use), apn_in_use);
+    ck_assert_ptr_ne (pdn_context->apn_oi_replacement, NULL);
+    ck_assert_ptr_ne (RB_MIN (SessionBearers, &pdn_context->session_bearers), NULL);
+    ck_assert_uint_eq (RB_MIN (SessionBearers, &pdn_context->session_bearers)->s_gw_fteid_s1u.teid, 0x2000 + 2 * 16 + i);
+    i++;
+  }
+  ck_assert_int_eq (i, 2);
+
+  ck_assert_int_eq (hashtable_ts_get (_emm_data.ctx_coll_ue_id, 7, (void **)&emm_context), HASH_TABLE_OK);
+  ck_assert_uint_eq (emm_context->_guti.m_tmsi, 0xc0000007);
+  ck_assert_uint_eq (emm_context->_security.ul_count.seq_num, 7);
+  ck_assert_int_eq (emm_context->_emm_fsm_state, EMM_REGISTERED);
+}
+END_TEST
+
+START_TEST(checkpoint_released_ue_test)
+{
+  test_add_ue (1, 1);
+  test_add_ue (2, 1);
+  test_add_ue (3, 1);
+  test_snapshot ();
+  ck_assert_uint_eq (checkpoint.nb_free_slots, TEST_CHECKPOINT_SLOTS - 3);
+
+  test_remove_ue (2);
+  test_snapshot ();
+  ck_assert_uint_eq (checkpoint.nb_free_slots, TEST_CHECKPOINT_SLOTS - 2);
+  // an unchanged UE writes nothing
+  test_snapshot ();
+  ck_assert_uint_eq (checkpoint.nb_written, 0);
+
+  test_restart ();
+  ck_assert_uint_eq (test_nb_ues (), 2);
+}
+END_TEST
+
+START_TEST(checkpoint_no_emm_part_test)
+{
+  emm_data_context_t *emm_context = NULL;
+
+  // a UE without EMM context is saved but not restored
+  test_add_ue (1, 1);
+  test_add_ue (2, 1);
+  hashtable_ts_remove (_emm_data.ctx_coll_ue_id, 2, (void **)&emm_context);
+  free_wrapper ((void**)&emm_context);
+  test_snapshot ();
+  test_restart ();
+  ck_assert_uint_eq (test_nb_ues (), 1);
+}
+END_TEST
+
+START_TEST(checkpoint_dropped_request_test)
+{
+  test_add_ue (1, 1);
+  test_snapshot ();
+
+  // the EMM parts of the previous snapshot are kept when NAS cannot be asked
+  test_add_ue (2, 1);
+  test_drop_messages = true;
+  mme_app_checkpoint_snapshot ();
+  ck_assert_uint_eq (checkpoint.pending_round, 0);
+  test_drop_messages = false;
+
+  test_restart ();
+  ck_assert_uint_eq (test_nb_ues (), 1);
+}
+END_TEST
+
+START_TEST(checkpoint_pending_round_test)
+{
+  MessageDef *message_p = NULL;
+
+  test_add_ue (1, 1);
+  mme_app_checkpoint_snapshot ();
+  message_p = test_sent_message;
+  test_sent_message = NULL;
+  ck_assert_uint_ne (checkpoint.pending_round, 0);
+
+  // no new round before NAS answered
+  mme_app_checkpoint_snapshot ();
+  ck_assert_ptr_eq (test_sent_message, NULL);
+
+  mme_app_checkpoint_emm_snapshot (&NAS_CHECKPOINT_REQ (message_p));
+  free (message_p);
+  message_p = test_sent_message;
+  test_sent_message = NULL;
+  mme_app_checkpoint_handle_emm_snapshot (&NAS_CHECKPOINT_RSP (message_p));
+  ck_assert_uint_eq (checkpoint.pending_round, 0);
+  // an answer to an old round is ignored
+  mme_app_checkpoint_handle_emm_snapshot (&NAS_CHECKPOINT_RSP (message_p));
+  free_wrapper ((void**)&NAS_CHECKPOINT_RSP (message_p).ues_ptr);
+  free (message_p);
+
+  test_restart ();
+  ck_assert_uint_eq (test_nb_ues (), 1);
+}
+END_TEST
+
+START_TEST(checkpoint_unterminated_strings_test)
+{
+  ue_context_t *ue_context = NULL;
+
+  test_add_ue (1, 1);
+  test_snapshot ();
+
+  // a file written by someone else may hold no NUL
+  mme_app_checkpoint_slot_t * const slot = mme_app_checkpoint_slot (checkpoint.map, 0);
+  ck_assert_uint_eq (slot->mme.mme_ue_s1ap_id, 1);
+  memset (slot->mme.msisdn, '9', sizeof (slot->mme.msisdn));
+  memset (slot->mme.apn_oi_replacement, 'o', sizeof (slot->mme.apn_oi_replacement));
+  memset (slot->mme.pdns[0].apn_in_use, 'a', sizeof (slot->mme.pdns[0].apn_in_use));
+  memset (slot->mme.pdns[0].apn_subscribed, 's', sizeof (slot->mme.pdns[0].apn_subscribed));
+  test_restart ();
+
+  ck_assert_int_eq (hashtable_ts_get (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, 1, (void **)&ue_context), HASH_TABLE_OK);
+  ck_assert_int_eq (blength (ue_context->msisdn), MSISDN_LENGTH + 1);
+  ck_assert_int_eq (blength (ue_context->apn_oi_replacement), ACCESS_POINT_NAME_MAX_LENGTH + 1);
+  ck_assert_int_eq (blength (RB_MIN (PdnContexts, &ue_context->pdn_contexts)->apn_in_use), ACCESS_POINT_NAME_MAX_LENGTH + 1);
+  ck_assert_int_eq (blength (RB_MIN (PdnContexts, &ue_context->pdn_contexts)->apn_subscribed), ACCESS_POINT_NAME_MAX_LENGTH + 1);
+}
+END_TEST
+
+Suite *mme_app_checkpoint_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("MME checkpoint tests");
+
+    tc_core = tcase_create("Snapshot restore");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_add_test(tc_core, checkpoint_restore_test);
+    tcase_add_test(tc_core, checkpoint_released_ue_test);
+    tcase_add_test(tc_core, checkpoint_no_emm_part_test);
+    tcase_add_test(tc_core, checkpoint_dropped_request_test);
+    tcase_add_test(tc_core, checkpoint_pending_round_test);
+    tcase_add_test(tc_core, checkpoint_unterminated_strings_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = mme_app_checkpoint_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
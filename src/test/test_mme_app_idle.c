@@ -0,0 +1,719 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+/*
+ * The idle compaction is tested alone: the MME_APP and EMM collections are plain hash tables,
+ * the ITTI messages exchanged with the NAS EMM task are handed over by the test.
+ */
+#include "mme_app_idle.c"
+
+mme_app_desc_t                            mme_app_desc;
+__thread mme_stats_shard_t               *g_mme_stats_shard = NULL;
+
+static mme_stats_shard_t                  test_stats_shard;
+static MessageDef                        *test_sent_message = NULL;
+static bool                               test_drop_messages = false;
+
+//------------------------------------------------------------------------------
+// Stubs of the log, statistics, MME_APP, EMM and ITTI functions used by the idle compaction
+//------------------------------------------------------------------------------
+log_level_t g_oai_log_level[MAX_LOG_PROTOS] = {[0 ... MAX_LOG_PROTOS - 1] = OAILOG_LEVEL_WARNING};
+
+void log_message (log_thread_ctxt_t * const thread_ctxtP, const log_level_t log_levelP, const log_proto_t protoP,
+    const char *const source_fileP, const unsigned int line_numP, char *format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  vfprintf (stderr, format, args);
+  va_end (args);
+}
+
+void log_func (bool is_entering, const log_proto_t protoP, const char *const source_fileP, const unsigned int line_numP, const char *const function)
+{
+}
+
+void log_func_return (const log_proto_t protoP, const char *const source_fileP, const unsigned int line_numP, const char *const functionP, const long return_codeP)
+{
+}
+
+mme_stats_shard_t *mme_stats_new_shard (void)
+{
+  g_mme_stats_shard = &test_stats_shard;
+  return g_mme_stats_shard;
+}
+
+MessageDef *itti_alloc_new_message (task_id_t origin_task_id, MessagesIds message_id)
+{
+  MessageDef *message_p = calloc (1, sizeof (MessageDef));
+
+  message_p->ittiMsgHeader.messageId = message_id;
+  message_p->ittiMsgHeader.originTaskId = origin_task_id;
+  return message_p;
+}
+
+// the content of a dropped message is freed as ITTI does
+static void test_free_message (MessageDef * const message_p)
+{
+  if (NAS_IDLE_COMPACT_REQ == message_p->ittiMsgHeader.messageId) {
+    free_wrapper ((void**)&NAS_IDLE_COMPACT_REQ (message_p).ue_ids_ptr);
+  } else if (NAS_IDLE_COMPACT_RSP == message_p->ittiMsgHeader.messageId) {
+    free_wrapper ((void**)&NAS_IDLE_COMPACT_RSP (message_p).ue_ids_ptr);
+  }
+  free (message_p);
+}
+
+int itti_send_msg_to_task (task_id_t task_id, instance_t instance, MessageDef *message)
+{
+  if (test_drop_messages) {
+    test_free_message (message);
+    return -1;
+  }
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  test_sent_message = message;
+  return RETURNok;
+}
+
+imsi64_t imsi_to_imsi64 (const imsi_t * const imsi)
+{
+  imsi64_t imsi64 = 0;
+
+  for (int i = 0; i < IMSI_BCD8_SIZE; i++) {
+    imsi64 = imsi64 * 100 + (imsi->u.value[i] >> 4) * 10 + (imsi->u.value[i] & 0x0F);
+  }
+  return imsi64;
+}
+
+bearer_context_t *mme_app_new_ue_bearer_context (ue_context_t * const ue_context, const ebi_t ebi)
+{
+  bearer_context_t *bearer_context = calloc (1, sizeof (bearer_context_t));
+
+  bearer_context->ebi = ebi;
+  ue_context->bearer_contexts[EBI_TO_INDEX (ebi)] = bearer_context;
+  return bearer_context;
+}
+
+void mme_app_release_ue_bearer_context (ue_context_t * const ue_context, bearer_context_t ** const bearer_context)
+{
+  ck_assert_ptr_eq (ue_context->bearer_contexts[EBI_TO_INDEX ((*bearer_context)->ebi)], *bearer_context);
+  ue_context->bearer_contexts[EBI_TO_INDEX ((*bearer_context)->ebi)] = NULL;
+  free_wrapper ((void**)bearer_context);
+}
+
+void emm_init_context (struct emm_data_context_s * const emm_context, const bool init_esm_ctxt)
+{
+  emm_context->_emm_fsm_state = EMM_DEREGISTERED;
+}
+
+int emm_data_context_add (emm_data_t * emm_data, struct emm_data_context_s *elm)
+{
+  return (HASH_TABLE_OK == hashtable_ts_insert (emm_data->ctx_coll_ue_id, (const hash_key_t)elm->ue_id, elm)) ? RETURNok : RETURNerror;
+}
+
+struct emm_data_context_s *emm_data_context_remove (emm_data_t * emm_data, struct emm_data_context_s *elm, bool clear_fields)
+{
+  hashtable_ts_remove (emm_data->ctx_coll_ue_id, (const hash_key_t)elm->ue_id, (void **)&elm);
+  return elm;
+}
+
+//------------------------------------------------------------------------------
+// The RB trees of mme_app_ue_context.c, PDN contexts ordered by context identifier
+//------------------------------------------------------------------------------
+static int test_compare_pdn_context (struct pdn_context_s *a, struct pdn_context_s *b)
+{
+  return (a->context_identifier > b->context_identifier) - (a->context_identifier < b->context_identifier);
+}
+
+static int test_compare_bearer_context (struct bearer_context_s *a, struct bearer_context_s *b)
+{
+  return (a->ebi > b->ebi) - (a->ebi < b->ebi);
+}
+
+#define mme_app_compare_pdn_context    test_compare_pdn_context
+#define mme_app_compare_bearer_context test_compare_bearer_context
+RB_GENERATE (PdnContexts, pdn_context_s, pdnCtxRbtNode, mme_app_compare_pdn_context)
+RB_GENERATE (SessionBearers, bearer_context_s, bearerContextRbtNode, mme_app_compare_bearer_context)
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+static void test_free_ue_context (void **ue_context_p)
+{
+  ue_context_t  *ue_context = (ue_context_t *)*ue_context_p;
+  pdn_context_t *pdn_context = NULL;
+
+  mme_app_idle_ue_free (ue_context);
+  for (int i = 0; i < MAX_NUM_BEARERS_UE; i++) {
+    if (ue_context->bearer_contexts[i]) free_wrapper ((void**)&ue_context->bearer_contexts[i]);
+  }
+  while ((pdn_context = RB_MIN (PdnContexts, &ue_context->pdn_contexts))) {
+    RB_REMOVE (PdnContexts, &ue_context->pdn_contexts, pdn_context);
+    bdestroy_wrapper (&pdn_context->apn_in_use);
+    bdestroy_wrapper (&pdn_context->apn_subscribed);
+    bdestroy_wrapper (&pdn_context->apn_oi_replacement);
+    if (pdn_context->paa) free_wrapper ((void**)&pdn_context->paa);
+    free_wrapper ((void**)&pdn_context);
+  }
+  free_wrapper (ue_context_p);
+}
+
+static void test_fill_emm_context (emm_data_context_t * const emm_context, const mme_ue_s1ap_id_t ue_id)
+{
+  emm_security_context_t * const security = &emm_context->_security;
+  const uint8_t                  imsi_digits[] = {0x02, 0x08, 0x09, 0x05, 0x00, 0x00, 0x00, 0x00};
+
+  emm_context->ue_id = ue_id;
+  emm_context->is_dynamic = true;
+  emm_context->_emm_fsm_state = EMM_REGISTERED;
+  for (int i = 0; i < IMSI_BCD8_SIZE; i++) {
+    emm_context->_imsi.u.value[i] = (uint8_t)((imsi_digits[i] << 4) | ((ue_id + i) % 10));
+  }
+  emm_context->_imsi64 = imsi_to_imsi64 (&emm_context->_imsi);
+  emm_context->_imei.u.num.tac1 = 3;
+  emm_context->_imeisv.u.num.snr6 = 7;
+  emm_context->_guti.gummei.mme_gid = 4;
+  emm_context->_guti.gummei.mme_code = 1;
+  emm_context->_guti.m_tmsi = 0xc0000000 + ue_id;
+  emm_context->_lvr_tai.tac = 0x10 + ue_id;
+  emm_context->originating_tai.tac = 0x20 + ue_id;
+  emm_context->_tai_list.numberoflists = 1;
+  emm_context->_tai_list.partial_tai_list[0].typeoflist = 1;
+  emm_context->_tai_list.partial_tai_list[0].numberofelements = 2;
+  emm_context->_ue_network_capability.eea = 0xE0;
+  emm_context->_ue_network_capability.eia = 0x60;
+  emm_context->_ms_network_capability.gea1 = 1;
+  emm_context->_drx_parameter.splitpgcyclecode = 10;
+  emm_context->_current_drx_parameter.splitpgcyclecode = 11;
+  emm_context->ksi = 2;
+  emm_context->attach_type = 1;
+  emm_context->is_has_been_attached = true;
+  emm_context->is_guti_based_attach = true;
+  emm_context->member_present_mask = EMM_CTXT_MEMBER_GUTI | EMM_CTXT_MEMBER_SECURITY | EMM_CTXT_MEMBER_AUTH_VECTORS;
+  emm_context->member_valid_mask = EMM_CTXT_MEMBER_GUTI | EMM_CTXT_MEMBER_SECURITY;
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    memset (emm_context->_vector[i].kasme, 0x40 + i, sizeof (emm_context->_vector[i].kasme));
+    memset (emm_context->_vector[i].rand, 0x50 + i, sizeof (emm_context->_vector[i].rand));
+  }
+  emm_context->remaining_vectors = 3;
+  security->vector_index = 1;
+  security->sc_type = SECURITY_CTX_TYPE_FULL_NATIVE;
+  security->eksi = 2;
+  security->ncc = 5;
+  memset (security->nh_conj, 0x11, sizeof (security->nh_conj));
+  memset (security->knas_enc, 0x22, sizeof (security->knas_enc));
+  memset (security->knas_int, 0x33, sizeof (security->knas_int));
+  security->dl_count.overflow = 1;
+  security->dl_count.seq_num = ue_id & 0xff;
+  security->ul_count.seq_num = 0x42;
+  security->capability.eps_encryption = 0xE0;
+  security->capability.eps_integrity = 0x60;
+  security->selected_algorithms.encryption = 1;
+  security->selected_algorithms.integrity = 2;
+  security->activated = 1;
+  security->direction_encode = SECU_DIRECTION_DOWNLINK;
+  security->direction_decode = SECU_DIRECTION_UPLINK;
+}
+
+static void ck_assert_emm_context (const emm_data_context_t * const emm_context, const emm_data_context_t * const expected)
+{
+  ck_assert_uint_eq (emm_context->_imsi64, expected->_imsi64);
+  ck_assert_mem_eq (&emm_context->_imsi, &expected->_imsi, sizeof (imsi_t));
+  ck_assert_mem_eq (&emm_context->_imei, &expected->_imei, sizeof (imei_t));
+  ck_assert_mem_eq (&emm_context->_imeisv, &expected->_imeisv, sizeof (imeisv_t));
+  ck_assert_mem_eq (&emm_context->_guti, &expected->_guti, sizeof (guti_t));
+  ck_assert_mem_eq (&emm_context->_lvr_tai, &expected->_lvr_tai, sizeof (tai_t));
+  ck_assert_mem_eq (&emm_context->originating_tai, &expected->originating_tai, sizeof (tai_t));
+  ck_assert_int_eq (emm_context->_tai_list.numberoflists, expected->_tai_list.numberoflists);
+  ck_assert_mem_eq (&emm_context->_tai_list.partial_tai_list[0], &expected->_tai_list.partial_tai_list[0], sizeof (partial_tai_list_t));
+  ck_assert_mem_eq (&emm_context->_ue_network_capability, &expected->_ue_network_capability, sizeof (ue_network_capability_t));
+  ck_assert_mem_eq (&emm_context->_ms_network_capability, &expected->_ms_network_capability, sizeof (ms_network_capability_t));
+  ck_assert_mem_eq (&emm_context->_drx_parameter, &expected->_drx_parameter, sizeof (drx_parameter_t));
+  ck_assert_mem_eq (&emm_context->_current_drx_parameter, &expected->_current_drx_parameter, sizeof (drx_parameter_t));
+  ck_assert_int_eq (emm_context->ksi, expected->ksi);
+  ck_assert_int_eq (emm_context->attach_type, expected->attach_type);
+  ck_assert_int_eq (emm_context->is_has_been_attached, expected->is_has_been_attached);
+  ck_assert_int_eq (emm_context->is_guti_based_attach, expected->is_guti_based_attach);
+  ck_assert_uint_eq (emm_context->member_present_mask, expected->member_present_mask);
+  ck_assert_uint_eq (emm_context->member_valid_mask, expected->member_valid_mask);
+  ck_assert_mem_eq (emm_context->_vector, expected->_vector, sizeof (expected->_vector));
+  ck_assert_int_eq (emm_context->remaining_vectors, expected->remaining_vectors);
+  ck_assert_int_eq (emm_context->_security.vector_index, expected->_security.vector_index);
+  ck_assert_int_eq (emm_context->_security.sc_type, expected->_security.sc_type);
+  ck_assert_int_eq (emm_context->_security.eksi, expected->_security.eksi);
+  ck_assert_int_eq (emm_context->_security.ncc, expected->_security.ncc);
+  ck_assert_mem_eq (emm_context->_security.nh_conj, expected->_security.nh_conj, sizeof (expected->_security.nh_conj));
+  ck_assert_mem_eq (emm_context->_security.knas_enc, expected->_security.knas_enc, sizeof (expected->_security.knas_enc));
+  ck_assert_mem_eq (emm_context->_security.knas_int, expected->_security.knas_int, sizeof (expected->_security.knas_int));
+  ck_assert_mem_eq (&emm_context->_security.dl_count, &expected->_security.dl_count, sizeof (count_t));
+  ck_assert_mem_eq (&emm_context->_security.ul_count, &expected->_security.ul_count, sizeof (count_t));
+  ck_assert_int_eq (emm_context->_security.capability.eps_encryption, expected->_security.capability.eps_encryption);
+  ck_assert_int_eq (emm_context->_security.capability.eps_integrity, expected->_security.capability.eps_integrity);
+  ck_assert_int_eq (emm_context->_security.selected_algorithms.encryption, expected->_security.selected_algorithms.encryption);
+  ck_assert_int_eq (emm_context->_security.selected_algorithms.integrity, expected->_security.selected_algorithms.integrity);
+  ck_assert_int_eq (emm_context->_security.activated, expected->_security.activated);
+  ck_assert_int_eq (emm_context->_security.direction_encode, expected->_security.direction_encode);
+  ck_assert_int_eq (emm_context->_security.direction_decode, expected->_security.direction_decode);
+  ck_assert_int_eq (emm_context->_emm_fsm_state, EMM_REGISTERED);
+}
+
+static ue_context_t *test_add_ue (const mme_ue_s1ap_id_t ue_id, const int nb_pdns)
+{
+  ue_context_t       *ue_context = calloc (1, sizeof (ue_context_t));
+  emm_data_context_t *emm_context = calloc (1, sizeof (emm_data_context_t));
+
+  RB_INIT (&ue_context->pdn_contexts);
+  ue_context->mme_ue_s1ap_id = ue_id;
+  ue_context->mm_state = UE_REGISTERED;
+  ue_context->ecm_state = ECM_IDLE;
+  ue_context->ecm_idle_sec = mme_app_idle_now_sec () - 100;
+  ue_context->initial_context_setup_rsp_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  for (int i = 0; i < nb_pdns; i++) {
+    pdn_context_t    *pdn_context = calloc (1, sizeof (pdn_context_t));
+    bearer_context_t *bearer_context = mme_app_new_ue_bearer_context (ue_context, 5 + i);
+
+    pdn_context->context_identifier = i;
+    pdn_context->default_ebi = 5 + i;
+    pdn_context->pdn_type = IPv4;
+    pdn_context->paa = calloc (1, sizeof (paa_t));
+    pdn_context->paa->pdn_type = IPv4;
+    pdn_context->paa->ipv4_address.s_addr = htonl (0x0a000000 + ue_id * 16 + i);
+    pdn_context->s_gw_teid_s11_s4 = 0x3000 + ue_id * 16 + i;
+    pdn_context->p_gw_teid_s5_s8_cp = 0x4000 + ue_id * 16 + i;
+    pdn_context->subscribed_apn_ambr.br_ul = 1000 + i;
+    pdn_context->subscribed_apn_ambr.br_dl = 2000 + i;
+    pdn_context->apn_in_use = bformat ("apn%d.ue%u", i, ue_id);
+    pdn_context->apn_subscribed = bformat ("apn%d", i);
+    pdn_context->apn_oi_replacement = bformat ("pdn%d.mnc095.mcc208.gprs", i);
+    RB_INIT (&pdn_context->session_bearers);
+    RB_INSERT (PdnContexts, &ue_context->pdn_contexts, pdn_context);
+    bearer_context->linked_ebi = 5 + i;
+    bearer_context->bearer_state = BEARER_STATE_SGW_CREATED | BEARER_STATE_MME_CREATED;
+    bearer_context->esm_ebr_context.status = ESM_EBR_ACTIVE;
+    bearer_context->s_gw_fteid_s1u.teid = 0x2000 + ue_id * 16 + i;
+    bearer_context->p_gw_fteid_s5_s8_up.teid = 0x5000 + ue_id * 16 + i;
+    bearer_context->bearer_level_qos.qci = 9 - i;
+    bearer_context->bearer_level_qos.pl = 15 - i;
+    RB_INSERT (SessionBearers, &pdn_context->session_bearers, bearer_context);
+  }
+  ck_assert_int_eq (hashtable_ts_insert (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_id, ue_context), HASH_TABLE_OK);
+
+  test_fill_emm_context (emm_context, ue_id);
+  ck_assert_int_eq (emm_data_context_add (&_emm_data, emm_context), RETURNok);
+  return ue_context;
+}
+
+static void ck_assert_pdn_contexts (const ue_context_t * const ue_context, const int nb_pdns)
+{
+  pdn_context_t    *pdn_context = NULL;
+  bearer_context_t *bearer_context = NULL;
+  int               i = 0;
+
+  RB_FOREACH (pdn_context, PdnContexts, (struct PdnContexts *)&ue_context->pdn_contexts) {
+    char apn_in_use[32];
+
+    snprintf (apn_in_use, sizeof (apn_in_use), "apn%d.ue%u", i, ue_context->mme_ue_s1ap_id);
+    ck_assert_int_eq (pdn_context->context_identifier, i);
+    ck_assert_int_eq (pdn_context->default_ebi, 5 + i);
+    ck_assert_int_eq (pdn_context->pdn_type, IPv4);
+    ck_assert_ptr_ne (pdn_context->paa, NULL);
+    ck_assert_uint_eq (ntohl (pdn_context->paa->ipv4_address.s_addr), 0x0a000000 + ue_context->mme_ue_s1ap_id * 16 + i);
+    ck_assert_uint_eq (pdn_context->s_gw_teid_s11_s4, 0x3000 + ue_context->mme_ue_s1ap_id * 16 + i);
+    ck_assert_uint_eq (pdn_context->p_gw_teid_s5_s8_cp, 0x4000 + ue_context->mme_ue_s1ap_id * 16 + i);
+    ck_assert_uint_eq (pdn_context->subscribed_apn_ambr.br_ul, 1000 + i);
+    ck_assert_uint_eq (pdn_context->subscribed_apn_ambr.br_dl, 2000 + i);
+    ck_assert_str_eq (bdata (pdn_context->apn_in_use), apn_in_use);
+    ck_assert_ptr_ne (pdn_context->apn_oi_replacement, NULL);
+
+    bearer_context = RB_MIN (SessionBearers, &pdn_context->session_bearers);
+    ck_assert_ptr_ne (bearer_context, NULL);
+    ck_assert_ptr_eq (RB_NEXT (SessionBearers, &pdn_context->session_bearers, bearer_context), NULL);
+    ck_assert_ptr_eq (ue_context->bearer_contexts[EBI_TO_INDEX (5 + i)], bearer_context);
+    ck_assert_int_eq (bearer_context->ebi, 5 + i);
+    ck_assert_int_eq (bearer_context->linked_ebi, 5 + i);
+    ck_assert_int_eq (bearer_context->bearer_state, BEARER_STATE_SGW_CREATED | BEARER_STATE_MME_CREATED);
+    ck_assert_int_eq (bearer_context->esm_ebr_context.status, ESM_EBR_ACTIVE);
+    ck_assert_uint_eq (bearer_context->s_gw_fteid_s1u.teid, 0x2000 + ue_context->mme_ue_s1ap_id * 16 + i);
+    ck_assert_uint_eq (bearer_context->p_gw_fteid_s5_s8_up.teid, 0x5000 + ue_context->mme_ue_s1ap_id * 16 + i);
+    ck_assert_int_eq (bearer_context->bearer_level_qos.qci, 9 - i);
+    ck_assert_int_eq (bearer_context->bearer_level_qos.pl, 15 - i);
+    i++;
+  }
+  ck_assert_int_eq (i, nb_pdns);
+}
+
+static emm_data_context_t *test_emm_context (const mme_ue_s1ap_id_t ue_id)
+{
+  emm_data_context_t *emm_context = NULL;
+
+  hashtable_ts_get (_emm_data.ctx_coll_ue_id, (const hash_key_t)ue_id, (void **)&emm_context);
+  return emm_context;
+}
+
+static MessageDef *test_take_message (const MessagesIds message_id)
+{
+  MessageDef *message_p = test_sent_message;
+
+  test_sent_message = NULL;
+  ck_assert_ptr_ne (message_p, NULL);
+  ck_assert_int_eq (message_p->ittiMsgHeader.messageId, message_id);
+  return message_p;
+}
+
+// run a compaction round, the NAS EMM task answers the request
+static void test_compact (void)
+{
+  MessageDef *message_p = NULL;
+
+  mme_app_idle_compact_ues (10);
+  if (!test_sent_message) {
+    return;
+  }
+  message_p = test_take_message (NAS_IDLE_COMPACT_REQ);
+  mme_app_idle_emm_compact (&NAS_IDLE_COMPACT_REQ (message_p));
+  test_free_message (message_p);
+  if (!test_sent_message) {
+    return;
+  }
+  message_p = test_take_message (NAS_IDLE_COMPACT_RSP);
+  mme_app_idle_handle_emm_compact (&NAS_IDLE_COMPACT_RSP (message_p));
+  test_free_message (message_p);
+}
+
+static void setup (void)
+{
+  mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl = hashtable_ts_create (64, NULL, test_free_ue_context, NULL);
+  _emm_data.ctx_coll_ue_id = hashtable_ts_create (64, NULL, free_wrapper, NULL);
+  test_drop_messages = false;
+  test_sent_message = NULL;
+}
+
+static void teardown (void)
+{
+  hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl);
+  hashtable_ts_destroy (_emm_data.ctx_coll_ue_id);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 0);
+}
+
+//------------------------------------------------------------------------------
+START_TEST(idle_emm_round_trip_test)
+{
+  emm_data_context_t  expected;
+  emm_data_context_t  emm_context;
+  mme_app_idle_ue_t  *idle_ue = calloc (1, sizeof (mme_app_idle_ue_t));
+
+  memset (&expected, 0, sizeof (expected));
+  memset (&emm_context, 0, sizeof (emm_context));
+  test_fill_emm_context (&expected, 17);
+  mme_app_idle_write_emm (idle_ue, &expected);
+  mme_app_idle_read_emm (&emm_context, idle_ue);
+  ck_assert_emm_context (&emm_context, &expected);
+
+  // no TAI list
+  memset (idle_ue, 0, sizeof (*idle_ue));
+  memset (&emm_context, 0, sizeof (emm_context));
+  expected._tai_list.numberoflists = 0;
+  mme_app_idle_write_emm (idle_ue, &expected);
+  mme_app_idle_read_emm (&emm_context, idle_ue);
+  ck_assert_int_eq (emm_context._tai_list.numberoflists, 0);
+  free_wrapper ((void**)&idle_ue);
+}
+END_TEST
+
+START_TEST(idle_pdns_round_trip_test)
+{
+  ue_context_t       *ue_context = test_add_ue (3, MME_APP_IDLE_UE_MAX_PDNS);
+  mme_app_idle_ue_t  *idle_ue = calloc (1, sizeof (mme_app_idle_ue_t));
+  bstring             apn_in_use = RB_MIN (PdnContexts, &ue_context->pdn_contexts)->apn_in_use;
+
+  mme_app_idle_write_pdns (idle_ue, ue_context);
+  ck_assert (RB_EMPTY (&ue_context->pdn_contexts));
+  for (int i = 0; i < MAX_NUM_BEARERS_UE; i++) {
+    ck_assert_ptr_eq (ue_context->bearer_contexts[i], NULL);
+  }
+  ck_assert_int_eq (idle_ue->nb_pdns, MME_APP_IDLE_UE_MAX_PDNS);
+  // the strings are moved, not copied
+  ck_assert_ptr_eq (idle_ue->pdns[0].apn_in_use, apn_in_use);
+
+  mme_app_idle_read_pdns (ue_context, idle_ue);
+  ck_assert_int_eq (idle_ue->nb_pdns, 0);
+  ck_assert_ptr_eq (RB_MIN (PdnContexts, &ue_context->pdn_contexts)->apn_in_use, apn_in_use);
+  ck_assert_pdn_contexts (ue_context, MME_APP_IDLE_UE_MAX_PDNS);
+  free_wrapper ((void**)&idle_ue);
+}
+END_TEST
+
+START_TEST(idle_compact_expand_test)
+{
+  ue_context_t       *ue_context = test_add_ue (1, 2);
+  emm_data_context_t  expected;
+  MessageDef         *message_p = NULL;
+
+  memset (&expected, 0, sizeof (expected));
+  test_fill_emm_context (&expected, 1);
+  test_compact ();
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 1);
+  ck_assert_ptr_ne (ue_context->idle_ue, NULL);
+  ck_assert (RB_EMPTY (&ue_context->pdn_contexts));
+  ck_assert_ptr_eq (test_emm_context (1), NULL);
+
+  // a compacted UE is not selected again
+  mme_app_idle_compact_ues (10);
+  ck_assert_ptr_eq (test_sent_message, NULL);
+
+  // MME_APP rebuilds its part first and asks NAS for the EMM context
+  mme_app_idle_ue_expand (ue_context);
+  ck_assert_pdn_contexts (ue_context, 2);
+  ck_assert_ptr_ne (ue_context->idle_ue, NULL);
+  message_p = test_take_message (NAS_IDLE_EXPAND_REQ);
+  ck_assert_uint_eq (NAS_IDLE_EXPAND_REQ (message_p).ue_id, 1);
+  // nothing more to rebuild on the next lookup
+  mme_app_idle_ue_expand (ue_context);
+  ck_assert_ptr_eq (test_sent_message, NULL);
+
+  ck_assert_ptr_ne (mme_app_idle_emm_expand (NAS_IDLE_EXPAND_REQ (message_p).ue_id), NULL);
+  test_free_message (message_p);
+  ck_assert_ptr_eq (ue_context->idle_ue, NULL);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 0);
+  ck_assert_emm_context (test_emm_context (1), &expected);
+  // already rebuilt
+  ck_assert_ptr_eq (mme_app_idle_emm_expand (1), test_emm_context (1));
+}
+END_TEST
+
+START_TEST(idle_emm_lookup_first_test)
+{
+  ue_context_t       *ue_context = test_add_ue (2, 1);
+  emm_data_context_t  expected;
+
+  memset (&expected, 0, sizeof (expected));
+  test_fill_emm_context (&expected, 2);
+  test_compact ();
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 1);
+
+  // an EMM lookup rebuilds the EMM context only
+  ck_assert_ptr_ne (mme_app_idle_emm_expand (2), NULL);
+  ck_assert_emm_context (test_emm_context (2), &expected);
+  ck_assert (RB_EMPTY (&ue_context->pdn_contexts));
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 1);
+
+  // then MME_APP, NAS has nothing left to rebuild
+  mme_app_idle_ue_expand (ue_context);
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  ck_assert_pdn_contexts (ue_context, 1);
+  ck_assert_ptr_eq (ue_context->idle_ue, NULL);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 0);
+  ck_assert_ptr_eq (mme_app_idle_emm_expand (12), NULL);
+}
+END_TEST
+
+START_TEST(idle_not_compactable_test)
+{
+  ue_context_t       *connected = test_add_ue (1, 1);
+  ue_context_t       *recent = test_add_ue (2, 1);
+  ue_context_t       *three_pdns = test_add_ue (3, 3);
+  ue_context_t       *emm_busy = test_add_ue (4, 1);
+  ue_context_t       *two_tai_lists = test_add_ue (5, 1);
+
+  connected->ecm_state = ECM_CONNECTED;
+  recent->ecm_idle_sec = mme_app_idle_now_sec ();
+  test_emm_context (4)->member_present_mask |= EMM_CTXT_MEMBER_OLD_GUTI;
+  test_emm_context (5)->_tai_list.numberoflists = 2;
+  test_compact ();
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 0);
+  ck_assert_pdn_contexts (connected, 1);
+  ck_assert_pdn_contexts (recent, 1);
+  ck_assert_pdn_contexts (three_pdns, 3);
+  ck_assert_pdn_contexts (emm_busy, 1);
+  ck_assert_pdn_contexts (two_tai_lists, 1);
+  for (mme_ue_s1ap_id_t ue_id = 1; ue_id <= 5; ue_id++) {
+    ck_assert_ptr_ne (test_emm_context (ue_id), NULL);
+  }
+}
+END_TEST
+
+START_TEST(idle_ue_connected_meanwhile_test)
+{
+  ue_context_t       *ue_context = test_add_ue (6, 1);
+  emm_data_context_t  expected;
+  MessageDef         *message_p = NULL;
+
+  memset (&expected, 0, sizeof (expected));
+  test_fill_emm_context (&expected, 6);
+  mme_app_idle_compact_ues (10);
+  message_p = test_take_message (NAS_IDLE_COMPACT_REQ);
+  mme_app_idle_emm_compact (&NAS_IDLE_COMPACT_REQ (message_p));
+  test_free_message (message_p);
+  ck_assert_ptr_eq (test_emm_context (6), NULL);
+  ck_assert_ptr_ne (ue_context->idle_ue, NULL);
+
+  // the UE left ECM-IDLE before MME_APP got the EMM context, it is rebuilt by NAS
+  ue_context->ecm_state = ECM_CONNECTED;
+  message_p = test_take_message (NAS_IDLE_COMPACT_RSP);
+  mme_app_idle_handle_emm_compact (&NAS_IDLE_COMPACT_RSP (message_p));
+  test_free_message (message_p);
+  ck_assert_pdn_contexts (ue_context, 1);
+  message_p = test_take_message (NAS_IDLE_EXPAND_REQ);
+  mme_app_idle_emm_expand (NAS_IDLE_EXPAND_REQ (message_p).ue_id);
+  test_free_message (message_p);
+  ck_assert_emm_context (test_emm_context (6), &expected);
+  ck_assert_ptr_eq (ue_context->idle_ue, NULL);
+}
+END_TEST
+
+START_TEST(idle_emm_lookup_before_response_test)
+{
+  ue_context_t       *ue_context = test_add_ue (11, 2);
+  emm_data_context_t  expected;
+  MessageDef         *message_p = NULL;
+
+  memset (&expected, 0, sizeof (expected));
+  test_fill_emm_context (&expected, 11);
+  mme_app_idle_compact_ues (10);
+  message_p = test_take_message (NAS_IDLE_COMPACT_REQ);
+  mme_app_idle_emm_compact (&NAS_IDLE_COMPACT_REQ (message_p));
+  test_free_message (message_p);
+
+  // looked up before MME_APP got the response, the EMM context is already in the record
+  ck_assert_ptr_ne (mme_app_idle_emm_expand (11), NULL);
+  ck_assert_emm_context (test_emm_context (11), &expected);
+  ck_assert_ptr_eq (ue_context->idle_ue, NULL);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 0);
+
+  // nothing left for MME_APP to compact
+  message_p = test_take_message (NAS_IDLE_COMPACT_RSP);
+  mme_app_idle_handle_emm_compact (&NAS_IDLE_COMPACT_RSP (message_p));
+  test_free_message (message_p);
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  ck_assert_pdn_contexts (ue_context, 2);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 0);
+}
+END_TEST
+
+START_TEST(idle_dropped_response_test)
+{
+  ue_context_t       *ue_context = test_add_ue (7, 1);
+  MessageDef         *message_p = NULL;
+
+  // a dropped request changes nothing
+  test_drop_messages = true;
+  mme_app_idle_compact_ues (10);
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  ck_assert_ptr_ne (test_emm_context (7), NULL);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 0);
+
+  // a dropped response leaves the EMM context alone in the record
+  test_drop_messages = false;
+  mme_app_idle_compact_ues (10);
+  message_p = test_take_message (NAS_IDLE_COMPACT_REQ);
+  test_drop_messages = true;
+  mme_app_idle_emm_compact (&NAS_IDLE_COMPACT_REQ (message_p));
+  test_free_message (message_p);
+  test_drop_messages = false;
+  ck_assert_ptr_eq (test_emm_context (7), NULL);
+  ck_assert_ptr_ne (ue_context->idle_ue, NULL);
+  ck_assert_pdn_contexts (ue_context, 1);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 1);
+
+  // MME_APP has nothing to rebuild, the EMM lookup rebuilds the EMM context
+  mme_app_idle_ue_expand (ue_context);
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  ck_assert_ptr_ne (mme_app_idle_emm_expand (7), NULL);
+  ck_assert_ptr_eq (ue_context->idle_ue, NULL);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 0);
+
+  test_compact ();
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 1);
+  ck_assert (RB_EMPTY (&ue_context->pdn_contexts));
+}
+END_TEST
+
+START_TEST(idle_released_ue_test)
+{
+  MessageDef         *message_p = NULL;
+
+  test_add_ue (8, 2);
+  test_add_ue (9, 1);
+  test_compact ();
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 2);
+
+  // released while compacted, its record and the strings it holds are freed
+  hashtable_ts_free (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, 8);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 1);
+  ck_assert_ptr_eq (mme_app_idle_emm_expand (8), NULL);
+
+  // released before MME_APP got the response, the record is freed with its UE context
+  mme_app_idle_compact_ues (10);
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  test_add_ue (10, 1);
+  mme_app_idle_compact_ues (10);
+  message_p = test_take_message (NAS_IDLE_COMPACT_REQ);
+  mme_app_idle_emm_compact (&NAS_IDLE_COMPACT_REQ (message_p));
+  test_free_message (message_p);
+  hashtable_ts_free (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, 10);
+  message_p = test_take_message (NAS_IDLE_COMPACT_RSP);
+  mme_app_idle_handle_emm_compact (&NAS_IDLE_COMPACT_RSP (message_p));
+  test_free_message (message_p);
+  ck_assert_uint_eq (mme_app_idle_nb_ues (), 1);
+}
+END_TEST
+
+Suite *mme_app_idle_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("MME idle compaction tests");
+
+    tc_core = tcase_create("Compaction expansion");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_add_test(tc_core, idle_emm_round_trip_test);
+    tcase_add_test(tc_core, idle_pdns_round_trip_test);
+    tcase_add_test(tc_core, idle_compact_expand_test);
+    tcase_add_test(tc_core, idle_emm_lookup_first_test);
+    tcase_add_test(tc_core, idle_not_compactable_test);
+    tcase_add_test(tc_core, idle_ue_connected_meanwhile_test);
+    tcase_add_test(tc_core, idle_emm_lookup_before_response_test);
+    tcase_add_test(tc_core, idle_dropped_response_test);
+    tcase_add_test(tc_core, idle_released_ue_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = mme_app_idle_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,159 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <check.h>
+
+#include "mme_app_statistics.h"
+
+#define SUB_BUCKETS (1 << MME_STATS_HISTOGRAM_SUB_BITS)
+
+START_TEST(histogram_small_values_test)
+{
+    // below 2^SUB_BITS each value has its own bucket
+    for (uint64_t v = 0; v < SUB_BUCKETS; v++) {
+        ck_assert_uint_eq(mme_stats_histogram_index(v), v);
+        ck_assert_uint_eq(mme_stats_histogram_value(v), v);
+    }
+    ck_assert_uint_eq(mme_stats_histogram_index(SUB_BUCKETS), SUB_BUCKETS);
+}
+END_TEST
+
+START_TEST(histogram_bucket_bounds_test)
+{
+    uint32_t previous_index = 0;
+
+    for (uint64_t v = 0; v < (UINT64_C(1) << MME_STATS_HISTOGRAM_MAX_BITS); v = (v < 4096) ? v + 1 : v + v / 37) {
+        const uint32_t index = mme_stats_histogram_index(v);
+        const uint64_t high = mme_stats_histogram_value(index);
+
+        ck_assert_uint_lt(index, MME_STATS_HISTOGRAM_BUCKETS);
+        // monotonic, the value is within the bucket, the bucket is at most 1/2^SUB_BITS wide
+        ck_assert_uint_ge(index, previous_index);
+        ck_assert_uint_ge(high, v);
+        ck_assert_uint_le(high - v, v / SUB_BUCKETS);
+        if (index) {
+            ck_assert_uint_lt(mme_stats_histogram_value(index - 1), v);
+        }
+        previous_index = index;
+    }
+}
+END_TEST
+
+START_TEST(histogram_index_value_round_trip_test)
+{
+    for (uint32_t index = 0; index < MME_STATS_HISTOGRAM_BUCKETS; index++) {
+        ck_assert_uint_eq(mme_stats_histogram_index(mme_stats_histogram_value(index)), index);
+    }
+}
+END_TEST
+
+START_TEST(histogram_clamp_test)
+{
+    const uint32_t last = MME_STATS_HISTOGRAM_BUCKETS - 1;
+
+    ck_assert_uint_eq(mme_stats_histogram_index((UINT64_C(1) << MME_STATS_HISTOGRAM_MAX_BITS) - 1), last);
+    ck_assert_uint_eq(mme_stats_histogram_index(UINT64_C(1) << MME_STATS_HISTOGRAM_MAX_BITS), last);
+    ck_assert_uint_eq(mme_stats_histogram_index(UINT64_MAX), last);
+    ck_assert_uint_eq(mme_stats_histogram_value(last), (UINT64_C(1) << MME_STATS_HISTOGRAM_MAX_BITS) - 1);
+}
+END_TEST
+
+START_TEST(histogram_percentile_test)
+{
+    static mme_stats_histogram_t histogram;
+    uint64_t count = 0;
+
+    memset(&histogram, 0, sizeof(histogram));
+    ck_assert_uint_eq(mme_stats_histogram_count(&histogram), 0);
+    ck_assert_uint_eq(mme_stats_histogram_percentile(&histogram, 0, 99.0), 0);
+
+    // 1..10000 us once each
+    for (uint64_t v = 1; v <= 10000; v++) {
+        histogram.buckets[mme_stats_histogram_index(v)]++;
+        histogram.sum_us += v;
+    }
+    count = mme_stats_histogram_count(&histogram);
+    ck_assert_uint_eq(count, 10000);
+
+    const double   percentiles[] = {50.0, 90.0, 99.0, 99.9};
+    const uint64_t exact[] = {5000, 9000, 9900, 9990};
+    for (int i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        const uint64_t p = mme_stats_histogram_percentile(&histogram, count, percentiles[i]);
+        // highest value of the bucket holding the exact percentile
+        ck_assert_uint_ge(p, exact[i]);
+        ck_assert_uint_le(p - exact[i], exact[i] / SUB_BUCKETS);
+    }
+    ck_assert_uint_eq(mme_stats_histogram_percentile(&histogram, count, 0.0), 1);
+    ck_assert_uint_eq(mme_stats_histogram_percentile(&histogram, count, 100.0), mme_stats_histogram_value(mme_stats_histogram_index(10000)));
+}
+END_TEST
+
+START_TEST(histogram_percentile_single_bucket_test)
+{
+    static mme_stats_histogram_t histogram;
+    const uint32_t index = mme_stats_histogram_index(250000);
+
+    memset(&histogram, 0, sizeof(histogram));
+    histogram.buckets[index] = 42;
+    ck_assert_uint_eq(mme_stats_histogram_count(&histogram), 42);
+    ck_assert_uint_eq(mme_stats_histogram_percentile(&histogram, 42, 1.0), mme_stats_histogram_value(index));
+    ck_assert_uint_eq(mme_stats_histogram_percentile(&histogram, 42, 100.0), mme_stats_histogram_value(index));
+}
+END_TEST
+
+Suite *mme_app_statistics_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("MME statistics tests");
+
+    tc_core = tcase_create("Latency histogram");
+    tcase_add_test(tc_core, histogram_small_values_test);
+    tcase_add_test(tc_core, histogram_bucket_bounds_test);
+    tcase_add_test(tc_core, histogram_index_value_round_trip_test);
+    tcase_add_test(tc_core, histogram_clamp_test);
+    tcase_add_test(tc_core, histogram_percentile_test);
+    tcase_add_test(tc_core, histogram_percentile_single_bucket_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = mme_app_statistics_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,277 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <check.h>
+
+#include "s1ap_asn_arena.h"
+
+#define TEST_ARENA_BLOCK_SIZE   200
+#define TEST_ARENA_NB_BLOCKS    ((3 * S1AP_ASN_ARENA_CHUNK_SIZE) / TEST_ARENA_BLOCK_SIZE)
+
+static void test_arena_fill (uint8_t * const block, const size_t size, const unsigned int seed)
+{
+  for (size_t i = 0; i < size; i++) {
+    block[i] = (uint8_t)(seed * 31 + i);
+  }
+}
+
+static bool test_arena_check (const uint8_t * const block, const size_t size, const unsigned int seed)
+{
+  for (size_t i = 0; i < size; i++) {
+    if (block[i] != (uint8_t)(seed * 31 + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+START_TEST(arena_outside_scope_test)
+{
+  void                                   *ptr = NULL;
+
+  // no scope: the C library
+  ptr = s1ap_asn_arena_malloc (64);
+  ck_assert_ptr_ne (ptr, NULL);
+  ck_assert (!s1ap_asn_arena_owns (ptr));
+  ptr = s1ap_asn_arena_realloc (ptr, 100000);
+  ck_assert_ptr_ne (ptr, NULL);
+  ck_assert (!s1ap_asn_arena_owns (ptr));
+  s1ap_asn_arena_free (ptr);
+  s1ap_asn_arena_free (NULL);
+  // unbalanced end is ignored
+  s1ap_asn_arena_end ();
+  ptr = s1ap_asn_arena_calloc (4, 16);
+  ck_assert (!s1ap_asn_arena_owns (ptr));
+  free (ptr);
+}
+END_TEST
+
+START_TEST(arena_allocation_test)
+{
+  uint8_t                                *blocks[16];
+  uint8_t                                *zeroed = NULL;
+  void                                   *outside = malloc (32);
+
+  s1ap_asn_arena_begin ();
+  for (int i = 0; i < 16; i++) {
+    blocks[i] = s1ap_asn_arena_malloc (i * 7 + 1);
+    ck_assert_ptr_ne (blocks[i], NULL);
+    ck_assert (s1ap_asn_arena_owns (blocks[i]));
+    ck_assert_uint_eq ((uintptr_t)blocks[i] % 16, 0);
+    test_arena_fill (blocks[i], i * 7 + 1, i);
+  }
+  // no overlap
+  for (int i = 0; i < 16; i++) {
+    ck_assert (test_arena_check (blocks[i], i * 7 + 1, i));
+  }
+  zeroed = s1ap_asn_arena_calloc (10, 13);
+  ck_assert (s1ap_asn_arena_owns (zeroed));
+  for (int i = 0; i < 130; i++) {
+    ck_assert_uint_eq (zeroed[i], 0);
+  }
+  ck_assert_ptr_eq (s1ap_asn_arena_calloc (SIZE_MAX / 2, 4), NULL);
+  // memory of the C library is still freed by the C library in a scope
+  ck_assert (!s1ap_asn_arena_owns (outside));
+  s1ap_asn_arena_free (outside);
+  s1ap_asn_arena_end ();
+  ck_assert (!s1ap_asn_arena_owns (blocks[0]));
+}
+END_TEST
+
+START_TEST(arena_free_last_block_test)
+{
+  uint8_t                                *first = NULL;
+  uint8_t                                *last = NULL;
+
+  s1ap_asn_arena_begin ();
+  first = s1ap_asn_arena_malloc (40);
+  last = s1ap_asn_arena_malloc (100);
+  // the last block gives its room back, a previous one does not
+  s1ap_asn_arena_free (last);
+  ck_assert_ptr_eq (s1ap_asn_arena_malloc (100), last);
+  s1ap_asn_arena_free (first);
+  ck_assert_ptr_ne (s1ap_asn_arena_malloc (40), first);
+  s1ap_asn_arena_end ();
+}
+END_TEST
+
+START_TEST(arena_realloc_test)
+{
+  uint8_t                                *first = NULL;
+  uint8_t                                *last = NULL;
+  uint8_t                                *moved = NULL;
+
+  s1ap_asn_arena_begin ();
+  first = s1ap_asn_arena_malloc (20);
+  test_arena_fill (first, 20, 1);
+  last = s1ap_asn_arena_malloc (20);
+  test_arena_fill (last, 20, 2);
+  // shrunk or within the alignment: same block
+  ck_assert_ptr_eq (s1ap_asn_arena_realloc (last, 10), last);
+  ck_assert_ptr_eq (s1ap_asn_arena_realloc (last, 32), last);
+  // last block grows in place
+  ck_assert_ptr_eq (s1ap_asn_arena_realloc (last, 1000), last);
+  ck_assert (test_arena_check (last, 20, 2));
+  // any other block moves, its content with it
+  moved = s1ap_asn_arena_realloc (first, 500);
+  ck_assert_ptr_ne (moved, first);
+  ck_assert (s1ap_asn_arena_owns (moved));
+  ck_assert (test_arena_check (moved, 20, 1));
+  ck_assert (test_arena_check (last, 20, 2));
+  // NULL is a malloc
+  ck_assert (s1ap_asn_arena_owns (s1ap_asn_arena_realloc (NULL, 8)));
+  s1ap_asn_arena_end ();
+}
+END_TEST
+
+START_TEST(arena_growth_test)
+{
+  static uint8_t                         *blocks[TEST_ARENA_NB_BLOCKS];
+  uint8_t                                *large = NULL;
+
+  s1ap_asn_arena_begin ();
+  // past one chunk
+  for (int i = 0; i < TEST_ARENA_NB_BLOCKS; i++) {
+    blocks[i] = s1ap_asn_arena_malloc (TEST_ARENA_BLOCK_SIZE);
+    ck_assert_ptr_ne (blocks[i], NULL);
+    test_arena_fill (blocks[i], TEST_ARENA_BLOCK_SIZE, i);
+  }
+  // larger than a chunk
+  large = s1ap_asn_arena_malloc (2 * S1AP_ASN_ARENA_CHUNK_SIZE);
+  ck_assert_ptr_ne (large, NULL);
+  test_arena_fill (large, 2 * S1AP_ASN_ARENA_CHUNK_SIZE, 7);
+  // a last block grown past its chunk moves to a new one
+  blocks[0] = s1ap_asn_arena_realloc (blocks[TEST_ARENA_NB_BLOCKS - 1], S1AP_ASN_ARENA_CHUNK_SIZE);
+  ck_assert (test_arena_check (blocks[0], TEST_ARENA_BLOCK_SIZE, TEST_ARENA_NB_BLOCKS - 1));
+  blocks[TEST_ARENA_NB_BLOCKS - 1] = blocks[0];
+  blocks[0] = NULL;
+
+  for (int i = 1; i < TEST_ARENA_NB_BLOCKS; i++) {
+    ck_assert (s1ap_asn_arena_owns (blocks[i]));
+    ck_assert (test_arena_check (blocks[i], TEST_ARENA_BLOCK_SIZE, i));
+  }
+  ck_assert (s1ap_asn_arena_owns (large));
+  ck_assert (s1ap_asn_arena_owns (&large[2 * S1AP_ASN_ARENA_CHUNK_SIZE - 1]));
+  ck_assert (test_arena_check (large, 2 * S1AP_ASN_ARENA_CHUNK_SIZE, 7));
+  s1ap_asn_arena_end ();
+}
+END_TEST
+
+START_TEST(arena_reset_reuse_test)
+{
+  uint8_t                                *firsts[S1AP_ASN_ARENA_RETAINED_MAX + 2];
+  uint8_t                                *ptr = NULL;
+  int                                     nb_firsts = 0;
+  int                                     nb_reused = 0;
+
+  // first block of each chunk of a scope spanning more chunks than retained
+  s1ap_asn_arena_begin ();
+  for (int i = 0; i < S1AP_ASN_ARENA_RETAINED_MAX + 2; i++) {
+    firsts[nb_firsts++] = s1ap_asn_arena_malloc (S1AP_ASN_ARENA_CHUNK_SIZE - 64);
+  }
+  s1ap_asn_arena_end ();
+
+  // the next scopes start again from the retained chunks
+  for (int round = 0; round < 3; round++) {
+    nb_reused = 0;
+    s1ap_asn_arena_begin ();
+    for (int i = 0; i < S1AP_ASN_ARENA_RETAINED_MAX; i++) {
+      ptr = s1ap_asn_arena_malloc (S1AP_ASN_ARENA_CHUNK_SIZE - 64);
+      ck_assert (s1ap_asn_arena_owns (ptr));
+      for (int j = 0; j < nb_firsts; j++) {
+        nb_reused += (ptr == firsts[j]);
+      }
+      test_arena_fill (ptr, S1AP_ASN_ARENA_CHUNK_SIZE - 64, i);
+    }
+    s1ap_asn_arena_end ();
+    ck_assert_int_eq (nb_reused, S1AP_ASN_ARENA_RETAINED_MAX);
+  }
+
+  // the chunks are reset: a small block starts at the beginning of a retained chunk
+  s1ap_asn_arena_begin ();
+  ptr = s1ap_asn_arena_malloc (8);
+  nb_reused = 0;
+  for (int j = 0; j < nb_firsts; j++) {
+    nb_reused += (ptr == firsts[j]);
+  }
+  ck_assert_int_eq (nb_reused, 1);
+  s1ap_asn_arena_end ();
+}
+END_TEST
+
+START_TEST(arena_nested_scope_test)
+{
+  void                                   *outer = NULL;
+  void                                   *inner = NULL;
+
+  s1ap_asn_arena_begin ();
+  outer = s1ap_asn_arena_malloc (16);
+  s1ap_asn_arena_begin ();
+  inner = s1ap_asn_arena_malloc (16);
+  s1ap_asn_arena_end ();
+  // released by the outermost scope only
+  ck_assert (s1ap_asn_arena_owns (outer));
+  ck_assert (s1ap_asn_arena_owns (inner));
+  s1ap_asn_arena_end ();
+  ck_assert (!s1ap_asn_arena_owns (outer));
+  ck_assert (!s1ap_asn_arena_owns (inner));
+}
+END_TEST
+
+Suite *s1ap_asn_arena_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S1AP asn1c arena tests");
+
+    tc_core = tcase_create("Arena");
+    tcase_add_test(tc_core, arena_outside_scope_test);
+    tcase_add_test(tc_core, arena_allocation_test);
+    tcase_add_test(tc_core, arena_free_last_block_test);
+    tcase_add_test(tc_core, arena_realloc_test);
+    tcase_add_test(tc_core, arena_growth_test);
+    tcase_add_test(tc_core, arena_reset_reuse_test);
+    tcase_add_test(tc_core, arena_nested_scope_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s1ap_asn_arena_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,229 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <check.h>
+
+#include "bstrlib.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+
+#define TEST_PLMN           {0x02, 0xF8, 0x29}
+#define TEST_TAC            0x0004
+#define TEST_CELL_IDENTITY  0x0002000
+
+// lengths around the 1 and 2 octets length determinants and the fragmented form
+static const int test_nas_lengths[] = {1, 2, 9, 120, 124, 125, 126, 127, 128, 129, 255, 256, 4096,
+                                       16360, 16370, 16371, 16372, 16373, 16374, 16380, 16381, 16382, 16383, 16384, 20000};
+
+static const uint32_t test_ue_s1ap_ids[][2] = {
+  {0, 0}, {0xFF, 0xFF}, {0x100, 0x1B3}, {0x0110CECC, 0xFFFF}, {0xFFFFFFFF, 0xFFFFFF}};
+
+typedef struct test_nas_transport_s {
+  uint8_t    *asn1c;
+  uint32_t    asn1c_length;
+  bstring     hand;
+  ssize_t     hand_length;
+} test_nas_transport_t;
+
+static bstring test_nas_pdu (const int nas_length)
+{
+  bstring pdu = bfromcstralloc (nas_length + S1AP_UPLINK_NAS_TRANSPORT_OVERHEAD_MAX + 1, "");
+
+  for (int i = 0; i < nas_length; i++) {
+    bconchar (pdu, (char)(i * 7 + 3));
+  }
+  return pdu;
+}
+
+static void test_nas_transport_free (test_nas_transport_t * const result)
+{
+  free (result->asn1c);
+  bdestroy (result->hand);
+  memset (result, 0, sizeof (*result));
+}
+
+static void test_downlink_nas_transport (test_nas_transport_t * const result, const int nas_length, const uint32_t mme_ue_s1ap_id, const uint32_t enb_ue_s1ap_id)
+{
+  S1ap_DownlinkNASTransportIEs_t          ies;
+  S1ap_DownlinkNASTransport_t             downlinkNASTransport;
+
+  memset (result, 0, sizeof (*result));
+  memset (&ies, 0, sizeof (ies));
+  memset (&downlinkNASTransport, 0, sizeof (downlinkNASTransport));
+  result->hand = test_nas_pdu (nas_length);
+  ies.mme_ue_s1ap_id = mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+  ies.nas_pdu.buf = result->hand->data;
+  ies.nas_pdu.size = nas_length;
+  if ((s1ap_encode_s1ap_downlinknastransporties (&downlinkNASTransport, &ies) < 0) ||
+      (s1ap_generate_initiating_message (&result->asn1c, &result->asn1c_length, S1ap_ProcedureCode_id_downlinkNASTransport,
+          S1ap_Criticality_ignore, &asn_DEF_S1ap_DownlinkNASTransport, &downlinkNASTransport) < 0)) {
+    result->asn1c = NULL;
+    result->asn1c_length = 0;
+  }
+  result->hand_length = s1ap_encode_downlink_nas_transport (result->hand, mme_ue_s1ap_id, enb_ue_s1ap_id);
+}
+
+static void test_uplink_nas_transport (test_nas_transport_t * const result, const int nas_length, const uint32_t mme_ue_s1ap_id, const uint32_t enb_ue_s1ap_id)
+{
+  S1ap_UplinkNASTransportIEs_t            ies;
+  S1ap_UplinkNASTransport_t               uplinkNASTransport;
+  uint8_t                                 plmn[3] = TEST_PLMN;
+  uint8_t                                 tac[2] = {TEST_TAC >> 8, TEST_TAC & 0xFF};
+  uint8_t                                 cell_id[4] = {(TEST_CELL_IDENTITY >> 20) & 0xFF, (TEST_CELL_IDENTITY >> 12) & 0xFF,
+                                                      (TEST_CELL_IDENTITY >> 4) & 0xFF, (TEST_CELL_IDENTITY & 0x0F) << 4};
+
+  memset (result, 0, sizeof (*result));
+  memset (&ies, 0, sizeof (ies));
+  memset (&uplinkNASTransport, 0, sizeof (uplinkNASTransport));
+  result->hand = test_nas_pdu (nas_length);
+  ies.mme_ue_s1ap_id = mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+  ies.nas_pdu.buf = result->hand->data;
+  ies.nas_pdu.size = nas_length;
+  ies.eutran_cgi.pLMNidentity.buf = plmn;
+  ies.eutran_cgi.pLMNidentity.size = 3;
+  ies.eutran_cgi.cell_ID.buf = cell_id;
+  ies.eutran_cgi.cell_ID.size = 4;
+  ies.eutran_cgi.cell_ID.bits_unused = 4;
+  ies.tai.pLMNidentity.buf = plmn;
+  ies.tai.pLMNidentity.size = 3;
+  ies.tai.tAC.buf = tac;
+  ies.tai.tAC.size = 2;
+  if ((s1ap_encode_s1ap_uplinknastransporties (&uplinkNASTransport, &ies) < 0) ||
+      (s1ap_generate_initiating_message (&result->asn1c, &result->asn1c_length, S1ap_ProcedureCode_id_uplinkNASTransport,
+          S1ap_Criticality_ignore, &asn_DEF_S1ap_UplinkNASTransport, &uplinkNASTransport) < 0)) {
+    result->asn1c = NULL;
+    result->asn1c_length = 0;
+  }
+  result->hand_length = s1ap_encode_uplink_nas_transport (result->hand, mme_ue_s1ap_id, enb_ue_s1ap_id, plmn, TEST_TAC, TEST_CELL_IDENTITY);
+}
+
+// same bytes as asn1c, or refused with the NAS PDU left untouched when a length determinant would be fragmented
+static void ck_assert_nas_transport (test_nas_transport_t * const result, const int nas_length)
+{
+  if (result->hand_length < 0) {
+    ck_assert_int_ge (nas_length + S1AP_UPLINK_NAS_TRANSPORT_OVERHEAD_MAX, 16384);
+    ck_assert_int_eq (blength (result->hand), nas_length);
+    for (int i = 0; i < nas_length; i++) {
+      ck_assert_uint_eq (result->hand->data[i], (uint8_t)(i * 7 + 3));
+    }
+    return;
+  }
+  ck_assert_msg (result->asn1c != NULL, "asn1c failed to encode a NAS PDU of %d bytes", nas_length);
+  ck_assert_int_eq (result->hand_length, result->asn1c_length);
+  ck_assert_int_eq (blength (result->hand), result->asn1c_length);
+  ck_assert_msg (0 == memcmp (result->hand->data, result->asn1c, result->asn1c_length), "NAS PDU of %d bytes encoded differently", nas_length);
+}
+
+START_TEST(downlink_nas_transport_asn1c_test)
+{
+  test_nas_transport_t                    result;
+
+  for (int i = 0; i < sizeof (test_nas_lengths) / sizeof (test_nas_lengths[0]); i++) {
+    for (int j = 0; j < sizeof (test_ue_s1ap_ids) / sizeof (test_ue_s1ap_ids[0]); j++) {
+      test_downlink_nas_transport (&result, test_nas_lengths[i], test_ue_s1ap_ids[j][0], test_ue_s1ap_ids[j][1]);
+      ck_assert_nas_transport (&result, test_nas_lengths[i]);
+      test_nas_transport_free (&result);
+    }
+  }
+}
+END_TEST
+
+START_TEST(uplink_nas_transport_asn1c_test)
+{
+  test_nas_transport_t                    result;
+
+  for (int i = 0; i < sizeof (test_nas_lengths) / sizeof (test_nas_lengths[0]); i++) {
+    for (int j = 0; j < sizeof (test_ue_s1ap_ids) / sizeof (test_ue_s1ap_ids[0]); j++) {
+      test_uplink_nas_transport (&result, test_nas_lengths[i], test_ue_s1ap_ids[j][0], test_ue_s1ap_ids[j][1]);
+      ck_assert_nas_transport (&result, test_nas_lengths[i]);
+      test_nas_transport_free (&result);
+    }
+  }
+}
+END_TEST
+
+START_TEST(nas_transport_longest_test)
+{
+  test_nas_transport_t                    result;
+  int                                     longest = 0;
+
+  // the longest NAS PDU encoded by hand is one byte short of the fragmented form
+  for (int nas_length = 16300; nas_length <= 16384; nas_length++) {
+    test_downlink_nas_transport (&result, nas_length, 0xFFFFFFFF, 0xFFFFFF);
+    ck_assert_nas_transport (&result, nas_length);
+    if (result.hand_length > 0) {
+      longest = nas_length;
+    }
+    test_nas_transport_free (&result);
+  }
+  ck_assert_int_gt (longest, 16300);
+  ck_assert_int_lt (longest, 16384);
+}
+END_TEST
+
+START_TEST(nas_transport_empty_test)
+{
+  bstring                                 pdu = bfromcstr ("");
+
+  ck_assert_int_lt (s1ap_encode_downlink_nas_transport (pdu, 1, 1), 0);
+  ck_assert_int_lt (s1ap_encode_downlink_nas_transport (NULL, 1, 1), 0);
+  bdestroy (pdu);
+}
+END_TEST
+
+Suite *s1ap_nas_transport_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S1AP NAS transport tests");
+
+    tc_core = tcase_create("Hand encoding versus asn1c");
+    tcase_add_test(tc_core, downlink_nas_transport_asn1c_test);
+    tcase_add_test(tc_core, uplink_nas_transport_asn1c_test);
+    tcase_add_test(tc_core, nas_transport_longest_test);
+    tcase_add_test(tc_core, nas_transport_empty_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s1ap_nas_transport_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,440 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+/*
+ * The HSS peer selection and the in-flight table are tested without freeDiameter:
+ * the peers are known and open as the test says, the ITTI messages are handed over to the test.
+ */
+#include "s6a_peer.c"
+#include "s6a_inflight.c"
+
+#define TEST_NB_HSS_PEERS       3
+
+s6a_fd_cnf_t                              s6a_fd_cnf;
+__pid_t                                   g_pid = 0;
+struct fd_config                         *fd_g_config = NULL;
+__thread mme_stats_shard_t               *g_mme_stats_shard = NULL;
+
+static mme_stats_shard_t                  test_stats_shard;
+static struct peer_hdr                    test_peers[TEST_NB_HSS_PEERS];
+static bool                               test_peer_known[TEST_NB_HSS_PEERS];
+static int                                test_peer_state[TEST_NB_HSS_PEERS];
+static MessageDef                        *test_sent_message = NULL;
+
+//------------------------------------------------------------------------------
+// Stubs of the log, statistics, ITTI, template and freeDiameter functions
+//------------------------------------------------------------------------------
+log_level_t g_oai_log_level[MAX_LOG_PROTOS] = {[0 ... MAX_LOG_PROTOS - 1] = OAILOG_LEVEL_ERROR};
+
+void log_message (log_thread_ctxt_t * const thread_ctxtP, const log_level_t log_levelP, const log_proto_t protoP,
+    const char *const source_fileP, const unsigned int line_numP, char *format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  vfprintf (stderr, format, args);
+  va_end (args);
+}
+
+void log_func (bool is_entering, const log_proto_t protoP, const char *const source_fileP, const unsigned int line_numP, const char *const function)
+{
+}
+
+void log_func_return (const log_proto_t protoP, const char *const source_fileP, const unsigned int line_numP, const char *const functionP, const long return_codeP)
+{
+}
+
+mme_stats_shard_t *mme_stats_new_shard (void)
+{
+  g_mme_stats_shard = &test_stats_shard;
+  return g_mme_stats_shard;
+}
+
+MessageDef *itti_alloc_new_message (task_id_t origin_task_id, MessagesIds message_id)
+{
+  MessageDef *message_p = calloc (1, sizeof (MessageDef));
+
+  message_p->ittiMsgHeader.messageId = message_id;
+  message_p->ittiMsgHeader.originTaskId = origin_task_id;
+  return message_p;
+}
+
+int itti_send_msg_to_task (task_id_t task_id, instance_t instance, MessageDef *message)
+{
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  test_sent_message = message;
+  return RETURNok;
+}
+
+int itti_free (task_id_t task_id, void *ptr)
+{
+  free (ptr);
+  return RETURNok;
+}
+
+int s6a_template_init (s6a_template_t * const template_p, const mme_config_t * const mme_config_p, const_bstring hss_host_name)
+{
+  template_p->destination_host = bstrcpy (hss_host_name);
+  return RETURNok;
+}
+
+void s6a_template_free (s6a_template_t * const template_p)
+{
+  bdestroy_wrapper (&template_p->destination_host);
+}
+
+int fd_peer_getbyid (DiamId_t diamid, size_t diamidlen, int igncase, struct peer_hdr **peer)
+{
+  *peer = NULL;
+  for (int i = 0; i < TEST_NB_HSS_PEERS; i++) {
+    if ((test_peer_known[i]) && (diamidlen == blength (s6a_fd_cnf.hss_peers[i].request_template.destination_host)) &&
+        (!memcmp (diamid, bdata (s6a_fd_cnf.hss_peers[i].request_template.destination_host), diamidlen))) {
+      *peer = &test_peers[i];
+    }
+  }
+  return 0;
+}
+
+int fd_peer_get_state (struct peer_hdr *peer)
+{
+  return test_peer_state[peer - test_peers];
+}
+
+int fd_peer_add (struct peer_info *info, const char *orig_dbg, void (*cb)(struct peer_info *, void *), void *cb_data)
+{
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void test_setup_hss_peers (const uint32_t weights[TEST_NB_HSS_PEERS])
+{
+  static mme_config_t                     config;
+
+  memset (&config, 0, sizeof (config));
+  config.s6a_config.nb_hss_peers = TEST_NB_HSS_PEERS;
+  for (int i = 0; i < TEST_NB_HSS_PEERS; i++) {
+    config.s6a_config.hss_peers[i].host_name = bformat ("hss%d", i);
+    config.s6a_config.hss_peers[i].weight = weights[i];
+    test_peer_known[i] = true;
+    test_peer_state[i] = STATE_OPEN;
+  }
+  ck_assert_int_eq (s6a_hss_peers_init (&config), RETURNok);
+  for (int i = 0; i < TEST_NB_HSS_PEERS; i++) {
+    bdestroy_wrapper (&config.s6a_config.hss_peers[i].host_name);
+  }
+}
+
+static void setup (void)
+{
+  const uint32_t                          weights[TEST_NB_HSS_PEERS] = {1, 1, 1};
+
+  memset (&s6a_fd_cnf, 0, sizeof (s6a_fd_cnf));
+  memset (&test_stats_shard, 0, sizeof (test_stats_shard));
+  memset (test_peers, 0, sizeof (test_peers));
+  test_sent_message = NULL;
+  test_setup_hss_peers (weights);
+  ck_assert_int_eq (s6a_inflight_init (), RETURNok);
+}
+
+static void teardown (void)
+{
+  free (test_sent_message);
+  test_sent_message = NULL;
+  s6a_inflight_exit ();
+  s6a_hss_peers_exit ();
+}
+
+static void test_set_weights (const uint32_t weights[TEST_NB_HSS_PEERS])
+{
+  for (int i = 0; i < TEST_NB_HSS_PEERS; i++) {
+    s6a_fd_cnf.hss_peers[i].weight = weights[i];
+  }
+}
+
+static s6a_auth_info_req_t test_air (const uint64_t imsi64)
+{
+  s6a_auth_info_req_t                     air;
+
+  memset (&air, 0, sizeof (air));
+  snprintf (air.imsi, sizeof (air.imsi), "%015" PRIu64, imsi64);
+  air.imsi_length = strlen (air.imsi);
+  air.nb_of_vectors = 1;
+  air.visited_plmn.mcc_digit1 = 2;
+  air.visited_plmn.mcc_digit2 = 0;
+  air.visited_plmn.mcc_digit3 = 8;
+  return air;
+}
+
+static s6a_inflight_t *test_inflight (const s6a_inflight_type_t type, const char * const imsi)
+{
+  s6a_inflight_t                         *inflight = NULL;
+
+  hashtable_get (s6a_inflight_htbl, s6a_inflight_key (type, imsi), (void **)&inflight);
+  return inflight;
+}
+
+//------------------------------------------------------------------------------
+START_TEST(hss_peer_weighted_selection_test)
+{
+  const uint32_t                          weights[TEST_NB_HSS_PEERS] = {1, 2, 5};
+  const int                               nb_requests = 800;
+  s6a_auth_info_req_t                     air;
+  int                                     hss_peer = -1;
+
+  test_set_weights (weights);
+  // unanswered requests spread in proportion of the weights
+  for (int i = 0; i < nb_requests; i++) {
+    air = test_air (208930000000000ULL + i);
+    hss_peer = s6a_inflight_air_begin (&air);
+    ck_assert_int_ge (hss_peer, 0);
+    ck_assert_int_lt (hss_peer, TEST_NB_HSS_PEERS);
+    s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)(i + 1));
+  }
+  for (int i = 0; i < TEST_NB_HSS_PEERS; i++) {
+    const int                             expected = nb_requests * weights[i] / 8;
+
+    ck_assert_int_le (s6a_fd_cnf.hss_peers[i].inflight, expected + 1);
+    ck_assert_int_ge (s6a_fd_cnf.hss_peers[i].inflight, expected - 1);
+  }
+  // the answers give the requests back
+  for (int i = 0; i < nb_requests; i++) {
+    air = test_air (208930000000000ULL + i);
+    ck_assert (s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)(i + 1), ER_DIAMETER_SUCCESS));
+  }
+  for (int i = 0; i < TEST_NB_HSS_PEERS; i++) {
+    ck_assert_uint_eq (s6a_fd_cnf.hss_peers[i].inflight, 0);
+  }
+  ck_assert_uint_eq (s6a_inflight_htbl->num_elements, 0);
+}
+END_TEST
+
+START_TEST(hss_peer_open_selection_test)
+{
+  // only the open peers known by freeDiameter, not excluded
+  test_peer_known[0] = false;
+  test_peer_state[1] = STATE_CLOSED;
+  pthread_mutex_lock (&s6a_inflight_lock);
+  ck_assert_int_eq (s6a_hss_peer_select (0), 2);
+  ck_assert_int_eq (s6a_hss_peer_select (1U << 2), -1);
+  ck_assert_ptr_eq (s6a_fd_cnf.hss_peers[0].peer, NULL);
+  pthread_mutex_unlock (&s6a_inflight_lock);
+
+  // known later, picked up by the selection
+  test_peer_known[0] = true;
+  pthread_mutex_lock (&s6a_inflight_lock);
+  ck_assert_int_eq (s6a_hss_peer_select (1U << 2), 0);
+  ck_assert_ptr_eq (s6a_fd_cnf.hss_peers[0].peer, &test_peers[0]);
+  pthread_mutex_unlock (&s6a_inflight_lock);
+
+  // set by the connection of the S6a task
+  s6a_inflight_hss_peer_found (1, &test_peers[1]);
+  ck_assert_ptr_eq (s6a_fd_cnf.hss_peers[1].peer, &test_peers[1]);
+  test_peer_state[1] = STATE_OPEN;
+  ck_assert_int_eq (s6a_inflight_hss_peer_select (), 0);
+
+  // none open: the first one, freeDiameter queues or rejects
+  for (int i = 0; i < TEST_NB_HSS_PEERS; i++) {
+    test_peer_state[i] = STATE_CLOSED;
+  }
+  ck_assert_int_eq (s6a_inflight_hss_peer_select (), 0);
+}
+END_TEST
+
+START_TEST(inflight_merge_test)
+{
+  s6a_auth_info_req_t                     air = test_air (208930000000001ULL);
+  s6a_auth_info_req_t                     other_air = air;
+  s6a_update_location_req_t               ulr;
+  int                                     hss_peer = -1;
+
+  hss_peer = s6a_inflight_air_begin (&air);
+  ck_assert_int_ge (hss_peer, 0);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)1);
+
+  // identical AIR: merged, not sent
+  ck_assert_int_lt (s6a_inflight_air_begin (&air), 0);
+  ck_assert_int_lt (s6a_inflight_air_begin (&air), 0);
+  ck_assert_uint_eq (test_stats_shard.counters[MME_STATS_S6A_REQUEST_MERGED], 2);
+  ck_assert_uint_eq (test_inflight (S6A_INFLIGHT_AIR, air.imsi)->nb_merged, 2);
+  ck_assert_uint_eq (s6a_fd_cnf.hss_peers[hss_peer].inflight, 1);
+
+  // ULR of the same IMSI: tracked apart
+  memset (&ulr, 0, sizeof (ulr));
+  strcpy (ulr.imsi, air.imsi);
+  ck_assert_int_ge (s6a_inflight_ulr_begin (&ulr), 0);
+  ck_assert_ptr_ne (test_inflight (S6A_INFLIGHT_ULR, air.imsi), NULL);
+
+  // a re-synchronization supersedes the pending AIR, no more accounted on its HSS peer
+  other_air.re_synchronization = 1;
+  other_air.auts[0] = 0x55;
+  ck_assert_int_ge (s6a_inflight_air_begin (&other_air), 0);
+  ck_assert_uint_eq (test_inflight (S6A_INFLIGHT_AIR, air.imsi)->nb_merged, 0);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)2);
+  // its repetition is merged, another AUTS is not
+  ck_assert_int_lt (s6a_inflight_air_begin (&other_air), 0);
+  other_air.auts[0] = 0x66;
+  ck_assert_int_ge (s6a_inflight_air_begin (&other_air), 0);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)3);
+
+  // unanswered for too long: no more merged
+  test_inflight (S6A_INFLIGHT_AIR, air.imsi)->sent_sec -= S6A_INFLIGHT_TIMEOUT_SEC;
+  ck_assert_int_ge (s6a_inflight_air_begin (&other_air), 0);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)4);
+
+  // the answer of a superseded query does not end the pending one
+  ck_assert (s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)1, ER_DIAMETER_SUCCESS));
+  ck_assert_ptr_ne (test_inflight (S6A_INFLIGHT_AIR, air.imsi), NULL);
+  ck_assert (s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)4, ER_DIAMETER_SUCCESS));
+  ck_assert_ptr_eq (test_inflight (S6A_INFLIGHT_AIR, air.imsi), NULL);
+
+  // one ULR left accounted
+  ck_assert_uint_eq (s6a_fd_cnf.hss_peers[0].inflight + s6a_fd_cnf.hss_peers[1].inflight + s6a_fd_cnf.hss_peers[2].inflight, 1);
+  ck_assert_ptr_eq (test_sent_message, NULL);
+}
+END_TEST
+
+START_TEST(inflight_failover_test)
+{
+  s6a_auth_info_req_t                     air = test_air (208930000000002ULL);
+  int                                     first = -1;
+  int                                     second = -1;
+  int                                     third = -1;
+
+  first = s6a_inflight_air_begin (&air);
+  ck_assert_int_ge (first, 0);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)1);
+
+  // unable to deliver: sent again by the S6A task, the failure is not forwarded
+  ck_assert (!s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)1, ER_DIAMETER_UNABLE_TO_DELIVER));
+  ck_assert_ptr_ne (test_sent_message, NULL);
+  ck_assert_int_eq (test_sent_message->ittiMsgHeader.messageId, S6A_AUTH_INFO_REQ);
+  ck_assert_str_eq (test_sent_message->ittiMsg.s6a_auth_info_req.imsi, air.imsi);
+  ck_assert_uint_eq (test_stats_shard.counters[MME_STATS_S6A_REQUEST_FAILOVER], 1);
+  ck_assert_uint_eq (s6a_fd_cnf.hss_peers[first].inflight, 0);
+  free (test_sent_message);
+  test_sent_message = NULL;
+
+  // the S6A task sends it to a peer not tried yet, an identical AIR meanwhile is merged
+  second = s6a_inflight_air_begin (&air);
+  ck_assert_int_ge (second, 0);
+  ck_assert_int_ne (second, first);
+  ck_assert_int_lt (s6a_inflight_air_begin (&air), 0);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)2);
+  ck_assert (!s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)2, ER_DIAMETER_TOO_BUSY));
+  free (test_sent_message);
+  test_sent_message = NULL;
+  third = s6a_inflight_air_begin (&air);
+  ck_assert_int_ge (third, 0);
+  ck_assert_int_ne (third, first);
+  ck_assert_int_ne (third, second);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)3);
+
+  // all tried: the failure is forwarded
+  ck_assert (s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)3, ER_DIAMETER_UNABLE_TO_DELIVER));
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  ck_assert_ptr_eq (test_inflight (S6A_INFLIGHT_AIR, air.imsi), NULL);
+  ck_assert_uint_eq (test_stats_shard.counters[MME_STATS_S6A_REQUEST_FAILOVER], 2);
+  for (int i = 0; i < TEST_NB_HSS_PEERS; i++) {
+    ck_assert_uint_eq (s6a_fd_cnf.hss_peers[i].inflight, 0);
+  }
+}
+END_TEST
+
+START_TEST(inflight_failover_closed_peers_test)
+{
+  s6a_auth_info_req_t                     air = test_air (208930000000003ULL);
+  int                                     hss_peer = -1;
+
+  // the only other open peer is closed meanwhile: the failure is forwarded
+  test_peer_state[2] = STATE_CLOSED;
+  hss_peer = s6a_inflight_air_begin (&air);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)1);
+  test_peer_state[1 - hss_peer] = STATE_CLOSED;
+  ck_assert (s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)1, ER_DIAMETER_UNABLE_TO_DELIVER));
+  ck_assert_ptr_eq (test_sent_message, NULL);
+
+  // other failures are not sent again
+  test_peer_state[1 - hss_peer] = STATE_OPEN;
+  ck_assert_int_ge (s6a_inflight_air_begin (&air), 0);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)2);
+  ck_assert (s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)2, DIAMETER_ERROR_USER_UNKNOWN));
+  ck_assert_ptr_eq (test_sent_message, NULL);
+  ck_assert_uint_eq (test_stats_shard.counters[MME_STATS_S6A_REQUEST_FAILOVER], 0);
+}
+END_TEST
+
+START_TEST(inflight_not_sent_test)
+{
+  s6a_auth_info_req_t                     air = test_air (208930000000004ULL);
+  int                                     hss_peer = -1;
+
+  // the AIR could not be built: released without answer, a retry is sent again
+  hss_peer = s6a_inflight_air_begin (&air);
+  ck_assert_int_ge (hss_peer, 0);
+  ck_assert (s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, NULL, 0));
+  ck_assert_ptr_eq (test_inflight (S6A_INFLIGHT_AIR, air.imsi), NULL);
+  ck_assert_uint_eq (s6a_fd_cnf.hss_peers[hss_peer].inflight, 0);
+  ck_assert_int_ge (s6a_inflight_air_begin (&air), 0);
+  s6a_inflight_sent (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)1);
+  ck_assert (s6a_inflight_end (S6A_INFLIGHT_AIR, air.imsi, (struct msg *)(uintptr_t)1, ER_DIAMETER_SUCCESS));
+  ck_assert_ptr_eq (test_sent_message, NULL);
+}
+END_TEST
+
+Suite *s6a_inflight_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S6a HSS peers tests");
+
+    tc_core = tcase_create("HSS peers and in-flight requests");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_add_test(tc_core, hss_peer_weighted_selection_test);
+    tcase_add_test(tc_core, hss_peer_open_selection_test);
+    tcase_add_test(tc_core, inflight_merge_test);
+    tcase_add_test(tc_core, inflight_failover_test);
+    tcase_add_test(tc_core, inflight_failover_closed_peers_test);
+    tcase_add_test(tc_core, inflight_not_sent_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s6a_inflight_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
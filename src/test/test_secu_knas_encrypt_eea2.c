@@ -42,6 +42,7 @@ eea2_encrypt (
 {
   nas_stream_cipher_t                    *nas_cipher;
   uint8_t                                *result;
+  nas_stream_key_schedule_t               key_schedule;
   uint32_t                                zero_bits = length & 7;
   uint32_t                                byte_length = length >> 3;
 
@@ -64,6 +65,18 @@ eea2_encrypt (
     fail ("Fail: eea2_encrypt\n");
   }
 
+  /*
+   * Ciphered in place with the key schedule
+   */
+  nas_stream_key_schedule_init (&key_schedule, key);
+
+  if (nas_stream_encrypt_eea2_scheduled (&key_schedule, nas_cipher, message) != 0)
+    fail ("Fail: nas_stream_encrypt_eea2_scheduled\n");
+
+  if (compare_buffer (message, byte_length, expected, byte_length) != 0) {
+    fail ("Fail: eea2_encrypt_scheduled\n");
+  }
+
   free (nas_cipher);
   free (result);
 }
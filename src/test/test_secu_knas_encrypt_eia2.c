@@ -43,6 +43,7 @@ eia2_encrypt (
 {
   nas_stream_cipher_t                     nas_cipher;
   uint8_t                                 result[4];
+  nas_stream_key_schedule_t               key_schedule;
 
   nas_cipher.direction = direction;
   nas_cipher.count = count;
@@ -59,6 +60,16 @@ eia2_encrypt (
   if (compare_buffer (result, 4, expected, length_expected) != 0) {
     fail ("Fail: eia2_encrypt\n");
   }
+
+  nas_stream_key_schedule_init (&key_schedule, key);
+
+  if (nas_stream_encrypt_eia2_scheduled (&key_schedule, &nas_cipher, result) != 0) {
+    fail ("Fail: nas_stream_encrypt_eia2_scheduled\n");
+  }
+
+  if (compare_buffer (result, 4, expected, length_expected) != 0) {
+    fail ("Fail: eia2_encrypt_scheduled\n");
+  }
 }
 
 void
@@ -26,6 +26,7 @@
   \email: lionel.gauthier@eurecom.fr
 */
 
+#define _GNU_SOURCE             // required for recvmmsg() and sendmmsg()
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -53,7 +54,8 @@
 
 
 struct udp_socket_desc_s {
-  uint8_t                                 buffer[4096];
+  /* Pool of UDP_DATA_IND messages, datagrams are received in place then the messages are handed to task_id */
+  MessageDef                             *rx_msgs[UDP_BATCH_SIZE_MAX];
   int                                     sd;   /* Socket descriptor to use */
 
   pthread_t                               listener_thread;      /* Thread affected to recv */
@@ -73,6 +75,23 @@ STAILQ_HEAD (
   udp_socket_desc_s) udp_socket_list;
      static pthread_mutex_t                  udp_socket_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+static uint16_t                         udp_batch_size = UDP_BATCH_SIZE_DEFAULT;
+static bool                             udp_reuse_port = false;
+
+/*
+ * UDP_DATA_REQ waiting to be sent with a single sendmmsg, all on the same socket.
+ * The datagrams are copied: the buffer of a UDP_DATA_REQ belongs to the sending
+ * stack and is not guaranteed to outlive its ITTI message.
+ */
+static struct {
+  int                                     sd;
+  unsigned int                            count;
+  struct mmsghdr                          msgs[UDP_BATCH_SIZE_MAX];
+  struct iovec                            iovs[UDP_BATCH_SIZE_MAX];
+  struct sockaddr_in                      peers[UDP_BATCH_SIZE_MAX];
+  uint8_t                                 bufs[UDP_BATCH_SIZE_MAX][UDP_DATA_MAX_MSG_LEN];
+} udp_tx_batch;
+
 
 static void                             udp_server_receive_and_process (
   struct udp_socket_desc_s *udp_sock_pP);
@@ -155,6 +174,20 @@ udp_server_create_socket (
     return sd;
   }
 
+  /*
+   * Several tasks (sharded GTPv2-C stacks) may bind the same address and port,
+   * the kernel spreads the peers on their sockets
+   */
+  if (udp_reuse_port) {
+    const int                               on = 1;
+
+    if (setsockopt (sd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof (on)) < 0) {
+      OAILOG_ERROR (LOG_UDP, "setsockopt SO_REUSEPORT failed (%s)\n", strerror (errno));
+      close (sd);
+      return -1;
+    }
+  }
+
   memset (&addr, 0, sizeof (struct sockaddr_in));
   addr.sin_family = AF_INET;
   addr.sin_port = htons (port);
@@ -236,44 +269,135 @@ static void
 udp_server_receive_and_process (
   struct udp_socket_desc_s *udp_sock_pP)
 {
-  OAILOG_DEBUG (LOG_UDP, "Inserting new descriptor for task %d, sd %d\n", udp_sock_pP->task_id, udp_sock_pP->sd);
-  {
-    int                                     bytes_received = 0;
-    socklen_t                               from_len;
-    struct sockaddr_in                      addr;
-
-    from_len = (socklen_t) sizeof (struct sockaddr_in);
-
-    if ((bytes_received = recvfrom (udp_sock_pP->sd, udp_sock_pP->buffer, sizeof (udp_sock_pP->buffer), 0, (struct sockaddr *)&addr, &from_len)) <= 0) {
-      OAILOG_ERROR (LOG_UDP, "Recvfrom failed %s\n", strerror (errno));
-      //break;
-    } else {
-      MessageDef                             *message_p = NULL;
-      udp_data_ind_t                         *udp_data_ind_p;
-      AssertFatal (sizeof (udp_sock_pP->buffer) >= bytes_received, "UDP BUFFER OVERFLOW");
-      message_p = itti_alloc_new_message (TASK_UDP, UDP_DATA_IND);
-      DevAssert (message_p != NULL);
-      udp_data_ind_p = &message_p->ittiMsg.udp_data_ind;
-      memcpy (udp_data_ind_p->msgBuf, udp_sock_pP->buffer, bytes_received);
-
-      udp_data_ind_p->buffer_length = bytes_received;
-      udp_data_ind_p->local_port = udp_sock_pP->local_port;
-      udp_data_ind_p->peer_port = htons (addr.sin_port);
-      udp_data_ind_p->peer_address = addr.sin_addr;
-      OAILOG_DEBUG (LOG_UDP, "Msg of length %d received from %s:%u\n", bytes_received, inet_ntoa (addr.sin_addr), ntohs (addr.sin_port));
-
-      if (itti_send_msg_to_task (udp_sock_pP->task_id, INSTANCE_DEFAULT, message_p) < 0) {
-        OAILOG_DEBUG (LOG_UDP, "Failed to send message %d to task %d\n", UDP_DATA_IND, udp_sock_pP->task_id);
-        //break;
+  struct mmsghdr                          msgs[UDP_BATCH_SIZE_MAX];
+  struct iovec                            iovs[UDP_BATCH_SIZE_MAX];
+  struct sockaddr_in                      addrs[UDP_BATCH_SIZE_MAX];
+  int                                     nb_msgs = 0;
+
+  memset (msgs, 0, sizeof (msgs[0]) * udp_batch_size);
+  for (int i = 0; i < udp_batch_size; i++) {
+    // replace the messages handed to the task on the previous call
+    if (!udp_sock_pP->rx_msgs[i]) {
+      udp_sock_pP->rx_msgs[i] = itti_alloc_new_message (TASK_UDP, UDP_DATA_IND);
+      DevAssert (udp_sock_pP->rx_msgs[i] != NULL);
+    }
+    iovs[i].iov_base = udp_sock_pP->rx_msgs[i]->ittiMsg.udp_data_ind.msgBuf;
+    iovs[i].iov_len  = UDP_DATA_MAX_MSG_LEN;
+    msgs[i].msg_hdr.msg_iov     = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen  = 1;
+    msgs[i].msg_hdr.msg_name    = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+  }
+
+  if ((nb_msgs = recvmmsg (udp_sock_pP->sd, msgs, udp_batch_size, MSG_DONTWAIT, NULL)) <= 0) {
+    if ((nb_msgs < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+      OAILOG_ERROR (LOG_UDP, "Recvmmsg failed %s\n", strerror (errno));
+    }
+    return;
+  }
+  OAILOG_DEBUG (LOG_UDP, "Received %d datagrams on sd %d for task %d\n", nb_msgs, udp_sock_pP->sd, udp_sock_pP->task_id);
+
+  for (int i = 0; i < nb_msgs; i++) {
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      // keep the message in the pool
+      OAILOG_ERROR (LOG_UDP, "Dropped datagram from %s:%u larger than %d bytes\n", inet_ntoa (addrs[i].sin_addr), ntohs (addrs[i].sin_port), UDP_DATA_MAX_MSG_LEN);
+      continue;
+    }
+    MessageDef                             *message_p = udp_sock_pP->rx_msgs[i];
+    udp_data_ind_t                         *udp_data_ind_p = &message_p->ittiMsg.udp_data_ind;
+
+    udp_sock_pP->rx_msgs[i] = NULL;
+    udp_data_ind_p->buffer_length = msgs[i].msg_len;
+    udp_data_ind_p->local_port = udp_sock_pP->local_port;
+    udp_data_ind_p->peer_port = htons (addrs[i].sin_port);
+    udp_data_ind_p->peer_address = addrs[i].sin_addr;
+    OAILOG_DEBUG (LOG_UDP, "Msg of length %u received from %s:%u\n", msgs[i].msg_len, inet_ntoa (addrs[i].sin_addr), ntohs (addrs[i].sin_port));
+
+    if (itti_send_msg_to_task (udp_sock_pP->task_id, INSTANCE_DEFAULT, message_p) < 0) {
+      OAILOG_DEBUG (LOG_UDP, "Failed to send message %d to task %d\n", UDP_DATA_IND, udp_sock_pP->task_id);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void
+udp_server_flush_data_reqs (void)
+{
+  unsigned int                            sent = 0;
+
+  while (sent < udp_tx_batch.count) {
+    int                                     rc = sendmmsg (udp_tx_batch.sd, &udp_tx_batch.msgs[sent], udp_tx_batch.count - sent, 0);
+
+    if (rc <= 0) {
+      // skip the datagram that failed, try the next ones
+      OAILOG_ERROR (LOG_UDP, "There was an error while writing to socket " "(%d:%s)\n", errno, strerror (errno));
+      sent += 1;
+      continue;
+    }
+    for (int i = sent; i < sent + rc; i++) {
+      if (udp_tx_batch.msgs[i].msg_len != udp_tx_batch.iovs[i].iov_len) {
+        OAILOG_ERROR (LOG_UDP, "Partial write to socket %d (%u/%zu)\n", udp_tx_batch.sd, udp_tx_batch.msgs[i].msg_len, udp_tx_batch.iovs[i].iov_len);
       }
     }
+    sent += rc;
+  }
+  udp_tx_batch.count = 0;
+}
+
+//------------------------------------------------------------------------------
+static int
+udp_server_queue_data_req (
+  task_id_t origin_task_id,
+  const udp_data_req_t * const udp_data_req_p)
+{
+  int                                     udp_sd = -1;
+  struct udp_socket_desc_s               *udp_sock_p = NULL;
+
+  pthread_mutex_lock (&udp_socket_list_mutex);
+  udp_sock_p = udp_server_get_socket_desc (origin_task_id, udp_data_req_p->local_port, udp_data_req_p->peer_port);
+
+  if (udp_sock_p == NULL) {
+    OAILOG_ERROR (LOG_UDP, "Failed to retrieve the udp socket descriptor " "associated with task %d\n", origin_task_id);
+    pthread_mutex_unlock (&udp_socket_list_mutex);
+    return RETURNerror;
+  }
+
+  udp_sd = udp_sock_p->sd;
+  pthread_mutex_unlock (&udp_socket_list_mutex);
+
+  if (udp_data_req_p->buffer_length > UDP_DATA_MAX_MSG_LEN) {
+    OAILOG_ERROR (LOG_UDP, "Message of size %u to " IN_ADDR_FMT " exceeds %u bytes, not sent\n",
+        udp_data_req_p->buffer_length, PRI_IN_ADDR (udp_data_req_p->peer_address), UDP_DATA_MAX_MSG_LEN);
+    return RETURNerror;
+  }
+
+  if ((udp_tx_batch.count) && (udp_tx_batch.sd != udp_sd)) {
+    udp_server_flush_data_reqs ();
   }
-  //close(udp_sock_pP->sd);
-  //udp_sock_pP->sd = -1;
-  //pthread_mutex_lock(&udp_socket_list_mutex);
-  //STAILQ_REMOVE(&udp_socket_list, udp_sock_pP, udp_socket_desc_s, entries);
-  //pthread_mutex_unlock(&udp_socket_list_mutex);
-  //return NULL;
+  OAILOG_DEBUG (LOG_UDP, "[%d] Sending message of size %u to " IN_ADDR_FMT " and port %u\n",
+      udp_sd, udp_data_req_p->buffer_length, PRI_IN_ADDR (udp_data_req_p->peer_address), udp_data_req_p->peer_port);
+
+  const unsigned int                      i = udp_tx_batch.count++;
+  struct sockaddr_in                     *peer_addr = &udp_tx_batch.peers[i];
+
+  memset (peer_addr, 0, sizeof (struct sockaddr_in));
+  peer_addr->sin_family = AF_INET;
+  peer_addr->sin_port = htons (udp_data_req_p->peer_port);
+  peer_addr->sin_addr = udp_data_req_p->peer_address;
+  memcpy (udp_tx_batch.bufs[i], &udp_data_req_p->buffer[udp_data_req_p->buffer_offset], udp_data_req_p->buffer_length);
+  udp_tx_batch.iovs[i].iov_base = udp_tx_batch.bufs[i];
+  udp_tx_batch.iovs[i].iov_len  = udp_data_req_p->buffer_length;
+  memset (&udp_tx_batch.msgs[i], 0, sizeof (struct mmsghdr));
+  udp_tx_batch.msgs[i].msg_hdr.msg_iov     = &udp_tx_batch.iovs[i];
+  udp_tx_batch.msgs[i].msg_hdr.msg_iovlen  = 1;
+  udp_tx_batch.msgs[i].msg_hdr.msg_name    = peer_addr;
+  udp_tx_batch.msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+  udp_tx_batch.sd = udp_sd;
+
+  if (udp_tx_batch.count >= udp_batch_size) {
+    udp_server_flush_data_reqs ();
+  }
+  return RETURNok;
 }
 
 //------------------------------------------------------------------------------
@@ -287,10 +411,15 @@ static void *udp_intertask_interface (void *args_p)
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
+    int                                     nb_msgs = 0;
 
     itti_receive_msg (TASK_UDP, &received_message_p);
 
-    if (received_message_p != NULL) {
+    /*
+     * Drain what is already queued without blocking (bounded by the batch size),
+     * UDP_DATA_REQ are sent by batches when the queue is empty
+     */
+    while (received_message_p != NULL) {
       switch (ITTI_MSG_ID (received_message_p)) {
       case MESSAGE_TEST:{
           OAI_FPRINTF_INFO("TASK_UDP received MESSAGE_TEST\n");
@@ -299,6 +428,7 @@ static void *udp_intertask_interface (void *args_p)
 
 
       case TERMINATE_MESSAGE:{
+          udp_server_flush_data_reqs ();
           udp_exit();
           itti_free_msg_content(received_message_p);
           itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
@@ -314,41 +444,8 @@ static void *udp_intertask_interface (void *args_p)
         break;
 
       case UDP_DATA_REQ:{
-          int                                     udp_sd = -1;
-          ssize_t                                 bytes_written;
-          struct udp_socket_desc_s               *udp_sock_p = NULL;
-          udp_data_req_t                         *udp_data_req_p;
-          struct sockaddr_in                      peer_addr;
-
-          udp_data_req_p = &received_message_p->ittiMsg.udp_data_req;
-          //UDP_DEBUG("-- UDP_DATA_REQ -----------------------------------------------------\n%s :\n",
-          //        __FUNCTION__);
-          //udp_print_hex_octets(&udp_data_req_p->buffer[udp_data_req_p->buffer_offset],
-          //        udp_data_req_p->buffer_length);
-          memset (&peer_addr, 0, sizeof (struct sockaddr_in));
-          peer_addr.sin_family = AF_INET;
-          peer_addr.sin_port = htons (udp_data_req_p->peer_port);
-          peer_addr.sin_addr = udp_data_req_p->peer_address;
-          pthread_mutex_lock (&udp_socket_list_mutex);
-          udp_sock_p = udp_server_get_socket_desc (ITTI_MSG_ORIGIN_ID (received_message_p), udp_data_req_p->local_port, udp_data_req_p->peer_port);
-
-          if (udp_sock_p == NULL) {
-            OAILOG_ERROR (LOG_UDP, "Failed to retrieve the udp socket descriptor " "associated with task %d\n", ITTI_MSG_ORIGIN_ID (received_message_p));
-            pthread_mutex_unlock (&udp_socket_list_mutex);
-            // no free udp_data_req_p->buffer, statically allocated
-            goto on_error;
-          }
-
-          udp_sd = udp_sock_p->sd;
-          pthread_mutex_unlock (&udp_socket_list_mutex);
-          OAILOG_DEBUG (LOG_UDP, "[%d] Sending message of size %u to " IN_ADDR_FMT " and port %u\n",
-              udp_sd, udp_data_req_p->buffer_length, PRI_IN_ADDR (udp_data_req_p->peer_address), udp_data_req_p->peer_port);
-          bytes_written = sendto (udp_sd, &udp_data_req_p->buffer[udp_data_req_p->buffer_offset], udp_data_req_p->buffer_length, 0, (struct sockaddr *)&peer_addr, sizeof (struct sockaddr_in));
           // no free udp_data_req_p->buffer, statically allocated
-
-          if (bytes_written != udp_data_req_p->buffer_length) {
-            OAILOG_ERROR (LOG_UDP, "There was an error while writing to socket " "(%d:%s)\n", errno, strerror (errno));
-          }
+          udp_server_queue_data_req (ITTI_MSG_ORIGIN_ID (received_message_p), &received_message_p->ittiMsg.udp_data_req);
         }
         break;
 
@@ -358,12 +455,16 @@ static void *udp_intertask_interface (void *args_p)
         break;
       }
 
-    on_error:
       itti_free_msg_content(received_message_p);
       rc = itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
       AssertFatal (rc == EXIT_SUCCESS, "Failed to free memory (%d)!\n", rc);
       received_message_p = NULL;
+
+      if (++nb_msgs < udp_batch_size) {
+        itti_poll_msg (TASK_UDP, &received_message_p);
+      }
     }
+    udp_server_flush_data_reqs ();
 
     nb_events = itti_get_events (TASK_UDP, &events);
 
@@ -383,6 +484,13 @@ int udp_init (void)
 {
   OAILOG_DEBUG (LOG_UDP, "Initializing UDP task interface\n");
   STAILQ_INIT (&udp_socket_list);
+  mme_config_read_lock (&mme_config);
+  udp_batch_size = mme_config.udp_config.batch_size;
+  udp_reuse_port = mme_config.udp_config.reuse_port;
+  mme_config_unlock (&mme_config);
+  if ((udp_batch_size < 1) || (udp_batch_size > UDP_BATCH_SIZE_MAX)) {
+    udp_batch_size = UDP_BATCH_SIZE_DEFAULT;
+  }
 
   if (itti_create_task (TASK_UDP, &udp_intertask_interface, NULL) < 0) {
     OAILOG_ERROR (LOG_UDP, "udp pthread_create (%s)\n", strerror (errno));
@@ -400,6 +508,11 @@ void udp_exit (void)
   while ((socket_desc_p = STAILQ_FIRST (&udp_socket_list))) {
     itti_unsubscribe_event_fd(TASK_UDP, socket_desc_p->sd);
     close(socket_desc_p->sd);
+    for (int i = 0; i < UDP_BATCH_SIZE_MAX; i++) {
+      if (socket_desc_p->rx_msgs[i]) {
+        itti_free (TASK_UDP, socket_desc_p->rx_msgs[i]);
+      }
+    }
     pthread_mutex_destroy(&udp_socket_list_mutex);
     STAILQ_REMOVE_HEAD (&udp_socket_list, entries);
     free_wrapper ((void**)&socket_desc_p);
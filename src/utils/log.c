@@ -35,6 +35,7 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <ctype.h>
@@ -47,6 +48,7 @@
 #include "timer.h"
 #include "log.h"
 #include "shared_ts_log.h"
+#include "log_binary.h"
 #include "assertions.h"
 #include "dynamic_memory_check.h"
 
@@ -100,6 +102,7 @@ typedef struct oai_log_s {
   bool                                    is_output_is_fd;                                      /* We may want to not use syslog even if exe is a daemon */
   bool                                    is_output_fd_buffered;                                /* We way want no buffering */
   bool                                    is_ansi_codes;                                        /* ANSI codes for color in console output */
+  bool                                    is_binary_output;                                     /* log_message() does not format, see log_binary.h */
   bstring                                 bserver_address;                                      /*!< \brief TCP remote (or local) server hostname */
   bstring                                 bserver_port ;                                        /*!< \brief TCP remote (or local) server port     */
   log_tcp_state_t                         tcp_state;                                            /*!< \brief State of the client TCP connection           */
@@ -108,14 +111,26 @@ typedef struct oai_log_s {
   char                                    log_level2str[MAX_LOG_LEVEL][LOG_LEVEL_NAME_MAX_LENGTH];     /*!< \brief Convert log level id into human readable log level string */
   char                                    log_level2ansi[MAX_LOG_LEVEL][ANSI_CODE_MAX_LENGTH];     /*!< \brief Convert log level id into human readable log level string */
   int                                     log_start_time_second;                                       /*!< \brief Logging utility reference time              */
-  log_level_t                             log_level[MAX_LOG_PROTOS];                                   /*!< \brief Loglevel id of each client (protocol/layer) */
 
   log_message_number_t                    log_message_number;                                          /*!< \brief Counter of log message        */
-  hash_table_ts_t                           *thread_context_htbl;                                         /*!< \brief Container for log_thread_ctxt_t */
 } oai_log_t;
 
 static oai_log_t g_oai_log={0};    /*!< \brief  logging utility internal variables global var definition*/
 
+log_level_t                               g_oai_log_level[MAX_LOG_PROTOS] = {0}; /*!< \brief Loglevel id of each client (protocol/layer), read by the OAILOG macros */
+
+static __thread log_thread_ctxt_t         g_log_thread_ctxt = {0};  /*!< \brief Context of the calling thread, tid is 0 until log_start_use() */
+
+//------------------------------------------------------------------------------
+static inline log_thread_ctxt_t * log_get_thread_ctxt (void)
+{
+  if (!g_log_thread_ctxt.tid) {
+    // thread not started by ITTI
+    log_start_use ();
+  }
+  return &g_log_thread_ctxt;
+}
+
 //------------------------------------------------------------------------------
 void* log_task (__attribute__ ((unused)) void *args_p)
 {
@@ -238,36 +253,42 @@ void log_connect_to_server(void)
 void log_set_config(const log_config_t * const config)
 {
   if (config) {
-    if ((MAX_LOG_LEVEL > config->udp_log_level) && (MIN_LOG_LEVEL <= config->udp_log_level))         g_oai_log.log_level[LOG_UDP] = config->udp_log_level;
-    if ((MAX_LOG_LEVEL > config->gtpv1u_log_level) && (MIN_LOG_LEVEL <= config->gtpv1u_log_level))   g_oai_log.log_level[LOG_GTPV1U]   = config->gtpv1u_log_level;
-    if ((MAX_LOG_LEVEL > config->gtpv2c_log_level) && (MIN_LOG_LEVEL <= config->gtpv2c_log_level))   g_oai_log.log_level[LOG_GTPV2C]   = config->gtpv2c_log_level;
-    if ((MAX_LOG_LEVEL > config->sctp_log_level) && (MIN_LOG_LEVEL <= config->sctp_log_level))       g_oai_log.log_level[LOG_SCTP]     = config->sctp_log_level;
-    if ((MAX_LOG_LEVEL > config->s1ap_log_level) && (MIN_LOG_LEVEL <= config->s1ap_log_level))       g_oai_log.log_level[LOG_S1AP]     = config->s1ap_log_level;
-    if ((MAX_LOG_LEVEL > config->mme_app_log_level) && (MIN_LOG_LEVEL <= config->mme_app_log_level)) g_oai_log.log_level[LOG_MME_APP]  = config->mme_app_log_level;
+    if ((MAX_LOG_LEVEL > config->udp_log_level) && (MIN_LOG_LEVEL <= config->udp_log_level))         g_oai_log_level[LOG_UDP] = config->udp_log_level;
+    if ((MAX_LOG_LEVEL > config->gtpv1u_log_level) && (MIN_LOG_LEVEL <= config->gtpv1u_log_level))   g_oai_log_level[LOG_GTPV1U]   = config->gtpv1u_log_level;
+    if ((MAX_LOG_LEVEL > config->gtpv2c_log_level) && (MIN_LOG_LEVEL <= config->gtpv2c_log_level))   g_oai_log_level[LOG_GTPV2C]   = config->gtpv2c_log_level;
+    if ((MAX_LOG_LEVEL > config->sctp_log_level) && (MIN_LOG_LEVEL <= config->sctp_log_level))       g_oai_log_level[LOG_SCTP]     = config->sctp_log_level;
+    if ((MAX_LOG_LEVEL > config->s1ap_log_level) && (MIN_LOG_LEVEL <= config->s1ap_log_level))       g_oai_log_level[LOG_S1AP]     = config->s1ap_log_level;
+    if ((MAX_LOG_LEVEL > config->mme_app_log_level) && (MIN_LOG_LEVEL <= config->mme_app_log_level)) g_oai_log_level[LOG_MME_APP]  = config->mme_app_log_level;
     if ((MAX_LOG_LEVEL > config->nas_log_level) && (MIN_LOG_LEVEL <= config->nas_log_level)) {
-      g_oai_log.log_level[LOG_NAS]      = config->nas_log_level;
-      g_oai_log.log_level[LOG_NAS_EMM]  = config->nas_log_level;
-      g_oai_log.log_level[LOG_NAS_ESM]  = config->nas_log_level;
+      g_oai_log_level[LOG_NAS]      = config->nas_log_level;
+      g_oai_log_level[LOG_NAS_EMM]  = config->nas_log_level;
+      g_oai_log_level[LOG_NAS_ESM]  = config->nas_log_level;
     }
-    if ((MAX_LOG_LEVEL > config->spgw_app_log_level) && (MIN_LOG_LEVEL <= config->spgw_app_log_level)) g_oai_log.log_level[LOG_SPGW_APP] = config->spgw_app_log_level;
-    if ((MAX_LOG_LEVEL > config->s10_log_level) && (MIN_LOG_LEVEL <= config->s10_log_level))           g_oai_log.log_level[LOG_S10]      = config->s10_log_level;
-    if ((MAX_LOG_LEVEL > config->s11_log_level) && (MIN_LOG_LEVEL <= config->s11_log_level))           g_oai_log.log_level[LOG_S11]      = config->s11_log_level;
-    if ((MAX_LOG_LEVEL > config->s6a_log_level) && (MIN_LOG_LEVEL <= config->s6a_log_level))           g_oai_log.log_level[LOG_S6A]      = config->s6a_log_level;
-    if ((MAX_LOG_LEVEL > config->secu_log_level) && (MIN_LOG_LEVEL <= config->secu_log_level))         g_oai_log.log_level[LOG_SECU]     = config->secu_log_level;
-    if ((MAX_LOG_LEVEL > config->util_log_level) && (MIN_LOG_LEVEL <= config->util_log_level))         g_oai_log.log_level[LOG_UTIL]     = config->util_log_level;
-    if ((MAX_LOG_LEVEL > config->msc_log_level) && (MIN_LOG_LEVEL <= config->msc_log_level))           g_oai_log.log_level[LOG_MSC]      = config->msc_log_level;
-    if ((MAX_LOG_LEVEL > config->xml_log_level) && (MIN_LOG_LEVEL <= config->xml_log_level))           g_oai_log.log_level[LOG_XML]      = config->xml_log_level;
+    if ((MAX_LOG_LEVEL > config->spgw_app_log_level) && (MIN_LOG_LEVEL <= config->spgw_app_log_level)) g_oai_log_level[LOG_SPGW_APP] = config->spgw_app_log_level;
+    if ((MAX_LOG_LEVEL > config->s10_log_level) && (MIN_LOG_LEVEL <= config->s10_log_level))           g_oai_log_level[LOG_S10]      = config->s10_log_level;
+    if ((MAX_LOG_LEVEL > config->s11_log_level) && (MIN_LOG_LEVEL <= config->s11_log_level))           g_oai_log_level[LOG_S11]      = config->s11_log_level;
+    if ((MAX_LOG_LEVEL > config->s6a_log_level) && (MIN_LOG_LEVEL <= config->s6a_log_level))           g_oai_log_level[LOG_S6A]      = config->s6a_log_level;
+    if ((MAX_LOG_LEVEL > config->secu_log_level) && (MIN_LOG_LEVEL <= config->secu_log_level))         g_oai_log_level[LOG_SECU]     = config->secu_log_level;
+    if ((MAX_LOG_LEVEL > config->util_log_level) && (MIN_LOG_LEVEL <= config->util_log_level))         g_oai_log_level[LOG_UTIL]     = config->util_log_level;
+    if ((MAX_LOG_LEVEL > config->msc_log_level) && (MIN_LOG_LEVEL <= config->msc_log_level))           g_oai_log_level[LOG_MSC]      = config->msc_log_level;
+    if ((MAX_LOG_LEVEL > config->xml_log_level) && (MIN_LOG_LEVEL <= config->xml_log_level))           g_oai_log_level[LOG_XML]      = config->xml_log_level;
     if ((MAX_LOG_LEVEL > config->mme_scenario_player_log_level) && (MIN_LOG_LEVEL <= config->mme_scenario_player_log_level))
-      g_oai_log.log_level[LOG_MME_SCENARIO_PLAYER]      = config->mme_scenario_player_log_level;
-    if ((MAX_LOG_LEVEL > config->itti_log_level) && (MIN_LOG_LEVEL <= config->itti_log_level))         g_oai_log.log_level[LOG_ITTI]     = config->itti_log_level;
+      g_oai_log_level[LOG_MME_SCENARIO_PLAYER]      = config->mme_scenario_player_log_level;
+    if ((MAX_LOG_LEVEL > config->itti_log_level) && (MIN_LOG_LEVEL <= config->itti_log_level))         g_oai_log_level[LOG_ITTI]     = config->itti_log_level;
     if ((MAX_LOG_LEVEL > config->async_system_log_level) && (MIN_LOG_LEVEL <= config->async_system_log_level))
-      g_oai_log.log_level[LOG_ASYNC_SYSTEM] = config->async_system_log_level;
+      g_oai_log_level[LOG_ASYNC_SYSTEM] = config->async_system_log_level;
 
 
     g_oai_log.is_output_fd_buffered = config->is_output_thread_safe;
 
     g_oai_log.is_ansi_codes = config->color;
 
+    if ((config->binary_output) && (!g_oai_log.is_binary_output)) {
+      int rv = log_binary_init (bdata(config->binary_output), g_oai_log.log_start_time_second);
+      AssertFatal (0 == rv, "Could not open binary log file %s", bdata(config->binary_output));
+      g_oai_log.is_binary_output = true;
+    }
+
     if (config->output) {
       g_oai_log.log_fd = NULL;
       g_oai_log.is_output_is_fd = false;
@@ -358,24 +379,6 @@ log_init (
 
   g_oai_log.log_start_time_second = shared_log_get_start_time_sec();
 
-
-  bstring b = bfromcstr("Logging thread context hashtable");
-  g_oai_log.thread_context_htbl = hashtable_ts_create (LOG_MESSAGE_MIN_ALLOC_SIZE, NULL, free_wrapper, b);
-  bdestroy_wrapper (&b);
-  AssertFatal (NULL != g_oai_log.thread_context_htbl, "Could not create hashtable for Log!\n");
-  g_oai_log.thread_context_htbl->log_enabled = false;
-
-
-  log_thread_ctxt_t *thread_ctxt = calloc(1, sizeof(log_thread_ctxt_t));
-  AssertFatal(NULL != thread_ctxt, "Error Could not create log thread context\n");
-  pthread_t p = pthread_self();
-  thread_ctxt->tid = p;
-  hashtable_rc_t hash_rc = hashtable_ts_insert(g_oai_log.thread_context_htbl, (hash_key_t) p, thread_ctxt);
-  if (HASH_TABLE_OK != hash_rc) {
-    OAI_FPRINTF_ERR("Error Could not register log thread context\n");
-    free_wrapper((void**)thread_ctxt);
-  }
-
   log_start_use ();
 
   snprintf (&g_oai_log.log_proto2str[LOG_SCTP][0], LOG_MAX_PROTO_NAME_LENGTH, "SCTP");
@@ -421,7 +424,7 @@ log_init (
   snprintf (&g_oai_log.log_level2ansi[OAILOG_LEVEL_EMERGENCY][0], ANSI_CODE_MAX_LENGTH, ANSI_COLOR_FG_REV_RED);
 
   for (i=MIN_LOG_PROTOS; i < MAX_LOG_PROTOS; i++) {
-    g_oai_log.log_level[i] = default_log_levelP;
+    g_oai_log_level[i] = default_log_levelP;
   }
   // did not check return value of snprintf...
   for (i=MIN_LOG_LEVEL; i < MAX_LOG_LEVEL; i++) {
@@ -444,56 +447,67 @@ void log_itti_connect(void)
 }
 
 //------------------------------------------------------------------------------
+// Called once by each thread (ITTI tasks do it in itti_mark_task_ready()), lazily by the others
 void log_start_use (void)
 {
-  pthread_t      p       = pthread_self();
-  hashtable_rc_t hash_rc = hashtable_ts_is_key_exists (g_oai_log.thread_context_htbl, (hash_key_t) p);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    log_thread_ctxt_t *thread_ctxt = calloc(1, sizeof(log_thread_ctxt_t));
-    if (thread_ctxt) {
-      thread_ctxt->tid = p;
-      hash_rc = hashtable_ts_insert(g_oai_log.thread_context_htbl, (hash_key_t) p, thread_ctxt);
-      if (HASH_TABLE_OK != hash_rc) {
-        OAI_FPRINTF_ERR("Error Could not register log thread context\n");
-        free_wrapper((void**)&thread_ctxt);
-      }
-    } else {
-      OAI_FPRINTF_ERR("Error Could not create log thread context\n");
-    }
+  if (!g_log_thread_ctxt.tid) {
+    g_log_thread_ctxt.indent = 0;
+    g_log_thread_ctxt.tid    = pthread_self();
   }
 }
 
 //------------------------------------------------------------------------------
-void log_flush_message (struct shared_log_queue_item_s *item_p)
+// Called by the shared logging task with a batch of messages: one writev() for the batch
+void log_write_messages (struct shared_log_queue_item_s ** items, const int nb_items, const uint64_t nb_dropped)
 {
+  struct iovec                            iov[SHARED_LOG_BATCH_MAX_ITEMS + 1];
+  int                                     iovcnt = 0;
+  bstring                                 bdropped = NULL;
   int                                     rv = 0;
-  int                                     rv_put = 0;
-
-  if (blength(item_p->bstr) > 0) {
-    if (g_oai_log.is_output_is_fd) {
-      if (g_oai_log.log_fd) {
-        rv_put = fputs ((const char *)item_p->bstr->data, g_oai_log.log_fd);
-
-        if (rv_put < 0) {
-          // error occured
-          OAI_FPRINTF_ERR("Error while writing log %d\n", rv_put);
-          rv = fclose (g_oai_log.log_fd);
-          if (rv != 0) {
-            OAI_FPRINTF_ERR("Error while closing Log file stream: %s\n", strerror (errno));
-          }
-          // do not exit
-          if (LOG_TCP_STATE_DISABLED != g_oai_log.tcp_state) {
-            // Let ITTI LOG Timer do the reconnection
-            g_oai_log.tcp_state = LOG_TCP_STATE_NOT_CONNECTED;
-            return;
-          }
+
+  if (nb_dropped) {
+    bdropped = bformat ("------ %" PRIu64 " messages dropped (log queue full)\n", nb_dropped);
+  }
+  if (g_oai_log.is_output_is_fd) {
+    if (g_oai_log.log_fd) {
+      if (bdropped) {
+        iov[iovcnt].iov_base = bdropped->data;
+        iov[iovcnt++].iov_len = blength(bdropped);
+      }
+      for (int i = 0; i < nb_items; i++) {
+        if (blength(items[i]->bstr) > 0) {
+          iov[iovcnt].iov_base = items[i]->bstr->data;
+          iov[iovcnt++].iov_len = blength(items[i]->bstr);
         }
-        fflush (g_oai_log.log_fd);
       }
-    } else {
-      syslog (item_p->u_app_log.log.log_level ,"%s", bdata(item_p->bstr));
+      // the stream may hold data written by the non buffered path
+      fflush (g_oai_log.log_fd);
+      if (shared_log_writev (fileno (g_oai_log.log_fd), iov, iovcnt)) {
+        // error occured
+        OAI_FPRINTF_ERR("Error while writing log: %s\n", strerror (errno));
+        rv = fclose (g_oai_log.log_fd);
+        if (rv != 0) {
+          OAI_FPRINTF_ERR("Error while closing Log file stream: %s\n", strerror (errno));
+        }
+        g_oai_log.log_fd = NULL;
+        // do not exit
+        if (LOG_TCP_STATE_DISABLED != g_oai_log.tcp_state) {
+          // Let ITTI LOG Timer do the reconnection
+          g_oai_log.tcp_state = LOG_TCP_STATE_NOT_CONNECTED;
+        }
+      }
+    }
+  } else {
+    if (bdropped) {
+      syslog (LOG_WARNING, "%s", bdata(bdropped));
+    }
+    for (int i = 0; i < nb_items; i++) {
+      if (blength(items[i]->bstr) > 0) {
+        syslog (items[i]->u_app_log.log.log_level ,"%s", bdata(items[i]->bstr));
+      }
     }
   }
+  bdestroy_wrapper (&bdropped);
 }
 
 //------------------------------------------------------------------------------
@@ -518,7 +532,10 @@ void log_exit (void)
   if (!g_oai_log.is_output_is_fd) {
     closelog();
   }
-  hashtable_ts_destroy (g_oai_log.thread_context_htbl);
+  if (g_oai_log.is_binary_output) {
+    g_oai_log.is_binary_output = false;
+    log_binary_exit ();
+  }
   bdestroy_wrapper(&g_oai_log.bserver_address);
   bdestroy_wrapper(&g_oai_log.bserver_port);
   OAI_FPRINTF_INFO("[TRACE] Leaving %s\n", __FUNCTION__);
@@ -537,17 +554,8 @@ void log_stream_hex(
   struct shared_log_queue_item_s  * message = NULL;
   size_t                            octet_index = 0;
   int                               rv = 0;
-  log_thread_ctxt_t                *thread_ctxt = NULL;
-  hashtable_rc_t                    hash_rc = HASH_TABLE_OK;
+  log_thread_ctxt_t                *thread_ctxt = log_get_thread_ctxt ();
 
-  pthread_t             p           = pthread_self();
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
   if (messageP) {
     log_message_start(thread_ctxt, log_levelP, protoP, &message, source_fileP, line_numP, "hex stream ");
     if (!message) return;
@@ -583,17 +591,8 @@ void log_stream_hex_array(
   struct shared_log_queue_item_s *  message = NULL;
   unsigned long                     octet_index = 0;
   unsigned long                     index = 0;
-  log_thread_ctxt_t                *thread_ctxt = NULL;
-  hashtable_rc_t                    hash_rc = HASH_TABLE_OK;
+  log_thread_ctxt_t                *thread_ctxt = log_get_thread_ctxt ();
 
-  pthread_t             p           = pthread_self();
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
 
   if (messageP) {
     log_message(thread_ctxt, log_levelP, protoP, source_fileP, line_numP, "%s\n", messageP);
@@ -688,7 +687,6 @@ void log_message_start (
   int                                     rv              = 0;
   int                                     filename_length = 0;
   log_thread_ctxt_t                      *thread_ctxt     = thread_ctxtP;
-  hashtable_rc_t                          hash_rc         = HASH_TABLE_OK;
 
   if ((MIN_LOG_PROTOS > protoP) || (MAX_LOG_PROTOS <= protoP)) {
     return;
@@ -696,19 +694,12 @@ void log_message_start (
   if ((MIN_LOG_LEVEL > log_levelP) || (MAX_LOG_LEVEL <= log_levelP)) {
     return;
   }
-  if (log_levelP > g_oai_log.log_level[protoP]) {
+  if (log_levelP > g_oai_log_level[protoP]) {
     return;
   }
 
   if (NULL == thread_ctxt){
-    pthread_t             p           = pthread_self();
-    hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-    if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-      // make the thread safe LFDS collections usable by this thread
-      log_start_use();
-      hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-      AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
-    }
+    thread_ctxt = log_get_thread_ctxt ();
   }
 
   if (! *messageP) {
@@ -774,17 +765,8 @@ void log_func (
   const unsigned int line_numP,
   const char *const functionP)
 {
-  log_thread_ctxt_t        *thread_ctxt = NULL;
-  hashtable_rc_t            hash_rc     = HASH_TABLE_OK;
-  pthread_t                 p           = pthread_self();
+  log_thread_ctxt_t        *thread_ctxt = log_get_thread_ctxt ();
 
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
   if (is_enteringP) {
     log_message(thread_ctxt, OAILOG_LEVEL_TRACE, protoP, source_fileP, line_numP, "Entering %s()\n", functionP);
     thread_ctxt->indent += LOG_FUNC_INDENT_SPACES;
@@ -803,17 +785,8 @@ void log_func_return (
   const char *const functionP,
   const long return_codeP)
 {
-  log_thread_ctxt_t        *thread_ctxt = NULL;
-  hashtable_rc_t            hash_rc     = HASH_TABLE_OK;
-  pthread_t                 p           = pthread_self();
+  log_thread_ctxt_t        *thread_ctxt = log_get_thread_ctxt ();
 
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
   thread_ctxt->indent -= LOG_FUNC_INDENT_SPACES;
   if (thread_ctxt->indent < 0) thread_ctxt->indent = 0;
   log_message(thread_ctxt, OAILOG_LEVEL_TRACE, protoP, source_fileP, line_numP, "Leaving %s() (rc=%ld)\n", functionP, return_codeP);
@@ -834,7 +807,6 @@ log_message (
   int                                     filename_length = 0;
   struct shared_log_queue_item_s         *new_item_p      = NULL;
   log_thread_ctxt_t                      *thread_ctxt     = thread_ctxtP;
-  hashtable_rc_t                          hash_rc         = HASH_TABLE_OK;
 
   if ((MIN_LOG_PROTOS > protoP) || (MAX_LOG_PROTOS <= protoP)) {
     return;
@@ -842,18 +814,26 @@ log_message (
   if ((MIN_LOG_LEVEL > log_levelP) || (MAX_LOG_LEVEL <= log_levelP)) {
     return;
   }
-  if (log_levelP > g_oai_log.log_level[protoP]) {
+  if (log_levelP > g_oai_log_level[protoP]) {
     return;
   }
   if (NULL == thread_ctxt){
-    pthread_t             p           = pthread_self();
-    hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-    if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-      // make the thread safe LFDS collections usable by this thread
-      log_start_use();
-      hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-      AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
+    thread_ctxt = log_get_thread_ctxt ();
+  }
+
+  if (g_oai_log.is_binary_output) {
+    if (!thread_ctxt->binary_ring) {
+      thread_ctxt->binary_ring = log_binary_ring_create ();
+    }
+    if (thread_ctxt->binary_ring) {
+      va_start (args, format);
+      bool is_logged = log_binary_vmessage (thread_ctxt->binary_ring, (uint64_t)thread_ctxt->tid, thread_ctxt->indent,
+          log_levelP, &g_oai_log.log_level2str[log_levelP][0], protoP, &g_oai_log.log_proto2str[protoP][0],
+          source_fileP, line_numP, format, args);
+      va_end (args);
+      if (is_logged) return;
     }
+    // format not supported by the binary backend, or too many threads
   }
 
   new_item_p = get_new_log_queue_item(SH_TS_LOG_TXT);
@@ -82,6 +82,7 @@ extern int fd_g_debug_lvl;
 #define ANSI_COLOR_CONCEALED_ON "\x1b[8m"
 
 #define LOG_CONFIG_STRING_ASYNC_SYSTEM_LOG_LEVEL         "ASYNC_SYSTEM"
+#define LOG_CONFIG_STRING_BINARY_OUTPUT                  "BINARY_OUTPUT"
 #define LOG_CONFIG_STRING_COLOR                          "COLOR"
 #define LOG_CONFIG_STRING_OUTPUT_CONSOLE                 "CONSOLE"
 #define LOG_CONFIG_STRING_GTPV1U_LOG_LEVEL               "GTPV1U_LOG_LEVEL"
@@ -161,6 +162,7 @@ typedef enum {
 typedef struct log_thread_ctxt_s {
   int indent;
   pthread_t tid;
+  struct spsc_ring_s *binary_ring; /*!< \brief Ring of the thread for the binary backend, created on first use */
 } log_thread_ctxt_t;
 
 /*! \struct  log_private_t
@@ -180,6 +182,7 @@ typedef struct log_private_s {
 typedef struct log_config_s {
   bstring       output;             /*!< \brief Where logs go, choice in { "CONSOLE", "`path to file`", "`IPv4@`:`TCP port num`"} . */
   bool          is_output_thread_safe; /*!< \brief Is final string goes in a thread safe buffer of is flushed without care . */
+  bstring       binary_output;      /*!< \brief If set, path of the file where messages are written unformatted (see log_binary.h), decoded offline by oai_log_decode. */
   log_level_t   udp_log_level;      /*!< \brief UDP ITTI task log level starting from OAILOG_LEVEL_EMERGENCY up to MAX_LOG_LEVEL (no log) */
   log_level_t   gtpv1u_log_level;   /*!< \brief GTPv1-U ITTI task log level starting from OAILOG_LEVEL_EMERGENCY up to MAX_LOG_LEVEL (no log) */
   log_level_t   gtpv2c_log_level;   /*!< \brief GTPv2-C ITTI task log level starting from OAILOG_LEVEL_EMERGENCY up to MAX_LOG_LEVEL (no log) */
@@ -219,7 +222,7 @@ void log_start_use(void);
 
 struct shared_log_queue_item_s;
 
-void log_flush_message (struct shared_log_queue_item_s *item_p) __attribute__ ((hot));
+void log_write_messages (struct shared_log_queue_item_s ** items, const int nb_items, const uint64_t nb_dropped) __attribute__ ((hot));
 void log_exit(void);
 
 void log_stream_hex(
@@ -284,37 +287,43 @@ void log_message (
 
 int log_get_start_time_sec (void);
 
+extern log_level_t g_oai_log_level[MAX_LOG_PROTOS];
+
+/* Filtering done by the caller, arguments are not evaluated if the message is not logged */
+#    define OAILOG_IS_ON(lOgLeVeL, pRoTo)                               ((lOgLeVeL) <= g_oai_log_level[pRoTo])
+
 #    define OAILOG_SET_CONFIG                                           log_set_config
 #    define OAILOG_LEVEL_STR2INT                                        log_level_str2int
 #    define OAILOG_LEVEL_INT2STR                                        log_level_int2str
 #    define OAILOG_INIT                                                 log_init
 #    define OAILOG_ITTI_CONNECT                                         log_itti_connect
+#    define OAILOG_START_USE()                                          log_start_use()
 #    define OAILOG_EXIT()                                               log_exit()
-#    define OAILOG_SPEC(pRoTo, ...)                                     do { log_message(NULL, OAILOG_LEVEL_NOTICE,   pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief 3GPP trace on specifications */
-#    define OAILOG_EMERGENCY(pRoTo, ...)                                do { log_message(NULL, OAILOG_LEVEL_EMERGENCY,pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief system is unusable */
-#    define OAILOG_ALERT(pRoTo, ...)                                    do { log_message(NULL, OAILOG_LEVEL_ALERT,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief action must be taken immediately */
-#    define OAILOG_CRITICAL(pRoTo, ...)                                 do { log_message(NULL, OAILOG_LEVEL_CRITICAL, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief critical conditions */
-#    define OAILOG_ERROR(pRoTo, ...)                                    do { log_message(NULL, OAILOG_LEVEL_ERROR,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief error conditions */
-#    define OAILOG_WARNING(pRoTo, ...)                                  do { log_message(NULL, OAILOG_LEVEL_WARNING,  pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief warning conditions */
-#    define OAILOG_NOTICE(pRoTo, ...)                                   do { log_message(NULL, OAILOG_LEVEL_NOTICE,   pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief normal but significant condition */
-#    define OAILOG_INFO(pRoTo, ...)                                     do { log_message(NULL, OAILOG_LEVEL_INFO,     pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief informational */
-#    define OAILOG_MESSAGE_START(lOgLeVeL, pRoTo, cOnTeXt, ...)         do { log_message_start(NULL, lOgLeVeL, pRoTo, cOnTeXt, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief when need to log only 1 message with many char messages, ex formating a dumped struct */
+#    define OAILOG_SPEC(pRoTo, ...)                                     do { if (OAILOG_IS_ON(OAILOG_LEVEL_NOTICE, pRoTo)) log_message(NULL, OAILOG_LEVEL_NOTICE, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief 3GPP trace on specifications */
+#    define OAILOG_EMERGENCY(pRoTo, ...)                                do { if (OAILOG_IS_ON(OAILOG_LEVEL_EMERGENCY, pRoTo)) log_message(NULL, OAILOG_LEVEL_EMERGENCY, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief system is unusable */
+#    define OAILOG_ALERT(pRoTo, ...)                                    do { if (OAILOG_IS_ON(OAILOG_LEVEL_ALERT, pRoTo)) log_message(NULL, OAILOG_LEVEL_ALERT, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief action must be taken immediately */
+#    define OAILOG_CRITICAL(pRoTo, ...)                                 do { if (OAILOG_IS_ON(OAILOG_LEVEL_CRITICAL, pRoTo)) log_message(NULL, OAILOG_LEVEL_CRITICAL, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief critical conditions */
+#    define OAILOG_ERROR(pRoTo, ...)                                    do { if (OAILOG_IS_ON(OAILOG_LEVEL_ERROR, pRoTo)) log_message(NULL, OAILOG_LEVEL_ERROR, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief error conditions */
+#    define OAILOG_WARNING(pRoTo, ...)                                  do { if (OAILOG_IS_ON(OAILOG_LEVEL_WARNING, pRoTo)) log_message(NULL, OAILOG_LEVEL_WARNING, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief warning conditions */
+#    define OAILOG_NOTICE(pRoTo, ...)                                   do { if (OAILOG_IS_ON(OAILOG_LEVEL_NOTICE, pRoTo)) log_message(NULL, OAILOG_LEVEL_NOTICE, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief normal but significant condition */
+#    define OAILOG_INFO(pRoTo, ...)                                     do { if (OAILOG_IS_ON(OAILOG_LEVEL_INFO, pRoTo)) log_message(NULL, OAILOG_LEVEL_INFO, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief informational */
+#    define OAILOG_MESSAGE_START(lOgLeVeL, pRoTo, cOnTeXt, ...)         do { if (OAILOG_IS_ON(lOgLeVeL, pRoTo)) log_message_start(NULL, lOgLeVeL, pRoTo, cOnTeXt, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief when need to log only 1 message with many char messages, ex formating a dumped struct */
 #    define OAILOG_MESSAGE_ADD(cOnTeXt, ...)                            do { log_message_add(cOnTeXt, ##__VA_ARGS__); } while(0) /*!< \brief can be called as many times as needed after OAILOG_MESSAGE_START() */
 #    define OAILOG_MESSAGE_FINISH(cOnTeXt)                              do { log_message_finish(cOnTeXt); } while(0) /*!< \brief Send the message built by OAILOG_MESSAGE_START() n*LOG_MESSAGE_ADD() (n=0..N) */
 #    define OAILOG_STREAM_HEX(lOgLeVeL, pRoTo, mEsSaGe, sTrEaM, sIzE)   do { \
                                                                    OAI_GCC_DIAG_OFF(pointer-sign); \
-                                                                   log_stream_hex(lOgLeVeL, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE);\
+                                                                   if (OAILOG_IS_ON(lOgLeVeL, pRoTo)) log_stream_hex(lOgLeVeL, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE);\
                                                                    OAI_GCC_DIAG_ON(pointer-sign); \
                                                                  } while(0); /*!< \brief trace buffer content */
 #    if DEBUG_IS_ON
-#      define OAILOG_DEBUG(pRoTo, ...)                                  do { log_message(NULL, OAILOG_LEVEL_DEBUG,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief debug informations */
+#      define OAILOG_DEBUG(pRoTo, ...)                                  do { if (OAILOG_IS_ON(OAILOG_LEVEL_DEBUG, pRoTo)) log_message(NULL, OAILOG_LEVEL_DEBUG, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief debug informations */
 #      if TRACE_IS_ON
-#        define OAILOG_EXTERNAL(lOgLeVeL, pRoTo, ...)                   do { log_message(NULL, lOgLeVeL       ,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)
-#        define OAILOG_TRACE(pRoTo, ...)                                do { log_message(NULL, OAILOG_LEVEL_TRACE,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief most detailled informations, struct dumps */
-#        define OAILOG_FUNC_IN(pRoTo)                                   do { log_func(true, pRoTo, __FILE__, __LINE__, __FUNCTION__); } while(0) /*!< \brief informational */
-#        define OAILOG_FUNC_OUT(pRoTo)                                  do { log_func(false, pRoTo, __FILE__, __LINE__, __FUNCTION__); return;} while(0) /*!< \brief informational */
-#        define OAILOG_FUNC_RETURN(pRoTo, rEtUrNcOdE)                   do { log_func_return(pRoTo, __FILE__, __LINE__, __FUNCTION__, (long)rEtUrNcOdE); return rEtUrNcOdE;} while(0) /*!< \brief informational */
-#        define OAILOG_STREAM_HEX_ARRAY(pRoTo, mEsSaGe, sTrEaM, sIzE)       do { log_stream_hex_array(OAILOG_LEVEL_TRACE, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE); } while(0) /*!< \brief trace buffer content with indexes */
+#        define OAILOG_EXTERNAL(lOgLeVeL, pRoTo, ...)                   do { if (OAILOG_IS_ON(lOgLeVeL, pRoTo)) log_message(NULL, lOgLeVeL, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)
+#        define OAILOG_TRACE(pRoTo, ...)                                do { if (OAILOG_IS_ON(OAILOG_LEVEL_TRACE, pRoTo)) log_message(NULL, OAILOG_LEVEL_TRACE, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief most detailled informations, struct dumps */
+#        define OAILOG_FUNC_IN(pRoTo)                                   do { if (OAILOG_IS_ON(OAILOG_LEVEL_TRACE, pRoTo)) log_func(true, pRoTo, __FILE__, __LINE__, __FUNCTION__); } while(0) /*!< \brief informational */
+#        define OAILOG_FUNC_OUT(pRoTo)                                  do { if (OAILOG_IS_ON(OAILOG_LEVEL_TRACE, pRoTo)) log_func(false, pRoTo, __FILE__, __LINE__, __FUNCTION__); return;} while(0) /*!< \brief informational */
+#        define OAILOG_FUNC_RETURN(pRoTo, rEtUrNcOdE)                   do { if (OAILOG_IS_ON(OAILOG_LEVEL_TRACE, pRoTo)) log_func_return(pRoTo, __FILE__, __LINE__, __FUNCTION__, (long)rEtUrNcOdE); return rEtUrNcOdE;} while(0) /*!< \brief informational */
+#        define OAILOG_STREAM_HEX_ARRAY(pRoTo, mEsSaGe, sTrEaM, sIzE)       do { if (OAILOG_IS_ON(OAILOG_LEVEL_TRACE, pRoTo)) log_stream_hex_array(OAILOG_LEVEL_TRACE, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE); } while(0) /*!< \brief trace buffer content with indexes */
 #      endif
 #    endif
 #    include "shared_ts_log.h"
@@ -325,6 +334,7 @@ int log_get_start_time_sec (void);
 #    define OAILOG_LEVEL_INT2STR(a)                                     "EMERGENCY"
 #    define OAILOG_INIT(a,b,c)                                          0
 #    define OAILOG_ITTI_CONNECT()
+#    define OAILOG_START_USE()
 #    define OAILOG_EXIT()
 #    define OAILOG_EMERGENCY(...)
 #    define OAILOG_ALERT(...)
@@ -0,0 +1,601 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file log_binary.c
+   \brief Deferred binary logging backend.
+   The logging threads do not format anything: a call site (format, source file, line) is
+   registered once and gets an id, then each message is a fixed header followed by the raw
+   arguments, copied in a single producer/single consumer ring owned by the thread.
+   A writer thread drains the rings in a file, oai_log_decode renders the text.
+   This file has no dependency on ITTI or on the rest of the logging facility, it is also
+   linked in oai_log_decode.
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "spsc_ring.h"
+#include "log_binary.h"
+
+#define LOG_BINARY_SITE_SLOTS            (2*LOG_BINARY_SITES_MAX)  /*!< \brief power of 2 */
+#define LOG_BINARY_ALIGN(lEn)            (((lEn) + 7) & ~((size_t)7))
+#define LOG_BINARY_FILE_BUFFER_SIZE      (1024*1024)
+
+/*! \struct  log_binary_site_t
+* \brief A log call site, its arguments are encoded following its signature.
+*/
+typedef struct log_binary_site_s {
+  const char                             *format;
+  const char                             *source_file;
+  unsigned int                            line_num;
+  int                                     level;
+  int                                     proto;
+  const char                             *level_name;
+  const char                             *proto_name;
+  bool                                    is_text_only;             /*!< \brief format not supported, logged as text */
+  int                                     nb_args;
+  char                                    signature[LOG_BINARY_ARGS_MAX];
+} log_binary_site_t;
+
+/*! \struct  log_binary_site_slot_t
+* \brief Open addressing hash table entry (format, source file, line) -> site id, read without lock.
+*/
+typedef struct log_binary_site_slot_s {
+  const char                             *format;
+  const char                             *source_file;
+  unsigned int                            line_num;
+  uint32_t                                site_id;                  /*!< \brief 0 while free, written last */
+} log_binary_site_slot_t;
+
+typedef struct log_binary_s {
+  FILE                                   *fp;
+  char                                   *file_buffer;
+  pthread_t                               writer;
+  volatile bool                           running;
+  pthread_mutex_t                         mutex;                    /*!< \brief site registration, ring creation */
+  uint32_t                                nb_sites;                 /*!< \brief last registered site id */
+  uint32_t                                nb_sites_written;         /*!< \brief last site id written in the file */
+  log_binary_site_t                      *sites;                    /*!< \brief indexed by site id, 0 unused */
+  log_binary_site_slot_t                 *slots;
+  uint32_t                                nb_rings;
+  spsc_ring_t                            *rings[LOG_BINARY_RINGS_MAX];   /*!< \brief producer: a logging thread, consumer: the writer thread */
+} log_binary_t;
+
+static log_binary_t g_log_binary = {.fp = NULL, .mutex = PTHREAD_MUTEX_INITIALIZER};
+
+//------------------------------------------------------------------------------
+const char * log_binary_parse_conversion (const char * p, log_binary_conversion_t * const conversion)
+{
+  int                                     spec_length = 0;
+  bool                                    is_64bits = false;
+  bool                                    is_long_double = false;
+  int                                     nb_h = 0;
+
+  conversion->nb_stars = 0;
+  conversion->spec[spec_length++] = '%';
+  if ('%' == *p) {
+    conversion->kind = '%';
+    conversion->spec[spec_length] = '\0';
+    return p + 1;
+  }
+  // flags, width, precision
+  while ((*p) && (strchr ("-+ #0'123456789.*", *p))) {
+    if ('*' == *p) conversion->nb_stars++;
+    if (spec_length >= (int)sizeof (conversion->spec) - 4) return NULL;
+    conversion->spec[spec_length++] = *p++;
+  }
+  // length modifiers
+  while ((*p) && (strchr ("hlLqjzt", *p))) {
+    if (strchr ("lqjzt", *p)) is_64bits = true;
+    if ('L' == *p) is_long_double = true;
+    if ('h' == *p) nb_h++;
+    p++;
+  }
+  switch (*p) {
+  case 'c':
+    if (is_64bits) return NULL;   // wide char
+    conversion->kind = 'i';
+    break;
+  case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+    conversion->kind = (is_64bits) ? 'l' : 'i';
+    if ('l' == conversion->kind) {
+      conversion->spec[spec_length++] = 'l';
+      conversion->spec[spec_length++] = 'l';
+    } else if (nb_h) {
+      // the int is printed as the short or char it was converted from
+      conversion->spec[spec_length++] = 'h';
+      if (nb_h > 1) conversion->spec[spec_length++] = 'h';
+    }
+    break;
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+    if (is_long_double) return NULL;
+    conversion->kind = 'd';
+    break;
+  case 's':
+    if (is_64bits) return NULL;   // wide string
+    conversion->kind = 's';
+    break;
+  case 'p':
+    conversion->kind = 'p';
+    break;
+  default:
+    // %n, positional arguments...
+    return NULL;
+  }
+  conversion->spec[spec_length++] = *p++;
+  conversion->spec[spec_length] = '\0';
+  return p;
+}
+
+//------------------------------------------------------------------------------
+bool log_binary_format_signature (const char * format, char * const signature, int * const nb_args)
+{
+  log_binary_conversion_t                 conversion = {0};
+  const char                             *p = format;
+
+  *nb_args = 0;
+  while ((p = strchr (p, '%'))) {
+    p = log_binary_parse_conversion (p + 1, &conversion);
+    if (!p) return false;
+    if ('%' == conversion.kind) continue;
+    if (*nb_args + conversion.nb_stars + 1 > LOG_BINARY_ARGS_MAX) return false;
+    for (int i = 0; i < conversion.nb_stars; i++) {
+      signature[(*nb_args)++] = 'i';
+    }
+    signature[(*nb_args)++] = conversion.kind;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+size_t log_binary_encode_args (
+  uint8_t * const     buffer,
+  size_t              offset,
+  const size_t        size,
+  const char * const  signature,
+  const int           nb_args,
+  va_list             args)
+{
+  for (int i = 0; i < nb_args; i++) {
+    switch (signature[i]) {
+    case 'i': {
+        const int64_t v = va_arg (args, int);
+        memcpy (&buffer[offset], &v, sizeof (v));
+        offset += sizeof (v);
+      }
+      break;
+    case 'l': {
+        const int64_t v = va_arg (args, long long);
+        memcpy (&buffer[offset], &v, sizeof (v));
+        offset += sizeof (v);
+      }
+      break;
+    case 'd': {
+        const double v = va_arg (args, double);
+        memcpy (&buffer[offset], &v, sizeof (v));
+        offset += sizeof (v);
+      }
+      break;
+    case 'p': {
+        const uint64_t v = (uintptr_t)va_arg (args, void *);
+        memcpy (&buffer[offset], &v, sizeof (v));
+        offset += sizeof (v);
+      }
+      break;
+    case 's': {
+        const char * const s = va_arg (args, const char *);
+        // keep 8 bytes for each remaining argument
+        const size_t       room = size - offset - sizeof (uint64_t) * (nb_args - i + 1);
+        uint32_t           length = UINT32_MAX;
+
+        if (s) {
+          length = strnlen (s, (room < LOG_BINARY_STRING_MAX) ? room : LOG_BINARY_STRING_MAX);
+        }
+        memcpy (&buffer[offset], &length, sizeof (length));
+        if (s) {
+          memcpy (&buffer[offset + sizeof (length)], s, length);
+          offset = LOG_BINARY_ALIGN (offset + sizeof (length) + length);
+        } else {
+          offset += sizeof (uint64_t);
+        }
+      }
+      break;
+    default:;
+    }
+  }
+  return offset;
+}
+
+//------------------------------------------------------------------------------
+static bool log_binary_get_scalar (const uint8_t * args, const size_t args_length, size_t * const offset, void * const value)
+{
+  if (*offset + sizeof (uint64_t) > args_length) return false;
+  memcpy (value, &args[*offset], sizeof (uint64_t));
+  *offset += sizeof (uint64_t);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Same rendering as printf would have done with the original arguments
+bool log_binary_render (FILE * const out, const char * const format, const uint8_t * const args, const size_t args_length)
+{
+  const char                             *p = format;
+  size_t                                  offset = 0;
+  log_binary_conversion_t                 conversion = {0};
+
+  while (*p) {
+    const char *percent = strchr (p, '%');
+    if (!percent) {
+      fputs (p, out);
+      break;
+    }
+    fwrite (p, percent - p, 1, out);
+    p = log_binary_parse_conversion (percent + 1, &conversion);
+    if (!p) {
+      fputs (percent, out);
+      break;
+    }
+    int      stars[2] = {0, 0};
+    int64_t  star = 0;
+    for (int i = 0; i < conversion.nb_stars; i++) {
+      if (!log_binary_get_scalar (args, args_length, &offset, &star)) return false;
+      if (i < 2) stars[i] = (int)star;
+    }
+#define LOG_BINARY_PRINT(vAlUe) do { \
+      if (0 == conversion.nb_stars)      fprintf (out, conversion.spec, vAlUe); \
+      else if (1 == conversion.nb_stars) fprintf (out, conversion.spec, stars[0], vAlUe); \
+      else                               fprintf (out, conversion.spec, stars[0], stars[1], vAlUe); \
+    } while (0)
+
+    switch (conversion.kind) {
+    case '%':
+      fputc ('%', out);
+      break;
+    case 'i': {
+        int64_t v = 0;
+        if (!log_binary_get_scalar (args, args_length, &offset, &v)) return false;
+        LOG_BINARY_PRINT ((int)v);
+      }
+      break;
+    case 'l': {
+        int64_t v = 0;
+        if (!log_binary_get_scalar (args, args_length, &offset, &v)) return false;
+        LOG_BINARY_PRINT ((long long)v);
+      }
+      break;
+    case 'd': {
+        double v = 0;
+        if (!log_binary_get_scalar (args, args_length, &offset, &v)) return false;
+        LOG_BINARY_PRINT (v);
+      }
+      break;
+    case 'p': {
+        uint64_t v = 0;
+        if (!log_binary_get_scalar (args, args_length, &offset, &v)) return false;
+        LOG_BINARY_PRINT ((void *)(uintptr_t)v);
+      }
+      break;
+    case 's': {
+        uint32_t length = 0;
+        if (offset + sizeof (length) > args_length) return false;
+        memcpy (&length, &args[offset], sizeof (length));
+        if (UINT32_MAX == length) {
+          LOG_BINARY_PRINT ("(null)");
+          offset += sizeof (uint64_t);
+        } else {
+          if (offset + sizeof (length) + length > args_length) return false;
+          char *s = strndup ((const char *)&args[offset + sizeof (length)], length);
+          LOG_BINARY_PRINT (s);
+          free (s);
+          offset = LOG_BINARY_ALIGN (offset + sizeof (length) + length);
+        }
+      }
+      break;
+    default:;
+    }
+#undef LOG_BINARY_PRINT
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t log_binary_site_hash (const char * const format, const char * const source_file, const unsigned int line_num)
+{
+  const uint64_t h = log_binary_pointer_hash (format) ^ (log_binary_pointer_hash (source_file) * 0xC2B2AE3D27D4EB4FULL) ^ line_num;
+  return (uint32_t)h & (LOG_BINARY_SITE_SLOTS - 1);
+}
+
+//------------------------------------------------------------------------------
+static uint32_t log_binary_site_lookup (const char * const format, const char * const source_file, const unsigned int line_num)
+{
+  uint32_t                                index = log_binary_site_hash (format, source_file, line_num);
+
+  for (int i = 0; i < LOG_BINARY_SITE_SLOTS; i++) {
+    log_binary_site_slot_t * const slot = &g_log_binary.slots[(index + i) & (LOG_BINARY_SITE_SLOTS - 1)];
+    const uint32_t                 site_id = __atomic_load_n (&slot->site_id, __ATOMIC_ACQUIRE);
+
+    if (!site_id) return 0;
+    if ((slot->format == format) && (slot->line_num == line_num) && (slot->source_file == source_file)) {
+      return site_id;
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t log_binary_site_register (
+  const int           level,
+  const char * const  level_name,
+  const int           proto,
+  const char * const  proto_name,
+  const char * const  source_file,
+  const unsigned int  line_num,
+  const char * const  format)
+{
+  uint32_t                                site_id = 0;
+
+  pthread_mutex_lock (&g_log_binary.mutex);
+  // may have been registered by another thread
+  site_id = log_binary_site_lookup (format, source_file, line_num);
+  if ((!site_id) && (g_log_binary.nb_sites < LOG_BINARY_SITES_MAX)) {
+    site_id = g_log_binary.nb_sites + 1;
+    log_binary_site_t * const site = &g_log_binary.sites[site_id];
+    site->format       = format;
+    site->source_file  = source_file;
+    site->line_num     = line_num;
+    site->level        = level;
+    site->level_name   = level_name;
+    site->proto        = proto;
+    site->proto_name   = proto_name;
+    site->is_text_only = !log_binary_format_signature (format, site->signature, &site->nb_args);
+
+    uint32_t index = log_binary_site_hash (format, source_file, line_num);
+    while (g_log_binary.slots[index].site_id) {
+      index = (index + 1) & (LOG_BINARY_SITE_SLOTS - 1);
+    }
+    g_log_binary.slots[index].format      = format;
+    g_log_binary.slots[index].source_file = source_file;
+    g_log_binary.slots[index].line_num    = line_num;
+    __atomic_store_n (&g_log_binary.slots[index].site_id, site_id, __ATOMIC_RELEASE);
+    __atomic_store_n (&g_log_binary.nb_sites, site_id, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock (&g_log_binary.mutex);
+  return site_id;
+}
+
+//------------------------------------------------------------------------------
+spsc_ring_t * log_binary_ring_create (void)
+{
+  spsc_ring_t                            *ring = spsc_ring_create (LOG_BINARY_RING_SIZE);
+
+  if (!ring) {
+    return NULL;
+  }
+  pthread_mutex_lock (&g_log_binary.mutex);
+  if (g_log_binary.nb_rings < LOG_BINARY_RINGS_MAX) {
+    g_log_binary.rings[g_log_binary.nb_rings] = ring;
+    __atomic_store_n (&g_log_binary.nb_rings, g_log_binary.nb_rings + 1, __ATOMIC_RELEASE);
+  } else {
+    spsc_ring_free (&ring);
+  }
+  pthread_mutex_unlock (&g_log_binary.mutex);
+  return ring;
+}
+
+//------------------------------------------------------------------------------
+bool log_binary_vmessage (
+  spsc_ring_t * const ring,
+  const uint64_t      tid,
+  const int           indent,
+  const int           level,
+  const char * const  level_name,
+  const int           proto,
+  const char * const  proto_name,
+  const char * const  source_file,
+  const unsigned int  line_num,
+  const char * const  format,
+  va_list             args)
+{
+  uint64_t                                record[LOG_BINARY_RECORD_MAX / sizeof (uint64_t)];
+  log_binary_record_header_t * const      header = (log_binary_record_header_t *)record;
+  uint8_t * const                         p = (uint8_t *)record;
+  size_t                                  offset = sizeof (log_binary_record_header_t);
+  struct timespec                         ts;
+  uint32_t                                site_id = log_binary_site_lookup (format, source_file, line_num);
+
+  if (!site_id) {
+    site_id = log_binary_site_register (level, level_name, proto, proto_name, source_file, line_num, format);
+    if (!site_id) return false;
+  }
+  const log_binary_site_t * const site = &g_log_binary.sites[site_id];
+  if (site->is_text_only) return false;
+
+  clock_gettime (CLOCK_REALTIME, &ts);
+  header->type         = LOG_BINARY_RECORD_MESSAGE;
+  header->indent       = (indent > 0) ? indent : 0;
+  header->site_id      = site_id;
+  header->reserved     = 0;
+  header->tid          = tid;
+  header->timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+  offset = log_binary_encode_args (p, offset, LOG_BINARY_RECORD_MAX, site->signature, site->nb_args, args);
+  header->length = offset;
+  spsc_ring_push (ring, record, offset);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static void log_binary_write_sites (void)
+{
+  const uint32_t                          nb_sites = __atomic_load_n (&g_log_binary.nb_sites, __ATOMIC_ACQUIRE);
+
+  for (uint32_t site_id = g_log_binary.nb_sites_written + 1; site_id <= nb_sites; site_id++) {
+    const log_binary_site_t * const site = &g_log_binary.sites[site_id];
+    const char                     *strings[4] = {site->level_name, site->proto_name, site->source_file, site->format};
+    size_t                          length = sizeof (log_binary_record_header_t) + 2 * sizeof (uint16_t) + sizeof (uint32_t);
+    size_t                          offset = length;
+    uint8_t                        *record = NULL;
+
+    for (int i = 0; i < 4; i++) {
+      length += strlen (strings[i]) + 1;
+    }
+    length = LOG_BINARY_ALIGN (length);
+    record = calloc (1, length);
+    if (!record) return;
+
+    log_binary_record_header_t * const header = (log_binary_record_header_t *)record;
+    const uint16_t                     level = site->level;
+    const uint16_t                     proto = site->proto;
+    const uint32_t                     line_num = site->line_num;
+
+    header->length  = length;
+    header->type    = LOG_BINARY_RECORD_SITE;
+    header->site_id = site_id;
+    memcpy (&record[sizeof (*header)], &level, sizeof (level));
+    memcpy (&record[sizeof (*header) + sizeof (level)], &proto, sizeof (proto));
+    memcpy (&record[sizeof (*header) + sizeof (level) + sizeof (proto)], &line_num, sizeof (line_num));
+    for (int i = 0; i < 4; i++) {
+      const size_t string_length = strlen (strings[i]) + 1;
+      memcpy (&record[offset], strings[i], string_length);
+      offset += string_length;
+    }
+    fwrite (record, length, 1, g_log_binary.fp);
+    free (record);
+    g_log_binary.nb_sites_written = site_id;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void log_binary_write_record (const void * const record, const uint32_t length, void * const arg)
+{
+  const log_binary_record_header_t * const header = (const log_binary_record_header_t *)record;
+
+  // the site of the message was registered before the message was pushed
+  if (header->site_id > g_log_binary.nb_sites_written) {
+    log_binary_write_sites ();
+  }
+  fwrite (record, length, 1, g_log_binary.fp);
+  *(bool *)arg = true;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if something was written
+static bool log_binary_drain (void)
+{
+  const uint32_t                          nb_rings = __atomic_load_n (&g_log_binary.nb_rings, __ATOMIC_ACQUIRE);
+  bool                                    is_written = false;
+
+  for (uint32_t r = 0; r < nb_rings; r++) {
+    const uint64_t                        dropped = spsc_ring_drain (g_log_binary.rings[r], log_binary_write_record, &is_written);
+
+    if (dropped) {
+      uint64_t                   record[sizeof (log_binary_record_header_t) / sizeof (uint64_t) + 1] = {0};
+      log_binary_record_header_t *header = (log_binary_record_header_t *)record;
+
+      header->length = sizeof (record);
+      header->type   = LOG_BINARY_RECORD_DROPPED;
+      memcpy (&record[sizeof (log_binary_record_header_t) / sizeof (uint64_t)], &dropped, sizeof (dropped));
+      fwrite (record, sizeof (record), 1, g_log_binary.fp);
+      is_written = true;
+    }
+  }
+  if (is_written) {
+    fflush (g_log_binary.fp);
+  }
+  return is_written;
+}
+
+//------------------------------------------------------------------------------
+static void * log_binary_writer (__attribute__ ((unused)) void *args_p)
+{
+  while (g_log_binary.running) {
+    if (!log_binary_drain ()) {
+      usleep (LOG_BINARY_FLUSH_PERIOD_MICRO_SEC);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int log_binary_init (const char * const path, const int64_t start_time_sec)
+{
+  log_binary_file_header_t                file_header = {.version = LOG_BINARY_VERSION, .reserved = 0, .start_time_sec = start_time_sec};
+
+  if (g_log_binary.fp) {
+    return 0;
+  }
+  g_log_binary.sites = calloc (LOG_BINARY_SITES_MAX + 1, sizeof (log_binary_site_t));
+  g_log_binary.slots = calloc (LOG_BINARY_SITE_SLOTS, sizeof (log_binary_site_slot_t));
+  g_log_binary.file_buffer = malloc (LOG_BINARY_FILE_BUFFER_SIZE);
+  g_log_binary.fp = fopen (path, "w");
+  if ((!g_log_binary.sites) || (!g_log_binary.slots) || (!g_log_binary.file_buffer) || (!g_log_binary.fp)) {
+    fprintf (stderr, "Could not open binary log file %s: %s\n", path, strerror (errno));
+    if (g_log_binary.fp) fclose (g_log_binary.fp);
+    g_log_binary.fp = NULL;
+    free (g_log_binary.sites);
+    free (g_log_binary.slots);
+    free (g_log_binary.file_buffer);
+    return -1;
+  }
+  setvbuf (g_log_binary.fp, g_log_binary.file_buffer, _IOFBF, LOG_BINARY_FILE_BUFFER_SIZE);
+  memcpy (file_header.magic, LOG_BINARY_MAGIC, sizeof (file_header.magic));
+  fwrite (&file_header, sizeof (file_header), 1, g_log_binary.fp);
+
+  g_log_binary.running = true;
+  if (pthread_create (&g_log_binary.writer, NULL, log_binary_writer, NULL)) {
+    fprintf (stderr, "Could not create binary log writer thread\n");
+    g_log_binary.running = false;
+    fclose (g_log_binary.fp);
+    g_log_binary.fp = NULL;
+    return -1;
+  }
+  pthread_setname_np (g_log_binary.writer, "LOG BIN");
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+bool log_binary_is_enabled (void)
+{
+  return g_log_binary.running;
+}
+
+//------------------------------------------------------------------------------
+void log_binary_exit (void)
+{
+  if (g_log_binary.running) {
+    g_log_binary.running = false;
+    pthread_join (g_log_binary.writer, NULL);
+    log_binary_drain ();
+    fclose (g_log_binary.fp);
+    g_log_binary.fp = NULL;
+    free (g_log_binary.file_buffer);
+    g_log_binary.file_buffer = NULL;
+    // sites and rings are left allocated, late loggers may still reference them
+  }
+}
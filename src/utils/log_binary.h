@@ -0,0 +1,155 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file log_binary.h
+  \brief Deferred binary logging backend: the logging thread only copies a call site id,
+  a timestamp and the raw arguments in a per-thread lock-free ring, a writer thread dumps
+  the rings in a file, oai_log_decode renders the text offline.
+*/
+
+#ifndef FILE_LOG_BINARY_SEEN
+#define FILE_LOG_BINARY_SEEN
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+#define LOG_BINARY_MAGIC                 "OAIBLOG1"
+#define LOG_BINARY_VERSION               1
+
+#define LOG_BINARY_RING_SIZE             (256*1024) /*!< \brief per thread, power of 2 */
+#define LOG_BINARY_RINGS_MAX             256        /*!< \brief max number of logging threads */
+#define LOG_BINARY_SITES_MAX             16384      /*!< \brief max number of distinct log call sites */
+#define LOG_BINARY_ARGS_MAX              32
+#define LOG_BINARY_STRING_MAX            512        /*!< \brief %s arguments are truncated to this length */
+#define LOG_BINARY_RECORD_MAX            4096
+#define LOG_BINARY_FLUSH_PERIOD_MICRO_SEC 10000
+
+typedef enum {
+  LOG_BINARY_RECORD_NONE = 0,     /*!< \brief reserved, see spsc_ring.h */
+  LOG_BINARY_RECORD_SITE,         /*!< \brief definition of a call site, precedes its first message */
+  LOG_BINARY_RECORD_MESSAGE,      /*!< \brief a log message, arguments encoded with the signature of the site */
+  LOG_BINARY_RECORD_DROPPED,      /*!< \brief number of messages dropped because a ring was full */
+} log_binary_record_type_t;
+
+/*! \struct  log_binary_file_header_t
+* \brief Header of a binary log file.
+*/
+typedef struct log_binary_file_header_s {
+  char         magic[8];
+  uint32_t     version;
+  uint32_t     reserved;
+  int64_t      start_time_sec;   /*!< \brief Reference time of the elapsed time displayed in logs */
+} log_binary_file_header_t;
+
+/*! \struct  log_binary_record_header_t
+* \brief Header of every record, in the rings and in the file. Records are 8 bytes aligned.
+* A message record is followed by its arguments: 8 bytes for a scalar, a 4 bytes length
+* followed by the characters (padded) for a string.
+* A site record is followed by level(u16), proto(u16), line(u32), then 4 NUL terminated
+* strings: level name, protocol name, source file, format.
+*/
+typedef struct log_binary_record_header_s {
+  uint32_t     length;           /*!< \brief Length of the record, header included */
+  uint16_t     type;             /*!< \brief log_binary_record_type_t */
+  uint16_t     indent;           /*!< \brief Indentation of the thread (OAILOG_FUNC_IN/OUT) */
+  uint32_t     site_id;          /*!< \brief Call site of the message */
+  uint32_t     reserved;
+  uint64_t     tid;              /*!< \brief Thread that logged the message */
+  uint64_t     timestamp_ns;     /*!< \brief CLOCK_REALTIME */
+} log_binary_record_header_t;
+
+/*! \struct  log_binary_conversion_t
+* \brief One conversion specification of a printf format.
+*/
+typedef struct log_binary_conversion_s {
+  char         kind;             /*!< \brief 'i' int, 'l' 64 bits integer, 'd' double, 's' string, 'p' pointer, '%' literal */
+  int          nb_stars;         /*!< \brief Number of '*' width/precision int arguments preceding the value */
+  char         spec[32];         /*!< \brief Normalized specification ('ll' length for 'l', 'h'/'hh' kept for 'i', no length for the others) */
+} log_binary_conversion_t;
+
+struct spsc_ring_s;
+
+/*
+ * Hash of the address of a format or of a source file name, these are string literals.
+ */
+static inline uint64_t log_binary_pointer_hash (const void * const pointer)
+{
+  uint64_t h = (uintptr_t)pointer * 0x9E3779B97F4A7C15ULL;
+  return h ^ (h >> 29);
+}
+
+int  log_binary_init (const char * const path, const int64_t start_time_sec);
+void log_binary_exit (void);
+bool log_binary_is_enabled (void);
+
+struct spsc_ring_s * log_binary_ring_create (void);
+
+/*
+ * Copy a message in the ring of the calling thread. Returns false if the message could not
+ * be encoded (unsupported format), the caller should then log it as text.
+ */
+bool log_binary_vmessage (
+  struct spsc_ring_s * const ring,
+  const uint64_t      tid,
+  const int           indent,
+  const int           level,
+  const char * const  level_name,
+  const int           proto,
+  const char * const  proto_name,
+  const char * const  source_file,
+  const unsigned int  line_num,
+  const char * const  format,
+  va_list             args);
+
+/*
+ * Parse the conversion specification starting after a '%' in a format string,
+ * returns the position following it or NULL if it is not supported.
+ */
+const char * log_binary_parse_conversion (const char * p, log_binary_conversion_t * const conversion);
+
+/*
+ * Argument types of a format, one char per argument ('i', 'l', 'd', 's', 'p', see
+ * log_binary_conversion_t), at most LOG_BINARY_ARGS_MAX. Returns false if not supported.
+ */
+bool log_binary_format_signature (const char * format, char * const signature, int * const nb_args);
+
+/*
+ * Encode the arguments following their signature in buffer at offset, returns the new offset.
+ * The buffer (size bytes) must have room for 8 bytes per argument plus the strings, strings are
+ * truncated to fit.
+ */
+size_t log_binary_encode_args (
+  uint8_t * const     buffer,
+  size_t              offset,
+  const size_t        size,
+  const char * const  signature,
+  const int           nb_args,
+  va_list             args);
+
+/*
+ * Print format with the arguments encoded by log_binary_encode_args(), returns false if
+ * the encoded arguments are truncated.
+ */
+bool log_binary_render (FILE * const out, const char * const format, const uint8_t * const args, const size_t args_length);
+
+#endif /* FILE_LOG_BINARY_SEEN */
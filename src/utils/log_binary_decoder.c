@@ -0,0 +1,181 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file log_binary_decoder.c
+   \brief oai_log_decode: render a binary log file (BINARY_OUTPUT of the LOGGING section)
+   in the text layout of the OAI logging facility.
+   Usage: oai_log_decode binary_log_file [text_output_file]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "log_binary.h"
+
+#define LOG_DISPLAYED_FILENAME_MAX_LENGTH       32
+#define LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH  5
+#define LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH      6
+
+typedef struct decoder_site_s {
+  unsigned int                            line_num;
+  char                                   *level_name;
+  char                                   *proto_name;
+  char                                   *source_file;
+  char                                   *format;
+} decoder_site_t;
+
+static decoder_site_t                    *sites = NULL;
+static uint32_t                           nb_sites_max = 0;
+
+//------------------------------------------------------------------------------
+static int decoder_add_site (const uint32_t site_id, const uint8_t * payload, const size_t payload_length)
+{
+  const char                             *strings[4] = {NULL};
+  size_t                                  offset = 2 * sizeof (uint16_t) + sizeof (uint32_t);
+  uint32_t                                line_num = 0;
+
+  if (payload_length < offset) return -1;
+  memcpy (&line_num, &payload[2 * sizeof (uint16_t)], sizeof (line_num));
+  for (int i = 0; i < 4; i++) {
+    const char *end = memchr (&payload[offset], '\0', payload_length - offset);
+    if (!end) return -1;
+    strings[i] = (const char *)&payload[offset];
+    offset = (const uint8_t *)end - payload + 1;
+  }
+  if (site_id >= nb_sites_max) {
+    const uint32_t new_max = site_id + 1024;
+    decoder_site_t *new_sites = realloc (sites, new_max * sizeof (decoder_site_t));
+    if (!new_sites) return -1;
+    memset (&new_sites[nb_sites_max], 0, (new_max - nb_sites_max) * sizeof (decoder_site_t));
+    sites = new_sites;
+    nb_sites_max = new_max;
+  }
+  sites[site_id].line_num    = line_num;
+  sites[site_id].level_name  = strdup (strings[0]);
+  sites[site_id].proto_name  = strdup (strings[1]);
+  sites[site_id].source_file = strdup (strings[2]);
+  sites[site_id].format      = strdup (strings[3]);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  FILE                                   *in = NULL;
+  FILE                                   *out = stdout;
+  log_binary_file_header_t                file_header = {{0}};
+  log_binary_record_header_t              header = {0};
+  uint8_t                                *payload = NULL;
+  size_t                                  payload_max = 0;
+  uint64_t                                message_number = 0;
+
+  if ((argc < 2) || (argc > 3)) {
+    fprintf (stderr, "Usage: %s binary_log_file [text_output_file]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  in = fopen (argv[1], "r");
+  if (!in) {
+    fprintf (stderr, "Could not open %s: %s\n", argv[1], strerror (errno));
+    return EXIT_FAILURE;
+  }
+  if (3 == argc) {
+    out = fopen (argv[2], "w");
+    if (!out) {
+      fprintf (stderr, "Could not open %s: %s\n", argv[2], strerror (errno));
+      return EXIT_FAILURE;
+    }
+  }
+  if ((1 != fread (&file_header, sizeof (file_header), 1, in)) || (memcmp (file_header.magic, LOG_BINARY_MAGIC, sizeof (file_header.magic)))) {
+    fprintf (stderr, "%s is not a binary log file\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  if (LOG_BINARY_VERSION != file_header.version) {
+    fprintf (stderr, "%s: unsupported version %u\n", argv[1], file_header.version);
+    return EXIT_FAILURE;
+  }
+
+  while (1 == fread (&header, sizeof (header), 1, in)) {
+    const size_t payload_length = header.length - sizeof (header);
+
+    if (header.length < sizeof (header)) {
+      fprintf (stderr, "Corrupted record at offset %ld\n", ftell (in));
+      break;
+    }
+    if (payload_length > payload_max) {
+      payload_max = payload_length;
+      payload = realloc (payload, payload_max);
+    }
+    if ((payload_length) && (1 != fread (payload, payload_length, 1, in))) {
+      break;
+    }
+
+    switch (header.type) {
+    case LOG_BINARY_RECORD_SITE:
+      if (decoder_add_site (header.site_id, payload, payload_length)) {
+        fprintf (stderr, "Corrupted site record %u\n", header.site_id);
+      }
+      break;
+
+    case LOG_BINARY_RECORD_MESSAGE: {
+        if ((header.site_id >= nb_sites_max) || (!sites[header.site_id].format)) {
+          fprintf (stderr, "Message of unknown site %u\n", header.site_id);
+          break;
+        }
+        const decoder_site_t * const site = &sites[header.site_id];
+        const int                    filename_length = strlen (site->source_file);
+        const char                  *filename = site->source_file;
+        if (filename_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
+          filename = &site->source_file[filename_length - LOG_DISPLAYED_FILENAME_MAX_LENGTH];
+        }
+        fprintf (out, "%06" PRIu64 " %05ld:%06ld %08" PRIX64 " %-*.*s %-*.*s %-*.*s:%04u   %*s",
+            message_number++,
+            (long)(header.timestamp_ns / 1000000000ULL - file_header.start_time_sec), (long)((header.timestamp_ns % 1000000000ULL) / 1000),
+            header.tid,
+            LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, site->level_name,
+            LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, site->proto_name,
+            LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, filename, site->line_num,
+            header.indent, " ");
+        if (!log_binary_render (out, site->format, payload, payload_length)) {
+          fputs ("<truncated record>\n", out);
+        }
+      }
+      break;
+
+    case LOG_BINARY_RECORD_DROPPED: {
+        uint64_t dropped = 0;
+        if (payload_length >= sizeof (dropped)) memcpy (&dropped, payload, sizeof (dropped));
+        fprintf (out, "------ %" PRIu64 " messages dropped (log ring full)\n", dropped);
+      }
+      break;
+
+    default:
+      fprintf (stderr, "Unknown record type %u\n", header.type);
+    }
+  }
+  free (payload);
+  fclose (in);
+  if (stdout != out) fclose (out);
+  return EXIT_SUCCESS;
+}
@@ -64,6 +64,13 @@
 #define SCTP_IN_STREAMS       (32)
 #define SCTP_MAX_ATTEMPTS     (5)
 
+/*******************************************************************************
+ * UDP Constants
+ ******************************************************************************/
+
+#define UDP_BATCH_SIZE_DEFAULT (32) ///< Datagrams received (recvmmsg) or sent (sendmmsg) per system call
+#define UDP_BATCH_SIZE_MAX     (64)
+
 /*******************************************************************************
  * MME global definitions
  ******************************************************************************/
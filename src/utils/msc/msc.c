@@ -36,12 +36,14 @@
 #include <limits.h>
 #include <inttypes.h>
 #include <sys/time.h>
+#include <pthread.h>
 
 #include "bstrlib.h"
 
 #include "hashtable.h"
 #include "obj_hashtable.h"
 #include "log.h"
+#include "spsc_ring.h"
 #include "msc.h"
 #include "assertions.h"
 #include "conversions.h"
@@ -62,11 +64,15 @@
 #include "dynamic_memory_check.h"
 #include "shared_ts_log.h"
 #include "log.h"
+#include "log_binary.h"
+#include "msc_binary.h"
 
 //-------------------------------
-#define MSC_MAX_QUEUE_ELEMENTS    1024
 #define MSC_MAX_PROTO_NAME_LENGTH 16
 #define MSC_MAX_MESSAGE_LENGTH    512
+#define MSC_FORMAT_SLOTS          (2*MSC_BINARY_FORMATS_MAX)  /*!< \brief power of 2 */
+#define MSC_ALIGN(lEn)            (((lEn) + 7) & ~((size_t)7))
+#define MSC_FILE_BUFFER_SIZE      (256*1024)
 
 //-------------------------------
 
@@ -81,6 +87,41 @@ typedef unsigned long                   msc_message_number_t;
 
 msc_message_number_t                    g_message_number = 0;
 
+/*! \struct  msc_format_t
+* \brief Label format of MSC call sites, its arguments are encoded following its signature.
+*/
+typedef struct msc_format_s {
+  const char                             *format;
+  bool                                    is_text_only;             /*!< \brief format not supported by the encoder, label formatted */
+  int                                     nb_args;
+  char                                    signature[LOG_BINARY_ARGS_MAX];
+} msc_format_t;
+
+/*! \struct  msc_format_slot_t
+* \brief Open addressing hash table entry format -> format id, read without lock.
+*/
+typedef struct msc_format_slot_s {
+  const char                             *format;
+  uint32_t                                format_id;                /*!< \brief 0 while free, written last */
+} msc_format_slot_t;
+
+typedef struct msc_binary_s {
+  char                                   *file_buffer;
+  pthread_mutex_t                         mutex;                    /*!< \brief format registration, ring creation */
+  uint32_t                                nb_formats;               /*!< \brief last registered format id */
+  uint32_t                                nb_formats_written;       /*!< \brief last format id written in the file */
+  msc_format_t                            formats[MSC_BINARY_FORMATS_MAX + 1];   /*!< \brief indexed by format id, 0 unused */
+  msc_format_slot_t                       slots[MSC_FORMAT_SLOTS];
+  uint32_t                                nb_rings;
+  spsc_ring_t                            *rings[MSC_BINARY_RINGS_MAX];   /*!< \brief producer: a tracing thread, consumer: the shared log task */
+} msc_binary_t;
+
+static msc_binary_t                       g_msc_binary = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static __thread spsc_ring_t              *g_msc_ring = NULL;        /*!< \brief ring of the calling thread */
+
+static const char * const                 g_msc_operations[MSC_BINARY_OPERATION_MAX] = MSC_BINARY_OPERATION_STRINGS;
+
 
 //------------------------------------------------------------------------------
 int
@@ -91,11 +132,12 @@ msc_init (
   int                                     i = 0;
   int                                     rv = 0;
   char                                    msc_filename[NAME_MAX+1];
+  msc_binary_file_header_t                file_header = {.version = MSC_BINARY_VERSION, .reserved = 0};
 
 
   OAI_FPRINTF_INFO ("Initializing MSC logs\n");
   g_msc_start_time_second = shared_log_get_start_time_sec();
-  rv = snprintf (msc_filename, NAME_MAX, "/tmp/openair.msc.%u.log", envP);   // TODO NAME
+  rv = snprintf (msc_filename, NAME_MAX, "/tmp/openair.msc.%u.bin", envP);   // TODO NAME, oai_msc_decode renders it in /tmp/openair.msc.%u.log
 
   if ((0 >= rv) || (256 < rv)) {
     OAI_FPRINTF_ERR ("Error in MSC log file name");
@@ -103,6 +145,12 @@ msc_init (
 
   g_msc_fd = fopen (msc_filename, "w");
   AssertFatal (g_msc_fd != NULL, "Could not open MSC log file %s : %s", msc_filename, strerror (errno));
+  g_msc_binary.file_buffer = malloc (MSC_FILE_BUFFER_SIZE);
+  AssertFatal (g_msc_binary.file_buffer != NULL, "Could not allocate MSC log file buffer");
+  setvbuf (g_msc_fd, g_msc_binary.file_buffer, _IOFBF, MSC_FILE_BUFFER_SIZE);
+  memcpy (file_header.magic, MSC_BINARY_MAGIC, sizeof (file_header.magic));
+  file_header.start_time_sec = g_msc_start_time_second;
+  fwrite (&file_header, sizeof (file_header), 1, g_msc_fd);
 
 
   for (i = MIN_MSC_PROTOS; i < MAX_MSC_PROTOS; i++) {
@@ -301,64 +349,244 @@ msc_init (
 //------------------------------------------------------------------------------
 void msc_flush_messages (void)
 {
+  // the shared log task drains the MSC rings with its queue
   shared_log_flush_messages();
+}
+
+//------------------------------------------------------------------------------
+static spsc_ring_t * msc_get_thread_ring (void)
+{
+  spsc_ring_t                            *ring = NULL;
 
-  fflush (g_msc_fd);
+  if (g_msc_ring) {
+    return g_msc_ring;
+  }
+  if (!(ring = spsc_ring_create (MSC_BINARY_RING_SIZE))) {
+    return NULL;
+  }
+  pthread_mutex_lock (&g_msc_binary.mutex);
+  if (g_msc_binary.nb_rings < MSC_BINARY_RINGS_MAX) {
+    g_msc_binary.rings[g_msc_binary.nb_rings] = ring;
+    __atomic_store_n (&g_msc_binary.nb_rings, g_msc_binary.nb_rings + 1, __ATOMIC_RELEASE);
+    g_msc_ring = ring;
+  } else {
+    spsc_ring_free (&ring);
+  }
+  pthread_mutex_unlock (&g_msc_binary.mutex);
+  return g_msc_ring;
 }
 
 //------------------------------------------------------------------------------
+// Preallocate the ring of the calling thread
 void msc_start_use (void)
 {
-  lfds611_queue_use (g_msc_message_queue_p);
-  lfds611_stack_use (g_msc_memory_stack_p);
+  msc_get_thread_ring ();
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t msc_format_hash (const char * const format)
+{
+  return (uint32_t)log_binary_pointer_hash (format) & (MSC_FORMAT_SLOTS - 1);
+}
+
+//------------------------------------------------------------------------------
+static uint32_t msc_format_lookup (const char * const format)
+{
+  uint32_t                                index = msc_format_hash (format);
+
+  for (int i = 0; i < MSC_FORMAT_SLOTS; i++) {
+    msc_format_slot_t * const slot = &g_msc_binary.slots[(index + i) & (MSC_FORMAT_SLOTS - 1)];
+    const uint32_t            format_id = __atomic_load_n (&slot->format_id, __ATOMIC_ACQUIRE);
+
+    if (!format_id) return 0;
+    if (slot->format == format) return format_id;
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t msc_format_register (const char * const format)
+{
+  uint32_t                                format_id = 0;
+
+  pthread_mutex_lock (&g_msc_binary.mutex);
+  // may have been registered by another thread
+  format_id = msc_format_lookup (format);
+  if ((!format_id) && (g_msc_binary.nb_formats < MSC_BINARY_FORMATS_MAX)) {
+    format_id = g_msc_binary.nb_formats + 1;
+    msc_format_t * const msc_format = &g_msc_binary.formats[format_id];
+    msc_format->format       = format;
+    msc_format->is_text_only = !log_binary_format_signature (format, msc_format->signature, &msc_format->nb_args);
+
+    uint32_t index = msc_format_hash (format);
+    while (g_msc_binary.slots[index].format_id) {
+      index = (index + 1) & (MSC_FORMAT_SLOTS - 1);
+    }
+    g_msc_binary.slots[index].format = format;
+    __atomic_store_n (&g_msc_binary.slots[index].format_id, format_id, __ATOMIC_RELEASE);
+    __atomic_store_n (&g_msc_binary.nb_formats, format_id, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock (&g_msc_binary.mutex);
+  return format_id;
+}
+
+//------------------------------------------------------------------------------
+static void msc_vlog (
+  const msc_binary_record_type_t type,
+  const msc_binary_operation_t   operation,
+  const msc_proto_t              proto1P,
+  const msc_proto_t              proto2P,
+  const uint8_t * const          bytesP,
+  const unsigned int             num_bytes,
+  const char * const             format,
+  va_list                        args)
+{
+  uint64_t                                record[MSC_BINARY_RECORD_MAX / sizeof (uint64_t)];
+  msc_binary_record_header_t * const      header = (msc_binary_record_header_t *)record;
+  uint8_t * const                         p = (uint8_t *)record;
+  size_t                                  offset = sizeof (msc_binary_record_header_t);
+  struct timeval                          elapsed_time;
+  spsc_ring_t * const                     ring = msc_get_thread_ring ();
+  uint32_t                                format_id = 0;
+
+  if (!ring) return;
+
+  shared_log_get_elapsed_time_since_start(&elapsed_time);
+  header->type                = type;
+  header->operation           = operation;
+  header->proto1              = proto1P;
+  header->proto2              = proto2P;
+  header->payload_full_length = (bytesP) ? num_bytes : 0;
+  header->payload_length      = (header->payload_full_length < MSC_BINARY_PAYLOAD_MAX) ? header->payload_full_length : MSC_BINARY_PAYLOAD_MAX;
+  header->reserved            = 0;
+  header->number              = __sync_fetch_and_add (&g_message_number, 1);
+  header->elapsed_time_us     = (uint64_t)elapsed_time.tv_sec * 1000000 + elapsed_time.tv_usec;
+  if (header->payload_length) {
+    memcpy (&p[offset], bytesP, header->payload_length);
+    offset = MSC_ALIGN (offset + header->payload_length);
+  }
+
+  format_id = msc_format_lookup (format);
+  if (!format_id) {
+    format_id = msc_format_register (format);
+  }
+  if ((format_id) && (!g_msc_binary.formats[format_id].is_text_only)) {
+    const msc_format_t * const msc_format = &g_msc_binary.formats[format_id];
+    offset = log_binary_encode_args (p, offset, MSC_BINARY_RECORD_MAX, msc_format->signature, msc_format->nb_args, args);
+  } else {
+    const size_t room = (MSC_BINARY_RECORD_MAX - offset < MSC_MAX_MESSAGE_LENGTH) ? MSC_BINARY_RECORD_MAX - offset : MSC_MAX_MESSAGE_LENGTH;
+    int          rv = vsnprintf ((char *)&p[offset], room, format, args);
+
+    format_id = 0;
+    if (0 > rv) rv = 0;
+    if ((size_t)rv >= room) rv = room - 1;
+    offset = MSC_ALIGN (offset + rv + 1);
+  }
+  header->format_id = format_id;
+  header->length    = offset;
+  spsc_ring_push (ring, record, offset);
+}
+
+//------------------------------------------------------------------------------
+static void msc_write_formats (void)
+{
+  const uint32_t                          nb_formats = __atomic_load_n (&g_msc_binary.nb_formats, __ATOMIC_ACQUIRE);
+
+  for (uint32_t format_id = g_msc_binary.nb_formats_written + 1; format_id <= nb_formats; format_id++) {
+    const char * const          format = g_msc_binary.formats[format_id].format;
+    const size_t                format_length = strlen (format) + 1;
+    msc_binary_record_header_t  header = {0};
+    const uint64_t              padding = 0;
+
+    header.length    = MSC_ALIGN (sizeof (header) + format_length);
+    header.type      = MSC_BINARY_RECORD_FORMAT;
+    header.format_id = format_id;
+    fwrite (&header, sizeof (header), 1, g_msc_fd);
+    fwrite (format, format_length, 1, g_msc_fd);
+    fwrite (&padding, header.length - sizeof (header) - format_length, 1, g_msc_fd);
+    g_msc_binary.nb_formats_written = format_id;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void msc_write_record (const void * const record, const uint32_t length, void * const arg)
+{
+  const msc_binary_record_header_t * const header = (const msc_binary_record_header_t *)record;
+
+  // the format of the label was registered before the record was pushed
+  if (header->format_id > g_msc_binary.nb_formats_written) {
+    msc_write_formats ();
+  }
+  fwrite (record, length, 1, g_msc_fd);
+  *(bool *)arg = true;
 }
 
+//------------------------------------------------------------------------------
+// Called by the shared log task when it flushes its queue
+void msc_drain_buffers (void)
+{
+  const uint32_t                          nb_rings = __atomic_load_n (&g_msc_binary.nb_rings, __ATOMIC_ACQUIRE);
+  bool                                    is_written = false;
+
+  if (!g_msc_fd) return;
+
+  for (uint32_t r = 0; r < nb_rings; r++) {
+    const uint64_t                        dropped = spsc_ring_drain (g_msc_binary.rings[r], msc_write_record, &is_written);
+
+    if (dropped) {
+      msc_binary_record_header_t  header = {0};
+
+      header.length = sizeof (header);
+      header.type   = MSC_BINARY_RECORD_DROPPED;
+      header.number = dropped;
+      fwrite (&header, sizeof (header), 1, g_msc_fd);
+      is_written = true;
+    }
+  }
+  if (is_written) {
+    fflush (g_msc_fd);
+  }
+}
 
 //------------------------------------------------------------------------------
 void msc_end (void)
 {
   int                                     rv = 0;
+  FILE                                   *msc_fd = g_msc_fd;
 
-  if (NULL != g_msc_fd) {
+  if (NULL != msc_fd) {
     msc_flush_messages ();
-    rv = fflush (g_msc_fd);
+    g_msc_fd = NULL;
+    rv = fflush (msc_fd);
 
     if (rv != 0) {
       OAI_FPRINTF_ERR ("Error while flushing stream of MSC log file: %s", strerror (errno));
     }
 
-    rv = fclose (g_msc_fd);
+    rv = fclose (msc_fd);
 
     if (rv != 0) {
       OAI_FPRINTF_ERR ("Error while closing MSC log file: %s", strerror (errno));
     }
+    free_wrapper ((void**)&g_msc_binary.file_buffer);
   }
 }
 
 //------------------------------------------------------------------------------
 void msc_log_declare_proto (const msc_proto_t protoP)
 {
-  int                                     rv = 0;
-  shared_log_queue_item_t                *new_item_p = NULL;
-
-  if ((MIN_MSC_PROTOS <= protoP) && (MAX_MSC_PROTOS > protoP)) {
-    // may be build a memory pool for that also ?
-    new_item_p = get_new_log_queue_item (SH_TS_LOG_MSC);
-
-    if (NULL != new_item_p) {
-      rv = bassignformat (new_item_p->bstr, "%" PRIu64 " [PROTO] %d %s\n",
-          __sync_fetch_and_add (&g_message_number, 1), protoP, &g_msc_proto2str[protoP][0]);
-
-      if (BSTR_ERR ==  rv) {
-        OAI_FPRINTF_ERR ("Error while declaring new protocol in MSC: %d", protoP);
-
-        return;
-      }
-
-      new_item_p->u_app_log.msc.message_bin = NULL;
-      new_item_p->u_app_log.msc.message_bin_size = 0;
-      shared_log_item (new_item_p);
-    }
+  uint64_t                                record[(sizeof (msc_binary_record_header_t) + MSC_MAX_PROTO_NAME_LENGTH) / sizeof (uint64_t)] = {0};
+  msc_binary_record_header_t * const      header = (msc_binary_record_header_t *)record;
+  spsc_ring_t * const                     ring = msc_get_thread_ring ();
+
+  if ((MIN_MSC_PROTOS <= protoP) && (MAX_MSC_PROTOS > protoP) && (ring)) {
+    header->type   = MSC_BINARY_RECORD_PROTO;
+    header->proto1 = protoP;
+    header->number = __sync_fetch_and_add (&g_message_number, 1);
+    // g_msc_proto2str entries are NUL terminated within MSC_MAX_PROTO_NAME_LENGTH
+    memcpy (&record[sizeof (msc_binary_record_header_t) / sizeof (uint64_t)], &g_msc_proto2str[protoP][0], MSC_MAX_PROTO_NAME_LENGTH);
+    header->length = sizeof (record);
+    spsc_ring_push (ring, record, sizeof (record));
   }
 }
 
@@ -366,43 +594,14 @@ void msc_log_declare_proto (const msc_proto_t protoP)
 void msc_log_event (const msc_proto_t protoP, char *format, ...)
 {
   va_list                                 args;
-  int                                     rv = 0;
-  shared_log_queue_item_t                *new_item_p = NULL;
 
   if ((MIN_MSC_PROTOS > protoP) || (MAX_MSC_PROTOS <= protoP)) {
     return;
   }
 
-  new_item_p = get_new_log_queue_item (SH_TS_LOG_MSC);
-
-  if (NULL != new_item_p) {
-    struct timeval elapsed_time;
-    shared_log_get_elapsed_time_since_start(&elapsed_time);
-
-    rv = bassignformat (new_item_p->bstr, "%" PRIu64 " [EVENT] %d %04ld:%06ld",
-          __sync_fetch_and_add (&g_message_number, 1), protoP, elapsed_time.tv_sec, elapsed_time.tv_usec);
-
-    if (BSTR_ERR ==  rv) {
-      OAI_FPRINTF_ERR ("Error while logging MSC event : %s", &g_msc_proto2str[protoP][0]);
-      return;
-      }
-
-      va_start (args, format);
-    rv = bvcformata (new_item_p->bstr, MSC_MAX_MESSAGE_LENGTH - rv, format, args);
-      va_end (args);
-
-    if (BSTR_ERR == rv) {
-      OAI_FPRINTF_ERR("Error while logging MSC event : %s", &g_msc_proto2str[protoP][0]);
-      return;
-      }
-
-    bcatcstr(new_item_p->bstr, "\n");
-
-    new_item_p->u_app_log.msc.message_bin = NULL;
-    new_item_p->u_app_log.msc.message_bin_size = 0;
-
-    shared_log_item(new_item_p);
-      }
+  va_start (args, format);
+  msc_vlog (MSC_BINARY_RECORD_EVENT, MSC_BINARY_OPERATION_TX, protoP, protoP, NULL, 0, format, args);
+  va_end (args);
 }
 
 //------------------------------------------------------------------------------
@@ -417,58 +616,20 @@ msc_log_message (
   ...)
 {
   va_list                                 args;
-  uint64_t                                mac = 0;      // TO DO mac on bytesP param
-  int                                     rv = 0;
-  shared_log_queue_item_t                *new_item_p = NULL;
+  msc_binary_operation_t                  operation = MSC_BINARY_OPERATION_TX;
 
   if ((MIN_MSC_PROTOS > proto1P) || (MAX_MSC_PROTOS <= proto1P) || (MIN_MSC_PROTOS > proto2P) || (MAX_MSC_PROTOS <= proto2P)) {
     return;
   }
 
-  new_item_p = get_new_log_queue_item (SH_TS_LOG_MSC);
-
-  if (NULL != new_item_p) {
-    struct timeval elapsed_time;
-    shared_log_get_elapsed_time_since_start(&elapsed_time);
-    rv = bassignformat (new_item_p->bstr, "%" PRIu64 " [MESSAGE] %d %s %d %" PRIu64 " %04ld:%06ld",
-          __sync_fetch_and_add (&g_message_number, 1), proto1P, message_operationP, proto2P, mac, elapsed_time.tv_sec, elapsed_time.tv_usec);
-
-    if (BSTR_ERR ==  rv) {
-      OAI_FPRINTF_ERR ("Error while logging MSC message : %s/%s", &g_msc_proto2str[proto1P][0], &g_msc_proto2str[proto2P][0]);
-      return;
-    }
-
-    va_start (args, format);
-    rv = bvcformata (new_item_p->bstr, MSC_MAX_MESSAGE_LENGTH - rv, format, args);
-    va_end (args);
-
-    if (BSTR_ERR == rv) {
-      OAI_FPRINTF_ERR("Error while logging MSC message : %s/%s", &g_msc_proto2str[proto1P][0], &g_msc_proto2str[proto2P][0]);
-      return;
+  for (int i = 0; i < MSC_BINARY_OPERATION_MAX; i++) {
+    if ((message_operationP[0] == g_msc_operations[i][0]) && (message_operationP[1] == g_msc_operations[i][1])) {
+      operation = i;
+      break;
     }
-
-    bcatcstr(new_item_p->bstr, "\n");
-
-    new_item_p->u_app_log.msc.message_bin = bytesP;
-    new_item_p->u_app_log.msc.message_bin_size = num_bytes;
-
-    shared_log_item(new_item_p);
   }
-}
-//------------------------------------------------------------------------------
-void msc_flush_message (struct shared_log_queue_item_s *item_p)
-{
-  int                                     rv_put = 0;
-
-  if (blength(item_p->bstr) > 0) {
-    if (g_msc_fd) {
-      rv_put = fputs ((const char *)item_p->bstr->data, g_msc_fd);
 
-      if (rv_put < 0) {
-        // error occured
-        OAI_FPRINTF_ERR("Error while writing msc %d\n", rv_put);
-      }
-      fflush (g_msc_fd);
-    }
-  }
+  va_start (args, format);
+  msc_vlog (MSC_BINARY_RECORD_MESSAGE, operation, proto1P, proto2P, bytesP, num_bytes, format, args);
+  va_end (args);
 }
@@ -81,12 +81,11 @@ void msc_log_message(
     uint8_t* bytesP,
     const unsigned int num_bytes,
     char *format, ...);
-struct shared_log_queue_item_s;
-
-void msc_flush_message (struct shared_log_queue_item_s *item_p);
+void msc_drain_buffers (void);
 
 #define MSC_INIT(arg1,arg2)                                      msc_init(arg1,arg2)
 #define MSC_END                                                  msc_end
+#define MSC_START_USE(mScPaRaMs)                                 msc_start_use()
 #define MSC_LOG_EVENT(mScPaRaMs, fORMAT, aRGS...)                msc_log_event(mScPaRaMs, fORMAT, ##aRGS)
 #define MSC_LOG_RX_MESSAGE(rECEIVER, sENDER, bYTES, nUMbYTES, fORMAT, aRGS...)           msc_log_message("<-",rECEIVER, sENDER, bYTES, nUMbYTES, fORMAT, ##aRGS)
 #define MSC_LOG_RX_DISCARDED_MESSAGE(rECEIVER, sENDER, bYTES, nUMbYTES, fORMAT, aRGS...) msc_log_message("x-",rECEIVER, sENDER, bYTES, nUMbYTES, fORMAT, ##aRGS)
@@ -0,0 +1,93 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file msc_binary.h
+  \brief Binary format of the MSC trace files (/tmp/openair.msc.<env>.bin): the tracing thread
+  copies a fixed header, the raw arguments of the label and the head of the message payload in
+  a per-thread ring, oai_msc_decode renders the mscgen text of msc_gen offline.
+*/
+
+#ifndef FILE_MSC_BINARY_SEEN
+#define FILE_MSC_BINARY_SEEN
+
+#include <stdint.h>
+
+#define MSC_BINARY_MAGIC                 "OAIMSC01"
+#define MSC_BINARY_VERSION               1
+
+#define MSC_BINARY_RING_SIZE             (128*1024) /*!< \brief per thread, power of 2 */
+#define MSC_BINARY_RINGS_MAX             256        /*!< \brief max number of tracing threads */
+#define MSC_BINARY_FORMATS_MAX           4096       /*!< \brief max number of distinct label formats */
+#define MSC_BINARY_RECORD_MAX            2048
+#define MSC_BINARY_PAYLOAD_MAX           64         /*!< \brief bytes of the message payload kept in a record */
+
+typedef enum {
+  MSC_BINARY_RECORD_NONE = 0,     /*!< \brief reserved, see spsc_ring.h */
+  MSC_BINARY_RECORD_PROTO,        /*!< \brief declaration of a protocol entity, followed by its name */
+  MSC_BINARY_RECORD_FORMAT,       /*!< \brief definition of a label format, precedes its first use */
+  MSC_BINARY_RECORD_EVENT,
+  MSC_BINARY_RECORD_MESSAGE,
+  MSC_BINARY_RECORD_DROPPED,      /*!< \brief number of records dropped because a ring was full */
+} msc_binary_record_type_t;
+
+typedef enum {
+  MSC_BINARY_OPERATION_TX = 0,    /*!< \brief "->" */
+  MSC_BINARY_OPERATION_RX,        /*!< \brief "<-" */
+  MSC_BINARY_OPERATION_RX_DISCARDED, /*!< \brief "x-" */
+  MSC_BINARY_OPERATION_TX_FAILED, /*!< \brief "-x" */
+  MSC_BINARY_OPERATION_MAX,
+} msc_binary_operation_t;
+
+#define MSC_BINARY_OPERATION_STRINGS     {"->", "<-", "x-", "-x"}
+
+/*! \struct  msc_binary_file_header_t
+* \brief Header of a binary MSC trace file.
+*/
+typedef struct msc_binary_file_header_s {
+  char         magic[8];
+  uint32_t     version;
+  uint32_t     reserved;
+  int64_t      start_time_sec;
+} msc_binary_file_header_t;
+
+/*! \struct  msc_binary_record_header_t
+* \brief Header of every record, in the rings and in the file. Records are 8 bytes aligned.
+* An event or message record is followed by payload_length bytes of payload (padded), then by
+* the label: arguments encoded by log_binary_encode_args() if format_id is not 0, a NUL
+* terminated text otherwise (format not supported by the encoder).
+* A proto record is followed by the NUL terminated name of proto1, a format record by the
+* NUL terminated format of format_id.
+*/
+typedef struct msc_binary_record_header_s {
+  uint32_t     length;              /*!< \brief Length of the record, header included */
+  uint8_t      type;                /*!< \brief msc_binary_record_type_t */
+  uint8_t      operation;           /*!< \brief msc_binary_operation_t of a message */
+  uint8_t      proto1;              /*!< \brief msc_proto_t, sender or entity of the event */
+  uint8_t      proto2;              /*!< \brief msc_proto_t, receiver */
+  uint32_t     format_id;
+  uint32_t     payload_length;      /*!< \brief Bytes of payload in the record */
+  uint32_t     payload_full_length; /*!< \brief Size of the traced message */
+  uint32_t     reserved;
+  uint64_t     number;              /*!< \brief Sequence number, count of dropped records for a dropped record */
+  uint64_t     elapsed_time_us;     /*!< \brief Since the start of the logging facility */
+} msc_binary_record_header_t;
+
+#endif /* FILE_MSC_BINARY_SEEN */
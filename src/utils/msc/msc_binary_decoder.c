@@ -0,0 +1,191 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file msc_binary_decoder.c
+   \brief oai_msc_decode: render a binary MSC trace file (/tmp/openair.msc.<env>.bin) in the
+   text format read by scripts/msc_gen.
+   Usage: oai_msc_decode [-x] binary_msc_file [text_output_file]
+   -x appends the captured head of the message payloads in hexadecimal (not understood by msc_gen).
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "log_binary.h"
+#include "msc_binary.h"
+
+#define MSC_ALIGN(lEn)            (((lEn) + 7) & ~((size_t)7))
+
+static char                             **formats = NULL;
+static uint32_t                           nb_formats_max = 0;
+
+//------------------------------------------------------------------------------
+static int decoder_add_format (const uint32_t format_id, const uint8_t * payload, const size_t payload_length)
+{
+  if (!memchr (payload, '\0', payload_length)) return -1;
+  if (format_id >= nb_formats_max) {
+    const uint32_t new_max = format_id + 256;
+    char **new_formats = realloc (formats, new_max * sizeof (char *));
+    if (!new_formats) return -1;
+    memset (&new_formats[nb_formats_max], 0, (new_max - nb_formats_max) * sizeof (char *));
+    formats = new_formats;
+    nb_formats_max = new_max;
+  }
+  formats[format_id] = strdup ((const char *)payload);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Same text as the former msc_log_event()/msc_log_message()
+static void decoder_render (FILE * const out, const msc_binary_record_header_t * const header, const uint8_t * payload, const size_t payload_length, const bool with_payload)
+{
+  static const char * const               operations[MSC_BINARY_OPERATION_MAX] = MSC_BINARY_OPERATION_STRINGS;
+  const size_t                            label_offset = MSC_ALIGN (header->payload_length);
+  const long                              sec = header->elapsed_time_us / 1000000;
+  const long                              usec = header->elapsed_time_us % 1000000;
+
+  if (label_offset > payload_length) {
+    fprintf (stderr, "Corrupted record %" PRIu64 "\n", header->number);
+    return;
+  }
+  if (MSC_BINARY_RECORD_EVENT == header->type) {
+    fprintf (out, "%" PRIu64 " [EVENT] %d %04ld:%06ld", header->number, header->proto1, sec, usec);
+  } else {
+    fprintf (out, "%" PRIu64 " [MESSAGE] %d %s %d %" PRIu64 " %04ld:%06ld", header->number, header->proto1,
+        operations[(header->operation < MSC_BINARY_OPERATION_MAX) ? header->operation : MSC_BINARY_OPERATION_TX],
+        header->proto2, (uint64_t)0, sec, usec);
+  }
+  if (header->format_id) {
+    if ((header->format_id >= nb_formats_max) || (!formats[header->format_id])) {
+      fprintf (stderr, "Record %" PRIu64 " of unknown format %u\n", header->number, header->format_id);
+    } else if (!log_binary_render (out, formats[header->format_id], &payload[label_offset], payload_length - label_offset)) {
+      fprintf (stderr, "Truncated record %" PRIu64 "\n", header->number);
+    }
+  } else {
+    fprintf (out, "%.*s", (int)(payload_length - label_offset), (const char *)&payload[label_offset]);
+  }
+  if ((with_payload) && (header->payload_length)) {
+    fprintf (out, " [%u/%u bytes:", header->payload_length, header->payload_full_length);
+    for (uint32_t i = 0; i < header->payload_length; i++) {
+      fprintf (out, " %02x", payload[i]);
+    }
+    fputc (']', out);
+  }
+  fputc ('\n', out);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  FILE                                   *in = NULL;
+  FILE                                   *out = stdout;
+  msc_binary_file_header_t                file_header = {{0}};
+  msc_binary_record_header_t              header = {0};
+  uint8_t                                *payload = NULL;
+  size_t                                  payload_max = 0;
+  uint64_t                                nb_dropped = 0;
+  bool                                    with_payload = false;
+  int                                     arg = 1;
+
+  if ((argc > 1) && (!strcmp (argv[1], "-x"))) {
+    with_payload = true;
+    arg++;
+  }
+  if ((argc - arg < 1) || (argc - arg > 2)) {
+    fprintf (stderr, "Usage: %s [-x] binary_msc_file [text_output_file]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  in = fopen (argv[arg], "r");
+  if (!in) {
+    fprintf (stderr, "Could not open %s: %s\n", argv[arg], strerror (errno));
+    return EXIT_FAILURE;
+  }
+  if (argc - arg == 2) {
+    out = fopen (argv[arg + 1], "w");
+    if (!out) {
+      fprintf (stderr, "Could not open %s: %s\n", argv[arg + 1], strerror (errno));
+      return EXIT_FAILURE;
+    }
+  }
+  if ((1 != fread (&file_header, sizeof (file_header), 1, in)) || (memcmp (file_header.magic, MSC_BINARY_MAGIC, sizeof (file_header.magic)))) {
+    fprintf (stderr, "%s is not a binary MSC file\n", argv[arg]);
+    return EXIT_FAILURE;
+  }
+  if (MSC_BINARY_VERSION != file_header.version) {
+    fprintf (stderr, "%s: unsupported version %u\n", argv[arg], file_header.version);
+    return EXIT_FAILURE;
+  }
+
+  while (1 == fread (&header, sizeof (header), 1, in)) {
+    if (header.length < sizeof (header)) {
+      fprintf (stderr, "Corrupted record at offset %ld\n", ftell (in));
+      break;
+    }
+    const size_t payload_length = header.length - sizeof (header);
+    if (payload_length > payload_max) {
+      payload_max = payload_length;
+      payload = realloc (payload, payload_max);
+    }
+    if ((payload_length) && (1 != fread (payload, payload_length, 1, in))) {
+      break;
+    }
+
+    switch (header.type) {
+    case MSC_BINARY_RECORD_PROTO:
+      if ((!payload_length) || (!memchr (payload, '\0', payload_length))) {
+        fprintf (stderr, "Corrupted proto record %u\n", header.proto1);
+        break;
+      }
+      fprintf (out, "%" PRIu64 " [PROTO] %d %s\n", header.number, header.proto1, (const char *)payload);
+      break;
+
+    case MSC_BINARY_RECORD_FORMAT:
+      if (decoder_add_format (header.format_id, payload, payload_length)) {
+        fprintf (stderr, "Corrupted format record %u\n", header.format_id);
+      }
+      break;
+
+    case MSC_BINARY_RECORD_EVENT:
+    case MSC_BINARY_RECORD_MESSAGE:
+      decoder_render (out, &header, payload, payload_length, with_payload);
+      break;
+
+    case MSC_BINARY_RECORD_DROPPED:
+      // not in the output, msc_gen only knows MSC records
+      nb_dropped += header.number;
+      break;
+
+    default:
+      fprintf (stderr, "Unknown record type %u\n", header.type);
+    }
+  }
+  if (nb_dropped) {
+    fprintf (stderr, "%" PRIu64 " MSC records were dropped (trace buffer full)\n", nb_dropped);
+  }
+  free (payload);
+  fclose (in);
+  if (stdout != out) fclose (out);
+  return EXIT_SUCCESS;
+}
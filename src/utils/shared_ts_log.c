@@ -39,6 +39,9 @@
 #include <ctype.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
 
 #include "bstrlib.h"
 
@@ -66,6 +69,7 @@
 #include "gcc_diag.h"
 //-------------------------------
 #define LOG_MAX_QUEUE_ELEMENTS                2048
+#define LOG_MAX_QUEUE_ITEMS                   (2*LOG_MAX_QUEUE_ELEMENTS) /*!< \brief growth limit of the memory pool */
 #define LOG_MESSAGE_MIN_ALLOC_SIZE             256
 
 #define LOG_FLUSH_PERIOD_SEC                     0
@@ -92,12 +96,21 @@ typedef struct oai_shared_log_s {
 
   hash_table_ts_t                        *thread_context_htbl;                                         /*!< \brief Container for log_thread_ctxt_t */
 
-  void (*logger_callback[MAX_SH_TS_LOG_CLIENT])(shared_log_queue_item_t*);
+  shared_log_batch_callback_t             logger_callback[MAX_SH_TS_LOG_CLIENT];
   bool                                    running;
+
+  int                                     flush_event_fd;                                              /*!< \brief Wakes up the flushing task when SHARED_LOG_FLUSH_THRESHOLD_BYTES are pending */
+  pthread_mutex_t                         flush_mutex;                                                 /*!< \brief Serializes consumers, producers never take it */
+  int64_t                                 nb_pending_bytes;                                            /*!< \brief Bytes enqueued and not yet written */
+  int                                     nb_items;                                                    /*!< \brief Items allocated in the memory pool */
+  uint64_t                                nb_dropped[MAX_SH_TS_LOG_CLIENT];                            /*!< \brief Messages dropped, queue or pool exhausted */
+  uint64_t                                nb_dropped_reported[MAX_SH_TS_LOG_CLIENT];                   /*!< \brief Part of nb_dropped already given to the callback */
 } oai_shared_log_t;
 
 static oai_shared_log_t g_shared_log={0};    /*!< \brief  logging utility internal variables global var definition*/
 
+static __thread bool g_shared_log_thread_started = false;  /*!< \brief shared_log_start_use() already done by the calling thread */
+
 
 //------------------------------------------------------------------------------
 int shared_log_get_start_time_sec (void)
@@ -140,10 +153,18 @@ shared_log_queue_item_t * get_new_log_queue_item(sh_ts_log_app_id_t app_id)
 
   lfds710_stack_pop( &g_shared_log.log_free_message_queue, &se );
   if (!se) {
-    shared_log_flush_messages();
-    lfds710_stack_pop( &g_shared_log.log_free_message_queue, &se );
-  }
-  if (se) {
+    // never flush here, a slow output would stall the producer: grow the pool up to a limit, then drop
+    if (__sync_fetch_and_add (&g_shared_log.nb_items, 1) < LOG_MAX_QUEUE_ITEMS) {
+      item_p = create_new_log_queue_item(app_id);
+#if !defined(SHARED_LOG_PREALLOC_STRING_BUFFERS)
+      item_p->bstr = bfromcstralloc(LOG_MESSAGE_MIN_ALLOC_SIZE, "");
+      AssertFatal((item_p->bstr), "Allocation of buf in log container failed");
+#endif
+    } else {
+      __sync_fetch_and_sub (&g_shared_log.nb_items, 1);
+      __sync_fetch_and_add (&g_shared_log.nb_dropped[app_id], 1);
+    }
+  } else {
     item_p = LFDS710_STACK_GET_VALUE_FROM_ELEMENT( *se );
 
     if (!item_p) {
@@ -159,8 +180,6 @@ shared_log_queue_item_t * get_new_log_queue_item(sh_ts_log_app_id_t app_id)
     item_p->bstr = bfromcstralloc(LOG_MESSAGE_MIN_ALLOC_SIZE, "");
     AssertFatal((item_p->bstr), "Allocation of buf in log container failed");
 #endif
-  } else {
-    OAI_FPRINTF_ERR("Could not get memory for logging\n");
   }
   return item_p;
 }
@@ -174,6 +193,7 @@ void* shared_log_task (__attribute__ ((unused)) void *args_p)
 
   itti_mark_task_ready (TASK_SHARED_TS_LOG);
   shared_log_start_use ();
+  itti_subscribe_event_fd (TASK_SHARED_TS_LOG, g_shared_log.flush_event_fd);
   timer_setup (LOG_FLUSH_PERIOD_SEC,
                LOG_FLUSH_PERIOD_MICRO_SEC,
                TASK_SHARED_TS_LOG, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &timer_id);
@@ -185,7 +205,7 @@ void* shared_log_task (__attribute__ ((unused)) void *args_p)
 
       switch (ITTI_MSG_ID (received_message_p)) {
       case TIMER_HAS_EXPIRED:{
-//    todo:    shared_log_flush_messages ();
+        shared_log_flush_messages ();
         timer_setup (LOG_FLUSH_PERIOD_SEC,
             LOG_FLUSH_PERIOD_MICRO_SEC,
             TASK_SHARED_TS_LOG, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &timer_id);
@@ -214,6 +234,17 @@ void* shared_log_task (__attribute__ ((unused)) void *args_p)
       rc = itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
       AssertFatal (rc == EXIT_SUCCESS, "Failed to free memory (%d)!\n", rc);
       received_message_p = NULL;
+    } else {
+      struct epoll_event                 *events = NULL;
+      int                                 nb_events = itti_get_events (TASK_SHARED_TS_LOG, &events);
+
+      for (int i = 0; i < nb_events; i++) {
+        if ((events[i].events & EPOLLIN) && (events[i].data.fd == g_shared_log.flush_event_fd)) {
+          eventfd_t                       counter = 0;
+          eventfd_read (g_shared_log.flush_event_fd, &counter);
+          shared_log_flush_messages ();
+        }
+      }
     }
   }
 
@@ -240,10 +271,10 @@ int shared_log_init (const int max_threadsP)
   OAI_FPRINTF_INFO("Initializing shared logging\n");
   gettimeofday(&start_time, NULL);
   g_shared_log.log_start_time_second = start_time.tv_sec;
-  g_shared_log.logger_callback[SH_TS_LOG_TXT] = log_flush_message;
-#if MESSAGE_CHART_GENERATOR
-  g_shared_log.logger_callback[SH_TS_LOG_MSC] = msc_flush_message;
-#endif
+  g_shared_log.logger_callback[SH_TS_LOG_TXT] = log_write_messages;
+  g_shared_log.flush_event_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  AssertFatal (0 <= g_shared_log.flush_event_fd, "Could not create eventfd for Log: %s\n", strerror (errno));
+  pthread_mutex_init (&g_shared_log.flush_mutex, NULL);
 
   bstring b = bfromcstr("Logging thread context hashtable");
   g_shared_log.thread_context_htbl = hashtable_ts_create (LOG_MESSAGE_MIN_ALLOC_SIZE, NULL, free_wrapper, b);
@@ -273,7 +304,7 @@ int shared_log_init (const int max_threadsP)
     LFDS710_STACK_SET_VALUE_IN_ELEMENT( item_p->se, item_p );
     lfds710_stack_push( &g_shared_log.log_free_message_queue, &item_p->se );
   }
-
+  g_shared_log.nb_items = max_threadsP * 30;
 
   OAI_FPRINTF_INFO("Initializing shared logging Done\n");
 
@@ -293,6 +324,11 @@ void shared_log_itti_connect(void)
 //------------------------------------------------------------------------------
 void shared_log_start_use (void)
 {
+  if (g_shared_log_thread_started) {
+    return;
+  }
+  g_shared_log_thread_started = true;
+
   pthread_t      p       = pthread_self();
   hashtable_rc_t hash_rc = hashtable_ts_is_key_exists (g_shared_log.thread_context_htbl, (hash_key_t) p);
   if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
@@ -314,19 +350,88 @@ void shared_log_start_use (void)
 }
 
 //------------------------------------------------------------------------------
+uint64_t shared_log_get_dropped (sh_ts_log_app_id_t app_id)
+{
+  return g_shared_log.nb_dropped[app_id];
+}
+
+//------------------------------------------------------------------------------
+// Write all the iovecs, resuming after partial writes
+int shared_log_writev (const int fd, struct iovec * iov, int iovcnt)
+{
+  while (iovcnt > 0) {
+    ssize_t                               written = writev (fd, iov, iovcnt);
+
+    if (0 > written) {
+      if (EINTR == errno) continue;
+      return -1;
+    }
+    while ((iovcnt > 0) && ((size_t)written >= iov->iov_len)) {
+      written -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = (char *)iov->iov_base + written;
+      iov->iov_len -= written;
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void shared_log_flush_batch (sh_ts_log_app_id_t app_id, shared_log_queue_item_t ** items, const int nb_items)
+{
+  const uint64_t                          nb_dropped = g_shared_log.nb_dropped[app_id];
+  const uint64_t                          nb_new_dropped = nb_dropped - g_shared_log.nb_dropped_reported[app_id];
+
+  g_shared_log.nb_dropped_reported[app_id] = nb_dropped;
+  if ((nb_items) || (nb_new_dropped)) {
+    if (g_shared_log.logger_callback[app_id]) {
+      (*g_shared_log.logger_callback[app_id])(items, nb_items, nb_new_dropped);
+    }
+  }
+  for (int i = 0; i < nb_items; i++) {
+    shared_log_reuse_item(items[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drain the queue, one writev per batch of SHARED_LOG_BATCH_MAX_ITEMS items or SHARED_LOG_BATCH_MAX_BYTES bytes per client
 void shared_log_flush_messages (void)
 {
-  int                                     rv = 0;
   shared_log_queue_item_t                *item_p = NULL;
+  shared_log_queue_item_t                *batch[MAX_SH_TS_LOG_CLIENT][SHARED_LOG_BATCH_MAX_ITEMS];
+  int                                     nb_items[MAX_SH_TS_LOG_CLIENT] = {0};
+  int                                     nb_bytes[MAX_SH_TS_LOG_CLIENT] = {0};
 
-  while ((rv = lfds710_queue_bmm_dequeue(&g_shared_log.log_message_queue, NULL, (void **)&item_p)) == 1) {
-    if ((item_p->app_id >= MIN_SH_TS_LOG_CLIENT) && (item_p->app_id < MAX_SH_TS_LOG_CLIENT)) {
-      (*g_shared_log.logger_callback[item_p->app_id])(item_p);
-    } else {
+  pthread_mutex_lock (&g_shared_log.flush_mutex);
+  while (lfds710_queue_bmm_dequeue(&g_shared_log.log_message_queue, NULL, (void **)&item_p) == 1) {
+    const int length = blength(item_p->bstr);
+
+    __sync_fetch_and_sub (&g_shared_log.nb_pending_bytes, length);
+    if ((item_p->app_id < MIN_SH_TS_LOG_CLIENT) || (item_p->app_id >= MAX_SH_TS_LOG_CLIENT)) {
       OAI_FPRINTF_ERR("Error bad logger identifier: %d\n", item_p->app_id);
+      shared_log_reuse_item(item_p);
+      continue;
     }
-    shared_log_reuse_item(item_p);
+    const sh_ts_log_app_id_t app_id = item_p->app_id;
+    batch[app_id][nb_items[app_id]++] = item_p;
+    nb_bytes[app_id] += length;
+    if ((SHARED_LOG_BATCH_MAX_ITEMS == nb_items[app_id]) || (SHARED_LOG_BATCH_MAX_BYTES <= nb_bytes[app_id])) {
+      shared_log_flush_batch (app_id, batch[app_id], nb_items[app_id]);
+      nb_items[app_id] = 0;
+      nb_bytes[app_id] = 0;
+    }
+  }
+  for (sh_ts_log_app_id_t app_id = MIN_SH_TS_LOG_CLIENT; app_id < MAX_SH_TS_LOG_CLIENT; app_id++) {
+    shared_log_flush_batch (app_id, batch[app_id], nb_items[app_id]);
   }
+#if MESSAGE_CHART_GENERATOR
+  // MSC records are not queued, they are in the per-thread buffers of msc.c
+  msc_drain_buffers ();
+#endif
+  pthread_mutex_unlock (&g_shared_log.flush_mutex);
 }
 
 //------------------------------------------------------------------------------
@@ -362,6 +467,8 @@ void shared_log_exit (void)
   lfds710_queue_bmm_cleanup( &g_shared_log.log_message_queue, shared_log_element_dequeue_cleanup_callback);
   lfds710_stack_cleanup( &g_shared_log.log_free_message_queue, shared_log_element_pop_cleanup_callback );
   free_wrapper((void**)&g_shared_log.qbmme);
+  close (g_shared_log.flush_event_fd);
+  g_shared_log.flush_event_fd = -1;
   OAI_FPRINTF_INFO("[TRACE] Leaving %s\n", __FUNCTION__);
 }
 
@@ -370,8 +477,19 @@ void shared_log_item(shared_log_queue_item_t * messageP)
 {
   if (messageP) {
     if (g_shared_log.running) {
+      const int length = blength(messageP->bstr);
+
       shared_log_start_use();
-      lfds710_queue_bmm_enqueue( &g_shared_log.log_message_queue, NULL, messageP );
+      const int64_t nb_pending_bytes = __sync_add_and_fetch (&g_shared_log.nb_pending_bytes, length);
+      if (!lfds710_queue_bmm_enqueue( &g_shared_log.log_message_queue, NULL, messageP )) {
+        // queue full, the output does not keep up: drop rather than stall the producer
+        __sync_fetch_and_sub (&g_shared_log.nb_pending_bytes, length);
+        __sync_fetch_and_add (&g_shared_log.nb_dropped[messageP->app_id], 1);
+        shared_log_reuse_item(messageP);
+      } else if ((nb_pending_bytes >= SHARED_LOG_FLUSH_THRESHOLD_BYTES) && (nb_pending_bytes - length < SHARED_LOG_FLUSH_THRESHOLD_BYTES)) {
+        // size bound crossed, do not wait for the flush timer
+        eventfd_write (g_shared_log.flush_event_fd, 1);
+      }
     } else {
       if (messageP->bstr) {
         bdestroy_wrapper(&messageP->bstr);
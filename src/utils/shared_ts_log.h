@@ -30,10 +30,15 @@
 #define FILE_SHARED_TS_LOG_SEEN
 
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <liblfds710.h>
 #include "msc.h"
 #include "log.h"
 
+#define SHARED_LOG_BATCH_MAX_ITEMS              64    /*!< \brief max number of messages written by one writev() */
+#define SHARED_LOG_BATCH_MAX_BYTES           65536    /*!< \brief a batch is written once it reaches this size */
+#define SHARED_LOG_FLUSH_THRESHOLD_BYTES     32768    /*!< \brief pending bytes that wake up the flushing task before its timer */
+
 typedef enum {
   MIN_SH_TS_LOG_CLIENT = 0,
   SH_TS_LOG_TXT = MIN_SH_TS_LOG_CLIENT,
@@ -57,10 +62,10 @@ typedef struct shared_log_queue_item_s {
   } u_app_log;
 } shared_log_queue_item_t;
 
-/*! \struct  log_config_t
-* \brief Structure containing the dynamically configurable parameters of the Logging facilities.
-* This structure is filled by configuration facilities when parsing a configuration file.
+/*! \brief Writes a batch of messages of a client, nb_dropped is the number of messages of this
+* client dropped since the previous call because the queue or the memory pool was exhausted.
 */
+typedef void (*shared_log_batch_callback_t)(shared_log_queue_item_t ** items, const int nb_items, const uint64_t nb_dropped);
 
 //------------------------------------------------------------------------------
 int shared_log_get_start_time_sec (void);
@@ -73,4 +78,6 @@ void shared_log_start_use (void);
 void shared_log_flush_messages (void);
 void shared_log_exit (void);
 void shared_log_item(shared_log_queue_item_t * messageP);
+uint64_t shared_log_get_dropped (sh_ts_log_app_id_t app_id);
+int shared_log_writev (const int fd, struct iovec * iov, int iovcnt);
 #endif /* FILE_SHARED_TS_LOG_SEEN */
@@ -0,0 +1,106 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file spsc_ring.c
+   \brief Single producer, single consumer ring of variable length records.
+   This file has no dependency on ITTI or on the logging facility, it is also linked in
+   oai_log_decode and oai_msc_decode.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spsc_ring.h"
+
+#define SPSC_RING_PADDING                0   /*!< \brief 4 bytes following the length of the wrap around record */
+
+//------------------------------------------------------------------------------
+spsc_ring_t * spsc_ring_create (const uint32_t size)
+{
+  spsc_ring_t                            *ring = NULL;
+
+  if ((!size) || (size & (size - 1))) {
+    return NULL;
+  }
+  if (posix_memalign ((void **)&ring, 64, sizeof (*ring) + size)) {
+    return NULL;
+  }
+  memset (ring, 0, sizeof (*ring) + size);
+  ring->size = size;
+  return ring;
+}
+
+//------------------------------------------------------------------------------
+void spsc_ring_free (spsc_ring_t ** const ring)
+{
+  free (*ring);
+  *ring = NULL;
+}
+
+//------------------------------------------------------------------------------
+bool spsc_ring_push (spsc_ring_t * const ring, const void * const record, const uint32_t length)
+{
+  const uint64_t                          tail = __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE);
+  uint64_t                                head = ring->head;
+  uint32_t                                pos = head & (ring->size - 1);
+  const uint32_t                          contiguous = ring->size - pos;
+  const uint32_t                          needed = (contiguous < length) ? contiguous + length : length;
+
+  if ((ring->size - (head - tail)) < needed) {
+    // never wait for the consumer
+    __atomic_store_n (&ring->overruns, ring->overruns + 1, __ATOMIC_RELAXED);
+    return false;
+  }
+  if (contiguous < length) {
+    const uint32_t padding[2] = {contiguous, SPSC_RING_PADDING};
+
+    memcpy (&ring->buffer[pos], padding, sizeof (padding));
+    head += contiguous;
+    pos   = 0;
+  }
+  memcpy (&ring->buffer[pos], record, length);
+  __atomic_store_n (&ring->head, head + length, __ATOMIC_RELEASE);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+uint64_t spsc_ring_drain (spsc_ring_t * const ring, spsc_ring_record_cb_t record_cb, void * const arg)
+{
+  const uint64_t                          head = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+  const uint64_t                          overruns = __atomic_load_n (&ring->overruns, __ATOMIC_RELAXED);
+  const uint64_t                          dropped = overruns - ring->overruns_reported;
+  uint64_t                                tail = ring->tail;
+
+  while (tail != head) {
+    const uint8_t * const record = &ring->buffer[tail & (ring->size - 1)];
+    uint32_t              header[2];
+
+    memcpy (header, record, sizeof (header));
+    if (SPSC_RING_PADDING != header[1]) {
+      record_cb (record, header[0], arg);
+    }
+    tail += header[0];
+  }
+  __atomic_store_n (&ring->tail, tail, __ATOMIC_RELEASE);
+  ring->overruns_reported = overruns;
+  return dropped;
+}
@@ -0,0 +1,70 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file spsc_ring.h
+   \brief Preallocated single producer, single consumer ring of variable length records, shared by
+   the binary log backend and the binary MSC trace. The producer never waits: a record that does not
+   fit is dropped and counted, the consumer reports the drops.
+   A record starts with its uint32_t length (8 bytes aligned, at least 8 bytes), the 4 bytes that
+   follow the length must not be all 0: the ring marks the wrap around with such a record.
+*/
+#ifndef FILE_SPSC_RING_SEEN
+#define FILE_SPSC_RING_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*! \struct  spsc_ring_t
+* \brief head is only written by the producer, tail and overruns_reported by the consumer.
+*/
+typedef struct spsc_ring_s {
+  uint64_t                                head __attribute__ ((aligned (64)));  /*!< \brief written by the producer */
+  uint64_t                                overruns;                 /*!< \brief records dropped, ring full */
+  uint64_t                                tail __attribute__ ((aligned (64)));  /*!< \brief written by the consumer */
+  uint64_t                                overruns_reported;
+  uint32_t                                size;                     /*!< \brief power of 2 */
+  uint8_t                                 buffer[] __attribute__ ((aligned (64)));
+} spsc_ring_t;
+
+/*
+ * Called by spsc_ring_drain() for each record, in the order they were pushed.
+ */
+typedef void (*spsc_ring_record_cb_t) (const void * const record, const uint32_t length, void * const arg);
+
+/*
+ * Allocate a ring of size bytes, size must be a power of 2.
+ */
+spsc_ring_t * spsc_ring_create (const uint32_t size);
+
+void spsc_ring_free (spsc_ring_t ** const ring);
+
+/*
+ * Producer side: copy the record in the ring, returns false if it was dropped (ring full).
+ */
+bool spsc_ring_push (spsc_ring_t * const ring, const void * const record, const uint32_t length);
+
+/*
+ * Consumer side: call record_cb for the records pushed so far then release their room.
+ * Returns the number of records dropped since the previous call.
+ */
+uint64_t spsc_ring_drain (spsc_ring_t * const ring, spsc_ring_record_cb_t record_cb, void * const arg);
+
+#endif /* FILE_SPSC_RING_SEEN */